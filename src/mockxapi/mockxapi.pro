@@ -0,0 +1,28 @@
+TEMPLATE = lib
+CONFIG += qt warn_on c++17 staticlib
+QT += core network
+QT -= gui
+TARGET = mockxapi
+
+INCLUDEPATH += ..
+
+# zlib — used for compressed responses, see MockXapiServer::SetCompressionEnabled()
+contains(CONFIG, no_zlib) {
+    DEFINES += XENADMIN_NO_ZLIB
+} else {
+    LIBS += -lz
+}
+
+greaterThan(QT_MAJOR_VERSION, 5) {
+    DEFINES += QT_NO_DEPRECATED_WARNINGS
+}
+
+SOURCES += \
+    mockxapidatabase.cpp \
+    mockxapiinventory.cpp \
+    mockxapiserver.cpp
+
+HEADERS += \
+    mockxapidatabase.h \
+    mockxapiinventory.h \
+    mockxapiserver.h
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mockxapidatabase.h"
+
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QUuid>
+
+namespace
+{
+    // Longest single wait, so cancellation is noticed even without WakeAll()
+    const int WAIT_SLICE_MS = 250;
+}
+
+QVariantMap MockXapiEvent::ToVariant() const
+{
+    QVariantMap event;
+    event.insert("id", this->id);
+    event.insert("timestamp", QDateTime::fromSecsSinceEpoch(this->timestamp, Qt::UTC).toString("yyyyMMddTHH:mm:ssZ"));
+    event.insert("class", this->className);
+    event.insert("operation", this->operation);
+    event.insert("ref", this->ref);
+    if (this->operation != "del")
+        event.insert("snapshot", this->snapshot);
+    return event;
+}
+
+MockXapiDatabase::MockXapiDatabase()
+{
+}
+
+void MockXapiDatabase::Add(const QString& className, const QString& ref, const QVariantMap& record)
+{
+    QMutexLocker locker(&this->m_mutex);
+    const QString cls = className.toLower();
+    this->m_objects[cls].insert(ref, record);
+    this->appendEvent(cls, "add", ref, record);
+}
+
+bool MockXapiDatabase::Modify(const QString& className, const QString& ref, const QVariantMap& fields)
+{
+    return this->Update(className, ref, [&fields](QVariantMap& record) {
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it)
+            record.insert(it.key(), it.value());
+    });
+}
+
+bool MockXapiDatabase::Update(const QString& className, const QString& ref, const std::function<void(QVariantMap&)>& change)
+{
+    QMutexLocker locker(&this->m_mutex);
+    const QString cls = className.toLower();
+    auto classIt = this->m_objects.find(cls);
+    if (classIt == this->m_objects.end())
+        return false;
+
+    auto it = classIt->find(ref);
+    if (it == classIt->end())
+        return false;
+
+    change(it.value());
+    this->appendEvent(cls, "mod", ref, it.value());
+    return true;
+}
+
+bool MockXapiDatabase::Remove(const QString& className, const QString& ref)
+{
+    QMutexLocker locker(&this->m_mutex);
+    const QString cls = className.toLower();
+    auto classIt = this->m_objects.find(cls);
+    if (classIt == this->m_objects.end() || !classIt->remove(ref))
+        return false;
+
+    this->appendEvent(cls, "del", ref, QVariantMap());
+    return true;
+}
+
+void MockXapiDatabase::Clear()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_objects.clear();
+    this->m_events.clear();
+    this->m_droppedUpTo = this->m_nextEventId - 1;
+    this->m_changed.wakeAll();
+}
+
+bool MockXapiDatabase::Contains(const QString& className, const QString& ref) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_objects.value(className.toLower()).contains(ref);
+}
+
+QVariantMap MockXapiDatabase::Get(const QString& className, const QString& ref) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_objects.value(className.toLower()).value(ref);
+}
+
+QVariantMap MockXapiDatabase::GetAll(const QString& className) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    QVariantMap all;
+    const QHash<QString, QVariantMap> objects = this->m_objects.value(className.toLower());
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it)
+        all.insert(it.key(), it.value());
+    return all;
+}
+
+QStringList MockXapiDatabase::GetRefs(const QString& className) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_objects.value(className.toLower()).keys();
+}
+
+QStringList MockXapiDatabase::GetClasses() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_objects.keys();
+}
+
+int MockXapiDatabase::GetCount(const QString& className) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_objects.value(className.toLower()).size();
+}
+
+int MockXapiDatabase::GetTotalCount() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    int count = 0;
+    for (const QHash<QString, QVariantMap>& objects : this->m_objects)
+        count += objects.size();
+    return count;
+}
+
+qint64 MockXapiDatabase::GetLastEventId() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_nextEventId - 1;
+}
+
+int MockXapiDatabase::GetMaxEvents() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_maxEvents;
+}
+
+void MockXapiDatabase::SetMaxEvents(int maxEvents)
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_maxEvents = qMax(1, maxEvents);
+}
+
+QList<MockXapiEvent> MockXapiDatabase::WaitForEvents(const QStringList& classes,
+                                                     qint64 since,
+                                                     int timeoutMs,
+                                                     qint64* lastId,
+                                                     bool* eventsLost,
+                                                     const std::function<bool()>& cancelled)
+{
+    QList<MockXapiEvent> result;
+    if (eventsLost)
+        *eventsLost = false;
+
+    QMutexLocker locker(&this->m_mutex);
+
+    if (since < 0)
+    {
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        for (auto classIt = this->m_objects.constBegin(); classIt != this->m_objects.constEnd(); ++classIt)
+        {
+            for (auto it = classIt->constBegin(); it != classIt->constEnd(); ++it)
+            {
+                if (!matches(classes, classIt.key(), it.key()))
+                    continue;
+
+                MockXapiEvent event;
+                event.id = this->m_nextEventId - 1;
+                event.timestamp = now;
+                event.className = classIt.key();
+                event.operation = "add";
+                event.ref = it.key();
+                event.snapshot = it.value();
+                result.append(event);
+            }
+        }
+        if (lastId)
+            *lastId = this->m_nextEventId - 1;
+        return result;
+    }
+
+    if (since < this->m_droppedUpTo)
+    {
+        if (eventsLost)
+            *eventsLost = true;
+        if (lastId)
+            *lastId = this->m_nextEventId - 1;
+        return result;
+    }
+
+    QDeadlineTimer deadline(qMax(0, timeoutMs));
+    qint64 scanned = since;
+    for (;;)
+    {
+        // The log is ordered by id, so only the tail past the last scan is new
+        QHash<QString, int> latest;
+        int first = this->m_events.size();
+        while (first > 0 && this->m_events.at(first - 1).id > scanned)
+            --first;
+
+        for (int i = first; i < this->m_events.size(); ++i)
+        {
+            const MockXapiEvent& event = this->m_events.at(i);
+            if (!matches(classes, event.className, event.ref))
+                continue;
+
+            const QString key = event.className + '/' + event.ref;
+            auto found = latest.find(key);
+            if (found != latest.end())
+            {
+                result[found.value()] = event;
+            } else
+            {
+                latest.insert(key, result.size());
+                result.append(event);
+            }
+        }
+        scanned = this->m_nextEventId - 1;
+
+        if (!result.isEmpty() || deadline.hasExpired() || (cancelled && cancelled()))
+            break;
+
+        this->m_changed.wait(&this->m_mutex, QDeadlineTimer(qMin<qint64>(deadline.remainingTime(), WAIT_SLICE_MS)));
+    }
+
+    if (lastId)
+        *lastId = scanned;
+    return result;
+}
+
+void MockXapiDatabase::WakeAll()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_changed.wakeAll();
+}
+
+QString MockXapiDatabase::MakeUuid(QRandomGenerator& random)
+{
+    QByteArray bytes(16, Qt::Uninitialized);
+    for (int i = 0; i < 16; i += 4)
+    {
+        const quint32 value = random.generate();
+        memcpy(bytes.data() + i, &value, 4);
+    }
+    bytes[6] = char((bytes[6] & 0x0f) | 0x40);
+    bytes[8] = char((bytes[8] & 0x3f) | 0x80);
+    return QUuid::fromRfc4122(bytes).toString(QUuid::WithoutBraces);
+}
+
+QString MockXapiDatabase::MakeRef(QRandomGenerator& random)
+{
+    return "OpaqueRef:" + MakeUuid(random);
+}
+
+void MockXapiDatabase::appendEvent(const QString& className, const QString& operation,
+                                   const QString& ref, const QVariantMap& snapshot)
+{
+    MockXapiEvent event;
+    event.id = this->m_nextEventId++;
+    event.timestamp = QDateTime::currentSecsSinceEpoch();
+    event.className = className;
+    event.operation = operation;
+    event.ref = ref;
+    event.snapshot = snapshot;
+    this->m_events.append(event);
+
+    // Trim in batches so the log is not shifted on every append
+    if (this->m_events.size() > this->m_maxEvents + this->m_maxEvents / 8)
+    {
+        const int drop = this->m_events.size() - this->m_maxEvents;
+        this->m_droppedUpTo = this->m_events.at(drop - 1).id;
+        this->m_events.remove(0, drop);
+    }
+
+    this->m_changed.wakeAll();
+}
+
+bool MockXapiDatabase::matches(const QStringList& classes, const QString& className, const QString& ref)
+{
+    for (const QString& entry : classes)
+    {
+        if (entry == "*")
+            return true;
+
+        const int slash = entry.indexOf('/');
+        if (slash < 0)
+        {
+            if (entry.compare(className, Qt::CaseInsensitive) == 0)
+                return true;
+        } else if (entry.left(slash).compare(className, Qt::CaseInsensitive) == 0 && entry.mid(slash + 1) == ref)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MOCKXAPIDATABASE_H
+#define MOCKXAPIDATABASE_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QWaitCondition>
+#include <functional>
+
+class QRandomGenerator;
+
+/**
+ * @brief One entry of the mock event log, shaped like an xapi event record.
+ */
+struct MockXapiEvent
+{
+    qint64 id = 0;
+    qint64 timestamp = 0;   ///< Seconds since the epoch
+    QString className;      ///< Lower-case xapi class ("vm", "host", …)
+    QString operation;      ///< "add", "mod" or "del"
+    QString ref;
+    QVariantMap snapshot;   ///< Record after the change, empty for "del"
+
+    QVariantMap ToVariant() const;
+};
+
+/**
+ * @brief Thread-safe object store and event log behind MockXapiServer.
+ *
+ * Objects are kept per lower-case class name as plain xapi records. Every
+ * change appends an event, and event.from callers block in WaitForEvents()
+ * until a change they subscribed to arrives. Only the newest events are
+ * retained; a token older than that gets the same EVENTS_LOST treatment as
+ * on a real pool.
+ */
+class MockXapiDatabase
+{
+    public:
+        static const int DEFAULT_MAX_EVENTS = 100000;
+
+        MockXapiDatabase();
+
+        /** @brief Insert or replace an object and log an "add" event. */
+        void Add(const QString& className, const QString& ref, const QVariantMap& record);
+
+        /**
+         * @brief Merge @p fields into an object and log a "mod" event.
+         * @return false if the object does not exist
+         */
+        bool Modify(const QString& className, const QString& ref, const QVariantMap& fields);
+
+        /**
+         * @brief Apply @p change to an object under the lock and log a "mod" event.
+         *
+         * For read-modify-write updates such as appending to a reference list.
+         * @return false if the object does not exist
+         */
+        bool Update(const QString& className, const QString& ref, const std::function<void(QVariantMap&)>& change);
+
+        /**
+         * @brief Delete an object and log a "del" event.
+         * @return false if the object does not exist
+         */
+        bool Remove(const QString& className, const QString& ref);
+
+        void Clear();
+
+        bool Contains(const QString& className, const QString& ref) const;
+        QVariantMap Get(const QString& className, const QString& ref) const;
+
+        /** @brief All records of a class keyed by opaque ref. */
+        QVariantMap GetAll(const QString& className) const;
+        QStringList GetRefs(const QString& className) const;
+        QStringList GetClasses() const;
+        int GetCount(const QString& className) const;
+        int GetTotalCount() const;
+
+        /** @brief Id of the newest event; the event.from token to continue from. */
+        qint64 GetLastEventId() const;
+
+        int GetMaxEvents() const;
+        void SetMaxEvents(int maxEvents);
+
+        /**
+         * @brief Collect events for an event.from call.
+         *
+         * With @p since < 0 the current state is returned as "add" events.
+         * Otherwise waits up to @p timeoutMs for events newer than @p since
+         * that match @p classes, and returns them coalesced to the latest
+         * event per object. @p classes entries are class names, "*" or
+         * "class/ref" for a single object.
+         *
+         * @param lastId     Receives the token for the next call
+         * @param eventsLost Set when @p since predates the retained log
+         * @param cancelled  Polled while waiting; stops the wait early
+         */
+        QList<MockXapiEvent> WaitForEvents(const QStringList& classes,
+                                           qint64 since,
+                                           int timeoutMs,
+                                           qint64* lastId,
+                                           bool* eventsLost,
+                                           const std::function<bool()>& cancelled = std::function<bool()>());
+
+        /** @brief Wake every WaitForEvents() caller so it re-checks @p cancelled. */
+        void WakeAll();
+
+        /** @brief Random version 4 UUID drawn from @p random, for reproducible inventories. */
+        static QString MakeUuid(QRandomGenerator& random);
+
+        /** @brief "OpaqueRef:" followed by a random UUID. */
+        static QString MakeRef(QRandomGenerator& random);
+
+    private:
+        void appendEvent(const QString& className, const QString& operation,
+                         const QString& ref, const QVariantMap& snapshot);
+        static bool matches(const QStringList& classes, const QString& className, const QString& ref);
+
+        mutable QMutex m_mutex;
+        QWaitCondition m_changed;
+        QHash<QString, QHash<QString, QVariantMap>> m_objects;
+        QList<MockXapiEvent> m_events;
+        qint64 m_nextEventId = 1;
+        qint64 m_droppedUpTo = 0;   ///< Newest event id no longer in the log
+        int m_maxEvents = DEFAULT_MAX_EVENTS;
+};
+
+#endif // MOCKXAPIDATABASE_H
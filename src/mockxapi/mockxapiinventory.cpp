@@ -0,0 +1,705 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mockxapiinventory.h"
+#include "mockxapidatabase.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QVariantList>
+#include <QXmlStreamWriter>
+
+namespace
+{
+    const QString NULL_REF = "OpaqueRef:NULL";
+    const qint64 GIB = 1024LL * 1024 * 1024;
+    const qint64 MIB = 1024LL * 1024;
+    const int RRD_STEP_SECONDS = 5;
+    const int SUBFOLDERS_PER_FOLDER = 4;
+
+    // Records are assembled here and only written once every back reference is known
+    class Builder
+    {
+        public:
+            explicit Builder(quint32 seed) : m_random(seed)
+            {
+            }
+
+            QString New(const QString& className, const QVariantMap& record)
+            {
+                const QString ref = MockXapiDatabase::MakeRef(this->m_random);
+                QVariantMap full = record;
+                full.insert("uuid", MockXapiDatabase::MakeUuid(this->m_random));
+                this->m_order.append(qMakePair(className, ref));
+                this->m_records.insert(ref, full);
+                return ref;
+            }
+
+            QVariantMap& At(const QString& ref)
+            {
+                return this->m_records[ref];
+            }
+
+            void Append(const QString& ref, const QString& field, const QString& value)
+            {
+                QVariantMap& record = this->m_records[ref];
+                QVariantList list = record.value(field).toList();
+                list.append(value);
+                record.insert(field, list);
+            }
+
+            QString Mac()
+            {
+                const quint32 value = this->m_random.generate();
+                return QString("02:00:%1:%2:%3:%4")
+                    .arg((value >> 24) & 0xff, 2, 16, QChar('0'))
+                    .arg((value >> 16) & 0xff, 2, 16, QChar('0'))
+                    .arg((value >> 8) & 0xff, 2, 16, QChar('0'))
+                    .arg(value & 0xff, 2, 16, QChar('0'));
+            }
+
+            const QList<QPair<QString, QString>>& GetOrder() const
+            {
+                return this->m_order;
+            }
+
+            void WriteTo(MockXapiDatabase& database) const
+            {
+                for (const QPair<QString, QString>& entry : this->m_order)
+                    database.Add(entry.first, entry.second, this->m_records.value(entry.second));
+            }
+
+        private:
+            QRandomGenerator m_random;
+            QList<QPair<QString, QString>> m_order;
+            QHash<QString, QVariantMap> m_records;
+    };
+
+    QString xapiTime(const QDateTime& time)
+    {
+        return time.toUTC().toString("yyyyMMddTHH:mm:ssZ");
+    }
+
+    QVariantMap vmRecord(const QString& name, bool controlDomain)
+    {
+        QVariantMap vm;
+        vm.insert("name_label", name);
+        vm.insert("name_description", QString());
+        vm.insert("power_state", "Halted");
+        vm.insert("is_a_template", false);
+        vm.insert("is_default_template", false);
+        vm.insert("is_a_snapshot", false);
+        vm.insert("is_control_domain", controlDomain);
+        vm.insert("resident_on", NULL_REF);
+        vm.insert("affinity", NULL_REF);
+        vm.insert("domid", -1);
+        vm.insert("memory_static_min", 512 * MIB);
+        vm.insert("memory_static_max", 2 * GIB);
+        vm.insert("memory_dynamic_min", 2 * GIB);
+        vm.insert("memory_dynamic_max", 2 * GIB);
+        vm.insert("memory_target", 2 * GIB);
+        vm.insert("memory_overhead", 20 * MIB);
+        vm.insert("VCPUs_max", 2);
+        vm.insert("VCPUs_at_startup", 2);
+        vm.insert("VCPUs_params", QVariantMap());
+        vm.insert("VBDs", QVariantList());
+        vm.insert("VIFs", QVariantList());
+        vm.insert("VGPUs", QVariantList());
+        vm.insert("VUSBs", QVariantList());
+        vm.insert("VTPMs", QVariantList());
+        vm.insert("consoles", QVariantList());
+        vm.insert("crash_dumps", QVariantList());
+        vm.insert("snapshots", QVariantList());
+        vm.insert("children", QVariantList());
+        vm.insert("attached_PCIs", QVariantList());
+        vm.insert("snapshot_of", NULL_REF);
+        vm.insert("parent", NULL_REF);
+        vm.insert("appliance", NULL_REF);
+        vm.insert("protection_policy", NULL_REF);
+        vm.insert("snapshot_schedule", NULL_REF);
+        vm.insert("suspend_VDI", NULL_REF);
+        vm.insert("suspend_SR", NULL_REF);
+        vm.insert("guest_metrics", NULL_REF);
+        vm.insert("metrics", NULL_REF);
+        vm.insert("HVM_boot_policy", controlDomain ? QString() : QString("BIOS order"));
+        vm.insert("HVM_boot_params", QVariantMap{{"order", "cdn"}});
+        vm.insert("PV_bootloader", QString());
+        vm.insert("PV_args", QString());
+        vm.insert("platform", QVariantMap());
+        vm.insert("other_config", QVariantMap());
+        vm.insert("xenstore_data", QVariantMap());
+        vm.insert("blobs", QVariantMap());
+        vm.insert("blocked_operations", QVariantMap());
+        vm.insert("current_operations", QVariantMap());
+        vm.insert("allowed_operations", QVariantList());
+        vm.insert("tags", QVariantList());
+        vm.insert("ha_restart_priority", QString());
+        vm.insert("ha_always_run", false);
+        vm.insert("order", 0);
+        vm.insert("start_delay", 0);
+        vm.insert("shutdown_delay", 0);
+        vm.insert("user_version", 1);
+        vm.insert("recommendations", QString());
+        vm.insert("domarch", QString());
+        vm.insert("has_vendor_device", false);
+        return vm;
+    }
+}
+
+void MockXapiInventory::Populate(MockXapiDatabase& database, const MockXapiInventoryOptions& options)
+{
+    Builder b(options.seed);
+    const QString now = xapiTime(QDateTime::currentDateTimeUtc());
+    const int hostCount = qMax(1, options.hosts);
+
+    const QString poolRef = b.New("pool", {
+        {"name_label", options.poolName},
+        {"name_description", QString()},
+        {"ha_enabled", false},
+        {"other_config", QVariantMap()},
+        {"gui_config", QVariantMap()},
+        {"tags", QVariantList()},
+        {"allowed_operations", QVariantList()},
+        {"current_operations", QVariantMap()},
+        {"blobs", QVariantMap()},
+    });
+
+    QStringList hostRefs;
+    QStringList localSrRefs;
+    for (int h = 0; h < hostCount; ++h)
+    {
+        const QString name = QString("host-%1").arg(h + 1, 2, 10, QChar('0'));
+        const QString metricsRef = b.New("host_metrics", {
+            {"memory_total", 256 * GIB},
+            {"memory_free", 200 * GIB},
+            {"live", true},
+            {"last_updated", now},
+            {"other_config", QVariantMap()},
+        });
+
+        const QString hostRef = b.New("host", {
+            {"name_label", name},
+            {"name_description", QString()},
+            {"hostname", name},
+            {"address", QString("10.0.%1.%2").arg(h / 250).arg(h % 250 + 1)},
+            {"enabled", true},
+            {"API_version_major", 2},
+            {"API_version_minor", 21},
+            {"API_version_vendor", "XenSource"},
+            {"software_version", QVariantMap{{"product_version", "8.4.0"}, {"platform_name", "XCP"}, {"xapi", "24.39"}}},
+            {"cpu_info", QVariantMap{{"cpu_count", "32"}, {"socket_count", "2"}, {"vendor", "GenuineIntel"}}},
+            {"memory_overhead", 1 * GIB},
+            {"metrics", metricsRef},
+            {"resident_VMs", QVariantList()},
+            {"PBDs", QVariantList()},
+            {"PIFs", QVariantList()},
+            {"host_CPUs", QVariantList()},
+            {"PCIs", QVariantList()},
+            {"PGPUs", QVariantList()},
+            {"PUSBs", QVariantList()},
+            {"crashdumps", QVariantList()},
+            {"patches", QVariantList()},
+            {"updates", QVariantList()},
+            {"control_domain", NULL_REF},
+            {"suspend_image_sr", NULL_REF},
+            {"crash_dump_sr", NULL_REF},
+            {"local_cache_sr", NULL_REF},
+            {"edition", "xcp-ng"},
+            {"license_params", QVariantMap()},
+            {"capabilities", QVariantList()},
+            {"other_config", QVariantMap()},
+            {"logging", QVariantMap()},
+            {"tags", QVariantList()},
+            {"allowed_operations", QVariantList{"provision", "evacuate", "reboot", "shutdown"}},
+            {"current_operations", QVariantMap()},
+            {"blobs", QVariantMap()},
+        });
+        hostRefs.append(hostRef);
+
+        // Control domain
+        QVariantMap dom0 = vmRecord(QString("Control domain on host: %1").arg(name), true);
+        dom0.insert("power_state", "Running");
+        dom0.insert("resident_on", hostRef);
+        dom0.insert("domid", 0);
+        const QString dom0Ref = b.New("vm", dom0);
+        b.At(hostRef).insert("control_domain", dom0Ref);
+        b.Append(hostRef, "resident_VMs", dom0Ref);
+
+        // Local storage
+        const QString srRef = b.New("sr", {
+            {"name_label", "Local storage"},
+            {"name_description", QString()},
+            {"type", "lvm"},
+            {"content_type", "user"},
+            {"shared", false},
+            {"physical_size", 1024 * GIB},
+            {"physical_utilisation", 0},
+            {"virtual_allocation", 0},
+            {"VDIs", QVariantList()},
+            {"PBDs", QVariantList()},
+            {"sm_config", QVariantMap()},
+            {"other_config", QVariantMap{{"i18n-key", "local-storage"}}},
+            {"tags", QVariantList()},
+            {"allowed_operations", QVariantList{"scan", "vdi_create"}},
+            {"current_operations", QVariantMap()},
+            {"blobs", QVariantMap()},
+            {"local_cache_enabled", false},
+            {"is_tools_sr", false},
+            {"introduced_by", NULL_REF},
+            {"clustered", false},
+        });
+        localSrRefs.append(srRef);
+        const QString pbdRef = b.New("pbd", {
+            {"host", hostRef},
+            {"SR", srRef},
+            {"currently_attached", true},
+            {"device_config", QVariantMap()},
+            {"other_config", QVariantMap()},
+        });
+        b.Append(hostRef, "PBDs", pbdRef);
+        b.Append(srRef, "PBDs", pbdRef);
+        b.At(hostRef).insert("suspend_image_sr", srRef);
+        b.At(hostRef).insert("crash_dump_sr", srRef);
+    }
+
+    QString sharedSrRef;
+    if (options.sharedStorage)
+    {
+        sharedSrRef = b.New("sr", {
+            {"name_label", "Shared storage"},
+            {"name_description", "NFS SR"},
+            {"type", "nfs"},
+            {"content_type", "user"},
+            {"shared", true},
+            {"physical_size", 16384 * GIB},
+            {"physical_utilisation", 0},
+            {"virtual_allocation", 0},
+            {"VDIs", QVariantList()},
+            {"PBDs", QVariantList()},
+            {"sm_config", QVariantMap()},
+            {"other_config", QVariantMap()},
+            {"tags", QVariantList()},
+            {"allowed_operations", QVariantList{"scan", "vdi_create"}},
+            {"current_operations", QVariantMap()},
+            {"blobs", QVariantMap()},
+            {"local_cache_enabled", false},
+            {"is_tools_sr", false},
+            {"introduced_by", NULL_REF},
+            {"clustered", false},
+        });
+        for (const QString& hostRef : hostRefs)
+        {
+            const QString pbdRef = b.New("pbd", {
+                {"host", hostRef},
+                {"SR", sharedSrRef},
+                {"currently_attached", true},
+                {"device_config", QVariantMap{{"server", "nfs.example"}, {"serverpath", "/export"}}},
+                {"other_config", QVariantMap()},
+            });
+            b.Append(hostRef, "PBDs", pbdRef);
+            b.Append(sharedSrRef, "PBDs", pbdRef);
+        }
+    }
+
+    QStringList networkRefs;
+    for (int n = 0; n < qMax(1, options.networks); ++n)
+    {
+        const QString networkRef = b.New("network", {
+            {"name_label", QString("Pool-wide network associated with eth%1").arg(n)},
+            {"name_description", QString()},
+            {"bridge", QString("xenbr%1").arg(n)},
+            {"MTU", 1500},
+            {"managed", true},
+            {"PIFs", QVariantList()},
+            {"VIFs", QVariantList()},
+            {"other_config", QVariantMap()},
+            {"tags", QVariantList()},
+            {"allowed_operations", QVariantList()},
+            {"current_operations", QVariantMap()},
+            {"blobs", QVariantMap()},
+            {"default_locking_mode", "unlocked"},
+        });
+        networkRefs.append(networkRef);
+
+        for (int h = 0; h < hostRefs.size(); ++h)
+        {
+            const QString pifRef = b.New("pif", {
+                {"device", QString("eth%1").arg(n)},
+                {"network", networkRef},
+                {"host", hostRefs.at(h)},
+                {"MAC", b.Mac()},
+                {"MTU", 1500},
+                {"VLAN", -1},
+                {"physical", true},
+                {"currently_attached", true},
+                {"management", n == 0},
+                {"ip_configuration_mode", n == 0 ? "DHCP" : "None"},
+                {"IP", n == 0 ? b.At(hostRefs.at(h)).value("address").toString() : QString()},
+                {"netmask", n == 0 ? "255.255.0.0" : QString()},
+                {"gateway", QString()},
+                {"DNS", QString()},
+                {"metrics", NULL_REF},
+                {"bond_master_of", QVariantList()},
+                {"bond_slave_of", NULL_REF},
+                {"VLAN_master_of", NULL_REF},
+                {"VLAN_slave_of", QVariantList()},
+                {"tunnel_access_PIF_of", QVariantList()},
+                {"tunnel_transport_PIF_of", QVariantList()},
+                {"other_config", QVariantMap()},
+                {"managed", true},
+            });
+            b.Append(hostRefs.at(h), "PIFs", pifRef);
+            b.Append(networkRef, "PIFs", pifRef);
+        }
+    }
+
+    int vmIndex = 0;
+    for (int h = 0; h < hostRefs.size(); ++h)
+    {
+        const QString hostRef = hostRefs.at(h);
+        for (int v = 0; v < options.vmsPerHost; ++v)
+        {
+            ++vmIndex;
+            const QString name = QString("vm-%1").arg(vmIndex, 4, 10, QChar('0'));
+            // Two out of three VMs run, the rest are halted
+            const bool running = vmIndex % 3 != 0;
+
+            const QString metricsRef = b.New("vm_metrics", {
+                {"memory_actual", running ? 2 * GIB : 0},
+                {"VCPUs_number", running ? 2 : 0},
+                {"VCPUs_utilisation", QVariantMap()},
+                {"start_time", now},
+                {"install_time", now},
+                {"last_updated", now},
+                {"state", QVariantList()},
+                {"other_config", QVariantMap()},
+            });
+
+            QVariantMap vm = vmRecord(name, false);
+            vm.insert("metrics", metricsRef);
+            vm.insert("affinity", hostRef);
+            if (options.folders > 0)
+            {
+                const int folder = vmIndex % (options.folders * SUBFOLDERS_PER_FOLDER);
+                vm.insert("other_config", QVariantMap{{"folder", QString("/Folder %1/Sub %2")
+                                                                     .arg(folder / SUBFOLDERS_PER_FOLDER + 1)
+                                                                     .arg(folder % SUBFOLDERS_PER_FOLDER + 1)}});
+            }
+            if (options.tags > 0)
+                vm.insert("tags", QVariantList{QString("tag-%1").arg(vmIndex % options.tags + 1)});
+            if (running)
+            {
+                vm.insert("power_state", "Running");
+                vm.insert("resident_on", hostRef);
+                vm.insert("domid", vmIndex);
+                vm.insert("allowed_operations", QVariantList{"clean_shutdown", "hard_shutdown", "clean_reboot", "hard_reboot", "pause", "suspend", "snapshot"});
+            } else
+            {
+                vm.insert("allowed_operations", QVariantList{"start", "start_on", "export", "copy", "clone", "destroy", "snapshot"});
+            }
+            const QString vmRef = b.New("vm", vm);
+            if (running)
+                b.Append(hostRef, "resident_VMs", vmRef);
+
+            const QString srRef = options.sharedStorage ? sharedSrRef : localSrRefs.at(h);
+            for (int d = 0; d < options.vdisPerVm; ++d)
+            {
+                const QString vdiRef = b.New("vdi", {
+                    {"name_label", QString("%1 disk %2").arg(name).arg(d)},
+                    {"name_description", QString()},
+                    {"SR", srRef},
+                    {"VBDs", QVariantList()},
+                    {"virtual_size", 32 * GIB},
+                    {"physical_utilisation", 4 * GIB},
+                    {"type", "user"},
+                    {"sharable", false},
+                    {"read_only", false},
+                    {"managed", true},
+                    {"missing", false},
+                    {"is_a_snapshot", false},
+                    {"snapshot_of", NULL_REF},
+                    {"snapshots", QVariantList()},
+                    {"parent", NULL_REF},
+                    {"location", QString()},
+                    {"sm_config", QVariantMap()},
+                    {"xenstore_data", QVariantMap()},
+                    {"other_config", QVariantMap()},
+                    {"tags", QVariantList()},
+                    {"allowed_operations", QVariantList{"clone", "copy", "snapshot"}},
+                    {"current_operations", QVariantMap()},
+                    {"crash_dumps", QVariantList()},
+                });
+                b.At(vdiRef).insert("location", b.At(vdiRef).value("uuid"));
+                b.Append(srRef, "VDIs", vdiRef);
+
+                const QString vbdRef = b.New("vbd", {
+                    {"VM", vmRef},
+                    {"VDI", vdiRef},
+                    {"userdevice", QString::number(d)},
+                    {"device", running ? QString("xvd%1").arg(QChar('a' + d % 26)) : QString()},
+                    {"bootable", d == 0},
+                    {"mode", "RW"},
+                    {"type", "Disk"},
+                    {"empty", false},
+                    {"unpluggable", false},
+                    {"currently_attached", running},
+                    {"metrics", NULL_REF},
+                    {"qos_algorithm_type", QString()},
+                    {"qos_algorithm_params", QVariantMap()},
+                    {"other_config", QVariantMap()},
+                    {"allowed_operations", QVariantList()},
+                    {"current_operations", QVariantMap()},
+                });
+                b.Append(vmRef, "VBDs", vbdRef);
+                b.Append(vdiRef, "VBDs", vbdRef);
+            }
+
+            const QString networkRef = networkRefs.at(vmIndex % networkRefs.size());
+            const QString vifRef = b.New("vif", {
+                {"device", "0"},
+                {"network", networkRef},
+                {"VM", vmRef},
+                {"MAC", b.Mac()},
+                {"MAC_autogenerated", true},
+                {"MTU", 1500},
+                {"currently_attached", running},
+                {"locking_mode", "network_default"},
+                {"ipv4_allowed", QVariantList()},
+                {"ipv6_allowed", QVariantList()},
+                {"metrics", NULL_REF},
+                {"qos_algorithm_type", QString()},
+                {"qos_algorithm_params", QVariantMap()},
+                {"other_config", QVariantMap()},
+                {"allowed_operations", QVariantList()},
+                {"current_operations", QVariantMap()},
+            });
+            b.Append(vmRef, "VIFs", vifRef);
+            b.Append(networkRef, "VIFs", vifRef);
+
+            const QString consoleRef = b.New("console", {
+                {"protocol", "rfb"},
+                {"VM", vmRef},
+                {"other_config", QVariantMap()},
+            });
+            b.At(consoleRef).insert("location", QString("https://%1/console?uuid=%2")
+                                                    .arg(b.At(hostRef).value("address").toString(),
+                                                         b.At(consoleRef).value("uuid").toString()));
+            b.Append(vmRef, "consoles", consoleRef);
+        }
+    }
+
+    // Messages are not referenced by anything, only their obj_uuid points back
+    QStringList vmRefs;
+    for (const QPair<QString, QString>& entry : b.GetOrder())
+    {
+        if (entry.first == "vm" && !b.At(entry.second).value("is_control_domain").toBool())
+            vmRefs.append(entry.second);
+    }
+    const QDateTime created = QDateTime::currentDateTimeUtc();
+    for (int m = 0; m < options.messages; ++m)
+    {
+        // Every fifth alert is about a host, the rest about VMs
+        const bool aboutHost = vmRefs.isEmpty() || m % 5 == 0;
+        const QString subjectRef = aboutHost ? hostRefs.at(m % hostRefs.size()) : vmRefs.at(m % vmRefs.size());
+        const int priority = 1 + m % 5;
+        b.New("message", {
+            {"name", aboutHost ? "HOST_CLOCK_SKEW_DETECTED" : "VM_STARTED"},
+            {"priority", priority},
+            {"cls", aboutHost ? "Host" : "VM"},
+            {"obj_uuid", b.At(subjectRef).value("uuid")},
+            {"timestamp", xapiTime(created.addSecs(-60LL * (options.messages - m)))},
+            {"body", QString("Synthetic message %1 about %2").arg(m + 1).arg(b.At(subjectRef).value("name_label").toString())},
+        });
+    }
+
+    QVariantMap& pool = b.At(poolRef);
+    pool.insert("master", hostRefs.first());
+    pool.insert("default_SR", options.sharedStorage ? sharedSrRef : localSrRefs.first());
+    pool.insert("suspend_image_SR", pool.value("default_SR"));
+    pool.insert("crash_dump_SR", pool.value("default_SR"));
+
+    const QList<QPair<QString, QString>> roles = {
+        {"pool-admin", "The Pool Administrator role has full access to all features and settings"},
+        {"pool-operator", "The Pool Operator role manages host- and pool-wide resources"},
+        {"vm-admin", "The VM Administrator role can manage VMs and snapshots"},
+        {"read-only", "The Read-Only role can log in with basic read-only access"},
+    };
+    for (const QPair<QString, QString>& role : roles)
+    {
+        b.New("role", {
+            {"name_label", role.first},
+            {"name_description", role.second},
+            {"subroles", QVariantList()},
+            {"is_internal", false},
+        });
+    }
+
+    b.WriteTo(database);
+}
+
+QString MockXapiInventory::GetMasterRef(const MockXapiDatabase& database)
+{
+    const QVariantMap pools = database.GetAll("pool");
+    if (pools.isEmpty())
+        return QString();
+    return pools.first().toMap().value("master").toString();
+}
+
+MockXapiInventoryOptions MockXapiInventory::OptionsForObjectCount(int objects, quint32 seed)
+{
+    // Per host: host, metrics, dom0, local SR, PBD, shared PBD and a PIF per network.
+    // Per VM: VM, metrics, VIF, console and a VDI plus VBD per disk.
+    MockXapiInventoryOptions options;
+    options.seed = seed;
+    options.poolName = QString("Synthetic pool (%1 objects)").arg(objects);
+    options.hosts = qBound(1, objects / 400, 64);
+    options.networks = 4;
+    options.vdisPerVm = 1;
+    options.messages = objects / 10;
+
+    const int perHost = 6 + options.networks;
+    const int perVm = 4 + 2 * options.vdisPerVm;
+    const int vmBudget = objects - options.messages - options.hosts * perHost;
+    options.vmsPerHost = qMax(0, vmBudget / perVm / options.hosts);
+
+    const int vms = options.vmsPerHost * options.hosts;
+    options.folders = qMax(1, vms / 200);
+    options.tags = qMax(1, vms / 100);
+    return options;
+}
+
+QByteArray MockXapiInventory::ExportEventDump(const MockXapiDatabase& database)
+{
+    const qint64 lastId = database.GetLastEventId();
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    QVariantList eventList;
+    eventList.reserve(database.GetTotalCount());
+    QVariantMap validRefCounts;
+    const QStringList classes = database.GetClasses();
+    for (const QString& cls : classes)
+    {
+        const QVariantMap records = database.GetAll(cls);
+        for (auto it = records.constBegin(); it != records.constEnd(); ++it)
+        {
+            MockXapiEvent event;
+            event.id = lastId;
+            event.timestamp = now;
+            event.className = cls;
+            event.operation = "add";
+            event.ref = it.key();
+            event.snapshot = it.value().toMap();
+            eventList.append(event.ToVariant());
+        }
+        validRefCounts.insert(cls, records.size());
+    }
+
+    const QVariantMap result{
+        {"events", eventList},
+        {"valid_ref_counts", validRefCounts},
+        {"token", QString("%1").arg(lastId, 20, 10, QChar('0'))},
+    };
+    const QJsonObject reply{
+        {"jsonrpc", "2.0"},
+        {"result", QJsonObject::fromVariantMap(result)},
+        {"id", 1},
+    };
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+QByteArray MockXapiInventory::ExportRrdUpdates(const MockXapiDatabase& database, bool includeHosts, qint64 end, int rows)
+{
+    QStringList legend;
+    if (includeHosts)
+    {
+        const QVariantMap hosts = database.GetAll("host");
+        for (const QVariant& host : hosts)
+        {
+            const QString uuid = host.toMap().value("uuid").toString();
+            for (const char* metric : {"cpu0", "cpu1", "memory_total_kib", "memory_free_kib", "loadavg"})
+                legend.append(QString("AVERAGE:host:%1:%2").arg(uuid, metric));
+        }
+    }
+
+    const QVariantMap vms = database.GetAll("vm");
+    for (const QVariant& vm : vms)
+    {
+        const QVariantMap record = vm.toMap();
+        if (record.value("power_state").toString() != "Running" || record.value("is_control_domain").toBool())
+            continue;
+        const QString uuid = record.value("uuid").toString();
+        for (const char* metric : {"cpu0", "memory", "memory_internal_free", "vif_0_rx", "vif_0_tx", "vbd_xvda_read", "vbd_xvda_write"})
+            legend.append(QString("AVERAGE:vm:%1:%2").arg(uuid, metric));
+    }
+
+    rows = qMax(1, rows);
+    end = end / RRD_STEP_SECONDS * RRD_STEP_SECONDS;
+    const qint64 start = end - RRD_STEP_SECONDS * (rows - 1);
+
+    QByteArray body;
+    QXmlStreamWriter xml(&body);
+    xml.writeStartDocument();
+    xml.writeStartElement("xport");
+    xml.writeStartElement("meta");
+    xml.writeTextElement("start", QString::number(start));
+    xml.writeTextElement("step", QString::number(RRD_STEP_SECONDS));
+    xml.writeTextElement("end", QString::number(end));
+    xml.writeTextElement("rows", QString::number(rows));
+    xml.writeTextElement("columns", QString::number(legend.size()));
+    xml.writeStartElement("legend");
+    for (const QString& entry : legend)
+        xml.writeTextElement("entry", entry);
+    xml.writeEndElement(); // legend
+    xml.writeEndElement(); // meta
+
+    QRandomGenerator* random = QRandomGenerator::global();
+    xml.writeStartElement("data");
+    for (qint64 t = end; t >= start; t -= RRD_STEP_SECONDS)
+    {
+        xml.writeStartElement("row");
+        xml.writeTextElement("t", QString::number(t));
+        for (const QString& entry : legend)
+        {
+            double value = random->bounded(1.0);
+            if (entry.contains("memory"))
+                value = 1024.0 * 1024.0 * (1024 + random->bounded(1024));
+            else if (entry.contains("vif_") || entry.contains("vbd_"))
+                value = random->bounded(10.0 * 1024 * 1024);
+            xml.writeTextElement("v", QString::number(value, 'g', 10));
+        }
+        xml.writeEndElement(); // row
+    }
+    xml.writeEndElement(); // data
+    xml.writeEndElement(); // xport
+    xml.writeEndDocument();
+    return body;
+}
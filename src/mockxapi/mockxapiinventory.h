@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MOCKXAPIINVENTORY_H
+#define MOCKXAPIINVENTORY_H
+
+#include <QByteArray>
+#include <QString>
+
+class MockXapiDatabase;
+
+/**
+ * @brief Size and shape of a generated pool.
+ */
+struct MockXapiInventoryOptions
+{
+    int hosts = 1;
+    int vmsPerHost = 10;
+    int vdisPerVm = 1;
+    int networks = 2;            ///< Every host gets one PIF per network
+    int messages = 0;            ///< Alerts spread over the VMs and hosts
+    int folders = 0;             ///< VMs spread over this many folders, each with subfolders; 0 for none
+    int tags = 0;                ///< VMs carry one of this many tags; 0 for none
+    bool sharedStorage = true;   ///< VM disks live on one shared SR instead of local SRs
+    quint32 seed = 1;            ///< Same seed, same refs and UUIDs
+    QString poolName = "Mock pool";
+};
+
+/**
+ * @brief Fills a MockXapiDatabase with a consistent pool.
+ *
+ * Every reference field points at an object that exists and the reverse
+ * lists (host.resident_VMs, VM.VBDs, SR.VDIs, network.PIFs, …) agree with
+ * them, so the client side sees the same shape it would get from xapi.
+ */
+class MockXapiInventory
+{
+    public:
+        /** @brief Add a pool built from @p options to @p database. */
+        static void Populate(MockXapiDatabase& database, const MockXapiInventoryOptions& options);
+
+        /** @brief Ref of the pool coordinator, or an empty string if there is no pool. */
+        static QString GetMasterRef(const MockXapiDatabase& database);
+
+        /**
+         * @brief Options for a pool of roughly @p objects objects in total.
+         *
+         * Hosts are added up to the 64-host pool limit as the size grows, a
+         * tenth of the objects are messages and VMs are spread over folders
+         * and tags, so benchmarks at different sizes see the same mix.
+         */
+        static MockXapiInventoryOptions OptionsForObjectCount(int objects, quint32 seed = 1);
+
+        /**
+         * @brief The whole database as the JSON-RPC reply to an initial event.from.
+         *
+         * Same layout as a captured <tt>{"result": {"events": […], …}}</tt> dump,
+         * so it loads wherever such fixtures are used.
+         */
+        static QByteArray ExportEventDump(const MockXapiDatabase& database);
+
+        /**
+         * @brief An /rrd_updates xport document for the running VMs, and the hosts if asked.
+         * @param end   Timestamp of the newest row
+         * @param rows  Rows of 5-second samples, newest first
+         */
+        static QByteArray ExportRrdUpdates(const MockXapiDatabase& database, bool includeHosts, qint64 end, int rows = 2);
+
+    private:
+        MockXapiInventory() = delete;
+};
+
+#endif // MOCKXAPIINVENTORY_H
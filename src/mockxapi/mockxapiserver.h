@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MOCKXAPISERVER_H
+#define MOCKXAPISERVER_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class MockXapiDatabase;
+
+/**
+ * @brief A scripted failure injected into matching requests.
+ */
+struct MockXapiFault
+{
+    enum class Kind
+    {
+        Failure,     ///< JSON-RPC error carrying errorDescription
+        HttpError,   ///< Bare HTTP error status, no JSON-RPC body
+        Disconnect,  ///< Connection dropped before any response
+        Stall        ///< Extra stallMs before the normal response
+    };
+
+    QString method = "*";   ///< JSON-RPC method, HTTP path ("/rrd_updates") or "*"
+    Kind kind = Kind::Failure;
+    QStringList errorDescription = {"INTERNAL_ERROR", "Injected fault"};
+    int httpStatus = 500;
+    int stallMs = 0;
+    int skip = 0;           ///< Matching requests let through before the first hit
+    int count = 1;          ///< Number of hits, -1 for every matching request
+};
+
+/**
+ * @brief In-process stand-in for xapi, for load and regression tests.
+ *
+ * Speaks HTTP/1.1 with keep-alive, by default over TLS with a built-in
+ * self-signed certificate, and serves:
+ * - JSON-RPC on /jsonrpc: session login/logout, event.from, the generic
+ *   get_all_records / get_record / get_* / set_* family,
+ *   VM power operations, task.* and Async.* calls that complete as tasks;
+ * - /rrd_updates with an xport document for the running VMs and hosts.
+ *
+ * Objects come from GetDatabase(), usually filled by MockXapiInventory.
+ * Latency and faults can be injected per method, and Schedule() or
+ * LoadEventScript() replay timed changes so clients see a live event
+ * stream.
+ *
+ * With SetCompressionEnabled() responses are gzip or deflate encoded for
+ * clients that ask for it, like a compressing reverse proxy in front of
+ * xapi would do.
+ *
+ * Requests are handled with blocking sockets on one thread per connection,
+ * so the server does not need an event loop in the thread that owns it.
+ */
+class MockXapiServer
+{
+    public:
+        static const int DEFAULT_TASK_DURATION_MS = 200;
+
+        MockXapiServer();
+        ~MockXapiServer();
+
+        /**
+         * @brief Start listening.
+         * @param port 0 picks a free port, see GetPort()
+         * @return false with GetError() set if the socket or TLS setup failed
+         */
+        bool Start(quint16 port = 0, const QHostAddress& address = QHostAddress::LocalHost);
+
+        /** @brief Close the listener and every connection, and stop scheduled work. */
+        void Stop();
+
+        bool IsRunning() const;
+        quint16 GetPort() const;
+        QString GetError() const;
+
+        /** @brief Serve plain HTTP instead of TLS. Takes effect on Start(). */
+        void SetTlsEnabled(bool enabled);
+        bool IsTlsEnabled() const;
+
+        /**
+         * @brief Replace the built-in certificate with PEM-encoded ones.
+         * @return false if either could not be parsed
+         */
+        bool SetCertificate(const QByteArray& certificatePem, const QByteArray& privateKeyPem);
+
+        /** @brief Require these credentials for login; by default any are accepted. */
+        void SetCredentials(const QString& username, const QString& password);
+
+        MockXapiDatabase* GetDatabase() const;
+
+        /**
+         * @brief Compress responses and accept compressed requests.
+         *
+         * Responses are encoded as the client's Accept-Encoding allows and
+         * streamed with chunked transfer encoding. While disabled, the
+         * default, a request with a Content-Encoding gets 415. Has no effect
+         * in builds without zlib.
+         */
+        void SetCompressionEnabled(bool enabled);
+        bool IsCompressionEnabled() const;
+
+        // ── Latency and faults ──────────────────────────────────────────────
+
+        /** @brief Delay added to every request, plus up to @p jitterMs at random. */
+        void SetLatency(int ms, int jitterMs = 0);
+
+        /** @brief Delay for one method instead of the default latency; -1 removes it. */
+        void SetMethodLatency(const QString& method, int ms);
+
+        void AddFault(const MockXapiFault& fault);
+        void ClearFaults();
+
+        // ── Tasks and scripted events ───────────────────────────────────────
+
+        /** @brief Time an Async.* call stays pending before its task completes. */
+        void SetTaskDuration(int ms);
+        int GetTaskDuration() const;
+
+        /**
+         * @brief Run @p action against the database @p delayMs from now.
+         *
+         * Actions run in order on the server's scheduler thread, which starts
+         * with the server and drops anything still pending on Stop().
+         */
+        void Schedule(int delayMs, const std::function<void(MockXapiDatabase&)>& action);
+
+        /**
+         * @brief Schedule the changes described by a JSON event script.
+         *
+         * The script is an array of
+         * <tt>{"delay_ms": 500, "class": "vm", "operation": "mod", "ref": "OpaqueRef:…", "snapshot": {…}}</tt>
+         * entries; delays are relative to the call. "add" inserts
+         * the snapshot, "mod" merges it into the object and "del" removes it.
+         */
+        bool LoadEventScript(const QByteArray& json, QString* error = nullptr);
+
+        // ── Statistics ──────────────────────────────────────────────────────
+
+        /** @brief Requests handled for @p method, or all of them when empty. */
+        int GetCallCount(const QString& method = QString()) const;
+
+        /** @brief Connections accepted since Start(). */
+        int GetConnectionCount() const;
+
+        /** @brief Response body bytes written, after compression. */
+        qint64 GetBytesSent() const;
+
+        /** @brief Requests that arrived with a compressed body. */
+        int GetCompressedRequestCount() const;
+
+    private:
+        class Private;
+        Private* d;
+};
+
+#endif // MOCKXAPISERVER_H
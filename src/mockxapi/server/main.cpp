@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QTimer>
+#include "mockxapi/mockxapidatabase.h"
+#include "mockxapi/mockxapiinventory.h"
+#include "mockxapi/mockxapiserver.h"
+
+namespace
+{
+    QByteArray readFile(const QString& path, QString* error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+            return QByteArray();
+        }
+        return file.readAll();
+    }
+
+    // method:kind[:skip[:count]] where kind is failure, disconnect, stall=<ms> or http=<status>
+    bool parseFault(const QString& spec, MockXapiFault* fault)
+    {
+        const QStringList parts = spec.split(':');
+        if (parts.size() < 2 || parts.size() > 4 || parts.at(0).isEmpty())
+            return false;
+
+        fault->method = parts.at(0);
+        const QString kind = parts.at(1).section('=', 0, 0);
+        const QString argument = parts.at(1).section('=', 1);
+        bool ok = true;
+        if (kind == "failure")
+        {
+            fault->kind = MockXapiFault::Kind::Failure;
+            if (!argument.isEmpty())
+                fault->errorDescription = argument.split(',');
+        } else if (kind == "disconnect")
+        {
+            fault->kind = MockXapiFault::Kind::Disconnect;
+        } else if (kind == "stall")
+        {
+            fault->kind = MockXapiFault::Kind::Stall;
+            fault->stallMs = argument.toInt(&ok);
+        } else if (kind == "http")
+        {
+            fault->kind = MockXapiFault::Kind::HttpError;
+            fault->httpStatus = argument.toInt(&ok);
+        } else
+        {
+            return false;
+        }
+
+        if (ok && parts.size() > 2)
+            fault->skip = parts.at(2).toInt(&ok);
+        if (ok && parts.size() > 3)
+            fault->count = parts.at(3).toInt(&ok);
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mockxapi-server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mock xapi server for load and regression testing");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption("port", "Port to listen on (default 4443).", "port", "4443");
+    QCommandLineOption listenOption("listen", "Address to listen on (default 127.0.0.1).", "address", "127.0.0.1");
+    QCommandLineOption noTlsOption("no-tls", "Serve plain HTTP.");
+    QCommandLineOption compressOption("compress", "Gzip or deflate responses for clients that accept it.");
+    QCommandLineOption certOption("cert", "PEM certificate instead of the built-in one.", "file");
+    QCommandLineOption keyOption("key", "PEM private key for --cert.", "file");
+    QCommandLineOption userOption("username", "Required login user name.", "name");
+    QCommandLineOption passwordOption("password", "Required login password.", "password");
+    QCommandLineOption hostsOption("hosts", "Hosts in the pool (default 1).", "count", "1");
+    QCommandLineOption vmsOption("vms-per-host", "VMs per host (default 10).", "count", "10");
+    QCommandLineOption vdisOption("vdis-per-vm", "Disks per VM (default 1).", "count", "1");
+    QCommandLineOption networksOption("networks", "Networks in the pool (default 2).", "count", "2");
+    QCommandLineOption messagesOption("messages", "Alerts spread over VMs and hosts (default 0).", "count", "0");
+    QCommandLineOption foldersOption("folders", "Top-level folders the VMs are filed in (default 0).", "count", "0");
+    QCommandLineOption tagsOption("tags", "Distinct tags put on VMs (default 0).", "count", "0");
+    QCommandLineOption objectsOption("objects", "Size the pool for about this many objects, overriding the counts above.", "count");
+    QCommandLineOption seedOption("seed", "Inventory random seed (default 1).", "seed", "1");
+    QCommandLineOption dumpOption("dump", "Write the inventory as an event.from reply and exit.", "file");
+    QCommandLineOption latencyOption("latency", "Delay added to every request.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Random extra delay of up to this much.", "ms", "0");
+    QCommandLineOption taskOption("task-ms", "Time Async.* tasks stay pending.", "ms",
+                                  QString::number(MockXapiServer::DEFAULT_TASK_DURATION_MS));
+    QCommandLineOption scriptOption("script", "JSON event script to replay after start.", "file");
+    QCommandLineOption faultOption("fault", "Inject a fault: method:failure[=CODE,args]|disconnect|stall=ms|http=status[:skip[:count]]. "
+                                            "Repeatable; count -1 means always.", "spec");
+    QCommandLineOption churnOption("churn", "Random VM modifications per second.", "rate", "0");
+
+    parser.addOptions({portOption, listenOption, noTlsOption, compressOption, certOption, keyOption, userOption,
+                       passwordOption, hostsOption, vmsOption, vdisOption, networksOption, messagesOption, foldersOption,
+                       tagsOption, objectsOption, seedOption, dumpOption, latencyOption, jitterOption, taskOption,
+                       scriptOption, faultOption, churnOption});
+    parser.process(app);
+
+    QTextStream err(stderr);
+    MockXapiServer server;
+
+    MockXapiInventoryOptions inventory;
+    inventory.hosts = parser.value(hostsOption).toInt();
+    inventory.vmsPerHost = parser.value(vmsOption).toInt();
+    inventory.vdisPerVm = parser.value(vdisOption).toInt();
+    inventory.networks = parser.value(networksOption).toInt();
+    inventory.messages = parser.value(messagesOption).toInt();
+    inventory.folders = parser.value(foldersOption).toInt();
+    inventory.tags = parser.value(tagsOption).toInt();
+    inventory.seed = parser.value(seedOption).toUInt();
+    if (parser.isSet(objectsOption))
+        inventory = MockXapiInventory::OptionsForObjectCount(parser.value(objectsOption).toInt(), inventory.seed);
+    MockXapiInventory::Populate(*server.GetDatabase(), inventory);
+
+    if (parser.isSet(dumpOption))
+    {
+        QFile dump(parser.value(dumpOption));
+        if (!dump.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || dump.write(MockXapiInventory::ExportEventDump(*server.GetDatabase())) < 0)
+        {
+            err << "Cannot write " << dump.fileName() << ": " << dump.errorString() << "\n";
+            return 1;
+        }
+        QTextStream(stdout) << "Wrote " << server.GetDatabase()->GetTotalCount() << " objects to "
+                            << dump.fileName() << "\n";
+        return 0;
+    }
+
+    server.SetTlsEnabled(!parser.isSet(noTlsOption));
+    server.SetCompressionEnabled(parser.isSet(compressOption));
+    if (parser.isSet(certOption))
+    {
+        QString error;
+        const QByteArray cert = readFile(parser.value(certOption), &error);
+        const QByteArray key = error.isEmpty() ? readFile(parser.value(keyOption), &error) : QByteArray();
+        if (!error.isEmpty() || !server.SetCertificate(cert, key))
+        {
+            err << (error.isEmpty() ? "Invalid certificate or key" : error) << "\n";
+            return 1;
+        }
+    }
+
+    if (parser.isSet(userOption) || parser.isSet(passwordOption))
+        server.SetCredentials(parser.value(userOption), parser.value(passwordOption));
+
+    server.SetLatency(parser.value(latencyOption).toInt(), parser.value(jitterOption).toInt());
+    server.SetTaskDuration(parser.value(taskOption).toInt());
+
+    for (const QString& spec : parser.values(faultOption))
+    {
+        MockXapiFault fault;
+        if (!parseFault(spec, &fault))
+        {
+            err << "Invalid fault: " << spec << "\n";
+            return 1;
+        }
+        server.AddFault(fault);
+    }
+
+    if (parser.isSet(scriptOption))
+    {
+        QString error;
+        const QByteArray script = readFile(parser.value(scriptOption), &error);
+        if (!error.isEmpty() || !server.LoadEventScript(script, &error))
+        {
+            err << error << "\n";
+            return 1;
+        }
+    }
+
+    if (!server.Start(quint16(parser.value(portOption).toUInt()), QHostAddress(parser.value(listenOption))))
+    {
+        err << "Cannot start: " << server.GetError() << "\n";
+        return 1;
+    }
+
+    QTextStream(stdout) << "Serving " << server.GetDatabase()->GetTotalCount() << " objects on "
+                        << (server.IsTlsEnabled() ? "https" : "http") << "://" << parser.value(listenOption)
+                        << ":" << server.GetPort() << "/\n" << Qt::flush;
+
+    // Churn touches a random VM per tick so clients see a steady event stream
+    QTimer churn;
+    const int churnRate = parser.value(churnOption).toInt();
+    if (churnRate > 0)
+    {
+        const QStringList vms = server.GetDatabase()->GetRefs("vm");
+        churn.setInterval(qMax(1, 1000 / churnRate));
+        QObject::connect(&churn, &QTimer::timeout, [&server, vms]() {
+            if (vms.isEmpty())
+                return;
+            const QString ref = vms.at(QRandomGenerator::global()->bounded(vms.size()));
+            server.GetDatabase()->Modify("vm", ref, {{"name_description",
+                                         QString("Touched at %1").arg(QDateTime::currentMSecsSinceEpoch())}});
+        });
+        churn.start();
+    }
+
+    const int result = app.exec();
+    server.Stop();
+    return result;
+}
@@ -0,0 +1,16 @@
+TEMPLATE = app
+CONFIG += console warn_on c++17
+CONFIG -= app_bundle
+QT += core network
+QT -= gui
+TARGET = mockxapi-server
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+LIBS += -L../../../release/mockxapi -lmockxapi
+
+# The static mockxapi library needs zlib for compressed responses
+!contains(CONFIG, no_zlib): LIBS += -lz
@@ -144,13 +144,47 @@ void VNCGraphicsClient::Unpause()
 {
     // Matches C# UnPause() in IRemoteConsole
     this->m_helperIsPaused = false;
+
+    bool released = false;
+    {
+        QMutexLocker locker(&this->m_backBufferMutex);
+        if (this->m_backBuffer.isNull() && this->m_fbWidth > 0 && this->m_fbHeight > 0)
+        {
+            this->m_backBuffer = QImage(this->m_fbWidth, this->m_fbHeight, QImage::Format_RGB32);
+            this->m_backBuffer.fill(Qt::black);
+            this->m_backBufferInteresting = false;
+            released = true;
+        }
+    }
+
     if (this->m_connected && this->m_state == Normal)
     {
+        // The buffer was dropped while paused, so ask for the whole screen again
+        if (released)
+            sendFramebufferUpdateRequest(false);
         this->m_updateTimer->start();
     }
     this->update();
 }
 
+qint64 VNCGraphicsClient::BackBufferBytes()
+{
+    QMutexLocker locker(&this->m_backBufferMutex);
+    return this->m_backBuffer.sizeInBytes();
+}
+
+qint64 VNCGraphicsClient::ReleaseBackBuffer()
+{
+    if (!this->m_helperIsPaused)
+        return 0;
+
+    QMutexLocker locker(&this->m_backBufferMutex);
+    const qint64 bytes = this->m_backBuffer.sizeInBytes();
+    this->m_backBuffer = QImage();
+    this->m_backBufferInteresting = false;
+    return bytes;
+}
+
 void VNCGraphicsClient::SendCAD()
 {
     // Matches C# SendCAD() method
@@ -881,6 +915,16 @@ bool VNCGraphicsClient::handleFramebufferUpdate()
     // All data is available! Now consume and process atomically
     // qDebug() << "VNCGraphicsClient: All data available, consuming" << offset << "bytes";
 
+    // Updates still in flight can arrive after a paused console dropped its buffer
+    {
+        QMutexLocker locker(&this->m_backBufferMutex);
+        if (this->m_backBuffer.isNull())
+        {
+            this->m_backBuffer = QImage(this->m_fbWidth, this->m_fbHeight, QImage::Format_RGB32);
+            this->m_backBuffer.fill(Qt::black);
+        }
+    }
+
     // Reset offset and consume header
     offset = 0;
     readU8(); // Message type
@@ -101,6 +101,15 @@ class VNCGraphicsClient : public QWidget, public IRemoteConsole
         {
             return m_terminated;
         }
+        bool IsPaused() const
+        {
+            return m_helperIsPaused;
+        }
+
+        // Back buffer memory, for MemoryAccountant
+        qint64 BackBufferBytes();
+        // Drop the back buffer of a paused console; Unpause() rebuilds it with a full update
+        qint64 ReleaseBackBuffer();
 
         // Source mode (text console)
         void SetUseSource(bool value)
@@ -1197,60 +1197,38 @@ void VNCTabView::registerEventListeners()
     XenCache* cache = this->m_vm->GetCache();
 
     // C#: source.PropertyChanged += Server_PropertyChanged;
-    // Qt: Connect to cache objectChanged signal for this VM
-    connect(cache, &XenCache::objectChanged, this, [this](QSharedPointer<XenObject> object)
+    // Subscriptions are delivered after the cache update has finished, so the
+    // handlers are free to query the cache directly
+    cache->Subscribe(this, XenObjectType::VM, this->m_vm->OpaqueRef(), [this](const QList<XenCacheChange>&)
     {
-        if (object == this->m_vm)
-        {
-            // Check what changed and update UI accordingly
-            // C#: Server_PropertyChanged checks specific properties
-            this->updatePowerState();
-            // TODO: Check other properties like allowed_operations, is_control_domain, etc.
-        }
-    });
+        // C#: Server_PropertyChanged checks specific properties
+        this->updatePowerState();
+    }, QStringList{ "power_state", "resident_on", "is_control_domain" });
 
     // C#: guestMetrics.PropertyChanged += guestMetrics_PropertyChanged;
-    // Use deferred update to avoid infinite loop (don't call cache queries inside cache callbacks)
     QString guestMetricsRef = this->m_vm->GetGuestMetricsRef();
     if (!guestMetricsRef.isEmpty() && guestMetricsRef != XENOBJECT_NULL)
     {
-        connect(cache, &XenCache::objectChanged, this, [this, guestMetricsRef](QSharedPointer<XenObject> object)
+        cache->Subscribe(this, XenObjectType::VMGuestMetrics, guestMetricsRef, [this](const QList<XenCacheChange>&)
         {
-            if (object && object->GetObjectType() == XenObjectType::VMGuestMetrics && object->OpaqueRef() == guestMetricsRef)
-            {
-                // Guest metrics changed - update RDP/SSH availability
-                // C#: guestMetrics_PropertyChanged updates RDP button state
-                qDebug() << "VNCTabView: Guest metrics changed for" << this->m_vm->OpaqueRef();
-
-                // Defer update to next event loop iteration to avoid calling cache queries
-                // inside cache update callback (which causes infinite loops)
-                QTimer::singleShot(0, this, [this]()
-                {
-                    // Update RDP availability based on new guest metrics
-                    // Reference: C# VNCTabView.cs lines 565-580
-                    // Check if RDP became available and auto-switch if enabled
-                    onDetectRDP();
-                });
-            }
+            // Guest metrics changed - update RDP/SSH availability
+            // Reference: C# VNCTabView.cs lines 565-580
+            qDebug() << "VNCTabView: Guest metrics changed for" << this->m_vm->OpaqueRef();
+            this->onDetectRDP();
         });
     }
 
     // C#: For control domain, register host property changes
-    // CRITICAL: Check isControlDomainZero() ONCE before creating connection, not inside lambda!
-    // Otherwise it triggers API calls on every cache update → infinite loop
+    // Check isControlDomainZero() once here rather than on every change
     QString hostRef = this->m_vm->GetResidentOnRef();
     bool isControlDomain = this->m_vm->IsControlDomain();
     if (isControlDomain && !hostRef.isEmpty())
     {
         qDebug() << "VNCTabView: Registering host property listener for control domain on" << hostRef;
-        connect(cache, &XenCache::objectChanged, this, [this, hostRef](QSharedPointer<XenObject> object)
+        cache->Subscribe(this, XenObjectType::Host, hostRef, [this](const QList<XenCacheChange>&)
         {
-            if (object && object->GetObjectType() == XenObjectType::Host && object->OpaqueRef() == hostRef)
-            {
-                // Host changed - update power state
-                this->updatePowerState();
-            }
-        });
+            this->updatePowerState();
+        }, QStringList{ "metrics" });
 
         // C#: Also register host_metrics property changes
         QSharedPointer<Host> host = cache->ResolveObject<Host>(hostRef);
@@ -1258,32 +1236,23 @@ void VNCTabView::registerEventListeners()
         if (!hostMetricsRef.isEmpty() && hostMetricsRef != XENOBJECT_NULL)
         {
             qDebug() << "VNCTabView: Registering host_metrics listener for" << hostMetricsRef;
-            connect(cache, &XenCache::objectChanged, this, [this, hostMetricsRef](QSharedPointer<XenObject> object)
+            cache->Subscribe(this, XenObjectType::HostMetrics, hostMetricsRef, [this](const QList<XenCacheChange>&)
             {
-                if (object && object->GetObjectType() == XenObjectType::HostMetrics && object->OpaqueRef() == hostMetricsRef)
-                {
-                    // Host metrics changed - update power state (check 'live' field)
-                    this->updatePowerState();
-                }
-            });
+                this->updatePowerState();
+            }, QStringList{ "live" });
         }
     }
 
     // C#: For SR driver domain, register SR property changes
-    // Use deferred update to avoid infinite loop (isSRDriverDomain() triggers cache queries)
     QString srRef;
     bool isSRDriver = isSRDriverDomain(this->m_vm, &srRef);
     if (isSRDriver && !srRef.isEmpty())
     {
         qDebug() << "VNCTabView: Registering SR property listener for SR driver domain on" << srRef;
-        connect(cache, &XenCache::objectChanged, this, [this, srRef](QSharedPointer<XenObject> object)
+        cache->Subscribe(this, XenObjectType::SR, srRef, [this](const QList<XenCacheChange>&)
         {
-            if (object && object->GetObjectType() == XenObjectType::SR && object->OpaqueRef() == srRef)
-            {
-                // SR changed - may need to update labels
-                // Defer update to avoid calling cache queries inside cache callback
-                QTimer::singleShot(0, this, [this]() { this->updatePowerState(); });
-            }
+            // SR changed - may need to update labels
+            this->updatePowerState();
         });
     }
 
@@ -1315,8 +1284,8 @@ void VNCTabView::unregisterEventListeners()
     // C#: Connection.Cache.DeregisterCollectionChanged<VM>(...)
     // C#: Connection.Cache.DeregisterCollectionChanged<Host>(...)
 
-    // Qt: Disconnect all signals from cache to this object
-    // This disconnects ALL connections from cache to this VNCTabView instance
+    // Qt: Drop the cache subscriptions and any remaining signal connections
+    cache->Unsubscribe(this);
     disconnect(cache, 0, this, 0);
 
     qDebug() << "VNCTabView: Event listeners unregistered for" << this->m_vm->OpaqueRef();
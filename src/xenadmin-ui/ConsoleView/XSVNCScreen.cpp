@@ -43,6 +43,7 @@
 #include "xenlib/xen/session.h"
 #include "xenlib/xen/vif.h"
 #include "xenlib/xencache.h"
+#include "xenlib/utils/memoryaccountant.h"
 #include "xenlib/xen/vm.h"
 #include "xenlib/xen/host.h"
 #include "xenlib/xen/network.h"
@@ -91,6 +92,25 @@ XSVNCScreen::XSVNCScreen(const QString& sourceRef, VNCTabView* parent, XenConnec
     // Initialize console control (VNC or RDP client)
     this->initSubControl();
 
+    if (this->_connection)
+    {
+        MemoryAccountant::instance()->Register(this->_connection, MemoryAccountant::CONSOLE_BUFFERS, this,
+            [this]()
+            {
+                MemoryAccountant::Size size;
+                if (this->_vncClient)
+                {
+                    size.bytes = this->_vncClient->BackBufferBytes();
+                    size.evictable = this->_vncClient->IsPaused() ? size.bytes : 0;
+                }
+                return size;
+            },
+            [this](qint64)
+            {
+                return this->_vncClient ? this->_vncClient->ReleaseBackBuffer() : 0;
+            });
+    }
+
     // Register event listeners for VM/metrics changes
     if (!this->_sourceRef.isEmpty())
     {
@@ -32,6 +32,7 @@
 #include "xenlib/xen/host.h"
 #include "xenlib/xen/vm.h"
 #include "xenlib/xencache.h"
+#include "xenlib/utils/memoryaccountant.h"
 #include <QEventLoop>
 #include <QMetaObject>
 #include <QNetworkAccessManager>
@@ -397,6 +398,22 @@ namespace CustomDataGraph
 
         this->m_timer->setInterval(5000);
         connect(this->m_timer, &QTimer::timeout, this, &ArchiveMaintainer::onSampleTick);
+
+        if (this->m_connection)
+        {
+            MemoryAccountant::instance()->Register(this->m_connection, MemoryAccountant::GRAPH_ARCHIVES, this,
+                [this]()
+                {
+                    MemoryAccountant::Size size;
+                    size.bytes = this->MemoryUsage();
+                    size.evictable = this->m_running ? 0 : size.bytes;
+                    return size;
+                },
+                [this](qint64)
+                {
+                    return this->ReleaseArchives();
+                });
+        }
     }
 
     ArchiveMaintainer::~ArchiveMaintainer()
@@ -430,6 +447,37 @@ namespace CustomDataGraph
         this->m_timer->stop();
     }
 
+    qint64 ArchiveMaintainer::MemoryUsage() const
+    {
+        // QMap node overhead plus key, set and point storage
+        const qint64 nodeOverhead = 32;
+
+        qint64 bytes = 0;
+        for (auto it = this->m_archives.constBegin(); it != this->m_archives.constEnd(); ++it)
+        {
+            const DataArchive& archive = it.value();
+            const QList<QString> keys = archive.Keys();
+            for (const QString& key : keys)
+            {
+                bytes += nodeOverhead + qint64(sizeof(QString) + sizeof(DataSet)) + key.capacity() * qint64(sizeof(QChar));
+                if (const DataSet* set = archive.Find(key))
+                    bytes += set->Points().capacity() * qint64(sizeof(DataPoint));
+            }
+        }
+        return bytes;
+    }
+
+    qint64 ArchiveMaintainer::ReleaseArchives()
+    {
+        if (this->m_running)
+            return 0;
+
+        const qint64 bytes = this->MemoryUsage();
+        for (auto it = this->m_archives.begin(); it != this->m_archives.end(); ++it)
+            it.value().ClearSets();
+        return bytes;
+    }
+
     void ArchiveMaintainer::SetDataSourceIds(const QStringList& dataSourceIds)
     {
         this->m_dataSourceIds = dataSourceIds;
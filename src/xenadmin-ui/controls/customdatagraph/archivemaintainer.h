@@ -65,6 +65,11 @@ namespace CustomDataGraph
             DataSet GetDataSet(const QString& dataSourceId, ArchiveInterval interval) const;
             const DataSet* TryGetDataSet(const QString& dataSourceId, ArchiveInterval interval) const;
 
+            //! Approximate heap held by the archives
+            qint64 MemoryUsage() const;
+            //! Drop all archived points while stopped (Start() reloads them); returns bytes freed
+            qint64 ReleaseArchives();
+
             static constexpr qint64 TICKS_IN_ONE_SECOND = 10000000LL;
             static constexpr qint64 TICKS_IN_FIVE_SECONDS = 50000000LL;
             static constexpr qint64 TICKS_IN_ONE_MINUTE = 600000000LL;
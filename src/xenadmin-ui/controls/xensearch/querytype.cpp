@@ -653,28 +653,9 @@ TagQueryType::~TagQueryType()
 void TagQueryType::populateCollectedTags()
 {
     // C# equivalent: Tags.GetAllTags()
-    // Collects all unique tags from all connections
-    
-    this->collectedTags_.clear();
-    QSet<QString> uniqueTags;
-    
-    // TODO: When ConnectionsManager is implemented, iterate through all connections
-    // For now, this is a placeholder that will be populated by cache updates
-    
-    // C# logic:
-    // foreach (IXenConnection connection in ConnectionsManager.XenConnectionsCopy)
-    // {
-    //     foreach (IXenObject o in connection.Cache.XenSearchableObjects)
-    //     {
-    //         String[] tags = Tags.GetTags(o);
-    //         if (tags != null)
-    //             foreach (string tag in tags)
-    //                 uniqueTags.insert(tag);
-    //     }
-    // }
-    
-    this->collectedTags_ = uniqueTags.values();
-    std::sort(this->collectedTags_.begin(), this->collectedTags_.end());
+    // The watcher keeps a reference-counted index of tags on all connections,
+    // already sorted and de-duplicated
+    this->collectedTags_ = OtherConfigAndTagsWatcher::instance()->GetAllTags();
 }
 
 void TagQueryType::onTagsChanged()
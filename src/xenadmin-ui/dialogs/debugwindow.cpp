@@ -28,6 +28,10 @@
 #include "debugwindow.h"
 #include "ui_debugwindow.h"
 #include "../settingsmanager.h"
+#include "xenlib/xen/network/rpctracer.h"
+#include "xenlib/xen/network/connection.h"
+#include "xenlib/utils/memoryaccountant.h"
+#include "xenlib/utils/misc.h"
 #include <QApplication>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -38,6 +42,7 @@
 #include <QFileInfo>
 #include <QTextEdit>
 #include <QPushButton>
+#include <QCheckBox>
 #include <QShortcut>
 #include <QKeySequence>
 
@@ -61,6 +66,7 @@ DebugWindow::DebugWindow(QWidget* parent) : QDialog(parent), ui(new Ui::DebugWin
     this->m_logFontSize = qBound(6, SettingsManager::instance().GetDebugConsoleFontSize(), 32);
     this->setupFontControls();
     this->applyLogFontSize(this->m_logFontSize);
+    this->setupTraceControls();
 
     // Connect the signal to append messages (for thread safety)
     connect(this, &DebugWindow::messageReceived, this, &DebugWindow::appendMessage, Qt::QueuedConnection);
@@ -201,6 +207,15 @@ void DebugWindow::setupFontControls()
     }
 }
 
+void DebugWindow::setupTraceControls()
+{
+    this->ui->rpcTraceCheckBox->setChecked(RpcTracer::IsEnabled());
+    connect(this->ui->rpcTraceCheckBox, &QCheckBox::toggled, this, &DebugWindow::setRpcTracing);
+    connect(this->ui->rpcStatsButton, &QPushButton::clicked, this, &DebugWindow::showRpcStats);
+    connect(this->ui->memoryButton, &QPushButton::clicked, this, &DebugWindow::showMemoryUsage);
+    connect(this->ui->exportTraceButton, &QPushButton::clicked, this, &DebugWindow::exportRpcTrace);
+}
+
 void DebugWindow::applyLogFontSize(int pointSize)
 {
     this->m_logFontSize = qBound(6, pointSize, 32);
@@ -299,3 +314,95 @@ void DebugWindow::decreaseFontSize()
 {
     this->applyLogFontSize(this->m_logFontSize - 1);
 }
+
+void DebugWindow::setRpcTracing(bool enabled)
+{
+    RpcTracer::SetEnabled(enabled);
+}
+
+void DebugWindow::showRpcStats()
+{
+    const QList<RpcLatencySummary> summaries = RpcTracer::GetSummaries();
+    if (summaries.isEmpty())
+    {
+        this->appendMessage(RpcTracer::IsEnabled() ? "No API calls traced yet"
+                                                   : "API call tracing is off; tick \"Trace API calls\" first");
+        return;
+    }
+
+    // Milliseconds with one decimal; slowest methods by total time first
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+                 .arg("method", -40).arg("calls", 7).arg("p50", 9).arg("p90", 9).arg("p99", 9)
+                 .arg("max", 9).arg("queue", 9).arg("server", 9).arg("parse", 9).arg("total", 11);
+    for (const RpcLatencySummary& summary : summaries)
+    {
+        lines << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+                     .arg(summary.method, -40).arg(summary.count, 7)
+                     .arg(ms(summary.p50Us), 9).arg(ms(summary.p90Us), 9).arg(ms(summary.p99Us), 9)
+                     .arg(ms(summary.maxUs), 9).arg(ms(summary.meanQueueUs), 9).arg(ms(summary.meanServerUs), 9)
+                     .arg(ms(summary.meanParseUs), 9).arg(ms(summary.totalUs), 11);
+    }
+    const QString table = "<pre>" + lines.join("\n").toHtmlEscaped() + "</pre>";
+    this->appendMessage(table);
+}
+
+void DebugWindow::showMemoryUsage()
+{
+    MemoryAccountant* memory = MemoryAccountant::instance();
+    const QList<XenConnection*> connections = memory->GetConnections();
+    if (connections.isEmpty())
+    {
+        this->appendMessage("No connections hold accounted memory");
+        return;
+    }
+
+    for (XenConnection* connection : connections)
+    {
+        QStringList lines;
+        lines << QString("%1 %2 %3 %4 %5")
+                     .arg(connection->GetHostname(), -20).arg("size", 12).arg("evictable", 12).arg("budget", 12).arg("owners", 7);
+        qint64 total = 0;
+        for (const MemoryAccountant::Usage& usage : memory->GetUsage(connection))
+        {
+            lines << QString("%1 %2 %3 %4 %5")
+                         .arg(usage.subsystem, -20).arg(Misc::FormatSize(usage.bytes), 12)
+                         .arg(Misc::FormatSize(usage.evictable), 12)
+                         .arg(usage.budget > 0 ? Misc::FormatSize(usage.budget) : QString("-"), 12)
+                         .arg(usage.providers, 7);
+            total += usage.bytes;
+        }
+        lines << QString("%1 %2").arg("total", -20).arg(Misc::FormatSize(total), 12);
+        this->appendMessage("<pre>" + lines.join("\n").toHtmlEscaped() + "</pre>");
+    }
+}
+
+void DebugWindow::exportRpcTrace()
+{
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+    QString defaultFileName = QString("xenadmin_trace_%1.json").arg(timestamp);
+
+    QString fileName = QFileDialog::getSaveFileName(
+        this,
+        "Export API Trace",
+        QDir(defaultPath).filePath(defaultFileName),
+        "Chrome trace files (*.json);;All files (*)");
+
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    QString error;
+    if (RpcTracer::ExportChromeTrace(fileName, &error))
+    {
+        QMessageBox::information(this, "Trace Exported",
+                                 QString("%1 API calls saved to:\n%2\n\nOpen it in chrome://tracing or ui.perfetto.dev.")
+                                     .arg(RpcTracer::GetEvents().size()).arg(fileName));
+    } else
+    {
+        QMessageBox::warning(this, "Export Failed", error);
+    }
+}
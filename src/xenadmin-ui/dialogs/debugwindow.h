@@ -64,6 +64,10 @@ class DebugWindow : public QDialog
         void setLogLevel(int level);
         void increaseFontSize();
         void decreaseFontSize();
+        void setRpcTracing(bool enabled);
+        void showRpcStats();
+        void showMemoryUsage();
+        void exportRpcTrace();
 
     signals:
         void messageReceived(const QString& message);
@@ -76,6 +80,7 @@ class DebugWindow : public QDialog
 
         QString formatMessage(QtMsgType type, const QMessageLogContext& context, const QString& msg);
         void setupFontControls();
+        void setupTraceControls();
         void applyLogFontSize(int pointSize);
 
         Ui::DebugWindow* ui;
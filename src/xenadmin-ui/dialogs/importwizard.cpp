@@ -39,6 +39,7 @@
 #include "xenlib/xen/vm.h"
 #include "xenlib/xen/vif.h"
 #include "xenlib/xen/session.h"
+#include "xenlib/diskimage/diskimagereader.h"
 #include "xenlib/utils/decompressgzaction.h"
 #include "xenlib/utils/downloadfileaction.h"
 #include "xenlib/xen/actions/sr/srrefreshaction.h"
@@ -52,6 +53,7 @@
 #include <QSet>
 #include <QStandardPaths>
 #include <QUrl>
+#include <memory>
 
 ImportWizard::ImportWizard(QWidget* parent)
     : ImportWizard(nullptr, parent)
@@ -1371,36 +1373,19 @@ bool ImportWizard::inspectDiskImage(const QString& filePath)
         }
     }
 
-    // VMDK: sparse extent has a 4-byte little-endian magic 0x564D444B at offset 0.
-    // Capacity is a uint64 at offset 8 in the header (sector count; multiply by 512 for bytes).
-    if (f.seek(0))
-    {
-        const QByteArray header = f.read(16);
-        if (header.size() >= 16)
-        {
-            const quint32 magic =
-                static_cast<quint32>(static_cast<quint8>(header.at(0)))        |
-                (static_cast<quint32>(static_cast<quint8>(header.at(1))) << 8)  |
-                (static_cast<quint32>(static_cast<quint8>(header.at(2))) << 16) |
-                (static_cast<quint32>(static_cast<quint8>(header.at(3))) << 24);
+    f.close();
 
-            if (magic == 0x564D444B) // "KDMV" little-endian
-            {
-                quint64 sectors = 0;
-                for (int i = 0; i < 8; i++)
-                    sectors |= (static_cast<quint64>(static_cast<quint8>(header.at(8 + i))) << (8 * i));
-                if (sectors > 0)
-                {
-                    this->m_diskImageCapacityBytes = static_cast<qint64>(sectors) * 512;
-                    this->m_diskImageFormatName = "VMDK";
-                    f.close();
-                    return true;
-                }
-            }
-        }
+    // VMDK (sparse, stream-optimized or a descriptor) and qcow2: the image
+    // readers already parse these headers, so ask them for the capacity.
+    QString readerError;
+    std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(filePath, 0, -1, readerError));
+    if (reader && reader->FormatName() != QLatin1String("raw") && reader->VirtualSize() > 0)
+    {
+        this->m_diskImageCapacityBytes = reader->VirtualSize();
+        this->m_diskImageFormatName = reader->FormatName().toUpper();
+        return true;
     }
 
-    f.close();
     return false;
 }
 
@@ -1515,14 +1500,6 @@ bool ImportWizard::validateCurrentPage()
             return false;
         }
 
-        if (this->m_importType == ImportType_VHD && filePath.endsWith(".vmdk", Qt::CaseInsensitive))
-        {
-            QMessageBox::warning(this, tr("Unsupported Disk Image"),
-                                 tr("VMDK disk-image import is not supported yet. "
-                                    "Convert the disk to VHD and import the VHD file."));
-            return false;
-        }
-
         this->m_sourceFilePath = filePath;
         SettingsManager::instance().SetDefaultImportPath(QFileInfo(filePath).absolutePath());
 
@@ -1932,6 +1909,21 @@ QString ImportWizard::detectImportType(const QString& filePath)
 
     // ── Map content to import type ────────────────────────────────────────
 
+    // qcow2: "QFI\xfb" magic. Checked first: its header would also pass the
+    // old-format TAR heuristic below.
+    if (header.startsWith("QFI\xfb"))
+    {
+        this->m_importType = ImportType_VHD;
+        return tr("QEMU Copy-On-Write Disk (qcow2)");
+    }
+
+    // VMDK text descriptor pointing at a sparse or flat extent
+    if (header.contains("# Disk DescriptorFile"))
+    {
+        this->m_importType = ImportType_VHD;
+        return tr("Virtual Machine Disk (VMDK)");
+    }
+
     // XVA.GZ: gzip-compressed TAR (the GZ wraps a TAR)
     if (isGzip && (lower.endsWith(".xva.gz") || lower.endsWith(".xva")))
     {
@@ -1988,7 +1980,7 @@ QString ImportWizard::detectImportType(const QString& filePath)
         static_cast<unsigned char>(header[3]) == 0x56)
     {
         this->m_importType = ImportType_VHD;
-        return tr("Virtual Hard Disk (VMDK)");
+        return tr("Virtual Machine Disk (VMDK)");
     }
 
     // ── Extension-only fallback (file too small / empty / no content read) ────
@@ -2002,10 +1994,10 @@ QString ImportWizard::detectImportType(const QString& filePath)
         this->m_importType = ImportType_OVF;
         return tr("Open Virtualization Format (OVF/OVA)");
     }
-    if (lower.endsWith(".vhd") || lower.endsWith(".vmdk"))
+    if (lower.endsWith(".vhd") || lower.endsWith(".vmdk") || lower.endsWith(".qcow2"))
     {
         this->m_importType = ImportType_VHD;
-        return tr("Virtual Hard Disk (VHD/VMDK)");
+        return tr("Disk Image (VHD/VMDK/qcow2)");
     }
 
     return QString(); // Unsupported type
@@ -2052,10 +2044,10 @@ void ImportWizard::onBrowseClicked()
     }
     else
     {
-        filter = tr("All Supported Files (*.xva *.xva.gz *.ovf *.ova *.ova.gz *.vhd);;"
+        filter = tr("All Supported Files (*.xva *.xva.gz *.ovf *.ova *.ova.gz *.vhd *.vmdk *.qcow2);;"
                     "XVA Files (*.xva *.xva.gz);;"
                     "OVF/OVA Files (*.ovf *.ova *.ova.gz);;"
-                    "VHD Files (*.vhd);;"
+                    "Disk Images (*.vhd *.vmdk *.qcow2);;"
                     "All Files (*)");
     }
 
@@ -31,6 +31,8 @@
 #include "xen/network/connection.h"
 #include "xen/session.h"
 #include "xencache.h"
+#include "utils/memoryaccountant.h"
+#include "utils/misc.h"
 #include <QTreeWidgetItem>
 #include <QHeaderView>
 #include <QDebug>
@@ -271,6 +273,21 @@ void XenCacheExplorer::displayConnectionInfo(XenConnection* connection)
 
     for (const auto& entry : info)
         this->addPropertyItem(nullptr, entry.first, entry.second, tr("Connection Info"));
+
+    qint64 totalBytes = 0;
+    const QList<MemoryAccountant::Usage> usage = MemoryAccountant::instance()->GetUsage(connection);
+    for (const MemoryAccountant::Usage& entry : usage)
+    {
+        QString value = Misc::FormatSize(entry.bytes);
+        if (entry.evictable > 0)
+            value += tr(" (%1 evictable)").arg(Misc::FormatSize(entry.evictable));
+        if (entry.budget > 0)
+            value += tr(", budget %1").arg(Misc::FormatSize(entry.budget));
+        this->addPropertyItem(nullptr, entry.subsystem, value, tr("Memory"));
+        totalBytes += entry.bytes;
+    }
+    if (!usage.isEmpty())
+        this->addPropertyItem(nullptr, tr("Total Memory"), Misc::FormatSize(totalBytes), tr("Memory"));
 }
 
 void XenCacheExplorer::displayCategoryInfo(XenConnection* connection, const QString& type)
@@ -28,6 +28,7 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QDebug>
 #include <QTextStream>
 #include <QTimer>
 #include "globals.h"
@@ -37,9 +38,13 @@
 #include "xenlib/customfields/customfieldsmanager.h"
 #include "xenlib/folders/foldersmanager.h"
 #include "xenlib/xenlib.h"
+#include "xenlib/xen/network/wirerecorder.h"
+#include "xenlib/xen/network/wirereplay.h"
+#include "xenlib/xen/network/rpctracer.h"
 
 int main(int argc, char* argv[])
 {
+    QString rpcTracePath;
     {
         QCoreApplication coreApp(argc, argv);
         QCoreApplication::setApplicationName(XENADMIN_BRANDING_APP_NAME);
@@ -51,8 +56,16 @@ int main(int argc, char* argv[])
 
         QCommandLineOption confOption(QStringList() << "c" << "conf", "Use alternative configuration directory path.", "path");
         QCommandLineOption versionOption(QStringList() << "V" << "version", "Print version and exit.");
+        QCommandLineOption recordOption("record-wire", "Record xapi traffic, with credentials redacted, to a file.", "path");
+        QCommandLineOption replayOption("replay-wire", "Answer every connection from a recording instead of the network.", "path");
+        QCommandLineOption replaySpeedOption("replay-speed", "Replay speed factor, 0 for no delays (default 1).", "factor", "1");
+        QCommandLineOption traceRpcOption("trace-rpc", "Trace API call latency from startup and save it as Chrome trace JSON on exit.", "path");
         parser.addOption(confOption);
         parser.addOption(versionOption);
+        parser.addOption(recordOption);
+        parser.addOption(replayOption);
+        parser.addOption(replaySpeedOption);
+        parser.addOption(traceRpcOption);
         parser.addHelpOption();
 
         parser.process(coreApp);
@@ -67,6 +80,33 @@ int main(int argc, char* argv[])
         {
             SettingsManager::SetConfigDir(parser.value(confOption));
         }
+
+        if (parser.isSet(replayOption))
+        {
+            QSharedPointer<WireReplay> replay(new WireReplay());
+            QString error;
+            if (!replay->Load(parser.value(replayOption), &error))
+            {
+                QTextStream(stderr) << error << "\n";
+                return 1;
+            }
+            replay->SetSpeed(parser.value(replaySpeedOption).toDouble());
+            WireReplay::Install(replay);
+        } else if (parser.isSet(recordOption))
+        {
+            QString error;
+            if (!WireRecorder::Start(parser.value(recordOption), &error))
+            {
+                QTextStream(stderr) << error << "\n";
+                return 1;
+            }
+        }
+
+        if (parser.isSet(traceRpcOption))
+        {
+            rpcTracePath = parser.value(traceRpcOption);
+            RpcTracer::SetEnabled(true);
+        }
     }
 
     QApplication app(argc, argv);
@@ -82,10 +122,15 @@ int main(int argc, char* argv[])
     OtherConfigAndTagsWatcher::instance()->RegisterEventHandlers();
     FoldersManager::instance()->RegisterEventHandlers();
     (void)CustomFieldsManager::instance();
-    QObject::connect(&app, &QCoreApplication::aboutToQuit, []()
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, [rpcTracePath]()
     {
         FoldersManager::instance()->DeregisterEventHandlers();
         OtherConfigAndTagsWatcher::instance()->DeregisterEventHandlers();
+        WireRecorder::Stop();
+
+        QString error;
+        if (!rpcTracePath.isEmpty() && !RpcTracer::ExportChromeTrace(rpcTracePath, &error))
+            qWarning() << error;
     });
 
     MainWindow w;
@@ -75,8 +75,8 @@
 #include "tabpages/searchtabpage.h"
 #include "tabpages/alertsummarypage.h"
 #include "tabpages/eventspage.h"
-#include "alerts/alertmanager.h"
 #include "alerts/messagealert.h"
+#include "alerts/messagealertloader.h"
 #include "ConsoleView/ConsolePanel.h"
 #include "placeholderwidget.h"
 #include "settingsmanager.h"
@@ -89,13 +89,16 @@
 #include "xenlib/xen/vm.h"
 #include "xenlib/xen/network/certificatemanager.h"
 #include "xenlib/xencache.h"
+#include "xenlib/utils/memoryaccountant.h"
 #include "xenlib/xen/sr.h"
 #include "metricupdater.h"
 #include "xenlib/xensearch/search.h"
 #include "xenlib/xensearch/groupingtag.h"
 #include "xenlib/xensearch/grouping.h"
 #include "xenlib/xen/network/connection.h"
+#include "xenlib/xen/network/connectionworker.h"
 #include "xenlib/xen/network/connectionsmanager.h"
+#include "xenlib/xen/network/transferlimits.h"
 #include "operations/operationmanager.h"
 #include "xenlib/xen/actions/meddlingaction.h"
 #include "commands/contextmenubuilder.h"
@@ -407,6 +410,31 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
     // Load saved settings
     this->loadSettings();
 
+    // Soft per-connection budgets for data that can be rebuilt on demand
+    const qint64 megabyte = 1024 * 1024;
+    SettingsManager& settings = SettingsManager::instance();
+    MemoryAccountant::instance()->SetBudget(MemoryAccountant::GRAPH_ARCHIVES,
+                                            settings.GetValue("Memory/GraphArchiveBudgetMB", 32).toLongLong() * megabyte);
+    MemoryAccountant::instance()->SetBudget(MemoryAccountant::CONSOLE_BUFFERS,
+                                            settings.GetValue("Memory/ConsoleBufferBudgetMB", 64).toLongLong() * megabyte);
+
+    // Event classes subscribed on connect; "*" brings back subscribing to everything
+    const QStringList eventClasses = settings.GetValue("Connection/EventClasses").toStringList();
+    if (!eventClasses.isEmpty())
+        XenConnection::SetDefaultEventClasses(eventClasses);
+
+    // gzip/deflate replies are negotiated by default; compressed requests only
+    // help behind a proxy that accepts them, so they stay off unless configured
+    Xen::ConnectionWorker::SetResponseCompressionEnabled(settings.GetValue("Connection/CompressResponses", true).toBool());
+    Xen::ConnectionWorker::SetRequestCompressionThreshold(settings.GetValue("Connection/RequestCompressionThreshold", 0).toInt());
+
+    // Concurrent disk transfers and their combined rate (0 MB/s = unlimited)
+    TransferLimits::SetMaxTransfersPerConnection(
+        settings.GetValue("Transfers/MaxPerConnection", TransferLimits::DEFAULT_MAX_TRANSFERS_PER_CONNECTION).toInt());
+    TransferLimits::SetMaxTransfersPerHost(
+        settings.GetValue("Transfers/MaxPerHost", TransferLimits::DEFAULT_MAX_TRANSFERS_PER_HOST).toInt());
+    TransferLimits::SetBandwidthLimit(settings.GetValue("Transfers/BandwidthLimitMBps", 0).toLongLong() * megabyte);
+
     // Restore saved connections
     this->restoreConnections();
 }
@@ -673,7 +701,6 @@ void MainWindow::onConnectionAdded(XenConnection* connection)
     });
 
     connect(connection, &XenConnection::CachePopulated, this, &MainWindow::onCachePopulated);
-    connect(connection->GetCache(), &XenCache::objectChanged, this, &MainWindow::onCacheObjectChanged);
     connect(connection->GetCache(), &XenCache::objectRemoved, this, [this](QSharedPointer<XenObject> object)
     {
         if (object && object->GetObjectType() == XenObjectType::VM && !object->OpaqueRef().isEmpty())
@@ -715,6 +742,7 @@ void MainWindow::clearConnectionUIState(XenConnection* connection)
     if (currentObjectUsesConnection)
     {
         this->m_currentObject.clear();
+        this->watchCurrentObject();
         this->m_lastSelectedRef.clear();
         this->m_titleBar->Clear();
     }
@@ -797,6 +825,7 @@ void MainWindow::onTreeItemSelected()
     XenConnection *connection = nullptr;
     
     this->m_currentObject = itemData.value<QSharedPointer<XenObject>>();
+    this->watchCurrentObject();
     if (this->m_currentObject)
     {
         objectType = this->m_currentObject->GetObjectTypeName();
@@ -2331,44 +2360,52 @@ void MainWindow::updateConnectionProfileFromCache(XenConnection* connection, Xen
     SettingsManager::instance().Sync();
 }
 
-void MainWindow::onCacheObjectChanged(QSharedPointer<XenObject> object)
+void MainWindow::watchCurrentObject()
 {
-    if (!object)
+    if (this->m_currentObjectCache && this->m_currentObjectSubscription)
+        this->m_currentObjectCache->Unsubscribe(this->m_currentObjectSubscription);
+    this->m_currentObjectCache.clear();
+    this->m_currentObjectSubscription = 0;
+
+    if (!this->m_currentObject || !this->m_currentObject->GetConnection() || this->m_currentObject->OpaqueRef().isEmpty())
         return;
 
-    XenConnection* connection = object->GetConnection();
-    if (!connection)
+    // Only the displayed object matters here, so subscribe to it rather than
+    // filtering every objectChanged() of every connection
+    XenCache* cache = this->m_currentObject->GetCache();
+    this->m_currentObjectCache = cache;
+    this->m_currentObjectSubscription = cache->Subscribe(this, this->m_currentObject->GetObjectType(),
+                                                         this->m_currentObject->OpaqueRef(),
+                                                         [this](const QList<XenCacheChange>& changes)
+    {
+        if (!changes.isEmpty() && !changes.last().removed)
+            this->onCurrentObjectChanged();
+    });
+}
+
+void MainWindow::onCurrentObjectChanged()
+{
+    if (this->m_currentObject.isNull())
         return;
 
-    const XenObjectType changedType = object->GetObjectType();
-    const QString objectRef = object->OpaqueRef();
+    BaseTabPage* currentTab = qobject_cast<BaseTabPage*>(this->ui->mainTabWidget->currentWidget());
 
-    // If the changed object is the currently displayed one, refresh the tabs
-    if (!this->m_currentObject.isNull()
-        && connection == this->m_currentObject->GetConnection()
-        && changedType == this->m_currentObject->GetObjectType()
-        && objectRef == this->m_currentObject->OpaqueRef())
+    // Mark all tabs dirty, but immediately refresh only the visible tab.
+    for (int i = 0; i < this->ui->mainTabWidget->count(); ++i)
     {
-        BaseTabPage* currentTab = qobject_cast<BaseTabPage*>(this->ui->mainTabWidget->currentWidget());
-
-        // Mark all tabs dirty, but immediately refresh only the visible tab.
-        for (int i = 0; i < this->ui->mainTabWidget->count(); ++i)
-        {
-            BaseTabPage* tabPage = qobject_cast<BaseTabPage*>(this->ui->mainTabWidget->widget(i));
-            if (!tabPage)
-                continue;
+        BaseTabPage* tabPage = qobject_cast<BaseTabPage*>(this->ui->mainTabWidget->widget(i));
+        if (!tabPage)
+            continue;
 
-            tabPage->MarkDirty();
-            if (tabPage == currentTab)
-                tabPage->SetObject(this->m_currentObject);
-        }
-        this->updateToolbarsAndMenus();
+        tabPage->MarkDirty();
+        if (tabPage == currentTab)
+            tabPage->SetObject(this->m_currentObject);
     }
+    this->updateToolbarsAndMenus();
 }
 
 void MainWindow::onMessageReceived(const QString& messageRef, const QVariantMap& messageData)
 {
-    (void) messageRef;
     // C# Reference: MainWindow.cs line 1000 - Alert.AddAlert(MessageAlert.ParseMessage(m))
     // Create alert from XenAPI message and add to AlertManager
     
@@ -2394,11 +2431,10 @@ void MainWindow::onMessageReceived(const QString& messageRef, const QVariantMap&
     if (graphOnlyMessages.contains(messageType) || messageType == "HA_POOL_OVERCOMMITTED")
         return;
 
-    XenLib::Alert* alert = XenLib::MessageAlert::ParseMessage(connection, messageData);
-    if (alert)
-    {
-        XenLib::AlertManager::instance()->AddAlert(alert);
-    }
+    // Parsed off the GUI thread and added newest first, one page at a time;
+    // "mod" events for messages already known are dropped by the loader
+    Q_UNUSED(messageRef)
+    XenLib::MessageAlertLoader::instance()->Enqueue(connection, messageData);
 }
 
 void MainWindow::onMessageRemoved(const QString& messageRef)
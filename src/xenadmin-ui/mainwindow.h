@@ -31,6 +31,7 @@
 #include <QMainWindow>
 #include <QList>
 #include <QMap>
+#include <QPointer>
 
 #include "tabpages/basetabpage.h"
 #include "navigation/navigationpane.h"
@@ -147,8 +148,8 @@ class MainWindow : public QMainWindow
         void onViewShowHiddenObjectsToggled(bool checked);
         void onViewShowAllServerEventsToggled(bool checked);
 
-        // Cache update handler for refreshing selected object
-        void onCacheObjectChanged(QSharedPointer<XenObject> object);
+        // Cache subscription handler for refreshing selected object
+        void onCurrentObjectChanged();
 
         // XenAPI Message handlers for alert system (matches C# MainWindow.cs line 993 - MessageCollectionChanged)
         void onMessageReceived(const QString& messageRef, const QVariantMap& messageData);
@@ -286,6 +287,7 @@ class MainWindow : public QMainWindow
         void clearTabs();
         void updateTabPages(QSharedPointer<XenObject> xen_obj);
         void updatePlaceholderVisibility();
+        void watchCurrentObject();
 
         // Get correct tab order for object type (C# GetNewTabPages equivalent)
         QList<BaseTabPage*> getNewTabPages(QSharedPointer<XenObject> xen_obj) const;
@@ -360,6 +362,9 @@ class MainWindow : public QMainWindow
         AsyncOperation* m_statusBarAction; // Currently tracked action in status bar
 
         QSharedPointer<XenObject> m_currentObject;
+        // Cache subscription delivering changes of m_currentObject only
+        QPointer<XenCache> m_currentObjectCache;
+        int m_currentObjectSubscription = 0;
 
         // Selection deduplication - prevent multiple API calls for same selection
         QString m_lastSelectedRef;
@@ -56,16 +56,19 @@
 
 using namespace XenSearch;
 
-static bool isTypeRelevantForTree(XenObjectType type)
+static const QList<XenObjectType>& treeRelevantTypes()
 {
-    return type == XenObjectType::Pool ||
-           type == XenObjectType::Host ||
-           type == XenObjectType::VM ||
-           type == XenObjectType::SR ||
-           type == XenObjectType::VDI ||
-           type == XenObjectType::Network ||
-           type == XenObjectType::Folder ||
-           type == XenObjectType::VMAppliance;
+    static const QList<XenObjectType> types = {
+        XenObjectType::Pool,
+        XenObjectType::Host,
+        XenObjectType::VM,
+        XenObjectType::SR,
+        XenObjectType::VDI,
+        XenObjectType::Network,
+        XenObjectType::Folder,
+        XenObjectType::VMAppliance
+    };
+    return types;
 }
 
 NavigationView::NavigationView(QWidget* parent)  : QWidget(parent), ui(new Ui::NavigationView), m_refreshTimer(new QTimer(this)), m_typeGrouping(new TypeGrouping()) // Create TypeGrouping for Objects view
@@ -247,17 +250,6 @@ void NavigationView::SetSearchText(const QString& text)
     this->ui->searchLineEdit->setText(text);
 }
 
-void NavigationView::onCacheObjectChanged(XenConnection* connection, XenObjectType type, const QString& ref)
-{
-    Q_UNUSED(ref);
-    Q_UNUSED(connection);
-
-    if (isTypeRelevantForTree(type))
-    {
-        this->scheduleRefresh();
-    }
-}
-
 void NavigationView::scheduleRefresh()
 {
     // Debounce: restart timer on each call
@@ -292,15 +284,20 @@ void NavigationView::connectCacheSignals(XenConnection* connection)
     if (!cache)
         return;
 
-    if (!this->m_cacheChangedHandlers.contains(connection))
-    {
-        this->m_cacheChangedHandlers.insert(connection, connect(cache, &XenCache::itemChanged, this, &NavigationView::onCacheObjectChanged));
-    }
+    if (this->m_cacheSubscriptions.contains(connection))
+        return;
 
-    if (!this->m_cacheRemovedHandlers.contains(connection))
+    // Per-type subscriptions: changes to types the tree never shows (metrics,
+    // tasks, messages...) no longer reach the debounce timer at all
+    QList<int> subscriptions;
+    for (XenObjectType type : treeRelevantTypes())
     {
-        this->m_cacheRemovedHandlers.insert(connection, connect(cache, &XenCache::itemRemoved, this, &NavigationView::onCacheObjectChanged));
+        subscriptions.append(cache->Subscribe(this, type, [this](const QList<XenCacheChange>&)
+        {
+            this->scheduleRefresh();
+        }));
     }
+    this->m_cacheSubscriptions.insert(connection, subscriptions);
 }
 
 void NavigationView::disconnectCacheSignals(XenConnection* connection)
@@ -308,10 +305,12 @@ void NavigationView::disconnectCacheSignals(XenConnection* connection)
     if (!connection)
         return;
 
-    if (this->m_cacheChangedHandlers.contains(connection))
-        disconnect(this->m_cacheChangedHandlers.take(connection));
-    if (this->m_cacheRemovedHandlers.contains(connection))
-        disconnect(this->m_cacheRemovedHandlers.take(connection));
+    const QList<int> subscriptions = this->m_cacheSubscriptions.take(connection);
+    XenCache* cache = connection->GetCache();
+    if (!cache)
+        return;
+    for (int subscription : subscriptions)
+        cache->Unsubscribe(subscription);
 }
 
 XenConnection* NavigationView::primaryConnection() const
@@ -133,7 +133,6 @@ class NavigationView : public QWidget
 
     private slots:
         void onSearchTextChanged(const QString& text);
-        void onCacheObjectChanged(XenConnection *connection, XenObjectType type, const QString& ref);
         void onRefreshTimerTimeout();
         void onConnectionAdded(XenConnection* connection);
         void onConnectionRemoved(XenConnection* connection);
@@ -165,8 +164,7 @@ class NavigationView : public QWidget
         NavigationPane::NavigationMode m_navigationMode = NavigationPane::Infrastructure;
         ViewFilters m_viewFilters;
         QTimer* m_refreshTimer; // Debounce timer for cache updates
-        QHash<XenConnection*, QMetaObject::Connection> m_cacheChangedHandlers;
-        QHash<XenConnection*, QMetaObject::Connection> m_cacheRemovedHandlers;
+        QHash<XenConnection*, QList<int>> m_cacheSubscriptions;
 
         // Grouping instances for Objects view (matches C# OrganizationViewObjects)
         class TypeGrouping* m_typeGrouping;
@@ -33,8 +33,8 @@
 #include "xenlib/xen/actions/general/generaleditpageaction.h"
 #include "xenlib/xen/network/connection.h"
 #include "xenlib/xen/xenobject.h"
-#include "xenlib/xen/network/connectionsmanager.h"
 #include "xenlib/folders/foldersmanager.h"
+#include "xenlib/otherconfig/otherconfigandtagswatcher.h"
 #include "xenlib/xencache.h"
 #include <QHBoxLayout>
 #include <QIcon>
@@ -402,33 +402,7 @@ void GeneralEditPage::onEditTagsClicked()
 QStringList GeneralEditPage::collectAllKnownTags() const
 {
     QStringList allTags = this->m_currentTags;
-
-    const QList<XenConnection*> connections = Xen::ConnectionsManager::instance()->GetAllConnections();
-    for (XenConnection* connection : connections)
-    {
-        if (!connection || !connection->IsConnected() || !connection->GetCache())
-            continue;
-
-        const QList<QPair<XenObjectType, QString>> searchable = connection->GetCache()->GetXenSearchableObjects();
-        for (const auto& pair : searchable)
-        {
-            if (pair.first == XenObjectType::Folder)
-                continue;
-
-            const QSharedPointer<XenObject> candidate = connection->GetCache()->ResolveObject(pair.first, pair.second);
-            if (!candidate)
-                continue;
-
-            const QStringList tags = candidate->GetTags();
-            for (const QString& tag : tags)
-            {
-                const QString cleaned = tag.trimmed();
-                if (!cleaned.isEmpty())
-                    allTags.append(cleaned);
-            }
-        }
-    }
-
+    allTags.append(OtherConfigAndTagsWatcher::instance()->GetAllTags());
     allTags.removeDuplicates();
     allTags.sort();
     return allTags;
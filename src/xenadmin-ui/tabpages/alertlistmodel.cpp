@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "alertlistmodel.h"
+#include "xenlib/alerts/alertmanager.h"
+#include "xenlib/alerts/messagealertloader.h"
+#include <QIcon>
+#include <algorithm>
+
+using namespace XenLib;
+
+AlertListModel::AlertListModel(QObject* parent) : QAbstractTableModel(parent)
+{
+    AlertManager* manager = AlertManager::instance();
+    connect(manager, &AlertManager::alertsAdded, this, &AlertListModel::onAlertsAdded);
+    connect(manager, &AlertManager::alertsRemoved, this, &AlertListModel::onAlertsRemoved);
+    connect(manager, &AlertManager::alertsChanged, this, &AlertListModel::onAlertsChanged);
+}
+
+int AlertListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : this->m_alerts.size();
+}
+
+int AlertListModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant AlertListModel::data(const QModelIndex& index, int role) const
+{
+    Alert* alert = this->GetAlert(index.row());
+    if (!alert)
+        return QVariant();
+
+    if (role == AlertRole)
+        return QVariant::fromValue(alert);
+
+    switch (index.column())
+    {
+        case ExpanderColumn:
+            // C# Reference: GridViewAlerts expandedState dictionary
+            if (role == Qt::DecorationRole)
+                return QIcon(this->IsExpanded(alert) ? ":/images/expanded_triangle.png" : ":/images/contracted_triangle.png");
+            break;
+
+        case SeverityColumn:
+            if (role == Qt::DisplayRole)
+                return Alert::PriorityToString(alert->GetPriority());
+            if (role == SortRole)
+            {
+                // Unknown sorts below Priority5, as in Alert::CompareOnPriority
+                const int priority = static_cast<int>(alert->GetPriority());
+                return priority == 0 ? 6 : priority;
+            }
+            break;
+
+        case MessageColumn:
+            if (role == Qt::DisplayRole)
+            {
+                QString message = alert->GetTitle();
+                const QString description = alert->GetDescription();
+                if (this->IsExpanded(alert) && !description.isEmpty() && description != message)
+                    message += "\n" + description;
+                return message;
+            }
+            if (role == Qt::ToolTipRole)
+                return alert->GetDescription();
+            if (role == SortRole)
+                return alert->GetTitle();
+            break;
+
+        case LocationColumn:
+            if (role == Qt::DisplayRole || role == SortRole)
+                return alert->AppliesTo();
+            break;
+
+        case DateColumn:
+            if (role == Qt::DisplayRole)
+                return alert->GetTimestamp().toString("yyyy-MM-dd HH:mm:ss");
+            if (role == SortRole)
+                return alert->GetTimestamp().toMSecsSinceEpoch();
+            break;
+
+        case ActionsColumn:
+            if (role == Qt::DisplayRole)
+                return tr("Actions");
+            break;
+
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+QVariant AlertListModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (section)
+    {
+        case SeverityColumn:
+            return tr("Severity");
+        case MessageColumn:
+            return tr("Message");
+        case LocationColumn:
+            return tr("Location");
+        case DateColumn:
+            return tr("Date");
+        case ActionsColumn:
+            return tr("Actions");
+        default:
+            return QVariant();
+    }
+}
+
+bool AlertListModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && MessageAlertLoader::instance()->PendingCount() > 0;
+}
+
+void AlertListModel::fetchMore(const QModelIndex& parent)
+{
+    if (!parent.isValid())
+        MessageAlertLoader::instance()->FetchMore();
+}
+
+Alert* AlertListModel::GetAlert(int row) const
+{
+    return row >= 0 && row < this->m_alerts.size() ? this->m_alerts.at(row) : nullptr;
+}
+
+void AlertListModel::SetFilter(const std::function<bool(Alert*)>& filter)
+{
+    this->m_filter = filter;
+}
+
+bool AlertListModel::IsExpanded(const Alert* alert) const
+{
+    return alert && this->m_expanded.contains(alert->GetUUID());
+}
+
+void AlertListModel::SetExpanded(Alert* alert, bool expanded)
+{
+    if (!alert || this->IsExpanded(alert) == expanded)
+        return;
+
+    if (expanded)
+        this->m_expanded.insert(alert->GetUUID());
+    else
+        this->m_expanded.remove(alert->GetUUID());
+
+    const int row = this->m_rows.value(alert, -1);
+    if (row >= 0)
+        emit this->dataChanged(this->index(row, ExpanderColumn), this->index(row, MessageColumn));
+}
+
+void AlertListModel::Reload()
+{
+    this->beginResetModel();
+    this->m_alerts.clear();
+    this->m_rows.clear();
+    for (Alert* alert : AlertManager::instance()->GetNonDismissingAlerts())
+    {
+        if (this->accepts(alert))
+        {
+            this->m_rows.insert(alert, this->m_alerts.size());
+            this->m_alerts.append(alert);
+        }
+    }
+    this->endResetModel();
+}
+
+bool AlertListModel::accepts(Alert* alert) const
+{
+    return alert && !alert->IsDismissing() && (!this->m_filter || this->m_filter(alert));
+}
+
+void AlertListModel::appendAlerts(const QList<Alert*>& alerts)
+{
+    QList<Alert*> accepted;
+    for (Alert* alert : alerts)
+    {
+        if (!this->m_rows.contains(alert) && this->accepts(alert))
+            accepted.append(alert);
+    }
+
+    if (accepted.isEmpty())
+        return;
+
+    // One contiguous insert per batch; the proxy places the rows in sort order
+    const int first = this->m_alerts.size();
+    this->beginInsertRows(QModelIndex(), first, first + accepted.size() - 1);
+    for (Alert* alert : accepted)
+    {
+        this->m_rows.insert(alert, this->m_alerts.size());
+        this->m_alerts.append(alert);
+    }
+    this->endInsertRows();
+}
+
+void AlertListModel::removeRowIndexes(QList<int> rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    // Dropping most of the table is cheaper as a reset than as scattered removals
+    if (rows.size() > this->m_alerts.size() / 2)
+    {
+        const QSet<int> dropped(rows.cbegin(), rows.cend());
+        this->beginResetModel();
+        QList<Alert*> kept;
+        kept.reserve(this->m_alerts.size() - dropped.size());
+        for (int row = 0; row < this->m_alerts.size(); ++row)
+        {
+            if (!dropped.contains(row))
+                kept.append(this->m_alerts.at(row));
+        }
+        this->m_alerts = kept;
+        this->m_rows.clear();
+        this->reindexFrom(0);
+        this->endResetModel();
+        return;
+    }
+
+    // Remove contiguous runs from the bottom up so earlier row numbers stay valid
+    std::sort(rows.begin(), rows.end());
+    int end = rows.size() - 1;
+    while (end >= 0)
+    {
+        int start = end;
+        while (start > 0 && rows.at(start - 1) == rows.at(start) - 1)
+            --start;
+
+        const int firstRow = rows.at(start);
+        const int lastRow = rows.at(end);
+        this->beginRemoveRows(QModelIndex(), firstRow, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row)
+            this->m_rows.remove(this->m_alerts.at(row));
+        this->m_alerts.remove(firstRow, lastRow - firstRow + 1);
+        this->endRemoveRows();
+
+        end = start - 1;
+    }
+
+    this->reindexFrom(rows.first());
+}
+
+void AlertListModel::reindexFrom(int row)
+{
+    for (int i = row; i < this->m_alerts.size(); ++i)
+        this->m_rows[this->m_alerts.at(i)] = i;
+}
+
+void AlertListModel::onAlertsAdded(const QList<Alert*>& alerts)
+{
+    this->appendAlerts(alerts);
+}
+
+void AlertListModel::onAlertsRemoved(const QList<Alert*>& alerts)
+{
+    QList<int> rows;
+    for (Alert* alert : alerts)
+    {
+        const int row = this->m_rows.value(alert, -1);
+        if (row >= 0)
+            rows.append(row);
+        this->m_expanded.remove(alert->GetUUID());
+    }
+    this->removeRowIndexes(rows);
+}
+
+void AlertListModel::onAlertsChanged(const QList<Alert*>& alerts)
+{
+    // Mostly dismissing toggles: hide dismissing alerts, bring back restored ones
+    QList<int> hidden;
+    QList<Alert*> shown;
+    for (Alert* alert : alerts)
+    {
+        const int row = this->m_rows.value(alert, -1);
+        if (row >= 0 && !this->accepts(alert))
+            hidden.append(row);
+        else if (row < 0)
+            shown.append(alert);
+        else
+            emit this->dataChanged(this->index(row, 0), this->index(row, ColumnCount - 1));
+    }
+
+    this->removeRowIndexes(hidden);
+    this->appendAlerts(shown);
+}
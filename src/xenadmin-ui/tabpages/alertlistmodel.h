@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ALERTLISTMODEL_H
+#define ALERTLISTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <functional>
+#include "xenlib/alerts/alert.h"
+
+/**
+ * @brief Table model over AlertManager for the Alerts page
+ *
+ * Holds the non-dismissing alerts that pass the page filter and follows
+ * AlertManager's batched add/remove signals with row inserts and removals,
+ * so a view over tens of thousands of alerts only paints what is visible
+ * and never rebuilds on a collection change. Sorting is left to a
+ * QSortFilterProxyModel using SortRole.
+ */
+class AlertListModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+    public:
+        enum Column
+        {
+            ExpanderColumn = 0,
+            SeverityColumn,
+            MessageColumn,
+            LocationColumn,
+            DateColumn,
+            ActionsColumn,
+            ColumnCount
+        };
+
+        enum Role
+        {
+            SortRole = Qt::UserRole,
+            AlertRole
+        };
+
+        explicit AlertListModel(QObject* parent = nullptr);
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+        QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+        /** @brief Older messages not parsed yet are pulled in by MessageAlertLoader as the view scrolls. */
+        bool canFetchMore(const QModelIndex& parent) const override;
+        void fetchMore(const QModelIndex& parent) override;
+
+        XenLib::Alert* GetAlert(int row) const;
+        QList<XenLib::Alert*> GetAlerts() const { return this->m_alerts; }
+
+        /** @brief Alerts for which @p filter returns false are left out; takes effect on Reload(). */
+        void SetFilter(const std::function<bool(XenLib::Alert*)>& filter);
+
+        bool IsExpanded(const XenLib::Alert* alert) const;
+        void SetExpanded(XenLib::Alert* alert, bool expanded);
+
+        /** @brief Re-read the whole collection, e.g. after the filter changed. */
+        void Reload();
+
+    private slots:
+        void onAlertsAdded(const QList<XenLib::Alert*>& alerts);
+        void onAlertsRemoved(const QList<XenLib::Alert*>& alerts);
+        void onAlertsChanged(const QList<XenLib::Alert*>& alerts);
+
+    private:
+        bool accepts(XenLib::Alert* alert) const;
+        void appendAlerts(const QList<XenLib::Alert*>& alerts);
+        void removeRowIndexes(QList<int> rows);
+        void reindexFrom(int row);
+
+        QList<XenLib::Alert*> m_alerts;
+        QHash<XenLib::Alert*, int> m_rows;
+        QSet<QString> m_expanded;
+        std::function<bool(XenLib::Alert*)> m_filter;
+};
+
+#endif // ALERTLISTMODEL_H
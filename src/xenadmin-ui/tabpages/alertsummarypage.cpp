@@ -41,31 +41,53 @@
 #include <QApplication>
 #include <QHeaderView>
 #include <QItemSelectionModel>
+#include <QSortFilterProxyModel>
 #include <algorithm>
 #include "alertsummarypage.h"
 #include "ui_alertsummarypage.h"
+#include "alertlistmodel.h"
 #include "../settingsmanager.h"
-#include "../widgets/tableclipboardutils.h"
 #include "xenlib/alerts/alertmanager.h"
 #include "xenlib/alerts/alert.h"
+#include "xenlib/alerts/messagealertloader.h"
 
 using namespace XenLib;
 
 AlertSummaryPage::AlertSummaryPage(QWidget* parent) : NotificationsBasePage(parent), ui(new Ui::AlertSummaryPage), m_dateFilterEnabled(false)
 {
     this->ui->setupUi(this);
-    this->ui->alertsTable->sortByColumn(4, Qt::DescendingOrder);
-    this->ui->alertsTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+
+    // The model follows AlertManager incrementally, the proxy keeps it sorted
+    this->m_model = new AlertListModel(this);
+    this->m_model->SetFilter([this](Alert* alert) { return !this->filterAlert(alert); });
+    this->m_proxy = new QSortFilterProxyModel(this);
+    this->m_proxy->setSourceModel(this->m_model);
+    this->m_proxy->setSortRole(AlertListModel::SortRole);
+    this->m_proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+    this->m_proxy->setDynamicSortFilter(true);
+    this->ui->alertsTable->setModel(this->m_proxy);
+
+    this->ui->alertsTable->horizontalHeader()->setSectionResizeMode(AlertListModel::MessageColumn, QHeaderView::Stretch);
     this->ui->alertsTable->horizontalHeader()->setSortIndicatorShown(true);
+    this->ui->alertsTable->verticalHeader()->hide();
     this->ui->alertsTable->setSortingEnabled(true);
+    this->ui->alertsTable->sortByColumn(AlertListModel::DateColumn, Qt::DescendingOrder);
     this->ui->alertsTable->setContextMenuPolicy(Qt::CustomContextMenu);
-    
-    // Connect table cell clicks for expand/collapse (C# Reference: GridViewAlerts_CellClick)
-    connect(this->ui->alertsTable, &QTableWidget::cellClicked, this, &AlertSummaryPage::onExpanderClicked);
+
+    // Every alert is listed, there is no cap any more
+    this->ui->cappingLabel->hide();
+
+    // Expand/collapse and the per-row Actions menu (C# Reference: GridViewAlerts_CellClick)
+    connect(this->ui->alertsTable, &QTableView::clicked, this, &AlertSummaryPage::onAlertClicked);
     connect(this->ui->alertsTable, &QWidget::customContextMenuRequested, this, &AlertSummaryPage::onAlertsContextMenuRequested);
-    
-    // Connect to AlertManager signals
-    connect(AlertManager::instance(), &AlertManager::collectionChanged, this, &AlertSummaryPage::buildAlertList);
+
+    connect(this->ui->actionFilterSeverity, &QAction::triggered, this, &AlertSummaryPage::onFilterBySeverity);
+    connect(this->ui->actionFilterServer, &QAction::triggered, this, &AlertSummaryPage::onFilterByServer);
+    connect(this->ui->actionFilterDates, &QAction::triggered, this, &AlertSummaryPage::onFilterByDate);
+    connect(this->ui->actionRefresh, &QAction::triggered, this, &AlertSummaryPage::buildAlertList);
+    connect(this->ui->actionDismiss, &QAction::triggered, this, &AlertSummaryPage::onDismissAll);
+
+    this->m_model->Reload();
 }
 
 AlertSummaryPage::~AlertSummaryPage()
@@ -96,89 +118,8 @@ void AlertSummaryPage::deregisterEventHandlers()
 
 void AlertSummaryPage::buildAlertList()
 {
-    if (!this->isVisible())
-        return;
-
-    const TableClipboardUtils::SortState sortState = TableClipboardUtils::CaptureSortState(this->ui->alertsTable);
-    this->ui->alertsTable->setSortingEnabled(false);
-
-    this->ui->alertsTable->setUpdatesEnabled(false);
-    this->ui->alertsTable->setRowCount(0);
-    
-    // Get alerts from AlertManager
-    QList<Alert*> alerts = AlertManager::instance()->GetNonDismissingAlerts();
-    
-    // Apply filters (C# Reference: FilterAlert() line 283)
-    QList<Alert*> filteredAlerts;
-    for (Alert* alert : alerts)
-    {
-        if (!this->filterAlert(alert))
-            filteredAlerts.append(alert);
-    }
-    
-    for (Alert* alert : filteredAlerts)
-    {
-        int row = this->ui->alertsTable->rowCount();
-        this->ui->alertsTable->insertRow(row);
-        
-        // Column 0: Expand/collapse icon (C# Reference: GridViewAlerts_CellClick)
-        QTableWidgetItem* expandItem = new QTableWidgetItem();
-        expandItem->setIcon(this->getExpanderIcon(alert->GetUUID()));
-        expandItem->setData(Qt::UserRole, QVariant::fromValue(alert));
-        this->ui->alertsTable->setItem(row, 0, expandItem);
-        
-        // Column 1: Severity (GetPriority)
-        QString severity = Alert::PriorityToString(alert->GetPriority());
-        QTableWidgetItem* severityItem = new QTableWidgetItem(severity);
-        this->ui->alertsTable->setItem(row, 1, severityItem);
-        
-        // Column 2: Message (GetTitle + description if expanded)
-        QString message = alert->GetTitle();
-        bool isExpanded = this->m_expandedAlerts.contains(alert->GetUUID());
-        if (isExpanded && !alert->GetDescription().isEmpty() && alert->GetDescription() != alert->GetTitle())
-        {
-            message += "\n" + alert->GetDescription();
-        }
-        QTableWidgetItem* messageItem = new QTableWidgetItem(message);
-        this->ui->alertsTable->setItem(row, 2, messageItem);
-        
-        // Column 3: Location (AppliesTo)
-        QString location = alert->AppliesTo();
-        QTableWidgetItem* locationItem = new QTableWidgetItem(location);
-        this->ui->alertsTable->setItem(row, 3, locationItem);
-        
-        // Column 4: Date
-        QString dateStr = alert->GetTimestamp().toString("yyyy-MM-dd HH:mm:ss");
-        QTableWidgetItem* dateItem = new QTableWidgetItem(dateStr);
-        dateItem->setData(Qt::UserRole, alert->GetTimestamp());
-        this->ui->alertsTable->setItem(row, 4, dateItem);
-        
-        // Column 5: Actions dropdown (C# Reference: GetAlertActionItems() line 200)
-        QToolButton* actionBtn = new QToolButton();
-        actionBtn->setText(tr("Actions"));
-        actionBtn->setPopupMode(QToolButton::InstantPopup);
-        
-        QMenu* actionMenu = new QMenu(actionBtn);
-        
-        // Dismiss action (always available)
-        QAction* dismissAction = actionMenu->addAction(tr("Dismiss"));
-        connect(dismissAction, &QAction::triggered, this, [this, alert]()
-        {
-            this->dismissAlerts(QList<Alert*>() << alert,
-                               true,
-                               tr("Dismiss Alert"),
-                               tr("Are you sure you want to dismiss this alert?"));
-        });
-        
-        // TODO: Add Fix/Help/Web Console actions based on alert type
-        // C# Reference: MessageAlert.cs FixLinkAction, HelpLinkAction, WebConsoleAction
-        
-        actionBtn->setMenu(actionMenu);
-        this->ui->alertsTable->setCellWidget(row, 5, actionBtn);
-    }
-
-    this->ui->alertsTable->setUpdatesEnabled(true);
-    TableClipboardUtils::RestoreSortState(this->ui->alertsTable, sortState, 4, Qt::DescendingOrder);
+    // Only needed when the filter changes; collection changes arrive through the model
+    this->m_model->Reload();
 }
 
 bool AlertSummaryPage::filterAlert(Alert* alert) const
@@ -221,41 +162,51 @@ bool AlertSummaryPage::filterAlert(Alert* alert) const
     return false;  // Show this alert
 }
 
-QIcon AlertSummaryPage::getExpanderIcon(const QString& alertUuid) const
+Alert* AlertSummaryPage::alertAt(int row) const
+{
+    return this->m_proxy->index(row, 0).data(AlertListModel::AlertRole).value<Alert*>();
+}
+
+void AlertSummaryPage::showActionsMenu(Alert* alert, const QPoint& globalPos)
 {
-    // C# Reference: GridViewAlerts expandedState dictionary
-    bool isExpanded = this->m_expandedAlerts.contains(alertUuid);
-    QString iconPath = isExpanded ? 
-        ":/images/expanded_triangle.png" : 
-        ":/images/contracted_triangle.png";
-    return QIcon(iconPath);
+    // C# Reference: GetAlertActionItems() line 200
+    QMenu menu(this->ui->alertsTable);
+
+    // Dismiss action (always available)
+    QAction* dismissAction = menu.addAction(tr("Dismiss"));
+    dismissAction->setEnabled(alert->IsAllowedToDismiss());
+
+    // TODO: Add Fix/Help/Web Console actions based on alert type
+    // C# Reference: MessageAlert.cs FixLinkAction, HelpLinkAction, WebConsoleAction
+
+    if (menu.exec(globalPos) == dismissAction)
+    {
+        this->dismissAlerts(QList<Alert*>() << alert,
+                            true,
+                            tr("Dismiss Alert"),
+                            tr("Are you sure you want to dismiss this alert?"));
+    }
 }
 
 // Slots
 
-void AlertSummaryPage::onExpanderClicked(int row, int column)
+void AlertSummaryPage::onAlertClicked(const QModelIndex& index)
 {
     // C# Reference: GridViewAlerts_CellClick() line 307
-    if (column != 0)
-        return;  // Only handle clicks on expand column
-    
-    QTableWidgetItem* item = this->ui->alertsTable->item(row, 0);
-    if (!item)
-        return;
-    
-    Alert* alert = item->data(Qt::UserRole).value<Alert*>();
+    Alert* alert = index.data(AlertListModel::AlertRole).value<Alert*>();
     if (!alert)
         return;
-    
-    // Toggle expanded state
-    QString uuid = alert->GetUUID();
-    if (this->m_expandedAlerts.contains(uuid))
-        this->m_expandedAlerts.remove(uuid);
-    else
-        this->m_expandedAlerts.insert(uuid);
-    
-    // Rebuild list to show/hide description
-    this->buildAlertList();
+
+    if (index.column() == AlertListModel::ExpanderColumn)
+    {
+        // Toggle expanded state and let the row grow or shrink with the description
+        this->m_model->SetExpanded(alert, !this->m_model->IsExpanded(alert));
+        this->ui->alertsTable->resizeRowToContents(index.row());
+    } else if (index.column() == AlertListModel::ActionsColumn)
+    {
+        const QRect cell = this->ui->alertsTable->visualRect(index);
+        this->showActionsMenu(alert, this->ui->alertsTable->viewport()->mapToGlobal(cell.bottomLeft()));
+    }
 }
 
 void AlertSummaryPage::onAlertsContextMenuRequested(const QPoint& pos)
@@ -536,8 +487,10 @@ void AlertSummaryPage::onDismissAll()
 {
     // C# Reference: tsbtnDismissAll_Click
     const QList<Alert*> alerts = AlertManager::instance()->GetNonDismissingAlerts();
-    
-    if (alerts.isEmpty())
+    // Older messages still waiting in the loader have no alert yet but are dismissed too
+    const int pending = MessageAlertLoader::instance()->PendingCount();
+
+    if (alerts.isEmpty() && pending == 0)
         return;
 
     QList<Alert*> alertsToDismiss = alerts;
@@ -556,45 +509,31 @@ void AlertSummaryPage::onDismissAll()
         msgBox.exec();
 
         QAbstractButton* clicked = msgBox.clickedButton();
+        bool includePending = false;
         if (clicked == dismissAllBtn)
         {
             alertsToDismiss = alerts;
+            includePending = true;
         }
         else if (clicked == dismissFilteredBtn)
         {
-            alertsToDismiss.clear();
-            QSet<QString> seen;
-            for (int row = 0; row < this->ui->alertsTable->rowCount(); ++row)
-            {
-                QTableWidgetItem* item = this->ui->alertsTable->item(row, 0);
-                if (!item)
-                    continue;
-
-                Alert* alert = item->data(Qt::UserRole).value<Alert*>();
-                if (!alert)
-                    continue;
-
-                const QString uuid = alert->GetUUID();
-                if (seen.contains(uuid))
-                    continue;
-
-                seen.insert(uuid);
-                alertsToDismiss.append(alert);
-            }
+            // The model holds exactly the alerts that pass the filter
+            alertsToDismiss = this->m_model->GetAlerts();
         }
         else
         {
             return;
         }
 
-        this->dismissAlerts(alertsToDismiss, false, QString(), QString());
+        this->dismissAlerts(alertsToDismiss, false, QString(), QString(), includePending);
         return;
     }
 
     this->dismissAlerts(alertsToDismiss,
                         true,
                         tr("Dismiss All Alerts"),
-                        tr("Are you sure you want to dismiss all %1 alerts?").arg(alertsToDismiss.count()));
+                        tr("Are you sure you want to dismiss all %1 alerts?").arg(alertsToDismiss.count() + pending),
+                        true);
 }
 
 void AlertSummaryPage::onDismissSelected()
@@ -616,14 +555,7 @@ QList<Alert*> AlertSummaryPage::selectedAlerts(int fallbackRow) const
 
     auto appendFromRow = [&](int row)
     {
-        if (row < 0 || row >= this->ui->alertsTable->rowCount())
-            return;
-
-        QTableWidgetItem* item = this->ui->alertsTable->item(row, 0);
-        if (!item)
-            return;
-
-        Alert* alert = item->data(Qt::UserRole).value<Alert*>();
+        Alert* alert = this->alertAt(row);
         if (!alert)
             return;
 
@@ -644,9 +576,9 @@ QList<Alert*> AlertSummaryPage::selectedAlerts(int fallbackRow) const
     return alerts;
 }
 
-void AlertSummaryPage::dismissAlerts(const QList<Alert*>& alerts, bool confirm, const QString& title, const QString& text)
+void AlertSummaryPage::dismissAlerts(const QList<Alert*>& alerts, bool confirm, const QString& title, const QString& text, bool includePending)
 {
-    if (alerts.isEmpty())
+    if (alerts.isEmpty() && (!includePending || MessageAlertLoader::instance()->PendingCount() == 0))
         return;
 
     if (confirm && !SettingsManager::instance().GetDoNotConfirmDismissAlerts())
@@ -662,11 +594,13 @@ void AlertSummaryPage::dismissAlerts(const QList<Alert*>& alerts, bool confirm,
             return;
     }
 
-    for (Alert* alert : alerts)
-    {
-        alert->Dismiss();
-        AlertManager::instance()->RemoveAlert(alert);
-    }
+    // Taken only now, so messages that arrived while the question was up go as well
+    QHash<XenConnection*, QStringList> pendingMessages;
+    if (includePending)
+        pendingMessages = MessageAlertLoader::instance()->TakePending();
+
+    // Destroys the messages in concurrent batches; progress shows up under Events
+    AlertManager::instance()->DismissAlerts(alerts, pendingMessages);
 }
 
 void AlertSummaryPage::copyRowsToClipboard(const QList<int>& rows) const
@@ -682,11 +616,8 @@ void AlertSummaryPage::copyRowsToClipboard(const QList<int>& rows) const
     {
         QStringList cells;
         // Severity, Message, Location, Date (skip expander + actions columns)
-        for (int col = 1; col <= 4; ++col)
-        {
-            QTableWidgetItem* item = this->ui->alertsTable->item(row, col);
-            cells.append(item ? item->text() : QString());
-        }
+        for (int col = AlertListModel::SeverityColumn; col <= AlertListModel::DateColumn; ++col)
+            cells.append(this->m_proxy->index(row, col).data().toString());
         lines.append(cells.join('\t'));
     }
 
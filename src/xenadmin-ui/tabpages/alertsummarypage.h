@@ -35,6 +35,9 @@
 #include <QStringList>
 #include <QList>
 
+class AlertListModel;
+class QSortFilterProxyModel;
+
 namespace Ui
 {
     class AlertSummaryPage;
@@ -62,7 +65,7 @@ class AlertSummaryPage : public NotificationsBasePage
         void deregisterEventHandlers() override;
 
     private slots:
-        void onExpanderClicked(int row, int column);
+        void onAlertClicked(const QModelIndex& index);
         void onAlertsContextMenuRequested(const QPoint& pos);
         void onFilterBySeverity();
         void onFilterByServer();
@@ -72,6 +75,8 @@ class AlertSummaryPage : public NotificationsBasePage
 
     private:
         Ui::AlertSummaryPage* ui;
+        AlertListModel* m_model;
+        QSortFilterProxyModel* m_proxy;
 
         // Filter state (C# Reference: AlertSummaryPage.cs FilterAlert() line 283)
         QSet<XenLib::AlertPriority> m_severityFilters;  // Empty = show all
@@ -80,14 +85,13 @@ class AlertSummaryPage : public NotificationsBasePage
         QDateTime m_dateFilterFrom;
         QDateTime m_dateFilterTo;
 
-        // Expanded state tracking (C# Reference: AlertSummaryPage.cs expandedState)
-        QSet<QString> m_expandedAlerts;  // Set of alert UUIDs that are expanded
-
         void buildAlertList();
         bool filterAlert(XenLib::Alert* alert) const;
-        QIcon getExpanderIcon(const QString& alertUuid) const;
+        XenLib::Alert* alertAt(int row) const;
+        void showActionsMenu(XenLib::Alert* alert, const QPoint& globalPos);
         QList<XenLib::Alert*> selectedAlerts(int fallbackRow = -1) const;
-        void dismissAlerts(const QList<XenLib::Alert*>& alerts, bool confirm, const QString& title, const QString& text);
+        void dismissAlerts(const QList<XenLib::Alert*>& alerts, bool confirm, const QString& title, const QString& text,
+                           bool includePending = false);
         void copyRowsToClipboard(const QList<int>& rows) const;
 };
 
@@ -27,6 +27,7 @@
 
 #include "basetabpage.h"
 #include "xenlib/xen/xenobject.h"
+#include "xenlib/xen/network/rpctracer.h"
 
 
 BaseTabPage::BaseTabPage(QWidget* parent) : QWidget(parent)
@@ -39,6 +40,9 @@ BaseTabPage::~BaseTabPage()
 
 void BaseTabPage::SetObject(QSharedPointer<XenObject> object)
 {
+    // API calls made while the page loads are charged to it
+    RpcTraceScope traceScope(QString("%1 page").arg(this->GetTitle()));
+
     const bool hadObject = !this->m_object.isNull();
     const bool hasNewObject = !object.isNull();
     const bool sameObject = hadObject
@@ -148,6 +148,44 @@ bool GeneralTabPage::IsApplicableForObjectType(XenObjectType objectType) const
     return true;
 }
 
+void GeneralTabPage::updateObject()
+{
+    this->watchCertificates();
+}
+
+void GeneralTabPage::removeObject()
+{
+    if (this->m_certificateCache && this->m_certificateSubscription)
+        this->m_certificateCache->Unsubscribe(this->m_certificateSubscription);
+    this->m_certificateCache.clear();
+    this->m_certificateSubscription = 0;
+}
+
+void GeneralTabPage::watchCertificates()
+{
+    XenCache* cache = nullptr;
+    const XenObjectType type = this->m_object ? this->m_object->GetObjectType() : XenObjectType::Null;
+    if (type == XenObjectType::Host || type == XenObjectType::Pool)
+        cache = this->m_object->GetCache();
+
+    if (cache == this->m_certificateCache && this->m_certificateSubscription)
+        return;
+
+    this->removeObject();
+    if (!cache)
+        return;
+
+    // Certificates are loaded on demand, usually after the page was first filled
+    this->m_certificateCache = cache;
+    this->m_certificateSubscription = cache->Subscribe(this, XenObjectType::Certificate, [this](const QList<XenCacheChange>&)
+    {
+        if (this->isVisible())
+            this->refreshContent();
+        else
+            this->MarkDirty();
+    });
+}
+
 void GeneralTabPage::refreshContent()
 {
     if (!this->m_object)
@@ -33,6 +33,7 @@
 #include <QAction>
 #include <QHash>
 #include <QList>
+#include <QPointer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -41,6 +42,8 @@ namespace Ui
 }
 QT_END_NAMESPACE
 
+class XenCache;
+
 /**
  * General tab page showing basic information about any Xen object.
  * This tab is applicable to all object types and displays common properties
@@ -70,12 +73,18 @@ class GeneralTabPage : public BaseTabPage
 
     protected:
         void refreshContent() override;
+        void updateObject() override;
+        void removeObject() override;
 
     private:
         Ui::GeneralTabPage* ui;
         QList<PDSection*> m_sections;
         QHash<QString, QList<PDSection*>> m_expandedSections;
         QAction* m_propertiesAction;
+        QPointer<XenCache> m_certificateCache;
+        int m_certificateSubscription = 0;
+
+        void watchCertificates();
 
         void clearProperties();
         void addProperty(PDSection* section, const QString& label, const QString& value, const QList<QAction*>& contextMenuItems = QList<QAction*>());
@@ -285,6 +285,7 @@ SOURCES += \
     tabpages/searchtabpage.cpp \
     tabpages/notificationsbasepage.cpp \
     tabpages/alertsummarypage.cpp \
+    tabpages/alertlistmodel.cpp \
     tabpages/eventspage.cpp \
     controls/memorybar.cpp \
     controls/memoryspinner.cpp \
@@ -603,6 +604,7 @@ HEADERS += \
     tabpages/searchtabpage.h \
     tabpages/notificationsbasepage.h \
     tabpages/alertsummarypage.h \
+    tabpages/alertlistmodel.h \
     tabpages/eventspage.h \
     controls/memorybar.h \
     controls/memoryspinner.h \
@@ -3,7 +3,12 @@ CONFIG += ordered
 
 SUBDIRS = \
     xenlib \
-    xenadmin-ui
+    xenadmin-ui \
+    mockxapi \
+    mockxapi-server
+
+mockxapi-server.file = mockxapi/server/mockxapi-server.pro
+mockxapi-server.depends = mockxapi
 
 # Make sure xenlib is built before xenadmin-ui
 xenadmin-ui.depends = xenlib
\ No newline at end of file
@@ -26,6 +26,7 @@
  */
 
 #include "alert.h"
+#include "alertmanager.h"
 #include "../xen/network/connection.h"
 
 using namespace XenLib;
@@ -38,6 +39,16 @@ Alert::Alert(XenConnection* connection) : QObject(nullptr)
     this->m_timestamp = QDateTime::currentDateTime();
 }
 
+void Alert::SetDismissing(bool dismissing)
+{
+    if (this->m_dismissing == dismissing)
+        return;
+
+    // Keep AlertManager's counts and views in step with the flag
+    this->m_dismissing = dismissing;
+    AlertManager::instance()->onAlertDismissingChanged(this);
+}
+
 // C# Reference: Alert.cs line 272 - CompareOnDate
 int Alert::CompareOnDate(const Alert* a1, const Alert* a2)
 {
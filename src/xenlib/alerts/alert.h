@@ -75,6 +75,10 @@ class XENLIB_EXPORT Alert : public QObject
         QDateTime GetTimestamp() const { return this->m_timestamp; }
         virtual QString AppliesTo() const = 0;
 
+        // Keys AlertManager indexes on; empty for alerts not backed by a XenAPI message
+        virtual QString GetOpaqueRef() const { return QString(); }
+        virtual QString GetObjUUID() const { return QString(); }
+
         // Additional properties
         virtual QString GetName() const { return QString(); }
         virtual QString GetWebPageLabel() const { return QString(); }
@@ -87,7 +91,7 @@ class XENLIB_EXPORT Alert : public QObject
         virtual void Dismiss() = 0;
 
         bool IsDismissing() const { return this->m_dismissing; }
-        void SetDismissing(bool dismissing) { this->m_dismissing = dismissing; }
+        void SetDismissing(bool dismissing);
 
         // Connection tracking
         XenConnection* GetConnection() const { return this->m_connection; }
@@ -104,6 +108,8 @@ class XENLIB_EXPORT Alert : public QObject
         static QString PriorityToString(AlertPriority priority);
 
     protected:
+        friend class AlertManager;
+
         explicit Alert(XenConnection* connection = nullptr);
 
         QString m_uuid;
@@ -26,7 +26,11 @@
  */
 
 #include "alertmanager.h"
+#include "messagealertloader.h"
+#include "../operations/parallelaction.h"
+#include "../xen/actions/general/dismissmessagesaction.h"
 #include <QMutexLocker>
+#include <QPointer>
 #include <QDebug>
 
 using namespace XenLib;
@@ -49,33 +53,90 @@ AlertManager::~AlertManager()
     this->ClearAllAlerts();
 }
 
+AlertManager::DateKey AlertManager::dateKey(const Alert* alert)
+{
+    return DateKey(alert->GetTimestamp().toMSecsSinceEpoch(), alert->GetUUID());
+}
+
+bool AlertManager::indexAlert(Alert* alert)
+{
+    const QString uuid = alert->GetUUID();
+    if (this->m_byUuid.contains(uuid))
+        return false;
+
+    this->m_byUuid.insert(uuid, alert);
+    const QString opaqueRef = alert->GetOpaqueRef();
+    if (!opaqueRef.isEmpty())
+        this->m_byOpaqueRef.insert(opaqueRef, alert);
+    this->m_byConnection[alert->GetConnection()].insert(alert);
+    const QString objUuid = alert->GetObjUUID();
+    if (!objUuid.isEmpty())
+        this->m_byObject[objUuid].insert(alert);
+    this->m_byPriority[alert->GetPriority()].insert(alert);
+    this->m_byDate.insert(dateKey(alert), alert);
+    if (alert->IsDismissing())
+        this->m_dismissingCount++;
+    return true;
+}
+
+bool AlertManager::unindexAlert(Alert* alert)
+{
+    auto it = this->m_byUuid.find(alert->GetUUID());
+    if (it == this->m_byUuid.end() || it.value() != alert)
+        return false;
+
+    this->m_byUuid.erase(it);
+    const QString opaqueRef = alert->GetOpaqueRef();
+    if (!opaqueRef.isEmpty() && this->m_byOpaqueRef.value(opaqueRef) == alert)
+        this->m_byOpaqueRef.remove(opaqueRef);
+
+    // Drop empty buckets so per-connection and per-object keys do not pile up
+    auto removeFrom = [alert](auto& index, const auto& key)
+    {
+        auto bucket = index.find(key);
+        if (bucket == index.end())
+            return;
+        bucket.value().remove(alert);
+        if (bucket.value().isEmpty())
+            index.erase(bucket);
+    };
+    removeFrom(this->m_byConnection, alert->GetConnection());
+    removeFrom(this->m_byObject, alert->GetObjUUID());
+    removeFrom(this->m_byPriority, alert->GetPriority());
+    this->m_byDate.remove(dateKey(alert));
+    if (alert->IsDismissing())
+        this->m_dismissingCount--;
+    return true;
+}
+
 void AlertManager::AddAlert(Alert* alert)
 {
     if (!alert)
         return;
-    
-    {
-        QMutexLocker locker(&this->m_mutex);
-        this->m_alerts.append(alert);
-    }
-    
-    emit this->alertAdded(alert);
-    emit this->collectionChanged();
+
+    this->AddAlerts(QList<Alert*>() << alert);
 }
 
 void AlertManager::AddAlerts(const QList<Alert*>& alerts)
 {
-    if (alerts.isEmpty())
-        return;
-    
-    // TODO This can cause a deadlock, need to figure it out
-    //QMutexLocker locker(&this->m_mutex);
-    this->m_alerts.append(alerts);
-    
-    for (Alert* alert : alerts)
+    QList<Alert*> added;
     {
-        emit this->alertAdded(alert);
+        QMutexLocker locker(&this->m_mutex);
+        added.reserve(alerts.size());
+        for (Alert* alert : alerts)
+        {
+            if (alert && this->indexAlert(alert))
+                added.append(alert);
+        }
     }
+
+    if (added.isEmpty())
+        return;
+
+    // Signals go out without the lock so handlers can query the manager
+    for (Alert* alert : added)
+        emit this->alertAdded(alert);
+    emit this->alertsAdded(added);
     emit this->collectionChanged();
 }
 
@@ -83,57 +144,56 @@ void AlertManager::RemoveAlert(Alert* alert)
 {
     if (!alert)
         return;
-    
-    // TODO This can cause a deadlock, need to figure it out
-    //QMutexLocker locker(&this->m_mutex);
-    if (this->m_alerts.removeOne(alert))
+
+    this->RemoveAlerts(QList<Alert*>() << alert);
+}
+
+void AlertManager::RemoveAlerts(const QList<Alert*>& alerts)
+{
+    QList<Alert*> removed;
     {
-        emit this->alertRemoved(alert);
-        emit this->collectionChanged();
-        delete alert;
+        QMutexLocker locker(&this->m_mutex);
+        removed.reserve(alerts.size());
+        for (Alert* alert : alerts)
+        {
+            if (alert && this->unindexAlert(alert))
+                removed.append(alert);
+        }
     }
+
+    if (removed.isEmpty())
+        return;
+
+    for (Alert* alert : removed)
+        emit this->alertRemoved(alert);
+    emit this->alertsRemoved(removed);
+    emit this->collectionChanged();
+    qDeleteAll(removed);
 }
 
 void AlertManager::RemoveAlerts(const std::function<bool(Alert*)>& predicate)
 {
-    // TODO This can cause a deadlock, need to figure it out
-    //QMutexLocker locker(&this->m_mutex);
-    
     QList<Alert*> toRemove;
-    for (Alert* alert : this->m_alerts)
+    for (Alert* alert : this->GetAllAlerts())
     {
         if (predicate(alert))
             toRemove.append(alert);
     }
-    
-    for (Alert* alert : toRemove)
-    {
-        this->m_alerts.removeOne(alert);
-        emit this->alertRemoved(alert);
-        delete alert;
-    }
-    
-    if (!toRemove.isEmpty())
-        emit this->collectionChanged();
+
+    this->RemoveAlerts(toRemove);
 }
 
 Alert* AlertManager::FindAlert(const QString& uuid) const
 {
     QMutexLocker locker(&this->m_mutex);
-    for (Alert* alert : this->m_alerts)
-    {
-        if (alert && alert->GetUUID() == uuid)
-            return alert;
-    }
-    return nullptr;
+    return this->m_byUuid.value(uuid);
 }
 
 Alert* AlertManager::FindAlert(const std::function<bool(Alert*)>& predicate) const
 {
-    QMutexLocker locker(&this->m_mutex);
-    for (Alert* alert : this->m_alerts)
+    for (Alert* alert : this->GetAllAlerts())
     {
-        if (alert && predicate(alert))
+        if (predicate(alert))
             return alert;
     }
     return nullptr;
@@ -141,40 +201,47 @@ Alert* AlertManager::FindAlert(const std::function<bool(Alert*)>& predicate) con
 
 int AlertManager::FindAlertIndex(const std::function<bool(Alert*)>& predicate) const
 {
-    QMutexLocker locker(&this->m_mutex);
-    for (int i = 0; i < this->m_alerts.size(); ++i)
+    const QList<Alert*> alerts = this->GetAllAlerts();
+    for (int i = 0; i < alerts.size(); ++i)
     {
-        if (this->m_alerts[i] && predicate(this->m_alerts[i]))
+        if (predicate(alerts.at(i)))
             return i;
     }
     return -1;
 }
 
+Alert* AlertManager::FindAlertByOpaqueRef(const QString& opaqueRef) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_byOpaqueRef.value(opaqueRef);
+}
+
 int AlertManager::AlertCount() const
 {
     QMutexLocker locker(&this->m_mutex);
-    return this->m_alerts.count();
+    return this->m_byUuid.size();
 }
 
 int AlertManager::NonDismissingAlertCount() const
 {
     QMutexLocker locker(&this->m_mutex);
-    int count = 0;
-    for (Alert* alert : this->m_alerts)
-    {
-        if (alert && !alert->IsDismissing())
-            count++;
-    }
-    return count;
+    return this->m_byUuid.size() - this->m_dismissingCount;
+}
+
+int AlertManager::AlertCount(AlertPriority priority) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_byPriority.value(priority).size();
 }
 
 QList<Alert*> AlertManager::GetNonDismissingAlerts() const
 {
     QMutexLocker locker(&this->m_mutex);
     QList<Alert*> result;
-    for (Alert* alert : this->m_alerts)
+    result.reserve(this->m_byUuid.size() - this->m_dismissingCount);
+    for (Alert* alert : this->m_byDate)
     {
-        if (alert && !alert->IsDismissing())
+        if (!alert->IsDismissing())
             result.append(alert);
     }
     return result;
@@ -183,16 +250,207 @@ QList<Alert*> AlertManager::GetNonDismissingAlerts() const
 QList<Alert*> AlertManager::GetAllAlerts() const
 {
     QMutexLocker locker(&this->m_mutex);
-    return this->m_alerts;
+    return this->m_byDate.values();
+}
+
+QList<Alert*> AlertManager::GetAlerts(XenConnection* connection) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_byConnection.value(connection).values();
+}
+
+QList<Alert*> AlertManager::GetAlertsForObject(const QString& objUuid) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_byObject.value(objUuid).values();
+}
+
+QList<Alert*> AlertManager::GetAlerts(AlertPriority priority) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_byPriority.value(priority).values();
+}
+
+QList<Alert*> AlertManager::GetAlerts(const QDateTime& from, const QDateTime& to) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    QList<Alert*> result;
+    const qint64 last = to.toMSecsSinceEpoch();
+    for (auto it = this->m_byDate.lowerBound(DateKey(from.toMSecsSinceEpoch(), QString()));
+         it != this->m_byDate.end() && it.key().first <= last; ++it)
+    {
+        result.append(it.value());
+    }
+    return result;
+}
+
+QList<Alert*> AlertManager::GetNewestAlerts(int count) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    QList<Alert*> result;
+    result.reserve(qMin(count, int(this->m_byDate.size())));
+    for (auto it = this->m_byDate.end(); it != this->m_byDate.begin() && result.size() < count;)
+    {
+        --it;
+        result.append(it.value());
+    }
+    return result;
+}
+
+AsyncOperation* AlertManager::DismissAlerts(const QList<Alert*>& alerts, const QHash<XenConnection*, QStringList>& pendingMessages)
+{
+    // C# Reference: DeleteAllAlertsAction - one message.destroy per message, grouped per connection
+    QHash<XenConnection*, QStringList> messageRefs;
+    for (auto it = pendingMessages.constBegin(); it != pendingMessages.constEnd(); ++it)
+    {
+        if (it.key() && !it.value().isEmpty())
+            messageRefs[it.key()].append(it.value());
+    }
+    QList<Alert*> messageAlerts;
+    QList<Alert*> localAlerts;
+    for (Alert* alert : alerts)
+    {
+        if (!alert || alert->IsDismissing() || !alert->IsAllowedToDismiss())
+            continue;
+
+        const QString opaqueRef = alert->GetOpaqueRef();
+        if (!opaqueRef.isEmpty() && alert->GetConnection())
+        {
+            messageAlerts.append(alert);
+            messageRefs[alert->GetConnection()].append(opaqueRef);
+        } else
+        {
+            alert->Dismiss();
+            localAlerts.append(alert);
+        }
+    }
+
+    this->setDismissing(messageAlerts, true);
+    this->RemoveAlerts(localAlerts);
+
+    QList<AsyncOperation*> batches;
+    QList<QPointer<DismissMessagesAction>> dismissBatches;
+    for (auto it = messageRefs.constBegin(); it != messageRefs.constEnd(); ++it)
+    {
+        const QStringList& refs = it.value();
+        for (int start = 0; start < refs.size(); start += DISMISS_BATCH_SIZE)
+        {
+            DismissMessagesAction* batch = new DismissMessagesAction(it.key(), refs.mid(start, DISMISS_BATCH_SIZE));
+            connect(batch, &DismissMessagesAction::messagesNotDestroyed, this, &AlertManager::restoreAlerts);
+            batches.append(batch);
+            dismissBatches.append(batch);
+        }
+    }
+
+    if (batches.isEmpty())
+        return nullptr;
+
+    // Batches that never got to run() (no session, cancelled early) have nothing to report
+    auto restoreNotRun = [this, dismissBatches]()
+    {
+        for (const QPointer<DismissMessagesAction>& batch : dismissBatches)
+        {
+            if (batch && !batch->HasRun())
+                this->restoreAlerts(batch->GetMessageRefs());
+        }
+    };
+
+    if (batches.size() == 1)
+    {
+        connect(batches.first(), &AsyncOperation::failed, this, restoreNotRun);
+        connect(batches.first(), &AsyncOperation::cancelled, this, restoreNotRun);
+        batches.first()->RunAsync(true);
+        return batches.first();
+    }
+
+    int total = 0;
+    for (const QStringList& refs : messageRefs)
+        total += refs.size();
+
+    XenConnection* connection = messageRefs.size() == 1 ? messageRefs.constBegin().key() : nullptr;
+    ParallelAction* action = new ParallelAction(tr("Dismissing %1 alerts").arg(total),
+                                                tr("Dismissing alerts..."),
+                                                tr("Dismissed alerts"),
+                                                batches,
+                                                connection);
+    connect(action, &AsyncOperation::failed, this, restoreNotRun);
+    connect(action, &AsyncOperation::cancelled, this, restoreNotRun);
+    action->RunAsync(true);
+    return action;
+}
+
+void AlertManager::restoreAlerts(const QStringList& messageRefs)
+{
+    // The messages survived, so their alerts come back into view
+    QList<Alert*> alerts;
+    for (const QString& ref : messageRefs)
+    {
+        if (Alert* alert = this->FindAlertByOpaqueRef(ref))
+            alerts.append(alert);
+    }
+    this->setDismissing(alerts, false);
+
+    // Ones that never had an alert go back to the loader's queue
+    MessageAlertLoader::instance()->Restore(messageRefs);
+}
+
+void AlertManager::setDismissing(const QList<Alert*>& alerts, bool dismissing)
+{
+    // Same as Alert::SetDismissing() on each, with one alertsChanged() for the lot
+    QList<Alert*> changed;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        for (Alert* alert : alerts)
+        {
+            if (alert->m_dismissing == dismissing)
+                continue;
+            alert->m_dismissing = dismissing;
+            if (this->m_byUuid.value(alert->GetUUID()) == alert)
+            {
+                this->m_dismissingCount += dismissing ? 1 : -1;
+                changed.append(alert);
+            }
+        }
+    }
+
+    if (changed.isEmpty())
+        return;
+
+    for (Alert* alert : changed)
+        emit this->alertChanged(alert);
+    emit this->alertsChanged(changed);
+}
+
+void AlertManager::onAlertDismissingChanged(Alert* alert)
+{
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (this->m_byUuid.value(alert->GetUUID()) != alert)
+            return;
+        this->m_dismissingCount += alert->IsDismissing() ? 1 : -1;
+    }
+
+    emit this->alertChanged(alert);
+    emit this->alertsChanged(QList<Alert*>() << alert);
 }
 
 void AlertManager::ClearAllAlerts()
 {
+    QList<Alert*> alerts;
     {
         QMutexLocker locker(&this->m_mutex);
-        qDeleteAll(this->m_alerts);
-        this->m_alerts.clear();
+        alerts = this->m_byDate.values();
+        this->m_byUuid.clear();
+        this->m_byOpaqueRef.clear();
+        this->m_byConnection.clear();
+        this->m_byObject.clear();
+        this->m_byPriority.clear();
+        this->m_byDate.clear();
+        this->m_dismissingCount = 0;
     }
 
+    if (!alerts.isEmpty())
+        emit this->alertsRemoved(alerts);
     emit this->collectionChanged();
+    qDeleteAll(alerts);
 }
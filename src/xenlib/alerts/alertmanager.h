@@ -30,9 +30,17 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
 #include <QMutex>
+#include <functional>
 #include "alert.h"
 
+class AsyncOperation;
+class XenConnection;
+
 namespace XenLib
 {
 /**
@@ -41,12 +49,20 @@ namespace XenLib
  * 
  * Manages the global collection of alerts, provides thread-safe access,
  * and emits signals when the collection changes.
+ *
+ * Alerts are indexed by uuid, message opaque_ref, connection, object uuid,
+ * priority and date so lookups stay cheap with tens of thousands of
+ * messages. Predicates passed to the std::function overloads run without
+ * the lock held, so they may call back into the manager.
  */
 class XENLIB_EXPORT AlertManager : public QObject
 {
     Q_OBJECT
 
     public:
+        /// Messages destroyed per DismissMessagesAction when dismissing in bulk
+        static const int DISMISS_BATCH_SIZE = 100;
+
         static AlertManager* instance();
         ~AlertManager() override;
 
@@ -57,6 +73,7 @@ class XENLIB_EXPORT AlertManager : public QObject
 
         // C# Reference: Alert.cs line 58 - RemoveAlert
         void RemoveAlert(Alert* alert);
+        void RemoveAlerts(const QList<Alert*>& alerts);
         void RemoveAlerts(const std::function<bool(Alert*)>& predicate);
 
         // C# Reference: Alert.cs line 83 - FindAlert
@@ -64,29 +81,85 @@ class XENLIB_EXPORT AlertManager : public QObject
         Alert* FindAlert(const std::function<bool(Alert*)>& predicate) const;
         int FindAlertIndex(const std::function<bool(Alert*)>& predicate) const;
 
+        /** @brief Alert created for the XenAPI message @p opaqueRef, if any. */
+        Alert* FindAlertByOpaqueRef(const QString& opaqueRef) const;
+
         // C# Reference: Alert.cs line 123 - AlertCount
         int AlertCount() const;
         int NonDismissingAlertCount() const;
+        int AlertCount(AlertPriority priority) const;
 
         // C# Reference: Alert.cs line 145 - GetNonDismissingAlerts
         QList<Alert*> GetNonDismissingAlerts() const;
         QList<Alert*> GetAllAlerts() const;
 
+        QList<Alert*> GetAlerts(XenConnection* connection) const;
+        QList<Alert*> GetAlertsForObject(const QString& objUuid) const;
+        QList<Alert*> GetAlerts(AlertPriority priority) const;
+
+        /** @brief Alerts timestamped within [from, to], oldest first. */
+        QList<Alert*> GetAlerts(const QDateTime& from, const QDateTime& to) const;
+
+        /** @brief The @p count most recent alerts, newest first. */
+        QList<Alert*> GetNewestAlerts(int count) const;
+
+        /**
+         * @brief Dismiss alerts in bulk.
+         *
+         * Alerts backed by a XenAPI message are marked dismissing straight
+         * away and their messages destroyed by batches of
+         * DismissMessagesAction running in parallel; the alerts go away when
+         * the deletions come back through the event stream, or reappear if
+         * the destroy fails. Other alerts are dismissed and removed at once.
+         *
+         * @p pendingMessages are messages without an alert yet, as handed
+         * over by MessageAlertLoader::TakePending(); they join the same
+         * batches and go back to the loader if the destroy fails.
+         *
+         * @return The operation tracking the message deletions (already
+         *         started, auto-deleted), or nullptr if there were none.
+         */
+        AsyncOperation* DismissAlerts(const QList<Alert*>& alerts,
+                                      const QHash<XenConnection*, QStringList>& pendingMessages = {});
+
         // Clear all alerts (for cleanup)
         void ClearAllAlerts();
 
     signals:
         // C# Reference: Alert.cs line 199 - RegisterAlertCollectionChanged
-        void alertAdded(Alert* alert);
-        void alertRemoved(Alert* alert);
-        void alertChanged(Alert* alert);
+        void alertAdded(XenLib::Alert* alert);
+        void alertRemoved(XenLib::Alert* alert);
+        void alertChanged(XenLib::Alert* alert);
+
+        /** @brief One signal per AddAlerts()/RemoveAlerts() batch; removed alerts are still valid here. */
+        void alertsAdded(const QList<XenLib::Alert*>& alerts);
+        void alertsRemoved(const QList<XenLib::Alert*>& alerts);
+        void alertsChanged(const QList<XenLib::Alert*>& alerts);
         void collectionChanged();
 
     private:
+        friend class Alert;
+
+        // Date order with the uuid as tie breaker, matching Alert::CompareOnDate
+        using DateKey = QPair<qint64, QString>;
+
         explicit AlertManager(QObject* parent = nullptr);
 
+        static DateKey dateKey(const Alert* alert);
+        bool indexAlert(Alert* alert);
+        bool unindexAlert(Alert* alert);
+        void onAlertDismissingChanged(Alert* alert);
+        void setDismissing(const QList<Alert*>& alerts, bool dismissing);
+        void restoreAlerts(const QStringList& messageRefs);
+
         static AlertManager* s_instance;
-        QList<Alert*> m_alerts;
+        QHash<QString, Alert*> m_byUuid;
+        QHash<QString, Alert*> m_byOpaqueRef;
+        QHash<XenConnection*, QSet<Alert*>> m_byConnection;
+        QHash<QString, QSet<Alert*>> m_byObject;
+        QHash<AlertPriority, QSet<Alert*>> m_byPriority;
+        QMap<DateKey, Alert*> m_byDate;
+        int m_dismissingCount = 0;
         mutable QMutex m_mutex;
 };
 } // XenLib
@@ -30,6 +30,7 @@
 #include "policyalert.h"
 #include "certificatealert.h"
 #include "alertmanager.h"
+#include "messagealertloader.h"
 #include "../xen/network/connection.h"
 #include <QDateTime>
 
@@ -67,9 +68,15 @@ QString MessageAlert::GetName() const
 
 void MessageAlert::Dismiss()
 {
-    // TODO: Call XenAPI Message.destroy to remove the message
-    // For now, just mark as dismissing
-    this->m_dismissing = true;
+    // C# Reference: MessageAlert.cs Dismiss() - Message.destroy, the alert
+    // disappears when the deletion comes back through the event stream
+    if (this->GetOpaqueRef().isEmpty() || !this->m_connection)
+    {
+        this->SetDismissing(true);
+        return;
+    }
+
+    AlertManager::instance()->DismissAlerts(QList<Alert*>() << this);
 }
 
 QString MessageAlert::GetMessageType() const
@@ -146,15 +153,9 @@ void MessageAlert::RemoveAlert(const QString& messageRef)
 {
     // C# Reference: MessageAlert.cs line 447 - RemoveWithMessage()
     // Find and remove alert associated with this message opaque_ref
-    
-    Alert* alert = AlertManager::instance()->FindAlert([messageRef](Alert* a)
-    {
-        MessageAlert* msgAlert = dynamic_cast<MessageAlert*>(a);
-        if (!msgAlert)
-            return false;
-        return msgAlert->GetOpaqueRef() == messageRef;
-    });
-    
+    MessageAlertLoader::instance()->Remove(messageRef);
+    Alert* alert = AlertManager::instance()->FindAlertByOpaqueRef(messageRef);
+
     if (alert)
     {
         AlertManager::instance()->RemoveAlert(alert);
@@ -60,8 +60,8 @@ class XENLIB_EXPORT MessageAlert : public Alert
         QVariantMap GetMessageData() const { return this->m_messageData; }
         QString GetMessageType() const;
         QString GetMessageBody() const;
-        QString GetObjUUID() const;
-        QString GetOpaqueRef() const;
+        QString GetObjUUID() const override;
+        QString GetOpaqueRef() const override;
 
         // Factory method to create appropriate alert type based on message type
         // C# Reference: MessageAlert.cs line 462 - ParseMessage()
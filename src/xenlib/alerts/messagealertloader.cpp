@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "messagealertloader.h"
+#include "messagealert.h"
+#include "alertmanager.h"
+#include "../xen/network/connection.h"
+#include <QMetaObject>
+#include <QThread>
+#include <QThreadPool>
+
+using namespace XenLib;
+
+MessageAlertLoader* MessageAlertLoader::s_instance = nullptr;
+
+MessageAlertLoader* MessageAlertLoader::instance()
+{
+    if (!s_instance)
+        s_instance = new MessageAlertLoader();
+    return s_instance;
+}
+
+MessageAlertLoader::MessageAlertLoader(QObject* parent) : QObject(parent)
+{
+}
+
+MessageAlertLoader::PendingKey MessageAlertLoader::pendingKey(const QString& messageRef, const QVariantMap& messageData)
+{
+    // Same timestamp MessageAlert::parseMessageData() uses
+    return PendingKey(-messageData.value("timestamp").toLongLong(), messageRef);
+}
+
+void MessageAlertLoader::Enqueue(XenConnection* connection, const QVariantMap& messageData)
+{
+    const QString messageRef = messageData.value("ref").toString();
+    if (!connection || messageRef.isEmpty())
+        return;
+
+    // Messages are immutable, a "mod" event for one we already know adds nothing
+    if (this->m_pendingRefs.contains(messageRef) || this->m_inFlight.contains(messageRef)
+        || this->m_taken.contains(messageRef) || AlertManager::instance()->FindAlertByOpaqueRef(messageRef))
+        return;
+
+    ConnectionQueue& queue = this->m_queues[connection];
+    if (queue.connection.isNull())
+    {
+        // New connection, or a new one allocated where a deleted one used to be
+        queue = ConnectionQueue();
+        queue.connection = connection;
+    }
+
+    const PendingKey key = pendingKey(messageRef, messageData);
+    queue.pending.insert(key, messageData);
+    this->m_pendingRefs.insert(messageRef, qMakePair(connection, key));
+    this->scheduleFlush();
+}
+
+void MessageAlertLoader::Remove(const QString& messageRef)
+{
+    auto refIt = this->m_pendingRefs.find(messageRef);
+    if (refIt != this->m_pendingRefs.end())
+    {
+        auto queueIt = this->m_queues.find(refIt.value().first);
+        if (queueIt != this->m_queues.end())
+            queueIt.value().pending.remove(refIt.value().second);
+        this->m_pendingRefs.erase(refIt);
+    }
+
+    // An alert still being parsed is thrown away when it comes back
+    this->m_inFlight.remove(messageRef);
+    this->m_taken.remove(messageRef);
+}
+
+void MessageAlertLoader::FetchMore()
+{
+    // Views ask again on every scroll; one page at a time is plenty
+    if (!this->m_inFlight.isEmpty())
+        return;
+
+    bool more = false;
+    for (ConnectionQueue& queue : this->m_queues)
+    {
+        if (queue.pending.isEmpty() || queue.requested > queue.loaded)
+            continue;
+        queue.requested = queue.loaded + PAGE_SIZE;
+        more = true;
+    }
+
+    if (more)
+        this->scheduleFlush();
+}
+
+int MessageAlertLoader::PendingCount() const
+{
+    return this->m_pendingRefs.size();
+}
+
+QHash<XenConnection*, QStringList> MessageAlertLoader::TakePending()
+{
+    QHash<XenConnection*, QStringList> result;
+    for (auto queueIt = this->m_queues.begin(); queueIt != this->m_queues.end(); ++queueIt)
+    {
+        ConnectionQueue& queue = queueIt.value();
+        for (auto it = queue.pending.constBegin(); it != queue.pending.constEnd(); ++it)
+        {
+            const QString& messageRef = it.key().second;
+            this->m_pendingRefs.remove(messageRef);
+            if (queue.connection.isNull())
+                continue;
+            result[queueIt.key()].append(messageRef);
+            this->m_taken.insert(messageRef, qMakePair(queue.connection, it.value()));
+        }
+        queue.pending.clear();
+    }
+    return result;
+}
+
+void MessageAlertLoader::Restore(const QStringList& messageRefs)
+{
+    for (const QString& messageRef : messageRefs)
+    {
+        auto it = this->m_taken.find(messageRef);
+        if (it == this->m_taken.end())
+            continue;
+        const QPair<QPointer<XenConnection>, QVariantMap> taken = it.value();
+        this->m_taken.erase(it);
+        if (!taken.first.isNull())
+            this->Enqueue(taken.first, taken.second);
+    }
+}
+
+int MessageAlertLoader::InFlightCount() const
+{
+    return this->m_inFlight.size();
+}
+
+void MessageAlertLoader::scheduleFlush()
+{
+    // Wait for the rest of the event batch so the whole backlog is sorted at once
+    if (this->m_flushScheduled)
+        return;
+    this->m_flushScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { this->flush(); }, Qt::QueuedConnection);
+}
+
+void MessageAlertLoader::flush()
+{
+    this->m_flushScheduled = false;
+
+    QList<QPair<XenConnection*, QVariantMap>> batch;
+    for (auto queueIt = this->m_queues.begin(); queueIt != this->m_queues.end();)
+    {
+        ConnectionQueue& queue = queueIt.value();
+        if (queue.connection.isNull())
+        {
+            for (auto it = queue.pending.constBegin(); it != queue.pending.constEnd(); ++it)
+                this->m_pendingRefs.remove(it.key().second);
+            queueIt = this->m_queues.erase(queueIt);
+            continue;
+        }
+
+        int taken = 0;
+        auto it = queue.pending.begin();
+        while (it != queue.pending.end())
+        {
+            const qint64 timestamp = -it.key().first;
+            const bool withinShown = queue.anyLoaded && timestamp > queue.oldestLoaded;
+            if (!withinShown && queue.loaded + taken >= queue.requested)
+                break;
+
+            batch.append(qMakePair(queueIt.key(), it.value()));
+            this->m_inFlight.insert(it.key().second, queue.connection);
+            this->m_pendingRefs.remove(it.key().second);
+            if (!queue.anyLoaded || timestamp < queue.oldestLoaded)
+                queue.oldestLoaded = timestamp;
+            queue.anyLoaded = true;
+            ++taken;
+            it = queue.pending.erase(it);
+        }
+        queue.loaded += taken;
+        ++queueIt;
+    }
+
+    if (batch.isEmpty())
+        return;
+
+    // Alerts are plain QObjects without a parent, so the worker can hand them
+    // over to this thread before they are queued back
+    QThread* target = this->thread();
+    QThreadPool::globalInstance()->start([this, batch, target]()
+    {
+        QList<Alert*> alerts;
+        alerts.reserve(batch.size());
+        for (const auto& message : batch)
+        {
+            Alert* alert = MessageAlert::ParseMessage(message.first, message.second);
+            if (!alert)
+                continue;
+            alert->moveToThread(target);
+            alerts.append(alert);
+        }
+        QMetaObject::invokeMethod(this, [this, alerts]() { this->deliver(alerts); }, Qt::QueuedConnection);
+    });
+}
+
+void MessageAlertLoader::deliver(const QList<Alert*>& alerts)
+{
+    QList<Alert*> accepted;
+    accepted.reserve(alerts.size());
+    for (Alert* alert : alerts)
+    {
+        // Dropped if the message was destroyed or its connection went away meanwhile
+        auto it = this->m_inFlight.find(alert->GetOpaqueRef());
+        if (it == this->m_inFlight.end() || it.value().isNull())
+        {
+            if (it != this->m_inFlight.end())
+                this->m_inFlight.erase(it);
+            delete alert;
+            continue;
+        }
+        this->m_inFlight.erase(it);
+        accepted.append(alert);
+    }
+
+    if (!accepted.isEmpty())
+        AlertManager::instance()->AddAlerts(accepted);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MESSAGEALERTLOADER_H
+#define MESSAGEALERTLOADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QPointer>
+#include <QStringList>
+#include <QVariantMap>
+#include "../xenlib_global.h"
+
+class XenConnection;
+
+namespace XenLib
+{
+class Alert;
+
+/**
+ * Builds MessageAlerts from XenAPI message records off the GUI thread.
+ *
+ * The first event.from of a pool with years of history delivers every
+ * message at once. Messages passed to Enqueue() are collected until control
+ * returns to the event loop, ordered newest first and parsed on the global
+ * thread pool; the resulting alerts reach AlertManager as one AddAlerts()
+ * batch per flush. Per connection only the newest PAGE_SIZE messages are
+ * parsed up front, older ones stay raw until FetchMore() asks for the next
+ * page (the alert list does when it is scrolled to the end). Messages newer
+ * than the oldest alert already shown for their connection, such as ones
+ * arriving later, are parsed straight away. Dismiss All takes the unparsed
+ * messages over with TakePending() and destroys them without building alerts.
+ */
+class XENLIB_EXPORT MessageAlertLoader : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const int PAGE_SIZE = 250;
+
+        static MessageAlertLoader* instance();
+
+        /** @brief Queue @p messageData for alert creation; messages already known are ignored. */
+        void Enqueue(XenConnection* connection, const QVariantMap& messageData);
+
+        /** @brief Forget a message that was destroyed before its alert was created. */
+        void Remove(const QString& messageRef);
+
+        /** @brief Materialize the next page of older messages. */
+        void FetchMore();
+
+        /** @brief Messages queued but not yet handed to the thread pool. */
+        int PendingCount() const;
+
+        /**
+         * @brief Hand over every queued message for dismissal, grouped per connection.
+         *
+         * The messages are held back until their deletion arrives (Remove())
+         * or Restore() puts them back in the queue; Enqueue() ignores them
+         * meanwhile.
+         */
+        QHash<XenConnection*, QStringList> TakePending();
+
+        /** @brief Queue taken messages again, e.g. when they could not be destroyed; other refs are ignored. */
+        void Restore(const QStringList& messageRefs);
+
+        /** @brief Messages being parsed on the thread pool right now. */
+        int InFlightCount() const;
+
+    private:
+        // Newest first: the negated timestamp sorts ascending, the ref breaks ties
+        using PendingKey = QPair<qint64, QString>;
+
+        struct ConnectionQueue
+        {
+            QPointer<XenConnection> connection;
+            QMap<PendingKey, QVariantMap> pending;
+            qint64 oldestLoaded = 0;
+            bool anyLoaded = false;
+            int loaded = 0;
+            int requested = PAGE_SIZE;
+        };
+
+        explicit MessageAlertLoader(QObject* parent = nullptr);
+
+        static PendingKey pendingKey(const QString& messageRef, const QVariantMap& messageData);
+        void scheduleFlush();
+        void flush();
+        void deliver(const QList<Alert*>& alerts);
+
+        static MessageAlertLoader* s_instance;
+        QHash<XenConnection*, ConnectionQueue> m_queues;
+        QHash<QString, QPair<XenConnection*, PendingKey>> m_pendingRefs;
+        QHash<QString, QPointer<XenConnection>> m_inFlight;
+        QHash<QString, QPair<QPointer<XenConnection>, QVariantMap>> m_taken;
+        bool m_flushScheduled = false;
+};
+} // XenLib
+
+#endif // MESSAGEALERTLOADER_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "clusterinflater.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <cstring>
+#ifndef XENADMIN_NO_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    // Kept separate from the global pool, which runs the operations that
+    // call in here and could otherwise be exhausted by them
+    QThreadPool* inflatePool()
+    {
+        static QThreadPool* pool = []() {
+            QThreadPool* p = new QThreadPool();
+            p->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+            return p;
+        }();
+        return pool;
+    }
+}
+
+bool ClusterInflater::inflateOne(const CompressedCluster& cluster, Format format, QString& errorOut)
+{
+#ifdef XENADMIN_NO_ZLIB
+    Q_UNUSED(cluster);
+    Q_UNUSED(format);
+    errorOut = "Compressed disk images are not supported in this build (zlib not available)";
+    return false;
+#else
+    z_stream strm {};
+    if (inflateInit2(&strm, format == Format::RawDeflate ? -15 : 15) != Z_OK)
+    {
+        errorOut = "Failed to initialise decompressor";
+        return false;
+    }
+
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(cluster.input.constData()));
+    strm.avail_in = static_cast<uInt>(cluster.input.size());
+    strm.next_out = reinterpret_cast<Bytef*>(cluster.output);
+    strm.avail_out = static_cast<uInt>(cluster.outputSize);
+
+    const int ret = inflate(&strm, Z_FINISH);
+    const bool full = strm.avail_out == 0;
+    inflateEnd(&strm);
+
+    // The stored size is rounded up to whole sectors, so the stream may end
+    // before the input does; what matters is a complete cluster of output.
+    if (ret == Z_STREAM_END || (full && (ret == Z_OK || ret == Z_BUF_ERROR)))
+    {
+        if (!full)
+            std::memset(strm.next_out, 0, strm.avail_out);
+        return true;
+    }
+
+    errorOut = QString("Corrupt compressed cluster (%1)").arg(QString::fromLatin1(strm.msg ? strm.msg : "inflate failed"));
+    return false;
+#endif
+}
+
+bool ClusterInflater::InflateAll(QVector<CompressedCluster>& clusters, Format format, QString& errorOut)
+{
+    if (clusters.isEmpty())
+        return true;
+    if (clusters.size() == 1)
+        return inflateOne(clusters.first(), format, errorOut);
+
+    QThreadPool* pool = inflatePool();
+    const int workers = qMin(clusters.size(), pool->maxThreadCount());
+    std::atomic<int> next { 0 };
+    std::atomic<bool> failed { false };
+    QMutex errorMutex;
+    QString firstError;
+    QSemaphore done;
+
+    for (int w = 0; w < workers; ++w)
+    {
+        pool->start([&]() {
+            for (;;)
+            {
+                const int index = next.fetch_add(1);
+                if (index >= clusters.size() || failed.load())
+                    break;
+
+                QString error;
+                if (!inflateOne(clusters.at(index), format, error))
+                {
+                    QMutexLocker locker(&errorMutex);
+                    if (!failed.exchange(true))
+                        firstError = error;
+                }
+            }
+            done.release();
+        });
+    }
+    done.acquire(workers);
+
+    if (failed.load())
+    {
+        errorOut = firstError;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLUSTERINFLATER_H
+#define CLUSTERINFLATER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief One compressed cluster/grain waiting to be inflated.
+ */
+struct CompressedCluster
+{
+    QByteArray input;       ///< Compressed bytes as stored (may carry trailing slack)
+    char* output = nullptr; ///< Destination for the decompressed cluster
+    int outputSize = 0;     ///< Decompressed cluster size
+};
+
+/**
+ * @brief Inflates batches of compressed clusters on a private thread pool.
+ *
+ * Image readers gather all compressed clusters touched by one read, do the
+ * file I/O themselves and hand the batch here, so decompression of a block
+ * spreads over the available cores while memory stays bounded by the read.
+ */
+class ClusterInflater
+{
+    public:
+        enum class Format
+        {
+            RawDeflate, ///< qcow2: deflate without header
+            Zlib        ///< VMDK: RFC 1950 zlib stream
+        };
+
+        /**
+         * @brief Inflate every cluster of @p clusters into its output buffer.
+         * @return false if any cluster is corrupt (see @p errorOut)
+         */
+        static bool InflateAll(QVector<CompressedCluster>& clusters, Format format, QString& errorOut);
+
+    private:
+        ClusterInflater() = delete;
+        static bool inflateOne(const CompressedCluster& cluster, Format format, QString& errorOut);
+};
+
+#endif // CLUSTERINFLATER_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "diskimagereader.h"
+#include "qcow2imagereader.h"
+#include "rawimagereader.h"
+#include "vhdimagereader.h"
+#include "vmdkimagereader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+#include <memory>
+
+DiskImageReader* DiskImageReader::Create(const QString& path, qint64 offset, qint64 length, QString& errorOut)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(path, file.errorString());
+        return nullptr;
+    }
+    if (length < 0)
+        length = file.size() - offset;
+    if (offset < 0 || length < 0 || offset + length > file.size())
+    {
+        errorOut = QString("Disk image range lies outside %1").arg(path);
+        return nullptr;
+    }
+
+    std::unique_ptr<DiskImageReader> reader;
+    if (Qcow2ImageReader::Probe(file, offset, length))
+    {
+        reader.reset(new Qcow2ImageReader(path, offset, length));
+    } else if (VmdkImageReader::Probe(file, offset, length))
+    {
+        reader.reset(new VmdkImageReader(path, offset, length));
+    } else if (VmdkImageReader::ProbeDescriptor(file, offset, length))
+    {
+        // A descriptor only points at the extent holding the data
+        file.seek(offset);
+        VmdkExtent extent;
+        if (!VmdkImageReader::ParseDescriptor(file.read(length), QFileInfo(path).absolutePath(), extent, errorOut))
+            return nullptr;
+        if (extent.type == QLatin1String("SPARSE"))
+            return Create(extent.fileName, 0, -1, errorOut);
+
+        // FLAT/VMFS: raw data, taken as-is without probing its content
+        const qint64 flatLength = extent.sectors * 512;
+        if (QFileInfo(extent.fileName).size() < extent.offset + flatLength)
+        {
+            errorOut = QString("VMDK extent %1 is missing or shorter than its descriptor says").arg(extent.fileName);
+            return nullptr;
+        }
+        reader.reset(new RawImageReader(extent.fileName, extent.offset, flatLength));
+    } else if (VhdImageReader::Probe(file, offset, length))
+    {
+        reader.reset(new VhdImageReader(path, offset, length));
+    } else
+    {
+        reader.reset(new RawImageReader(path, offset, length));
+    }
+    file.close();
+
+    if (!reader->Open(errorOut))
+        return nullptr;
+    return reader.release();
+}
+
+bool DiskImageReader::IsZero(const char* data, qint64 length)
+{
+    // Check a short head explicitly, then compare the buffer with itself
+    // shifted by that head: equal only if every byte matches the zero head.
+    // memcmp is vectorised by the C library, so this runs at memory speed
+    // without hand-written SIMD.
+    static const char zeros[16] = {};
+    if (length <= 16)
+        return length <= 0 || std::memcmp(data, zeros, static_cast<size_t>(length)) == 0;
+    if (std::memcmp(data, zeros, 16) != 0)
+        return false;
+    return std::memcmp(data, data + 16, static_cast<size_t>(length - 16)) == 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DISKIMAGEREADER_H
+#define DISKIMAGEREADER_H
+
+#include <QList>
+#include <QString>
+
+/**
+ * @brief A byte range of a virtual disk.
+ */
+struct DiskExtent
+{
+    qint64 offset = 0;
+    qint64 length = 0;
+};
+
+/**
+ * @brief Random-access reader presenting a disk image as a flat virtual disk.
+ *
+ * Implementations understand one container format each and expose where the
+ * disk actually holds data, so uploads can skip unallocated ranges instead
+ * of pushing the full virtual size (see SparseVhdStream).
+ *
+ * An image may be a whole file or a byte range inside a larger file (a disk
+ * member of an OVA archive).
+ */
+class DiskImageReader
+{
+    public:
+        virtual ~DiskImageReader() = default;
+
+        /** @brief Short format name for logs and errors ("raw", "vhd", ...). */
+        virtual QString FormatName() const = 0;
+
+        /** @brief Parse the image. Must succeed before any other call. */
+        virtual bool Open(QString& errorOut) = 0;
+
+        /** @brief Size of the virtual disk in bytes. */
+        virtual qint64 VirtualSize() const = 0;
+
+        /**
+         * @brief Ranges of the virtual disk that may contain data.
+         *
+         * Sorted and non-overlapping. Everything outside reads as zeros; ranges
+         * inside may still be zero-filled, callers check the data itself.
+         */
+        virtual QList<DiskExtent> AllocatedExtents() const = 0;
+
+        /**
+         * @brief Whether AllocatedExtents() comes from the image's own allocation
+         * table (VHD BAT, qcow2 L2, VMDK grain tables) rather than from the host
+         * file system.
+         *
+         * Allocated-but-zero ranges are rare in such maps and finding them would
+         * mean reading (and for compressed images inflating) the data twice, so
+         * SparseVhdStream takes them as they are.
+         */
+        virtual bool HasExactAllocationMap() const { return false; }
+
+        /**
+         * @brief Read @p length bytes of the virtual disk at @p offset.
+         *
+         * Unallocated areas are returned zero-filled. Reads beyond the end of
+         * the disk fail. Not thread-safe; use one reader per thread.
+         */
+        virtual bool Read(qint64 offset, char* data, qint64 length, QString& errorOut) = 0;
+
+        /**
+         * @brief Detect the format of the image at @p path and open a reader for it.
+         * @param path    Image file
+         * @param offset  Start of the image inside @p path
+         * @param length  Image length, or -1 for "to the end of the file"
+         * @return New opened reader (caller owns), or nullptr with @p errorOut set
+         */
+        static DiskImageReader* Create(const QString& path, qint64 offset, qint64 length, QString& errorOut);
+
+        /** @brief Whether @p length bytes at @p data are all zero. */
+        static bool IsZero(const char* data, qint64 length);
+};
+
+#endif // DISKIMAGEREADER_H
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "qcow2imagereader.h"
+#include "clusterinflater.h"
+
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const quint32 QCOW2_MAGIC = 0x514649fb;   // "QFI\xfb"
+    const quint64 L1_OFFSET_MASK = 0x00fffffffffffe00ull;
+    const quint64 L2_OFFSET_MASK = 0x00fffffffffffe00ull;
+    const quint64 L2_COMPRESSED = 1ull << 62;
+    const quint64 L2_ZERO = 1ull;
+
+    // Incompatible feature bits we cannot honour
+    const quint64 INCOMPAT_CORRUPT = 1ull << 1;
+    const quint64 INCOMPAT_EXTERNAL_DATA = 1ull << 2;
+    const quint64 INCOMPAT_EXTENDED_L2 = 1ull << 4;
+
+    // qemu refuses L1 tables larger than this (QCOW_MAX_L1_SIZE)
+    const qint64 MAX_L1_BYTES = 32 * 1024 * 1024;
+
+    quint32 be32(const char* p) { return qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(p)); }
+    quint64 be64(const char* p) { return qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(p)); }
+}
+
+Qcow2ImageReader::Qcow2ImageReader(const QString& path, qint64 offset, qint64 length)
+    : m_path(path), m_offset(offset), m_length(length)
+{
+}
+
+bool Qcow2ImageReader::Probe(QFile& file, qint64 offset, qint64 length)
+{
+    if (length < 72 || !file.seek(offset))
+        return false;
+    const QByteArray magic = file.read(4);
+    return magic.size() == 4 && be32(magic.constData()) == QCOW2_MAGIC;
+}
+
+bool Qcow2ImageReader::readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut)
+{
+    if (fileOffset < 0 || fileOffset + length > this->m_length)
+    {
+        errorOut = QString("qcow2 structure lies outside %1").arg(this->m_path);
+        return false;
+    }
+    if (!this->m_file.seek(this->m_offset + fileOffset) || this->m_file.read(data, length) != length)
+    {
+        errorOut = QString("Read error in %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool Qcow2ImageReader::Open(QString& errorOut)
+{
+    this->m_file.setFileName(this->m_path);
+    if (!this->m_file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+
+    char header[112] = {};
+    const qint64 headerBytes = qMin<qint64>(sizeof(header), this->m_length);
+    if (!this->readAt(0, header, headerBytes, errorOut))
+        return false;
+    if (be32(header) != QCOW2_MAGIC)
+    {
+        errorOut = QString("%1 is not a qcow2 image").arg(this->m_path);
+        return false;
+    }
+
+    const quint32 version = be32(header + 4);
+    if (version != 2 && version != 3)
+    {
+        errorOut = QString("Unsupported qcow2 version %1 in %2").arg(version).arg(this->m_path);
+        return false;
+    }
+    if (be64(header + 8) != 0)
+    {
+        errorOut = QString("%1 has a backing file; flatten it (qemu-img convert) before importing").arg(this->m_path);
+        return false;
+    }
+    if (be32(header + 32) != 0)
+    {
+        errorOut = QString("Encrypted qcow2 images are not supported (%1)").arg(this->m_path);
+        return false;
+    }
+
+    if (version == 3)
+    {
+        const quint64 incompatible = be64(header + 72);
+        if (incompatible & (INCOMPAT_CORRUPT | INCOMPAT_EXTERNAL_DATA | INCOMPAT_EXTENDED_L2))
+        {
+            errorOut = QString("qcow2 image %1 uses features that cannot be imported (flags 0x%2)")
+                           .arg(this->m_path).arg(incompatible, 0, 16);
+            return false;
+        }
+        const quint32 headerLength = be32(header + 100);
+        if (headerLength > 104 && static_cast<uchar>(header[104]) != 0)
+        {
+            errorOut = QString("qcow2 image %1 uses a compression type other than zlib").arg(this->m_path);
+            return false;
+        }
+        this->m_zeroFlag = true;
+    }
+
+    this->m_clusterBits = static_cast<int>(be32(header + 20));
+    if (this->m_clusterBits < 9 || this->m_clusterBits > 21)
+    {
+        errorOut = QString("Corrupt qcow2 header in %1").arg(this->m_path);
+        return false;
+    }
+    this->m_clusterSize = 1LL << this->m_clusterBits;
+    this->m_l2Entries = static_cast<int>(this->m_clusterSize / 8);
+    this->m_virtualSize = static_cast<qint64>(be64(header + 24));
+    if (this->m_virtualSize <= 0 || this->m_virtualSize > std::numeric_limits<qint64>::max() - this->m_clusterSize)
+    {
+        errorOut = QString("Corrupt qcow2 header in %1").arg(this->m_path);
+        return false;
+    }
+
+    const quint32 l1Size = be32(header + 36);
+    const qint64 l1Offset = static_cast<qint64>(be64(header + 40));
+    const qint64 clusters = (this->m_virtualSize + this->m_clusterSize - 1) / this->m_clusterSize;
+    const qint64 l1Needed = (clusters + this->m_l2Entries - 1) / this->m_l2Entries;
+    if (static_cast<qint64>(l1Size) != l1Needed || static_cast<qint64>(l1Size) * 8 > MAX_L1_BYTES)
+    {
+        errorOut = QString("Corrupt qcow2 L1 table in %1").arg(this->m_path);
+        return false;
+    }
+
+    QByteArray l1(static_cast<int>(l1Size) * 8, Qt::Uninitialized);
+    if (!this->readAt(l1Offset, l1.data(), l1.size(), errorOut))
+        return false;
+    this->m_l1.resize(static_cast<int>(l1Size));
+    for (quint32 i = 0; i < l1Size; ++i)
+        this->m_l1[static_cast<int>(i)] = be64(l1.constData() + i * 8);
+
+    // Allocation map: every cluster with a data or compressed entry
+    this->m_extents.clear();
+    for (int i = 0; i < this->m_l1.size(); ++i)
+    {
+        const qint64 l2Offset = static_cast<qint64>(this->m_l1.at(i) & L1_OFFSET_MASK);
+        if (l2Offset == 0)
+            continue;
+        const QByteArray* table = this->l2Table(l2Offset, errorOut);
+        if (!table)
+            return false;
+
+        for (int j = 0; j < this->m_l2Entries; ++j)
+        {
+            const qint64 cluster = static_cast<qint64>(i) * this->m_l2Entries + j;
+            if (cluster >= clusters)
+                break;
+            const quint64 entry = be64(table->constData() + j * 8);
+            const bool compressed = entry & L2_COMPRESSED;
+            if (!compressed && ((this->m_zeroFlag && (entry & L2_ZERO)) || (entry & L2_OFFSET_MASK) == 0))
+                continue;
+
+            const qint64 start = cluster * this->m_clusterSize;
+            const qint64 len = qMin(this->m_clusterSize, this->m_virtualSize - start);
+            if (!this->m_extents.isEmpty() && this->m_extents.last().offset + this->m_extents.last().length == start)
+                this->m_extents.last().length += len;
+            else
+                this->m_extents.append({ start, len });
+        }
+    }
+    return true;
+}
+
+const QByteArray* Qcow2ImageReader::l2Table(qint64 l2Offset, QString& errorOut)
+{
+    auto it = this->m_l2Cache.constFind(l2Offset);
+    if (it != this->m_l2Cache.constEnd())
+        return &it.value();
+
+    if (this->m_l2Cache.size() >= L2_CACHE_TABLES)
+        this->m_l2Cache.clear();
+
+    QByteArray table(static_cast<int>(this->m_clusterSize), Qt::Uninitialized);
+    if (!this->readAt(l2Offset, table.data(), table.size(), errorOut))
+        return nullptr;
+    return &this->m_l2Cache.insert(l2Offset, table).value();
+}
+
+bool Qcow2ImageReader::l2Entry(qint64 clusterIndex, quint64& entryOut, QString& errorOut)
+{
+    const qint64 l1Index = clusterIndex / this->m_l2Entries;
+    const qint64 l2Offset = static_cast<qint64>(this->m_l1.value(static_cast<int>(l1Index)) & L1_OFFSET_MASK);
+    if (l2Offset == 0)
+    {
+        entryOut = 0;
+        return true;
+    }
+
+    const QByteArray* table = this->l2Table(l2Offset, errorOut);
+    if (!table)
+        return false;
+    entryOut = be64(table->constData() + (clusterIndex % this->m_l2Entries) * 8);
+    return true;
+}
+
+bool Qcow2ImageReader::Read(qint64 offset, char* data, qint64 length, QString& errorOut)
+{
+    if (offset < 0 || offset + length > this->m_virtualSize)
+    {
+        errorOut = QString("Read beyond the end of %1").arg(this->m_path);
+        return false;
+    }
+
+    // Compressed clusters are collected and inflated together at the end;
+    // partial ones go through a scratch buffer and are copied afterwards.
+    QVector<CompressedCluster> compressed;
+    struct PartialCopy { int scratch; qint64 inCluster; char* dest; qint64 length; };
+    QVector<QByteArray> scratch;
+    QVector<PartialCopy> partials;
+
+    const int compressedSizeShift = 62 - (this->m_clusterBits - 8);
+    const quint64 compressedOffsetMask = (1ull << compressedSizeShift) - 1;
+
+    while (length > 0)
+    {
+        const qint64 cluster = offset >> this->m_clusterBits;
+        const qint64 inCluster = offset & (this->m_clusterSize - 1);
+        const qint64 chunk = qMin(length, this->m_clusterSize - inCluster);
+
+        quint64 entry = 0;
+        if (!this->l2Entry(cluster, entry, errorOut))
+            return false;
+
+        if (entry & L2_COMPRESSED)
+        {
+            const qint64 hostOffset = static_cast<qint64>(entry & compressedOffsetMask);
+            const qint64 sectors = static_cast<qint64>((entry & ~L2_COMPRESSED & ~(1ull << 63)) >> compressedSizeShift) + 1;
+            const qint64 storedSize = qMin(sectors * 512 - (hostOffset & 511), this->m_length - hostOffset);
+
+            CompressedCluster job;
+            job.input.resize(static_cast<int>(storedSize));
+            if (!this->readAt(hostOffset, job.input.data(), storedSize, errorOut))
+                return false;
+            job.outputSize = static_cast<int>(this->m_clusterSize);
+            if (inCluster == 0 && chunk == this->m_clusterSize)
+            {
+                job.output = data;
+            } else
+            {
+                // Only the first and last cluster of a read can be partial
+                scratch.append(QByteArray(static_cast<int>(this->m_clusterSize), Qt::Uninitialized));
+                job.output = scratch.last().data();
+                partials.append({ static_cast<int>(scratch.size() - 1), inCluster, data, chunk });
+            }
+            compressed.append(job);
+        } else if ((this->m_zeroFlag && (entry & L2_ZERO)) || (entry & L2_OFFSET_MASK) == 0)
+        {
+            std::memset(data, 0, static_cast<size_t>(chunk));
+        } else
+        {
+            const qint64 hostOffset = static_cast<qint64>(entry & L2_OFFSET_MASK);
+            if (!this->readAt(hostOffset + inCluster, data, chunk, errorOut))
+                return false;
+        }
+
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    if (!ClusterInflater::InflateAll(compressed, ClusterInflater::Format::RawDeflate, errorOut))
+    {
+        errorOut = QString("%1 in %2").arg(errorOut, this->m_path);
+        return false;
+    }
+    for (const PartialCopy& copy : partials)
+        std::memcpy(copy.dest, scratch.at(copy.scratch).constData() + copy.inCluster, static_cast<size_t>(copy.length));
+    return true;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef QCOW2IMAGEREADER_H
+#define QCOW2IMAGEREADER_H
+
+#include "diskimagereader.h"
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+/**
+ * @brief Reader for qcow2 images (versions 2 and 3).
+ *
+ * Follows the L1/L2 tables; compressed clusters are inflated through
+ * ClusterInflater, several at a time. Images with a backing file,
+ * encryption, an external data file, extended L2 entries or a compression
+ * type other than zlib are rejected.
+ */
+class Qcow2ImageReader : public DiskImageReader
+{
+    public:
+        Qcow2ImageReader(const QString& path, qint64 offset, qint64 length);
+
+        /** @brief Whether the range of @p file starts with the qcow2 magic. */
+        static bool Probe(QFile& file, qint64 offset, qint64 length);
+
+        QString FormatName() const override { return QStringLiteral("qcow2"); }
+        bool Open(QString& errorOut) override;
+        qint64 VirtualSize() const override { return this->m_virtualSize; }
+        QList<DiskExtent> AllocatedExtents() const override { return this->m_extents; }
+        bool HasExactAllocationMap() const override { return true; }
+        bool Read(qint64 offset, char* data, qint64 length, QString& errorOut) override;
+
+    private:
+        static const int L2_CACHE_TABLES = 32;
+
+        bool readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut);
+        bool l2Entry(qint64 clusterIndex, quint64& entryOut, QString& errorOut);
+        const QByteArray* l2Table(qint64 l2Offset, QString& errorOut);
+
+        QString m_path;
+        qint64 m_offset;
+        qint64 m_length;
+        QFile m_file;
+
+        int m_clusterBits = 16;
+        qint64 m_clusterSize = 65536;
+        qint64 m_virtualSize = 0;
+        int m_l2Entries = 0;
+        bool m_zeroFlag = false;     // v3: bit 0 of an L2 entry marks an all-zero cluster
+        QVector<quint64> m_l1;
+        QHash<qint64, QByteArray> m_l2Cache;
+        QList<DiskExtent> m_extents;
+};
+
+#endif // QCOW2IMAGEREADER_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rawimagereader.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+RawImageReader::RawImageReader(const QString& path, qint64 offset, qint64 length)
+    : m_path(path), m_offset(offset), m_length(length)
+{
+}
+
+bool RawImageReader::Open(QString& errorOut)
+{
+    this->m_file.setFileName(this->m_path);
+    if (!this->m_file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+
+    this->m_extents = DataExtents(this->m_file, this->m_offset, this->m_length);
+    return true;
+}
+
+bool RawImageReader::Read(qint64 offset, char* data, qint64 length, QString& errorOut)
+{
+    if (offset < 0 || offset + length > this->m_length)
+    {
+        errorOut = QString("Read beyond the end of %1").arg(this->m_path);
+        return false;
+    }
+    if (!this->m_file.seek(this->m_offset + offset) || this->m_file.read(data, length) != length)
+    {
+        errorOut = QString("Read error in %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QList<DiskExtent> RawImageReader::DataExtents(QFile& file, qint64 offset, qint64 length)
+{
+    QList<DiskExtent> extents;
+    if (length <= 0)
+        return extents;
+
+#if defined(Q_OS_UNIX) && defined(SEEK_DATA) && defined(SEEK_HOLE)
+    const int fd = file.handle();
+    const qint64 end = offset + length;
+    qint64 pos = offset;
+    while (fd >= 0 && pos < end)
+    {
+        const off_t dataStart = ::lseek(fd, static_cast<off_t>(pos), SEEK_DATA);
+        if (dataStart < 0)
+        {
+            // ENXIO: no data after pos. Anything else: the file system
+            // cannot tell, so treat the rest as data.
+            if (errno != ENXIO)
+                extents.append({ pos - offset, end - pos });
+            break;
+        }
+        if (dataStart >= end)
+            break;
+
+        off_t holeStart = ::lseek(fd, dataStart, SEEK_HOLE);
+        if (holeStart < 0 || holeStart > end)
+            holeStart = static_cast<off_t>(end);
+
+        extents.append({ static_cast<qint64>(dataStart) - offset,
+                         static_cast<qint64>(holeStart - dataStart) });
+        pos = holeStart;
+    }
+
+    // QFile keeps its own position; make sure the next read seeks explicitly
+    file.seek(offset);
+    if (fd >= 0)
+        return extents;
+#else
+    Q_UNUSED(file);
+#endif
+
+    extents.append({ 0, length });
+    return extents;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RAWIMAGEREADER_H
+#define RAWIMAGEREADER_H
+
+#include "diskimagereader.h"
+#include <QFile>
+
+/**
+ * @brief Reader for raw (flat) disk images.
+ *
+ * Allocation comes from the file system: on platforms with SEEK_DATA /
+ * SEEK_HOLE the holes of a sparse file are reported as unallocated, so a
+ * thin image is read only where it holds data. Elsewhere the whole range
+ * counts as allocated.
+ */
+class RawImageReader : public DiskImageReader
+{
+    public:
+        RawImageReader(const QString& path, qint64 offset, qint64 length);
+
+        QString FormatName() const override { return QStringLiteral("raw"); }
+        bool Open(QString& errorOut) override;
+        qint64 VirtualSize() const override { return this->m_length; }
+        QList<DiskExtent> AllocatedExtents() const override { return this->m_extents; }
+        bool Read(qint64 offset, char* data, qint64 length, QString& errorOut) override;
+
+        /**
+         * @brief Data ranges of [offset, offset + length) of @p file, relative to @p offset.
+         *
+         * Shared with readers whose payload is stored raw (fixed VHD).
+         */
+        static QList<DiskExtent> DataExtents(QFile& file, qint64 offset, qint64 length);
+
+    private:
+        QString m_path;
+        qint64 m_offset;
+        qint64 m_length;
+        QFile m_file;
+        QList<DiskExtent> m_extents;
+};
+
+#endif // RAWIMAGEREADER_H
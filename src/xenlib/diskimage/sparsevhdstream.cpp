@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sparsevhdstream.h"
+#include "diskimagereader.h"
+#include "vhdformat.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+SparseVhdStream::SparseVhdStream(DiskImageReader* reader, QObject* parent)
+    : QIODevice(parent), m_reader(reader), m_blockSize(VhdFormat::DEFAULT_BLOCK_SIZE)
+{
+}
+
+bool SparseVhdStream::Prepare(QString& errorOut, CancelCallback cancelled)
+{
+    const qint64 sourceSize = this->m_reader->VirtualSize();
+    this->m_virtualSize = (sourceSize + VhdFormat::SECTOR_SIZE - 1) / VhdFormat::SECTOR_SIZE * VhdFormat::SECTOR_SIZE;
+    this->m_blockCount = static_cast<int>((this->m_virtualSize + this->m_blockSize - 1) / this->m_blockSize);
+    this->m_dataBlocks.clear();
+
+    // Candidate blocks are those touched by an allocated extent. When the map
+    // comes from the file system (raw files, fixed VHDs) each one is read and
+    // kept only if it is not all zeros; data blocks are then read a second time
+    // to be sent, so the scan costs one extra sequential read of the allocated
+    // bytes of an uncompressed file. Maps taken from the image's own tables are
+    // trusted as they are, so compressed clusters are inflated only once.
+    const bool scan = !this->m_reader->HasExactAllocationMap();
+    QByteArray buffer(scan ? static_cast<int>(this->m_blockSize) : 0, Qt::Uninitialized);
+    const QList<DiskExtent> extents = this->m_reader->AllocatedExtents();
+    qint64 scannedBytes = 0;
+    int lastBlock = -1;
+    for (const DiskExtent& extent : extents)
+    {
+        if (extent.length <= 0)
+            continue;
+        const int first = static_cast<int>(extent.offset / this->m_blockSize);
+        const int last = static_cast<int>((extent.offset + extent.length - 1) / this->m_blockSize);
+        for (int block = qMax(first, lastBlock + 1); block <= last && block < this->m_blockCount; ++block)
+        {
+            if (cancelled && cancelled())
+            {
+                errorOut = "Operation cancelled by user";
+                return false;
+            }
+
+            lastBlock = block;
+            if (!scan)
+            {
+                this->m_dataBlocks.append(static_cast<quint32>(block));
+                continue;
+            }
+
+            const qint64 start = static_cast<qint64>(block) * this->m_blockSize;
+            const qint64 length = qMin<qint64>(this->m_blockSize, sourceSize - start);
+            if (!this->m_reader->Read(start, buffer.data(), length, errorOut))
+                return false;
+            scannedBytes += length;
+            if (!DiskImageReader::IsZero(buffer.constData(), length))
+                this->m_dataBlocks.append(static_cast<quint32>(block));
+        }
+    }
+
+    const qint64 batBytes = (static_cast<qint64>(this->m_blockCount) * 4 + VhdFormat::SECTOR_SIZE - 1)
+                            / VhdFormat::SECTOR_SIZE * VhdFormat::SECTOR_SIZE;
+    this->m_contentSize = VhdFormat::FOOTER_SIZE + VhdFormat::DYNAMIC_HEADER_SIZE + batBytes
+                          + static_cast<qint64>(this->m_dataBlocks.size()) * (VhdFormat::SECTOR_SIZE + this->m_blockSize)
+                          + VhdFormat::FOOTER_SIZE;
+    this->m_footer = VhdFormat::BuildFooter(this->m_virtualSize, VhdFormat::DISK_TYPE_DYNAMIC, VhdFormat::FOOTER_SIZE);
+
+    qInfo() << "SparseVhdStream:" << this->m_reader->FormatName() << "image,"
+            << this->m_dataBlocks.size() << "of" << this->m_blockCount << "blocks carry data;"
+            << "scanned" << scannedBytes << "bytes, will send" << this->m_contentSize << "bytes";
+    return true;
+}
+
+bool SparseVhdStream::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || this->m_contentSize < 0)
+        return false;
+
+    this->m_nextSegment = 0;
+    this->m_segment.clear();
+    this->m_segmentPos = 0;
+    this->m_finished = false;
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+bool SparseVhdStream::atEnd() const
+{
+    return this->m_finished;
+}
+
+qint64 SparseVhdStream::writeData(const char*, qint64)
+{
+    return -1;
+}
+
+bool SparseVhdStream::fillNextSegment()
+{
+    const int segment = this->m_nextSegment++;
+    const int dataBlocks = this->m_dataBlocks.size();
+    this->m_segmentPos = 0;
+
+    if (segment == 0)
+    {
+        // Footer copy, dynamic header, BAT
+        const qint64 tableOffset = VhdFormat::FOOTER_SIZE + VhdFormat::DYNAMIC_HEADER_SIZE;
+        const int batBytes = (this->m_blockCount * 4 + VhdFormat::SECTOR_SIZE - 1)
+                             / VhdFormat::SECTOR_SIZE * VhdFormat::SECTOR_SIZE;
+
+        QByteArray bat(batBytes, '\xFF');
+        qint64 nextSector = (tableOffset + batBytes) / VhdFormat::SECTOR_SIZE;
+        const qint64 sectorsPerEntry = (VhdFormat::SECTOR_SIZE + this->m_blockSize) / VhdFormat::SECTOR_SIZE;
+        for (quint32 block : this->m_dataBlocks)
+        {
+            qToBigEndian<quint32>(static_cast<quint32>(nextSector), reinterpret_cast<uchar*>(bat.data() + block * 4));
+            nextSector += sectorsPerEntry;
+        }
+
+        this->m_segment = this->m_footer
+                          + VhdFormat::BuildDynamicHeader(tableOffset, static_cast<quint32>(this->m_blockCount), this->m_blockSize)
+                          + bat;
+        return true;
+    }
+
+    if (segment <= dataBlocks)
+    {
+        // Sector bitmap (every sector present) followed by the block data
+        const quint32 block = this->m_dataBlocks.at(segment - 1);
+        this->m_segment.resize(VhdFormat::SECTOR_SIZE + static_cast<int>(this->m_blockSize));
+        std::fill(this->m_segment.begin(), this->m_segment.begin() + VhdFormat::SECTOR_SIZE, '\xFF');
+
+        char* data = this->m_segment.data() + VhdFormat::SECTOR_SIZE;
+        const qint64 start = static_cast<qint64>(block) * this->m_blockSize;
+        const qint64 available = qMin<qint64>(this->m_blockSize, this->m_reader->VirtualSize() - start);
+        QString error;
+        if (!this->m_reader->Read(start, data, available, error))
+        {
+            this->setErrorString(error);
+            return false;
+        }
+        if (available < this->m_blockSize)
+            std::fill(data + available, data + this->m_blockSize, '\0');
+        return true;
+    }
+
+    if (segment == dataBlocks + 1)
+    {
+        this->m_segment = this->m_footer;
+        return true;
+    }
+
+    this->m_segment.clear();
+    this->m_finished = true;
+    return true;
+}
+
+qint64 SparseVhdStream::readData(char* data, qint64 maxSize)
+{
+    qint64 copied = 0;
+    while (copied < maxSize && !this->m_finished)
+    {
+        if (this->m_segmentPos >= this->m_segment.size())
+        {
+            if (!this->fillNextSegment())
+                return copied > 0 ? copied : -1;
+            continue;
+        }
+
+        const qint64 n = qMin<qint64>(maxSize - copied, this->m_segment.size() - this->m_segmentPos);
+        std::memcpy(data + copied, this->m_segment.constData() + this->m_segmentPos, static_cast<size_t>(n));
+        this->m_segmentPos += n;
+        copied += n;
+    }
+    return copied;
+}
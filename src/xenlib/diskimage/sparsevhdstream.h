@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPARSEVHDSTREAM_H
+#define SPARSEVHDSTREAM_H
+
+#include <QIODevice>
+#include <QVector>
+#include <functional>
+
+class DiskImageReader;
+
+/**
+ * @brief Read-only device producing a dynamic VHD from any DiskImageReader.
+ *
+ * Blocks that are unallocated in the source, or allocated but entirely
+ * zero, are left out of the BAT and never sent, so uploading a mostly
+ * empty disk costs time in proportion to the data it holds rather than its
+ * virtual size. The output goes to @c /import_raw_vdi with @c format=vhd.
+ *
+ * Prepare() builds the BAT, which a dynamic VHD needs before the first data
+ * block; the device then streams header, BAT, blocks and footer in order.
+ * Sources whose allocation map comes from the file system are scanned for
+ * zero blocks first, which reads their allocated data twice; sources with
+ * their own allocation tables (DiskImageReader::HasExactAllocationMap()) are
+ * not scanned, so an allocated block that happens to be zero is sent.
+ */
+class SparseVhdStream : public QIODevice
+{
+    Q_OBJECT
+
+    public:
+        using CancelCallback = std::function<bool()>;
+
+        /** @param reader Opened source image; must outlive this device. */
+        explicit SparseVhdStream(DiskImageReader* reader, QObject* parent = nullptr);
+
+        /**
+         * @brief Find the blocks to send and lay out the output.
+         * @return false on read error or cancellation (see @p errorOut)
+         */
+        bool Prepare(QString& errorOut, CancelCallback cancelled = nullptr);
+
+        /** @brief Total size of the generated VHD (valid after Prepare()). */
+        qint64 ContentSize() const { return this->m_contentSize; }
+
+        /** @brief Virtual size recorded in the VHD, rounded up to whole sectors. */
+        qint64 VirtualSize() const { return this->m_virtualSize; }
+
+        /** @brief Number of blocks that will be sent, out of BlockCount(). */
+        int DataBlockCount() const { return this->m_dataBlocks.size(); }
+        int BlockCount() const { return this->m_blockCount; }
+
+        bool open(OpenMode mode) override;
+        bool isSequential() const override { return true; }
+        bool atEnd() const override;
+
+    protected:
+        qint64 readData(char* data, qint64 maxSize) override;
+        qint64 writeData(const char* data, qint64 maxSize) override;
+
+    private:
+        bool fillNextSegment();
+
+        DiskImageReader* m_reader;
+        quint32 m_blockSize;
+        qint64 m_virtualSize = 0;
+        int m_blockCount = 0;
+        QVector<quint32> m_dataBlocks;   // indices of blocks carrying data, ascending
+        qint64 m_contentSize = -1;
+        QByteArray m_footer;
+
+        // Output state
+        int m_nextSegment = 0;           // 0 = header + BAT, 1..n = data blocks, n + 1 = footer
+        QByteArray m_segment;
+        qint64 m_segmentPos = 0;
+        bool m_finished = false;
+};
+
+#endif // SPARSEVHDSTREAM_H
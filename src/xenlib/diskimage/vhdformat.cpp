@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vhdformat.h"
+
+#include <QDateTime>
+#include <QUuid>
+#include <QtEndian>
+#include <cstring>
+
+namespace
+{
+    void putBe32(QByteArray& buf, int offset, quint32 value)
+    {
+        qToBigEndian<quint32>(value, reinterpret_cast<uchar*>(buf.data() + offset));
+    }
+
+    void putBe64(QByteArray& buf, int offset, quint64 value)
+    {
+        qToBigEndian<quint64>(value, reinterpret_cast<uchar*>(buf.data() + offset));
+    }
+
+    quint32 vhdTimestamp()
+    {
+        // Seconds since 2000-01-01 00:00:00 UTC
+        const qint64 VHD_EPOCH_UNIX_SECS = 946684800;
+        return static_cast<quint32>(qMax<qint64>(0, QDateTime::currentSecsSinceEpoch() - VHD_EPOCH_UNIX_SECS));
+    }
+}
+
+quint32 VhdFormat::Checksum(const char* data, int size, int checksumOffset)
+{
+    quint32 sum = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        if (i >= checksumOffset && i < checksumOffset + 4)
+            continue;
+        sum += static_cast<uchar>(data[i]);
+    }
+    return ~sum;
+}
+
+bool VhdFormat::HasFooterCookie(const char* footer)
+{
+    return std::memcmp(footer, "conectix", 8) == 0;
+}
+
+QByteArray VhdFormat::BuildFooter(qint64 virtualSize, quint32 diskType, qint64 dataOffset)
+{
+    QByteArray footer(FOOTER_SIZE, '\0');
+    std::memcpy(footer.data(), "conectix", 8);
+    putBe32(footer, 8, 0x00000002);                   // Features: reserved bit always set
+    putBe32(footer, 12, 0x00010000);                  // File format version 1.0
+    putBe64(footer, FOOTER_DATA_OFFSET,
+            diskType == DISK_TYPE_FIXED ? 0xFFFFFFFFFFFFFFFFull : static_cast<quint64>(dataOffset));
+    putBe32(footer, 24, vhdTimestamp());
+    std::memcpy(footer.data() + 28, "xadm", 4);       // Creator application
+    putBe32(footer, 32, 0x00010000);                  // Creator version
+    std::memcpy(footer.data() + 36, "Wi2k", 4);       // Creator host OS, as most tools write
+    putBe64(footer, 40, static_cast<quint64>(virtualSize));
+    putBe64(footer, FOOTER_CURRENT_SIZE, static_cast<quint64>(virtualSize));
+    putBe32(footer, 56, Geometry(virtualSize));
+    putBe32(footer, FOOTER_DISK_TYPE, diskType);
+    const QByteArray uuid = QUuid::createUuid().toRfc4122();
+    std::memcpy(footer.data() + 68, uuid.constData(), 16);
+    putBe32(footer, FOOTER_CHECKSUM, Checksum(footer.constData(), FOOTER_SIZE, FOOTER_CHECKSUM));
+    return footer;
+}
+
+QByteArray VhdFormat::BuildDynamicHeader(qint64 tableOffset, quint32 maxTableEntries, quint32 blockSize)
+{
+    QByteArray header(DYNAMIC_HEADER_SIZE, '\0');
+    std::memcpy(header.data(), "cxsparse", 8);
+    putBe64(header, 8, 0xFFFFFFFFFFFFFFFFull);        // Data offset: unused
+    putBe64(header, HEADER_TABLE_OFFSET, static_cast<quint64>(tableOffset));
+    putBe32(header, 24, 0x00010000);                  // Header version 1.0
+    putBe32(header, HEADER_MAX_TABLE_ENTRIES, maxTableEntries);
+    putBe32(header, HEADER_BLOCK_SIZE, blockSize);
+    putBe32(header, HEADER_CHECKSUM, Checksum(header.constData(), DYNAMIC_HEADER_SIZE, HEADER_CHECKSUM));
+    return header;
+}
+
+quint32 VhdFormat::Geometry(qint64 virtualSize)
+{
+    qint64 totalSectors = virtualSize / SECTOR_SIZE;
+    if (totalSectors > 65535LL * 16 * 255)
+        totalSectors = 65535LL * 16 * 255;
+
+    qint64 sectorsPerTrack;
+    qint64 heads;
+    qint64 cylinderTimesHeads;
+    if (totalSectors >= 65535LL * 16 * 63)
+    {
+        sectorsPerTrack = 255;
+        heads = 16;
+        cylinderTimesHeads = totalSectors / sectorsPerTrack;
+    } else
+    {
+        sectorsPerTrack = 17;
+        cylinderTimesHeads = totalSectors / sectorsPerTrack;
+        heads = (cylinderTimesHeads + 1023) / 1024;
+        if (heads < 4)
+            heads = 4;
+        if (cylinderTimesHeads >= heads * 1024 || heads > 16)
+        {
+            sectorsPerTrack = 31;
+            heads = 16;
+            cylinderTimesHeads = totalSectors / sectorsPerTrack;
+        }
+        if (cylinderTimesHeads >= heads * 1024)
+        {
+            sectorsPerTrack = 63;
+            heads = 16;
+            cylinderTimesHeads = totalSectors / sectorsPerTrack;
+        }
+    }
+    const qint64 cylinders = cylinderTimesHeads / heads;
+    return static_cast<quint32>((cylinders << 16) | (heads << 8) | sectorsPerTrack);
+}
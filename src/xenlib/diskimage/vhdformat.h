@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VHDFORMAT_H
+#define VHDFORMAT_H
+
+#include <QByteArray>
+
+/**
+ * @brief Layout constants and structure builders for the VHD format.
+ *
+ * Follows the Microsoft "Virtual Hard Disk Image Format Specification"
+ * (fixed and dynamic disks). All multi-byte fields are big-endian.
+ */
+class VhdFormat
+{
+    public:
+        static const int SECTOR_SIZE = 512;
+        static const int FOOTER_SIZE = 512;
+        static const int DYNAMIC_HEADER_SIZE = 1024;
+        static const quint32 DEFAULT_BLOCK_SIZE = 2 * 1024 * 1024;
+        static const quint32 UNUSED_BAT_ENTRY = 0xFFFFFFFFu;
+
+        static const quint32 DISK_TYPE_FIXED = 2;
+        static const quint32 DISK_TYPE_DYNAMIC = 3;
+        static const quint32 DISK_TYPE_DIFFERENCING = 4;
+
+        // Field offsets used by readers
+        static const int FOOTER_DATA_OFFSET = 16;
+        static const int FOOTER_CURRENT_SIZE = 48;
+        static const int FOOTER_DISK_TYPE = 60;
+        static const int FOOTER_CHECKSUM = 64;
+        static const int HEADER_TABLE_OFFSET = 16;
+        static const int HEADER_MAX_TABLE_ENTRIES = 28;
+        static const int HEADER_BLOCK_SIZE = 32;
+        static const int HEADER_CHECKSUM = 36;
+
+        /** @brief One's complement of the byte sum, skipping the 4-byte checksum field. */
+        static quint32 Checksum(const char* data, int size, int checksumOffset);
+
+        /** @brief Whether @p footer (512 bytes) carries the "conectix" cookie. */
+        static bool HasFooterCookie(const char* footer);
+
+        /**
+         * @brief Build a hard disk footer.
+         * @param virtualSize Disk size in bytes (multiple of 512)
+         * @param diskType    DISK_TYPE_FIXED or DISK_TYPE_DYNAMIC
+         * @param dataOffset  Offset of the dynamic header, ignored for fixed disks
+         */
+        static QByteArray BuildFooter(qint64 virtualSize, quint32 diskType, qint64 dataOffset);
+
+        /** @brief Build a dynamic disk header. */
+        static QByteArray BuildDynamicHeader(qint64 tableOffset, quint32 maxTableEntries, quint32 blockSize);
+
+        /** @brief CHS geometry packed as cylinders(16) heads(8) sectors(8), per the specification. */
+        static quint32 Geometry(qint64 virtualSize);
+
+    private:
+        VhdFormat() = delete;
+};
+
+#endif // VHDFORMAT_H
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vhdimagereader.h"
+#include "rawimagereader.h"
+#include "vhdformat.h"
+
+#include <QtEndian>
+#include <cstring>
+
+VhdImageReader::VhdImageReader(const QString& path, qint64 offset, qint64 length)
+    : m_path(path), m_offset(offset), m_length(length)
+{
+}
+
+bool VhdImageReader::Probe(QFile& file, qint64 offset, qint64 length)
+{
+    if (length < VhdFormat::FOOTER_SIZE)
+        return false;
+    if (!file.seek(offset + length - VhdFormat::FOOTER_SIZE))
+        return false;
+    const QByteArray footer = file.read(VhdFormat::FOOTER_SIZE);
+    return footer.size() == VhdFormat::FOOTER_SIZE && VhdFormat::HasFooterCookie(footer.constData());
+}
+
+bool VhdImageReader::readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut)
+{
+    if (fileOffset < 0 || fileOffset + length > this->m_length)
+    {
+        errorOut = QString("VHD structure lies outside %1").arg(this->m_path);
+        return false;
+    }
+    if (!this->m_file.seek(this->m_offset + fileOffset) || this->m_file.read(data, length) != length)
+    {
+        errorOut = QString("Read error in %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool VhdImageReader::Open(QString& errorOut)
+{
+    this->m_file.setFileName(this->m_path);
+    if (!this->m_file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+
+    char footer[VhdFormat::FOOTER_SIZE];
+    if (!this->readAt(this->m_length - VhdFormat::FOOTER_SIZE, footer, sizeof(footer), errorOut))
+        return false;
+    if (!VhdFormat::HasFooterCookie(footer))
+    {
+        errorOut = QString("%1 is not a VHD image").arg(this->m_path);
+        return false;
+    }
+    const quint32 checksum = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(footer + VhdFormat::FOOTER_CHECKSUM));
+    if (checksum != VhdFormat::Checksum(footer, sizeof(footer), VhdFormat::FOOTER_CHECKSUM))
+    {
+        errorOut = QString("VHD footer checksum mismatch in %1").arg(this->m_path);
+        return false;
+    }
+
+    this->m_diskType = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(footer + VhdFormat::FOOTER_DISK_TYPE));
+    this->m_virtualSize = static_cast<qint64>(qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(footer + VhdFormat::FOOTER_CURRENT_SIZE)));
+
+    if (this->m_diskType == VhdFormat::DISK_TYPE_FIXED)
+    {
+        if (this->m_virtualSize > this->m_length - VhdFormat::FOOTER_SIZE)
+        {
+            errorOut = QString("Fixed VHD %1 is truncated").arg(this->m_path);
+            return false;
+        }
+        this->m_fixedExtents = RawImageReader::DataExtents(this->m_file, this->m_offset, this->m_virtualSize);
+        return true;
+    }
+
+    if (this->m_diskType == VhdFormat::DISK_TYPE_DIFFERENCING)
+    {
+        errorOut = QString("%1 is a differencing VHD and cannot be imported without its parent").arg(this->m_path);
+        return false;
+    }
+    if (this->m_diskType != VhdFormat::DISK_TYPE_DYNAMIC)
+    {
+        errorOut = QString("Unsupported VHD disk type %1 in %2").arg(this->m_diskType).arg(this->m_path);
+        return false;
+    }
+
+    const qint64 headerOffset = static_cast<qint64>(qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(footer + VhdFormat::FOOTER_DATA_OFFSET)));
+    char header[VhdFormat::DYNAMIC_HEADER_SIZE];
+    if (!this->readAt(headerOffset, header, sizeof(header), errorOut))
+        return false;
+    if (std::memcmp(header, "cxsparse", 8) != 0)
+    {
+        errorOut = QString("Dynamic VHD header not found in %1").arg(this->m_path);
+        return false;
+    }
+
+    const qint64 tableOffset = static_cast<qint64>(qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(header + VhdFormat::HEADER_TABLE_OFFSET)));
+    const quint32 entries = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(header + VhdFormat::HEADER_MAX_TABLE_ENTRIES));
+    this->m_blockSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(header + VhdFormat::HEADER_BLOCK_SIZE));
+    if (this->m_blockSize < VhdFormat::SECTOR_SIZE || this->m_blockSize % VhdFormat::SECTOR_SIZE != 0 ||
+        static_cast<qint64>(entries) * this->m_blockSize < this->m_virtualSize)
+    {
+        errorOut = QString("Corrupt dynamic VHD header in %1").arg(this->m_path);
+        return false;
+    }
+
+    // One bit per sector, padded to a whole sector
+    const int sectorsPerBlock = static_cast<int>(this->m_blockSize / VhdFormat::SECTOR_SIZE);
+    this->m_bitmapSize = ((sectorsPerBlock / 8) + VhdFormat::SECTOR_SIZE - 1) / VhdFormat::SECTOR_SIZE * VhdFormat::SECTOR_SIZE;
+
+    QByteArray bat(static_cast<int>(entries) * 4, Qt::Uninitialized);
+    if (!this->readAt(tableOffset, bat.data(), bat.size(), errorOut))
+        return false;
+    this->m_bat.resize(static_cast<int>(entries));
+    for (quint32 i = 0; i < entries; ++i)
+        this->m_bat[static_cast<int>(i)] = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(bat.constData() + i * 4));
+    return true;
+}
+
+QList<DiskExtent> VhdImageReader::AllocatedExtents() const
+{
+    if (this->m_diskType == VhdFormat::DISK_TYPE_FIXED)
+        return this->m_fixedExtents;
+
+    QList<DiskExtent> extents;
+    for (int i = 0; i < this->m_bat.size(); ++i)
+    {
+        if (this->m_bat.at(i) == VhdFormat::UNUSED_BAT_ENTRY)
+            continue;
+
+        const qint64 start = static_cast<qint64>(i) * this->m_blockSize;
+        if (start >= this->m_virtualSize)
+            break;
+        const qint64 length = qMin<qint64>(this->m_blockSize, this->m_virtualSize - start);
+        if (!extents.isEmpty() && extents.last().offset + extents.last().length == start)
+            extents.last().length += length;
+        else
+            extents.append({ start, length });
+    }
+    return extents;
+}
+
+bool VhdImageReader::readBlock(quint32 block, qint64 offsetInBlock, char* data, qint64 length, QString& errorOut)
+{
+    const quint32 sector = this->m_bat.at(static_cast<int>(block));
+    if (sector == VhdFormat::UNUSED_BAT_ENTRY)
+    {
+        std::memset(data, 0, static_cast<size_t>(length));
+        return true;
+    }
+
+    const qint64 blockStart = static_cast<qint64>(sector) * VhdFormat::SECTOR_SIZE;
+    if (this->m_bitmapBlock != block)
+    {
+        this->m_bitmap.resize(this->m_bitmapSize);
+        if (!this->readAt(blockStart, this->m_bitmap.data(), this->m_bitmapSize, errorOut))
+            return false;
+        this->m_bitmapBlock = block;
+    }
+
+    if (!this->readAt(blockStart + this->m_bitmapSize + offsetInBlock, data, length, errorOut))
+        return false;
+
+    // Sectors not marked in the bitmap were never written and read as zeros
+    const uchar* bitmap = reinterpret_cast<const uchar*>(this->m_bitmap.constData());
+    qint64 pos = 0;
+    while (pos < length)
+    {
+        const qint64 sectorIndex = (offsetInBlock + pos) / VhdFormat::SECTOR_SIZE;
+        const qint64 sectorEnd = (sectorIndex + 1) * VhdFormat::SECTOR_SIZE - offsetInBlock;
+        const qint64 chunk = qMin(length, sectorEnd) - pos;
+        if (!(bitmap[sectorIndex / 8] & (0x80 >> (sectorIndex % 8))))
+            std::memset(data + pos, 0, static_cast<size_t>(chunk));
+        pos += chunk;
+    }
+    return true;
+}
+
+bool VhdImageReader::Read(qint64 offset, char* data, qint64 length, QString& errorOut)
+{
+    if (offset < 0 || offset + length > this->m_virtualSize)
+    {
+        errorOut = QString("Read beyond the end of %1").arg(this->m_path);
+        return false;
+    }
+
+    if (this->m_diskType == VhdFormat::DISK_TYPE_FIXED)
+        return this->readAt(offset, data, length, errorOut);
+
+    while (length > 0)
+    {
+        const quint32 block = static_cast<quint32>(offset / this->m_blockSize);
+        const qint64 inBlock = offset % this->m_blockSize;
+        const qint64 chunk = qMin<qint64>(length, this->m_blockSize - inBlock);
+        if (!this->readBlock(block, inBlock, data, chunk, errorOut))
+            return false;
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
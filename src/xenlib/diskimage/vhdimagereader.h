@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VHDIMAGEREADER_H
+#define VHDIMAGEREADER_H
+
+#include "diskimagereader.h"
+#include "vhdformat.h"
+#include <QFile>
+#include <QVector>
+
+/**
+ * @brief Reader for fixed and dynamic VHD images.
+ *
+ * Dynamic disks report only blocks present in the BAT as allocated and
+ * honour the per-block sector bitmaps; fixed disks use the file system's
+ * sparse map of the payload. Differencing disks are rejected, since they
+ * are meaningless without their parent.
+ */
+class VhdImageReader : public DiskImageReader
+{
+    public:
+        VhdImageReader(const QString& path, qint64 offset, qint64 length);
+
+        /** @brief Whether the range of @p file ends with a VHD footer. */
+        static bool Probe(QFile& file, qint64 offset, qint64 length);
+
+        QString FormatName() const override { return QStringLiteral("vhd"); }
+        bool Open(QString& errorOut) override;
+        qint64 VirtualSize() const override { return this->m_virtualSize; }
+        QList<DiskExtent> AllocatedExtents() const override;
+        bool HasExactAllocationMap() const override { return this->m_diskType != VhdFormat::DISK_TYPE_FIXED; }
+        bool Read(qint64 offset, char* data, qint64 length, QString& errorOut) override;
+
+    private:
+        bool readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut);
+        bool readBlock(quint32 block, qint64 offsetInBlock, char* data, qint64 length, QString& errorOut);
+
+        QString m_path;
+        qint64 m_offset;
+        qint64 m_length;
+        QFile m_file;
+
+        quint32 m_diskType = 0;
+        qint64 m_virtualSize = 0;
+
+        // Dynamic disks
+        quint32 m_blockSize = 0;
+        int m_bitmapSize = 0;
+        QVector<quint32> m_bat;
+        quint32 m_bitmapBlock = 0xFFFFFFFFu;
+        QByteArray m_bitmap;
+
+        // Fixed disks
+        QList<DiskExtent> m_fixedExtents;
+};
+
+#endif // VHDIMAGEREADER_H
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vmdkimagereader.h"
+#include "clusterinflater.h"
+
+#include <QDir>
+#include <QRegularExpression>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const quint32 VMDK_MAGIC = 0x564d444b;       // "KDMV" on disk
+    const qint64 SECTOR = 512;
+    const quint64 GD_AT_END = 0xffffffffffffffffull;
+    const quint32 FLAG_COMPRESSED = 1u << 16;
+    const quint16 COMPRESSION_DEFLATE = 1;
+    const int HEADER_SIZE = 512;
+    const int GRAIN_MARKER_SIZE = 12;           // u64 lba + u32 size
+    const qint64 MAX_GRAINS = 64 * 1024 * 1024; // 256 MiB of flattened grain tables
+    const quint32 MAX_GTES_PER_GT = 512;         // the only value VMware writes
+
+    // Sparse extent header field offsets
+    const int OFF_FLAGS = 8;
+    const int OFF_CAPACITY = 12;
+    const int OFF_GRAIN_SIZE = 20;
+    const int OFF_DESCRIPTOR_OFFSET = 28;
+    const int OFF_DESCRIPTOR_SIZE = 36;
+    const int OFF_GTES_PER_GT = 44;
+    const int OFF_GD_OFFSET = 56;
+    const int OFF_COMPRESS_ALGORITHM = 77;
+
+    quint16 le16(const char* p) { return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(p)); }
+    quint32 le32(const char* p) { return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p)); }
+    quint64 le64(const char* p) { return qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(p)); }
+
+    bool hasParent(const QByteArray& descriptor)
+    {
+        static const QRegularExpression parentCid(QStringLiteral("^\\s*parentCID\\s*=\\s*([0-9a-fA-F]+)"),
+                                                  QRegularExpression::MultilineOption);
+        const QRegularExpressionMatch m = parentCid.match(QString::fromLatin1(descriptor));
+        return m.hasMatch() && m.captured(1).compare(QLatin1String("ffffffff"), Qt::CaseInsensitive) != 0;
+    }
+}
+
+VmdkImageReader::VmdkImageReader(const QString& path, qint64 offset, qint64 length)
+    : m_path(path), m_offset(offset), m_length(length)
+{
+}
+
+bool VmdkImageReader::Probe(QFile& file, qint64 offset, qint64 length)
+{
+    if (length < HEADER_SIZE || !file.seek(offset))
+        return false;
+    const QByteArray magic = file.read(4);
+    return magic.size() == 4 && le32(magic.constData()) == VMDK_MAGIC;
+}
+
+bool VmdkImageReader::ProbeDescriptor(QFile& file, qint64 offset, qint64 length)
+{
+    // Descriptor files are small text files; anything large is a disk
+    if (length <= 0 || length > 64 * 1024 || !file.seek(offset))
+        return false;
+    const QByteArray head = file.read(qMin<qint64>(length, 1024));
+    return head.contains("# Disk DescriptorFile");
+}
+
+bool VmdkImageReader::ParseDescriptor(const QByteArray& text, const QString& baseDir,
+                                      VmdkExtent& extentOut, QString& errorOut)
+{
+    if (hasParent(text))
+    {
+        errorOut = QString("VMDK delta disks are not supported; consolidate the snapshot chain first");
+        return false;
+    }
+
+    // RW 4192256 SPARSE "disk-flat.vmdk" [offset]
+    static const QRegularExpression extentLine(
+        QStringLiteral("^\\s*(RW|RDONLY|NOACCESS)\\s+(\\d+)\\s+(\\w+)\\s+\"([^\"]+)\"(?:\\s+(\\d+))?"),
+        QRegularExpression::MultilineOption);
+
+    QList<VmdkExtent> extents;
+    QRegularExpressionMatchIterator it = extentLine.globalMatch(QString::fromUtf8(text));
+    while (it.hasNext())
+    {
+        const QRegularExpressionMatch m = it.next();
+        VmdkExtent extent;
+        extent.sectors = m.captured(2).toLongLong();
+        extent.type = m.captured(3).toUpper();
+        extent.fileName = QDir(baseDir).absoluteFilePath(m.captured(4));
+        extent.offset = m.captured(5).toLongLong() * SECTOR;
+        extents.append(extent);
+    }
+
+    if (extents.isEmpty())
+    {
+        errorOut = QString("VMDK descriptor lists no extents");
+        return false;
+    }
+    if (extents.size() > 1)
+    {
+        errorOut = QString("Split VMDK disks (%1 extents) are not supported; convert to a single extent first")
+                       .arg(extents.size());
+        return false;
+    }
+
+    const VmdkExtent& extent = extents.first();
+    if (extent.type != QLatin1String("SPARSE") && extent.type != QLatin1String("FLAT")
+        && extent.type != QLatin1String("VMFS"))
+    {
+        errorOut = QString("Unsupported VMDK extent type %1").arg(extent.type);
+        return false;
+    }
+    extentOut = extent;
+    return true;
+}
+
+bool VmdkImageReader::readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut)
+{
+    if (fileOffset < 0 || fileOffset + length > this->m_length)
+    {
+        errorOut = QString("VMDK structure lies outside %1").arg(this->m_path);
+        return false;
+    }
+    if (!this->m_file.seek(this->m_offset + fileOffset) || this->m_file.read(data, length) != length)
+    {
+        errorOut = QString("Read error in %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool VmdkImageReader::readHeader(qint64 fileOffset, QByteArray& headerOut, QString& errorOut)
+{
+    headerOut.resize(HEADER_SIZE);
+    if (!this->readAt(fileOffset, headerOut.data(), HEADER_SIZE, errorOut))
+        return false;
+    if (le32(headerOut.constData()) != VMDK_MAGIC)
+    {
+        errorOut = QString("%1 is not a sparse VMDK extent").arg(this->m_path);
+        return false;
+    }
+    return true;
+}
+
+bool VmdkImageReader::Open(QString& errorOut)
+{
+    this->m_file.setFileName(this->m_path);
+    if (!this->m_file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(this->m_path, this->m_file.errorString());
+        return false;
+    }
+
+    QByteArray header;
+    if (!this->readHeader(0, header, errorOut))
+        return false;
+
+    // The embedded descriptor tells us whether this is a delta disk
+    const qint64 descriptorOffset = static_cast<qint64>(le64(header.constData() + OFF_DESCRIPTOR_OFFSET)) * SECTOR;
+    const qint64 descriptorSize = static_cast<qint64>(le64(header.constData() + OFF_DESCRIPTOR_SIZE)) * SECTOR;
+    if (descriptorOffset > 0 && descriptorSize > 0 && descriptorSize <= 1024 * 1024)
+    {
+        QByteArray descriptor(static_cast<int>(descriptorSize), Qt::Uninitialized);
+        if (!this->readAt(descriptorOffset, descriptor.data(), descriptorSize, errorOut))
+            return false;
+        if (hasParent(descriptor))
+        {
+            errorOut = QString("%1 is a VMDK delta disk; consolidate the snapshot chain first").arg(this->m_path);
+            return false;
+        }
+    }
+
+    // Stream-optimized disks written in one pass keep the real header in
+    // the footer: footer marker, footer header, end-of-stream marker.
+    if (le64(header.constData() + OFF_GD_OFFSET) == GD_AT_END)
+    {
+        if (this->m_length < 3 * HEADER_SIZE || !this->readHeader(this->m_length - 2 * HEADER_SIZE, header, errorOut))
+        {
+            if (errorOut.isEmpty())
+                errorOut = QString("Truncated stream-optimized VMDK %1").arg(this->m_path);
+            return false;
+        }
+    }
+
+    const quint32 flags = le32(header.constData() + OFF_FLAGS);
+    const qint64 capacity = static_cast<qint64>(le64(header.constData() + OFF_CAPACITY));
+    const qint64 grainSectors = static_cast<qint64>(le64(header.constData() + OFF_GRAIN_SIZE));
+    const quint32 gtesPerGt = le32(header.constData() + OFF_GTES_PER_GT);
+    const quint64 gdOffset = le64(header.constData() + OFF_GD_OFFSET);
+    this->m_compressed = flags & FLAG_COMPRESSED;
+
+    if (this->m_compressed && le16(header.constData() + OFF_COMPRESS_ALGORITHM) != COMPRESSION_DEFLATE)
+    {
+        errorOut = QString("Unsupported VMDK compression algorithm in %1").arg(this->m_path);
+        return false;
+    }
+    if (grainSectors < 1 || grainSectors > 2048 || (grainSectors & (grainSectors - 1)) != 0
+        || gtesPerGt == 0 || gtesPerGt > MAX_GTES_PER_GT || gdOffset == GD_AT_END
+        || capacity <= 0 || capacity > std::numeric_limits<qint64>::max() / SECTOR)
+    {
+        errorOut = QString("Corrupt VMDK header in %1").arg(this->m_path);
+        return false;
+    }
+
+    this->m_grainSize = grainSectors * SECTOR;
+    this->m_virtualSize = capacity * SECTOR;
+
+    const qint64 grainCount = (capacity + grainSectors - 1) / grainSectors;
+    const qint64 tableCount = (grainCount + gtesPerGt - 1) / gtesPerGt;
+    if (grainCount > MAX_GRAINS)
+    {
+        errorOut = QString("VMDK %1 is too large").arg(this->m_path);
+        return false;
+    }
+
+    QByteArray directory(static_cast<int>(tableCount * 4), Qt::Uninitialized);
+    if (!this->readAt(static_cast<qint64>(gdOffset) * SECTOR, directory.data(), directory.size(), errorOut))
+        return false;
+
+    // Flatten all grain tables: 4 bytes per grain, so a 2 TiB disk with
+    // 64 KiB grains costs 128 MiB here.
+    this->m_grains.fill(GT_UNALLOCATED, static_cast<int>(grainCount));
+    QByteArray table(static_cast<int>(gtesPerGt) * 4, Qt::Uninitialized);
+    for (qint64 t = 0; t < tableCount; ++t)
+    {
+        const qint64 tableSector = le32(directory.constData() + t * 4);
+        if (tableSector == 0)
+            continue;
+        if (!this->readAt(tableSector * SECTOR, table.data(), table.size(), errorOut))
+            return false;
+        const qint64 first = t * gtesPerGt;
+        const qint64 count = qMin<qint64>(gtesPerGt, grainCount - first);
+        for (qint64 g = 0; g < count; ++g)
+            this->m_grains[static_cast<int>(first + g)] = le32(table.constData() + g * 4);
+    }
+
+    this->m_extents.clear();
+    for (int g = 0; g < this->m_grains.size(); ++g)
+    {
+        const quint32 sector = this->m_grains.at(g);
+        if (sector == GT_UNALLOCATED || sector == GT_ZERO_GRAIN)
+            continue;
+        const qint64 start = g * this->m_grainSize;
+        const qint64 len = qMin(this->m_grainSize, this->m_virtualSize - start);
+        if (!this->m_extents.isEmpty() && this->m_extents.last().offset + this->m_extents.last().length == start)
+            this->m_extents.last().length += len;
+        else
+            this->m_extents.append({ start, len });
+    }
+    return true;
+}
+
+bool VmdkImageReader::Read(qint64 offset, char* data, qint64 length, QString& errorOut)
+{
+    if (offset < 0 || offset + length > this->m_virtualSize)
+    {
+        errorOut = QString("Read beyond the end of %1").arg(this->m_path);
+        return false;
+    }
+
+    // Same batching as the qcow2 reader: compressed grains are read here
+    // and inflated together once the whole range has been walked.
+    QVector<CompressedCluster> compressed;
+    struct PartialCopy { int scratch; qint64 inGrain; char* dest; qint64 length; };
+    QVector<QByteArray> scratch;
+    QVector<PartialCopy> partials;
+
+    while (length > 0)
+    {
+        const qint64 grain = offset / this->m_grainSize;
+        const qint64 inGrain = offset % this->m_grainSize;
+        const qint64 chunk = qMin(length, this->m_grainSize - inGrain);
+        const quint32 sector = this->m_grains.at(static_cast<int>(grain));
+
+        if (sector == GT_UNALLOCATED || sector == GT_ZERO_GRAIN)
+        {
+            std::memset(data, 0, static_cast<size_t>(chunk));
+        } else if (this->m_compressed)
+        {
+            char marker[GRAIN_MARKER_SIZE];
+            const qint64 grainOffset = static_cast<qint64>(sector) * SECTOR;
+            if (!this->readAt(grainOffset, marker, GRAIN_MARKER_SIZE, errorOut))
+                return false;
+            const qint64 storedSize = le32(marker + 8);
+            if (storedSize <= 0 || storedSize > 2 * this->m_grainSize + 1024)
+            {
+                errorOut = QString("Corrupt compressed grain %1 in %2").arg(grain).arg(this->m_path);
+                return false;
+            }
+
+            CompressedCluster job;
+            job.input.resize(static_cast<int>(storedSize));
+            if (!this->readAt(grainOffset + GRAIN_MARKER_SIZE, job.input.data(), storedSize, errorOut))
+                return false;
+            // The last grain may be shorter than a full grain
+            job.outputSize = static_cast<int>(qMin(this->m_grainSize, this->m_virtualSize - grain * this->m_grainSize));
+            if (inGrain == 0 && chunk == job.outputSize)
+            {
+                job.output = data;
+            } else
+            {
+                scratch.append(QByteArray(job.outputSize, Qt::Uninitialized));
+                job.output = scratch.last().data();
+                partials.append({ static_cast<int>(scratch.size() - 1), inGrain, data, chunk });
+            }
+            compressed.append(job);
+        } else
+        {
+            if (!this->readAt(static_cast<qint64>(sector) * SECTOR + inGrain, data, chunk, errorOut))
+                return false;
+        }
+
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    if (!ClusterInflater::InflateAll(compressed, ClusterInflater::Format::Zlib, errorOut))
+    {
+        errorOut = QString("%1 in %2").arg(errorOut, this->m_path);
+        return false;
+    }
+    for (const PartialCopy& copy : partials)
+        std::memcpy(copy.dest, scratch.at(copy.scratch).constData() + copy.inGrain, static_cast<size_t>(copy.length));
+    return true;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VMDKIMAGEREADER_H
+#define VMDKIMAGEREADER_H
+
+#include "diskimagereader.h"
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+/**
+ * @brief One extent line of a VMDK text descriptor.
+ */
+struct VmdkExtent
+{
+    QString type;        ///< SPARSE, FLAT, VMFS, ...
+    QString fileName;    ///< Absolute path of the extent file
+    qint64 sectors = 0;  ///< Extent size in 512-byte sectors
+    qint64 offset = 0;   ///< FLAT only: start of the data in the file, in bytes
+};
+
+/**
+ * @brief Reader for hosted sparse VMDK extents (monolithicSparse and
+ *        streamOptimized).
+ *
+ * Walks the grain directory and grain tables; compressed grains of
+ * stream-optimized disks are inflated through ClusterInflater. Delta disks
+ * (with a parent) are rejected. Text descriptors are resolved with
+ * ParseDescriptor() by DiskImageReader::Create().
+ */
+class VmdkImageReader : public DiskImageReader
+{
+    public:
+        VmdkImageReader(const QString& path, qint64 offset, qint64 length);
+
+        /** @brief Whether the range of @p file starts with a sparse extent header ("KDMV"). */
+        static bool Probe(QFile& file, qint64 offset, qint64 length);
+
+        /** @brief Whether the range of @p file is a VMDK text descriptor. */
+        static bool ProbeDescriptor(QFile& file, qint64 offset, qint64 length);
+
+        /**
+         * @brief Parse a text descriptor that describes exactly one extent.
+         *
+         * Relative extent file names are resolved against @p baseDir.
+         * Split disks and delta disks fail with @p errorOut set.
+         */
+        static bool ParseDescriptor(const QByteArray& text, const QString& baseDir,
+                                    VmdkExtent& extentOut, QString& errorOut);
+
+        QString FormatName() const override { return QStringLiteral("vmdk"); }
+        bool Open(QString& errorOut) override;
+        qint64 VirtualSize() const override { return this->m_virtualSize; }
+        QList<DiskExtent> AllocatedExtents() const override { return this->m_extents; }
+        bool HasExactAllocationMap() const override { return true; }
+        bool Read(qint64 offset, char* data, qint64 length, QString& errorOut) override;
+
+    private:
+        static const quint32 GT_UNALLOCATED = 0;
+        static const quint32 GT_ZERO_GRAIN = 1;
+
+        bool readAt(qint64 fileOffset, char* data, qint64 length, QString& errorOut);
+        bool readHeader(qint64 fileOffset, QByteArray& headerOut, QString& errorOut);
+
+        QString m_path;
+        qint64 m_offset;
+        qint64 m_length;
+        QFile m_file;
+
+        qint64 m_virtualSize = 0;
+        qint64 m_grainSize = 0;      // bytes
+        bool m_compressed = false;
+        QVector<quint32> m_grains;   // grain sector per grain index, flattened grain tables
+        QList<DiskExtent> m_extents;
+};
+
+#endif // VMDKIMAGEREADER_H
@@ -25,7 +25,9 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <QMutexLocker>
 #include <QSet>
+#include <algorithm>
 #include "foldersmanager.h"
 #include "../xencache.h"
 #include "../xen/api.h"
@@ -40,6 +42,40 @@ const QString FoldersManager::PATH_SEPARATOR = QStringLiteral("/");
 const QString FoldersManager::EMPTY_FOLDERS_KEY = QStringLiteral("EMPTY_FOLDERS");
 const QString FoldersManager::EMPTY_FOLDERS_SEPARATOR = QStringLiteral(";");
 
+namespace
+{
+    // "/A/B" for any spelling of a folder path, empty for none or the root
+    QString normalizedFolder(const QString& path)
+    {
+        const QStringList points = FoldersManager::PointToPath(path);
+        if (points.isEmpty())
+            return QString();
+        return FoldersManager::PathToPoint(points, points.size());
+    }
+
+    QString objectKey(XenObjectType type, const QString& ref)
+    {
+        return QString::number(static_cast<int>(type)) + QLatin1Char(':') + ref;
+    }
+
+    QSet<QString> parseEmptyFolders(const QVariantMap& otherConfig)
+    {
+        QSet<QString> emptyFolders;
+        const QString raw = otherConfig.value(FoldersManager::EMPTY_FOLDERS_KEY).toString();
+        const QStringList pieces = raw.split(FoldersManager::EMPTY_FOLDERS_SEPARATOR, Qt::SkipEmptyParts);
+        for (const QString& piece : pieces)
+        {
+            const QString trimmed = piece.trimmed();
+            if (!trimmed.startsWith(FoldersManager::PATH_SEPARATOR))
+                continue;
+            const QString folder = normalizedFolder(trimmed);
+            if (!folder.isEmpty())
+                emptyFolders.insert(folder);
+        }
+        return emptyFolders;
+    }
+}
+
 FoldersManager::FoldersManager(QObject* parent) : QObject(parent)
 {
 }
@@ -76,13 +112,9 @@ void FoldersManager::DeregisterEventHandlers()
     disconnect(manager, &Xen::ConnectionsManager::connectionAdded, this, &FoldersManager::onConnectionAdded);
     disconnect(manager, &Xen::ConnectionsManager::connectionRemoved, this, &FoldersManager::onConnectionRemoved);
 
-    for (auto it = this->m_handlers.begin(); it != this->m_handlers.end(); ++it)
-    {
-        disconnect(it->xenObjectsUpdated);
-        disconnect(it->stateChanged);
-    }
-    this->m_handlers.clear();
-    this->m_rebuildInProgress.clear();
+    const QList<XenConnection*> connections = this->m_handlers.keys();
+    for (XenConnection* connection : connections)
+        this->onConnectionRemoved(connection);
     this->m_registered = false;
 }
 
@@ -163,44 +195,47 @@ QStringList FoldersManager::AncestorFolders(const QString& path)
 QStringList FoldersManager::Descendants(XenConnection* connection, const QString& path) const
 {
     QStringList descendants;
-    if (!connection || !connection->GetCache())
+    QMutexLocker locker(&this->m_indexMutex);
+    auto it = this->m_indexes.constFind(connection);
+    if (it == this->m_indexes.constEnd())
         return descendants;
 
-    const QList<QVariantMap> folders = connection->GetCache()->GetAllData(XenObjectType::Folder);
-    const QString prefix = path.endsWith(PATH_SEPARATOR) ? path : path + PATH_SEPARATOR;
-    for (const QVariantMap& folder : folders)
+    const FolderIndex& index = it.value();
+    const QString start = normalizedFolder(path);
+    QStringList pending{ start.isEmpty() ? PATH_SEPARATOR : start };
+    while (!pending.isEmpty())
     {
-        const QString ref = folder.value("ref").toString();
-        if (ref.startsWith(prefix))
-            descendants.append(ref);
+        const QSet<QString> children = index.children.value(pending.takeLast());
+        for (const QString& child : children)
+        {
+            descendants.append(child);
+            pending.append(child);
+        }
     }
+    descendants.sort();
     return descendants;
 }
 
 bool FoldersManager::HasSubfolders(XenConnection* connection, const QString& path) const
 {
-    return !this->Descendants(connection, path).isEmpty();
+    QMutexLocker locker(&this->m_indexMutex);
+    auto it = this->m_indexes.constFind(connection);
+    if (it == this->m_indexes.constEnd())
+        return false;
+
+    const QString folder = normalizedFolder(path);
+    return it->children.contains(folder.isEmpty() ? PATH_SEPARATOR : folder);
 }
 
 bool FoldersManager::ContainsResources(XenConnection* connection, const QString& path) const
 {
-    if (!connection || !connection->GetCache())
+    const QString folder = normalizedFolder(path);
+    if (folder.isEmpty())
         return false;
 
-    for (const QString& type : this->searchableTypes())
-    {
-        if (type == "folder")
-            continue;
-
-        const QList<QVariantMap> records = connection->GetCache()->GetAllData(type);
-        for (const QVariantMap& record : records)
-        {
-            const QString folderPath = FolderPathFromRecord(record);
-            if (folderPath == path || folderPath.startsWith(path + PATH_SEPARATOR))
-                return true;
-        }
-    }
-    return false;
+    QMutexLocker locker(&this->m_indexMutex);
+    auto it = this->m_indexes.constFind(connection);
+    return it != this->m_indexes.constEnd() && it->resources.value(folder) > 0;
 }
 
 bool FoldersManager::CreateFolder(XenConnection* connection, const QString& path)
@@ -209,11 +244,22 @@ bool FoldersManager::CreateFolder(XenConnection* connection, const QString& path
         return false;
 
     const QString fixed = PATH_SEPARATOR + FixupRelativePath(path);
-    QSet<QString> existing;
-    const QStringList refs = connection->GetCache()->GetAllRefs(XenObjectType::Folder);
-    for (const QString& ref : refs)
-        existing.insert(ref);
-    this->ensureFolderChain(connection, fixed, existing);
+    const QString folder = normalizedFolder(fixed);
+
+    // Register the folder right away; the pool update below comes back through
+    // the cache subscription later and then finds nothing left to do
+    FolderOps ops;
+    if (!folder.isEmpty())
+    {
+        QMutexLocker locker(&this->m_indexMutex);
+        auto it = this->m_indexes.find(connection);
+        if (it != this->m_indexes.end() && !it->emptyFolders.contains(folder))
+        {
+            it->emptyFolders.insert(folder);
+            addReference(it.value(), folder, false, ops);
+        }
+    }
+    this->applyFolderOps(connection, ops);
 
     QStringList emptyFolders = this->getEmptyFolders(connection);
     if (!emptyFolders.contains(fixed))
@@ -232,13 +278,38 @@ bool FoldersManager::DeleteFolder(XenConnection* connection, const QString& path
         return false;
 
     const QString target = PATH_SEPARATOR + FixupRelativePath(path);
-    const QStringList descendants = this->Descendants(connection, target);
-    for (const QString& ref : descendants)
-        connection->GetCache()->Remove(XenObjectType::Folder, ref);
-    connection->GetCache()->Remove(XenObjectType::Folder, target);
+    const QString folder = normalizedFolder(target);
+    if (folder.isEmpty())
+        return false;
+
+    // Drop the empty-folder entries at or below the target; folders that still
+    // hold objects stay until those objects are moved out
+    auto isAffected = [folder](const QString& entry) {
+        return entry == folder || entry.startsWith(folder + PATH_SEPARATOR);
+    };
+
+    FolderOps ops;
+    {
+        QMutexLocker locker(&this->m_indexMutex);
+        auto it = this->m_indexes.find(connection);
+        if (it != this->m_indexes.end())
+        {
+            const QList<QString> entries = it->emptyFolders.values();
+            for (const QString& entry : entries)
+            {
+                if (!isAffected(entry))
+                    continue;
+                it->emptyFolders.remove(entry);
+                removeReference(it.value(), entry, false, ops);
+            }
+        }
+    }
+    this->applyFolderOps(connection, ops);
 
     QStringList emptyFolders = this->getEmptyFolders(connection);
-    emptyFolders.removeAll(target);
+    emptyFolders.erase(std::remove_if(emptyFolders.begin(), emptyFolders.end(),
+                                      [&isAffected](const QString& entry) { return isAffected(normalizedFolder(entry)); }),
+                       emptyFolders.end());
     this->setEmptyFolders(connection, emptyFolders);
 
     emit FoldersChanged(connection);
@@ -292,11 +363,26 @@ void FoldersManager::onConnectionAdded(XenConnection* connection)
     if (!connection || this->m_handlers.contains(connection))
         return;
 
+    XenCache* cache = connection->GetCache();
+    if (!cache)
+        return;
+
+    // Only other_config carries the folder key (and the pool's EMPTY_FOLDERS),
+    // so power state or metrics churn never reaches the index
     ConnectionHandlers handlers;
-    handlers.xenObjectsUpdated = connect(connection, &XenConnection::XenObjectsUpdated, this, &FoldersManager::onConnectionObjectsUpdated);
-    handlers.stateChanged = connect(connection, &XenConnection::ConnectionStateChanged, this, &FoldersManager::onConnectionObjectsUpdated);
+    for (XenObjectType type : this->searchableTypes())
+    {
+        handlers.cacheSubscriptions.append(cache->Subscribe(this, type, [this, connection](const QList<XenCacheChange>& changes)
+        {
+            this->onCacheChanges(connection, changes);
+        }, QStringList{ QStringLiteral("other_config") }));
+    }
+    handlers.cacheCleared = connect(cache, &XenCache::cacheCleared, this, [this, connection]()
+    {
+        this->rebuildConnectionFolders(connection);
+    });
+    handlers.stateChanged = connect(connection, &XenConnection::ConnectionStateChanged, this, &FoldersManager::onConnectionStateChanged);
     this->m_handlers.insert(connection, handlers);
-    this->m_rebuildInProgress.insert(connection, false);
     this->rebuildConnectionFolders(connection);
 }
 
@@ -306,12 +392,19 @@ void FoldersManager::onConnectionRemoved(XenConnection* connection)
         return;
 
     const ConnectionHandlers handlers = this->m_handlers.take(connection);
-    disconnect(handlers.xenObjectsUpdated);
+    if (XenCache* cache = connection->GetCache())
+    {
+        for (int subscription : handlers.cacheSubscriptions)
+            cache->Unsubscribe(subscription);
+    }
+    disconnect(handlers.cacheCleared);
     disconnect(handlers.stateChanged);
-    this->m_rebuildInProgress.remove(connection);
+
+    QMutexLocker locker(&this->m_indexMutex);
+    this->m_indexes.remove(connection);
 }
 
-void FoldersManager::onConnectionObjectsUpdated()
+void FoldersManager::onConnectionStateChanged()
 {
     XenConnection* connection = qobject_cast<XenConnection*>(sender());
     if (!connection)
@@ -324,79 +417,218 @@ void FoldersManager::rebuildConnectionFolders(XenConnection* connection)
     if (!connection || !connection->GetCache())
         return;
 
-    if (this->m_rebuildInProgress.value(connection))
-        return;
-
-    this->m_rebuildInProgress[connection] = true;
-
-    QSet<QString> existing;
-    existing.insert(PATH_SEPARATOR);
-
-    QVariantMap root;
-    root["ref"] = PATH_SEPARATOR;
-    root["opaque_ref"] = PATH_SEPARATOR;
-    root["uuid"] = PATH_SEPARATOR;
-    root["name_label"] = QStringLiteral("Folders");
-    root["isRootFolder"] = true;
-    root["parent"] = QString();
-    connection->GetCache()->Update(XenObjectType::Folder, PATH_SEPARATOR, root);
+    XenCache* cache = connection->GetCache();
+    FolderIndex index;
+    FolderOps ignored;
 
-    for (const QString& type : this->searchableTypes())
+    for (XenObjectType type : this->searchableTypes())
     {
-        const XenObjectType objectType = XenObject::TypeFromString(type);
-        const QList<QVariantMap> records = connection->GetCache()->GetAllData(objectType);
+        const QList<QVariantMap> records = cache->GetAllData(type);
         for (const QVariantMap& record : records)
         {
-            const QString path = FolderPathFromRecord(record);
-            if (path.isEmpty())
+            const QString folder = normalizedFolder(FolderPathFromRecord(record));
+            if (folder.isEmpty())
                 continue;
-            this->ensureFolderChain(connection, path, existing);
+            index.objectFolders.insert(objectKey(type, record.value("ref").toString()), folder);
+            addReference(index, folder, true, ignored);
         }
     }
 
-    const QStringList emptyFolders = this->getEmptyFolders(connection);
-    for (const QString& path : emptyFolders)
-        this->ensureFolderChain(connection, path, existing);
+    QSharedPointer<Pool> pool = cache->GetPoolOfOne();
+    if (pool)
+        index.emptyFolders = parseEmptyFolders(pool->GetOtherConfig());
+    for (const QString& folder : std::as_const(index.emptyFolders))
+        addReference(index, folder, false, ignored);
+
+    QStringList wanted = index.references.keys();
+    {
+        QMutexLocker locker(&this->m_indexMutex);
+        this->m_indexes.insert(connection, index);
+    }
 
-    const QStringList current = connection->GetCache()->GetAllRefs(XenObjectType::Folder);
+    // Reconcile the Folder records with the index: parents before children,
+    // and only touch the records that are actually missing or stale
+    FolderOps ops;
+    const QSet<QString> wantedSet(wanted.begin(), wanted.end());
+    const QStringList current = cache->GetAllRefs(XenObjectType::Folder);
     for (const QString& folderRef : current)
     {
-        if (!existing.contains(folderRef))
-            connection->GetCache()->Remove(XenObjectType::Folder, folderRef);
+        if (folderRef != PATH_SEPARATOR && !wantedSet.contains(folderRef))
+            ops.append(qMakePair(folderRef, false));
     }
+    std::sort(wanted.begin(), wanted.end(), [](const QString& a, const QString& b) { return a.size() < b.size(); });
+    for (const QString& folder : wanted)
+        ops.append(qMakePair(folder, true));
+
+    if (!cache->Contains(XenObjectType::Folder, PATH_SEPARATOR))
+    {
+        QVariantMap root;
+        root["ref"] = PATH_SEPARATOR;
+        root["opaque_ref"] = PATH_SEPARATOR;
+        root["uuid"] = PATH_SEPARATOR;
+        root["name_label"] = QStringLiteral("Folders");
+        root["isRootFolder"] = true;
+        root["parent"] = QString();
+        cache->Update(XenObjectType::Folder, PATH_SEPARATOR, root);
+    }
+    this->applyFolderOps(connection, ops);
 
-    this->m_rebuildInProgress[connection] = false;
     emit FoldersChanged(connection);
 }
 
-void FoldersManager::ensureFolderChain(XenConnection* connection, const QString& path, QSet<QString>& existingFolders)
+void FoldersManager::onCacheChanges(XenConnection* connection, const QList<XenCacheChange>& changes)
 {
-    if (!connection || !connection->GetCache())
+    XenCache* cache = connection->GetCache();
+    if (!cache)
         return;
 
-    QString normalized = path.trimmed();
-    if (normalized.isEmpty())
-        return;
-    if (!normalized.startsWith(PATH_SEPARATOR))
-        normalized.prepend(PATH_SEPARATOR);
+    // Read the records before taking the index lock
+    struct ObjectFolder
+    {
+        QString key;
+        QString folder;
+        bool isPool = false;
+        QSet<QString> emptyFolders;
+    };
+    QList<ObjectFolder> updates;
+    updates.reserve(changes.size());
+    for (const XenCacheChange& change : changes)
+    {
+        ObjectFolder update;
+        update.key = objectKey(change.type, change.ref);
+        update.isPool = change.type == XenObjectType::Pool;
+        if (!change.removed)
+        {
+            const QVariantMap record = cache->ResolveObjectData(change.type, change.ref);
+            update.folder = normalizedFolder(FolderPathFromRecord(record));
+            if (update.isPool)
+                update.emptyFolders = parseEmptyFolders(record.value("other_config").toMap());
+        }
+        updates.append(update);
+    }
 
-    const QStringList points = PointToPath(normalized);
+    FolderOps ops;
+    bool changed = false;
+    {
+        QMutexLocker locker(&this->m_indexMutex);
+        auto it = this->m_indexes.find(connection);
+        if (it == this->m_indexes.end())
+            return;
+        FolderIndex& index = it.value();
+
+        for (const ObjectFolder& update : std::as_const(updates))
+        {
+            const QString previous = index.objectFolders.value(update.key);
+            if (previous != update.folder)
+            {
+                if (!previous.isEmpty())
+                {
+                    removeReference(index, previous, true, ops);
+                    index.objectFolders.remove(update.key);
+                }
+                if (!update.folder.isEmpty())
+                {
+                    addReference(index, update.folder, true, ops);
+                    index.objectFolders.insert(update.key, update.folder);
+                }
+                changed = true;
+            }
+
+            if (update.isPool && update.emptyFolders != index.emptyFolders)
+            {
+                for (const QString& folder : index.emptyFolders - update.emptyFolders)
+                    removeReference(index, folder, false, ops);
+                for (const QString& folder : update.emptyFolders - index.emptyFolders)
+                    addReference(index, folder, false, ops);
+                index.emptyFolders = update.emptyFolders;
+                changed = true;
+            }
+        }
+    }
+
+    this->applyFolderOps(connection, ops);
+    if (changed)
+        emit FoldersChanged(connection);
+}
+
+void FoldersManager::addReference(FolderIndex& index, const QString& path, bool resource, FolderOps& ops)
+{
+    const QStringList points = PointToPath(path);
+    QString parent = PATH_SEPARATOR;
     for (int depth = 1; depth <= points.size(); ++depth)
     {
-        const QString folderRef = PathToPoint(points, depth);
-        existingFolders.insert(folderRef);
+        const QString folder = PathToPoint(points, depth);
+        int& references = index.references[folder];
+        if (references++ == 0)
+        {
+            index.children[parent].insert(folder);
+            ops.append(qMakePair(folder, true));
+        }
+        if (resource)
+            ++index.resources[folder];
+        parent = folder;
+    }
+}
+
+void FoldersManager::removeReference(FolderIndex& index, const QString& path, bool resource, FolderOps& ops)
+{
+    // Deepest first so dropped folders go before their parents
+    const QStringList points = PointToPath(path);
+    for (int depth = points.size(); depth >= 1; --depth)
+    {
+        const QString folder = PathToPoint(points, depth);
+        auto refIt = index.references.find(folder);
+        if (refIt == index.references.end())
+            continue;
+
+        if (resource)
+        {
+            auto resIt = index.resources.find(folder);
+            if (resIt != index.resources.end() && --resIt.value() <= 0)
+                index.resources.erase(resIt);
+        }
+
+        if (--refIt.value() > 0)
+            continue;
+
+        index.references.erase(refIt);
+        index.children.remove(folder);
+        const QString parent = PathToPoint(points, depth - 1);
+        auto parentIt = index.children.find(parent);
+        if (parentIt != index.children.end())
+        {
+            parentIt->remove(folder);
+            if (parentIt->isEmpty())
+                index.children.erase(parentIt);
+        }
+        ops.append(qMakePair(folder, false));
+    }
+}
+
+void FoldersManager::applyFolderOps(XenConnection* connection, const FolderOps& ops)
+{
+    XenCache* cache = connection->GetCache();
+    for (const QPair<QString, bool>& op : ops)
+    {
+        const QString& folderRef = op.first;
+        if (!op.second)
+        {
+            cache->Remove(XenObjectType::Folder, folderRef);
+            continue;
+        }
 
-        if (connection->GetCache()->Contains(XenObjectType::Folder, folderRef))
+        if (cache->Contains(XenObjectType::Folder, folderRef))
             continue;
 
+        const QStringList points = PointToPath(folderRef);
         QVariantMap folderRecord;
         folderRecord["ref"] = folderRef;
         folderRecord["opaque_ref"] = folderRef;
         folderRecord["uuid"] = folderRef;
-        folderRecord["name_label"] = points.at(depth - 1);
+        folderRecord["name_label"] = points.last();
         folderRecord["isRootFolder"] = false;
-        folderRecord["parent"] = (depth > 1) ? PathToPoint(points, depth - 1) : PATH_SEPARATOR;
-        connection->GetCache()->Update(XenObjectType::Folder, folderRef, folderRecord);
+        folderRecord["parent"] = PathToPoint(points, points.size() - 1);
+        cache->Update(XenObjectType::Folder, folderRef, folderRecord);
     }
 }
 
@@ -458,7 +690,7 @@ void FoldersManager::setEmptyFolders(XenConnection* connection, const QStringLis
     connection->GetCache()->Update(XenObjectType::Pool, pool->OpaqueRef(), poolRecord);
 }
 
-QStringList FoldersManager::searchableTypes() const
+QList<XenObjectType> FoldersManager::searchableTypes() const
 {
-    return QStringList{QStringLiteral("host"), QStringLiteral("network"), QStringLiteral("pool"), QStringLiteral("sr"), QStringLiteral("vdi"), QStringLiteral("vm")};
+    return QList<XenObjectType>{XenObjectType::Host, XenObjectType::Network, XenObjectType::Pool, XenObjectType::SR, XenObjectType::VDI, XenObjectType::VM};
 }
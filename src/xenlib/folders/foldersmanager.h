@@ -30,11 +30,14 @@
 
 #include <QObject>
 #include <QHash>
+#include <QMutex>
 #include <QSet>
 #include <QStringList>
 #include "../xenlib_global.h"
+#include "../xen/xenobjecttype.h"
 
 class XenConnection;
+struct XenCacheChange;
 
 namespace Xen
 {
@@ -50,7 +53,11 @@ namespace Xen
  * - Empty folders are persisted separately in pool other_config["EMPTY_FOLDERS"].
  *
  * Data flow:
- * - When connection/cache updates arrive, this service rebuilds the folder tree.
+ * - Each connection has a folder index (a trie keyed by folder path) holding the
+ *   folder of every object and per-folder reference and resource counts.
+ * - The index is built once per connection/cache reset and then updated from
+ *   other_config cache subscriptions, touching only objects whose folder key
+ *   actually changed.
  * - It creates/removes synthetic Folder records in XenCache so the rest of the app
  *   can treat folders as normal searchable/groupable objects.
  * - Folder helper APIs (path parsing, ancestry, descendants, move/create/delete)
@@ -88,6 +95,9 @@ class XENLIB_EXPORT FoldersManager : public QObject
         static QString FolderPathFromRecord(const QVariantMap& objectData);
         static QStringList AncestorFolders(const QString& path);
 
+        /**
+         * @brief All folders below @p path, sorted; O(result) walk of the folder index
+         */
         QStringList Descendants(XenConnection* connection, const QString& path) const;
         bool HasSubfolders(XenConnection* connection, const QString& path) const;
         bool ContainsResources(XenConnection* connection, const QString& path) const;
@@ -103,7 +113,7 @@ class XENLIB_EXPORT FoldersManager : public QObject
     private slots:
         void onConnectionAdded(XenConnection* connection);
         void onConnectionRemoved(XenConnection* connection);
-        void onConnectionObjectsUpdated();
+        void onConnectionStateChanged();
 
     private:
         explicit FoldersManager(QObject* parent = nullptr);
@@ -111,19 +121,39 @@ class XENLIB_EXPORT FoldersManager : public QObject
 
         struct ConnectionHandlers
         {
-            QMetaObject::Connection xenObjectsUpdated;
+            QList<int> cacheSubscriptions;
+            QMetaObject::Connection cacheCleared;
             QMetaObject::Connection stateChanged;
         };
 
+        // Folder paths are normalised ("/A/B"); the root "/" is implicit
+        struct FolderIndex
+        {
+            QHash<QString, QString> objectFolders;      // object key -> folder
+            QSet<QString> emptyFolders;                 // pool EMPTY_FOLDERS entries
+            QHash<QString, int> references;             // folder -> objects + empty entries at or below it
+            QHash<QString, int> resources;              // folder -> objects at or below it
+            QHash<QString, QSet<QString>> children;     // folder -> direct subfolders
+        };
+
+        // Folder records to create (true) or drop (false) in the cache, in order
+        typedef QList<QPair<QString, bool>> FolderOps;
+
         void rebuildConnectionFolders(XenConnection* connection);
-        void ensureFolderChain(XenConnection* connection, const QString& path, QSet<QString>& existingFolders);
+        void onCacheChanges(XenConnection* connection, const QList<XenCacheChange>& changes);
+        static void addReference(FolderIndex& index, const QString& path, bool resource, FolderOps& ops);
+        static void removeReference(FolderIndex& index, const QString& path, bool resource, FolderOps& ops);
+        void applyFolderOps(XenConnection* connection, const FolderOps& ops);
         QStringList getEmptyFolders(XenConnection* connection) const;
         void setEmptyFolders(XenConnection* connection, const QStringList& emptyFolders);
-        QStringList searchableTypes() const;
+        QList<XenObjectType> searchableTypes() const;
 
         bool m_registered = false;
         QHash<XenConnection*, ConnectionHandlers> m_handlers;
-        QHash<XenConnection*, bool> m_rebuildInProgress;
+
+        // Read from action threads (Descendants), written on the cache thread
+        mutable QMutex m_indexMutex;
+        QHash<XenConnection*, FolderIndex> m_indexes;
 };
 
 #endif // FOLDERSMANAGER_H
@@ -28,6 +28,7 @@
 #include "metricupdater.h"
 #include "xen/network/connection.h"
 #include "xen/session.h"
+#include "utils/memoryaccountant.h"
 #include <QXmlStreamReader>
 #include <QDateTime>
 #include <QUrl>
@@ -46,6 +47,16 @@ MetricUpdater::MetricUpdater(XenConnection* connection)
     this->m_updateTimer->setInterval(UPDATE_INTERVAL_MS);
     connect(this->m_updateTimer, &QTimer::timeout, this, &MetricUpdater::updateMetrics);
     connect(this->m_networkManager, &QNetworkAccessManager::finished, this, &MetricUpdater::onNetworkReplyFinished);
+
+    if (connection)
+    {
+        MemoryAccountant::instance()->Register(connection, MemoryAccountant::METRICS, this, [this]()
+        {
+            MemoryAccountant::Size size;
+            size.bytes = this->MemoryUsage();
+            return size;
+        });
+    }
 }
 
 MetricUpdater::~MetricUpdater()
@@ -144,6 +155,23 @@ bool MetricUpdater::hasMetrics(const QString& objectType, const QString& objectU
     return this->m_metricsCache.contains(key) && !this->m_metricsCache[key].values.isEmpty();
 }
 
+qint64 MetricUpdater::MemoryUsage() const
+{
+    // QMap node overhead plus key and value payloads
+    const qint64 nodeOverhead = 32;
+
+    QMutexLocker locker(&this->m_metricsMutex);
+    qint64 bytes = 0;
+    for (auto it = this->m_metricsCache.constBegin(); it != this->m_metricsCache.constEnd(); ++it)
+    {
+        bytes += nodeOverhead + qint64(sizeof(QString) + sizeof(MetricValues)) + it.key().capacity() * qint64(sizeof(QChar));
+        const QMap<QString, double>& values = it.value().values;
+        for (auto valueIt = values.constBegin(); valueIt != values.constEnd(); ++valueIt)
+            bytes += nodeOverhead + qint64(sizeof(QString) + sizeof(double)) + valueIt.key().capacity() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
 void MetricUpdater::updateMetrics()
 {
     if (!this->m_running || this->m_paused)
@@ -87,6 +87,9 @@ class MetricUpdater : public QObject
         // Check if metrics are available for object
         bool hasMetrics(const QString& objectType, const QString& objectUuid) const;
 
+        // Approximate heap held by the cached metric values (for MemoryAccountant)
+        qint64 MemoryUsage() const;
+
     signals:
         // Emitted after each successful metrics update
         void metricsUpdated();
@@ -29,9 +29,71 @@
 #include "../xencache.h"
 #include "../xen/network/connection.h"
 #include "../xen/network/connectionsmanager.h"
+#include <algorithm>
 
 OtherConfigAndTagsWatcher* OtherConfigAndTagsWatcher::instance_ = nullptr;
 
+namespace
+{
+    const QString OTHER_CONFIG = QStringLiteral("other_config");
+    const QString TAGS = QStringLiteral("tags");
+    const QString GUI_CONFIG = QStringLiteral("gui_config");
+
+    const QList<XenObjectType> WATCHED_TYPES = {
+        XenObjectType::Pool, XenObjectType::Host, XenObjectType::VM,
+        XenObjectType::SR, XenObjectType::VDI, XenObjectType::Network
+    };
+
+    QString objectKey(XenObjectType type, const QString& ref)
+    {
+        return QString::number(static_cast<int>(type)) + QLatin1Char(':') + ref;
+    }
+
+    QStringList tagsFromRecord(const QVariantMap& record)
+    {
+        QStringList tags;
+        const QVariantList raw = record.value(TAGS).toList();
+        for (const QVariant& value : raw)
+        {
+            const QString tag = value.toString().trimmed();
+            if (!tag.isEmpty() && !tags.contains(tag))
+                tags.append(tag);
+        }
+        return tags;
+    }
+
+    // Reference-count the difference between two per-object lists; true if a
+    // value entered or left the overall set
+    bool applyDiff(QHash<QString, int>& counts, const QStringList& before, const QStringList& after)
+    {
+        bool changed = false;
+        for (const QString& value : before)
+        {
+            if (after.contains(value))
+                continue;
+            auto it = counts.find(value);
+            if (it != counts.end() && --it.value() <= 0)
+            {
+                counts.erase(it);
+                changed = true;
+            }
+        }
+        for (const QString& value : after)
+        {
+            if (!before.contains(value) && counts[value]++ == 0)
+                changed = true;
+        }
+        return changed;
+    }
+
+    QStringList sortedKeys(const QHash<QString, int>& counts)
+    {
+        QStringList keys = counts.keys();
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+}
+
 OtherConfigAndTagsWatcher::OtherConfigAndTagsWatcher(QObject* parent) : QObject(parent)
 {
 }
@@ -56,7 +118,6 @@ void OtherConfigAndTagsWatcher::RegisterEventHandlers()
     for (XenConnection* connection : connections)
         this->onConnectionAdded(connection);
 
-    this->markEventsReadyToFire(true);
     this->handlersRegistered_ = true;
 }
 
@@ -66,16 +127,27 @@ void OtherConfigAndTagsWatcher::DeregisterEventHandlers()
     disconnect(manager, &Xen::ConnectionsManager::connectionAdded, this, &OtherConfigAndTagsWatcher::onConnectionAdded);
     disconnect(manager, &Xen::ConnectionsManager::connectionRemoved, this, &OtherConfigAndTagsWatcher::onConnectionRemoved);
 
-    for (auto it = this->handlers_.begin(); it != this->handlers_.end(); ++it)
-    {
-        disconnect(it->cacheObjectChanged);
-        disconnect(it->xenObjectsUpdated);
-        disconnect(it->stateChanged);
-    }
-    this->handlers_.clear();
+    const QList<XenConnection*> connections = this->handlers_.keys();
+    for (XenConnection* connection : connections)
+        this->onConnectionRemoved(connection);
     this->handlersRegistered_ = false;
 }
 
+QStringList OtherConfigAndTagsWatcher::GetAllTags() const
+{
+    return sortedKeys(this->tagCounts_);
+}
+
+QStringList OtherConfigAndTagsWatcher::GetAllOtherConfigKeys() const
+{
+    return sortedKeys(this->otherConfigKeyCounts_);
+}
+
+int OtherConfigAndTagsWatcher::TagUseCount(const QString& tag) const
+{
+    return this->tagCounts_.value(tag);
+}
+
 void OtherConfigAndTagsWatcher::onConnectionAdded(XenConnection* connection)
 {
     if (!connection || this->handlers_.contains(connection))
@@ -85,14 +157,37 @@ void OtherConfigAndTagsWatcher::onConnectionAdded(XenConnection* connection)
     if (!cache)
         return;
 
+    // Only the watched fields wake us up, so metrics and power state churn on
+    // thousands of VMs never reaches the index
     ConnectionHandlers handlers;
-    handlers.cacheObjectChanged = connect(cache, &XenCache::itemChanged, this, &OtherConfigAndTagsWatcher::onCacheObjectChanged);
-    handlers.xenObjectsUpdated = connect(connection, &XenConnection::XenObjectsUpdated, this, &OtherConfigAndTagsWatcher::onConnectionXenObjectsUpdated);
+    auto callback = [this, connection](const QList<XenCacheChange>& changes) { this->onCacheChanges(connection, changes); };
+    for (XenObjectType type : WATCHED_TYPES)
+    {
+        QStringList fields{ OTHER_CONFIG, TAGS };
+        if (type == XenObjectType::Pool)
+            fields.append(GUI_CONFIG);
+        handlers.cacheSubscriptions.append(cache->Subscribe(this, type, callback, fields));
+    }
     handlers.stateChanged = connect(connection, &XenConnection::ConnectionStateChanged, this, &OtherConfigAndTagsWatcher::onConnectionStateChanged);
     this->handlers_.insert(connection, handlers);
 
-    // On initial connection registration emit all on next batch (C# MarkEventsReadyToFire(true)).
-    this->markEventsReadyToFire(true);
+    // Seed the index from what is cached already; later changes are diffs
+    bool tagsChanged = false;
+    bool keysChanged = false;
+    for (XenObjectType type : WATCHED_TYPES)
+    {
+        const QList<QVariantMap> records = cache->GetAllData(type);
+        for (const QVariantMap& record : records)
+        {
+            ObjectEntry entry;
+            entry.tags = tagsFromRecord(record);
+            entry.otherConfigKeys = record.value(OTHER_CONFIG).toMap().keys();
+            this->updateObject(connection, objectKey(type, record.value("ref").toString()), entry, tagsChanged, keysChanged);
+        }
+    }
+
+    // C# MarkEventsReadyToFire(true): a new connection may bring its own gui_config
+    this->emitChanges(tagsChanged, keysChanged, true);
 }
 
 void OtherConfigAndTagsWatcher::onConnectionRemoved(XenConnection* connection)
@@ -100,52 +195,82 @@ void OtherConfigAndTagsWatcher::onConnectionRemoved(XenConnection* connection)
     if (!connection || !this->handlers_.contains(connection))
         return;
 
-    const ConnectionHandlers handlers = this->handlers_.take(connection);
-    disconnect(handlers.cacheObjectChanged);
-    disconnect(handlers.xenObjectsUpdated);
-    disconnect(handlers.stateChanged);
+    this->unsubscribe(connection, this->handlers_.take(connection));
+
+    bool tagsChanged = false;
+    bool keysChanged = false;
+    const QHash<QString, ObjectEntry> objects = this->objects_.take(connection);
+    for (const ObjectEntry& entry : objects)
+    {
+        tagsChanged |= applyDiff(this->tagCounts_, entry.tags, QStringList());
+        keysChanged |= applyDiff(this->otherConfigKeyCounts_, entry.otherConfigKeys, QStringList());
+    }
+    this->emitChanges(tagsChanged, keysChanged, false);
 }
 
-void OtherConfigAndTagsWatcher::onConnectionXenObjectsUpdated()
+void OtherConfigAndTagsWatcher::unsubscribe(XenConnection* connection, const ConnectionHandlers& handlers)
 {
-    if (this->fireOtherConfigEvent_)
-        emit OtherConfigChanged();
-    if (this->fireTagsEvent_)
-        emit TagsChanged();
-    if (this->fireGuiConfigEvent_)
-        emit GuiConfigChanged();
-
-    this->markEventsReadyToFire(false);
+    XenCache* cache = connection->GetCache();
+    if (cache)
+    {
+        for (int subscription : handlers.cacheSubscriptions)
+            cache->Unsubscribe(subscription);
+    }
+    disconnect(handlers.stateChanged);
 }
 
 void OtherConfigAndTagsWatcher::onConnectionStateChanged()
 {
-    // C# parity: on state change, fire all and reset pending flags.
-    emit OtherConfigChanged();
-    emit TagsChanged();
-    emit GuiConfigChanged();
-    this->markEventsReadyToFire(false);
+    // C# parity: on state change, fire all
+    this->emitChanges(true, true, true);
 }
 
-void OtherConfigAndTagsWatcher::onCacheObjectChanged(XenConnection* connection, XenObjectType type, const QString& ref)
+void OtherConfigAndTagsWatcher::onCacheChanges(XenConnection* connection, const QList<XenCacheChange>& changes)
 {
-    Q_UNUSED(ref);
-    Q_UNUSED(connection);
-
-    if (type == XenObjectType::Pool)
-        this->fireGuiConfigEvent_ = true;
+    XenCache* cache = connection->GetCache();
+    bool tagsChanged = false;
+    bool keysChanged = false;
+    bool guiConfigChanged = false;
 
-    if (type == XenObjectType::Pool || type == XenObjectType::Host || type == XenObjectType::VM ||
-        type == XenObjectType::SR || type == XenObjectType::VDI || type == XenObjectType::Network)
+    for (const XenCacheChange& change : changes)
     {
-        this->fireOtherConfigEvent_ = true;
-        this->fireTagsEvent_ = true;
+        ObjectEntry entry;
+        if (!change.removed && cache)
+        {
+            const QVariantMap record = cache->ResolveObjectData(change.type, change.ref);
+            entry.tags = tagsFromRecord(record);
+            entry.otherConfigKeys = record.value(OTHER_CONFIG).toMap().keys();
+        }
+        this->updateObject(connection, objectKey(change.type, change.ref), entry, tagsChanged, keysChanged);
+
+        if (change.fields.contains(GUI_CONFIG))
+            guiConfigChanged = true;
     }
+
+    this->emitChanges(tagsChanged, keysChanged, guiConfigChanged);
+}
+
+void OtherConfigAndTagsWatcher::updateObject(XenConnection* connection, const QString& key, const ObjectEntry& entry,
+                                             bool& tagsChanged, bool& keysChanged)
+{
+    QHash<QString, ObjectEntry>& objects = this->objects_[connection];
+    const ObjectEntry previous = objects.value(key);
+
+    tagsChanged |= applyDiff(this->tagCounts_, previous.tags, entry.tags);
+    keysChanged |= applyDiff(this->otherConfigKeyCounts_, previous.otherConfigKeys, entry.otherConfigKeys);
+
+    if (entry.tags.isEmpty() && entry.otherConfigKeys.isEmpty())
+        objects.remove(key);
+    else
+        objects.insert(key, entry);
 }
 
-void OtherConfigAndTagsWatcher::markEventsReadyToFire(bool fire)
+void OtherConfigAndTagsWatcher::emitChanges(bool tagsChanged, bool keysChanged, bool guiConfigChanged)
 {
-    this->fireOtherConfigEvent_ = fire;
-    this->fireTagsEvent_ = fire;
-    this->fireGuiConfigEvent_ = fire;
+    if (keysChanged)
+        emit OtherConfigChanged();
+    if (tagsChanged)
+        emit TagsChanged();
+    if (guiConfigChanged)
+        emit GuiConfigChanged();
 }
@@ -37,6 +37,7 @@
 #include "xen/xenobjecttype.h"
 
 class XenConnection;
+struct XenCacheChange;
 
 /**
  * @brief Watches for changes to other_config, tags, and gui_config across all objects
@@ -48,9 +49,14 @@ class XenConnection;
  * - tags (user-defined labels)
  * - gui_config (pool GUI settings like custom field definitions)
  *
- * It batches property change events from multiple objects and emits aggregated
- * signals when connections finish updating. This prevents excessive UI updates
- * when many objects change simultaneously (e.g., during initial cache population).
+ * It keeps reference-counted indexes of every tag and every other_config key in
+ * use across all connections. The indexes are updated from field-masked cache
+ * subscriptions by diffing each object's previous tags/keys against its new
+ * record, so consumers can ask for the full set without walking every object.
+ * TagsChanged and OtherConfigChanged fire only when the set of tags or keys
+ * actually differs, not on every object update.
+ *
+ * Must be used from the GUI thread.
  *
  * Usage:
  *   OtherConfigAndTagsWatcher::instance()->RegisterEventHandlers();
@@ -82,17 +88,33 @@ public:
      */
     void DeregisterEventHandlers();
 
+    /**
+     * @brief All tags used by any watched object on any connection, sorted
+     *
+     * C# equivalent: Tags.GetAllTags()
+     */
+    QStringList GetAllTags() const;
+
+    /**
+     * @brief All other_config keys used by any watched object, sorted
+     */
+    QStringList GetAllOtherConfigKeys() const;
+
+    /**
+     * @brief Number of watched objects carrying @p tag
+     */
+    int TagUseCount(const QString& tag) const;
+
 signals:
     /**
-     * @brief Emitted when other_config changes on any XenObject
+     * @brief Emitted when the set of other_config keys in use changes
      * 
      * C# equivalent: OtherConfigChanged event
-     * Batched - only fires once per connection update cycle
      */
     void OtherConfigChanged();
 
     /**
-     * @brief Emitted when tags change on any XenObject
+     * @brief Emitted when the set of tags in use changes
      * 
      * C# equivalent: TagsChanged event
      * Used by TagQueryType to refresh available tag list
@@ -110,9 +132,7 @@ signals:
 private slots:
     void onConnectionAdded(XenConnection* connection);
     void onConnectionRemoved(XenConnection* connection);
-    void onConnectionXenObjectsUpdated();
     void onConnectionStateChanged();
-    void onCacheObjectChanged(XenConnection* connection, XenObjectType type, const QString& ref);
 
 private:
     explicit OtherConfigAndTagsWatcher(QObject* parent = nullptr);
@@ -122,20 +142,30 @@ private:
 
     struct ConnectionHandlers
     {
-        QMetaObject::Connection cacheObjectChanged;
-        QMetaObject::Connection xenObjectsUpdated;
+        QList<int> cacheSubscriptions;
         QMetaObject::Connection stateChanged;
     };
 
+    // What the index last saw on one object
+    struct ObjectEntry
+    {
+        QStringList tags;
+        QStringList otherConfigKeys;
+    };
+
     QHash<XenConnection*, ConnectionHandlers> handlers_;
     bool handlersRegistered_ = false;
 
-    // C# parity: pending event flags are set by property changes and emitted on XenObjectsUpdated
-    bool fireOtherConfigEvent_ = true;
-    bool fireTagsEvent_ = true;
-    bool fireGuiConfigEvent_ = true;
+    // Connection -> object key -> last seen tags/keys
+    QHash<XenConnection*, QHash<QString, ObjectEntry>> objects_;
+    QHash<QString, int> tagCounts_;
+    QHash<QString, int> otherConfigKeyCounts_;
 
-    void markEventsReadyToFire(bool fire);
+    void onCacheChanges(XenConnection* connection, const QList<XenCacheChange>& changes);
+    void updateObject(XenConnection* connection, const QString& key, const ObjectEntry& entry,
+                      bool& tagsChanged, bool& keysChanged);
+    void unsubscribe(XenConnection* connection, const ConnectionHandlers& handlers);
+    void emitChanges(bool tagsChanged, bool keysChanged, bool guiConfigChanged);
 };
 
 #endif // OTHERCONFIGANDTAGSWATCHER_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ovaarchive.h"
+#include "ovatar.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+bool OvaArchive::Open(const QString& ovaPath, QString& errorOut)
+{
+    this->m_path = ovaPath;
+    this->m_members.clear();
+
+    QFile file(ovaPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open OVA archive: %1").arg(file.errorString());
+        return false;
+    }
+
+    const qint64 archiveSize = file.size();
+    QString longName;
+    qint64 pos = 0;
+
+    while (pos + OvaTar::BLOCK_SIZE <= archiveSize)
+    {
+        if (!file.seek(pos))
+            break;
+        const QByteArray header = file.read(OvaTar::BLOCK_SIZE);
+        if (header.size() < OvaTar::BLOCK_SIZE)
+            break;
+
+        // All-zero block signals end of archive
+        if (header.count('\0') == OvaTar::BLOCK_SIZE)
+            break;
+
+        QString name = QString::fromLocal8Bit(header.constData(),
+                                              static_cast<int>(qstrnlen(header.constData(), 100)));
+
+        // POSIX ustar ("ustar\0") keeps a path prefix at offset 345; the GNU
+        // variant ("ustar  ") uses those bytes for other fields.
+        if (header.mid(257, 6) == QByteArray("ustar\0", 6))
+        {
+            const QString prefix = QString::fromLocal8Bit(header.constData() + 345,
+                                                          static_cast<int>(qstrnlen(header.constData() + 345, 155)));
+            if (!prefix.isEmpty())
+                name = prefix + "/" + name;
+        }
+
+        const qint64 size = OvaTar::ParseSize(header.constData() + 124);
+        if (size < 0)
+        {
+            errorOut = QString("Corrupt TAR header at offset %1").arg(pos);
+            return false;
+        }
+
+        const char type = header.at(156);
+        const qint64 dataOffset = pos + OvaTar::BLOCK_SIZE;
+        if (dataOffset + size > archiveSize)
+        {
+            errorOut = QString("OVA archive is truncated (member %1)").arg(name);
+            return false;
+        }
+
+        if (type == 'L')
+        {
+            // GNU long name: the data block holds the real name of the next member
+            file.seek(dataOffset);
+            const QByteArray raw = file.read(qMin<qint64>(size, 4096));
+            longName = QString::fromLocal8Bit(raw.constData(), static_cast<int>(qstrnlen(raw.constData(), raw.size())));
+        } else if (type == '0' || type == '\0' || type == '7')
+        {
+            if (!longName.isEmpty())
+                name = longName;
+            this->m_members.append({ name, dataOffset, size });
+            longName.clear();
+        } else
+        {
+            // Directories, links and pax headers carry nothing we import
+            longName.clear();
+        }
+
+        pos = dataOffset + size + OvaTar::PaddingFor(size);
+    }
+
+    return true;
+}
+
+const OvaMember* OvaArchive::FindMember(const QString& href) const
+{
+    for (const OvaMember& member : this->m_members)
+    {
+        if (member.name == href)
+            return &member;
+    }
+
+    const QString fileName = QFileInfo(href).fileName();
+    for (const OvaMember& member : this->m_members)
+    {
+        if (QFileInfo(member.name).fileName() == fileName)
+            return &member;
+    }
+    return nullptr;
+}
+
+const OvaMember* OvaArchive::FindMemberBySuffix(const QString& suffix) const
+{
+    for (const OvaMember& member : this->m_members)
+    {
+        if (member.name.endsWith(suffix, Qt::CaseInsensitive))
+            return &member;
+    }
+    return nullptr;
+}
+
+QByteArray OvaArchive::ReadMember(const OvaMember& member, qint64 maxSize) const
+{
+    if (member.size > maxSize)
+        return QByteArray();
+
+    QFile file(this->m_path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(member.dataOffset))
+        return QByteArray();
+
+    QByteArray data = file.read(member.size);
+    if (data.size() != member.size)
+        return QByteArray();
+    if (data.isNull())
+        data = QByteArray("");
+    return data;
+}
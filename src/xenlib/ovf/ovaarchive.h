@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OVAARCHIVE_H
+#define OVAARCHIVE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief Location of one regular-file member inside an OVA (TAR) archive.
+ */
+struct OvaMember
+{
+    QString name;           ///< Member path as stored in the archive
+    qint64 dataOffset = 0;  ///< Byte offset of the member data within the archive
+    qint64 size = 0;        ///< Member data length in bytes
+};
+
+/**
+ * @brief Random-access index over an OVA archive.
+ *
+ * Open() walks the TAR headers once (seeking over member data, so the cost
+ * is one 512-byte read per member) and records where each member's data
+ * lives. Disks can then be read straight out of the archive by offset —
+ * see OvfDiskSource — instead of being extracted to a scratch directory.
+ *
+ * Understands ustar/GNU headers, GNU base-256 sizes and GNU long names.
+ */
+class OvaArchive
+{
+    public:
+        OvaArchive() = default;
+
+        /**
+         * @brief Index the archive at @p ovaPath.
+         * @param ovaPath  Path to the .ova file
+         * @param errorOut Receives a human-readable error on failure
+         * @return true if the archive was indexed
+         */
+        bool Open(const QString& ovaPath, QString& errorOut);
+
+        QString FilePath() const { return this->m_path; }
+        QList<OvaMember> Members() const { return this->m_members; }
+
+        /**
+         * @brief Find a member by OVF href.
+         *
+         * Matches the full member path first, then the file name alone since
+         * some tools store members under a top-level folder.
+         * @return nullptr when there is no such member
+         */
+        const OvaMember* FindMember(const QString& href) const;
+
+        /** @brief First member with the given suffix (e.g. ".ovf"), or nullptr. */
+        const OvaMember* FindMemberBySuffix(const QString& suffix) const;
+
+        /**
+         * @brief Read a small member (descriptor, manifest, certificate) into memory.
+         * @param maxSize Refuse members larger than this
+         * @return Member content, or a null QByteArray on error
+         */
+        QByteArray ReadMember(const OvaMember& member, qint64 maxSize = 16 * 1024 * 1024) const;
+
+    private:
+        QString m_path;
+        QList<OvaMember> m_members;
+};
+
+#endif // OVAARCHIVE_H
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ovatar.h"
+
+#include <QFileDevice>
+#include <cstring>
+#include <limits>
+
+// ── OvaTar ───────────────────────────────────────────────────────────────────
+
+void OvaTar::FillHeader(char buf[512], const QString& name, qint64 fileSize)
+{
+    std::memset(buf, 0, BLOCK_SIZE);
+
+    // name field: 100 bytes
+    QByteArray nameBytes = name.toLocal8Bit();
+    if (nameBytes.size() > 99)
+        nameBytes = nameBytes.left(99);
+    std::memcpy(buf, nameBytes.constData(), nameBytes.size());
+
+    // mode: 0000644
+    std::memcpy(buf + 100, "0000644\0", 8);
+
+    // uid/gid
+    std::memcpy(buf + 108, "0000000\0", 8);
+    std::memcpy(buf + 116, "0000000\0", 8);
+
+    if (fileSize <= MAX_OCTAL_SIZE)
+    {
+        // size: octal, 11 digits + space
+        QByteArray sizeStr = QByteArray::number(fileSize, 8).rightJustified(11, '0');
+        std::memcpy(buf + 124, sizeStr.constData(), 11);
+        buf[135] = ' ';
+    } else
+    {
+        // GNU base-256: high bit of the first byte set, big-endian binary value
+        buf[124] = static_cast<char>(0x80);
+        quint64 v = static_cast<quint64>(fileSize);
+        for (int i = 11; i >= 1; --i)
+        {
+            buf[124 + i] = static_cast<char>(v & 0xFF);
+            v >>= 8;
+        }
+    }
+
+    // mtime: 0
+    std::memcpy(buf + 136, "00000000000\0", 12);
+
+    // checksum placeholder: all spaces
+    std::memset(buf + 148, ' ', 8);
+
+    // type flag: '0' = regular file
+    buf[156] = '0';
+
+    // ustar magic + version
+    std::memcpy(buf + 257, "ustar  \0", 8);
+
+    // Calculate checksum over the 512-byte header with spaces in checksum field
+    unsigned int checksum = 0;
+    for (int i = 0; i < BLOCK_SIZE; ++i)
+        checksum += static_cast<unsigned char>(buf[i]);
+
+    QByteArray csStr = QByteArray::number(checksum, 8).rightJustified(6, '0');
+    std::memcpy(buf + 148, csStr.constData(), 6);
+    buf[154] = '\0';
+    buf[155] = ' ';
+}
+
+qint64 OvaTar::ParseSize(const char* field)
+{
+    const unsigned char first = static_cast<unsigned char>(field[0]);
+    if (first & 0x80)
+    {
+        // GNU base-256; negative values (0xFF prefix) are never valid sizes
+        if (first == 0xFF)
+            return -1;
+        quint64 v = first & 0x7F;
+        for (int i = 1; i < 12; ++i)
+        {
+            if (v > (std::numeric_limits<quint64>::max() >> 8))
+                return -1;
+            v = (v << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return v > static_cast<quint64>(std::numeric_limits<qint64>::max()) ? -1 : static_cast<qint64>(v);
+    }
+
+    bool ok = false;
+    const QByteArray text = QByteArray(field, static_cast<int>(qstrnlen(field, 12))).trimmed();
+    if (text.isEmpty())
+        return 0;
+    const qint64 size = text.toLongLong(&ok, 8);
+    return ok ? size : -1;
+}
+
+qint64 OvaTar::PaddingFor(qint64 size)
+{
+    return (BLOCK_SIZE - (size % BLOCK_SIZE)) % BLOCK_SIZE;
+}
+
+// ── OvaTarWriter ─────────────────────────────────────────────────────────────
+
+OvaTarWriter::OvaTarWriter(QFileDevice* device) : m_device(device)
+{
+}
+
+bool OvaTarWriter::fail(const QString& what)
+{
+    this->m_lastError = QString("%1: %2").arg(what, this->m_device->errorString());
+    return false;
+}
+
+bool OvaTarWriter::AddMember(const QString& name, const QByteArray& data)
+{
+    return this->BeginMember(name)
+        && this->WriteMemberData(data.constData(), data.size())
+        && this->EndMember();
+}
+
+bool OvaTarWriter::BeginMember(const QString& name)
+{
+    this->m_memberName = name;
+    this->m_memberSize = 0;
+    this->m_headerPos  = this->m_device->pos();
+
+    // Placeholder header; the real one is written once the size is known
+    char header[OvaTar::BLOCK_SIZE] = {};
+    if (this->m_device->write(header, OvaTar::BLOCK_SIZE) != OvaTar::BLOCK_SIZE)
+        return this->fail(QString("Failed to write TAR header for %1").arg(name));
+    return true;
+}
+
+bool OvaTarWriter::WriteMemberData(const char* data, qint64 size)
+{
+    if (this->m_device->write(data, size) != size)
+        return this->fail(QString("Failed to write %1").arg(this->m_memberName));
+    this->m_memberSize += size;
+    return true;
+}
+
+bool OvaTarWriter::EndMember()
+{
+    const qint64 endPos = this->m_device->pos();
+
+    char header[OvaTar::BLOCK_SIZE];
+    OvaTar::FillHeader(header, this->m_memberName, this->m_memberSize);
+    if (!this->m_device->seek(this->m_headerPos)
+        || this->m_device->write(header, OvaTar::BLOCK_SIZE) != OvaTar::BLOCK_SIZE
+        || !this->m_device->seek(endPos))
+    {
+        return this->fail(QString("Failed to finalise TAR header for %1").arg(this->m_memberName));
+    }
+
+    // Pad to 512-byte boundary
+    const qint64 padding = OvaTar::PaddingFor(this->m_memberSize);
+    if (padding > 0)
+    {
+        char pad[OvaTar::BLOCK_SIZE] = {};
+        if (this->m_device->write(pad, padding) != padding)
+            return this->fail(QString("Failed to pad %1").arg(this->m_memberName));
+    }
+
+    this->m_headerPos = -1;
+    return true;
+}
+
+bool OvaTarWriter::Finish()
+{
+    // Two 512-byte zero blocks mark end of archive
+    char eofBlocks[2 * OvaTar::BLOCK_SIZE] = {};
+    if (this->m_device->write(eofBlocks, sizeof(eofBlocks)) != static_cast<qint64>(sizeof(eofBlocks)))
+        return this->fail(QStringLiteral("Failed to terminate OVA archive"));
+    if (!this->m_device->flush())
+        return this->fail(QStringLiteral("Failed to flush OVA archive"));
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OVATAR_H
+#define OVATAR_H
+
+#include <QByteArray>
+#include <QString>
+
+class QFileDevice;
+
+/**
+ * @brief POSIX/GNU TAR framing helpers shared by the OVA writer and readers.
+ */
+class OvaTar
+{
+    public:
+        static const int BLOCK_SIZE = 512;
+
+        /// Largest size representable in the 11-digit octal size field (8 GiB - 1).
+        static const qint64 MAX_OCTAL_SIZE = 077777777777LL;
+
+        /**
+         * @brief Fill a 512-byte GNU ustar header for a regular file.
+         *
+         * Sizes above MAX_OCTAL_SIZE use the GNU base-256 encoding so that
+         * multi-terabyte disk members survive the round trip.
+         */
+        static void FillHeader(char buf[512], const QString& name, qint64 fileSize);
+
+        /**
+         * @brief Decode the 12-byte size field of a TAR header.
+         *
+         * Understands both octal ASCII and GNU base-256 encodings.
+         * @return Size in bytes, or -1 if the field is malformed.
+         */
+        static qint64 ParseSize(const char* field);
+
+        /** @brief Number of zero bytes needed after @p size bytes of member data. */
+        static qint64 PaddingFor(qint64 size);
+
+    private:
+        OvaTar() = delete;
+};
+
+/**
+ * @brief Sequential OVA (TAR) writer that supports members of unknown size.
+ *
+ * BeginMember() reserves a header block, data is then streamed with
+ * WriteMemberData() and EndMember() seeks back to patch in the final size.
+ * This lets compressed disk images be written straight into the archive
+ * without knowing their compressed length up front.
+ *
+ * The device must be open for writing and seekable (a QFile or QSaveFile).
+ */
+class OvaTarWriter
+{
+    public:
+        explicit OvaTarWriter(QFileDevice* device);
+
+        /** @brief Write a complete member whose content is already in memory. */
+        bool AddMember(const QString& name, const QByteArray& data);
+
+        /** @brief Start a streamed member; its size is patched by EndMember(). */
+        bool BeginMember(const QString& name);
+        bool WriteMemberData(const char* data, qint64 size);
+        bool EndMember();
+
+        /** @brief Write the two zero blocks that terminate the archive and flush. */
+        bool Finish();
+
+        QString GetLastError() const { return this->m_lastError; }
+
+    private:
+        bool fail(const QString& what);
+
+        QFileDevice* m_device;
+        QString m_memberName;
+        qint64 m_headerPos = -1;
+        qint64 m_memberSize = 0;
+        QString m_lastError;
+};
+
+#endif // OVATAR_H
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ovfdisksource.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <memory>
+#ifndef XENADMIN_NO_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    const int VHD_SECTOR = 512;
+    const int VHD_DYNAMIC_HEADER_END = 1536;   // footer copy + dynamic disk header
+    const quint32 VHD_MAX_BAT_ENTRIES = 16 * 1024 * 1024;
+    const qint64 VHD_MAX_TABLE_OFFSET = 16 * 1024 * 1024;
+    const quint32 VHD_UNUSED_BLOCK = 0xFFFFFFFFu;
+
+    qint64 roundUp(qint64 value, qint64 unit)
+    {
+        return (value + unit - 1) / unit * unit;
+    }
+
+    // Inflate the source until @p buffer holds @p size bytes or the disk ends
+    bool readPrefix(OvfDiskSource& source, QByteArray& buffer, qint64 size)
+    {
+        while (buffer.size() < size && !source.atEnd())
+        {
+            const qint64 offset = buffer.size();
+            buffer.resize(size);
+            const qint64 n = source.read(buffer.data() + offset, size - offset);
+            buffer.resize(offset + qMax<qint64>(n, 0));
+            if (n <= 0)
+                return n == 0;
+        }
+        return true;
+    }
+}
+
+struct OvfDiskSource::Private
+{
+    QString filePath;
+    qint64 offset = 0;
+    qint64 size = 0;
+    bool gunzip = false;
+
+    QFile file;
+    qint64 storedRemaining = 0;
+    bool finished = false;
+
+    bool hashing = false;
+    QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha256;
+    std::unique_ptr<QCryptographicHash> hash;
+    QString digestHex;
+
+    QByteArray inBuf;
+#ifndef XENADMIN_NO_ZLIB
+    z_stream strm {};
+    bool inflateReady = false;
+#endif
+};
+
+OvfDiskSource::OvfDiskSource(const QString& filePath, qint64 offset, qint64 size,
+                             bool gunzip, QObject* parent)
+    : QIODevice(parent), d(new Private)
+{
+    this->d->filePath = filePath;
+    this->d->offset = offset;
+    this->d->size = size;
+    this->d->gunzip = gunzip;
+}
+
+OvfDiskSource::~OvfDiskSource()
+{
+    this->close();
+    delete this->d;
+}
+
+qint64 OvfDiskSource::StoredSize() const
+{
+    return this->d->size;
+}
+
+void OvfDiskSource::SetDigestAlgorithm(QCryptographicHash::Algorithm algorithm)
+{
+    this->d->hashing = true;
+    this->d->algorithm = algorithm;
+}
+
+QString OvfDiskSource::GetDigestHex() const
+{
+    return this->d->digestHex;
+}
+
+qint64 OvfDiskSource::ContentSize(QString& errorOut, qint64 capacity) const
+{
+    if (!this->d->gunzip)
+        return this->d->size;
+
+    const qint64 fromLayout = this->contentSizeFromLayout(capacity);
+    if (fromLayout >= 0)
+        return fromLayout;
+
+    OvfDiskSource counter(this->d->filePath, this->d->offset, this->d->size, true);
+    if (!counter.open(QIODevice::ReadOnly))
+    {
+        errorOut = counter.errorString();
+        return -1;
+    }
+
+    QByteArray scratch(READ_CHUNK, Qt::Uninitialized);
+    qint64 total = 0;
+    while (!counter.atEnd())
+    {
+        const qint64 n = counter.read(scratch.data(), scratch.size());
+        if (n < 0)
+        {
+            errorOut = counter.errorString();
+            return -1;
+        }
+        if (n == 0)
+            break;
+        total += n;
+    }
+    return total;
+}
+
+qint64 OvfDiskSource::contentSizeFromLayout(qint64 capacity) const
+{
+    // ISIZE, the last four bytes of a gzip member, is the inflated length
+    // modulo 2^32; a candidate length is only trusted when it agrees
+    if (this->d->size < 18)
+        return -1;
+    QFile file(this->d->filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(this->d->offset + this->d->size - 4))
+        return -1;
+    const QByteArray trailer = file.read(4);
+    if (trailer.size() != 4)
+        return -1;
+    const quint32 isize = qFromLittleEndian<quint32>(trailer.constData());
+    auto matches = [isize](qint64 length) { return length > 0 && static_cast<quint32>(length) == isize; };
+
+    OvfDiskSource prefix(this->d->filePath, this->d->offset, this->d->size, true);
+    QByteArray head;
+    if (!prefix.open(QIODevice::ReadOnly) || !readPrefix(prefix, head, VHD_DYNAMIC_HEADER_END))
+        return -1;
+
+    const bool dynamicVhd = head.size() == VHD_DYNAMIC_HEADER_END && head.startsWith("conectix")
+                            && head.mid(VHD_SECTOR, 8) == "cxsparse";
+    if (!dynamicVhd)
+    {
+        // A fixed VHD is the raw disk plus a one-sector footer
+        if (capacity > 0 && matches(capacity + VHD_SECTOR))
+            return capacity + VHD_SECTOR;
+        if (capacity > 0 && matches(capacity))
+            return capacity;
+        return -1;
+    }
+
+    // Blocks follow the BAT; the file ends one footer after the furthest of them
+    const char* header = head.constData() + VHD_SECTOR;
+    const qint64 tableOffset = static_cast<qint64>(qFromBigEndian<quint64>(header + 16));
+    const quint32 entries = qFromBigEndian<quint32>(header + 28);
+    const quint32 blockSize = qFromBigEndian<quint32>(header + 32);
+    if (tableOffset < VHD_DYNAMIC_HEADER_END || tableOffset > VHD_MAX_TABLE_OFFSET || entries > VHD_MAX_BAT_ENTRIES
+        || blockSize < VHD_SECTOR || (blockSize & (blockSize - 1)) != 0)
+    {
+        return -1;
+    }
+
+    const qint64 tableEnd = tableOffset + qint64(entries) * 4;
+    if (!readPrefix(prefix, head, tableEnd) || head.size() != tableEnd)
+        return -1;
+
+    const qint64 bitmapSize = roundUp(blockSize / VHD_SECTOR / 8, VHD_SECTOR);
+    qint64 end = roundUp(tableEnd, VHD_SECTOR);
+    const char* bat = head.constData() + tableOffset;
+    for (quint32 i = 0; i < entries; ++i)
+    {
+        const quint32 sector = qFromBigEndian<quint32>(bat + qint64(i) * 4);
+        if (sector != VHD_UNUSED_BLOCK)
+            end = qMax(end, qint64(sector) * VHD_SECTOR + bitmapSize + blockSize);
+    }
+    end += VHD_SECTOR;
+    return matches(end) ? end : -1;
+}
+
+bool OvfDiskSource::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || this->isOpen())
+        return false;
+
+    this->d->file.setFileName(this->d->filePath);
+    if (!this->d->file.open(QIODevice::ReadOnly))
+    {
+        this->setErrorString(QString("Cannot open %1: %2").arg(this->d->filePath, this->d->file.errorString()));
+        return false;
+    }
+    if (!this->d->file.seek(this->d->offset) || this->d->offset + this->d->size > this->d->file.size())
+    {
+        this->setErrorString(QString("Disk data lies outside %1").arg(this->d->filePath));
+        this->d->file.close();
+        return false;
+    }
+
+    this->d->storedRemaining = this->d->size;
+    this->d->finished = false;
+    this->d->digestHex.clear();
+    this->d->hash.reset(this->d->hashing ? new QCryptographicHash(this->d->algorithm) : nullptr);
+    this->d->inBuf.clear();
+
+    if (this->d->gunzip)
+    {
+#ifdef XENADMIN_NO_ZLIB
+        this->setErrorString("Compressed disks are not supported in this build (zlib not available)");
+        this->d->file.close();
+        return false;
+#else
+        this->d->strm = z_stream {};
+        // 15 + 32: accept gzip or zlib headers
+        if (inflateInit2(&this->d->strm, 15 + 32) != Z_OK)
+        {
+            this->setErrorString("Failed to initialise decompressor");
+            this->d->file.close();
+            return false;
+        }
+        this->d->inflateReady = true;
+#endif
+    }
+
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void OvfDiskSource::close()
+{
+#ifndef XENADMIN_NO_ZLIB
+    if (this->d->inflateReady)
+    {
+        inflateEnd(&this->d->strm);
+        this->d->inflateReady = false;
+    }
+#endif
+    this->d->file.close();
+    QIODevice::close();
+}
+
+bool OvfDiskSource::atEnd() const
+{
+    return this->d->finished;
+}
+
+qint64 OvfDiskSource::writeData(const char*, qint64)
+{
+    return -1;
+}
+
+qint64 OvfDiskSource::readStored(char* data, qint64 maxSize)
+{
+    const qint64 want = qMin(maxSize, this->d->storedRemaining);
+    if (want <= 0)
+        return 0;
+
+    const qint64 n = this->d->file.read(data, want);
+    if (n <= 0)
+    {
+        this->setErrorString(QString("Read error in %1: %2").arg(this->d->filePath, this->d->file.errorString()));
+        return -1;
+    }
+
+    this->d->storedRemaining -= n;
+    if (this->d->hash)
+        this->d->hash->addData(data, static_cast<int>(n));
+    return n;
+}
+
+void OvfDiskSource::drainStored()
+{
+    // Trailing bytes after the last gzip member still belong to the file
+    // the manifest digest covers
+    QByteArray scratch(READ_CHUNK, Qt::Uninitialized);
+    while (this->d->storedRemaining > 0)
+    {
+        if (this->readStored(scratch.data(), scratch.size()) <= 0)
+            return;
+    }
+
+    this->d->finished = true;
+    if (this->d->hash)
+        this->d->digestHex = QString::fromLatin1(this->d->hash->result().toHex());
+}
+
+qint64 OvfDiskSource::readData(char* data, qint64 maxSize)
+{
+    if (this->d->finished || maxSize <= 0)
+        return 0;
+
+    if (!this->d->gunzip)
+    {
+        const qint64 n = this->readStored(data, maxSize);
+        if (n >= 0 && this->d->storedRemaining == 0)
+            this->drainStored();
+        return n;
+    }
+
+#ifdef XENADMIN_NO_ZLIB
+    return -1;
+#else
+    z_stream& strm = this->d->strm;
+    for (;;)
+    {
+        if (strm.avail_in == 0)
+        {
+            if (this->d->storedRemaining == 0)
+            {
+                this->setErrorString(QString("Compressed disk data in %1 is truncated").arg(this->d->filePath));
+                return -1;
+            }
+
+            this->d->inBuf.resize(READ_CHUNK);
+            const qint64 n = this->readStored(this->d->inBuf.data(), this->d->inBuf.size());
+            if (n < 0)
+                return -1;
+            strm.next_in = reinterpret_cast<Bytef*>(this->d->inBuf.data());
+            strm.avail_in = static_cast<uInt>(n);
+        }
+
+        const uInt outSpace = static_cast<uInt>(qMin<qint64>(maxSize, READ_CHUNK));
+        strm.next_out = reinterpret_cast<Bytef*>(data);
+        strm.avail_out = outSpace;
+
+        const int ret = inflate(&strm, Z_NO_FLUSH);
+        const qint64 produced = outSpace - strm.avail_out;
+
+        if (ret == Z_STREAM_END)
+        {
+            // Concatenated gzip members (e.g. from parallel compressors)
+            // continue right after the previous trailer
+            if (strm.avail_in == 0 && this->d->storedRemaining > 0)
+            {
+                this->d->inBuf.resize(READ_CHUNK);
+                const qint64 n = this->readStored(this->d->inBuf.data(), this->d->inBuf.size());
+                if (n < 0)
+                    return -1;
+                strm.next_in = reinterpret_cast<Bytef*>(this->d->inBuf.data());
+                strm.avail_in = static_cast<uInt>(n);
+            }
+
+            if (strm.avail_in >= 2 && strm.next_in[0] == 0x1f && strm.next_in[1] == 0x8b)
+            {
+                inflateReset(&strm);
+            } else
+            {
+                this->drainStored();
+                return produced;
+            }
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            this->setErrorString(QString("Corrupt compressed disk data in %1: %2")
+                                     .arg(this->d->filePath, QString::fromLatin1(strm.msg ? strm.msg : "inflate failed")));
+            return -1;
+        }
+
+        if (produced > 0)
+            return produced;
+    }
+#endif
+}
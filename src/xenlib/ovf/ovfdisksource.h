@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OVFDISKSOURCE_H
+#define OVFDISKSOURCE_H
+
+#include <QIODevice>
+#include <QCryptographicHash>
+#include <QString>
+
+/**
+ * @brief Read-only device over one disk file of an OVF package.
+ *
+ * The disk may be a whole file (folder packages) or a byte range inside an
+ * OVA archive, which is how ImportApplianceAction uploads disks straight
+ * out of the archive without extracting it first. Gzip-compressed disks
+ * (.vhd.gz) are inflated on the fly, and the stored bytes can be hashed as
+ * they go past so the manifest digest is checked without a second read.
+ */
+class OvfDiskSource : public QIODevice
+{
+    Q_OBJECT
+
+    public:
+        static const int READ_CHUNK = 256 * 1024;
+
+        /**
+         * @param filePath Package file (.vhd, .vhd.gz or .ova)
+         * @param offset   Start of the disk data inside @p filePath
+         * @param size     Number of stored bytes belonging to the disk
+         * @param gunzip   Inflate the stored bytes while reading
+         */
+        OvfDiskSource(const QString& filePath, qint64 offset, qint64 size,
+                      bool gunzip, QObject* parent = nullptr);
+        ~OvfDiskSource() override;
+
+        /** @brief Number of bytes the disk occupies in the package file. */
+        qint64 StoredSize() const;
+
+        /** @brief Hash the stored (still compressed) bytes with @p algorithm while reading. */
+        void SetDigestAlgorithm(QCryptographicHash::Algorithm algorithm);
+
+        /**
+         * @brief Hex digest of the stored bytes; valid once the device reached its end.
+         * @return Empty string if no digest algorithm was set or reading is incomplete
+         */
+        QString GetDigestHex() const;
+
+        /**
+         * @brief Number of bytes read() will produce in total.
+         *
+         * Equal to the stored size for plain disks. For compressed disks the
+         * gzip trailer only records the length modulo 4 GiB, so it is taken
+         * from the disk itself and checked against the trailer: a dynamic VHD
+         * is sized from its header and BAT, which only needs the start of the
+         * stream inflated, and a fixed VHD or raw disk from @p capacity. Only
+         * when neither matches (several gzip members, unknown layout) is the
+         * whole disk inflated once to count it.
+         *
+         * @param capacity Virtual size declared in the OVF, or -1 if unknown
+         * @return Size in bytes, or -1 on error (see @p errorOut)
+         */
+        qint64 ContentSize(QString& errorOut, qint64 capacity = -1) const;
+
+        bool open(OpenMode mode) override;
+        void close() override;
+        bool isSequential() const override { return true; }
+        bool atEnd() const override;
+
+    protected:
+        qint64 readData(char* data, qint64 maxSize) override;
+        qint64 writeData(const char* data, qint64 maxSize) override;
+
+    private:
+        qint64 contentSizeFromLayout(qint64 capacity) const;
+        qint64 readStored(char* data, qint64 maxSize);
+        void drainStored();
+
+        struct Private;
+        Private* d;
+};
+
+#endif // OVFDISKSOURCE_H
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ovfexportstream.h"
+#include "../utils/chunkqueue.h"
+#include "../utils/parallelgzip.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+
+// ── OvfStreamStageStats ──────────────────────────────────────────────────────
+
+double OvfStreamStageStats::BusyThroughputMBps() const
+{
+    if (this->busyNs <= 0)
+        return 0.0;
+    return (this->bytesIn / (1024.0 * 1024.0)) / (this->busyNs / 1e9);
+}
+
+void OvfStreamStageStats::Accumulate(const OvfStreamStageStats& other)
+{
+    if (this->stage.isEmpty())
+        this->stage = other.stage;
+    this->bytesIn  += other.bytesIn;
+    this->bytesOut += other.bytesOut;
+    this->busyNs   += other.busyNs;
+    this->stallNs  += other.stallNs;
+}
+
+QString OvfStreamStageStats::ToString() const
+{
+    return QString("%1: in %2 MiB, out %3 MiB, busy %4 s (%5 MiB/s), stalled %6 s")
+        .arg(this->stage)
+        .arg(this->bytesIn / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(this->bytesOut / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(this->busyNs / 1e9, 0, 'f', 2)
+        .arg(this->BusyThroughputMBps(), 0, 'f', 1)
+        .arg(this->stallNs / 1e9, 0, 'f', 2);
+}
+
+// ── OvfDiskStream ────────────────────────────────────────────────────────────
+
+struct OvfDiskStream::Private
+{
+    Private(bool compress, SinkFunction sink)
+        : compress(compress)
+        , sink(std::move(sink))
+        , rawQueue(QUEUE_DEPTH)
+        , packedQueue(QUEUE_DEPTH)
+        , sha(QCryptographicHash::Sha256)
+    {
+        this->network.stage    = QStringLiteral("network");
+        this->compressor.stage = QStringLiteral("compress");
+        this->hasher.stage     = QStringLiteral("hash");
+        this->writer.stage     = QStringLiteral("write");
+    }
+
+    void Fail(const QString& message)
+    {
+        {
+            QMutexLocker locker(&this->errorMutex);
+            if (this->failed)
+                return;
+            this->error = message;
+            this->failed = true;
+        }
+        this->rawQueue.Abort();
+        this->packedQueue.Abort();
+    }
+
+    QString Error()
+    {
+        QMutexLocker locker(&this->errorMutex);
+        return this->error;
+    }
+
+    bool compress;
+    SinkFunction sink;
+    ChunkQueue rawQueue;     // network  -> compress
+    ChunkQueue packedQueue;  // compress -> hash/write
+    QThread* compressThread = nullptr;
+    QThread* writeThread = nullptr;
+    QByteArray pending;
+    QCryptographicHash sha;
+    QString shaHex;
+    QElapsedTimer wall;
+
+    // Each stage's counters are only touched by the thread running that stage
+    // and read after joinWorkers(), so they need no locking.
+    OvfStreamStageStats network;
+    OvfStreamStageStats compressor;
+    OvfStreamStageStats hasher;
+    OvfStreamStageStats writer;
+
+    QMutex errorMutex;
+    QString error;
+    std::atomic<bool> failed{false};
+};
+
+OvfDiskStream::OvfDiskStream(bool compress, SinkFunction sink, QObject* parent)
+    : QIODevice(parent)
+    , d(new Private(compress, std::move(sink)))
+{
+}
+
+OvfDiskStream::~OvfDiskStream()
+{
+    if (this->d->compressThread || this->d->writeThread)
+        this->Abort();
+    delete this->d;
+}
+
+bool OvfDiskStream::Start()
+{
+#ifdef XENADMIN_NO_ZLIB
+    if (this->d->compress)
+    {
+        this->setErrorString(QStringLiteral("Gzip compression support is not available in this build"));
+        return false;
+    }
+#endif
+    if (!QIODevice::open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+        return false;
+
+    this->d->pending.reserve(CHUNK_SIZE);
+    this->d->wall.start();
+    this->d->compressThread = QThread::create([this]() { this->runCompressor(); });
+    this->d->writeThread    = QThread::create([this]() { this->runWriter(); });
+    this->d->compressThread->start();
+    this->d->writeThread->start();
+    return true;
+}
+
+qint64 OvfDiskStream::readData(char* data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+
+qint64 OvfDiskStream::writeData(const char* data, qint64 size)
+{
+    if (this->d->failed)
+    {
+        this->setErrorString(this->d->Error());
+        return -1;
+    }
+
+    this->d->pending.append(data, static_cast<int>(size));
+    this->d->network.bytesIn  += size;
+    this->d->network.bytesOut += size;
+
+    if (this->d->pending.size() >= CHUNK_SIZE)
+    {
+        if (!this->d->rawQueue.Push(this->d->pending, &this->d->network.stallNs))
+        {
+            this->setErrorString(this->d->Error());
+            return -1;
+        }
+        this->d->pending = QByteArray();
+        this->d->pending.reserve(CHUNK_SIZE);
+    }
+
+    return size;
+}
+
+void OvfDiskStream::runCompressor()
+{
+    Private* d = this->d;
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray chunk;
+
+    if (!d->compress)
+    {
+        while (d->rawQueue.Pop(chunk, &d->compressor.stallNs))
+        {
+            d->compressor.bytesIn  += chunk.size();
+            d->compressor.bytesOut += chunk.size();
+            if (!d->packedQueue.Push(chunk, &d->compressor.stallNs))
+                break;
+        }
+        d->packedQueue.Close();
+        d->compressor.busyNs = timer.nsecsElapsed() - d->compressor.stallNs;
+        return;
+    }
+
+    // Same level gzopen("wb9") produced; blocks are deflated on all cores and
+    // come back in order on this thread
+    ParallelGzip gzip([d](const char* data, qint64 size, QString& error) -> bool
+    {
+        d->compressor.bytesOut += size;
+        if (d->packedQueue.Push(QByteArray(data, static_cast<int>(size)), &d->compressor.stallNs))
+            return true;
+        error = d->Error();
+        return false;
+    }, 9);
+
+    bool ok = true;
+    while (ok && d->rawQueue.Pop(chunk, &d->compressor.stallNs))
+    {
+        d->compressor.bytesIn += chunk.size();
+        ok = gzip.Write(chunk.constData(), chunk.size());
+    }
+
+    if (ok && !d->rawQueue.IsAborted())
+        ok = gzip.Finish();
+    if (!ok && !d->failed)
+        d->Fail(gzip.GetError());
+
+    d->packedQueue.Close();
+    d->compressor.busyNs = timer.nsecsElapsed() - d->compressor.stallNs;
+}
+
+void OvfDiskStream::runWriter()
+{
+    Private* d = this->d;
+    QElapsedTimer timer;
+    QByteArray chunk;
+
+    while (d->packedQueue.Pop(chunk, &d->writer.stallNs))
+    {
+        timer.start();
+        d->sha.addData(chunk);
+        d->hasher.busyNs   += timer.nsecsElapsed();
+        d->hasher.bytesIn  += chunk.size();
+        d->hasher.bytesOut += chunk.size();
+
+        timer.start();
+        QString error;
+        if (!d->sink(chunk.constData(), chunk.size(), error))
+        {
+            d->Fail(error);
+            return;
+        }
+        d->writer.busyNs   += timer.nsecsElapsed();
+        d->writer.bytesIn  += chunk.size();
+        d->writer.bytesOut += chunk.size();
+    }
+
+    if (!d->packedQueue.IsAborted())
+        d->shaHex = QString::fromLatin1(d->sha.result().toHex());
+}
+
+void OvfDiskStream::joinWorkers()
+{
+    for (QThread** thread : { &this->d->compressThread, &this->d->writeThread })
+    {
+        if (!*thread)
+            continue;
+        (*thread)->wait();
+        delete *thread;
+        *thread = nullptr;
+    }
+}
+
+bool OvfDiskStream::Finish()
+{
+    if (!this->d->failed && !this->d->pending.isEmpty())
+        this->d->rawQueue.Push(this->d->pending, &this->d->network.stallNs);
+    this->d->pending = QByteArray();
+    this->d->rawQueue.Close();
+
+    this->joinWorkers();
+    this->d->network.busyNs = this->d->wall.nsecsElapsed() - this->d->network.stallNs;
+    QIODevice::close();
+
+    if (this->d->failed)
+    {
+        this->setErrorString(this->d->Error());
+        return false;
+    }
+    return true;
+}
+
+void OvfDiskStream::Abort()
+{
+    this->d->Fail(QStringLiteral("Operation cancelled by user"));
+    this->joinWorkers();
+    QIODevice::close();
+}
+
+QString OvfDiskStream::GetSha256Hex() const
+{
+    return this->d->shaHex;
+}
+
+QList<OvfStreamStageStats> OvfDiskStream::GetStageStats() const
+{
+    return { this->d->network, this->d->compressor, this->d->hasher, this->d->writer };
+}
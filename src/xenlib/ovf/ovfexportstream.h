@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OVFEXPORTSTREAM_H
+#define OVFEXPORTSTREAM_H
+
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Byte and timing counters for one stage of the export pipeline.
+ *
+ * @c busyNs is time the stage spent doing its own work, @c stallNs is time it
+ * sat blocked on a neighbouring stage (input queue empty or output queue full).
+ * A stage with high busy time and low stall time is the bottleneck.
+ */
+struct OvfStreamStageStats
+{
+    QString stage;
+    qint64 bytesIn  = 0;
+    qint64 bytesOut = 0;
+    qint64 busyNs   = 0;
+    qint64 stallNs  = 0;
+
+    /** @brief Input throughput in MiB/s counting busy time only. */
+    double BusyThroughputMBps() const;
+
+    void Accumulate(const OvfStreamStageStats& other);
+
+    /** @brief One-line human readable summary for logs. */
+    QString ToString() const;
+};
+
+/**
+ * @brief Write-only device that streams one exported disk into its final destination.
+ *
+ * Used by ExportApplianceAction so that the @c /export_raw_vdi response is
+ * compressed, hashed and written (into a plain file or straight into an OVA
+ * member) in a single pass instead of being downloaded, re-read for gzip,
+ * re-read for the manifest and re-read again for the TAR.
+ *
+ * Stages and threads:
+ *   - network  — the caller's thread, feeding writeData() from HttpClient
+ *   - compress — worker thread feeding ParallelGzip, which deflates blocks
+ *                on all cores (or pass-through)
+ *   - hash     — second worker thread computing SHA-256 of the stored bytes
+ *   - write    — same thread as hash, handing bytes to the sink
+ *
+ * Stages are linked by bounded ChunkQueue instances so network, CPU and disk
+ * work overlap while memory stays bounded.
+ */
+class OvfDiskStream : public QIODevice
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * @brief Receives stored (possibly compressed) bytes on the writer thread.
+         * @return false and set @p error to abort the stream
+         */
+        using SinkFunction = std::function<bool(const char* data, qint64 size, QString& error)>;
+
+        static const int CHUNK_SIZE  = 1024 * 1024;
+        static const int QUEUE_DEPTH = 8;
+
+        /**
+         * @param compress Gzip the data before hashing and writing
+         * @param sink     Destination for the stored bytes
+         * @param parent   Parent QObject
+         */
+        OvfDiskStream(bool compress, SinkFunction sink, QObject* parent = nullptr);
+        ~OvfDiskStream() override;
+
+        /** @brief Open the device and start the worker threads. */
+        bool Start();
+
+        /**
+         * @brief Flush remaining data through all stages and join the workers.
+         * @return false if any stage failed; see errorString()
+         */
+        bool Finish();
+
+        /** @brief Stop all stages immediately, discarding in-flight data. */
+        void Abort();
+
+        /** @brief Lowercase hex SHA-256 of the stored bytes (valid after Finish()). */
+        QString GetSha256Hex() const;
+
+        /** @brief Per-stage counters (valid after Finish()). */
+        QList<OvfStreamStageStats> GetStageStats() const;
+
+        bool isSequential() const override { return true; }
+
+    protected:
+        qint64 readData(char* data, qint64 maxSize) override;
+        qint64 writeData(const char* data, qint64 size) override;
+
+    private:
+        void runCompressor();
+        void runWriter();
+        void joinWorkers();
+
+        struct Private;
+        Private* d;
+};
+
+#endif // OVFEXPORTSTREAM_H
@@ -26,6 +26,7 @@
  */
 
 #include "ovfpackage.h"
+#include "ovatar.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
@@ -81,11 +82,9 @@ static bool readTarHeader(QFile& file, QString& entryName, qint64& entrySize)
             entryName = prefixStr + "/" + entryName;
     }
 
-    // Size field: 12 bytes at offset 124, octal ASCII
-    QByteArray sizeField = header.mid(124, 12);
-    bool ok = false;
-    entrySize = QString::fromLatin1(sizeField.constData(), qstrnlen(sizeField.constData(), 12)).toLongLong(&ok, 8);
-    if (!ok)
+    // Size field: 12 bytes at offset 124, octal ASCII or GNU base-256 for large disks
+    entrySize = OvaTar::ParseSize(header.constData() + 124);
+    if (entrySize < 0)
         entrySize = 0;
 
     return true;
@@ -1014,36 +1013,18 @@ bool OvfPackage::ExtractAllToDir(const QString& ovaPath,
     return true;
 }
 
-// ─── OvfPackage::VerifyManifest ───────────────────────────────────────────────
+// ─── OvfPackage::ParseManifest ────────────────────────────────────────────────
 
-bool OvfPackage::VerifyManifest(const QString& workingDir,
-                                const QString& baseName,
-                                QString& errorOut,
-                                std::function<bool()> cancelCheck)
+QList<OvfManifestEntry> OvfPackage::ParseManifest(const QByteArray& content)
 {
-    const QString mfPath = QDir(workingDir).filePath(baseName + ".mf");
-    QFile mfFile(mfPath);
-    if (!mfFile.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        errorOut = QString("Cannot open manifest file '%1': %2").arg(mfPath, mfFile.errorString());
-        return false;
-    }
-
-    // ── Parse manifest lines ─────────────────────────────────────────────────
     // Line format: ALGORITHM(filename)= hexdigest
     // e.g.  SHA256(mypackage.ovf)= abcdef0123...
     //        SHA1(disk-1.vhd)= 01234567...
-    struct Digest
-    {
-        QString algorithm;    // "SHA1", "SHA256", etc.
-        QString fileName;
-        QString hexDigest;
-    };
-
-    QList<Digest> entries;
-    while (!mfFile.atEnd())
+    QList<OvfManifestEntry> entries;
+    const QList<QByteArray> lines = content.split('\n');
+    for (const QByteArray& line : lines)
     {
-        const QString rawLine = QString::fromUtf8(mfFile.readLine()).trimmed();
+        const QString rawLine = QString::fromUtf8(line).trimmed();
         if (rawLine.isEmpty())
             continue;
 
@@ -1053,11 +1034,11 @@ bool OvfPackage::VerifyManifest(const QString& workingDir,
         const int equals     = rawLine.indexOf('=', parenClose);
         if (parenOpen < 0 || parenClose < 0 || equals < 0)
         {
-            qWarning() << "OvfPackage::VerifyManifest: skipping unrecognised manifest line:" << rawLine;
+            qWarning() << "OvfPackage::ParseManifest: skipping unrecognised manifest line:" << rawLine;
             continue;
         }
 
-        Digest d;
+        OvfManifestEntry d;
         d.algorithm  = rawLine.left(parenOpen).trimmed().toUpper();
         d.fileName   = rawLine.mid(parenOpen + 1, parenClose - parenOpen - 1).trimmed();
         d.hexDigest  = rawLine.mid(equals + 1).trimmed();
@@ -1065,6 +1046,41 @@ bool OvfPackage::VerifyManifest(const QString& workingDir,
             continue;
         entries.append(d);
     }
+    return entries;
+}
+
+bool OvfPackage::DigestAlgorithmFromName(const QString& name, QCryptographicHash::Algorithm& algoOut)
+{
+    const QString algUpper = name.toUpper();
+    if (algUpper == "SHA1" || algUpper == "SHA-1")
+        algoOut = QCryptographicHash::Sha1;
+    else if (algUpper == "SHA256" || algUpper == "SHA-256")
+        algoOut = QCryptographicHash::Sha256;
+    else if (algUpper == "SHA512" || algUpper == "SHA-512")
+        algoOut = QCryptographicHash::Sha512;
+    else if (algUpper == "MD5")
+        algoOut = QCryptographicHash::Md5;
+    else
+        return false;
+    return true;
+}
+
+// ─── OvfPackage::VerifyManifest ───────────────────────────────────────────────
+
+bool OvfPackage::VerifyManifest(const QString& workingDir,
+                                const QString& baseName,
+                                QString& errorOut,
+                                std::function<bool()> cancelCheck)
+{
+    const QString mfPath = QDir(workingDir).filePath(baseName + ".mf");
+    QFile mfFile(mfPath);
+    if (!mfFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        errorOut = QString("Cannot open manifest file '%1': %2").arg(mfPath, mfFile.errorString());
+        return false;
+    }
+
+    const QList<OvfManifestEntry> entries = ParseManifest(mfFile.readAll());
     mfFile.close();
 
     if (entries.isEmpty())
@@ -1074,7 +1090,7 @@ bool OvfPackage::VerifyManifest(const QString& workingDir,
     }
 
     // ── Verify each listed file ───────────────────────────────────────────────
-    for (const Digest& d : entries)
+    for (const OvfManifestEntry& d : entries)
     {
         if (cancelCheck && cancelCheck())
         {
@@ -1082,18 +1098,8 @@ bool OvfPackage::VerifyManifest(const QString& workingDir,
             return false;
         }
 
-        // Map algorithm name to Qt enum
         QCryptographicHash::Algorithm algo;
-        const QString algUpper = d.algorithm.toUpper();
-        if (algUpper == "SHA1" || algUpper == "SHA-1")
-            algo = QCryptographicHash::Sha1;
-        else if (algUpper == "SHA256" || algUpper == "SHA-256")
-            algo = QCryptographicHash::Sha256;
-        else if (algUpper == "SHA512" || algUpper == "SHA-512")
-            algo = QCryptographicHash::Sha512;
-        else if (algUpper == "MD5")
-            algo = QCryptographicHash::Md5;
-        else
+        if (!DigestAlgorithmFromName(d.algorithm, algo))
         {
             errorOut = QString("Unsupported digest algorithm '%1' in manifest.").arg(d.algorithm);
             return false;
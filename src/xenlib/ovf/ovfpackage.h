@@ -32,6 +32,8 @@
 #include <QStringList>
 #include <QDomDocument>
 #include <QMap>
+#include <QList>
+#include <QCryptographicHash>
 #include <functional>
 
 /**
@@ -88,6 +90,16 @@ struct OvfVirtualHardware
     int ethernetCount = 0;
 };
 
+/**
+ * @brief One line of an OVF manifest (.mf): @c ALGORITHM(fileName)= hexDigest.
+ */
+struct OvfManifestEntry
+{
+    QString algorithm;   ///< Upper-cased algorithm name as written ("SHA1", "SHA256", ...)
+    QString fileName;
+    QString hexDigest;
+};
+
 /**
  * @brief Minimal OVF/OVA package reader for import wizard source validation.
  *
@@ -298,6 +310,19 @@ class OvfPackage
                                    QString& errorOut,
                                    std::function<bool()> cancelCheck = nullptr);
 
+        /**
+         * @brief Parse manifest content into its entries.
+         *
+         * Unrecognised lines are skipped with a warning.
+         */
+        static QList<OvfManifestEntry> ParseManifest(const QByteArray& content);
+
+        /**
+         * @brief Map a manifest algorithm name (SHA1, SHA-256, MD5, ...) to a Qt hash algorithm.
+         * @return false if the algorithm is not supported
+         */
+        static bool DigestAlgorithmFromName(const QString& name, QCryptographicHash::Algorithm& algoOut);
+
         /**
          * @brief Extract all files from a TAR (.ova) archive to a directory.
          *
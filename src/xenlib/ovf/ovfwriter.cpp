@@ -26,6 +26,8 @@
  */
 
 #include "ovfwriter.h"
+#include "ovatar.h"
+#include "../utils/parallelgzip.h"
 
 #include <QXmlStreamWriter>
 #include <QFile>
@@ -34,6 +36,7 @@
 #include <QCryptographicHash>
 #include <QTextStream>
 #include <QByteArray>
+#include <QHash>
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QTextCodec>
 #endif
@@ -349,6 +352,11 @@ void OvfWriter::writeVirtualSystem(QXmlStreamWriter& xml, const OvfVirtualSystem
 
 // ── Manifest ─────────────────────────────────────────────────────────────────
 
+QString OvfWriter::manifestLine(const QString& fileName, const QString& sha256Hex)
+{
+    return QStringLiteral("SHA256 (%1)= %2").arg(fileName, sha256Hex);
+}
+
 bool OvfWriter::createManifest(const OvfEnvelopeData& envelope,
                                const QString& packageDir,
                                const QString& ovfFileName) const
@@ -374,8 +382,7 @@ bool OvfWriter::createManifest(const OvfEnvelopeData& envelope,
         if (!hash.addData(&f))
             continue;
 
-        const QString hex = QString::fromLatin1(hash.result().toHex());
-        lines << QStringLiteral("SHA256 (%1)= %2").arg(name, hex);
+        lines << manifestLine(name, QString::fromLatin1(hash.result().toHex()));
     }
 
     const QString baseName = QFileInfo(ovfFileName).baseName();
@@ -394,53 +401,6 @@ bool OvfWriter::createManifest(const OvfEnvelopeData& envelope,
 
 // ── OVA (POSIX TAR) packaging ────────────────────────────────────────────────
 
-// Writes a 512-byte POSIX ustar header into buf for the given filename and size.
-// Returns the octal checksum value (already embedded in buf).
-static void fillTarHeader(char buf[512], const QString& name, qint64 fileSize)
-{
-    std::memset(buf, 0, 512);
-
-    // name field: 100 bytes
-    QByteArray nameBytes = name.toLocal8Bit();
-    if (nameBytes.size() > 99)
-        nameBytes = nameBytes.left(99);
-    std::memcpy(buf, nameBytes.constData(), nameBytes.size());
-
-    // mode: 0000644
-    std::memcpy(buf + 100, "0000644\0", 8);
-
-    // uid/gid
-    std::memcpy(buf + 108, "0000000\0", 8);
-    std::memcpy(buf + 116, "0000000\0", 8);
-
-    // size: octal, 11 digits + space
-    QByteArray sizeStr = QByteArray::number(fileSize, 8).rightJustified(11, '0');
-    std::memcpy(buf + 124, sizeStr.constData(), 11);
-    buf[135] = ' ';
-
-    // mtime: 0
-    std::memcpy(buf + 136, "00000000000\0", 12);
-
-    // checksum placeholder: all spaces
-    std::memset(buf + 148, ' ', 8);
-
-    // type flag: '0' = regular file
-    buf[156] = '0';
-
-    // ustar magic + version
-    std::memcpy(buf + 257, "ustar  \0", 8);
-
-    // Calculate checksum over the 512-byte header with spaces in checksum field
-    unsigned int checksum = 0;
-    for (int i = 0; i < 512; ++i)
-        checksum += static_cast<unsigned char>(buf[i]);
-
-    QByteArray csStr = QByteArray::number(checksum, 8).rightJustified(6, '0');
-    std::memcpy(buf + 148, csStr.constData(), 6);
-    buf[154] = '\0';
-    buf[155] = ' ';
-}
-
 bool OvfWriter::writeTarEntry(QFile& tarFile,
                               const QString& memberPath,
                               const QString& memberName) const
@@ -451,7 +411,7 @@ bool OvfWriter::writeTarEntry(QFile& tarFile,
 
     const qint64 fileSize = src.size();
     char header[512];
-    fillTarHeader(header, memberName, fileSize);
+    OvaTar::FillHeader(header, memberName, fileSize);
 
     if (tarFile.write(header, 512) != 512)
         return false;
@@ -538,8 +498,6 @@ bool OvfWriter::compressVhds(OvfEnvelopeData& envelope, const QString& packageDi
     qWarning() << "OvfWriter::compressVhds: gzip compression support is not available in this build";
     return false;
 #else
-    static const int BUF_SIZE = 64 * 1024;
-
     for (OvfVirtualSystemEntry& sys : envelope.systems)
     {
         for (OvfDiskEntry& disk : sys.disks)
@@ -553,39 +511,11 @@ bool OvfWriter::compressVhds(OvfEnvelopeData& envelope, const QString& packageDi
             if (!QFile::exists(srcPath))
                 continue;
 
-            QFile src(srcPath);
-            if (!src.open(QIODevice::ReadOnly))
+            // Level 9 as gzopen("wb9") used to, deflated on all cores
+            QString error;
+            if (!ParallelGzip::CompressFile(srcPath, gzPath, 9, error))
             {
-                qWarning() << "OvfWriter::compressVhds: cannot open" << srcPath;
-                return false;
-            }
-
-            gzFile gz = gzopen(gzPath.toLocal8Bit().constData(), "wb9");
-            if (!gz)
-            {
-                qWarning() << "OvfWriter::compressVhds: cannot create" << gzPath;
-                return false;
-            }
-
-            QByteArray buf(BUF_SIZE, 0);
-            bool ok = true;
-            while (!src.atEnd())
-            {
-                const qint64 n = src.read(buf.data(), BUF_SIZE);
-                if (n <= 0)
-                    break;
-                if (gzwrite(gz, buf.constData(), static_cast<unsigned int>(n)) != static_cast<int>(n))
-                {
-                    ok = false;
-                    break;
-                }
-            }
-            gzclose(gz);
-            src.close();
-
-            if (!ok)
-            {
-                QFile::remove(gzPath);
+                qWarning() << "OvfWriter::compressVhds:" << error;
                 return false;
             }
 
@@ -667,6 +597,105 @@ bool OvfWriter::verifyPackage(const QString& packageDir,
     return true;
 }
 
+bool OvfWriter::verifyOva(const QString& ovaPath, QString& errorMsg) const
+{
+    QFile ova(ovaPath);
+    if (!ova.open(QIODevice::ReadOnly))
+    {
+        errorMsg = QString("Cannot open OVA archive: %1").arg(ovaPath);
+        return false;
+    }
+
+    // Single sequential pass: hash every member as it goes by and keep the
+    // manifest text (it is written after the disks, so compare at the end).
+    QHash<QString, QString> actualByName;
+    QByteArray manifest;
+    QByteArray buf(1024 * 1024, Qt::Uninitialized);
+
+    while (true)
+    {
+        const QByteArray header = ova.read(OvaTar::BLOCK_SIZE);
+        if (header.size() < OvaTar::BLOCK_SIZE || header.count('\0') == OvaTar::BLOCK_SIZE)
+            break;
+
+        const QString name = QString::fromLocal8Bit(header.constData(),
+                                                    static_cast<int>(qstrnlen(header.constData(), 100)));
+        const qint64 size = OvaTar::ParseSize(header.constData() + 124);
+        if (size < 0)
+        {
+            errorMsg = QString("Corrupt TAR header for %1").arg(name);
+            return false;
+        }
+
+        const bool isManifest = name.endsWith(QStringLiteral(".mf"), Qt::CaseInsensitive);
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        qint64 remaining = size;
+        while (remaining > 0)
+        {
+            const qint64 n = ova.read(buf.data(), qMin<qint64>(buf.size(), remaining));
+            if (n <= 0)
+            {
+                errorMsg = QString("Unexpected end of archive in %1").arg(name);
+                return false;
+            }
+            hash.addData(QByteArray::fromRawData(buf.constData(), static_cast<int>(n)));
+            if (isManifest)
+                manifest.append(buf.constData(), n);
+            remaining -= n;
+        }
+        actualByName.insert(name, QString::fromLatin1(hash.result().toHex()));
+
+        const qint64 padding = OvaTar::PaddingFor(size);
+        if (padding > 0 && !ova.seek(ova.pos() + padding))
+        {
+            errorMsg = QString("Unexpected end of archive after %1").arg(name);
+            return false;
+        }
+    }
+
+    if (manifest.isEmpty())
+    {
+        errorMsg = QStringLiteral("OVA archive contains no manifest");
+        return false;
+    }
+
+    static const QRegularExpression re(
+        QStringLiteral(R"(^SHA256\s+\(([^)]+)\)\s*=\s*([0-9a-fA-F]+)$)"));
+
+    const QList<QByteArray> lines = manifest.split('\n');
+    for (const QByteArray& raw : lines)
+    {
+        const QString line = QString::fromUtf8(raw).trimmed();
+        if (line.isEmpty())
+            continue;
+
+        const QRegularExpressionMatch m = re.match(line);
+        if (!m.hasMatch())
+        {
+            errorMsg = QString("Unrecognised manifest line: %1").arg(line);
+            return false;
+        }
+
+        const QString name     = m.captured(1);
+        const QString expected = m.captured(2).toLower();
+        if (!actualByName.contains(name))
+        {
+            errorMsg = QString("File listed in manifest not found: %1").arg(name);
+            return false;
+        }
+
+        const QString actual = actualByName.value(name);
+        if (actual != expected)
+        {
+            errorMsg = QString("Checksum mismatch for %1: expected %2, got %3")
+                       .arg(name, expected, actual);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 // ── Signing ──────────────────────────────────────────────────────────────────
 
 bool OvfWriter::signPackage(const QString& packageDir,
@@ -675,13 +704,45 @@ bool OvfWriter::signPackage(const QString& packageDir,
                             const QString& password,
                             QString& errorMsg) const
 {
-#ifdef XENADMIN_OPENSSL_AVAILABLE
     const QString baseName  = QFileInfo(ovfFileName).baseName();
     const QString mfName    = baseName + QStringLiteral(".mf");
     const QString mfPath    = packageDir + QDir::separator() + mfName;
     const QString certOutPath = packageDir + QDir::separator()
                                + baseName + QStringLiteral(".cert");
 
+    // ── Read manifest ────────────────────────────────────────────────────────
+    QFile mf(mfPath);
+    if (!mf.open(QIODevice::ReadOnly))
+    {
+        errorMsg = QString("Cannot open manifest for signing: %1").arg(mfPath);
+        return false;
+    }
+    const QByteArray mfData = mf.readAll();
+    mf.close();
+
+    QByteArray certData;
+    if (!this->signManifest(mfName, mfData, p12Path, password, certData, errorMsg))
+        return false;
+
+    // ── Write .cert file ─────────────────────────────────────────────────────
+    QFile certOut(certOutPath);
+    if (!certOut.open(QIODevice::WriteOnly))
+    {
+        errorMsg = QString("Cannot write .cert file: %1").arg(certOutPath);
+        return false;
+    }
+    certOut.write(certData);
+    return true;
+}
+
+bool OvfWriter::signManifest(const QString& mfName,
+                             const QByteArray& mfData,
+                             const QString& p12Path,
+                             const QString& password,
+                             QByteArray& certData,
+                             QString& errorMsg) const
+{
+#ifdef XENADMIN_OPENSSL_AVAILABLE
     // ── Load PKCS12 ──────────────────────────────────────────────────────────
     FILE* fp = fopen(p12Path.toLocal8Bit().constData(), "rb");
     if (!fp)
@@ -707,18 +768,6 @@ bool OvfWriter::signPackage(const QString& packageDir,
     }
     PKCS12_free(p12);
 
-    // ── Read manifest ────────────────────────────────────────────────────────
-    QFile mf(mfPath);
-    if (!mf.open(QIODevice::ReadOnly))
-    {
-        EVP_PKEY_free(pkey);
-        X509_free(cert);
-        errorMsg = QString("Cannot open manifest for signing: %1").arg(mfPath);
-        return false;
-    }
-    const QByteArray mfData = mf.readAll();
-    mf.close();
-
     // ── RSA-SHA256 sign ──────────────────────────────────────────────────────
     EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
     if (!mdctx || EVP_DigestSignInit(mdctx, nullptr, EVP_sha256(), nullptr, pkey) <= 0)
@@ -752,29 +801,24 @@ bool OvfWriter::signPackage(const QString& packageDir,
     EVP_PKEY_free(pkey);
     X509_free(cert);
 
-    // ── Write .cert file ─────────────────────────────────────────────────────
+    // ── Build .cert content ──────────────────────────────────────────────────
     // Format matches C# FileDigest.ToManifestLine() + PEM certificate block.
-    QFile certOut(certOutPath);
-    if (!certOut.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        errorMsg = QString("Cannot write .cert file: %1").arg(certOutPath);
-        return false;
-    }
-    QTextStream ts(&certOut);
-    ts << "SHA256 (" << mfName << ")= " << QString::fromLatin1(sig.toHex()) << "\n";
-    ts << "-----BEGIN CERTIFICATE-----\n";
-    const QString b64 = QString::fromLatin1(derCert.toBase64());
+    certData.clear();
+    certData += "SHA256 (" + mfName.toUtf8() + ")= " + sig.toHex() + "\n";
+    certData += "-----BEGIN CERTIFICATE-----\n";
+    const QByteArray b64 = derCert.toBase64();
     for (int i = 0; i < b64.length(); i += 64)
-        ts << b64.mid(i, 64) << "\n";
-    ts << "-----END CERTIFICATE-----\n";
+        certData += b64.mid(i, 64) + "\n";
+    certData += "-----END CERTIFICATE-----\n";
 
     return true;
 
 #else
-    Q_UNUSED(packageDir);
-    Q_UNUSED(ovfFileName);
+    Q_UNUSED(mfName);
+    Q_UNUSED(mfData);
     Q_UNUSED(p12Path);
     Q_UNUSED(password);
+    Q_UNUSED(certData);
     errorMsg = QStringLiteral("Certificate signing requires OpenSSL. "
                                "This build does not include OpenSSL support.");
     return false;
@@ -32,6 +32,7 @@
 #include <QStringList>
 #include <QList>
 #include <QPair>
+#include <QByteArray>
 
 class QXmlStreamWriter;
 class QFile;
@@ -163,6 +164,11 @@ class OvfWriter
                             const QString& packageDir,
                             const QString& ovfFileName) const;
 
+        /**
+         * @brief Format one manifest entry: @c "SHA256 (name)= hex".
+         */
+        static QString manifestLine(const QString& fileName, const QString& sha256Hex);
+
         // ── OVA packaging ───────────────────────────────────────────────────
 
         /**
@@ -190,6 +196,8 @@ class OvfWriter
          * @brief Gzip-compress all non-CDROM disk files in the package.
          *
          * Each .vhd file is compressed to .vhd.gz in-place and deleted.
+         * Blocks are deflated in parallel by ParallelGzip; the output is a
+         * standard single-member gzip file.
          * The corresponding @c href field in @p envelope is updated to the
          * new compressed name so that a subsequent @c saveToFile() call
          * writes the correct References/DiskSection entries.
@@ -218,6 +226,18 @@ class OvfWriter
                            const QString& ovfFileName,
                            QString& errorMsg) const;
 
+        /**
+         * @brief Verify an OVA archive against the manifest stored inside it.
+         *
+         * Reads the archive once, hashing every member on the way, and
+         * compares the results with the embedded .mf entries.
+         *
+         * @param ovaPath   Path to the .ova file.
+         * @param errorMsg  Populated with a human-readable error on failure.
+         * @return true if all checksums match.
+         */
+        bool verifyOva(const QString& ovaPath, QString& errorMsg) const;
+
         // ── Signing ─────────────────────────────────────────────────────────
 
         /**
@@ -245,6 +265,28 @@ class OvfWriter
                          const QString& password,
                          QString& errorMsg) const;
 
+        /**
+         * @brief Sign manifest content held in memory.
+         *
+         * Same as signPackage() but takes the manifest bytes directly and
+         * returns the .cert content instead of writing files, so a streamed
+         * OVA can embed the signature without a temporary folder.
+         *
+         * @param mfName    Manifest file name recorded in the signature line.
+         * @param mfData    Manifest content to sign.
+         * @param p12Path   Path to the PKCS#12 (.p12/.pfx) certificate file.
+         * @param password  Password protecting the PKCS#12 file.
+         * @param certData  Receives the .cert file content.
+         * @param errorMsg  Populated with a human-readable error on failure.
+         * @return true on success.
+         */
+        bool signManifest(const QString& mfName,
+                          const QByteArray& mfData,
+                          const QString& p12Path,
+                          const QString& password,
+                          QByteArray& certData,
+                          QString& errorMsg) const;
+
     private:
         void writeReferences(QXmlStreamWriter& xml, const OvfEnvelopeData& env) const;
         void writeDiskSection(QXmlStreamWriter& xml, const OvfEnvelopeData& env) const;
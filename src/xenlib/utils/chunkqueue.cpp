@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "chunkqueue.h"
+#include <QElapsedTimer>
+
+ChunkQueue::ChunkQueue(int capacity) : m_capacity(qMax(1, capacity))
+{
+}
+
+bool ChunkQueue::Push(const QByteArray& chunk, qint64* stallNs)
+{
+    QMutexLocker locker(&this->m_mutex);
+
+    if (this->m_chunks.size() >= this->m_capacity && !this->m_aborted && !this->m_closed)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (this->m_chunks.size() >= this->m_capacity && !this->m_aborted && !this->m_closed)
+            this->m_notFull.wait(&this->m_mutex);
+        if (stallNs)
+            *stallNs += timer.nsecsElapsed();
+    }
+
+    if (this->m_aborted || this->m_closed)
+        return false;
+
+    this->m_chunks.enqueue(chunk);
+    this->m_notEmpty.wakeOne();
+    return true;
+}
+
+bool ChunkQueue::Pop(QByteArray& chunk, qint64* stallNs)
+{
+    QMutexLocker locker(&this->m_mutex);
+
+    if (this->m_chunks.isEmpty() && !this->m_aborted && !this->m_closed)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (this->m_chunks.isEmpty() && !this->m_aborted && !this->m_closed)
+            this->m_notEmpty.wait(&this->m_mutex);
+        if (stallNs)
+            *stallNs += timer.nsecsElapsed();
+    }
+
+    if (this->m_aborted || this->m_chunks.isEmpty())
+        return false;
+
+    chunk = this->m_chunks.dequeue();
+    this->m_notFull.wakeOne();
+    return true;
+}
+
+void ChunkQueue::Close()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_closed = true;
+    this->m_notEmpty.wakeAll();
+    this->m_notFull.wakeAll();
+}
+
+void ChunkQueue::Abort()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_aborted = true;
+    this->m_chunks.clear();
+    this->m_notEmpty.wakeAll();
+    this->m_notFull.wakeAll();
+}
+
+bool ChunkQueue::IsAborted() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_aborted;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CHUNKQUEUE_H
+#define CHUNKQUEUE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+/**
+ * @brief Bounded, thread-safe FIFO of data chunks linking two pipeline stages.
+ *
+ * The producer blocks in Push() while the queue is full and the consumer blocks
+ * in Pop() while it is empty, so memory stays bounded at roughly
+ * capacity × chunk size no matter which side is faster. Time spent blocked is
+ * reported back to the caller so each stage can account for its stalls.
+ *
+ * Close() marks the end of the stream (Pop() drains what is left, then returns
+ * false); Abort() wakes both sides immediately and discards pending chunks.
+ */
+class ChunkQueue
+{
+    public:
+        explicit ChunkQueue(int capacity);
+
+        /**
+         * @brief Append a chunk, blocking while the queue is full.
+         * @param chunk   Data to enqueue (implicitly shared, not copied)
+         * @param stallNs If non-null, incremented by the time spent waiting
+         * @return false if the queue was aborted or closed
+         */
+        bool Push(const QByteArray& chunk, qint64* stallNs = nullptr);
+
+        /**
+         * @brief Take the oldest chunk, blocking while the queue is empty.
+         * @param chunk   Receives the dequeued data
+         * @param stallNs If non-null, incremented by the time spent waiting
+         * @return false once the queue is closed and drained, or aborted
+         */
+        bool Pop(QByteArray& chunk, qint64* stallNs = nullptr);
+
+        /** @brief Signal end of stream; no further Push() calls are accepted. */
+        void Close();
+
+        /** @brief Abort both sides and drop any queued chunks. */
+        void Abort();
+
+        bool IsAborted() const;
+
+    private:
+        mutable QMutex m_mutex;
+        QWaitCondition m_notEmpty;
+        QWaitCondition m_notFull;
+        QQueue<QByteArray> m_chunks;
+        int m_capacity;
+        bool m_closed = false;
+        bool m_aborted = false;
+};
+
+#endif // CHUNKQUEUE_H
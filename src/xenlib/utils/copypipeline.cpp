@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "copypipeline.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+QString CopyPipeline::StageStats::ToString() const
+{
+    const double busySeconds = this->busyNs / 1e9;
+    return QString("%1: %2 MiB in %3 calls, busy %4 s (%5 MiB/s), stalled %6 s")
+        .arg(this->stage)
+        .arg(this->bytes / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(this->calls)
+        .arg(busySeconds, 0, 'f', 2)
+        .arg(busySeconds > 0 ? (this->bytes / (1024.0 * 1024.0)) / busySeconds : 0.0, 0, 'f', 1)
+        .arg(this->stallNs / 1e9, 0, 'f', 2);
+}
+
+CopyPipeline::CopyPipeline(ReadFunction read, WriteFunction write)
+    : m_read(std::move(read))
+    , m_write(std::move(write))
+    , m_free(RING_SIZE)
+    , m_filled(RING_SIZE)
+{
+    this->m_readStats.stage  = QStringLiteral("read");
+    this->m_writeStats.stage = QStringLiteral("write");
+}
+
+bool CopyPipeline::Run(Worker worker)
+{
+    QElapsedTimer wall;
+    wall.start();
+
+    if (worker == Worker::None)
+    {
+        this->runInline();
+        this->m_elapsedNs = wall.nsecsElapsed();
+        return !this->m_failed;
+    }
+
+    // Buffers start empty and are sized by the reader on first use
+    for (int i = 0; i < RING_SIZE; ++i)
+        this->m_free.Push(QByteArray());
+
+    QThread* thread = worker == Worker::Reader
+        ? QThread::create([this]() { this->runReader(); })
+        : QThread::create([this]() { this->runWriter(); });
+    thread->start();
+
+    if (worker == Worker::Reader)
+        this->runWriter();
+    else
+        this->runReader();
+
+    thread->wait();
+    delete thread;
+
+    this->m_elapsedNs = wall.nsecsElapsed();
+    return !this->m_failed;
+}
+
+QString CopyPipeline::GetError() const
+{
+    QMutexLocker locker(&this->m_errorMutex);
+    return this->m_error;
+}
+
+void CopyPipeline::fail(const QString& error)
+{
+    {
+        QMutexLocker locker(&this->m_errorMutex);
+        if (this->m_failed)
+            return;
+        this->m_error = error;
+        this->m_failed = true;
+    }
+    this->m_free.Abort();
+    this->m_filled.Abort();
+}
+
+int CopyPipeline::nextBufferSize(int current, qint64 lastRead) const
+{
+    if (lastRead >= current && current < MAX_BUFFER_SIZE)
+        return current * 2;
+    if (lastRead < current / 4 && current > MIN_BUFFER_SIZE)
+        return current / 2;
+    return current;
+}
+
+void CopyPipeline::runReader()
+{
+    QElapsedTimer timer;
+    QByteArray buffer;
+    int size = MIN_BUFFER_SIZE;
+
+    while (this->m_free.Pop(buffer, &this->m_readStats.stallNs))
+    {
+        buffer.resize(size);
+
+        QString error;
+        timer.start();
+        const qint64 bytesRead = this->m_read(buffer.data(), size, error);
+        this->m_readStats.busyNs += timer.nsecsElapsed();
+        ++this->m_readStats.calls;
+
+        if (bytesRead < 0)
+        {
+            this->fail(error);
+            return;
+        }
+
+        if (bytesRead == 0)
+            break;
+
+        this->m_readStats.bytes += bytesRead;
+        this->m_peakBufferSize = qMax(this->m_peakBufferSize, size);
+        size = this->nextBufferSize(size, bytesRead);
+
+        buffer.resize(static_cast<int>(bytesRead));
+        if (!this->m_filled.Push(buffer, &this->m_readStats.stallNs))
+            return;
+        // Drop this side's reference so the writer hands back an unshared buffer
+        buffer = QByteArray();
+    }
+
+    this->m_filled.Close();
+}
+
+void CopyPipeline::runWriter()
+{
+    QElapsedTimer timer;
+    QByteArray buffer;
+
+    while (this->m_filled.Pop(buffer, &this->m_writeStats.stallNs))
+    {
+        QString error;
+        timer.start();
+        const bool ok = this->m_write(buffer.constData(), buffer.size(), error);
+        this->m_writeStats.busyNs += timer.nsecsElapsed();
+        ++this->m_writeStats.calls;
+
+        if (!ok)
+        {
+            this->fail(error);
+            return;
+        }
+
+        this->m_writeStats.bytes += buffer.size();
+
+        // Only RING_SIZE buffers exist, so this never blocks
+        this->m_free.Push(buffer);
+        buffer = QByteArray();
+    }
+}
+
+void CopyPipeline::runInline()
+{
+    QElapsedTimer timer;
+    QByteArray buffer;
+    int size = MIN_BUFFER_SIZE;
+
+    for (;;)
+    {
+        buffer.resize(size);
+
+        QString error;
+        timer.start();
+        const qint64 bytesRead = this->m_read(buffer.data(), size, error);
+        this->m_readStats.busyNs += timer.nsecsElapsed();
+        ++this->m_readStats.calls;
+
+        if (bytesRead < 0)
+        {
+            this->fail(error);
+            return;
+        }
+
+        if (bytesRead == 0)
+            return;
+
+        this->m_readStats.bytes += bytesRead;
+        this->m_peakBufferSize = qMax(this->m_peakBufferSize, size);
+        const int nextSize = this->nextBufferSize(size, bytesRead);
+
+        timer.start();
+        const bool ok = this->m_write(buffer.constData(), bytesRead, error);
+        this->m_writeStats.busyNs += timer.nsecsElapsed();
+        ++this->m_writeStats.calls;
+
+        if (!ok)
+        {
+            this->fail(error);
+            return;
+        }
+
+        this->m_writeStats.bytes += bytesRead;
+        size = nextSize;
+    }
+}
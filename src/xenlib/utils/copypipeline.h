@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COPYPIPELINE_H
+#define COPYPIPELINE_H
+
+#include "chunkqueue.h"
+#include <QString>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Overlapped copy between a reader and a writer with a ring of reusable buffers.
+ *
+ * One stage runs on a worker thread and the other on the calling thread. The
+ * reader fills buffers taken from a free ring and queues them for the writer,
+ * which hands each buffer back once written, so at most RING_SIZE buffers are
+ * ever allocated and reading the next block overlaps writing the previous one.
+ *
+ * The read size adapts between MIN_BUFFER_SIZE and MAX_BUFFER_SIZE: it doubles
+ * while reads fill the whole buffer and halves while they return less than a
+ * quarter of it, so a fast file grows to large blocks while a trickling socket
+ * is not kept waiting for a buffer it will never fill.
+ *
+ * A stage that owns a Qt socket must stay on the calling thread, sockets
+ * cannot be used from another thread.
+ */
+class CopyPipeline
+{
+    public:
+        /**
+         * @brief Fill @p data with up to @p maxSize bytes.
+         * @return bytes read, 0 at end of data, or -1 with @p error set
+         */
+        using ReadFunction = std::function<qint64(char* data, qint64 maxSize, QString& error)>;
+
+        /** @return false with @p error set to abort the copy */
+        using WriteFunction = std::function<bool(const char* data, qint64 size, QString& error)>;
+
+        /// Which stage gets the worker thread
+        enum class Worker
+        {
+            Reader,
+            Writer,
+            None    ///< Both stages on the calling thread, no overlap
+        };
+
+        /**
+         * @brief Counters for one side of the copy.
+         *
+         * @c busyNs is time spent inside the read or write function, @c stallNs
+         * time spent waiting on the other side (no free buffer for the reader,
+         * no filled buffer for the writer). The stage with high busy and low
+         * stall time is the bottleneck.
+         */
+        struct StageStats
+        {
+            QString stage;
+            qint64 bytes   = 0;
+            qint64 calls   = 0;
+            qint64 busyNs  = 0;
+            qint64 stallNs = 0;
+
+            /** @brief One-line human readable summary for logs. */
+            QString ToString() const;
+        };
+
+        static const int RING_SIZE = 4;
+        static const int MIN_BUFFER_SIZE = 32 * 1024;
+        static const int MAX_BUFFER_SIZE = 1024 * 1024;
+
+        CopyPipeline(ReadFunction read, WriteFunction write);
+
+        /**
+         * @brief Copy until the reader reports end of data or a stage fails.
+         * @return false if either stage failed; see GetError()
+         */
+        bool Run(Worker worker);
+
+        /**
+         * @brief True once a stage has failed.
+         *
+         * Read or write functions that block in slices should check this so a
+         * failure on the other side does not leave them waiting.
+         */
+        bool IsAborted() const { return this->m_failed; }
+
+        /** @brief Error of the first stage that failed. */
+        QString GetError() const;
+
+        StageStats GetReadStats() const { return this->m_readStats; }
+        StageStats GetWriteStats() const { return this->m_writeStats; }
+
+        /** @brief Largest read size the adaptive sizing reached. */
+        int GetPeakBufferSize() const { return this->m_peakBufferSize; }
+
+        /** @brief Wall-clock duration of the last Run(). */
+        qint64 GetElapsedNs() const { return this->m_elapsedNs; }
+
+    private:
+        void runReader();
+        void runWriter();
+        void runInline();
+        void fail(const QString& error);
+        int nextBufferSize(int current, qint64 lastRead) const;
+
+        ReadFunction m_read;
+        WriteFunction m_write;
+        ChunkQueue m_free;
+        ChunkQueue m_filled;
+
+        // Each side's counters are only touched by the thread running that
+        // side and read after Run() joins the worker.
+        StageStats m_readStats;
+        StageStats m_writeStats;
+        int m_peakBufferSize = 0;
+        qint64 m_elapsedNs = 0;
+
+        mutable QMutex m_errorMutex;
+        QString m_error;
+        std::atomic<bool> m_failed{false};
+};
+
+#endif // COPYPIPELINE_H
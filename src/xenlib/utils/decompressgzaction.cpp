@@ -27,16 +27,11 @@
 
 #include "decompressgzaction.h"
 
+#include "parallelgzip.h"
+
 #include <QFile>
 #include <QFileInfo>
 
-#ifndef XENADMIN_NO_ZLIB
-#include <zlib.h>
-
-// Read buffer: 64 KB is a good balance of throughput vs. cancellation latency
-static const int GZ_BUF_SIZE = 64 * 1024;
-#endif
-
 DecompressGzAction::DecompressGzAction(const QString& sourceGzPath,
                                        const QString& destPath,
                                        QObject* parent)
@@ -53,76 +48,33 @@ void DecompressGzAction::run()
     this->SetCanCancel(true);
     this->setDescriptionSafe(tr("Decompressing %1...").arg(QFileInfo(this->m_sourceGzPath).fileName()));
 
-#ifdef XENADMIN_NO_ZLIB
-    this->setError(tr("Gzip decompression support is not available in this build."));
-    this->setState(Failed);
-#else
-    const qint64 compressedSize = QFileInfo(this->m_sourceGzPath).size();
+    QString error;
+    const bool ok = ParallelGzip::DecompressFile(
+        this->m_sourceGzPath,
+        this->m_destPath,
+        error,
+        [this]() { return this->IsCancelled(); },
+        [this](qint64 done, qint64 total)
+        {
+            // Progress follows the compressed input consumed
+            if (total > 0)
+                this->setPercentCompleteSafe(qBound(0, static_cast<int>(99.0 * done / total), 99));
+        });
 
-    // Open gzip input. gzopen handles the gzip header transparently.
-    gzFile gz = gzopen(this->m_sourceGzPath.toLocal8Bit().constData(), "rb");
-    if (!gz)
+    if (this->IsCancelled())
     {
-        this->setError(tr("Cannot open compressed file: %1").arg(this->m_sourceGzPath));
-        this->setState(Failed);
+        QFile::remove(this->m_destPath);
+        this->setState(Cancelled);
         return;
     }
 
-    QFile out(this->m_destPath);
-    if (!out.open(QIODevice::WriteOnly))
+    if (!ok)
     {
-        gzclose(gz);
-        this->setError(tr("Cannot create output file %1: %2")
-                         .arg(this->m_destPath, out.errorString()));
+        this->setError(tr("Decompression error: %1").arg(error));
         this->setState(Failed);
         return;
     }
 
-    QByteArray buf(GZ_BUF_SIZE, '\0');
-
-    while (true)
-    {
-        if (this->IsCancelled())
-        {
-            gzclose(gz);
-            out.close();
-            QFile::remove(this->m_destPath);
-            this->setState(Cancelled);
-            return;
-        }
-
-        const int bytesRead = gzread(gz, buf.data(), GZ_BUF_SIZE);
-        if (bytesRead < 0)
-        {
-            int errnum = 0;
-            const char* msg = gzerror(gz, &errnum);
-            gzclose(gz);
-            out.close();
-            QFile::remove(this->m_destPath);
-            this->setError(tr("Decompression error: %1").arg(QString::fromLatin1(msg)));
-            this->setState(Failed);
-            return;
-        }
-
-        if (bytesRead == 0)
-            break;  // EOF
-
-        out.write(buf.constData(), bytesRead);
-
-        // Report progress based on how much of the compressed stream has been consumed.
-        // gzoffset() (zlib >= 1.2.4) returns the byte position in the compressed file.
-        if (compressedSize > 0)
-        {
-            const z_off_t pos = gzoffset(gz);
-            const int pct = static_cast<int>(99.0 * pos / compressedSize);
-            this->setPercentCompleteSafe(qBound(0, pct, 99));
-        }
-    }
-
-    gzclose(gz);
-    out.close();
-
     this->setPercentCompleteSafe(100);
     this->setState(Completed);
-#endif
 }
@@ -37,6 +37,9 @@
  * Used by ImportWizard to decompress .xva.gz and .ova.gz files before
  * the import action begins.
  *
+ * Reading, inflating and writing run on separate threads via
+ * ParallelGzip::DecompressFile(), and concatenated members are accepted.
+ *
  * The output file is created at the path given to the constructor.
  * On cancellation or failure the partial output file is removed.
  *
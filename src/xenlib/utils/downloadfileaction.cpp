@@ -12,7 +12,33 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QThread>
 #include <QTimer>
+#include <QDebug>
+
+namespace
+{
+    const int MAX_ATTEMPTS = 5;
+    const int RETRY_DELAY_MS = 500;
+
+    // Errors where the same request may well succeed a moment later
+    bool isTransient(QNetworkReply::NetworkError error)
+    {
+        switch (error)
+        {
+            case QNetworkReply::RemoteHostClosedError:
+            case QNetworkReply::TimeoutError:
+            case QNetworkReply::TemporaryNetworkFailureError:
+            case QNetworkReply::NetworkSessionFailedError:
+            case QNetworkReply::ProxyConnectionClosedError:
+            case QNetworkReply::ProxyTimeoutError:
+            case QNetworkReply::UnknownNetworkError:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
 
 DownloadFileAction::DownloadFileAction(const QUrl& sourceUrl,
                                        const QString& destPath,
@@ -47,50 +73,125 @@ void DownloadFileAction::run()
     }
 
     QNetworkAccessManager manager;
-    QNetworkRequest request(this->m_sourceUrl);
-    request.setHeader(QNetworkRequest::UserAgentHeader, "XenAdminQt/1.0");
-
-    QEventLoop loop;
-    QTimer cancelTimer;
-    cancelTimer.setInterval(100);
-
-    this->m_reply = manager.get(request);
-
-    connect(this->m_reply, &QNetworkReply::readyRead, this, [this, &out]()
+    QNetworkReply::NetworkError err = QNetworkReply::NoError;
+    QString errStr;
+    qint64 written = 0;
+    bool writeFailed = false;
+
+    // A dropped connection is picked up with a Range request from the last
+    // byte written; a server that answers with the whole file starts it over
+    for (int attempt = 1; attempt <= MAX_ATTEMPTS; ++attempt)
     {
-        if (this->m_reply)
-            out.write(this->m_reply->readAll());
-    });
-
-    connect(this->m_reply, &QNetworkReply::downloadProgress, this,
-            [this](qint64 received, qint64 total)
-    {
-        if (total > 0)
-            this->setPercentCompleteSafe(qBound(0, static_cast<int>((received * 100) / total), 99));
-        this->setDescriptionSafe(tr("Downloading %1 (%2/%3 bytes)...")
-                                 .arg(this->m_sourceUrl.fileName())
-                                 .arg(received)
-                                 .arg(total));
-    });
-
-    connect(this->m_reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    connect(&cancelTimer, &QTimer::timeout, this, [this]()
-    {
-        if (this->IsCancelled() && this->m_reply)
-            this->m_reply->abort();
-    });
-
-    cancelTimer.start();
-    loop.exec();
-    cancelTimer.stop();
+        QNetworkRequest request(this->m_sourceUrl);
+        request.setHeader(QNetworkRequest::UserAgentHeader, "XenAdminQt/1.0");
+        const qint64 base = written;
+        if (base > 0)
+            request.setRawHeader("Range", "bytes=" + QByteArray::number(base) + "-");
+
+        QEventLoop loop;
+        QTimer cancelTimer;
+        cancelTimer.setInterval(100);
+
+        this->m_reply = manager.get(request);
+        bool bodyStarted = false;
+        bool wrongRange = false;
+
+        auto writeAvailable = [this, &out, &written, &writeFailed, &bodyStarted, &wrongRange, base]()
+        {
+            if (!this->m_reply || wrongRange || writeFailed)
+                return;
+            if (!bodyStarted)
+            {
+                bodyStarted = true;
+                const int status = this->m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray range = this->m_reply->rawHeader("Content-Range");
+                if (base > 0 && (status != 206 || !range.startsWith("bytes " + QByteArray::number(base) + "-")))
+                {
+                    qDebug() << "DownloadFileAction: server did not resume at" << base << "- starting over";
+                    out.resize(0);
+                    out.seek(0);
+                    written = 0;
+                    if (status == 206)
+                    {
+                        // Some other range; the next attempt asks for the whole file
+                        wrongRange = true;
+                        this->m_reply->abort();
+                        return;
+                    }
+                }
+            }
+            const QByteArray data = this->m_reply->readAll();
+            if (out.write(data) != data.size())
+            {
+                writeFailed = true;
+                this->m_reply->abort();
+                return;
+            }
+            written += data.size();
+        };
+
+        connect(this->m_reply, &QNetworkReply::readyRead, this, writeAvailable);
+
+        connect(this->m_reply, &QNetworkReply::downloadProgress, this,
+                [this, &written](qint64 received, qint64 total)
+        {
+            // Ranged replies report progress relative to the range
+            const qint64 fullSize = total > 0 ? written + qMax<qint64>(0, total - received) : total;
+            if (fullSize > 0)
+                this->setPercentCompleteSafe(qBound(0, static_cast<int>((written * 100) / fullSize), 99));
+            this->setDescriptionSafe(tr("Downloading %1 (%2/%3 bytes)...")
+                                     .arg(this->m_sourceUrl.fileName())
+                                     .arg(written)
+                                     .arg(fullSize));
+        });
+
+        connect(this->m_reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        connect(&cancelTimer, &QTimer::timeout, this, [this]()
+        {
+            if (this->IsCancelled() && this->m_reply)
+                this->m_reply->abort();
+        });
+
+        cancelTimer.start();
+        loop.exec();
+        cancelTimer.stop();
+
+        if (this->m_reply->bytesAvailable() > 0)
+            writeAvailable();
+
+        err = this->m_reply->error();
+        errStr = this->m_reply->errorString();
+        this->m_reply->deleteLater();
+        this->m_reply = nullptr;
+
+        if (writeFailed)
+            break;
+        if (wrongRange && !this->IsCancelled())
+        {
+            err = QNetworkReply::UnknownContentError;
+            errStr = tr("Server did not resume at byte %1").arg(base);
+            continue;
+        }
+        if (err == QNetworkReply::NoError || this->IsCancelled() || !isTransient(err))
+            break;
+        if (attempt < MAX_ATTEMPTS)
+        {
+            qWarning() << "DownloadFileAction: download interrupted at" << written << "bytes (" << errStr
+                       << "), resuming, attempt" << attempt + 1;
+            QThread::msleep(RETRY_DELAY_MS);
+        }
+    }
 
-    out.write(this->m_reply->readAll());
+    const QString writeError = out.errorString();
     out.close();
 
-    const QNetworkReply::NetworkError err = this->m_reply->error();
-    const QString errStr = this->m_reply->errorString();
-    this->m_reply->deleteLater();
-    this->m_reply = nullptr;
+    if (writeFailed)
+    {
+        QFile::remove(this->m_destPath);
+        this->setError(tr("Cannot write %1: %2").arg(this->m_destPath, writeError));
+        this->setState(Failed);
+        return;
+    }
 
     if (this->IsCancelled() || err == QNetworkReply::OperationCanceledError)
     {
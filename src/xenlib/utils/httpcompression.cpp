@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "httpcompression.h"
+
+#ifndef XENADMIN_NO_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    const int OUTPUT_CHUNK_SIZE = 64 * 1024;
+
+    enum class Coding
+    {
+        Identity,
+        Gzip,
+        Deflate,
+        Unsupported
+    };
+
+    Coding parseCoding(const QByteArray& header)
+    {
+        Coding coding = Coding::Identity;
+        for (const QByteArray& part : header.split(','))
+        {
+            const QByteArray name = part.trimmed().toLower();
+            if (name.isEmpty() || name == "identity")
+                continue;
+
+            // Stacked codings are legal HTTP, but nothing xapi sits behind sends them
+            if (coding != Coding::Identity)
+                return Coding::Unsupported;
+
+            if (name == "gzip" || name == "x-gzip")
+                coding = Coding::Gzip;
+            else if (name == "deflate")
+                coding = Coding::Deflate;
+            else
+                return Coding::Unsupported;
+        }
+
+        if (coding != Coding::Identity && !HttpCompression::IsAvailable())
+            return Coding::Unsupported;
+        return coding;
+    }
+}
+
+// ── HttpCompression ──────────────────────────────────────────────────────────
+
+bool HttpCompression::IsAvailable()
+{
+#ifdef XENADMIN_NO_ZLIB
+    return false;
+#else
+    return true;
+#endif
+}
+
+QByteArray HttpCompression::AcceptEncoding()
+{
+    return IsAvailable() ? QByteArray("gzip, deflate") : QByteArray("identity");
+}
+
+QByteArray HttpCompression::Gzip(const QByteArray& data, int level)
+{
+#ifdef XENADMIN_NO_ZLIB
+    Q_UNUSED(data);
+    Q_UNUSED(level);
+    return QByteArray();
+#else
+    z_stream zs = {};
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return QByteArray();
+
+    // deflateBound includes the gzip header and trailer, so one call is enough
+    QByteArray output;
+    output.resize(static_cast<qsizetype>(deflateBound(&zs, static_cast<uLong>(data.size()))));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(output.data());
+    zs.avail_out = static_cast<uInt>(output.size());
+
+    const int ret = deflate(&zs, Z_FINISH);
+    const qsizetype produced = output.size() - static_cast<qsizetype>(zs.avail_out);
+    deflateEnd(&zs);
+
+    if (ret != Z_STREAM_END)
+        return QByteArray();
+    output.resize(produced);
+    return output;
+#endif
+}
+
+// ── HttpContentDecoder ───────────────────────────────────────────────────────
+
+struct HttpContentDecoder::Private
+{
+    Coding coding = Coding::Identity;
+#ifndef XENADMIN_NO_ZLIB
+    z_stream strm = {};
+#endif
+    bool started = false;
+    bool streamEnded = false;   // the last gzip member or deflate stream is complete
+    QByteArray pending;         // input held until the deflate wrapper can be told apart
+    QString error;
+    qint64 bytesIn = 0;
+};
+
+HttpContentDecoder::HttpContentDecoder(const QByteArray& contentEncoding) : d(new Private)
+{
+    this->d->coding = parseCoding(contentEncoding);
+}
+
+HttpContentDecoder::~HttpContentDecoder()
+{
+#ifndef XENADMIN_NO_ZLIB
+    if (this->d->started)
+        inflateEnd(&this->d->strm);
+#endif
+    delete this->d;
+}
+
+bool HttpContentDecoder::IsSupported() const
+{
+    return this->d->coding != Coding::Unsupported;
+}
+
+bool HttpContentDecoder::IsCompressed() const
+{
+    return this->d->coding == Coding::Gzip || this->d->coding == Coding::Deflate;
+}
+
+bool HttpContentDecoder::start()
+{
+#ifdef XENADMIN_NO_ZLIB
+    this->d->error = QStringLiteral("Compressed responses are not supported by this build");
+    return false;
+#else
+    int windowBits = 15 + 16;
+    if (this->d->coding == Coding::Deflate)
+    {
+        // A zlib header is CM = 8 with a check value making the first two bytes a multiple of 31
+        const uchar cmf = static_cast<uchar>(this->d->pending.at(0));
+        const uchar flg = static_cast<uchar>(this->d->pending.at(1));
+        const bool zlibWrapped = (cmf & 0x0f) == 8 && ((cmf << 8) | flg) % 31 == 0;
+        windowBits = zlibWrapped ? 15 : -15;
+    }
+
+    if (inflateInit2(&this->d->strm, windowBits) != Z_OK)
+    {
+        this->d->error = QStringLiteral("Failed to initialise response decompressor");
+        return false;
+    }
+    this->d->started = true;
+    return true;
+#endif
+}
+
+bool HttpContentDecoder::Feed(const char* data, qint64 size, QByteArray& output)
+{
+    if (!this->d->error.isEmpty())
+        return false;
+
+    this->d->bytesIn += size;
+    if (this->d->coding == Coding::Identity)
+    {
+        output.append(data, size);
+        return true;
+    }
+    if (this->d->coding == Coding::Unsupported)
+    {
+        this->d->error = QStringLiteral("Unsupported content encoding");
+        return false;
+    }
+
+#ifdef XENADMIN_NO_ZLIB
+    Q_UNUSED(output);
+    return this->start();
+#else
+    QByteArray first;
+    if (!this->d->started)
+    {
+        this->d->pending.append(data, size);
+        if (this->d->coding == Coding::Deflate && this->d->pending.size() < 2)
+            return true;
+        if (!this->start())
+            return false;
+        first.swap(this->d->pending);
+        data = first.constData();
+        size = first.size();
+    }
+
+    z_stream& zs = this->d->strm;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+
+    // inflate() may stop with input left or with output still buffered inside
+    bool outputFull = false;
+    while (zs.avail_in > 0 || outputFull)
+    {
+        if (this->d->streamEnded)
+        {
+            // gzip allows members back to back; anything after a deflate stream is junk
+            if (this->d->coding != Coding::Gzip || inflateReset(&zs) != Z_OK)
+            {
+                this->d->error = QStringLiteral("Unexpected data after the compressed response body");
+                return false;
+            }
+            this->d->streamEnded = false;
+        }
+
+        const qsizetype offset = output.size();
+        output.resize(offset + OUTPUT_CHUNK_SIZE);
+        zs.next_out = reinterpret_cast<Bytef*>(output.data() + offset);
+        zs.avail_out = OUTPUT_CHUNK_SIZE;
+
+        const int ret = inflate(&zs, Z_NO_FLUSH);
+        output.resize(output.size() - static_cast<qsizetype>(zs.avail_out));
+        outputFull = zs.avail_out == 0;
+
+        if (ret == Z_STREAM_END)
+        {
+            this->d->streamEnded = true;
+            outputFull = false;
+        } else if (ret == Z_BUF_ERROR)
+        {
+            // No progress possible until more input arrives
+            break;
+        } else if (ret != Z_OK)
+        {
+            this->d->error = QString("Corrupt compressed response body (%1)")
+                                 .arg(QString::fromLatin1(zs.msg ? zs.msg : "inflate failed"));
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+bool HttpContentDecoder::Finish()
+{
+    if (!this->d->error.isEmpty())
+        return false;
+    if (!this->IsCompressed() || this->d->bytesIn == 0 || this->d->streamEnded)
+        return true;
+
+    this->d->error = QStringLiteral("Compressed response body is truncated");
+    return false;
+}
+
+QString HttpContentDecoder::GetError() const
+{
+    return this->d->error;
+}
+
+qint64 HttpContentDecoder::GetBytesIn() const
+{
+    return this->d->bytesIn;
+}
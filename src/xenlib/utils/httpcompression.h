@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HTTPCOMPRESSION_H
+#define HTTPCOMPRESSION_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief HTTP content coding helpers for the JSON-RPC transport.
+ *
+ * Only gzip and deflate are offered; both are plain zlib, which xenlib
+ * already links for import and export. Without zlib the transport falls
+ * back to identity and every call here is a no-op.
+ */
+class HttpCompression
+{
+    public:
+        /** @brief Whether gzip and deflate can be encoded and decoded in this build. */
+        static bool IsAvailable();
+
+        /** @brief Value for the Accept-Encoding request header. */
+        static QByteArray AcceptEncoding();
+
+        /**
+         * @brief Gzip @p data into a single member.
+         * @return Compressed data, or an empty array if zlib failed or is missing
+         */
+        static QByteArray Gzip(const QByteArray& data, int level = 6);
+};
+
+/**
+ * @brief Incremental decoder for a Content-Encoding response body.
+ *
+ * Bytes are inflated as they are fed, so the reader can decode each block
+ * straight off the socket and never holds the whole compressed body.
+ * "gzip" accepts concatenated members; "deflate" accepts both the zlib
+ * stream RFC 9110 asks for and the raw deflate data some servers send.
+ * An empty or "identity" coding passes data through unchanged.
+ */
+class HttpContentDecoder
+{
+    public:
+        explicit HttpContentDecoder(const QByteArray& contentEncoding);
+        ~HttpContentDecoder();
+
+        HttpContentDecoder(const HttpContentDecoder&) = delete;
+        HttpContentDecoder& operator=(const HttpContentDecoder&) = delete;
+
+        /** @brief False for codings this build cannot decode, such as br. */
+        bool IsSupported() const;
+
+        /** @brief True unless the body is passed through unchanged. */
+        bool IsCompressed() const;
+
+        /**
+         * @brief Decode the next part of the body and append it to @p output.
+         * @return false on corrupt input, see GetError()
+         */
+        bool Feed(const char* data, qint64 size, QByteArray& output);
+
+        /**
+         * @brief Check that the body ended on a complete stream.
+         * @return false if the compressed data was truncated
+         */
+        bool Finish();
+
+        QString GetError() const;
+
+        /** @brief Encoded bytes fed so far. */
+        qint64 GetBytesIn() const;
+
+    private:
+        bool start();
+
+        struct Private;
+        Private* d;
+};
+
+#endif // HTTPCOMPRESSION_H
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "memoryaccountant.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QTimer>
+#include <algorithm>
+
+const QString MemoryAccountant::CACHE_RECORDS = QStringLiteral("Cache records");
+const QString MemoryAccountant::OBJECT_SHELLS = QStringLiteral("Object shells");
+const QString MemoryAccountant::METRICS = QStringLiteral("Metrics");
+const QString MemoryAccountant::GRAPH_ARCHIVES = QStringLiteral("Graph archives");
+const QString MemoryAccountant::CONSOLE_BUFFERS = QStringLiteral("Console buffers");
+
+MemoryAccountant* MemoryAccountant::s_instance = nullptr;
+
+MemoryAccountant* MemoryAccountant::instance()
+{
+    if (!s_instance)
+        s_instance = new MemoryAccountant();
+    return s_instance;
+}
+
+MemoryAccountant::MemoryAccountant(QObject* parent) : QObject(parent), m_timer(new QTimer(this))
+{
+    this->m_subsystems << CACHE_RECORDS << OBJECT_SHELLS << METRICS << GRAPH_ARCHIVES << CONSOLE_BUFFERS;
+    this->m_timer->setInterval(CHECK_INTERVAL_MS);
+    connect(this->m_timer, &QTimer::timeout, this, [this]() { this->Enforce(); });
+}
+
+int MemoryAccountant::Register(XenConnection* connection, const QString& subsystem, QObject* owner,
+                               const SizeFunction& size, const EvictFunction& evict)
+{
+    if (!connection || !owner || !size)
+        return 0;
+
+    Provider provider;
+    provider.connection = connection;
+    provider.subsystem = subsystem;
+    provider.owner = owner;
+    provider.size = size;
+    provider.evict = evict;
+
+    {
+        QMutexLocker locker(&this->m_mutex);
+        provider.id = this->m_nextId++;
+        this->m_providers.append(provider);
+        if (!this->m_subsystems.contains(subsystem))
+            this->m_subsystems.append(subsystem);
+    }
+
+    const int id = provider.id;
+    connect(owner, &QObject::destroyed, this, [this, id]() { this->Unregister(id); });
+    return id;
+}
+
+void MemoryAccountant::Unregister(int id)
+{
+    QMutexLocker locker(&this->m_mutex);
+    for (int i = 0; i < this->m_providers.size(); ++i)
+    {
+        if (this->m_providers.at(i).id == id)
+        {
+            this->m_providers.removeAt(i);
+            return;
+        }
+    }
+}
+
+QList<MemoryAccountant::Provider> MemoryAccountant::providers(XenConnection* connection) const
+{
+    QList<Provider> result;
+    QMutexLocker locker(&this->m_mutex);
+    for (const Provider& provider : this->m_providers)
+    {
+        if (provider.owner && (!connection || provider.connection == connection))
+            result.append(provider);
+    }
+    return result;
+}
+
+QList<XenConnection*> MemoryAccountant::GetConnections() const
+{
+    QList<XenConnection*> connections;
+    QMutexLocker locker(&this->m_mutex);
+    for (const Provider& provider : this->m_providers)
+    {
+        if (provider.owner && !connections.contains(provider.connection))
+            connections.append(provider.connection);
+    }
+    return connections;
+}
+
+QList<MemoryAccountant::Usage> MemoryAccountant::GetUsage(XenConnection* connection) const
+{
+    QStringList subsystems;
+    QHash<QString, qint64> budgets;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        subsystems = this->m_subsystems;
+        budgets = this->m_budgets;
+    }
+
+    QHash<QString, Usage> bySubsystem;
+    for (const Provider& provider : this->providers(connection))
+    {
+        const Size size = provider.size();
+        Usage& usage = bySubsystem[provider.subsystem];
+        usage.bytes += size.bytes;
+        usage.evictable += size.evictable;
+        usage.providers++;
+    }
+
+    QList<Usage> result;
+    for (const QString& subsystem : subsystems)
+    {
+        auto it = bySubsystem.constFind(subsystem);
+        if (it == bySubsystem.constEnd())
+            continue;
+        Usage usage = it.value();
+        usage.subsystem = subsystem;
+        usage.budget = budgets.value(subsystem);
+        result.append(usage);
+    }
+    return result;
+}
+
+qint64 MemoryAccountant::GetTotal(XenConnection* connection) const
+{
+    qint64 total = 0;
+    for (const Usage& usage : this->GetUsage(connection))
+        total += usage.bytes;
+    return total;
+}
+
+void MemoryAccountant::SetBudget(const QString& subsystem, qint64 bytes)
+{
+    bool any = false;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (bytes > 0)
+            this->m_budgets.insert(subsystem, bytes);
+        else
+            this->m_budgets.remove(subsystem);
+        any = !this->m_budgets.isEmpty();
+    }
+
+    // Nothing to enforce without budgets, so the timer only runs when one is set
+    if (any && !this->m_timer->isActive())
+        this->m_timer->start();
+    else if (!any)
+        this->m_timer->stop();
+}
+
+qint64 MemoryAccountant::GetBudget(const QString& subsystem) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_budgets.value(subsystem);
+}
+
+qint64 MemoryAccountant::Enforce()
+{
+    QHash<QString, qint64> budgets;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        budgets = this->m_budgets;
+    }
+    if (budgets.isEmpty())
+        return 0;
+
+    // Only subsystems with a budget are sized; walking the cache is not free
+    struct Candidate
+    {
+        Provider provider;
+        Size size;
+    };
+    QHash<QPair<XenConnection*, QString>, QList<Candidate>> groups;
+    for (const Provider& provider : this->providers(nullptr))
+    {
+        if (!budgets.contains(provider.subsystem))
+            continue;
+        Candidate candidate{ provider, provider.size() };
+        groups[qMakePair(provider.connection, provider.subsystem)].append(candidate);
+    }
+
+    qint64 freedTotal = 0;
+    for (auto it = groups.begin(); it != groups.end(); ++it)
+    {
+        QList<Candidate>& candidates = it.value();
+        qint64 used = 0;
+        for (const Candidate& candidate : candidates)
+            used += candidate.size.bytes;
+
+        qint64 excess = used - budgets.value(it.key().second);
+        if (excess <= 0)
+            continue;
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.size.evictable > b.size.evictable;
+        });
+
+        qint64 freed = 0;
+        for (const Candidate& candidate : candidates)
+        {
+            if (excess <= 0 || candidate.size.evictable <= 0)
+                break;
+            if (!candidate.provider.evict || !candidate.provider.owner)
+                continue;
+            const qint64 released = candidate.provider.evict(excess);
+            freed += released;
+            excess -= released;
+        }
+
+        if (freed > 0)
+        {
+            qDebug() << "MemoryAccountant: evicted" << freed << "bytes of" << it.key().second
+                     << "for connection" << it.key().first;
+            freedTotal += freed;
+            emit this->evicted(it.key().first, it.key().second, freed);
+        }
+    }
+
+    return freedTotal;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MEMORYACCOUNTANT_H
+#define MEMORYACCOUNTANT_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <functional>
+
+class QTimer;
+class XenConnection;
+
+/**
+ * @brief Per-connection memory accounting with soft budgets.
+ *
+ * Subsystems that keep per-connection data (cache records, object shells,
+ * metrics, graph archives, console back buffers) register a size callback
+ * here, keyed by connection and subsystem name, so the debug window and the
+ * cache explorer can show where memory goes instead of just total RSS.
+ *
+ * A subsystem can be given a soft budget per connection. Providers that hold
+ * data which can be dropped and rebuilt later (archives of graphs nobody is
+ * looking at, back buffers of paused consoles) also register an evict
+ * callback; Enforce() runs every CHECK_INTERVAL_MS and asks them, largest
+ * evictable first, to free enough to get the subsystem back under budget.
+ * Budgets are soft: data that is in use is never dropped.
+ *
+ * Callbacks run on the accountant's thread without the lock held.
+ */
+class MemoryAccountant : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const int CHECK_INTERVAL_MS = 60000;
+
+        // Subsystem names
+        static const QString CACHE_RECORDS;
+        static const QString OBJECT_SHELLS;
+        static const QString METRICS;
+        static const QString GRAPH_ARCHIVES;
+        static const QString CONSOLE_BUFFERS;
+
+        struct Size
+        {
+            qint64 bytes = 0;
+            //! Part of bytes the provider could drop right now
+            qint64 evictable = 0;
+        };
+
+        struct Usage
+        {
+            QString subsystem;
+            qint64 bytes = 0;
+            qint64 evictable = 0;
+            qint64 budget = 0;
+            int providers = 0;
+        };
+
+        using SizeFunction = std::function<Size()>;
+        //! Asked to free at least the given number of bytes; returns what it freed
+        using EvictFunction = std::function<qint64(qint64 bytesToFree)>;
+
+        static MemoryAccountant* instance();
+
+        /**
+         * @brief Account memory held by @p owner for @p connection
+         *
+         * The registration goes away with @p owner.
+         *
+         * @return Id for Unregister()
+         */
+        int Register(XenConnection* connection, const QString& subsystem, QObject* owner,
+                     const SizeFunction& size, const EvictFunction& evict = EvictFunction());
+        void Unregister(int id);
+
+        QList<XenConnection*> GetConnections() const;
+
+        /**
+         * @brief Usage of @p connection per subsystem, in registration order of the subsystems
+         *
+         * Calls every size callback of the connection, so meant for diagnostics.
+         */
+        QList<Usage> GetUsage(XenConnection* connection) const;
+        qint64 GetTotal(XenConnection* connection) const;
+
+        /**
+         * @brief Set the per-connection soft budget of @p subsystem; 0 disables it
+         */
+        void SetBudget(const QString& subsystem, qint64 bytes);
+        qint64 GetBudget(const QString& subsystem) const;
+
+        /**
+         * @brief Evict from subsystems that are over budget
+         * @return Bytes freed
+         */
+        qint64 Enforce();
+
+    signals:
+        void evicted(XenConnection* connection, const QString& subsystem, qint64 bytes);
+
+    private:
+        struct Provider
+        {
+            int id = 0;
+            XenConnection* connection = nullptr;
+            QString subsystem;
+            QPointer<QObject> owner;
+            SizeFunction size;
+            EvictFunction evict;
+        };
+
+        explicit MemoryAccountant(QObject* parent = nullptr);
+
+        QList<Provider> providers(XenConnection* connection) const;
+
+        static MemoryAccountant* s_instance;
+        mutable QMutex m_mutex;
+        QList<Provider> m_providers;
+        QStringList m_subsystems;
+        QHash<QString, qint64> m_budgets;
+        int m_nextId = 1;
+        QTimer* m_timer = nullptr;
+};
+
+#endif // MEMORYACCOUNTANT_H
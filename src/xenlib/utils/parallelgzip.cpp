@@ -0,0 +1,556 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "parallelgzip.h"
+#include "chunkqueue.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtEndian>
+#include <atomic>
+#ifndef XENADMIN_NO_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    const int FILE_CHUNK_SIZE = 1024 * 1024;
+    const int FILE_QUEUE_DEPTH = 4;
+
+    std::atomic<int> defaultThreadCount { 0 };
+
+    struct CompressedBlock
+    {
+        QByteArray output;
+        quint32 crc = 0;
+        qint64 length = 0;
+        QString error;
+    };
+
+#ifndef XENADMIN_NO_ZLIB
+    CompressedBlock deflateBlock(const QByteArray& input, const QByteArray& dictionary, int level, bool last)
+    {
+        CompressedBlock block;
+        block.length = input.size();
+        block.crc = static_cast<quint32>(crc32(crc32(0L, Z_NULL, 0),
+                                               reinterpret_cast<const Bytef*>(input.constData()),
+                                               static_cast<uInt>(input.size())));
+
+        z_stream zs = {};
+        if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            block.error = QStringLiteral("Failed to initialise gzip compressor");
+            return block;
+        }
+
+        if (!dictionary.isEmpty())
+        {
+            deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary.constData()),
+                                 static_cast<uInt>(dictionary.size()));
+        }
+
+        // deflateBound covers Z_FINISH; a sync flush adds an empty stored block
+        block.output.resize(static_cast<int>(deflateBound(&zs, static_cast<uLong>(input.size()))) + 16);
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+        zs.avail_in = static_cast<uInt>(input.size());
+
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        int produced = 0;
+        int ret = Z_OK;
+        for (;;)
+        {
+            if (produced == block.output.size())
+                block.output.resize(block.output.size() * 2);
+            zs.next_out = reinterpret_cast<Bytef*>(block.output.data()) + produced;
+            zs.avail_out = static_cast<uInt>(block.output.size() - produced);
+
+            ret = deflate(&zs, flush);
+            produced = block.output.size() - static_cast<int>(zs.avail_out);
+            if (ret == Z_STREAM_ERROR)
+                break;
+            if (last ? ret == Z_STREAM_END : zs.avail_out > 0)
+                break;
+        }
+        deflateEnd(&zs);
+
+        if (ret == Z_STREAM_ERROR)
+            block.error = QStringLiteral("Gzip compression failed");
+        block.output.resize(produced);
+        return block;
+    }
+#endif
+}
+
+// ── ParallelGzip ─────────────────────────────────────────────────────────────
+
+struct ParallelGzip::Private
+{
+    SinkFunction sink;
+    int level = 6;
+    int maxInFlight = 2;
+    QThreadPool pool;
+
+    QByteArray pending;
+    QByteArray dictionary;  // last DICTIONARY_SIZE bytes of the previous block
+
+    // Blocks are numbered as dispatched and emitted strictly in that order
+    QMutex mutex;
+    QWaitCondition blockDone;
+    QHash<qint64, CompressedBlock> done;
+    qint64 nextDispatch = 0;
+    qint64 nextEmit = 0;
+
+    bool headerWritten = false;
+    bool finished = false;
+    bool failed = false;
+    QString error;
+    quint32 crc = 0;
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+};
+
+int ParallelGzip::GetThreadCount()
+{
+    const int threads = defaultThreadCount.load();
+    return threads > 0 ? threads : qMax(1, QThread::idealThreadCount());
+}
+
+void ParallelGzip::SetThreadCount(int threads)
+{
+    defaultThreadCount.store(qMax(0, threads));
+}
+
+ParallelGzip::ParallelGzip(SinkFunction sink, int level, int threads) : d(new Private)
+{
+    this->d->sink = std::move(sink);
+    this->d->level = qBound(1, level, 9);
+    const int workers = threads > 0 ? threads : GetThreadCount();
+    this->d->pool.setMaxThreadCount(workers);
+    this->d->maxInFlight = workers * 2;
+    this->d->pending.reserve(BLOCK_SIZE);
+#ifndef XENADMIN_NO_ZLIB
+    this->d->crc = static_cast<quint32>(crc32(0L, Z_NULL, 0));
+#endif
+}
+
+ParallelGzip::~ParallelGzip()
+{
+    this->d->pool.waitForDone();
+    delete this->d;
+}
+
+bool ParallelGzip::Write(const char* data, qint64 size)
+{
+    if (this->d->failed || this->d->finished)
+        return false;
+
+    while (size > 0)
+    {
+        const int take = static_cast<int>(qMin<qint64>(size, BLOCK_SIZE - this->d->pending.size()));
+        this->d->pending.append(data, take);
+        this->d->bytesIn += take;
+        data += take;
+        size -= take;
+
+        if (this->d->pending.size() == BLOCK_SIZE && !this->dispatch(false))
+            return false;
+    }
+    return true;
+}
+
+bool ParallelGzip::Finish()
+{
+    if (this->d->finished)
+        return !this->d->failed;
+
+    // The final block is dispatched even when empty, it carries the end-of-stream marker
+    const bool ok = !this->d->failed && this->dispatch(true) && this->drain(true);
+    this->d->finished = true;
+    this->d->pool.waitForDone();
+    if (!ok)
+        return false;
+
+    uchar trailer[8];
+    qToLittleEndian<quint32>(this->d->crc, trailer);
+    qToLittleEndian<quint32>(static_cast<quint32>(this->d->bytesIn), trailer + 4);
+    return this->emitBytes(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+}
+
+QString ParallelGzip::GetError() const
+{
+    return this->d->error;
+}
+
+qint64 ParallelGzip::GetBytesIn() const
+{
+    return this->d->bytesIn;
+}
+
+qint64 ParallelGzip::GetBytesOut() const
+{
+    return this->d->bytesOut;
+}
+
+bool ParallelGzip::dispatch(bool last)
+{
+#ifdef XENADMIN_NO_ZLIB
+    Q_UNUSED(last)
+    this->d->failed = true;
+    this->d->error = QStringLiteral("Gzip compression support is not available in this build");
+    return false;
+#else
+    const QByteArray input = this->d->pending;
+    const QByteArray dictionary = this->d->dictionary;
+    this->d->dictionary = input.size() >= DICTIONARY_SIZE
+        ? input.right(DICTIONARY_SIZE)
+        : (dictionary + input).right(DICTIONARY_SIZE);
+    this->d->pending = QByteArray();
+    this->d->pending.reserve(BLOCK_SIZE);
+
+    Private* d = this->d;
+    const qint64 sequence = d->nextDispatch++;
+    const int level = d->level;
+    d->pool.start([d, sequence, input, dictionary, level, last]() {
+        CompressedBlock block = deflateBlock(input, dictionary, level, last);
+        QMutexLocker locker(&d->mutex);
+        d->done.insert(sequence, block);
+        d->blockDone.wakeAll();
+    });
+
+    return this->drain(false);
+#endif
+}
+
+bool ParallelGzip::drain(bool finishing)
+{
+#ifndef XENADMIN_NO_ZLIB
+    for (;;)
+    {
+        CompressedBlock block;
+        {
+            QMutexLocker locker(&this->d->mutex);
+            while (!this->d->done.contains(this->d->nextEmit))
+            {
+                const qint64 inFlight = this->d->nextDispatch - this->d->nextEmit;
+                const bool mustWait = finishing ? inFlight > 0 : inFlight >= this->d->maxInFlight;
+                if (!mustWait)
+                    return true;
+                this->d->blockDone.wait(&this->d->mutex);
+            }
+            block = this->d->done.take(this->d->nextEmit++);
+        }
+
+        if (!block.error.isEmpty())
+        {
+            this->d->failed = true;
+            this->d->error = block.error;
+            return false;
+        }
+
+        if (!this->d->headerWritten)
+        {
+            // Minimal gzip header: no name, no mtime, OS "unknown"; XFL marks level 9/1 like gzip does
+            const char xfl = this->d->level == 9 ? 2 : (this->d->level == 1 ? 4 : 0);
+            const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, xfl, '\xff' };
+            if (!this->emitBytes(header, sizeof(header)))
+                return false;
+            this->d->headerWritten = true;
+        }
+
+        this->d->crc = static_cast<quint32>(crc32_combine(this->d->crc, block.crc, static_cast<z_off_t>(block.length)));
+        if (!this->emitBytes(block.output.constData(), block.output.size()))
+            return false;
+    }
+#else
+    Q_UNUSED(finishing)
+    return false;
+#endif
+}
+
+bool ParallelGzip::emitBytes(const char* data, qint64 size)
+{
+    QString error;
+    if (!this->d->sink(data, size, error))
+    {
+        this->d->failed = true;
+        this->d->error = error;
+        return false;
+    }
+    this->d->bytesOut += size;
+    return true;
+}
+
+// ── File helpers ─────────────────────────────────────────────────────────────
+
+bool ParallelGzip::CompressFile(const QString& sourcePath,
+                                const QString& destPath,
+                                int level,
+                                QString& errorOut,
+                                CancelCallback cancelled,
+                                ProgressCallback progress)
+{
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open %1: %2").arg(sourcePath, source.errorString());
+        return false;
+    }
+
+    QFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        errorOut = QString("Cannot create %1: %2").arg(destPath, dest.errorString());
+        return false;
+    }
+
+    ParallelGzip gzip([&dest](const char* data, qint64 size, QString& error) {
+        if (dest.write(data, size) == size)
+            return true;
+        error = dest.errorString();
+        return false;
+    }, level);
+
+    const qint64 total = source.size();
+    QByteArray buffer(FILE_CHUNK_SIZE, Qt::Uninitialized);
+    bool ok = true;
+    while (ok && !source.atEnd())
+    {
+        if (cancelled && cancelled())
+        {
+            errorOut = QStringLiteral("Operation cancelled by user");
+            ok = false;
+            break;
+        }
+
+        const qint64 n = source.read(buffer.data(), buffer.size());
+        if (n < 0)
+        {
+            errorOut = QString("Failed to read %1: %2").arg(sourcePath, source.errorString());
+            ok = false;
+            break;
+        }
+        if (n == 0)
+            break;
+
+        ok = gzip.Write(buffer.constData(), n);
+        if (progress)
+            progress(source.pos(), total);
+    }
+
+    if (ok)
+        ok = gzip.Finish();
+    if (!ok && errorOut.isEmpty())
+        errorOut = gzip.GetError();
+
+    dest.close();
+    if (!ok)
+        QFile::remove(destPath);
+    return ok;
+}
+
+bool ParallelGzip::DecompressFile(const QString& sourcePath,
+                                  const QString& destPath,
+                                  QString& errorOut,
+                                  CancelCallback cancelled,
+                                  ProgressCallback progress)
+{
+#ifdef XENADMIN_NO_ZLIB
+    Q_UNUSED(sourcePath)
+    Q_UNUSED(destPath)
+    Q_UNUSED(cancelled)
+    Q_UNUSED(progress)
+    errorOut = QStringLiteral("Gzip decompression support is not available in this build");
+    return false;
+#else
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        errorOut = QString("Cannot open compressed file: %1").arg(sourcePath);
+        return false;
+    }
+
+    QFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        errorOut = QString("Cannot create output file %1: %2").arg(destPath, dest.errorString());
+        return false;
+    }
+
+    ChunkQueue compressed(FILE_QUEUE_DEPTH);
+    ChunkQueue inflated(FILE_QUEUE_DEPTH);
+    QMutex errorMutex;
+    QString stageError;
+
+    auto fail = [&](const QString& message) {
+        {
+            QMutexLocker locker(&errorMutex);
+            if (stageError.isEmpty())
+                stageError = message;
+        }
+        compressed.Abort();
+        inflated.Abort();
+    };
+
+    QThread* reader = QThread::create([&]() {
+        while (!source.atEnd())
+        {
+            QByteArray chunk(FILE_CHUNK_SIZE, Qt::Uninitialized);
+            const qint64 n = source.read(chunk.data(), chunk.size());
+            if (n < 0)
+            {
+                fail(QString("Failed to read %1: %2").arg(sourcePath, source.errorString()));
+                return;
+            }
+            if (n == 0)
+                break;
+            chunk.resize(static_cast<int>(n));
+            if (!compressed.Push(chunk))
+                return;
+        }
+        compressed.Close();
+    });
+
+    QThread* writer = QThread::create([&]() {
+        QByteArray chunk;
+        while (inflated.Pop(chunk))
+        {
+            if (dest.write(chunk) != chunk.size())
+            {
+                fail(QString("Failed to write %1: %2").arg(destPath, dest.errorString()));
+                return;
+            }
+        }
+    });
+
+    const qint64 total = source.size();
+    qint64 consumed = 0;
+
+    reader->start();
+    writer->start();
+    bool cancelledByUser = false;
+
+    z_stream zs = {};
+    // 15 + 32: gzip or zlib header detected automatically, CRC and size checked by zlib
+    bool ok = inflateInit2(&zs, 15 + 32) == Z_OK;
+    if (!ok)
+        fail(QStringLiteral("Failed to initialise decompressor"));
+
+    int ret = Z_OK;
+    bool trailingGarbage = false;
+    QByteArray input;
+    QByteArray output(FILE_CHUNK_SIZE, Qt::Uninitialized);
+    zs.next_out = reinterpret_cast<Bytef*>(output.data());
+    zs.avail_out = FILE_CHUNK_SIZE;
+
+    while (ok && compressed.Pop(input))
+    {
+        if (cancelled && cancelled())
+        {
+            cancelledByUser = true;
+            fail(QStringLiteral("Operation cancelled by user"));
+            break;
+        }
+
+        zs.next_in = reinterpret_cast<Bytef*>(input.data());
+        zs.avail_in = trailingGarbage ? 0 : static_cast<uInt>(input.size());
+        while (zs.avail_in > 0)
+        {
+            if (ret == Z_STREAM_END)
+            {
+                // Another member may follow (concatenated .gz files); anything
+                // else after a complete member is ignored, as gzread() does
+                if (zs.next_in[0] != 0x1f || (zs.avail_in > 1 && zs.next_in[1] != 0x8b))
+                {
+                    trailingGarbage = true;
+                    break;
+                }
+                inflateReset(&zs);
+            }
+
+            ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            {
+                fail(QString("Corrupt compressed data (%1)").arg(QString::fromLatin1(zs.msg ? zs.msg : "inflate failed")));
+                ok = false;
+                break;
+            }
+
+            if (zs.avail_out == 0 || (ret == Z_STREAM_END && zs.avail_out < FILE_CHUNK_SIZE))
+            {
+                output.resize(FILE_CHUNK_SIZE - static_cast<int>(zs.avail_out));
+                if (!inflated.Push(output))
+                {
+                    ok = false;
+                    break;
+                }
+                output = QByteArray(FILE_CHUNK_SIZE, Qt::Uninitialized);
+                zs.next_out = reinterpret_cast<Bytef*>(output.data());
+                zs.avail_out = FILE_CHUNK_SIZE;
+            }
+
+            if (ret == Z_BUF_ERROR)
+                break;
+        }
+
+        consumed += input.size();
+        if (progress)
+            progress(consumed, total);
+    }
+
+    if (ok && !cancelledByUser && !compressed.IsAborted())
+    {
+        if (zs.avail_out < FILE_CHUNK_SIZE)
+        {
+            output.resize(FILE_CHUNK_SIZE - static_cast<int>(zs.avail_out));
+            inflated.Push(output);
+        }
+        if (ret != Z_STREAM_END)
+            fail(QStringLiteral("Unexpected end of compressed file"));
+    }
+    inflateEnd(&zs);
+
+    inflated.Close();
+    reader->wait();
+    writer->wait();
+    delete reader;
+    delete writer;
+    dest.close();
+
+    if (!stageError.isEmpty())
+    {
+        errorOut = stageError;
+        QFile::remove(destPath);
+        return false;
+    }
+    return true;
+#endif
+}
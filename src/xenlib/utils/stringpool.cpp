@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "stringpool.h"
+#include <QMutexLocker>
+#include <QStringList>
+
+QString StringPool::Intern(const QString& value)
+{
+    if (value.isEmpty() || value.size() > MAX_INTERNED_LENGTH)
+        return value;
+
+    QMutexLocker locker(&this->m_mutex);
+    return this->internLocked(value);
+}
+
+QVariantMap StringPool::Intern(const QVariantMap& record)
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->internLocked(record);
+}
+
+void StringPool::Prune()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->pruneLocked();
+}
+
+void StringPool::Clear()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_strings.clear();
+    this->m_pruneThreshold = INITIAL_PRUNE_THRESHOLD;
+}
+
+int StringPool::Size() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_strings.size();
+}
+
+QString StringPool::internLocked(const QString& value)
+{
+    if (value.isEmpty() || value.size() > MAX_INTERNED_LENGTH)
+        return value;
+
+    auto it = this->m_strings.constFind(value);
+    if (it != this->m_strings.constEnd())
+        return *it;
+
+    if (this->m_strings.size() >= this->m_pruneThreshold)
+        this->pruneLocked();
+
+    this->m_strings.insert(value);
+    return value;
+}
+
+QVariant StringPool::internLocked(const QVariant& value)
+{
+    switch (value.typeId())
+    {
+        case QMetaType::QString:
+            return this->internLocked(value.toString());
+
+        case QMetaType::QVariantMap:
+            return this->internLocked(value.toMap());
+
+        case QMetaType::QVariantList:
+        {
+            QVariantList list = value.toList();
+            for (QVariant& item : list)
+                item = this->internLocked(item);
+            return list;
+        }
+
+        case QMetaType::QStringList:
+        {
+            QStringList list = value.toStringList();
+            for (QString& item : list)
+                item = this->internLocked(item);
+            return list;
+        }
+
+        default:
+            return value;
+    }
+}
+
+QVariantMap StringPool::internLocked(const QVariantMap& map)
+{
+    // Keys arrive sorted, so appending at the end keeps every insert O(1)
+    QVariantMap result;
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+        result.insert(result.cend(), this->internLocked(it.key()), this->internLocked(it.value()));
+    return result;
+}
+
+void StringPool::pruneLocked()
+{
+    // A detached entry has no user left besides the table itself
+    for (auto it = this->m_strings.begin(); it != this->m_strings.end(); )
+    {
+        if (it->isDetached())
+            it = this->m_strings.erase(it);
+        else
+            ++it;
+    }
+    this->m_pruneThreshold = qMax(INITIAL_PRUNE_THRESHOLD, static_cast<int>(this->m_strings.size()) * 2);
+}
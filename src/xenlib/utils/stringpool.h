@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVariant>
+
+/**
+ * @brief Intern table that lets equal strings share one buffer.
+ *
+ * XenAPI records repeat the same short strings over and over: opaque refs in
+ * every cross reference (resident_on, VBDs, VIFs...), UUIDs, enum values such
+ * as "Running" and all the field names. Each record parsed from JSON owns its
+ * own copy of every one of them. Running a record through Intern() swaps each
+ * short string for the pool's implicitly shared instance, so a ref mentioned
+ * from thousands of places is stored once.
+ *
+ * Strings longer than MAX_INTERNED_LENGTH (descriptions, blobs) are left
+ * alone; they are rarely repeated and would only grow the table. Entries
+ * nobody else references any more are dropped by Prune(), which also runs
+ * automatically whenever the table has doubled since the last prune.
+ *
+ * Thread-safe.
+ */
+class StringPool
+{
+    public:
+        static const int MAX_INTERNED_LENGTH = 80;
+        static const int INITIAL_PRUNE_THRESHOLD = 4096;
+
+        StringPool() = default;
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+        QString Intern(const QString& value);
+
+        /**
+         * @brief Intern keys and string values of a record, recursing into maps and lists
+         */
+        QVariantMap Intern(const QVariantMap& record);
+
+        /**
+         * @brief Drop strings that only the pool still holds
+         */
+        void Prune();
+
+        void Clear();
+        int Size() const;
+
+    private:
+        mutable QMutex m_mutex;
+        QSet<QString> m_strings;
+        int m_pruneThreshold = INITIAL_PRUNE_THRESHOLD;
+
+        QString internLocked(const QString& value);
+        QVariant internLocked(const QVariant& value);
+        QVariantMap internLocked(const QVariantMap& map);
+        void pruneLocked();
+};
+
+#endif // STRINGPOOL_H
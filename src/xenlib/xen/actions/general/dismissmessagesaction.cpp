@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dismissmessagesaction.h"
+#include "../../failure.h"
+#include "../../xenapi/xenapi_Message.h"
+#include <QDebug>
+
+DismissMessagesAction::DismissMessagesAction(XenConnection* connection, const QStringList& messageRefs, QObject* parent)
+    : AsyncOperation(connection,
+                     QString("Dismissing %1 alert(s)").arg(messageRefs.size()),
+                     QString("Dismissing alerts..."),
+                     true,
+                     parent),
+      m_messageRefs(messageRefs)
+{
+    this->SetCanCancel(true);
+    this->AddApiMethodToRoleCheck("message.destroy");
+}
+
+void DismissMessagesAction::run()
+{
+    this->m_ran.storeRelease(1);
+
+    QStringList remaining;
+    QString firstError;
+    const int total = this->m_messageRefs.size();
+
+    for (int i = 0; i < total; ++i)
+    {
+        const QString& ref = this->m_messageRefs.at(i);
+        if (this->IsCancelled())
+        {
+            remaining.append(this->m_messageRefs.mid(i));
+            break;
+        }
+
+        try
+        {
+            XenAPI::Message::destroy(this->GetSession(), ref);
+        } catch (const Failure& failure)
+        {
+            // Someone else dismissed it first
+            if (failure.errorCode() != Failure::HANDLE_INVALID)
+            {
+                remaining.append(ref);
+                if (firstError.isEmpty())
+                    firstError = failure.message();
+            }
+        } catch (const std::exception& e)
+        {
+            remaining.append(ref);
+            if (firstError.isEmpty())
+                firstError = QString::fromLocal8Bit(e.what());
+        }
+
+        this->SetPercentComplete((i + 1) * 100 / total);
+    }
+
+    const int destroyed = total - remaining.size();
+    this->SetDescription(QString("Dismissed %1 of %2 alert(s)").arg(destroyed).arg(total));
+
+    if (!remaining.isEmpty())
+    {
+        qWarning() << "DismissMessagesAction:" << remaining.size() << "message(s) not destroyed:" << firstError;
+        emit this->messagesNotDestroyed(remaining);
+        if (!firstError.isEmpty())
+            throw std::runtime_error(firstError.toStdString());
+    }
+}
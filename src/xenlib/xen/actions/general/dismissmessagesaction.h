@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DISMISSMESSAGESACTION_H
+#define DISMISSMESSAGESACTION_H
+
+#include "../../asyncoperation.h"
+#include <QAtomicInt>
+#include <QStringList>
+
+/**
+ * @brief Destroys a batch of XenAPI messages on one connection
+ *
+ * Qt counterpart of the message.destroy loop in C# DeleteAllAlertsAction.
+ * AlertManager::DismissAlerts() splits a dismissal into batches of these
+ * and runs them through a ParallelAction, so large dismissals are spread
+ * over several concurrent calls and report progress as they go.
+ *
+ * Messages that are already gone (HANDLE_INVALID) count as destroyed.
+ * The alerts themselves are removed when the message deletion arrives
+ * through the event stream; refs that could not be destroyed are reported
+ * through messagesNotDestroyed() so their alerts can be shown again.
+ */
+class XENLIB_EXPORT DismissMessagesAction : public AsyncOperation
+{
+    Q_OBJECT
+
+    public:
+        DismissMessagesAction(XenConnection* connection,
+                              const QStringList& messageRefs,
+                              QObject* parent = nullptr);
+
+        QStringList GetMessageRefs() const { return this->m_messageRefs; }
+
+        /** @brief False if the batch failed or was cancelled before run(), so nothing was reported. */
+        bool HasRun() const { return this->m_ran.loadAcquire() != 0; }
+
+    signals:
+        /** @brief Emitted once at the end of run() with the refs that still exist. */
+        void messagesNotDestroyed(const QStringList& messageRefs);
+
+    protected:
+        void run() override;
+
+    private:
+        QStringList m_messageRefs;
+        QAtomicInt m_ran = 0;
+};
+
+#endif // DISMISSMESSAGESACTION_H
@@ -34,7 +34,6 @@
 #include "xenlib/xen/xenapi/xenapi_SR.h"
 #include "xenlib/xencache.h"
 #include <QDebug>
-#include <QThread>
 
 DestroyHostAction::DestroyHostAction(QSharedPointer<Host> host, QObject* parent)
     : AsyncOperation(host->GetConnection(),
@@ -140,45 +139,27 @@ void DestroyHostAction::run()
 bool DestroyHostAction::isSRDetached(const QString& srRef)
 {
     // Wait up to 2 minutes for all SR's PBDs to detach
-    const int maxSeconds = 2 * 60;
+    const int timeoutMs = 2 * 60 * 1000;
 
-    for (int i = 0; i < maxSeconds; i++)
+    XenCache* cache = GetConnection()->GetCache();
+    auto allDetached = [cache, &srRef]() -> bool
     {
-        QSharedPointer<SR> sr = GetConnection()->GetCache()->ResolveObject<SR>(srRef);
-        QList<QSharedPointer<PBD>> pbds = sr ? sr->GetPBDs() : QList<QSharedPointer<PBD>>();
-
-        if (pbds.isEmpty())
-        {
-            return true; // All PBDs detached
-        }
-
-        // Check if any PBDs are still attached
-        bool anyAttached = false;
+        QSharedPointer<SR> sr = cache->ResolveObject<SR>(srRef);
+        const QList<QSharedPointer<PBD>> pbds = sr ? sr->GetPBDs() : QList<QSharedPointer<PBD>>();
         for (const QSharedPointer<PBD>& pbd : pbds)
         {
-            if (!pbd || !pbd->IsValid())
-                continue;
-
-            bool currentlyAttached = pbd->IsCurrentlyAttached();
-
-            if (currentlyAttached)
-            {
-                anyAttached = true;
-                break;
-            }
-        }
-
-        if (!anyAttached)
-        {
-            return true; // All PBDs detached
+            if (pbd && pbd->IsValid() && pbd->IsCurrentlyAttached())
+                return false;
         }
+        return true;
+    };
 
-        // Wait 1 second before checking again
-        QThread::msleep(1000);
-    }
+    // PBD records change as they detach; the SR changes if one goes away
+    if (cache->WaitFor({ XenObjectType::PBD, XenObjectType::SR }, QStringList(), allDetached, timeoutMs))
+        return true;
 
     // Timeout - check one last time
-    QSharedPointer<SR> sr = GetConnection()->GetCache()->ResolveObject<SR>(srRef);
+    QSharedPointer<SR> sr = cache->ResolveObject<SR>(srRef);
     QList<QSharedPointer<PBD>> pbds = sr ? sr->GetPBDs() : QList<QSharedPointer<PBD>>();
     return pbds.isEmpty();
 }
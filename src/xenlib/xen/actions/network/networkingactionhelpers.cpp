@@ -37,7 +37,6 @@
 #include "../../host.h"
 #include "../../pool.h"
 #include "../../../xencache.h"
-#include <QThread>
 #include <QDebug>
 
 static QSharedPointer<PIF> resolvePif(AsyncOperation* action, const QString& pifRef)
@@ -206,19 +205,20 @@ void NetworkingActionHelpers::clearIP(AsyncOperation* action, const QString& pif
 void NetworkingActionHelpers::waitForMembersToRecover(XenConnection* connection, const QString& poolRef)
 {
     Q_UNUSED(poolRef)
-    const int retryLimit = 60;
-    int retryAttempt = 0;
+    // Each phase gives up after about a minute, as the old once-a-second poll did
+    const int phaseTimeoutMs = 60 * 1000;
 
     QList<QString> deadHosts;
 
     if (!connection || !connection->GetCache())
         return;
 
-    QSharedPointer<Pool> pool = connection->GetCache()->GetPoolOfOne();
+    XenCache* cache = connection->GetCache();
+    QSharedPointer<Pool> pool = cache->GetPoolOfOne();
     const QString coordinatorRef = pool ? pool->GetMasterHostRef() : QString();
 
     int totalHosts = 0;
-    QList<QSharedPointer<Host>> hosts = connection->GetCache()->GetAll<Host>(XenObjectType::Host);
+    QList<QSharedPointer<Host>> hosts = cache->GetAll<Host>(XenObjectType::Host);
     for (const QSharedPointer<Host>& host : hosts)
     {
         if (!host || !host->IsValid())
@@ -227,60 +227,35 @@ void NetworkingActionHelpers::waitForMembersToRecover(XenConnection* connection,
             totalHosts++;
     }
 
+    // Liveness lives in host_metrics, so changes to either type re-check
+    const QList<XenObjectType> liveTypes = { XenObjectType::Host, XenObjectType::HostMetrics };
+
     // Wait for supporters to go offline
-    while (deadHosts.count() < totalHosts && retryAttempt <= retryLimit)
-    {
-        hosts = connection->GetCache()->GetAll<Host>(XenObjectType::Host);
-        for (const QSharedPointer<Host>& host : hosts)
+    cache->WaitFor(liveTypes, QStringList(), [&]() {
+        for (const QSharedPointer<Host>& host : cache->GetAll<Host>(XenObjectType::Host))
         {
-            if (!host || !host->IsValid())
-                continue;
-
-            QString hostRef = host->OpaqueRef();
-            QString hostUuid = host->GetUUID();
-
-            if (hostRef == coordinatorRef)
-            {
+            if (!host || !host->IsValid() || host->OpaqueRef() == coordinatorRef)
                 continue;
-            }
 
-            bool isLive = host->IsLive();
-            if (!isLive && !deadHosts.contains(hostUuid))
-            {
+            const QString hostUuid = host->GetUUID();
+            if (!host->IsLive() && !deadHosts.contains(hostUuid))
                 deadHosts.append(hostUuid);
-            }
         }
-        retryAttempt++;
-        QThread::msleep(1000);
-    }
+        return deadHosts.count() >= totalHosts;
+    }, phaseTimeoutMs);
 
     // Wait for supporters to come back online
-    retryAttempt = 0;
-    while (!deadHosts.isEmpty() && retryAttempt <= retryLimit)
-    {
-        hosts = connection->GetCache()->GetAll<Host>(XenObjectType::Host);
-        for (const QSharedPointer<Host>& host : hosts)
+    cache->WaitFor(liveTypes, QStringList(), [&]() {
+        for (const QSharedPointer<Host>& host : cache->GetAll<Host>(XenObjectType::Host))
         {
-            if (!host || !host->IsValid())
+            if (!host || !host->IsValid() || host->OpaqueRef() == coordinatorRef)
                 continue;
 
-            QString hostRef = host->OpaqueRef();
-            QString hostUuid = host->GetUUID();
-
-            if (hostRef == coordinatorRef)
-            {
-                continue;
-            }
-
-            bool isLive = host->IsLive();
-            if (isLive && deadHosts.contains(hostUuid))
-            {
-                deadHosts.removeAll(hostUuid);
-            }
+            if (host->IsLive())
+                deadHosts.removeAll(host->GetUUID());
         }
-        retryAttempt++;
-        QThread::msleep(1000);
-    }
+        return deadHosts.isEmpty();
+    }, phaseTimeoutMs);
 
     qDebug() << "Pool members recovered";
 }
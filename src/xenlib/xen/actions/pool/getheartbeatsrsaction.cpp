@@ -33,7 +33,6 @@
 #include "../../jsonrpcclient.h"
 #include "../../../xencache.h"
 #include "../../xenapi/xenapi_SR.h"
-#include <QThread>
 
 namespace
 {
@@ -65,6 +64,10 @@ QString decodeUnsuitableReason(const QString& rawError)
     return QObject::tr("This SR does not support this operation.");
 }
 
+// Upper bound between server reads of a pending task; normally the task's
+// cache event wakes the wait much sooner
+const int TASK_WAIT_MS = 2000;
+
 QStringList taskErrorInfo(const QVariantMap& taskRecord)
 {
     QStringList errors;
@@ -163,7 +166,13 @@ void GetHeartbeatSRsAction::run()
                         break;
                     }
 
-                    QThread::msleep(250);
+                    // Sleep until the task's record changes in the cache
+                    // (or a few seconds pass), then re-read it from the server
+                    cache->WaitFor(XenObjectType::Task, taskRef, [cache, &taskRef]() {
+                        const QString cached = cache->ResolveObjectData(XenObjectType::Task, taskRef)
+                                                   .value("status").toString();
+                        return !cached.isEmpty() && cached != "pending";
+                    }, TASK_WAIT_MS, [this]() { return this->IsCancelled(); });
                 }
 
                 this->destroyTask();
@@ -29,6 +29,8 @@
 #include "../../xenapi/xenapi_VM.h"
 #include "../../host.h"
 #include "../../vm.h"
+#include "../../network/connection.h"
+#include "../../../xencache.h"
 #include <stdexcept>
 
 ChangeMemorySettingsAction::ChangeMemorySettingsAction(QSharedPointer<VM> vm,
@@ -137,16 +139,10 @@ void ChangeMemorySettingsAction::run()
 
             // Wait for VM to reach Halted state
             SetDescription("Waiting for VM to halt...");
-            bool halted = false;
-            for (int i = 0; i < 60; ++i)
-            { // Wait up to 60 seconds
-                if (this->m_vm->GetPowerState() == "Halted")
-                {
-                    halted = true;
-                    break;
-                }
-                QThread::sleep(1);
-            }
+            const bool halted = GetConnection()->GetCache()->WaitFor(
+                XenObjectType::VM, this->m_vm->OpaqueRef(),
+                [this]() { return this->m_vm->GetPowerState() == "Halted"; },
+                60 * 1000); // Wait up to 60 seconds
 
             if (!halted)
             {
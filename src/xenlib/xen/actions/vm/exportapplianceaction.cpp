@@ -29,6 +29,7 @@
 
 #include "../../network/httpclient.h"
 #include "../../network/connection.h"
+#include "../../network/transferbatch.h"
 #include "../../session.h"
 #include "../../xenapi/xenapi_Task.h"
 #include "../../vm.h"
@@ -38,9 +39,13 @@
 #include "../../network.h"
 #include "../../../xencache.h"
 #include "../../../ovf/ovfwriter.h"
+#include "../../../ovf/ovatar.h"
+#include "../../../ovf/ovfexportstream.h"
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QCryptographicHash>
+#include <QVector>
 #include <QDebug>
 
 // ── Constructor ───────────────────────────────────────────────────────────────
@@ -103,52 +108,37 @@ void ExportApplianceAction::run()
         return;
     }
 
-    // Create output directory: applianceDir/applianceName/
-    const QString appFolder = m_applianceDir + QDir::separator() + m_applianceName;
+#ifdef XENADMIN_NO_ZLIB
+    if (m_compressFiles)
     {
-        QDir d;
-        if (!d.exists(appFolder))
-        {
-            if (!d.mkpath(appFolder))
-            {
-                this->setError(tr("Cannot create output directory: %1").arg(appFolder));
-                this->setState(OperationState::Failed);
-                return;
-            }
-            this->m_createdAppFolder = true;
-        }
+        this->setError(tr("Gzip compression support is not available in this build."));
+        this->setState(OperationState::Failed);
+        return;
     }
+#endif
 
-    // Export each VM, 0–80% of total progress
+    const QString appFolder = m_applianceDir + QDir::separator() + m_applianceName;
+    const QString ovaPath   = m_applianceDir + QDir::separator()
+                              + m_applianceName + QStringLiteral(".ova");
+
+    // Describe every VM first. All hrefs are final before any disk data moves,
+    // so the descriptor can lead the OVA as the spec requires.
     OvfEnvelopeData envelope;
     envelope.name = m_applianceName;
+    QList<PendingDisk> disks;
 
-    const int vmTotal = m_vms.size();
-    for (int i = 0; i < vmTotal; ++i)
+    for (const QSharedPointer<VM>& vm : m_vms)
     {
         if (this->IsCancelled())
-            break;
-
-        const QSharedPointer<VM>& vm = m_vms[i];
-        this->SetDescription(tr("Exporting %1…").arg(vm->GetName()));
-
-        OvfVirtualSystemEntry sys;
-        if (!this->buildVirtualSystem(vm, appFolder, i, vmTotal, sys))
         {
-            // Error already set inside buildVirtualSystem
-            this->cleanupOnError(appFolder);
-            this->setState(OperationState::Failed);
+            this->setState(OperationState::Cancelled);
             return;
         }
-        envelope.systems << sys;
-        this->SetPercentComplete((i + 1) * 80 / vmTotal);
-    }
 
-    if (this->IsCancelled())
-    {
-        this->cleanupOnError(appFolder);
-        this->setState(OperationState::Cancelled);
-        return;
+        this->SetDescription(tr("Exporting %1…").arg(vm->GetName()));
+        OvfVirtualSystemEntry sys;
+        this->buildVirtualSystem(vm, sys, disks);
+        envelope.systems << sys;
     }
 
     // Read EULA file content
@@ -159,59 +149,130 @@ void ExportApplianceAction::run()
             envelope.eulaTexts << QString::fromUtf8(f.readAll());
     }
 
-    // Optionally compress VHDs *before* writing the OVF so hrefs are correct
-    if (m_compressFiles)
+    // Open the destination: a single OVA archive, or the appliance folder
+    QFile ovaFile(ovaPath);
+    OvaTarWriter ovaWriter(&ovaFile);
+    OvaTarWriter* tar = nullptr;
+    if (m_createOva)
     {
-#ifdef XENADMIN_NO_ZLIB
-        this->setError(tr("Gzip compression support is not available in this build."));
-        this->cleanupOnError(appFolder);
-        this->setState(OperationState::Failed);
-        return;
-#else
-        this->SetDescription(tr("Compressing disk files…"));
-        OvfWriter writer;
-        if (!writer.compressVhds(envelope, appFolder))
+        if (!ovaFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
         {
-            this->setError(tr("Failed to compress VHD files in %1").arg(appFolder));
-            this->cleanupOnError(appFolder);
+            this->setError(tr("Failed to create OVA archive: %1").arg(ovaPath));
             this->setState(OperationState::Failed);
             return;
         }
-        this->SetPercentComplete(83);
-#endif
+        this->m_createdOvaFile = true;
+        tar = &ovaWriter;
+    } else
+    {
+        QDir d;
+        if (!d.exists(appFolder))
+        {
+            if (!d.mkpath(appFolder))
+            {
+                this->setError(tr("Cannot create output directory: %1").arg(appFolder));
+                this->setState(OperationState::Failed);
+                return;
+            }
+            this->m_createdAppFolder = true;
+        }
     }
 
-    // Write OVF descriptor (hrefs are now final)
-    const QString ovfFileName = m_applianceName + QStringLiteral(".ovf");
-    const QString ovfFilePath = appFolder + QDir::separator() + ovfFileName;
-    this->SetDescription(tr("Writing OVF descriptor…"));
+    auto fail = [&](const QString& message)
+    {
+        if (!message.isEmpty())
+            this->setError(message);
+        ovaFile.close();
+        this->cleanupOnError(appFolder);
+        this->setState(this->IsCancelled() ? OperationState::Cancelled : OperationState::Failed);
+    };
 
+    // OVF descriptor (hrefs are already final)
     OvfWriter writer;
-    if (!writer.saveToFile(envelope, ovfFilePath))
+    const QString ovfFileName = m_applianceName + QStringLiteral(".ovf");
+    const QString baseName    = QFileInfo(ovfFileName).baseName();
+    const QByteArray ovfData  = writer.generateXml(envelope).toUtf8();
+
+    this->SetDescription(tr("Writing OVF descriptor…"));
+    if (!this->writeMember(appFolder, tar, ovfFileName, ovfData))
     {
-        this->setError(tr("Failed to write OVF file: %1").arg(ovfFilePath));
-        this->cleanupOnError(appFolder);
-        this->setState(OperationState::Failed);
+        fail(tr("Failed to write OVF file: %1").arg(ovfFileName));
         return;
     }
-    this->SetPercentComplete(85);
 
-    if (this->IsCancelled())
+    QStringList manifestLines;
+    manifestLines << OvfWriter::manifestLine(
+        ovfFileName,
+        QString::fromLatin1(QCryptographicHash::hash(ovfData, QCryptographicHash::Sha256).toHex()));
+
+    // Disks, 0–85% of total progress. Folder packages stream several disks
+    // at once; an OVA is a single sequential archive so its members go one
+    // at a time.
+    QVector<QString> diskDigests(disks.size());
+    QVector<QList<OvfStreamStageStats>> diskStats(disks.size());
+
+    TransferBatch batch(this->GetConnection(), this->GetConnection()->GetHostname());
+    if (tar)
+        batch.SetMaxConcurrency(1);
+    for (int i = 0; i < disks.size(); ++i)
     {
-        this->cleanupOnError(appFolder);
-        this->setState(OperationState::Cancelled);
+        const PendingDisk& disk = disks.at(i);
+        batch.AddJob(disk.label, disk.virtualSize,
+            [this, &disk, &appFolder, tar, &diskDigests, &diskStats, i](const TransferBatch::ReportFunction& report,
+                                                                         const TransferBatch::CancelFunction& cancelled)
+            {
+                QString error;
+                const bool ok = this->streamDisk(disk, appFolder, tar,
+                                                 [&](qint64 bytes) { report(qMin(bytes, disk.virtualSize), disk.virtualSize); },
+                                                 cancelled, diskDigests[i], diskStats[i], error);
+                if (!ok)
+                    throw std::runtime_error(error.isEmpty() ? "Transfer cancelled" : error.toStdString());
+            });
+    }
+
+    const bool streamed = batch.Run(
+        [this](int pct, const QString& active)
+        {
+            this->SetPercentComplete(qBound(0, pct * 85 / 100, 85));
+            if (!active.isEmpty())
+                this->SetDescription(tr("Exporting disks: %1…").arg(active));
+        },
+        [this]() -> bool { return this->IsCancelled(); });
+
+    if (!streamed)
+    {
+        fail(batch.WasCancelled() ? QString() : tr("Failed to export disk %1").arg(batch.GetError()));
         return;
     }
 
-    // Manifest + signing (matches C# ManifestAndSign())
+    this->m_stageStats.clear();
+    for (int i = 0; i < disks.size(); ++i)
+    {
+        manifestLines << OvfWriter::manifestLine(disks.at(i).href, diskDigests.at(i));
+
+        const QList<OvfStreamStageStats>& stats = diskStats.at(i);
+        if (this->m_stageStats.isEmpty())
+            this->m_stageStats = stats;
+        else
+            for (int stage = 0; stage < stats.size() && stage < this->m_stageStats.size(); ++stage)
+                this->m_stageStats[stage].Accumulate(stats[stage]);
+    }
+    this->SetPercentComplete(85);
+
+    for (const OvfStreamStageStats& stats : this->m_stageStats)
+        qInfo().noquote() << "ExportApplianceAction:" << stats.ToString();
+
+    // Manifest + signing (matches C# ManifestAndSign()), from the digests
+    // computed while streaming
+    const QString mfName = baseName + QStringLiteral(".mf");
+    QByteArray mfData;
     if (m_signAppliance || m_createManifest || m_createOva)
     {
         this->SetDescription(tr("Creating manifest…"));
-        if (!writer.createManifest(envelope, appFolder, ovfFileName))
+        mfData = manifestLines.join(QChar('\n')).toUtf8() + '\n';
+        if (!this->writeMember(appFolder, tar, mfName, mfData))
         {
-            this->setError(tr("Failed to create manifest for package %1").arg(m_applianceName));
-            this->cleanupOnError(appFolder);
-            this->setState(OperationState::Failed);
+            fail(tr("Failed to create manifest for package %1").arg(m_applianceName));
             return;
         }
         this->SetPercentComplete(90);
@@ -221,11 +282,15 @@ void ExportApplianceAction::run()
     {
         this->SetDescription(tr("Signing appliance…"));
         QString signError;
-        if (!writer.signPackage(appFolder, ovfFileName, m_certPath, m_certPassword, signError))
+        QByteArray certData;
+        if (!writer.signManifest(mfName, mfData, m_certPath, m_certPassword, certData, signError))
         {
-            this->setError(tr("Failed to sign package: %1").arg(signError));
-            this->cleanupOnError(appFolder);
-            this->setState(OperationState::Failed);
+            fail(tr("Failed to sign package: %1").arg(signError));
+            return;
+        }
+        if (!this->writeMember(appFolder, tar, baseName + QStringLiteral(".cert"), certData))
+        {
+            fail(tr("Failed to sign package: %1").arg(tr("cannot write certificate")));
             return;
         }
         this->SetPercentComplete(92);
@@ -233,40 +298,37 @@ void ExportApplianceAction::run()
 
     if (this->IsCancelled())
     {
-        this->cleanupOnError(appFolder);
-        this->setState(OperationState::Cancelled);
+        fail(QString());
         return;
     }
 
-    // OVA
-    if (m_createOva)
+    if (tar)
     {
-        const QString ovaPath = m_applianceDir + QDir::separator()
-                                + m_applianceName + QStringLiteral(".ova");
-        this->SetDescription(tr("Creating OVA archive %1.ova…").arg(m_applianceName));
-        if (!writer.createOva(envelope, appFolder, ovfFileName, ovaPath))
+        if (!tar->Finish())
         {
-            this->setError(tr("Failed to create OVA archive: %1").arg(ovaPath));
-            this->cleanupOnError(appFolder);
-            this->setState(OperationState::Failed);
+            fail(tr("Failed to create OVA archive: %1").arg(tar->GetLastError()));
             return;
         }
-        this->SetPercentComplete(98);
+        ovaFile.close();
+        this->SetPercentComplete(95);
     }
 
     // Verification
-    // If a manifest was created, verify every file against its SHA-256 digest.
-    // If no manifest exists (user disabled it), perform a basic file-existence and
-    // non-zero-size check — equivalent to C# verifying that each exported stream
-    // was written completely.
+    // OVA archives and manifest-backed folders are re-read and every file is
+    // checked against its SHA-256 digest. If no manifest exists (user disabled
+    // it), perform a basic file-existence and non-zero-size check — equivalent
+    // to C# verifying that each exported stream was written completely.
     if (m_shouldVerify)
     {
         this->SetDescription(tr("Verifying export…"));
 
-        if (m_createManifest)
+        if (m_createOva || m_createManifest)
         {
             QString verifyError;
-            if (!writer.verifyPackage(appFolder, ovfFileName, verifyError))
+            const bool verified = m_createOva
+                ? writer.verifyOva(ovaPath, verifyError)
+                : writer.verifyPackage(appFolder, ovfFileName, verifyError);
+            if (!verified)
             {
                 this->setError(tr("Export verification failed: %1").arg(verifyError));
                 this->setState(OperationState::Failed);
@@ -289,22 +351,15 @@ void ExportApplianceAction::run()
 
             if (ok)
             {
-                for (const OvfVirtualSystemEntry& sys : envelope.systems)
+                for (const PendingDisk& disk : disks)
                 {
-                    for (const OvfDiskEntry& disk : sys.disks)
+                    const QString diskPath = appFolder + QDir::separator() + disk.href;
+                    if (!QFile::exists(diskPath) || QFileInfo(diskPath).size() == 0)
                     {
-                        if (disk.isCdrom || disk.href.isEmpty())
-                            continue;
-                        const QString diskPath = appFolder + QDir::separator() + disk.href;
-                        if (!QFile::exists(diskPath) || QFileInfo(diskPath).size() == 0)
-                        {
-                            ok = false;
-                            verifyError = tr("Exported disk file not found or empty: %1").arg(disk.href);
-                            break;
-                        }
-                    }
-                    if (!ok)
+                        ok = false;
+                        verifyError = tr("Exported disk file not found or empty: %1").arg(disk.href);
                         break;
+                    }
                 }
             }
 
@@ -326,6 +381,9 @@ void ExportApplianceAction::run()
 
 void ExportApplianceAction::cleanupOnError(const QString& appFolder)
 {
+    if (this->m_createdOvaFile)
+        QFile::remove(m_applianceDir + QDir::separator() + m_applianceName + QStringLiteral(".ova"));
+
     // Only remove the folder if we created it (don't clobber pre-existing directories).
     if (!this->m_createdAppFolder)
         return;
@@ -340,13 +398,30 @@ void ExportApplianceAction::cleanupOnError(const QString& appFolder)
     cleanup.removeRecursively();
 }
 
+// ── writeMember() ─────────────────────────────────────────────────────────────
+
+bool ExportApplianceAction::writeMember(const QString& appFolder, OvaTarWriter* tar,
+                                        const QString& name, const QByteArray& data)
+{
+    if (tar)
+    {
+        if (tar->AddMember(name, data))
+            return true;
+        qWarning() << "ExportApplianceAction:" << tar->GetLastError();
+        return false;
+    }
+
+    QFile f(appFolder + QDir::separator() + name);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return f.write(data) == data.size() && f.flush();
+}
+
 // ── buildVirtualSystem() ──────────────────────────────────────────────────────
 
-bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
-                                               const QString& appFolder,
-                                               int vmIndex,
-                                               int vmTotal,
-                                               OvfVirtualSystemEntry& sys)
+void ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
+                                               OvfVirtualSystemEntry& sys,
+                                               QList<PendingDisk>& disks)
 {
     sys.id          = vm->GetUUID();
     sys.name        = vm->GetName();
@@ -389,7 +464,7 @@ bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
         sys.networks << net;
     }
 
-    // Disks (VBDs) — download each non-CD VDI
+    // Disks (VBDs) — queue each non-CD VDI for streaming
     const QList<QSharedPointer<VBD>> vbds = vm->GetVBDs();
     const int vbdTotal = vbds.size();
     int diskIndex = 0;
@@ -401,9 +476,6 @@ bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
         if (!vbd || !vbd->IsValid())
             continue;
 
-        if (this->IsCancelled())
-            return false;
-
         OvfDiskEntry disk;
         disk.addressOnParent = vbd->GetUserdevice();
         disk.bootable        = vbd->IsBootable();
@@ -435,7 +507,8 @@ bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
 
         disk.fileId  = QStringLiteral("file%1").arg(fileIndex);
         disk.diskId  = QStringLiteral("disk%1").arg(fileIndex);
-        disk.href    = vdiUuid + QStringLiteral(".vhd");
+        disk.href    = vdiUuid + (m_compressFiles ? QStringLiteral(".vhd.gz")
+                                                 : QStringLiteral(".vhd"));
         disk.physicalBytes = physBytes;
         disk.virtualBytes  = virtBytes;
         disk.name        = diskName;
@@ -443,14 +516,12 @@ bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
         ++fileIndex;
         ++diskIndex;
 
-        const QString vhdPath = appFolder + QDir::separator() + disk.href;
-
-        // Download VHD
-        if (!this->downloadVhd(vdiUuid, virtBytes, vhdPath, diskName,
-                               vmTotal, vmIndex, vi, vbdTotal))
-        {
-            return false;
-        }
+        PendingDisk pending;
+        pending.vdiUuid     = vdiUuid;
+        pending.virtualSize = virtBytes;
+        pending.href        = disk.href;
+        pending.label       = diskName;
+        disks << pending;
 
         sys.disks << disk;
     }
@@ -498,18 +569,18 @@ bool ExportApplianceAction::buildVirtualSystem(const QSharedPointer<VM>& vm,
     const QString pvBootloaderArgs = vm->PVBootloaderArgs();
     if (!pvBootloaderArgs.isEmpty())
         sys.xenConfig << qMakePair(QStringLiteral("PV_bootloader_args"), pvBootloaderArgs);
-
-    return true;
 }
 
-// ── downloadVhd() ─────────────────────────────────────────────────────────────
+// ── streamDisk() ──────────────────────────────────────────────────────────────
 
-bool ExportApplianceAction::downloadVhd(const QString& vdiUuid,
-                                        qint64 vdiSize,
-                                        const QString& vhdPath,
-                                        const QString& diskLabel,
-                                        int vmTotal, int vmIndex,
-                                        int vbdIndex, int vbdTotal)
+bool ExportApplianceAction::streamDisk(const PendingDisk& disk,
+                                       const QString& appFolder,
+                                       OvaTarWriter* tar,
+                                       const std::function<void(qint64)>& report,
+                                       const std::function<bool()>& cancelled,
+                                       QString& sha256Hex,
+                                       QList<OvfStreamStageStats>& stats,
+                                       QString& errorOut)
 {
     const QString hostname = this->GetConnection()->GetHostname();
 
@@ -519,52 +590,98 @@ bool ExportApplianceAction::downloadVhd(const QString& vdiUuid,
     {
         taskRef = XenAPI::Task::Create(this->GetSession(),
                                        QStringLiteral("export_raw_vdi"),
-                                       QStringLiteral("Exporting VDI %1").arg(vdiUuid));
+                                       QStringLiteral("Exporting VDI %1").arg(disk.vdiUuid));
     }
     catch (const std::exception& e)
     {
-        this->setError(tr("Failed to create export task: %1").arg(QString::fromStdString(e.what())));
+        errorOut = tr("Failed to create export task: %1").arg(QString::fromStdString(e.what()));
+        return false;
+    }
+
+    // Destination: an OVA member, or a file in the appliance folder
+    const QString diskPath = appFolder + QDir::separator() + disk.href;
+    QFile file;
+    if (tar)
+    {
+        if (!tar->BeginMember(disk.href))
+        {
+            errorOut = tr("Failed to write disk %1: %2").arg(disk.label, tar->GetLastError());
+            return false;
+        }
+    } else
+    {
+        file.setFileName(diskPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            errorOut = tr("Failed to write disk %1: %2").arg(disk.label, file.errorString());
+            return false;
+        }
+    }
+
+    // Runs on the stream's writer thread; this thread does not touch the
+    // file or archive until the stream has finished.
+    OvfDiskStream stream(m_compressFiles, [&](const char* data, qint64 size, QString& error) -> bool
+    {
+        if (tar)
+        {
+            if (tar->WriteMemberData(data, size))
+                return true;
+            error = tar->GetLastError();
+            return false;
+        }
+        if (file.write(data, size) == size)
+            return true;
+        error = file.errorString();
+        return false;
+    });
+
+    if (!stream.Start())
+    {
+        errorOut = tr("Failed to export disk %1: %2").arg(disk.label, stream.errorString());
+        file.close();
+        QFile::remove(diskPath);
         return false;
     }
 
     QMap<QString, QString> params;
     params[QStringLiteral("task_id")]    = taskRef;
     params[QStringLiteral("session_id")] = this->GetSession()->GetSessionID();
-    params[QStringLiteral("vdi")]        = vdiUuid;
+    params[QStringLiteral("vdi")]        = disk.vdiUuid;
     params[QStringLiteral("format")]     = QStringLiteral("vhd");
 
     HttpClient http;
-    const bool ok = http.getFile(
+    const bool downloaded = http.getStream(
         hostname,
         QStringLiteral("/export_raw_vdi"),
         params,
-        vhdPath,
-        [&](qint64 bytes)
-        {
-            // Scale progress: VM range is 0–80%, this VBD sub-ranges within one VM's slice
-            const double vmSlice = 80.0 / vmTotal;
-            const double vbdFraction = (vbdTotal > 0 && vdiSize > 0)
-                ? (static_cast<double>(vbdIndex) + static_cast<double>(bytes) / vdiSize)
-                  / vbdTotal
-                : 0.0;
-            const int pct = static_cast<int>(vmIndex * vmSlice + vbdFraction * vmSlice);
-            this->SetPercentComplete(qBound(0, pct, 80));
-
-            const double mb = bytes / (1024.0 * 1024.0);
-            this->SetDescription(tr("Exporting disk %1 (%2 MB)…").arg(diskLabel).arg(mb, 0, 'f', 1));
-        },
-        [this]() -> bool { return this->IsCancelled(); }
+        &stream,
+        report,
+        cancelled
     );
 
+    if (!downloaded)
+        stream.Abort();
+    const bool ok = downloaded && stream.Finish();
+    file.close();
+
     if (!ok)
     {
-        QFile::remove(vhdPath);
-        if (this->IsCancelled())
+        if (!tar)
+            QFile::remove(diskPath);
+        if (cancelled())
             return false;
-        this->setError(tr("Failed to download VHD for disk %1: %2")
-                       .arg(diskLabel, http.lastError()));
+        errorOut = tr("Failed to download VHD for disk %1: %2")
+                       .arg(disk.label, downloaded ? stream.errorString() : http.lastError());
+        return false;
+    }
+
+    if (tar && !tar->EndMember())
+    {
+        errorOut = tr("Failed to write disk %1: %2").arg(disk.label, tar->GetLastError());
         return false;
     }
 
+    sha256Hex = stream.GetSha256Hex();
+    stats = stream.GetStageStats();
     return true;
 }
@@ -31,24 +31,29 @@
 #include "../../asyncoperation.h"
 #include "../../vm.h"
 #include "../../../ovf/ovfwriter.h"
+#include "../../../ovf/ovfexportstream.h"
 #include <QList>
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 
+class OvaTarWriter;
+
 /**
  * @brief Export one or more VMs as an OVF appliance folder or OVA archive.
  *
  * Qt/C++ equivalent of C# XenAdmin.Actions.OvfActions.ExportApplianceAction.
  *
- * For each selected VM:
- *   1. Builds an OVF envelope (VM metadata, hardware, networks).
- *   2. Downloads each non-CD VDI as a VHD file via XenServer's
- *      @c /export_raw_vdi HTTP endpoint.
- *   3. Merges per-VM envelopes into a single appliance envelope.
- *   4. Writes the @c .ovf descriptor file.
- *   5. Optionally creates a manifest (.mf) and/or packs the folder into
- *      a single OVA archive (.ova).
+ * Steps:
+ *   1. Builds an OVF envelope (VM metadata, hardware, networks) for every
+ *      selected VM and merges them into a single appliance envelope.
+ *   2. Writes the @c .ovf descriptor.
+ *   3. Streams each non-CD VDI from XenServer's @c /export_raw_vdi HTTP
+ *      endpoint through OvfDiskStream, which gzips (optionally), hashes and
+ *      writes it in a single pass — straight into the OVA archive when one
+ *      is requested, otherwise into the appliance folder.
+ *   4. Writes the manifest (.mf) and signature (.cert) from the digests
+ *      computed while streaming, without re-reading any disk.
  *
  * All long-running I/O runs on the action thread, not the UI thread.
  */
@@ -90,50 +95,73 @@ class ExportApplianceAction : public AsyncOperation
 
         ~ExportApplianceAction() override = default;
 
+        /**
+         * @brief Per-stage transfer counters summed over all exported disks.
+         *
+         * Valid once the action has finished; see OvfDiskStream for the stages.
+         */
+        QList<OvfStreamStageStats> GetStageStats() const { return this->m_stageStats; }
+
     protected:
         void run() override;
 
     private:
+        /// One disk to be streamed from /export_raw_vdi once all VMs are described.
+        struct PendingDisk
+        {
+            QString vdiUuid;
+            qint64  virtualSize = 0;
+            QString href;
+            QString label;
+        };
+
         /**
          * @brief Build the OvfVirtualSystemEntry for one VM.
          *
-         * Downloads VHD files for each non-CD VBD and fills in all
-         * metadata fields from the live cache.
+         * Fills in all metadata fields from the live cache and queues each
+         * non-CD VDI in @p disks. No data is transferred here, so every href
+         * is final before the descriptor is written.
          *
-         * @param vm             VM to describe.
-         * @param appFolder      Directory where VHD files will be written.
-         * @param vmIndex        0-based index within the export list (for progress).
-         * @param vmTotal        Total number of VMs (for progress).
-         * @param[out] sys       Populated entry.
-         * @return true on success, false on error or cancellation.
+         * @param vm         VM to describe.
+         * @param[out] sys   Populated entry.
+         * @param[out] disks Disks to stream, appended in References order.
          */
-        bool buildVirtualSystem(const QSharedPointer<VM>& vm,
-                                const QString& appFolder,
-                                int vmIndex,
-                                int vmTotal,
-                                OvfVirtualSystemEntry& sys);
+        void buildVirtualSystem(const QSharedPointer<VM>& vm,
+                                OvfVirtualSystemEntry& sys,
+                                QList<PendingDisk>& disks);
 
         /**
-         * @brief Download one VDI as a VHD file via /export_raw_vdi.
+         * @brief Stream one VDI from /export_raw_vdi into its package location.
          *
-         * @param vdiUuid    UUID of the VDI to export.
-         * @param vdiSize    VDI virtual_size (bytes) for progress denominator.
-         * @param vhdPath    Destination file path.
-         * @param diskLabel  Human-readable label for progress messages.
-         * @param vmTotal    Total VM count (for overall progress scaling).
-         * @param vmIndex    Current VM index (for overall progress scaling).
-         * @param vbdIndex   Current VBD index within this VM.
-         * @param vbdTotal   Total VBD count for this VM.
+         * The response is compressed (if requested), hashed and written in one
+         * pass: into an OVA member when @p tar is set, otherwise into a file
+         * in @p appFolder. Runs on a TransferBatch worker and does not touch
+         * the operation's state; several folder-package disks may stream at once.
+         *
+         * @param disk       Disk to export.
+         * @param appFolder  Destination folder (folder packages only).
+         * @param tar        OVA writer, or nullptr for folder packages.
+         * @param report     Receives bytes downloaded so far.
+         * @param cancelled  Polled to abort the transfer.
+         * @param[out] sha256Hex SHA-256 of the stored bytes, for the manifest.
+         * @param[out] stats     Per-stage pipeline counters for this disk.
+         * @param[out] errorOut  Failure reason (empty when cancelled).
          * @return true on success.
          */
-        bool downloadVhd(const QString& vdiUuid,
-                         qint64 vdiSize,
-                         const QString& vhdPath,
-                         const QString& diskLabel,
-                         int vmTotal, int vmIndex,
-                         int vbdIndex, int vbdTotal);
+        bool streamDisk(const PendingDisk& disk,
+                        const QString& appFolder,
+                        OvaTarWriter* tar,
+                        const std::function<void(qint64)>& report,
+                        const std::function<bool()>& cancelled,
+                        QString& sha256Hex,
+                        QList<OvfStreamStageStats>& stats,
+                        QString& errorOut);
+
+        /// Write a small in-memory package member (.ovf, .mf, .cert).
+        bool writeMember(const QString& appFolder, OvaTarWriter* tar,
+                         const QString& name, const QByteArray& data);
 
-        /// Remove the appliance folder on error/cancel if we created it.
+        /// Remove the appliance folder / partial OVA on error/cancel if we created it.
         void cleanupOnError(const QString& appFolder);
 
         QList<QSharedPointer<VM>> m_vms;
@@ -148,6 +176,8 @@ class ExportApplianceAction : public AsyncOperation
         bool m_compressFiles;
         bool m_shouldVerify;
         bool m_createdAppFolder = false; ///< true if run() created the appliance subfolder
+        bool m_createdOvaFile = false;   ///< true if run() created the .ova archive
+        QList<OvfStreamStageStats> m_stageStats;
 };
 
 #endif // EXPORTAPPLIANCEACTION_H
@@ -32,12 +32,19 @@
 #include "../../xenapi/vm_appliance.h"
 #include "../../session.h"
 #include "../../network/connection.h"
+#include "../../network/transferbatch.h"
 #include "../../failure.h"
+#include "../../../ovf/ovfdisksource.h"
+#include "../../../diskimage/diskimagereader.h"
+#include "../../../diskimage/sparsevhdstream.h"
+#include "../../xenapi/xenapi_VDI.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
-#include <QTemporaryDir>
+#include <QSet>
+#include <QVector>
 #include <QDebug>
+#include <memory>
 
 // ─── Local helpers ───────────────────────────────────────────────────────────
 
@@ -56,6 +63,11 @@ static QVariantMap parseSemicolonKvMap(const QString& s)
     return result;
 }
 
+static bool isGzipHref(const QString& href)
+{
+    return href.endsWith(".gz", Qt::CaseInsensitive);
+}
+
 // ─── Constructor ─────────────────────────────────────────────────────────────
 
 ImportApplianceAction::ImportApplianceAction(XenConnection* connection,
@@ -101,6 +113,128 @@ void ImportApplianceAction::onCancel()
     this->cancelRelatedTask();
 }
 
+// ─── Package file access ─────────────────────────────────────────────────────
+
+bool ImportApplianceAction::locatePackageFile(const QString& href, QString& pathOut,
+                                              qint64& offsetOut, qint64& sizeOut, QString& errorOut) const
+{
+    if (this->m_isOva)
+    {
+        const OvaMember* member = this->m_archive.FindMember(href);
+        if (!member)
+        {
+            errorOut = QString("'%1' is not present in the OVA archive").arg(href);
+            return false;
+        }
+        pathOut = this->m_sourcePath;
+        offsetOut = member->dataOffset;
+        sizeOut = member->size;
+        return true;
+    }
+
+    pathOut = QFileInfo(this->m_sourcePath).absoluteDir().filePath(href);
+    const QFileInfo fi(pathOut);
+    if (!fi.exists())
+    {
+        errorOut = QString("File not found: %1").arg(pathOut);
+        return false;
+    }
+    offsetOut = 0;
+    sizeOut = fi.size();
+    return true;
+}
+
+OvfDiskSource* ImportApplianceAction::openPackageFile(const QString& href, bool gunzip, QString& errorOut) const
+{
+    QString path;
+    qint64 offset = 0;
+    qint64 size = 0;
+    if (!this->locatePackageFile(href, path, offset, size, errorOut))
+        return nullptr;
+    return new OvfDiskSource(path, offset, size, gunzip);
+}
+
+bool ImportApplianceAction::loadManifest(QMap<QString, OvfManifestEntry>& manifestOut, QString& errorOut) const
+{
+    QByteArray content;
+    if (this->m_isOva)
+    {
+        const OvaMember* member = this->m_archive.FindMemberBySuffix(".mf");
+        if (member)
+            content = this->m_archive.ReadMember(*member);
+    } else
+    {
+        const QFileInfo ovfFi(this->m_sourcePath);
+        QFile mfFile(ovfFi.absoluteDir().filePath(ovfFi.completeBaseName() + ".mf"));
+        if (mfFile.open(QIODevice::ReadOnly))
+            content = mfFile.readAll();
+    }
+
+    if (content.isNull())
+    {
+        errorOut = "Cannot read the manifest file.";
+        return false;
+    }
+
+    const QList<OvfManifestEntry> entries = OvfPackage::ParseManifest(content);
+    if (entries.isEmpty())
+    {
+        errorOut = "The manifest file contains no entries.";
+        return false;
+    }
+    for (const OvfManifestEntry& entry : entries)
+        manifestOut.insert(entry.fileName, entry);
+    return true;
+}
+
+bool ImportApplianceAction::verifyManifestEntry(const OvfManifestEntry& entry, QString& errorOut) const
+{
+    QCryptographicHash::Algorithm algo;
+    if (!OvfPackage::DigestAlgorithmFromName(entry.algorithm, algo))
+    {
+        errorOut = QString("Unsupported digest algorithm '%1' in manifest.").arg(entry.algorithm);
+        return false;
+    }
+
+    std::unique_ptr<OvfDiskSource> source(this->openPackageFile(entry.fileName, false, errorOut));
+    if (!source)
+    {
+        errorOut = QString("Manifest references '%1' but it could not be found: %2").arg(entry.fileName, errorOut);
+        return false;
+    }
+    source->SetDigestAlgorithm(algo);
+    if (!source->open(QIODevice::ReadOnly))
+    {
+        errorOut = source->errorString();
+        return false;
+    }
+
+    QByteArray buf(OvfDiskSource::READ_CHUNK, Qt::Uninitialized);
+    while (!source->atEnd())
+    {
+        if (this->IsCancelled())
+        {
+            errorOut = "Manifest verification cancelled.";
+            return false;
+        }
+        if (source->read(buf.data(), buf.size()) < 0)
+        {
+            errorOut = source->errorString();
+            return false;
+        }
+    }
+
+    if (source->GetDigestHex().compare(entry.hexDigest, Qt::CaseInsensitive) != 0)
+    {
+        errorOut = QString("Manifest verification failed for '%1': expected %2, computed %3.")
+                       .arg(entry.fileName, entry.hexDigest, source->GetDigestHex());
+        return false;
+    }
+
+    qDebug() << "ImportApplianceAction: manifest entry" << entry.fileName << "OK";
+    return true;
+}
+
 // ─── Run ─────────────────────────────────────────────────────────────────────
 
 void ImportApplianceAction::run()
@@ -115,56 +249,31 @@ void ImportApplianceAction::run()
 
     try
     {
-        // ── Step 0: OVA extraction (if the source is a .ova TAR archive) ────
-        // The action receives the original file path. For .ova files, all disk
-        // files are inside a TAR archive that must be extracted to a temp
-        // directory before we can upload them.  The temp dir is auto-deleted
-        // when it goes out of scope at the end of run().
+        // ── Step 0: Index the OVA archive ─────────────────────────────────
+        // Disks are uploaded straight from their byte range inside the archive,
+        // so nothing is extracted to a scratch directory; indexing only reads
+        // the TAR headers.
         // C# equivalent: ImportApplianceAction.RunCore() → m_package.ExtractToWorkingDir()
-        QTemporaryDir workingDir;
-        QString effectiveOvfPath = this->m_sourcePath;
-
-        if (this->m_sourcePath.toLower().endsWith(".ova"))
+        this->m_isOva = this->m_sourcePath.toLower().endsWith(".ova");
+        if (this->m_isOva)
         {
-            if (!workingDir.isValid())
-            {
-                this->setError("Failed to create temporary directory for OVA extraction.");
-                this->setState(Failed);
-                return;
-            }
-
-            this->setDescriptionSafe("Extracting OVA archive...");
+            this->setDescriptionSafe("Reading OVA archive...");
             this->setPercentCompleteSafe(2);
             this->checkCancelled();
 
-            QString extractErr;
-            const bool ok = OvfPackage::ExtractAllToDir(
-                this->m_sourcePath,
-                workingDir.path(),
-                extractErr,
-                [this]() { return this->IsCancelled(); });
-
-            if (!ok)
+            QString indexErr;
+            if (!this->m_archive.Open(this->m_sourcePath, indexErr))
             {
-                if (this->IsCancelled())
-                    throw VmImportActionBase::CancelledException();
-                this->setError(QString("OVA extraction failed: %1").arg(extractErr));
+                this->setError(QString("Failed to read OVA archive: %1").arg(indexErr));
                 this->setState(Failed);
                 return;
             }
-
-            // Find the .ovf descriptor among the extracted files
-            QDir dir(workingDir.path());
-            const QStringList ovfFiles = dir.entryList(QStringList() << "*.ovf", QDir::Files);
-            if (ovfFiles.isEmpty())
+            if (!this->m_archive.FindMemberBySuffix(".ovf"))
             {
-                this->setError("No .ovf descriptor found in extracted OVA archive.");
+                this->setError("No .ovf descriptor found in OVA archive.");
                 this->setState(Failed);
                 return;
             }
-            effectiveOvfPath = dir.filePath(ovfFiles.first());
-            qDebug() << "ImportApplianceAction: OVA extracted to" << workingDir.path()
-                     << "OVF:" << effectiveOvfPath;
         }
 
         // ── Step 1: Parse OVF package ─────────────────────────────────────
@@ -172,7 +281,7 @@ void ImportApplianceAction::run()
         this->setPercentCompleteSafe(5);
         this->checkCancelled();
 
-        OvfPackage pkg(effectiveOvfPath);
+        OvfPackage pkg(this->m_sourcePath);
         if (!pkg.IsValid())
         {
             this->setError(QString("Failed to parse OVF package: %1").arg(pkg.ParseError()));
@@ -199,28 +308,48 @@ void ImportApplianceAction::run()
             this->setState(Failed);
             return;
         }
+        // Digests of disks that get uploaded are checked while they stream to
+        // the server (see 4b); everything else is checked here.
+        QMap<QString, OvfManifestEntry> manifest;
         if (this->m_verifyManifest)
         {
             this->setDescriptionSafe("Verifying manifest...");
             this->checkCancelled();
 
-            const QString workingDir = QFileInfo(effectiveOvfPath).absolutePath();
-            const QString baseName   = QFileInfo(effectiveOvfPath).completeBaseName();
             QString verifyErr;
-            const bool ok = OvfPackage::VerifyManifest(
-                workingDir, baseName, verifyErr,
-                [this]() { return this->IsCancelled(); });
-
-            if (this->IsCancelled())
-                throw VmImportActionBase::CancelledException();
-
-            if (!ok)
+            if (!this->loadManifest(manifest, verifyErr))
             {
                 this->setError(QString("Manifest verification failed: %1").arg(verifyErr));
                 this->setState(Failed);
                 return;
             }
-            qDebug() << "ImportApplianceAction: manifest verified OK";
+
+            QSet<QString> streamedHrefs;
+            for (const OvfVmMapping& mapping : this->m_vmMappings)
+            {
+                for (const OvfDiskMapping& dm : mapping.diskMappings)
+                {
+                    if (!dm.targetSrRef.isEmpty() || !mapping.defaultSrRef.isEmpty())
+                        streamedHrefs.insert(dm.diskHref);
+                }
+            }
+
+            for (const OvfManifestEntry& entry : manifest)
+            {
+                if (streamedHrefs.contains(entry.fileName))
+                    continue;
+
+                this->checkCancelled();
+                if (!this->verifyManifestEntry(entry, verifyErr))
+                {
+                    if (this->IsCancelled())
+                        throw VmImportActionBase::CancelledException();
+                    this->setError(QString("Manifest verification failed: %1").arg(verifyErr));
+                    this->setState(Failed);
+                    return;
+                }
+            }
+            qDebug() << "ImportApplianceAction: manifest entries outside the disk stream verified OK";
         }
         // Signature verification (certificate-based) is not yet implemented.
         if (this->m_verifySignature)
@@ -384,11 +513,25 @@ void ImportApplianceAction::run()
                 this->m_importedVmRef = vmRef;
 
             // ── 4b: Upload disks ──────────────────────────────────────────
+            // The VM's disks upload concurrently (within the TransferLimits
+            // caps) and are attached in OVF order once all of them are in.
+            struct DiskUpload
+            {
+                QString href;
+                QString srRef;
+                qint64 virtualSize = 0;
+                qint64 storedSize = 0;
+                bool bootable = false;
+                OvfManifestEntry mfEntry;
+                QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha256;
+                QString vdiRef;     // written by the upload job
+                QString digestHex;  // written by the upload job
+            };
+
+            QVector<DiskUpload> uploads;
             const int diskCount = mapping.diskMappings.size();
             for (int diskIdx = 0; diskIdx < diskCount; ++diskIdx)
             {
-                this->checkCancelled();
-
                 const OvfDiskMapping& dm = mapping.diskMappings.at(diskIdx);
 
                 // Resolve SR: per-disk mapping → default SR in mapping → pool default
@@ -401,52 +544,158 @@ void ImportApplianceAction::run()
                     continue;
                 }
 
-                // Build local disk file path.
-                // For .ovf (folder-based), disks are alongside the .ovf.
-                // For .ova, effectiveOvfPath points to the extracted .ovf in a temp dir
-                // and all disk files were extracted to that same dir.
-                QFileInfo ovfFi(effectiveOvfPath);
-                const QString diskPath = ovfFi.absoluteDir().filePath(dm.diskHref);
-                if (!QFile::exists(diskPath))
+                DiskUpload up;
+                up.href        = dm.diskHref;
+                up.srRef       = srRef;
+                up.virtualSize = hw.diskSizesByHref.value(dm.diskHref, 0);
+                up.bootable    = (diskIdx == 0);
+                up.mfEntry     = manifest.value(dm.diskHref);
+
+                QString openErr;
+                std::unique_ptr<OvfDiskSource> probe(this->openPackageFile(dm.diskHref, false, openErr));
+                if (!probe)
                 {
-                    this->setError(QString("Disk file not found: %1").arg(diskPath));
+                    this->setError(QString("Cannot read disk '%1': %2").arg(dm.diskHref, openErr));
                     this->cleanupVm(vmRef);
                     this->setState(Failed);
                     return;
                 }
+                up.storedSize = probe->StoredSize();
 
-                const int diskProgressStart = vmProgressBase + (diskIdx * (vmProgressEnd - vmProgressBase) / qMax(diskCount, 1));
-                const int diskProgressEnd   = vmProgressBase + ((diskIdx + 1) * (vmProgressEnd - vmProgressBase) / qMax(diskCount, 1));
-
-                this->setDescriptionSafe(QString("Uploading disk '%1' (%2/%3)...")
-                                         .arg(dm.diskHref).arg(diskIdx + 1).arg(diskCount));
-                this->setPercentCompleteSafe(diskProgressStart);
-
-                QString vdiRef;
-                try
+                if (!up.mfEntry.fileName.isEmpty() &&
+                    !OvfPackage::DigestAlgorithmFromName(up.mfEntry.algorithm, up.algorithm))
                 {
-                    vdiRef = this->uploadDisk(srRef, dm.diskHref, diskPath, 0,
-                                              diskProgressStart, diskProgressEnd);
+                    this->setError(QString("Unsupported digest algorithm '%1' in manifest.").arg(up.mfEntry.algorithm));
+                    this->cleanupVm(vmRef);
+                    this->setState(Failed);
+                    return;
                 }
-                catch (const VmImportActionBase::CancelledException&)
+                uploads.append(up);
+            }
+
+            auto destroyUploadedVdis = [&]() {
+                for (const DiskUpload& up : uploads)
                 {
-                    this->cleanupVm(vmRef);
-                    throw;
+                    if (!up.vdiRef.isEmpty())
+                    {
+                        try { XenAPI::VDI::destroy(session, up.vdiRef); } catch (...) {}
+                    }
                 }
-                catch (const std::exception& e)
+            };
+
+            TransferBatch batch(this->GetConnection(), this->GetConnection()->GetHostname());
+            for (int i = 0; i < uploads.size(); ++i)
+            {
+                DiskUpload* up = &uploads[i];
+                batch.AddJob(up->href, up->storedSize,
+                    [this, up](const TransferBatch::ReportFunction& report,
+                               const TransferBatch::CancelFunction& cancelled)
+                    {
+                        QString err;
+                        if (!isGzipHref(up->href))
+                        {
+                            QString path;
+                            qint64 offset = 0;
+                            qint64 size = 0;
+                            if (!this->locatePackageFile(up->href, path, offset, size, err))
+                                throw std::runtime_error(err.toStdString());
+                            std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(path, offset, size, err));
+                            if (!reader)
+                                throw std::runtime_error(err.toStdString());
+
+                            // VMDK and qcow2 disks always go through the VHD
+                            // conversion; other disks only when there is no
+                            // digest to check, so that only the blocks holding
+                            // data are read and sent.
+                            const bool mustConvert = reader->FormatName() == QLatin1String("vmdk") ||
+                                                     reader->FormatName() == QLatin1String("qcow2");
+                            if (mustConvert || up->mfEntry.fileName.isEmpty())
+                            {
+                                if (!up->mfEntry.fileName.isEmpty())
+                                {
+                                    // The converted stream no longer matches the
+                                    // stored bytes, so check those up front
+                                    if (!this->verifyManifestEntry(up->mfEntry, err))
+                                        throw std::runtime_error(err.toStdString());
+                                    up->digestHex = up->mfEntry.hexDigest;
+                                }
+
+                                SparseVhdStream stream(reader.get());
+                                if (!stream.Prepare(err, cancelled))
+                                    throw std::runtime_error(err.toStdString());
+                                stream.open(QIODevice::ReadOnly);
+                                up->vdiRef = this->transferDisk(up->srRef, up->href, &stream, stream.ContentSize(),
+                                                                qMax(up->virtualSize, stream.VirtualSize()),
+                                                                report, cancelled);
+                                return;
+                            }
+                        }
+
+                        // Open the disk where it lies: alongside the .ovf, or as a
+                        // byte range of the OVA. Compressed disks are inflated on the
+                        // fly and the stored bytes hashed for the manifest.
+                        std::unique_ptr<OvfDiskSource> source(this->openPackageFile(up->href, isGzipHref(up->href), err));
+                        if (!source)
+                            throw std::runtime_error(err.toStdString());
+                        if (!up->mfEntry.fileName.isEmpty())
+                            source->SetDigestAlgorithm(up->algorithm);
+                        if (!source->open(QIODevice::ReadOnly))
+                            throw std::runtime_error(source->errorString().toStdString());
+
+                        const qint64 contentLength = source->ContentSize(err, up->virtualSize);
+                        if (contentLength < 0)
+                            throw std::runtime_error(err.toStdString());
+
+                        up->vdiRef = this->transferDisk(up->srRef, up->href, source.get(), contentLength,
+                                                        up->virtualSize, report, cancelled);
+                        up->digestHex = source->GetDigestHex();
+                    });
+            }
+
+            this->setDescriptionSafe(QString("Uploading %1 disk(s) for '%2'...").arg(uploads.size()).arg(vmName));
+            const bool uploaded = batch.Run(
+                [this, vmName, vmProgressBase, vmProgressEnd](int pct, const QString& active)
                 {
-                    this->setError(QString("Failed to upload disk '%1': %2").arg(dm.diskHref, e.what()));
+                    this->setPercentCompleteSafe(vmProgressBase + pct * (vmProgressEnd - vmProgressBase) / 100);
+                    if (!active.isEmpty())
+                        this->setDescriptionSafe(QString("Uploading disks for '%1': %2").arg(vmName, active));
+                },
+                [this]() -> bool { return this->IsCancelled(); });
+
+            if (!uploaded)
+            {
+                destroyUploadedVdis();
+                this->cleanupVm(vmRef);
+                if (batch.WasCancelled())
+                    throw VmImportActionBase::CancelledException();
+                this->setError(QString("Failed to upload disk %1").arg(batch.GetError()));
+                this->setState(Failed);
+                return;
+            }
+
+            for (const DiskUpload& up : uploads)
+            {
+                if (!up.mfEntry.fileName.isEmpty() &&
+                    up.digestHex.compare(up.mfEntry.hexDigest, Qt::CaseInsensitive) != 0)
+                {
+                    this->setError(QString("Manifest verification failed for '%1': expected %2, computed %3.")
+                                       .arg(up.href, up.mfEntry.hexDigest, up.digestHex));
+                    destroyUploadedVdis();
                     this->cleanupVm(vmRef);
                     this->setState(Failed);
                     return;
                 }
+            }
 
-                // Attach as VBD (first disk is bootable)
+            // Attach as VBDs (first disk is bootable)
+            for (int i = 0; i < uploads.size(); ++i)
+            {
+                const DiskUpload& up = uploads.at(i);
                 try
                 {
                     this->setDescriptionSafe(QString("Attaching disk '%1' (%2/%3)...")
-                                             .arg(dm.diskHref).arg(diskIdx + 1).arg(diskCount));
-                    this->attachDisk(vmRef, vdiRef, (diskIdx == 0), "RW", "Disk");
+                                             .arg(up.href).arg(i + 1).arg(uploads.size()));
+                    this->attachDisk(vmRef, up.vdiRef, up.bootable, "RW", "Disk");
                 }
                 catch (const std::exception& e)
                 {
@@ -30,6 +30,7 @@
 
 #include "vmimportactionbase.h"
 #include "../../../xenlib_global.h"
+#include "../../../ovf/ovaarchive.h"
 #include <QString>
 #include <QStringList>
 #include <QVariantMap>
@@ -37,6 +38,8 @@
 
 class XenConnection;
 class OvfPackage;
+class OvfDiskSource;
+struct OvfManifestEntry;
 
 /**
  * @brief Per-VIF network mapping entry: OVF network name → target XenServer network OpaqueRef
@@ -136,6 +139,21 @@ class XENLIB_EXPORT ImportApplianceAction : public VmImportActionBase
         void onCancel() override;
 
     private:
+        // ── Package access ───────────────────────────────────────────────────
+
+        /// Where a package file's bytes live: the .ova itself or a file next to the .ovf
+        bool locatePackageFile(const QString& href, QString& pathOut,
+                               qint64& offsetOut, qint64& sizeOut, QString& errorOut) const;
+
+        /// Unopened reader over a package file, inside the OVA or next to the .ovf (caller owns)
+        OvfDiskSource* openPackageFile(const QString& href, bool gunzip, QString& errorOut) const;
+
+        /// Read and parse the package manifest, keyed by file name
+        bool loadManifest(QMap<QString, OvfManifestEntry>& manifestOut, QString& errorOut) const;
+
+        /// Hash one package file as stored and compare with its manifest entry
+        bool verifyManifestEntry(const OvfManifestEntry& entry, QString& errorOut) const;
+
         // ── OVF parsing helpers ──────────────────────────────────────────────
 
         /// Parse the OVF XML descriptor and return per-VirtualSystem QDomElement maps
@@ -152,6 +170,9 @@ class XENLIB_EXPORT ImportApplianceAction : public VmImportActionBase
         QString m_fixupIsoSrRef;
         bool m_startAutomatically;
 
+        bool m_isOva = false;
+        OvaArchive m_archive;
+
         // ── Results ──────────────────────────────────────────────────────────
         QString m_importedVmRef;
         QString m_applianceRef;
@@ -30,8 +30,11 @@
 #include "../../xenapi/xenapi_VTPM.h"
 #include "../../session.h"
 #include "../../network/connection.h"
+#include "../../../diskimage/diskimagereader.h"
+#include "../../../diskimage/sparsevhdstream.h"
 #include <QFileInfo>
 #include <QDebug>
+#include <memory>
 
 // ─── Constructor ─────────────────────────────────────────────────────────────
 
@@ -82,13 +85,6 @@ void ImportImageAction::run()
 
     try
     {
-        if (this->m_sourcePath.endsWith(".vmdk", Qt::CaseInsensitive))
-        {
-            this->setError("VMDK disk-image import is not supported yet. Convert the disk to VHD and import the VHD file.");
-            this->setState(Failed);
-            return;
-        }
-
         // ── Step 1: Create VM record ──────────────────────────────────────
         this->setDescriptionSafe(QString("Creating VM '%1'...").arg(this->m_vmName));
         this->setPercentCompleteSafe(5);
@@ -176,19 +172,40 @@ void ImportImageAction::run()
         this->setPercentCompleteSafe(15);
 
         // ── Step 2: Upload disk ───────────────────────────────────────────
-        this->setDescriptionSafe(QString("Uploading disk image..."));
+        this->setDescriptionSafe(QString("Preparing disk image..."));
         this->checkCancelled();
 
-        // Use provided capacity; fall back to file size for VMDK or undetected formats
-        qint64 virtualSizeBytes = this->m_diskCapacityBytes;
-        if (virtualSizeBytes <= 0)
-            virtualSizeBytes = QFileInfo(this->m_sourcePath).size();
+        // Convert on the fly to a dynamic VHD holding only the blocks that
+        // carry data; raw, VHD, VMDK and qcow2 images are all sent this way,
+        // one block in memory at a time.
+        QString imageErr;
+        std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(this->m_sourcePath, 0, -1, imageErr));
+        SparseVhdStream stream(reader.get());
+        if (reader)
+        {
+            this->setDescriptionSafe(QString("Scanning %1 disk image...").arg(reader->FormatName()));
+            if (!stream.Prepare(imageErr, [this]() { return this->IsCancelled(); }))
+                reader.reset();
+        }
+        if (!reader)
+        {
+            this->checkCancelled();
+            this->setError(QString("Failed to read disk image: %1").arg(imageErr));
+            this->cleanupVm(vmRef);
+            this->setState(Failed);
+            return;
+        }
+        stream.open(QIODevice::ReadOnly);
+
+        // Use provided capacity, but never less than the image itself
+        const qint64 virtualSizeBytes = qMax(this->m_diskCapacityBytes, stream.VirtualSize());
 
+        this->setDescriptionSafe(QString("Uploading disk image..."));
         const QString diskLabel = this->m_vmName + " disk";
         QString vdiRef;
         try
         {
-            vdiRef = this->uploadDisk(this->m_srRef, diskLabel, this->m_sourcePath,
+            vdiRef = this->uploadDisk(this->m_srRef, diskLabel, &stream, stream.ContentSize(),
                                       virtualSizeBytes, 15, 85);
         }
         catch (const std::exception& e)
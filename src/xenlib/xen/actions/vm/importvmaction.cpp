@@ -38,7 +38,6 @@
 #include "../../vm.h"
 #include <QFile>
 #include <QFileInfo>
-#include <QThread>
 #include <QDebug>
 
 const QString ImportVmAction::IMPORT_TASK = "import_task";
@@ -261,50 +260,45 @@ void ImportVmAction::run()
 
     const QString taskRef = this->importTaskRef_; // preserved before pollToCompletion destroys the task
 
-    auto findVmByTaskRef = [this, &taskRef]() -> QString
-    {
-        if (taskRef.isEmpty() || !this->GetConnection() || !this->GetConnection()->GetCache())
-            return QString();
-        const auto allObjs = this->GetConnection()->GetCache()->GetAll(XenObjectType::VM);
-        for (const auto& obj : allObjs)
-        {
-            if (auto vm = qSharedPointerDynamicCast<VM>(obj))
-            {
-                if (!vm->IsValid())
-                    continue;
-                const QVariantMap oc = vm->GetOtherConfig();
-                if (oc.value(ImportVmAction::IMPORT_TASK).toString() == taskRef)
-                    return vm->OpaqueRef();
-            }
-        }
-        return QString();
-    };
-
-    // Poll up to 10 seconds for VM to materialise in cache
-    for (int attempts = 0; attempts < 100 && !this->IsCancelled(); ++attempts)
+    XenCache* cache = this->GetConnection() ? this->GetConnection()->GetCache() : nullptr;
+    auto findVm = [this, cache, &vmRef, &taskRef](const QStringList& changed) -> bool
     {
         // Try the direct ref first
-        if (!vmRef.isEmpty() && this->GetConnection() && this->GetConnection()->GetCache())
+        if (!vmRef.isEmpty())
         {
-            QSharedPointer<VM> vm = this->GetConnection()->GetCache()->ResolveObject<VM>(XenObjectType::VM, vmRef);
+            QSharedPointer<VM> vm = cache->ResolveObject<VM>(XenObjectType::VM, vmRef);
             if (vm && vm->IsValid())
             {
                 this->vmRef_ = vmRef;
-                break;
+                return true;
             }
         }
 
-        // Fallback: scan by import_task other_config key
-        const QString foundRef = findVmByTaskRef();
-        if (!foundRef.isEmpty())
+        // Fallback: look for the import_task other_config key, on every VM the
+        // first time and afterwards only on the VMs that changed
+        if (taskRef.isEmpty())
+            return false;
+        const QStringList candidates = changed.isEmpty() ? cache->GetAllRefs(XenObjectType::VM) : changed;
+        for (const QString& ref : candidates)
         {
-            qDebug() << "ImportVmAction: found VM by import_task scan:" << foundRef;
-            this->vmRef_ = foundRef;
-            break;
+            QSharedPointer<VM> vm = cache->ResolveObject<VM>(XenObjectType::VM, ref);
+            if (!vm || !vm->IsValid())
+                continue;
+            if (vm->GetOtherConfig().value(ImportVmAction::IMPORT_TASK).toString() == taskRef)
+            {
+                qDebug() << "ImportVmAction: found VM by import_task scan:" << ref;
+                this->vmRef_ = ref;
+                return true;
+            }
         }
+        return false;
+    };
 
-        QThread::msleep(100);
-    }
+    // Wait up to 10 seconds for the VM to materialise in cache; re-checked
+    // only when a VM record changes
+    if (cache)
+        cache->WaitForChanged({ XenObjectType::VM }, QStringList(), findVm, 10 * 1000,
+                              [this]() { return this->IsCancelled(); });
 
     if (this->IsCancelled())
     {
@@ -35,8 +35,12 @@
 #include "../../session.h"
 #include "../../network/connection.h"
 #include "../../network/httpclient.h"
+#include "../../api.h"
+#include "../../../xencache.h"
+#include <QFile>
 #include <QFileInfo>
 #include <QDebug>
+#include <QThread>
 
 // ─── Constructor ─────────────────────────────────────────────────────────────
 
@@ -76,16 +80,73 @@ QString VmImportActionBase::uploadDisk(const QString& srRef,
                                        qint64 virtualSizeBytes,
                                        int progressStart,
                                        int progressEnd)
+{
+    QFile file(diskFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+        throw std::runtime_error(QString("Cannot open disk file '%1': %2")
+                                     .arg(diskFilePath, file.errorString()).toStdString());
+
+    return this->uploadDisk(srRef, diskLabel, &file, file.size(), virtualSizeBytes,
+                            progressStart, progressEnd);
+}
+
+QString VmImportActionBase::uploadDisk(const QString& srRef,
+                                       const QString& diskLabel,
+                                       QIODevice* source,
+                                       qint64 contentLength,
+                                       qint64 virtualSizeBytes,
+                                       int progressStart,
+                                       int progressEnd)
 {
     XenAPI::Session* session = this->GetSession();
+    const ImportTarget target = this->createImportTarget(srRef, diskLabel,
+                                                         virtualSizeBytes > 0 ? virtualSizeBytes : contentLength);
+    this->SetRelatedTaskRef(target.taskRef);
+
+    // Upload via HTTP PUT
+    HttpClient http(this);
+    int lastPct = progressStart;
+    const bool uploadOk = http.putStream(
+        source,
+        contentLength,
+        target.hostAddr,
+        "/import_raw_vdi",
+        target.queryParams,
+        [this, progressStart, progressEnd, &lastPct](int pct)
+        {
+            const int mapped = progressStart +
+                static_cast<int>(pct / 100.0 * (progressEnd - progressStart));
+            if (mapped != lastPct)
+            {
+                lastPct = mapped;
+                this->setPercentCompleteSafe(mapped);
+            }
+        },
+        [this]() -> bool { return this->IsCancelled(); }
+    );
 
-    // Determine virtual size from file size when not provided by caller
-    if (virtualSizeBytes <= 0)
+    this->pollToCompletion(target.taskRef, progressStart, progressEnd, false);
+    this->SetRelatedTaskRef(QString()); // clear after upload completes
+
+    if (!uploadOk)
     {
-        QFileInfo fi(diskFilePath);
-        virtualSizeBytes = fi.size();
+        const QString uploadError = http.lastError();
+        // Try to clean up the VDI on upload failure
+        try { XenAPI::VDI::destroy(session, target.vdiRef); } catch (...) {}
+        throw std::runtime_error(uploadError.toStdString());
     }
 
+    return target.vdiRef;
+}
+
+// ─── createImportTarget ──────────────────────────────────────────────────────
+
+VmImportActionBase::ImportTarget VmImportActionBase::createImportTarget(const QString& srRef,
+                                                                        const QString& diskLabel,
+                                                                        qint64 virtualSizeBytes)
+{
+    XenAPI::Session* session = this->GetSession();
+
     // Create the target VDI
     QVariantMap vdiRecord;
     vdiRecord["name_label"]       = diskLabel;
@@ -98,62 +159,110 @@ QString VmImportActionBase::uploadDisk(const QString& srRef,
     vdiRecord["read_only"]        = false;
     vdiRecord["other_config"]     = QVariantMap();
 
-    const QString vdiRef = XenAPI::VDI::create(session, vdiRecord);
-    if (vdiRef.isEmpty())
+    ImportTarget target;
+    target.vdiRef = XenAPI::VDI::create(session, vdiRecord);
+    if (target.vdiRef.isEmpty())
         throw std::runtime_error("VDI.create returned an empty reference");
-    qDebug() << "VmImportActionBase: created VDI" << vdiRef;
+    qDebug() << "VmImportActionBase: created VDI" << target.vdiRef << "for" << diskLabel;
 
-    // Determine target host address
-    QString hostAddr;
+    // Create a task to track the upload on the host we are connected to
     if (this->GetConnection())
-        hostAddr = this->GetConnection()->GetHostname();
-
-    // Create a task to track the upload
-    const QString taskRef = XenAPI::Task::Create(session,
-                                                  "import_raw_vdi_task",
-                                                  hostAddr);
-    this->SetRelatedTaskRef(taskRef);
+        target.hostAddr = this->GetConnection()->GetHostname();
+    target.taskRef = XenAPI::Task::Create(session, "import_raw_vdi_task", target.hostAddr);
 
     // Build HTTP PUT query parameters matching /import_raw_vdi endpoint
-    QMap<QString, QString> queryParams;
-    queryParams["session_id"] = session->GetSessionID();
-    queryParams["task_id"]    = taskRef;
-    queryParams["vdi"]        = vdiRef;
-    queryParams["format"]     = "vhd";
+    target.queryParams["session_id"] = session->GetSessionID();
+    target.queryParams["task_id"]    = target.taskRef;
+    target.queryParams["vdi"]        = target.vdiRef;
+    target.queryParams["format"]     = "vhd";
+    return target;
+}
 
-    // Upload via HTTP PUT
-    HttpClient http(this);
-    int lastPct = progressStart;
-    const bool uploadOk = http.putFile(
-        diskFilePath,
-        hostAddr,
-        "/import_raw_vdi",
-        queryParams,
-        [this, progressStart, progressEnd, &lastPct](int pct)
+// ─── transferDisk ────────────────────────────────────────────────────────────
+
+QString VmImportActionBase::transferDisk(const QString& srRef,
+                                         const QString& diskLabel,
+                                         QIODevice* source,
+                                         qint64 contentLength,
+                                         qint64 virtualSizeBytes,
+                                         const std::function<void(qint64, qint64)>& report,
+                                         const std::function<bool()>& cancelled)
+{
+    XenAPI::Session* session = this->GetSession();
+    const ImportTarget target = this->createImportTarget(srRef, diskLabel,
+                                                         virtualSizeBytes > 0 ? virtualSizeBytes : contentLength);
+
+    HttpClient http;
+    const bool uploadOk = http.putStream(
+        source, contentLength, target.hostAddr, "/import_raw_vdi", target.queryParams,
+        nullptr,
+        cancelled,
+        [&report, contentLength](qint64 bytes) { report(bytes, contentLength); });
+
+    // Wait for xapi to finish writing the VDI. Only this thread reads the
+    // task, so the operation's shared related-task state is left alone.
+    QString failure = uploadOk ? QString() : http.lastError();
+    XenCache* cache = this->GetConnection() ? this->GetConnection()->GetCache() : nullptr;
+    XenRpcAPI api(session);
+    bool cancelSent = false;
+    int readFailures = 0;
+    for (;;)
+    {
+        const QVariantMap record = api.GetTaskRecord(target.taskRef).toMap();
+        const QString status = record.value("status").toString();
+        if (status.isEmpty())
         {
-            const int mapped = progressStart +
-                static_cast<int>(pct / 100.0 * (progressEnd - progressStart));
-            if (mapped != lastPct)
+            // Without the task there is no telling whether xapi finished the VDI
+            if (++readFailures >= TRANSFER_TASK_READ_ATTEMPTS)
             {
-                lastPct = mapped;
-                this->setPercentCompleteSafe(mapped);
+                if (failure.isEmpty())
+                    failure = QString("Could not read the status of import task %1").arg(target.taskRef);
+                break;
             }
-        },
-        [this]() -> bool { return this->IsCancelled(); }
-    );
+        } else if (status != "pending")
+        {
+            if (status == "failure" && failure.isEmpty())
+            {
+                const QVariantList errorInfo = record.value("error_info").toList();
+                failure = errorInfo.isEmpty() ? QString("Unknown error") : errorInfo.first().toString();
+            } else if (status == "cancelled" && failure.isEmpty())
+            {
+                failure = "Operation cancelled by user";
+            }
+            break;
+        } else
+        {
+            readFailures = 0;
+            if (!cancelSent && (!uploadOk || cancelled()))
+            {
+                cancelSent = true;
+                try { XenAPI::Task::Cancel(session, target.taskRef); } catch (...) {}
+            }
+        }
 
-    this->pollToCompletion(taskRef, progressStart, progressEnd, false);
-    this->SetRelatedTaskRef(QString()); // clear after upload completes
+        // Sleep until the task's record changes in the cache (or a few
+        // seconds pass), then re-read it from the server
+        if (cache)
+        {
+            cache->WaitFor(XenObjectType::Task, target.taskRef, [cache, &target]() {
+                const QString cached = cache->ResolveObjectData(XenObjectType::Task, target.taskRef)
+                                           .value("status").toString();
+                return !cached.isEmpty() && cached != "pending";
+            }, TRANSFER_TASK_WAIT_MS, [&cancelled, cancelSent]() { return !cancelSent && cancelled(); });
+        } else
+        {
+            QThread::msleep(TRANSFER_TASK_WAIT_MS);
+        }
+    }
+    try { XenAPI::Task::Destroy(session, target.taskRef); } catch (...) {}
 
-    if (!uploadOk)
+    if (!failure.isEmpty())
     {
-        const QString uploadError = http.lastError();
-        // Try to clean up the VDI on upload failure
-        try { XenAPI::VDI::destroy(session, vdiRef); } catch (...) {}
-        throw std::runtime_error(uploadError.toStdString());
+        try { XenAPI::VDI::destroy(session, target.vdiRef); } catch (...) {}
+        throw std::runtime_error(failure.toStdString());
     }
 
-    return vdiRef;
+    return target.vdiRef;
 }
 
 // ─── attachDisk ──────────────────────────────────────────────────────────────
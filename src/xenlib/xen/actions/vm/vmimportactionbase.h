@@ -32,8 +32,10 @@
 #include "../../../xenlib_global.h"
 #include <QString>
 #include <QVariantMap>
+#include <functional>
 
 class XenConnection;
+class QIODevice;
 
 /**
  * @brief Base class providing shared XenAPI helpers for VM/appliance import operations.
@@ -58,6 +60,11 @@ class XENLIB_EXPORT VmImportActionBase : public AsyncOperation
         ~VmImportActionBase() override = default;
 
     protected:
+        // transferDisk(): longest sleep between reads of the import task, and
+        // how many reads in a row may fail before the import counts as failed
+        static const int TRANSFER_TASK_WAIT_MS = 2000;
+        static const int TRANSFER_TASK_READ_ATTEMPTS = 3;
+
         // ── Exception type used by checkCancelled() ──────────────────────────
         // Defined here so both base and subclasses catch it by name.
         struct CancelledException {};
@@ -97,6 +104,56 @@ class XENLIB_EXPORT VmImportActionBase : public AsyncOperation
                            int progressStart,
                            int progressEnd);
 
+        /**
+         * @brief Same as above, but the disk content is read from an open device.
+         * @param source         Readable device positioned at the start of the disk content
+         * @param contentLength  Exact number of bytes @p source will deliver
+         * @param virtualSizeBytes Capacity for the VDI (0 = use @p contentLength)
+         */
+        QString uploadDisk(const QString& srRef,
+                           const QString& diskLabel,
+                           QIODevice* source,
+                           qint64 contentLength,
+                           qint64 virtualSizeBytes,
+                           int progressStart,
+                           int progressEnd);
+
+        /**
+         * @brief Thread-safe variant of uploadDisk() for TransferBatch jobs.
+         *
+         * Does not touch this operation's progress, description or related
+         * task, so several disks can upload at once; progress goes to
+         * @p report in bytes and the import task is read directly, waking on
+         * its cache updates. A task that cannot be read fails the import.
+         *
+         * @return OpaqueRef of the created VDI
+         * @throws std::runtime_error on failure or cancellation
+         */
+        QString transferDisk(const QString& srRef,
+                             const QString& diskLabel,
+                             QIODevice* source,
+                             qint64 contentLength,
+                             qint64 virtualSizeBytes,
+                             const std::function<void(qint64, qint64)>& report,
+                             const std::function<bool()>& cancelled);
+
+        /**
+         * @brief VDI, import task and /import_raw_vdi parameters for one disk upload.
+         */
+        struct ImportTarget
+        {
+            QString vdiRef;
+            QString taskRef;
+            QString hostAddr;
+            QMap<QString, QString> queryParams;
+        };
+
+        /**
+         * @brief Create the VDI and the task an upload to /import_raw_vdi reports to.
+         * @throws std::runtime_error on failure
+         */
+        ImportTarget createImportTarget(const QString& srRef, const QString& diskLabel, qint64 virtualSizeBytes);
+
         /**
          * @brief Attach a VDI to a VM as a VBD.
          * @throws std::runtime_error on failure
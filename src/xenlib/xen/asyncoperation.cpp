@@ -34,6 +34,7 @@
 #include "vm.h"
 #include "sr.h"
 #include "failure.h"
+#include "network/rpctracer.h"
 #include "xenlib/operations/operationmanager.h"
 #include <QtCore/QDebug>
 #include <QtCore/QMutexLocker>
@@ -530,6 +531,7 @@ void AsyncOperation::RunAsync(bool autoDelete)
 void AsyncOperation::runOnWorkerThread()
 {
     qDebug() << "[AsyncOperation] Starting runOnWorkerThread for:" << m_title;
+    RpcTraceScope traceScope(this->traceContext());
 
     try
     {
@@ -609,6 +611,7 @@ void AsyncOperation::RunSync(XenAPI::Session* session)
     bool lockerIsLocked = false;  // Track lock state manually for Qt5 compatibility
 
     emit this->started();
+    RpcTraceScope traceScope(this->traceContext());
 
     try
     {
@@ -754,6 +757,11 @@ void AsyncOperation::clearError()
 }
 
 // Session management
+QString AsyncOperation::traceContext() const
+{
+    return QString("%1: %2").arg(QString::fromLatin1(this->metaObject()->className()), this->m_title);
+}
+
 XenAPI::Session* AsyncOperation::createSession()
 {
     if (!this->m_connection)
@@ -240,6 +240,9 @@ class XENLIB_EXPORT AsyncOperation : public QObject
         // Worker thread management
         void runOnWorkerThread();
 
+        // Label for the API calls this operation makes, see RpcTraceScope
+        QString traceContext() const;
+
         // Private data
         QString m_title;
         QString m_description;
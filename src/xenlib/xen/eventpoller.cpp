@@ -32,6 +32,8 @@
 #include "jsonrpcclient.h"
 #include "../utils/misc.h"
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QThread>
 
 using namespace XenAPI;
@@ -52,6 +54,10 @@ class EventPoller::Private
         QTimer* pollTimer;
         int consecutiveErrors;
 
+        // Classes added while running, with the token of their snapshot
+        mutable QMutex classesMutex;
+        QList<QPair<QStringList, QString>> pendingClasses;
+
         static const int POLL_TIMEOUT = 30; // 30 seconds - proper long-poll timeout (EventPoller runs on dedicated thread with own connection)
         static const int MAX_CONSECUTIVE_ERRORS = 3;
 
@@ -123,7 +129,11 @@ void EventPoller::Reset()
     }
 
     this->d->token.clear();
-    this->d->classes.clear();
+    {
+        QMutexLocker locker(&this->d->classesMutex);
+        this->d->classes.clear();
+        this->d->pendingClasses.clear();
+    }
     this->d->initialized = false;
     this->d->initialCachePopulated = false;
     this->d->consecutiveErrors = 0;
@@ -214,7 +224,11 @@ void EventPoller::Start(const QStringList& classes, const QString& initialToken)
         qDebug() << "EventPoller: QTimer created on thread" << QThread::currentThread();
     }
 
-    this->d->classes = classes;
+    {
+        QMutexLocker locker(&this->d->classesMutex);
+        this->d->classes = classes;
+        this->d->pendingClasses.clear();
+    }
     this->d->token = initialToken; // Use token from cache population instead of resetting to ""
     this->d->running = true;
     this->d->initialCachePopulated = false;
@@ -246,6 +260,55 @@ void EventPoller::Stop()
     this->d->initialCachePopulated = false;
 }
 
+void EventPoller::AddClasses(const QStringList& classes, const QString& token)
+{
+    if (classes.isEmpty())
+        return;
+
+    QMutexLocker locker(&this->d->classesMutex);
+    this->d->pendingClasses.append(qMakePair(classes, token));
+}
+
+QStringList EventPoller::Classes() const
+{
+    QMutexLocker locker(&this->d->classesMutex);
+    QStringList classes = this->d->classes;
+    for (const auto& pending : this->d->pendingClasses)
+        classes.append(pending.first);
+    return classes;
+}
+
+void EventPoller::addPendingClasses()
+{
+    QList<QPair<QStringList, QString>> pending;
+    {
+        QMutexLocker locker(&this->d->classesMutex);
+        pending.swap(this->d->pendingClasses);
+    }
+
+    for (const auto& entry : pending)
+    {
+        // Changes made after the caller's snapshot but before our current token
+        // would otherwise be missed; replaying newer state is harmless
+        if (!entry.second.isEmpty())
+        {
+            const QVariantMap result = this->d->api->EventFrom(entry.first, entry.second, 0.0);
+            if (result.isEmpty())
+                qWarning() << "EventPoller: catch-up for" << entry.first << "failed, lastError" << Xen::JsonRpcClient::lastError();
+            else
+                this->emitEvents(result.value("events").toList());
+        }
+
+        QMutexLocker locker(&this->d->classesMutex);
+        for (const QString& eventClass : entry.first)
+        {
+            if (!this->d->classes.contains(eventClass, Qt::CaseInsensitive))
+                this->d->classes.append(eventClass);
+        }
+        qDebug() << "EventPoller: now subscribed to" << this->d->classes;
+    }
+}
+
 bool EventPoller::IsRunning() const
 {
     return this->d->running;
@@ -268,8 +331,16 @@ void EventPoller::pollEvents()
         return;
     }
 
+    this->addPendingClasses();
+
+    QStringList classes;
+    {
+        QMutexLocker locker(&this->d->classesMutex);
+        classes = this->d->classes;
+    }
+
     // Call event.from with current token
-    QVariantMap result = this->d->api->EventFrom(this->d->classes, this->d->token, this->d->POLL_TIMEOUT);
+    QVariantMap result = this->d->api->EventFrom(classes, this->d->token, this->d->POLL_TIMEOUT);
 
     if (result.isEmpty())
     {
@@ -320,47 +391,7 @@ void EventPoller::pollEvents()
         //    qDebug() << "EventPoller: Received" << events.size() << "events";
         //}
 
-        foreach (const QVariant& eventVar, events)
-        {
-            if (Misc::QVariantIsMap(eventVar))
-            {
-                QVariantMap eventData = eventVar.toMap();
-
-                // Normalize JSON-RPC vs XML-RPC field naming so downstream code can use either
-                if (!eventData.contains("class") && eventData.contains("class_"))
-                    eventData.insert("class", eventData.value("class_"));
-                if (!eventData.contains("class_") && eventData.contains("class"))
-                    eventData.insert("class_", eventData.value("class"));
-                if (!eventData.contains("opaqueRef") && eventData.contains("ref"))
-                    eventData.insert("opaqueRef", eventData.value("ref"));
-                if (!eventData.contains("ref") && eventData.contains("opaqueRef"))
-                    eventData.insert("ref", eventData.value("opaqueRef"));
-
-                // Emit all events - XenLib::onEventReceived will filter invalid ones
-                emit eventReceived(eventData);
-
-                // Emit task-specific signals for TaskRehydrationManager
-                QString eventClass = eventData.value("class_", eventData.value("class")).toString();
-                QString operation = eventData.value("operation").toString();
-                QString opaqueRef = eventData.value("opaqueRef", eventData.value("ref")).toString();
-
-                if (eventClass.toLower() == "task" && !opaqueRef.isEmpty())
-                {
-                    if (operation == "add")
-                    {
-                        QVariantMap snapshot = eventData.value("snapshot").toMap();
-                        emit taskAdded(opaqueRef, snapshot);
-                    } else if (operation == "mod")
-                    {
-                        QVariantMap snapshot = eventData.value("snapshot").toMap();
-                        emit taskModified(opaqueRef, snapshot);
-                    } else if (operation == "del")
-                    {
-                        emit taskDeleted(opaqueRef);
-                    }
-                }
-            }
-        }
+        this->emitEvents(events);
 
         // Emit cache populated signal on first successful poll with events
         if (!this->d->initialCachePopulated && !events.isEmpty())
@@ -378,3 +409,48 @@ void EventPoller::pollEvents()
         QTimer::singleShot(0, this, &EventPoller::pollEvents);
     }
 }
+
+void EventPoller::emitEvents(const QVariantList& events)
+{
+    foreach (const QVariant& eventVar, events)
+    {
+        if (Misc::QVariantIsMap(eventVar))
+        {
+            QVariantMap eventData = eventVar.toMap();
+
+            // Normalize JSON-RPC vs XML-RPC field naming so downstream code can use either
+            if (!eventData.contains("class") && eventData.contains("class_"))
+                eventData.insert("class", eventData.value("class_"));
+            if (!eventData.contains("class_") && eventData.contains("class"))
+                eventData.insert("class_", eventData.value("class"));
+            if (!eventData.contains("opaqueRef") && eventData.contains("ref"))
+                eventData.insert("opaqueRef", eventData.value("ref"));
+            if (!eventData.contains("ref") && eventData.contains("opaqueRef"))
+                eventData.insert("ref", eventData.value("opaqueRef"));
+
+            // Emit all events - XenLib::onEventReceived will filter invalid ones
+            emit eventReceived(eventData);
+
+            // Emit task-specific signals for TaskRehydrationManager
+            QString eventClass = eventData.value("class_", eventData.value("class")).toString();
+            QString operation = eventData.value("operation").toString();
+            QString opaqueRef = eventData.value("opaqueRef", eventData.value("ref")).toString();
+
+            if (eventClass.toLower() == "task" && !opaqueRef.isEmpty())
+            {
+                if (operation == "add")
+                {
+                    QVariantMap snapshot = eventData.value("snapshot").toMap();
+                    emit taskAdded(opaqueRef, snapshot);
+                } else if (operation == "mod")
+                {
+                    QVariantMap snapshot = eventData.value("snapshot").toMap();
+                    emit taskModified(opaqueRef, snapshot);
+                } else if (operation == "del")
+                {
+                    emit taskDeleted(opaqueRef);
+                }
+            }
+        }
+    }
+}
@@ -95,6 +95,21 @@ class EventPoller : public QObject
          */
         void Stop();
 
+        /**
+         * @brief Add event classes to a running subscription
+         *
+         * Thread-safe; the poller thread is usually blocked in event.from, so the
+         * classes are merged in before its next call. The caller has already loaded
+         * their current state; the poller first fetches whatever changed in them
+         * since @p token (the token of that load) so nothing falls in between.
+         * @param classes Event classes to add
+         * @param token Token returned with the snapshot of @p classes
+         */
+        void AddClasses(const QStringList& classes, const QString& token);
+
+        //! Event classes currently subscribed
+        QStringList Classes() const;
+
         //! Check if poller is currently running
         bool IsRunning() const;
 
@@ -147,6 +162,9 @@ class EventPoller : public QObject
         void pollEvents();
 
     private:
+        void addPendingClasses();
+        void emitEvents(const QVariantList& events);
+
         class Private;
         Private* d;
 };
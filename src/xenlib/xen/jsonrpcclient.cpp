@@ -26,11 +26,13 @@
  */
 
 #include "jsonrpcclient.h"
+#include "network/rpctracer.h"
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 #include <QtCore/QMetaType>
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
 #include <cmath>
 #include <cstring>
 
@@ -42,6 +44,27 @@ namespace Xen
         constexpr const char* kJsonNonFiniteNegInf = "__XEN_JSON_NONFINITE_NEG_INF__";
         constexpr const char* kJsonNonFiniteNaN = "__XEN_JSON_NONFINITE_NAN__";
 
+        // Reports decoding time to RpcTracer on every way out of parseJsonRpcResponse()
+        class ParseTrace
+        {
+            public:
+                ParseTrace() : m_active(RpcTracer::IsEnabled())
+                {
+                    if (this->m_active)
+                        this->m_timer.start();
+                }
+
+                ~ParseTrace()
+                {
+                    if (this->m_active)
+                        RpcTracer::RecordParse(this->m_timer.nsecsElapsed() / 1000);
+                }
+
+            private:
+                bool m_active;
+                QElapsedTimer m_timer;
+        };
+
         bool isJsonTokenBoundary(char c)
         {
             switch (c)
@@ -215,6 +238,8 @@ namespace Xen
 
     QVariant JsonRpcClient::parseJsonRpcResponse(const QByteArray& json)
     {
+        ParseTrace trace;
+
         // Clear previous error
         s_lastError.clear();
 
@@ -59,6 +59,25 @@ namespace
     const int kSearchNextSupporterTimeoutMs = 15 * 1000;
     const int kSearchNewCoordinatorStopAfterMs = 6 * 60 * 1000;
 
+    const QStringList kOnDemandEventClasses = {
+        "pool_update", "pool_patch", "host_patch", "vgpu_type", "PCI", "certificate"
+    };
+
+    QMutex defaultEventClassesMutex;
+    QStringList defaultEventClasses = {
+        "pool", "host", "host_metrics", "host_cpu", "host_crashdump",
+        "VM", "VM_metrics", "VM_guest_metrics", "VM_appliance", "VMSS", "VMPP",
+        "SR", "VDI", "VBD", "VBD_metrics", "PBD", "SM",
+        "network", "network_sriov", "PIF", "PIF_metrics", "VIF", "VLAN", "Bond", "tunnel",
+        "GPU_group", "PGPU", "VGPU", "USB_group", "PUSB", "VUSB", "VTPM",
+        "Cluster", "Cluster_host", "Feature", "console", "blob", "task", "message"
+    };
+
+    bool containsEventClass(const QStringList& classes, const QString& eventClass)
+    {
+        return classes.contains("*") || classes.contains(eventClass, Qt::CaseInsensitive);
+    }
+
     QString valueForKeys(const QVariantMap& map, std::initializer_list<const char*> keys)
     {
         for (const char* key : keys)
@@ -122,6 +141,10 @@ class XenConnection::Private
         EventPoller* eventPoller = nullptr;
         QString eventToken;
 
+        // Subscribed event classes; grows as on-demand classes get used
+        QStringList eventClasses;
+        mutable QMutex eventClassesMutex;
+
         QQueue<QVariantMap> eventQueue;
         QMutex eventQueueMutex;
         QTimer* cacheUpdateTimer = nullptr;
@@ -151,6 +174,9 @@ XenConnection::XenConnection(QObject* parent) : QObject(parent), d(new Private)
     connect(this->d->cache, &XenCache::itemRemoved, this, [wakeCacheWaiters](XenConnection*, XenObjectType, const QString&) { wakeCacheWaiters(); });
     connect(this->d->cache, &XenCache::bulkUpdateComplete, this, [wakeCacheWaiters](XenObjectType, int) { wakeCacheWaiters(); });
     connect(this->d->cache, &XenCache::cacheCleared, this, [wakeCacheWaiters]() { wakeCacheWaiters(); });
+
+    this->d->eventClasses = XenConnection::GetDefaultEventClasses();
+    this->updateOnDemandTypes();
 }
 
 XenConnection::~XenConnection()
@@ -999,8 +1025,9 @@ void XenConnection::connectWorkerThread()
         qWarning() << "XenLib::populateCache - Failed to fetch role records:" << exn.what();
     }
 
-    qDebug() << "XenConnection: Calling event.from for initial cache population";
-    QVariantMap eventBatch = api.EventFrom(QStringList() << "*", "", 30.0);
+    const QStringList classes = this->GetEventClasses();
+    qDebug() << "XenConnection: Calling event.from for initial cache population, classes:" << classes;
+    QVariantMap eventBatch = api.EventFrom(classes, "", 30.0);
     if (eventBatch.contains("token"))
         token = eventBatch.value("token").toString();
 
@@ -1096,8 +1123,6 @@ void XenConnection::connectWorkerThread()
         connect(this->d->eventPoller, &EventPoller::taskDeleted, this, &XenConnection::TaskDeleted);
     }
 
-    const QStringList classes = { "*" };
-
     QMetaObject::invokeMethod(this->d->eventPoller, [this, session, classes, token]()
     {
         this->d->eventPoller->Reset();
@@ -1105,10 +1130,136 @@ void XenConnection::connectWorkerThread()
         this->d->eventPoller->Start(classes, token);
     }, Qt::QueuedConnection);
 
+    // Classes asked for while the initial load was running missed it
+    QStringList late;
+    for (const QString& eventClass : this->GetEventClasses())
+    {
+        if (!containsEventClass(classes, eventClass))
+            late.append(eventClass);
+    }
+    if (!late.isEmpty())
+        QMetaObject::invokeMethod(this, [this, late]() { this->loadEventClasses(late); }, Qt::QueuedConnection);
+
     emit this->ConnectionResult(true, QString());
     emit this->ConnectionStateChanged();
 }
 
+QStringList XenConnection::GetDefaultEventClasses()
+{
+    QMutexLocker locker(&defaultEventClassesMutex);
+    return defaultEventClasses;
+}
+
+void XenConnection::SetDefaultEventClasses(const QStringList& classes)
+{
+    QMutexLocker locker(&defaultEventClassesMutex);
+    defaultEventClasses = classes;
+}
+
+QStringList XenConnection::OnDemandEventClasses()
+{
+    return kOnDemandEventClasses;
+}
+
+QStringList XenConnection::GetEventClasses() const
+{
+    QMutexLocker locker(&this->d->eventClassesMutex);
+    return this->d->eventClasses;
+}
+
+void XenConnection::SetEventClasses(const QStringList& classes)
+{
+    {
+        QMutexLocker locker(&this->d->eventClassesMutex);
+        this->d->eventClasses = classes;
+    }
+    this->updateOnDemandTypes();
+}
+
+void XenConnection::SubscribeEventClasses(const QStringList& classes)
+{
+    QStringList added;
+    {
+        QMutexLocker locker(&this->d->eventClassesMutex);
+        for (const QString& eventClass : classes)
+        {
+            if (!containsEventClass(this->d->eventClasses, eventClass) && !added.contains(eventClass, Qt::CaseInsensitive))
+                added.append(eventClass);
+        }
+        this->d->eventClasses.append(added);
+    }
+
+    if (added.isEmpty())
+        return;
+
+    // Before the poller runs, connectWorkerThread() picks the new classes up itself
+    QMetaObject::invokeMethod(this, [this, added]()
+    {
+        if (this->d->cacheIsPopulated && this->d->eventPoller)
+            this->loadEventClasses(added);
+    }, Qt::QueuedConnection);
+}
+
+void XenConnection::loadEventClasses(const QStringList& classes)
+{
+    QPointer<Session> session(this->GetSession());
+    if (!session)
+        return;
+
+    qDebug() << "XenConnection: Loading event classes on demand:" << classes;
+
+    QPointer<XenConnection> self(this);
+    QThread* loadThread = QThread::create([self, session, classes]()
+    {
+        if (!session)
+            return;
+
+        XenRpcAPI api(session);
+        const QVariantMap batch = api.EventFrom(classes, "", 0.0);
+        if (batch.isEmpty())
+        {
+            qWarning() << "XenConnection: Failed to load event classes" << classes;
+            return;
+        }
+
+        const QString token = batch.value("token").toString();
+        const QVariantList events = batch.value("events").toList();
+        if (!self)
+            return;
+        QMetaObject::invokeMethod(self, [self, classes, token, events]()
+        {
+            if (!self || !self->d->eventPoller)
+                return;
+
+            // Queue the snapshot ahead of anything the poller delivers for these classes
+            for (const QVariant& event : events)
+                self->onEventPollerEventReceived(event.toMap());
+            self->d->eventPoller->AddClasses(classes, token);
+        }, Qt::QueuedConnection);
+    });
+    connect(loadThread, &QThread::finished, loadThread, &QObject::deleteLater);
+    loadThread->start();
+}
+
+void XenConnection::updateOnDemandTypes()
+{
+    if (!this->d->cache)
+        return;
+
+    const QStringList subscribed = this->GetEventClasses();
+    QList<XenObjectType> types;
+    for (const QString& eventClass : kOnDemandEventClasses)
+    {
+        if (!containsEventClass(subscribed, eventClass))
+            types.append(XenObject::TypeFromString(eventClass));
+    }
+
+    this->d->cache->SetOnDemandTypes(types, [this](XenObjectType type)
+    {
+        this->SubscribeEventClasses({ XenObject::TypeToString(type) });
+    });
+}
+
 ConnectTask* XenConnection::GetConnectTask() const
 {
     return this->d->connectTask;
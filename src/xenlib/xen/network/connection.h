@@ -188,6 +188,32 @@ class XENLIB_EXPORT XenConnection : public QObject
             return qSharedPointerDynamicCast<T>(WaitForCacheObject(type, ref, timeoutMs, cancelling));
         }
 
+        /**
+         * @brief Event classes new connections subscribe to
+         *
+         * Defaults to everything the tree and the common pages need, leaving out
+         * OnDemandEventClasses(). "*" subscribes to every class.
+         */
+        static QStringList GetDefaultEventClasses();
+        static void SetDefaultEventClasses(const QStringList& classes);
+
+        //! Rarely shown classes (updates, patches, vGPU types, PCI devices, certificates) loaded on first use
+        static QStringList OnDemandEventClasses();
+
+        //! Event classes this connection subscribes to; changes take effect on the next connect
+        QStringList GetEventClasses() const;
+        void SetEventClasses(const QStringList& classes);
+
+        /**
+         * @brief Make sure @p classes are loaded into the cache and kept up to date
+         *
+         * Thread-safe. Classes that are not subscribed yet are loaded in the
+         * background and added to the running event subscription. They stay
+         * subscribed across reconnects. The cache calls this by itself the first
+         * time it is asked for an on-demand class.
+         */
+        void SubscribeEventClasses(const QStringList& classes);
+
     signals:
         void Connected();
         void Disconnected();
@@ -236,6 +262,8 @@ class XENLIB_EXPORT XenConnection : public QObject
         void handleConnectionLostNewFlow();
         int reconnectHostTimeoutMs() const;
         QVariantMap fetchObjectRecord(const QString& cacheType, const QString& ref) const;
+        void loadEventClasses(const QStringList& classes);
+        void updateOnDemandTypes();
         void startReconnectSingleHostTimer();
         void startReconnectCoordinatorTimer(int timeoutMs);
         void reconnectSingleHostTimer();
@@ -27,15 +27,29 @@
 
 #include "connectionworker.h"
 #include "certificatemanager.h"
+#include "rpctracer.h"
+#include "wirerecorder.h"
+#include "wirereplay.h"
+#include "../../utils/httpcompression.h"
 #include <QCoreApplication>
 #include <QSslConfiguration>
 #include <QElapsedTimer>
 #include <QDebug>
 #include <QDateTime>
+#include <atomic>
+
+namespace
+{
+    const qint64 READ_CHUNK_SIZE = 256 * 1024;
+
+    std::atomic<bool> responseCompression { HttpCompression::IsAvailable() };
+    std::atomic<int> requestCompressionThreshold { 0 };
+}
 
 namespace Xen
 {
-    ConnectionWorker::ConnectionWorker(const QString& hostname, int port, QObject* parent) : QThread(parent), m_hostname(hostname), m_port(port)
+    ConnectionWorker::ConnectionWorker(const QString& hostname, int port, QObject* parent)
+        : QThread(parent), m_hostname(hostname), m_port(port), m_replay(WireReplay::GetInstalled())
     {
     }
 
@@ -52,6 +66,26 @@ namespace Xen
         }
     }
 
+    bool ConnectionWorker::IsResponseCompressionEnabled()
+    {
+        return responseCompression.load();
+    }
+
+    void ConnectionWorker::SetResponseCompressionEnabled(bool enabled)
+    {
+        responseCompression.store(enabled && HttpCompression::IsAvailable());
+    }
+
+    int ConnectionWorker::GetRequestCompressionThreshold()
+    {
+        return requestCompressionThreshold.load();
+    }
+
+    void ConnectionWorker::SetRequestCompressionThreshold(int bytes)
+    {
+        requestCompressionThreshold.store(HttpCompression::IsAvailable() ? qMax(0, bytes) : 0);
+    }
+
     void ConnectionWorker::RequestStop()
     {
         this->m_stopped.storeRelaxed(1);
@@ -70,6 +104,11 @@ namespace Xen
         request->payload = data;
         request->processed = false;
         request->emitSignal = emitSignal; // Set signal emission flag
+        if (RpcTracer::IsEnabled())
+        {
+            request->queuedUs = RpcTracer::Now();
+            request->traceContext = RpcTracer::CurrentContext();
+        }
 
         // Add to pending queue
         this->m_pendingQueue.enqueue(request);
@@ -100,6 +139,8 @@ namespace Xen
                     // Found it! Remove from completed queue and return response
                     this->m_completedQueue.removeAt(i);
                     QByteArray response = req->response;
+                    // The caller decodes the reply next, on this thread
+                    RpcTracer::SetPendingParse(req->traceId);
                     delete req;
                     return response;
                 }
@@ -165,6 +206,16 @@ namespace Xen
     {
         // qDebug() << timestamp() << "ConnectionWorker: Thread started for" << this->m_hostname;
 
+        if (this->m_replay)
+        {
+            // Recorded session: nothing to connect to, the replay answers every request
+            emit ConnectionProgress("Replaying recorded session for " + this->m_hostname + "...");
+            emit ConnectionEstablished();
+            this->eventPollLoop();
+            emit WorkerFinished();
+            return;
+        }
+
         // Create socket on this thread (important for thread affinity)
         this->m_socket = new QSslSocket();
 
@@ -326,7 +377,25 @@ namespace Xen
             // qDebug() << timestamp() << "ConnectionWorker: Processing request" << request->id;
 
             // Send request synchronously (safe on worker thread)
-            QByteArray response = this->sendRequestSync(request->payload);
+            QByteArray response;
+            if (RpcTracer::IsEnabled())
+            {
+                RpcTraceEvent trace;
+                const qint64 dequeuedUs = RpcTracer::Now();
+                trace.startUs = request->queuedUs >= 0 ? request->queuedUs : dequeuedUs;
+                trace.queueUs = dequeuedUs - trace.startUs;
+                response = this->sendRequestSync(request->payload, &trace);
+                trace.method = RpcTracer::MethodFromRequest(request->payload);
+                trace.endpoint = this->m_hostname + ":" + QString::number(this->m_port);
+                trace.context = request->traceContext;
+                trace.requestBytes = request->payload.size();
+                trace.responseBytes = response.size();
+                trace.failed = response.isEmpty();
+                request->traceId = RpcTracer::Record(trace);
+            } else
+            {
+                response = this->sendRequestSync(request->payload);
+            }
 
             // Store response and mark as processed
             locker.relock();
@@ -350,8 +419,19 @@ namespace Xen
         }
     }
 
-    QByteArray ConnectionWorker::sendRequestSync(const QByteArray& request)
+    QByteArray ConnectionWorker::sendRequestSync(const QByteArray& request, RpcTraceEvent* trace)
     {
+        QElapsedTimer timer;
+        timer.start();
+
+        if (this->m_replay)
+        {
+            const QByteArray reply = this->m_replay->Respond(request, [this]() { return this->m_stopped.loadRelaxed() != 0; });
+            if (trace)
+                trace->serverUs = timer.nsecsElapsed() / 1000;
+            return reply;
+        }
+
         // Build HTTP POST request
         QByteArray httpRequest;
 
@@ -364,14 +444,32 @@ namespace Xen
             contentType = "application/json";
         }
 
+        // Large bodies go out gzipped only when asked for; most servers reject them
+        QByteArray body = request;
+        bool compressedRequest = false;
+        const int threshold = GetRequestCompressionThreshold();
+        if (this->m_compressRequests && threshold > 0 && request.size() >= threshold)
+        {
+            const QByteArray gzipped = HttpCompression::Gzip(request);
+            if (!gzipped.isEmpty() && gzipped.size() < request.size())
+            {
+                body = gzipped;
+                compressedRequest = true;
+            }
+        }
+
         httpRequest += "POST " + endpoint.toLatin1() + " HTTP/1.1\r\n";
         httpRequest += "Host: " + this->m_hostname.toUtf8() + "\r\n";
         httpRequest += "User-Agent: XenAdminQt/1.0\r\n";
         httpRequest += "Content-Type: " + contentType.toLatin1() + "\r\n";
-        httpRequest += "Content-Length: " + QByteArray::number(request.size()) + "\r\n";
+        if (compressedRequest)
+            httpRequest += "Content-Encoding: gzip\r\n";
+        if (IsResponseCompressionEnabled())
+            httpRequest += "Accept-Encoding: " + HttpCompression::AcceptEncoding() + "\r\n";
+        httpRequest += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
         httpRequest += "Connection: keep-alive\r\n";
         httpRequest += "\r\n";
-        httpRequest += request;
+        httpRequest += body;
 
         /*QString trimmed = request;
         if (trimmed.length() > 100)
@@ -392,6 +490,7 @@ namespace Xen
             qWarning() << "ConnectionWorker: Timeout waiting for bytes written -" << this->m_socket->errorString();
             return QByteArray();
         }
+        const qint64 writtenUs = timer.nsecsElapsed() / 1000;
 
         // qDebug() << "ConnectionWorker: Request sent, waiting for response...";
 
@@ -406,6 +505,7 @@ namespace Xen
             }
             // qDebug() << "ConnectionWorker: Data available despite timeout";
         }
+        const qint64 firstByteUs = timer.nsecsElapsed() / 1000;
 
         // qDebug() << "ConnectionWorker: Response received," << this->m_socket->bytesAvailable() << "bytes available";
 
@@ -415,7 +515,15 @@ namespace Xen
 
         // Read HTTP response
         QMap<QString, QString> headers;
-        QByteArray responseBody = this->readHttpResponse(headers);
+        int statusCode = 0;
+        QByteArray responseBody = this->readHttpResponse(headers, &statusCode);
+
+        if (compressedRequest && statusCode == 415)
+        {
+            qDebug() << "ConnectionWorker: Server does not accept compressed requests, sending them plain";
+            this->m_compressRequests = false;
+            return this->sendRequestSync(request, trace);
+        }
 
         // qDebug() << "ConnectionWorker: Response body size:" << responseBody.size();
 
@@ -423,22 +531,39 @@ namespace Xen
         //         (long long)responseBody.size());
         // fflush(stderr);
 
+        const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        if (trace)
+        {
+            trace->sendUs = writtenUs;
+            trace->serverUs = firstByteUs - writtenUs;
+            trace->receiveUs = elapsedUs - firstByteUs;
+        }
+
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, this->m_hostname + ":" + QString::number(this->m_port),
+                             request, responseBody, elapsedUs);
+
         return responseBody;
     }
 
-    QByteArray ConnectionWorker::readHttpResponse(QMap<QString, QString>& headers)
+    QByteArray ConnectionWorker::readHttpResponse(QMap<QString, QString>& headers, int* statusCode)
     {
-        QByteArray responseData;
-
         /*fprintf(stderr, "[WORKER] readHttpResponse: Starting to read HTTP response\n");
         fflush(stderr);*/
 
-        // Read until we have the headers
-        while (this->m_socket->canReadLine() || this->m_socket->waitForReadyRead(5000))
+        // Status line first, e.g. "HTTP/1.1 200 OK"
+        QByteArray statusLine;
+        if (!this->readHttpLine(statusLine))
         {
-            QByteArray line = this->m_socket->readLine();
-            responseData += line;
+            qWarning() << "ConnectionWorker: Timeout reading response status";
+            return QByteArray();
+        }
+        if (statusCode)
+            *statusCode = statusLine.split(' ').value(1).toInt();
 
+        // Read until we have the headers
+        QByteArray line;
+        while (this->readHttpLine(line))
+        {
             /*fprintf(stderr, "[WORKER] readHttpResponse: Read line (%lld bytes): %s",
                     (long long)line.size(), line.left(80).constData());
             fflush(stderr);*/
@@ -459,68 +584,116 @@ namespace Xen
                 QString headerValue = QString::fromLatin1(line.mid(colonPos + 1)).trimmed();
                 // Store with lowercase key for case-insensitive lookup
                 headers[headerName.toLower()] = headerValue;
-                /*fprintf(stderr, "[WORKER] readHttpResponse: Header: %s = %s\n",
-                        headerName.toUtf8().constData(), headerValue.toUtf8().constData());
-                fflush(stderr);*/
             }
         }
 
+        // The body is decoded block by block as it comes off the socket, so a
+        // compressed reply is never held in full next to its decoded form
+        HttpContentDecoder decoder(headers.value("content-encoding").toLatin1());
+        QByteArray body;
+
         // Check for Content-Length (case-insensitive)
-        int contentLength = headers.value("content-length", "-1").toInt();
-        /*fprintf(stderr, "[WORKER] readHttpResponse: Content-Length = %d (from headers[\"content-length\"])\n", contentLength);
+        const qint64 contentLength = headers.value("content-length", "-1").toLongLong();
+        /*fprintf(stderr, "[WORKER] readHttpResponse: Content-Length = %lld\n", contentLength);
         fflush(stderr);*/
 
-        if (contentLength > 0)
+        if (headers.value("transfer-encoding").contains("chunked", Qt::CaseInsensitive))
         {
-            /*fprintf(stderr, "[WORKER] readHttpResponse: Reading %d bytes of body\n", contentLength);
-            fflush(stderr);*/
-
-            // Read exact number of bytes
-            QByteArray body;
-            while (body.size() < contentLength)
-            {
-                if (this->m_socket->bytesAvailable() > 0 || this->m_socket->waitForReadyRead(5000))
-                {
-                    QByteArray chunk = this->m_socket->read(contentLength - body.size());
-                    body += chunk;
-                    /*fprintf(stderr, "[WORKER] readHttpResponse: Read %lld bytes, total %lld/%d\n",
-                            (long long)chunk.size(), (long long)body.size(), contentLength);
-                    fflush(stderr);*/
-                } else
-                {
-                    // fprintf(stderr, "[WORKER] readHttpResponse: Timeout reading body\n");
-                    // fflush(stderr);
-                    qWarning() << "ConnectionWorker: Timeout reading response body";
-                    break;
-                }
-            }
-
-            /*fprintf(stderr, "[WORKER] readHttpResponse: Body complete, size=%lld\n",
-                    (long long)body.size());
-            fprintf(stderr, "[WORKER] readHttpResponse: Body content (first 200 chars): %s\n",
-                    body.left(200).constData());
-            fflush(stderr);*/
-
-            return body;
-        } else
+            if (!this->readChunkedBody(decoder, body))
+                qWarning() << "ConnectionWorker: Timeout reading chunked response body";
+        } else if (contentLength > 0)
+        {
+            if (!decoder.IsCompressed())
+                body.reserve(contentLength);
+            if (!this->readHttpBody(contentLength, decoder, body))
+                qWarning() << "ConnectionWorker: Timeout reading response body";
+        } else if (contentLength < 0)
         {
             // fprintf(stderr, "[WORKER] readHttpResponse: No Content-Length, reading until timeout\n");
             // fflush(stderr);
 
             // No Content-Length, read until connection closes or timeout
             // (should not happen with keep-alive)
-            QByteArray body;
             while (this->m_socket->waitForReadyRead(1000))
             {
-                body += this->m_socket->readAll();
+                const QByteArray chunk = this->m_socket->readAll();
+                decoder.Feed(chunk.constData(), chunk.size(), body);
             }
+        }
 
-            /*fprintf(stderr, "[WORKER] readHttpResponse: Body complete (no CL), size=%lld\n",
-                    (long long)body.size());
-            fflush(stderr);*/
+        if (!decoder.Finish())
+        {
+            qWarning() << "ConnectionWorker: Failed to decode" << headers.value("content-encoding")
+                       << "response body -" << decoder.GetError();
+            return QByteArray();
+        }
 
-            return body;
+        /*fprintf(stderr, "[WORKER] readHttpResponse: Body complete, size=%lld\n",
+                (long long)body.size());
+        fflush(stderr);*/
+
+        return body;
+    }
+
+    bool ConnectionWorker::readHttpLine(QByteArray& line)
+    {
+        while (!this->m_socket->canReadLine())
+        {
+            if (!this->m_socket->waitForReadyRead(5000))
+                return false;
+        }
+        line = this->m_socket->readLine();
+        return true;
+    }
+
+    bool ConnectionWorker::readHttpBody(qint64 length, HttpContentDecoder& decoder, QByteArray& body)
+    {
+        // Keep reading after a decode error so the next response starts in the right place
+        qint64 remaining = length;
+        while (remaining > 0)
+        {
+            if (this->m_socket->bytesAvailable() > 0 || this->m_socket->waitForReadyRead(5000))
+            {
+                const QByteArray chunk = this->m_socket->read(qMin(remaining, READ_CHUNK_SIZE));
+                remaining -= chunk.size();
+                decoder.Feed(chunk.constData(), chunk.size(), body);
+            } else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ConnectionWorker::readChunkedBody(HttpContentDecoder& decoder, QByteArray& body)
+    {
+        QByteArray line;
+        for (;;)
+        {
+            // Chunk size in hex, optionally followed by ";extension"
+            if (!this->readHttpLine(line))
+                return false;
+            bool ok = false;
+            const qint64 size = line.split(';').first().trimmed().toLongLong(&ok, 16);
+            if (!ok || size < 0)
+            {
+                qWarning() << "ConnectionWorker: Malformed chunk header" << line.trimmed();
+                return false;
+            }
+
+            if (size == 0)
+                break;
+            if (!this->readHttpBody(size, decoder, body) || !this->readHttpLine(line))
+                return false;
+        }
+
+        // Skip trailer fields up to the terminating empty line
+        while (this->readHttpLine(line))
+        {
+            if (line == "\r\n" || line == "\n")
+                return true;
         }
+        return false;
     }
 
 } // namespace Xen
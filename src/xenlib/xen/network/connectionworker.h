@@ -36,6 +36,11 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QQueue>
+#include <QSharedPointer>
+
+class HttpContentDecoder;
+class WireReplay;
+struct RpcTraceEvent;
 
 namespace Xen
 {
@@ -51,6 +56,9 @@ namespace Xen
         bool emitSignal = true; // Whether to emit apiResponse signal when done
                                 // Set to false for sync/blocking calls that use waitForResponse()
                                 // to avoid "Unknown request ID" warnings in async handlers
+        qint64 queuedUs = -1;   // RpcTracer clock when queued, -1 if not traced
+        QString traceContext;   // RpcTraceScope of the queuing thread
+        quint64 traceId = 0;    // RpcTracer id once processed
     };
 
     /**
@@ -71,6 +79,11 @@ namespace Xen
      *
      * All socket operations use blocking waits (waitForConnected, waitForReadyRead, etc.)
      * which is safe because this thread is dedicated to I/O and doesn't handle UI events.
+     *
+     * Calls are logged by WireRecorder while it is recording and timed by
+     * RpcTracer while it is enabled. A worker created
+     * while a WireReplay is installed never opens a socket and answers every
+     * request from the replay instead.
      */
     class ConnectionWorker : public QThread
     {
@@ -123,6 +136,26 @@ namespace Xen
              */
             QByteArray WaitForResponse(int requestId, int timeoutMs = 60000);
 
+            /**
+             * @brief Offer gzip and deflate in Accept-Encoding
+             *
+             * On by default when zlib is available. Responses are inflated as
+             * they are read, so a compressed event.from costs memory only for
+             * the decoded body. Applies to requests sent after the call.
+             */
+            static bool IsResponseCompressionEnabled();
+            static void SetResponseCompressionEnabled(bool enabled);
+
+            /**
+             * @brief Gzip request bodies of at least this many bytes
+             *
+             * 0, the default, sends every request plain. Stock xapi does not
+             * accept compressed requests; a worker that gets 415 back resends
+             * the call uncompressed and stops compressing for its lifetime.
+             */
+            static int GetRequestCompressionThreshold();
+            static void SetRequestCompressionThreshold(int bytes);
+
         signals:
             /**
              * @brief Emitted to report connection progress
@@ -227,19 +260,26 @@ namespace Xen
              * This is safe to block because it runs on the worker thread.
              *
              * @param request API request body
+             * @param trace Receives the send/server/receive split when not null
              * @return HTTP response body (API response) or empty on error
              */
-            QByteArray sendRequestSync(const QByteArray& request);
+            QByteArray sendRequestSync(const QByteArray& request, RpcTraceEvent* trace = nullptr);
 
             /**
              * @brief Read HTTP response from socket
              *
-             * Handles chunked encoding and Content-Length headers.
+             * Handles chunked encoding and Content-Length headers, and decodes
+             * gzip or deflate bodies while they are read.
              *
              * @param headers Output parameter - filled with HTTP headers
-             * @return HTTP response body
+             * @param statusCode Receives the HTTP status when not null
+             * @return HTTP response body, empty if it could not be decoded
              */
-            QByteArray readHttpResponse(QMap<QString, QString>& headers);
+            QByteArray readHttpResponse(QMap<QString, QString>& headers, int* statusCode = nullptr);
+
+            bool readHttpLine(QByteArray& line);
+            bool readHttpBody(qint64 length, HttpContentDecoder& decoder, QByteArray& body);
+            bool readChunkedBody(HttpContentDecoder& decoder, QByteArray& body);
 
             // Connection parameters
             QString m_hostname;
@@ -247,6 +287,8 @@ namespace Xen
 
             // Connection state
             QSslSocket* m_socket = nullptr;
+            QSharedPointer<WireReplay> m_replay; // Set when answering from a recording
+            bool m_compressRequests = true;      // Cleared once the server rejects a gzipped body
 
             // Thread control
             QAtomicInt m_stopped = 0; // Thread-safe stop flag
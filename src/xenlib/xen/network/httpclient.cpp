@@ -26,18 +26,39 @@
  */
 
 #include "httpclient.h"
+#include "httpconnectionpool.h"
+#include "transfercheckpoint.h"
+#include "transferlimits.h"
+#include "wirerecorder.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QUrlQuery>
 #include <QSslConfiguration>
 #include <QEventLoop>
 #include <QTimer>
-#include <QDateTime>
 #include <QElapsedTimer>
 #include <QDebug>
 #include <QNetworkProxy>
+#include <QThread>
 #include <cerrno>
 
+namespace
+{
+    // Bulk bodies stay out of recordings; the status and length are enough to
+    // line transfers up with the API calls around them
+    void recordExchange(const QUrl& url, const QStringList& headers, int statusCode, qint64 contentLength, qint64 durationUs)
+    {
+        if (!WireRecorder::IsRecording())
+            return;
+
+        QByteArray response = "HTTP/1.1 " + QByteArray::number(statusCode);
+        if (contentLength >= 0)
+            response += "\r\nContent-Length: " + QByteArray::number(contentLength);
+        WireRecorder::Record(WireExchange::Channel::Http, url.host() + ":" + QString::number(url.port()),
+                             headers.join("\r\n").toLatin1(), response, durationUs);
+    }
+}
+
 HttpClient::HttpClient(QObject* parent) : QObject(parent)
 {
 }
@@ -67,15 +88,55 @@ QUrl HttpClient::buildUri(const QString& hostname,
     return url;
 }
 
-bool HttpClient::connectToHost(const QUrl& url, QSslSocket*& socket)
+QUrl HttpClient::endpointUri(const QString& hostname,
+                             const QString& path,
+                             const QMap<QString, QString>& queryParams) const
 {
-    socket = new QSslSocket(this);
+    QUrl url = buildUri(hostname, path, queryParams);
+    if (!this->useTls_)
+        url.setScheme("http");
+    url.setPort(this->port_);
+    return url;
+}
+
+bool HttpClient::connectToHost(const QUrl& url, QSslSocket*& socket, bool* reused)
+{
+    // Only callers that can cope with a pooled connection pass @p reused
+    if (reused)
+    {
+        *reused = false;
+        if (this->keepAlive_)
+        {
+            socket = HttpConnectionPool::Acquire(HttpConnectionPool::Key(url));
+            if (socket)
+            {
+                *reused = true;
+                return true;
+            }
+        }
+    }
+
+    // No parent: kept-alive sockets outlive this client and move between threads
+    socket = new QSslSocket();
 
     // Respect app-wide proxy settings (SettingsManager::ApplyProxySettings).
     const QNetworkProxy appProxy = QNetworkProxy::applicationProxy();
     if (appProxy.type() != QNetworkProxy::NoProxy)
         socket->setProxy(appProxy);
     
+    if (!this->useTls_)
+    {
+        socket->connectToHost(url.host(), url.port(80));
+        if (!socket->waitForConnected(30000))
+        {
+            this->lastError_ = QString("Failed to connect: %1").arg(socket->errorString());
+            delete socket;
+            socket = nullptr;
+            return false;
+        }
+        return true;
+    }
+
     // Configure SSL to accept all certificates (matching C# behavior)
     QSslConfiguration sslConfig = socket->sslConfiguration();
     sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
@@ -95,6 +156,76 @@ bool HttpClient::connectToHost(const QUrl& url, QSslSocket*& socket)
     return true;
 }
 
+void HttpClient::releaseConnection(const QUrl& url, QSslSocket* socket, bool reusable)
+{
+    if (this->keepAlive_ && reusable && socket->state() == QAbstractSocket::ConnectedState)
+    {
+        HttpConnectionPool::Release(HttpConnectionPool::Key(url), socket);
+        return;
+    }
+
+    socket->disconnectFromHost();
+    if (socket->state() != QAbstractSocket::UnconnectedState)
+        socket->waitForDisconnected(5000);
+    delete socket;
+}
+
+QSslSocket* HttpClient::openRequest(const QUrl& url, QStringList headers, ResponseInfo& info)
+{
+    headers << (this->keepAlive_ ? "Connection: keep-alive" : "Connection: close");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // A pooled connection may have been closed by the server just before
+    // the request went out; that case gets one retry on a fresh connection
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        bool reused = false;
+        QSslSocket* socket = nullptr;
+        info = ResponseInfo();
+        if (!this->connectToHost(url, socket, attempt == 0 ? &reused : nullptr))
+            return nullptr;
+
+        if (!this->sendHttpHeaders(socket, headers))
+        {
+            this->lastError_ = "Failed to send HTTP headers";
+        } else if (this->readHttpResponse(socket, &info))
+        {
+            recordExchange(url, headers, info.statusCode, info.contentLength, timer.nsecsElapsed() / 1000);
+            return socket;
+        }
+
+        if (info.statusCode != 0)
+            recordExchange(url, headers, info.statusCode, info.contentLength, timer.nsecsElapsed() / 1000);
+        delete socket;
+        if (!reused || info.statusCode != 0)
+            return nullptr;
+
+        qDebug() << "HttpClient: pooled connection to" << url.host() << "was closed, reconnecting";
+    }
+    return nullptr;
+}
+
+bool HttpClient::drainResponseBody(QSslSocket* socket, const ResponseInfo& info)
+{
+    // Only small, length-delimited bodies are worth reading to keep the connection
+    if (info.chunked || info.contentLength < 0 || info.contentLength > MAX_DRAIN_BYTES)
+        return false;
+
+    qint64 remaining = info.contentLength;
+    while (remaining > 0)
+    {
+        if (socket->bytesAvailable() <= 0 && !socket->waitForReadyRead(5000))
+            return false;
+        const QByteArray data = socket->read(remaining);
+        if (data.isEmpty())
+            return false;
+        remaining -= data.size();
+    }
+    return true;
+}
+
 bool HttpClient::sendHttpHeaders(QSslSocket* socket, const QStringList& headers)
 {
     for (const QString& header : headers)
@@ -127,7 +258,7 @@ bool HttpClient::sendHttpHeaders(QSslSocket* socket, const QStringList& headers)
     return true;
 }
 
-bool HttpClient::readHttpResponse(QSslSocket* socket)
+bool HttpClient::readHttpResponse(QSslSocket* socket, ResponseInfo* info)
 {
     // Wait for response
     if (!socket->waitForReadyRead(HTTP_TIMEOUT_MS))
@@ -142,6 +273,9 @@ bool HttpClient::readHttpResponse(QSslSocket* socket)
     
     qDebug() << "HTTP response:" << statusStr;
     
+    ResponseInfo parsed;
+    QByteArray connectionHeader;
+
     // Read headers
     while (socket->canReadLine() || socket->waitForReadyRead(5000))
     {
@@ -149,6 +283,40 @@ bool HttpClient::readHttpResponse(QSslSocket* socket)
         if (line.trimmed().isEmpty())
             break;
         qDebug() << "  Header:" << QString::fromLatin1(line).trimmed();
+
+        const int colon = line.indexOf(':');
+        if (colon <= 0)
+            continue;
+
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length")
+        {
+            bool ok = false;
+            const qint64 length = value.toLongLong(&ok);
+            if (ok)
+                parsed.contentLength = length;
+        } else if (name == "connection")
+        {
+            connectionHeader = value.toLower();
+        } else if (name == "transfer-encoding")
+        {
+            parsed.chunked = value.toLower().contains("chunked");
+        } else if (name == "content-range")
+        {
+            // "bytes <first>-<last>/<total>", total may be "*"
+            const QByteArray spec = value.mid(value.indexOf(' ') + 1);
+            const int dash = spec.indexOf('-');
+            const int slash = spec.indexOf('/');
+            if (dash > 0 && slash > dash)
+            {
+                parsed.rangeStart = spec.left(dash).toLongLong();
+                bool ok = false;
+                const qint64 total = spec.mid(slash + 1).toLongLong(&ok);
+                if (ok)
+                    parsed.totalLength = total;
+            }
+        }
     }
 
     // Parse status code
@@ -160,7 +328,17 @@ bool HttpClient::readHttpResponse(QSslSocket* socket)
     }
 
     int statusCode = parts[1].toInt();
-    if (statusCode != 200)
+    parsed.statusCode = statusCode;
+    // HTTP/1.1 keeps the connection unless told otherwise, HTTP/1.0 only when asked
+    parsed.keepAlive = parts[0] == "HTTP/1.1" ? !connectionHeader.contains("close")
+                                              : connectionHeader.contains("keep-alive");
+    if (statusCode == 200)
+        parsed.totalLength = parsed.contentLength;
+    if (info)
+        *info = parsed;
+
+    // 206 is only expected by callers that sent a Range header and asked for the details
+    if (statusCode != 200 && !(statusCode == 206 && info))
     {
         this->lastError_ = QString("HTTP error %1: %2").arg(statusCode).arg(statusStr);
         return false;
@@ -225,13 +403,23 @@ qint64 HttpClient::copyStream(QIODevice* source, QIODevice* dest,
                               qint64 totalSize,
                               ProgressCallback progressCallback,
                               DataCopiedCallback dataCopiedCallback,
-                              CancelCallback cancelCallback)
+                              CancelCallback cancelCallback,
+                              const ResponseInfo* response,
+                              bool* bodyComplete)
 {
-    qint64 bytesTransferred = 0;
-    QByteArray buffer(BUFFER_SIZE, Qt::Uninitialized);
-    QDateTime lastUpdate = QDateTime::currentDateTime();
+    QAbstractSocket* sourceSocket = qobject_cast<QAbstractSocket*>(source);
     QAbstractSocket* destSocket = qobject_cast<QAbstractSocket*>(dest);
 
+    // Progress is reported from the write side, so it counts bytes that have
+    // actually reached the destination. Callbacks may therefore run on the
+    // pipeline's worker thread when the destination is not a socket.
+    qint64 bytesTransferred = 0;
+    QElapsedTimer lastUpdate;
+    lastUpdate.start();
+
+    this->lastCopyWritten_ = 0;
+    this->writeFailed_ = false;
+
     auto reportProgress = [&]() {
         if (progressCallback && totalSize > 0)
         {
@@ -243,18 +431,25 @@ qint64 HttpClient::copyStream(QIODevice* source, QIODevice* dest,
             dataCopiedCallback(bytesTransferred);
     };
 
-    auto writeBytes = [&](qint64 bytesRead) -> bool {
+    const QString cancelledMessage = QStringLiteral("Operation cancelled by user");
+
+    auto writeBytes = [&](const char* data, qint64 size, QString& error) -> bool {
+        if (!TransferLimits::Throttle(size, cancelCallback))
+        {
+            error = cancelledMessage;
+            return false;
+        }
+
         qint64 offset = 0;
-        while (offset < bytesRead)
+        while (offset < size)
         {
             if (cancelCallback && cancelCallback())
             {
-                this->lastError_ = "Operation cancelled by user";
+                error = cancelledMessage;
                 return false;
             }
 
-            const qint64 bytesWritten = dest->write(buffer.constData() + offset,
-                                                    bytesRead - offset);
+            const qint64 bytesWritten = dest->write(data + offset, size - offset);
             if (bytesWritten < 0)
             {
                 // Detect disk-full on POSIX systems (mirrors C# ERROR_DISK_FULL check)
@@ -262,23 +457,23 @@ qint64 HttpClient::copyStream(QIODevice* source, QIODevice* dest,
                 if (errno == ENOSPC)
                 {
                     this->isDiskFull_ = true;
-                    this->lastError_ = "The target disk is full.";
+                    this->writeFailed_ = true;
+                    error = "The target disk is full.";
                     return false;
                 }
 #endif
                 // Generic write error — include the destination error where available
-                QFile* destFile = qobject_cast<QFile*>(dest);
-                this->lastError_ = destFile
-                    ? QString("Failed to write data: %1").arg(destFile->errorString())
-                    : destSocket
-                        ? QString("Failed to write data: %1").arg(destSocket->errorString())
-                        : QString("Failed to write data");
+                this->writeFailed_ = true;
+                error = dest->errorString().isEmpty()
+                    ? QString("Failed to write data")
+                    : QString("Failed to write data: %1").arg(dest->errorString());
                 return false;
             }
 
             if (bytesWritten == 0)
             {
-                this->lastError_ = destSocket
+                this->writeFailed_ = true;
+                error = destSocket
                     ? QString("Socket accepted no data: %1").arg(destSocket->errorString())
                     : QString("Destination accepted no data");
                 return false;
@@ -286,93 +481,228 @@ qint64 HttpClient::copyStream(QIODevice* source, QIODevice* dest,
 
             offset += bytesWritten;
             bytesTransferred += bytesWritten;
+            this->lastCopyWritten_ = bytesTransferred;
 
+            // The socket side always runs on this thread, so lastError_ is safe here
             if (destSocket &&
                 destSocket->bytesToWrite() >= WRITE_HIGH_WATER_MARK &&
                 !this->waitForWriteBuffer(destSocket,
                                           WRITE_LOW_WATER_MARK,
                                           cancelCallback))
             {
+                error = this->lastError_;
                 return false;
             }
 
             // Update progress every 500ms
-            QDateTime now = QDateTime::currentDateTime();
-            if (lastUpdate.msecsTo(now) > 500)
+            if (lastUpdate.elapsed() > 500)
             {
                 reportProgress();
-                lastUpdate = now;
+                lastUpdate.restart();
             }
         }
 
         return true;
     };
 
-    QAbstractSocket* sourceSocket = qobject_cast<QAbstractSocket*>(source);
-    if (sourceSocket)
-    {
-        while (sourceSocket->state() == QAbstractSocket::ConnectedState ||
-               sourceSocket->bytesAvailable() > 0)
+    CopyPipeline* pipeline = nullptr;
+
+    // Waits until @p ready holds. Returns 1 when it does, 0 if the peer
+    // closed first, -1 on error, cancellation or a failed writer.
+    auto waitReadable = [&](const std::function<bool()>& ready, QString& error) -> int {
+        QElapsedTimer idle;
+        idle.start();
+        while (!ready())
         {
-            // Check for cancellation
             if (cancelCallback && cancelCallback())
             {
-                this->lastError_ = "Operation cancelled by user";
+                error = cancelledMessage;
                 return -1;
             }
 
-            if (sourceSocket->bytesAvailable() <= 0)
+            // The writer failed; its error is the one reported
+            if (pipeline->IsAborted())
+                return -1;
+
+            if (sourceSocket->state() != QAbstractSocket::ConnectedState)
+                return 0;
+
+            // Short slices so cancellation and writer failures are noticed
+            if (sourceSocket->waitForReadyRead(READ_WAIT_SLICE_MS) || ready())
+                continue;
+
+            if (sourceSocket->state() == QAbstractSocket::UnconnectedState ||
+                sourceSocket->error() == QAbstractSocket::RemoteHostClosedError)
             {
-                if (!sourceSocket->waitForReadyRead(HTTP_TIMEOUT_MS))
-                {
-                    if (sourceSocket->bytesAvailable() > 0)
-                        continue;
+                return 0;
+            }
+
+            if (idle.elapsed() >= HTTP_TIMEOUT_MS)
+            {
+                error = QString("Timeout waiting for data: %1").arg(sourceSocket->errorString());
+                return -1;
+            }
+        }
+        return 1;
+    };
+
+    auto hasData = [&]() { return sourceSocket->bytesAvailable() > 0; };
+    auto hasLine = [&]() { return sourceSocket->canReadLine(); };
+
+    // Body framing: Content-Length, chunked, or (neither) until the peer closes
+    const bool chunked = response && response->chunked;
+    qint64 remaining = response && !chunked ? response->contentLength : -1;
+    qint64 chunkLeft = 0;
+    bool chunkNeedsCrlf = false;
+    if (bodyComplete)
+        *bodyComplete = false;
+
+    auto readChunkHeader = [&](QString& error) -> qint64 {
+        if (chunkNeedsCrlf)
+        {
+            if (waitReadable(hasLine, error) <= 0)
+                return -1;
+            sourceSocket->readLine();
+            chunkNeedsCrlf = false;
+        }
 
-                    if (sourceSocket->state() == QAbstractSocket::UnconnectedState ||
-                        sourceSocket->error() == QAbstractSocket::RemoteHostClosedError)
-                    {
-                        break;
-                    }
+        if (waitReadable(hasLine, error) <= 0)
+            return -1;
+
+        bool ok = false;
+        const QByteArray line = sourceSocket->readLine().trimmed();
+        const qint64 size = line.left(line.indexOf(';') < 0 ? line.size() : line.indexOf(';')).toLongLong(&ok, 16);
+        if (!ok || size < 0)
+        {
+            error = QString("Invalid chunk header: %1").arg(QString::fromLatin1(line));
+            return -1;
+        }
 
-                    this->lastError_ = QString("Timeout waiting for data: %1").arg(sourceSocket->errorString());
+        if (size == 0)
+        {
+            // Skip trailers up to the blank line that ends the message
+            for (;;)
+            {
+                if (waitReadable(hasLine, error) <= 0)
                     return -1;
-                }
+                if (sourceSocket->readLine().trimmed().isEmpty())
+                    break;
             }
+        }
+        return size;
+    };
 
-            while (sourceSocket->bytesAvailable() > 0)
+    auto readSocket = [&](char* data, qint64 maxSize, QString& error) -> qint64 {
+        if (chunked)
+        {
+            if (bodyComplete && *bodyComplete)
+                return 0;
+
+            if (chunkLeft == 0)
             {
-                qint64 bytesRead = sourceSocket->read(buffer.data(), buffer.size());
-                if (bytesRead < 0)
+                chunkLeft = readChunkHeader(error);
+                if (chunkLeft < 0)
                 {
-                    this->lastError_ = QString("Failed to read data: %1").arg(sourceSocket->errorString());
+                    if (error.isEmpty() && !pipeline->IsAborted())
+                        error = QStringLiteral("Connection closed inside chunked body");
                     return -1;
                 }
-
-                if (bytesRead == 0)
-                    break;
-
-                if (!writeBytes(bytesRead))
-                    return -1;
+                if (chunkLeft == 0)
+                {
+                    if (bodyComplete)
+                        *bodyComplete = true;
+                    return 0;
+                }
             }
+            maxSize = qMin(maxSize, chunkLeft);
+        } else if (remaining == 0)
+        {
+            if (bodyComplete)
+                *bodyComplete = true;
+            return 0;
+        } else if (remaining > 0)
+        {
+            maxSize = qMin(maxSize, remaining);
         }
-    } else
-    {
-        while (!source->atEnd())
+
+        const int ready = waitReadable(hasData, error);
+        if (ready < 0)
+            return -1;
+        if (ready == 0)
         {
-            // Check for cancellation
-            if (cancelCallback && cancelCallback())
+            if (chunked)
             {
-                this->lastError_ = "Operation cancelled by user";
+                error = QStringLiteral("Connection closed inside chunked body");
                 return -1;
             }
+            return 0;
+        }
 
-            qint64 bytesRead = source->read(buffer.data(), buffer.size());
-            if (bytesRead <= 0)
-                break;
+        const qint64 bytesRead = sourceSocket->read(data, maxSize);
+        if (bytesRead < 0)
+        {
+            error = QString("Failed to read data: %1").arg(sourceSocket->errorString());
+            return -1;
+        }
 
-            if (!writeBytes(bytesRead))
-                return -1;
+        if (chunked)
+        {
+            chunkLeft -= bytesRead;
+            chunkNeedsCrlf = chunkLeft == 0;
+        } else if (remaining > 0)
+        {
+            remaining -= bytesRead;
+        }
+        return bytesRead;
+    };
+
+    auto readDevice = [&](char* data, qint64 maxSize, QString& error) -> qint64 {
+        if (cancelCallback && cancelCallback())
+        {
+            error = cancelledMessage;
+            return -1;
         }
+
+        if (source->atEnd())
+            return 0;
+
+        const qint64 bytesRead = source->read(data, maxSize);
+        if (bytesRead < 0)
+            error = QString("Failed to read data: %1").arg(source->errorString());
+        return bytesRead;
+    };
+
+    CopyPipeline copy(sourceSocket ? CopyPipeline::ReadFunction(readSocket)
+                                   : CopyPipeline::ReadFunction(readDevice),
+                      writeBytes);
+    pipeline = &copy;
+
+    // Sockets stay on this thread; the file or device side gets the worker
+    CopyPipeline::Worker worker = CopyPipeline::Worker::Reader;
+    if (sourceSocket && destSocket)
+        worker = CopyPipeline::Worker::None;
+    else if (sourceSocket)
+        worker = CopyPipeline::Worker::Writer;
+
+    const bool ok = copy.Run(worker);
+
+    CopyPipeline::StageStats readStats = copy.GetReadStats();
+    CopyPipeline::StageStats writeStats = copy.GetWriteStats();
+    readStats.stage = sourceSocket ? QStringLiteral("network receive") : QStringLiteral("source read");
+    writeStats.stage = destSocket ? QStringLiteral("network send") : QStringLiteral("destination write");
+    this->lastCopyStats_ = { readStats, writeStats };
+
+    qDebug().noquote() << QString("HttpClient: copied %1 MiB in %2 s, peak buffer %3 KiB")
+                              .arg(writeStats.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                              .arg(copy.GetElapsedNs() / 1e9, 0, 'f', 2)
+                              .arg(copy.GetPeakBufferSize() / 1024);
+    qDebug().noquote() << "  " + readStats.ToString();
+    qDebug().noquote() << "  " + writeStats.ToString();
+
+    if (!ok)
+    {
+        this->lastError_ = copy.GetError();
+        return -1;
     }
 
     // Final progress update
@@ -397,71 +727,113 @@ bool HttpClient::putFile(const QString& localFilePath,
         return false;
     }
 
-    qint64 fileSize = file.size();
-    QUrl url = buildUri(hostname, remotePath, queryParams);
+    const bool ok = this->putStream(&file, file.size(), hostname, remotePath, queryParams,
+                                    progressCallback, cancelCallback);
+    file.close();
+    return ok;
+}
 
-    qDebug() << "HTTP PUT:" << url.toString();
-    qDebug() << "File size:" << fileSize << "bytes";
+bool HttpClient::putStream(QIODevice* source,
+                           qint64 contentLength,
+                           const QString& hostname,
+                           const QString& remotePath,
+                           const QMap<QString, QString>& queryParams,
+                           ProgressCallback progressCallback,
+                           CancelCallback cancelCallback,
+                           DataCopiedCallback dataCopiedCallback)
+{
+    QUrl url = this->endpointUri(hostname, remotePath, queryParams);
 
-    // Connect to server
-    QSslSocket* socket = nullptr;
-    if (!this->connectToHost(url, socket))
-    {
-        emit this->error(this->lastError_);
-        file.close();
-        return false;
-    }
+    qDebug() << "HTTP PUT:" << url.toString();
+    qDebug() << "Content length:" << contentLength << "bytes";
 
     // Send HTTP PUT headers
     QStringList headers;
     headers << QString("PUT %1 HTTP/1.1").arg(url.path() + "?" + url.query());
     headers << QString("Host: %1").arg(url.host());
-    headers << QString("Content-Length: %1").arg(fileSize);
-    headers << "Connection: close";
+    headers << QString("Content-Length: %1").arg(contentLength);
+    headers << (this->keepAlive_ ? "Connection: keep-alive" : "Connection: close");
 
-    if (!this->sendHttpHeaders(socket, headers))
+    // A body can only be replayed after a stale pooled connection if the
+    // source can be rewound
+    const qint64 sourceStart = source->isSequential() ? -1 : source->pos();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int attempt = 0; ; ++attempt)
     {
-        this->lastError_ = "Failed to send HTTP headers";
-        emit this->error(this->lastError_);
-        delete socket;
-        file.close();
-        return false;
-    }
+        // Connect to server
+        bool reused = false;
+        QSslSocket* socket = nullptr;
+        const bool mayReuse = attempt == 0 && sourceStart >= 0;
+        if (!this->connectToHost(url, socket, mayReuse ? &reused : nullptr))
+        {
+            emit this->error(this->lastError_);
+            return false;
+        }
 
-    // Upload file content
-    qint64 bytesTransferred = this->copyStream(&file, socket, fileSize,
-                                               progressCallback, nullptr, cancelCallback);
-    
-    file.close();
+        bool sent = this->sendHttpHeaders(socket, headers);
+        if (!sent)
+            this->lastError_ = "Failed to send HTTP headers";
 
-    if (bytesTransferred < 0)
-    {
-        emit this->error(this->lastError_);
-        delete socket;
-        return false;
-    }
+        // Upload content
+        qint64 bytesTransferred = -1;
+        if (sent)
+        {
+            bytesTransferred = this->copyStream(source, socket, contentLength,
+                                                progressCallback, dataCopiedCallback, cancelCallback);
+        }
 
-    socket->flush();
-    if (!this->waitForWriteBuffer(socket, 0, cancelCallback))
-    {
-        emit this->error(this->lastError_);
-        delete socket;
-        return false;
-    }
+        if (bytesTransferred >= 0 && bytesTransferred != contentLength)
+        {
+            // The server is waiting for the rest of the declared body and would
+            // otherwise sit on the request until it times out
+            this->lastError_ = QString("Upload source ended after %1 of %2 bytes%3")
+                                   .arg(bytesTransferred)
+                                   .arg(contentLength)
+                                   .arg(source->errorString().isEmpty()
+                                            ? QString()
+                                            : QString(": %1").arg(source->errorString()));
+            delete socket;
+            emit this->error(this->lastError_);
+            return false;
+        }
 
-    // Read response
-    bool success = this->readHttpResponse(socket);
-    
-    socket->disconnectFromHost();
-    if (socket->state() != QAbstractSocket::UnconnectedState)
-        socket->waitForDisconnected(5000);
-    
-    delete socket;
+        bool success = false;
+        ResponseInfo info;
+        if (bytesTransferred >= 0)
+        {
+            socket->flush();
+            if (this->waitForWriteBuffer(socket, 0, cancelCallback))
+                success = this->readHttpResponse(socket, &info);
+            if (info.statusCode != 0)
+                recordExchange(url, headers, info.statusCode, info.contentLength, timer.nsecsElapsed() / 1000);
+        }
 
-    if (!success)
-        emit this->error(this->lastError_);
+        const bool cancelled = cancelCallback && cancelCallback();
+        if (!success && reused && info.statusCode == 0 && !cancelled && source->seek(sourceStart))
+        {
+            qDebug() << "HttpClient: pooled connection to" << url.host() << "was closed, re-sending upload";
+            delete socket;
+            continue;
+        }
+
+        if (success && info.statusCode != 200)
+        {
+            this->lastError_ = QString("HTTP error %1").arg(info.statusCode);
+            success = false;
+        }
+
+        if (!success)
+        {
+            delete socket;
+            emit this->error(this->lastError_);
+            return false;
+        }
 
-    return success;
+        this->releaseConnection(url, socket, info.keepAlive && this->drainResponseBody(socket, info));
+        return true;
+    }
 }
 
 bool HttpClient::getFile(const QString& hostname,
@@ -472,65 +844,92 @@ bool HttpClient::getFile(const QString& hostname,
                          CancelCallback cancelCallback)
 {
     this->isDiskFull_ = false;   // Reset per-call flag before each download
-    QUrl url = buildUri(hostname, remotePath, queryParams);
 
-    qDebug() << "HTTP GET:" << url.toString();
+    QString tmpFile = localFilePath + ".tmp";
+    TransferCheckpoint checkpoint(tmpFile, TransferCheckpoint::Identity(hostname, remotePath, queryParams));
 
-    // Connect to server
-    QSslSocket* socket = nullptr;
-    if (!this->connectToHost(url, socket))
+    // Pick up a partial download left behind by an earlier call
+    qint64 position = checkpoint.Load();
+    qint64 totalSize = checkpoint.TotalSize();
+
+    QFile file(tmpFile);
+    const QIODevice::OpenMode mode = position > 0
+        ? QIODevice::ReadWrite
+        : QIODevice::WriteOnly | QIODevice::Truncate;
+    if (!file.open(mode) || !file.seek(position))
     {
+        this->lastError_ = QString("Failed to create file: %1").arg(file.errorString());
         emit this->error(this->lastError_);
         return false;
     }
 
-    // Send HTTP GET headers
-    QStringList headers;
-    headers << QString("GET %1 HTTP/1.1").arg(url.path() + "?" + url.query());
-    headers << QString("Host: %1").arg(url.host());
-    headers << "Connection: close";
+    if (position > 0)
+        qDebug() << "HttpClient: resuming" << tmpFile << "at offset" << position;
 
-    if (!this->sendHttpHeaders(socket, headers))
-    {
-        this->lastError_ = "Failed to send HTTP headers";
-        emit this->error(this->lastError_);
-        delete socket;
-        return false;
-    }
+    QUrl url = this->endpointUri(hostname, remotePath, queryParams);
+    qDebug() << "HTTP GET:" << url.toString();
+
+    qint64 lastCheckpoint = position;
+    auto copied = [&](qint64 absolute) {
+        if (dataCopiedCallback)
+            dataCopiedCallback(absolute);
+
+        if (totalSize > 0 && absolute - lastCheckpoint >= CHECKPOINT_INTERVAL)
+        {
+            file.flush();
+            if (checkpoint.Save(absolute, totalSize))
+                lastCheckpoint = absolute;
+        }
+    };
 
-    // Read response headers
-    if (!this->readHttpResponse(socket))
+    RangeResult result = RangeResult::Failed;
+    for (int attempt = 1; attempt <= MAX_RESUME_ATTEMPTS; ++attempt)
     {
-        emit this->error(this->lastError_);
-        delete socket;
-        return false;
+        result = this->fetchRange(url, &file, true, position, totalSize, copied, cancelCallback);
+        if (result != RangeResult::Dropped)
+            break;
+
+        // Nothing to resume against when the server never said how big the body is
+        if (totalSize <= 0)
+        {
+            result = RangeResult::Failed;
+            break;
+        }
+
+        file.flush();
+        if (checkpoint.Save(position, totalSize))
+            lastCheckpoint = position;
+
+        if (attempt == MAX_RESUME_ATTEMPTS)
+            break;
+
+        qWarning() << "HttpClient: download interrupted at" << position << "of" << totalSize
+                   << "(" << this->lastError_ << "), resuming, attempt" << attempt + 1;
+        QThread::msleep(RESUME_DELAY_MS);
+
+        if (cancelCallback && cancelCallback())
+        {
+            this->lastError_ = "Operation cancelled by user";
+            result = RangeResult::Failed;
+            break;
+        }
     }
 
-    // Create temporary file
-    QString tmpFile = localFilePath + ".tmp";
-    QFile file(tmpFile);
-    if (!file.open(QIODevice::WriteOnly))
+    file.flush();
+    file.close();
+
+    if (result == RangeResult::Dropped)
     {
-        this->lastError_ = QString("Failed to create file: %1").arg(file.errorString());
+        // Keep the partial file and its checkpoint for the next attempt
+        qWarning() << "HttpClient: giving up on" << tmpFile << "at offset" << position
+                   << "after" << MAX_RESUME_ATTEMPTS << "attempts";
         emit this->error(this->lastError_);
-        delete socket;
         return false;
     }
 
-    // Download file content
-    qint64 bytesTransferred = this->copyStream(socket, &file, 0,
-                                               nullptr, dataCopiedCallback, cancelCallback);
-    
-    file.flush();
-    file.close();
-
-    socket->disconnectFromHost();
-    if (socket->state() != QAbstractSocket::UnconnectedState)
-        socket->waitForDisconnected(5000);
-    
-    delete socket;
+    checkpoint.Remove();
 
-    if (bytesTransferred < 0)
+    if (result != RangeResult::Complete)
     {
         QFile::remove(tmpFile);
         emit this->error(this->lastError_);
@@ -551,3 +950,169 @@ bool HttpClient::getFile(const QString& hostname,
 
     return true;
 }
+
+HttpClient::RangeResult HttpClient::fetchRange(const QUrl& url,
+                                               QIODevice* dest,
+                                               bool canRestart,
+                                               qint64& position,
+                                               qint64& totalSize,
+                                               DataCopiedCallback dataCopiedCallback,
+                                               CancelCallback cancelCallback)
+{
+    // A checkpoint written right at the end; a Range request would only get a 416
+    if (totalSize > 0 && position >= totalSize)
+        return RangeResult::Complete;
+
+    QStringList headers;
+    headers << QString("GET %1 HTTP/1.1").arg(url.path() + "?" + url.query());
+    headers << QString("Host: %1").arg(url.host());
+    if (position > 0)
+        headers << QString("Range: bytes=%1-").arg(position);
+
+    ResponseInfo info;
+    QSslSocket* socket = this->openRequest(url, headers, info);
+    if (!socket)
+    {
+        // No status line at all means the connection went away, not a refusal
+        return info.statusCode == 0 ? RangeResult::Dropped : RangeResult::Failed;
+    }
+
+    QFile* file = canRestart ? qobject_cast<QFile*>(dest) : nullptr;
+    bool restart = false;
+    if (info.statusCode == 206)
+    {
+        if (info.rangeStart != position)
+        {
+            this->lastError_ = QString("Server resumed at byte %1 instead of %2")
+                                   .arg(info.rangeStart).arg(position);
+            restart = true;
+        } else if (totalSize > 0 && info.totalLength >= 0 && info.totalLength != totalSize)
+        {
+            this->lastError_ = QString("Remote size changed from %1 to %2 bytes")
+                                   .arg(totalSize).arg(info.totalLength);
+            restart = true;
+        }
+    } else if (position > 0 && !file)
+    {
+        // What was already written cannot be taken back out of the sink
+        this->lastError_ = QString("Server ignored the Range request; cannot resume at byte %1").arg(position);
+        delete socket;
+        return RangeResult::Failed;
+    } else if (position > 0)
+    {
+        // Range ignored: the full body follows, so start over
+        qDebug() << "HttpClient: server does not support ranges, restarting download";
+        position = 0;
+        if (!file->resize(0) || !file->seek(0))
+        {
+            this->lastError_ = QString("Failed to truncate file: %1").arg(file->errorString());
+            delete socket;
+            return RangeResult::Failed;
+        }
+    }
+
+    if (restart && !file)
+    {
+        delete socket;
+        return RangeResult::Failed;
+    }
+
+    if (restart)
+    {
+        qWarning() << "HttpClient:" << this->lastError_ << "- restarting download";
+        delete socket;
+        position = 0;
+        totalSize = -1;
+        if (!file->resize(0) || !file->seek(0))
+            return RangeResult::Failed;
+        return RangeResult::Dropped;
+    }
+
+    if (info.totalLength >= 0)
+        totalSize = info.totalLength;
+
+    const qint64 base = position;
+    auto copied = [&](qint64 bytes) {
+        if (dataCopiedCallback)
+            dataCopiedCallback(base + bytes);
+    };
+
+    bool complete = false;
+    const qint64 bytesTransferred = this->copyStream(socket, dest, 0, nullptr, copied, cancelCallback,
+                                                     &info, &complete);
+    this->releaseConnection(url, socket, bytesTransferred >= 0 && complete && info.keepAlive);
+
+    if (bytesTransferred < 0)
+    {
+        // Everything the sink accepted stays there; the next range starts after it
+        position = base + this->lastCopyWritten_;
+        const bool cancelled = cancelCallback && cancelCallback();
+        if (cancelled || this->writeFailed_)
+            return RangeResult::Failed;
+        return RangeResult::Dropped;
+    }
+
+    position = base + bytesTransferred;
+    if (totalSize >= 0 && position < totalSize)
+    {
+        this->lastError_ = QString("Connection closed after %1 of %2 bytes").arg(position).arg(totalSize);
+        return RangeResult::Dropped;
+    }
+
+    return RangeResult::Complete;
+}
+
+bool HttpClient::getStream(const QString& hostname,
+                           const QString& remotePath,
+                           const QMap<QString, QString>& queryParams,
+                           QIODevice* destination,
+                           DataCopiedCallback dataCopiedCallback,
+                           CancelCallback cancelCallback)
+{
+    this->isDiskFull_ = false;
+    QUrl url = this->endpointUri(hostname, remotePath, queryParams);
+
+    qDebug() << "HTTP GET:" << url.toString();
+
+    qint64 position = 0;
+    qint64 totalSize = -1;
+
+    RangeResult result = RangeResult::Failed;
+    for (int attempt = 1; attempt <= MAX_RESUME_ATTEMPTS; ++attempt)
+    {
+        // The sink cannot be rewound, so a server that ignores the Range fails the call
+        result = this->fetchRange(url, destination, false, position, totalSize,
+                                  dataCopiedCallback, cancelCallback);
+        if (result != RangeResult::Dropped)
+            break;
+
+        // Nothing to resume against when the server never said how big the body is
+        if (totalSize <= 0)
+        {
+            result = RangeResult::Failed;
+            break;
+        }
+
+        if (attempt == MAX_RESUME_ATTEMPTS)
+            break;
+
+        qWarning() << "HttpClient: stream interrupted at" << position << "of" << totalSize
+                   << "(" << this->lastError_ << "), resuming, attempt" << attempt + 1;
+        QThread::msleep(RESUME_DELAY_MS);
+
+        if (cancelCallback && cancelCallback())
+        {
+            this->lastError_ = "Operation cancelled by user";
+            result = RangeResult::Failed;
+            break;
+        }
+    }
+
+    if (result != RangeResult::Complete)
+    {
+        emit this->error(this->lastError_);
+        return false;
+    }
+
+    return true;
+}
@@ -29,6 +29,7 @@
 #define HTTPCLIENT_H
 
 #include "../../xenlib_global.h"
+#include "../../utils/copypipeline.h"
 #include <QObject>
 #include <QString>
 #include <QUrl>
@@ -36,6 +37,7 @@
 #include <functional>
 
 class XenSession;
+class QFile;
 
 /**
  * @brief HTTP client for XenServer API file transfer operations (import/export)
@@ -57,6 +59,11 @@ class XENLIB_EXPORT HttpClient : public QObject
         static const qint64 WRITE_HIGH_WATER_MARK = 1024 * 1024;
         static const qint64 WRITE_LOW_WATER_MARK = 256 * 1024;
         static const int WRITE_WAIT_SLICE_MS = 250;
+        static const int READ_WAIT_SLICE_MS = 250;
+        static const qint64 MAX_DRAIN_BYTES = 64 * 1024;
+        static const int MAX_RESUME_ATTEMPTS = 5;
+        static const int RESUME_DELAY_MS = 500;
+        static const qint64 CHECKPOINT_INTERVAL = 64 * 1024 * 1024;
 
         explicit HttpClient(QObject* parent = nullptr);
         ~HttpClient();
@@ -78,8 +85,47 @@ class XENLIB_EXPORT HttpClient : public QObject
                      ProgressCallback progressCallback = nullptr,
                      CancelCallback cancelCallback = nullptr);
 
+        /**
+        * @brief Upload the content of an already-open device via HTTP PUT
+        *
+        * Same as putFile() but reads the body from @p source, which lets
+        * callers upload a byte range of a larger file or data decoded on the
+        * fly. Exactly @p contentLength bytes must be readable; a source that
+        * ends early fails the request.
+        *
+        * @param source Open, readable device supplying the body
+        * @param contentLength Number of bytes the body will contain
+        * @param hostname Destination host
+        * @param remotePath Remote HTTP path (e.g., "/import_raw_vdi")
+        * @param queryParams Query string parameters (task_id, session_id, etc.)
+        * @param progressCallback Called with percent complete
+        * @param cancelCallback Called to check if operation should be cancelled
+        * @param dataCopiedCallback Called with bytes transferred
+        * @return true on success
+        */
+        bool putStream(QIODevice* source,
+                       qint64 contentLength,
+                       const QString& hostname,
+                       const QString& remotePath,
+                       const QMap<QString, QString>& queryParams,
+                       ProgressCallback progressCallback = nullptr,
+                       CancelCallback cancelCallback = nullptr,
+                       DataCopiedCallback dataCopiedCallback = nullptr);
+
         /**
         * @brief Download a file via HTTP GET
+        *
+        * The body is written to @c localFilePath.tmp and renamed on success.
+        * While downloading, a TransferCheckpoint is kept next to the partial
+        * file every CHECKPOINT_INTERVAL bytes. A dropped connection is
+        * retried up to MAX_RESUME_ATTEMPTS times with a @c Range request
+        * from the last byte written; a server that answers with a full 200
+        * instead of 206 restarts the download from zero. If the retries run
+        * out, the partial file and its checkpoint are kept so the next call
+        * for the same resource resumes after verifying the partial's tail.
+        * Resuming needs the server to report the body length; without one
+        * the body simply runs until the connection closes, as before.
+        *
         * @param hostname Source host
         * @param remotePath Remote HTTP path (e.g., "/export")
         * @param queryParams Query string parameters
@@ -95,11 +141,59 @@ class XENLIB_EXPORT HttpClient : public QObject
                      DataCopiedCallback dataCopiedCallback = nullptr,
                      CancelCallback cancelCallback = nullptr);
 
+        /**
+        * @brief Download via HTTP GET into an already-open device
+        *
+        * Same as getFile() but the response body is written to @p destination
+        * as it arrives, so callers can feed it straight into a processing
+        * pipeline (compression, hashing, archive framing) without a temporary
+        * file. The device is not closed.
+        *
+        * A dropped connection is resumed like getFile() does, with a Range
+        * request from the last byte @p destination accepted. Since the device
+        * cannot be rewound, a server that answers the Range with the whole
+        * body fails the call instead of starting over.
+        *
+        * @param hostname Source host
+        * @param remotePath Remote HTTP path (e.g., "/export_raw_vdi")
+        * @param queryParams Query string parameters
+        * @param destination Open, writable device receiving the body
+        * @param dataCopiedCallback Called with bytes transferred
+        * @param cancelCallback Called to check if operation should be cancelled
+        * @return true on success
+        */
+        bool getStream(const QString& hostname,
+                       const QString& remotePath,
+                       const QMap<QString, QString>& queryParams,
+                       QIODevice* destination,
+                       DataCopiedCallback dataCopiedCallback = nullptr,
+                       CancelCallback cancelCallback = nullptr);
+
         /**
         * @brief Build URI from hostname, path, and query parameters
         */
         static QUrl buildUri(const QString& hostname, const QString& path, const QMap<QString, QString>& queryParams);
 
+        /**
+        * @brief Override the port and transport used for new connections
+        *
+        * XAPI always serves HTTPS on 443; plain HTTP exists for talking to a
+        * local test server.
+        */
+        void setEndpoint(int port, bool useTls) { this->port_ = port; this->useTls_ = useTls; }
+
+        /**
+        * @brief Reuse connections through HttpConnectionPool (default on)
+        *
+        * With keep-alive a request goes out on an idle pooled connection to
+        * the same endpoint when there is one, and the connection is parked
+        * again once its response body has been read to the end (by
+        * Content-Length or chunked framing). A pooled connection the server
+        * has meanwhile closed is replaced by a fresh one transparently; for
+        * uploads that needs a seekable source.
+        */
+        void setKeepAlive(bool enabled) { this->keepAlive_ = enabled; }
+
         /**
         * @brief Get last error message
         */
@@ -111,22 +205,64 @@ class XENLIB_EXPORT HttpClient : public QObject
         */
         bool IsDiskFull() const { return this->isDiskFull_; }
 
+        /**
+        * @brief Read and write side counters of the last body copy.
+        *
+        * The side with high busy time and low stall time is the bottleneck:
+        * disk or decoder on the device side, TLS and the network on the
+        * socket side.
+        */
+        QList<CopyPipeline::StageStats> lastCopyStats() const { return this->lastCopyStats_; }
+
     signals:
         void error(const QString& message);
 
     private:
-        bool connectToHost(const QUrl& url, QSslSocket*& socket);
+        struct ResponseInfo
+        {
+            int statusCode = 0;
+            qint64 contentLength = -1;  ///< Content-Length, -1 if absent
+            qint64 rangeStart = -1;     ///< First byte of a 206 Content-Range
+            qint64 totalLength = -1;    ///< Full resource size from Content-Range or 200 Content-Length
+            bool chunked = false;       ///< Transfer-Encoding: chunked
+            bool keepAlive = false;     ///< Server leaves the connection open after the body
+        };
+
+        enum class RangeResult
+        {
+            Complete,
+            Dropped,    ///< Connection lost, retrying with a Range request may help
+            Failed
+        };
+
+        QUrl endpointUri(const QString& hostname, const QString& path, const QMap<QString, QString>& queryParams) const;
+        bool connectToHost(const QUrl& url, QSslSocket*& socket, bool* reused = nullptr);
+        void releaseConnection(const QUrl& url, QSslSocket* socket, bool reusable);
+        QSslSocket* openRequest(const QUrl& url, QStringList headers, ResponseInfo& info);
+        bool drainResponseBody(QSslSocket* socket, const ResponseInfo& info);
         bool sendHttpHeaders(QSslSocket* socket, const QStringList& headers);
-        bool readHttpResponse(QSslSocket* socket);
+        bool readHttpResponse(QSslSocket* socket, ResponseInfo* info = nullptr);
+        RangeResult fetchRange(const QUrl& url, QIODevice* dest, bool canRestart,
+                               qint64& position, qint64& totalSize,
+                               DataCopiedCallback dataCopiedCallback,
+                               CancelCallback cancelCallback);
         bool waitForWriteBuffer(QAbstractSocket* socket, qint64 targetBytes, CancelCallback cancelCallback);
         qint64 copyStream(QIODevice* source, QIODevice* dest,
                           qint64 totalSize,
                           ProgressCallback progressCallback,
                           DataCopiedCallback dataCopiedCallback,
-                          CancelCallback cancelCallback);
+                          CancelCallback cancelCallback,
+                          const ResponseInfo* response = nullptr,
+                          bool* bodyComplete = nullptr);
 
         QString lastError_;
         bool isDiskFull_ = false;
+        bool writeFailed_ = false;      ///< Last copyStream failed on the destination side
+        qint64 lastCopyWritten_ = 0;    ///< Bytes the destination accepted in the last copyStream
+        QList<CopyPipeline::StageStats> lastCopyStats_;
+        int port_ = 443;
+        bool useTls_ = true;
+        bool keepAlive_ = true;
 };
 
 #endif // HTTPCLIENT_H
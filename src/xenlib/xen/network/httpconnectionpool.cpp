@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "httpconnectionpool.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSslSocket>
+#include <QThread>
+#include <QUrl>
+
+namespace
+{
+    struct IdleConnection
+    {
+        QSslSocket* socket = nullptr;
+        QElapsedTimer idleSince;
+    };
+
+    struct PoolState
+    {
+        QMutex mutex;
+        QHash<QString, QList<IdleConnection>> idle;
+        int idleTimeoutMs = HttpConnectionPool::DEFAULT_IDLE_TIMEOUT_MS;
+        int maxIdlePerHost = HttpConnectionPool::DEFAULT_MAX_IDLE_PER_HOST;
+    };
+
+    PoolState& poolState()
+    {
+        static PoolState state;
+        return state;
+    }
+
+    // Sockets in the pool have no thread; pull them into this one before use
+    // or deletion
+    void adopt(QSslSocket* socket)
+    {
+        socket->moveToThread(QThread::currentThread());
+    }
+
+    void destroy(QSslSocket* socket)
+    {
+        adopt(socket);
+        socket->abort();
+        delete socket;
+    }
+
+    // Remove expired entries; caller holds the mutex and destroys the result
+    QList<QSslSocket*> takeExpired(PoolState& state)
+    {
+        QList<QSslSocket*> expired;
+        for (auto it = state.idle.begin(); it != state.idle.end();)
+        {
+            QList<IdleConnection>& list = it.value();
+            for (int i = list.size() - 1; i >= 0; --i)
+            {
+                if (list.at(i).idleSince.elapsed() >= state.idleTimeoutMs)
+                    expired.append(list.takeAt(i).socket);
+            }
+            it = list.isEmpty() ? state.idle.erase(it) : it + 1;
+        }
+        return expired;
+    }
+}
+
+QString HttpConnectionPool::Key(const QUrl& url)
+{
+    return QString("%1://%2:%3").arg(url.scheme(), url.host()).arg(url.port(url.scheme() == "http" ? 80 : 443));
+}
+
+QSslSocket* HttpConnectionPool::Acquire(const QString& key)
+{
+    PoolState& state = poolState();
+
+    for (;;)
+    {
+        QList<QSslSocket*> expired;
+        QSslSocket* socket = nullptr;
+        {
+            QMutexLocker locker(&state.mutex);
+            expired = takeExpired(state);
+            auto it = state.idle.find(key);
+            if (it != state.idle.end())
+            {
+                // Most recently used first, it is the least likely to have been closed
+                socket = it.value().takeLast().socket;
+                if (it.value().isEmpty())
+                    state.idle.erase(it);
+            }
+        }
+
+        for (QSslSocket* old : expired)
+            destroy(old);
+
+        if (!socket)
+            return nullptr;
+
+        adopt(socket);
+
+        // Let the socket notice a close or stray data that arrived while idle
+        socket->waitForReadyRead(0);
+        if (socket->state() == QAbstractSocket::ConnectedState && socket->bytesAvailable() == 0)
+            return socket;
+
+        qDebug() << "HttpConnectionPool: dropping stale connection to" << key;
+        socket->abort();
+        delete socket;
+    }
+}
+
+void HttpConnectionPool::Release(const QString& key, QSslSocket* socket)
+{
+    if (!socket)
+        return;
+
+    PoolState& state = poolState();
+    if (socket->state() != QAbstractSocket::ConnectedState || socket->bytesAvailable() > 0)
+    {
+        socket->abort();
+        delete socket;
+        return;
+    }
+
+    socket->setParent(nullptr);
+    socket->moveToThread(nullptr);
+
+    QList<QSslSocket*> dropped;
+    {
+        QMutexLocker locker(&state.mutex);
+        dropped = takeExpired(state);
+        if (state.maxIdlePerHost <= 0)
+        {
+            dropped.append(socket);
+        } else
+        {
+            QList<IdleConnection>& list = state.idle[key];
+            while (list.size() >= state.maxIdlePerHost)
+                dropped.append(list.takeFirst().socket);
+
+            IdleConnection entry;
+            entry.socket = socket;
+            entry.idleSince.start();
+            list.append(entry);
+        }
+    }
+
+    for (QSslSocket* old : dropped)
+        destroy(old);
+}
+
+void HttpConnectionPool::Clear()
+{
+    PoolState& state = poolState();
+    QList<QSslSocket*> all;
+    {
+        QMutexLocker locker(&state.mutex);
+        for (const QList<IdleConnection>& list : state.idle)
+        {
+            for (const IdleConnection& entry : list)
+                all.append(entry.socket);
+        }
+        state.idle.clear();
+    }
+
+    for (QSslSocket* socket : all)
+        destroy(socket);
+}
+
+int HttpConnectionPool::GetIdleCount(const QString& key)
+{
+    PoolState& state = poolState();
+    QMutexLocker locker(&state.mutex);
+    return state.idle.value(key).size();
+}
+
+int HttpConnectionPool::GetIdleTimeout()
+{
+    QMutexLocker locker(&poolState().mutex);
+    return poolState().idleTimeoutMs;
+}
+
+void HttpConnectionPool::SetIdleTimeout(int ms)
+{
+    QMutexLocker locker(&poolState().mutex);
+    poolState().idleTimeoutMs = qMax(0, ms);
+}
+
+int HttpConnectionPool::GetMaxIdlePerHost()
+{
+    QMutexLocker locker(&poolState().mutex);
+    return poolState().maxIdlePerHost;
+}
+
+void HttpConnectionPool::SetMaxIdlePerHost(int max)
+{
+    QMutexLocker locker(&poolState().mutex);
+    poolState().maxIdlePerHost = qMax(0, max);
+}
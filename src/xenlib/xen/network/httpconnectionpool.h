@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HTTPCONNECTIONPOOL_H
+#define HTTPCONNECTIONPOOL_H
+
+#include "../../xenlib_global.h"
+#include <QString>
+
+class QSslSocket;
+class QUrl;
+
+/**
+ * @brief Process-wide pool of idle keep-alive connections used by HttpClient.
+ *
+ * Connections are keyed by scheme, host and port. A socket handed back with
+ * Release() is detached from its thread, so the next Acquire() may come from
+ * any thread (transfers run on operation and TransferBatch threads) and pulls
+ * the socket into the caller's thread. Acquire() drops connections the server
+ * has closed or that sat idle longer than the idle timeout, so callers only
+ * need a fallback for a server closing the connection in the instant between
+ * the check and the request.
+ *
+ * All methods are thread-safe.
+ */
+class XENLIB_EXPORT HttpConnectionPool
+{
+    public:
+        static const int DEFAULT_IDLE_TIMEOUT_MS = 30 * 1000;
+        static const int DEFAULT_MAX_IDLE_PER_HOST = 4;
+
+        /** @brief Pool key for the endpoint of @p url. */
+        static QString Key(const QUrl& url);
+
+        /**
+         * @brief Take a live idle connection for @p key, owned by the calling thread.
+         * @return nullptr if none is available
+         */
+        static QSslSocket* Acquire(const QString& key);
+
+        /**
+         * @brief Park a connection whose last response was fully read.
+         *
+         * Must be called from the socket's thread. The pool takes ownership and
+         * closes the socket instead if it is not connected or the host already
+         * has the maximum number of idle connections.
+         */
+        static void Release(const QString& key, QSslSocket* socket);
+
+        /** @brief Close every idle connection. */
+        static void Clear();
+
+        /** @brief Number of idle connections parked for @p key. */
+        static int GetIdleCount(const QString& key);
+
+        static int GetIdleTimeout();
+        static void SetIdleTimeout(int ms);
+
+        static int GetMaxIdlePerHost();
+        static void SetMaxIdlePerHost(int max);
+
+    private:
+        HttpConnectionPool() = delete;
+};
+
+#endif // HTTPCONNECTIONPOOL_H
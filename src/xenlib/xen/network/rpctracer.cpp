@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rpctracer.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int SUB_BUCKETS = 8;
+    const int TRACE_PID = 1;
+
+    // Exact below 16 µs, then 8 buckets per power of two
+    class LatencyHistogram
+    {
+        public:
+            void Add(qint64 us)
+            {
+                const int index = indexFor(us);
+                if (index >= this->m_buckets.size())
+                    this->m_buckets.resize(index + 1);
+                ++this->m_buckets[index];
+                ++this->m_count;
+                this->m_max = qMax(this->m_max, us);
+            }
+
+            qint64 Percentile(double fraction) const
+            {
+                if (this->m_count == 0)
+                    return 0;
+
+                const quint64 target = qMax<quint64>(1, quint64(std::ceil(fraction * double(this->m_count))));
+                quint64 seen = 0;
+                for (int i = 0; i < this->m_buckets.size(); ++i)
+                {
+                    seen += this->m_buckets.at(i);
+                    if (seen >= target)
+                        return qMin(upperBound(i), this->m_max);
+                }
+                return this->m_max;
+            }
+
+            qint64 GetMax() const
+            {
+                return this->m_max;
+            }
+
+        private:
+            static int indexFor(qint64 us)
+            {
+                if (us < 2 * SUB_BUCKETS)
+                    return int(qMax<qint64>(0, us));
+                const int msb = 63 - qCountLeadingZeroBits(quint64(us));
+                return 2 * SUB_BUCKETS + (msb - 4) * SUB_BUCKETS + int((us >> (msb - 3)) - SUB_BUCKETS);
+            }
+
+            static qint64 upperBound(int index)
+            {
+                if (index < 2 * SUB_BUCKETS)
+                    return index;
+                const int msb = 4 + (index - 2 * SUB_BUCKETS) / SUB_BUCKETS;
+                const qint64 top = SUB_BUCKETS + (index - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+                return ((top + 1) << (msb - 3)) - 1;
+            }
+
+            QVector<quint32> m_buckets;
+            quint64 m_count = 0;
+            qint64 m_max = 0;
+    };
+
+    struct MethodStats
+    {
+        LatencyHistogram wire;
+        int count = 0;
+        int failures = 0;
+        int parsed = 0;
+        qint64 wireUs = 0;
+        qint64 queueUs = 0;
+        qint64 sendUs = 0;
+        qint64 serverUs = 0;
+        qint64 receiveUs = 0;
+        qint64 parseUs = 0;
+        qint64 requestBytes = 0;
+        qint64 responseBytes = 0;
+    };
+
+    struct TracerState
+    {
+        TracerState()
+        {
+            this->clock.start();
+        }
+
+        QMutex mutex;
+        QElapsedTimer clock;
+        QList<RpcTraceEvent> events;   ///< Consecutive ids, oldest first
+        QHash<QString, MethodStats> stats;
+        quint64 nextId = 1;
+        int capacity = RpcTracer::DEFAULT_CAPACITY;
+    };
+
+    TracerState& tracerState()
+    {
+        static TracerState state;
+        return state;
+    }
+
+    thread_local QString t_context;
+    thread_local quint64 t_pendingParse = 0;
+
+    // Caller holds the mutex
+    RpcTraceEvent* findEvent(TracerState& state, quint64 id)
+    {
+        if (state.events.isEmpty() || id < state.events.first().id)
+            return nullptr;
+        const quint64 index = id - state.events.first().id;
+        if (index >= quint64(state.events.size()))
+            return nullptr;
+        return &state.events[int(index)];
+    }
+
+    QJsonObject traceEvent(const QString& name, const char* category, const char* phase, qint64 ts, int tid)
+    {
+        return QJsonObject{
+            {"name", name},
+            {"cat", QLatin1String(category)},
+            {"ph", QLatin1String(phase)},
+            {"ts", ts},
+            {"pid", TRACE_PID},
+            {"tid", tid},
+        };
+    }
+
+    // Async begin/end pair; slices sharing an id nest under the call
+    void appendAsync(QJsonArray& trace, const QString& name, quint64 id, qint64 start, qint64 duration, int tid,
+                     const QJsonObject& args = QJsonObject())
+    {
+        QJsonObject begin = traceEvent(name, "rpc", "b", start, tid);
+        begin.insert("id", QString::number(id));
+        if (!args.isEmpty())
+            begin.insert("args", args);
+        trace.append(begin);
+
+        QJsonObject end = traceEvent(name, "rpc", "e", start + duration, tid);
+        end.insert("id", QString::number(id));
+        trace.append(end);
+    }
+
+    void appendComplete(QJsonArray& trace, const QString& name, qint64 start, qint64 duration, int tid)
+    {
+        QJsonObject slice = traceEvent(name, "rpc.wire", "X", start, tid);
+        slice.insert("dur", duration);
+        trace.append(slice);
+    }
+}
+
+QAtomicInt& RpcTracer::enabledFlag()
+{
+    static QAtomicInt enabled(0);
+    return enabled;
+}
+
+void RpcTracer::SetEnabled(bool enabled)
+{
+    if (enabledFlag().fetchAndStoreRelaxed(enabled ? 1 : 0) != (enabled ? 1 : 0))
+        qDebug() << "RpcTracer:" << (enabled ? "tracing" : "no longer tracing") << "API calls";
+}
+
+void RpcTracer::SetCapacity(int events)
+{
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    state.capacity = qMax(1, events);
+    if (state.events.size() > state.capacity)
+        state.events.remove(0, state.events.size() - state.capacity);
+}
+
+int RpcTracer::GetCapacity()
+{
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    return state.capacity;
+}
+
+void RpcTracer::Clear()
+{
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    state.events.clear();
+    state.stats.clear();
+}
+
+qint64 RpcTracer::Now()
+{
+    return tracerState().clock.nsecsElapsed() / 1000;
+}
+
+QString RpcTracer::CurrentContext()
+{
+    return t_context;
+}
+
+quint64 RpcTracer::Record(RpcTraceEvent event)
+{
+    if (!IsEnabled())
+        return 0;
+
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+
+    event.id = state.nextId++;
+    const qint64 wireUs = event.GetWireUs();
+
+    MethodStats& stats = state.stats[event.method];
+    stats.wire.Add(wireUs);
+    ++stats.count;
+    if (event.failed)
+        ++stats.failures;
+    stats.wireUs += wireUs;
+    stats.queueUs += event.queueUs;
+    stats.sendUs += event.sendUs;
+    stats.serverUs += event.serverUs;
+    stats.receiveUs += event.receiveUs;
+    stats.requestBytes += event.requestBytes;
+    stats.responseBytes += event.responseBytes;
+
+    state.events.append(event);
+    if (state.events.size() > state.capacity)
+        state.events.removeFirst();
+    return event.id;
+}
+
+void RpcTracer::SetPendingParse(quint64 id)
+{
+    t_pendingParse = id;
+}
+
+void RpcTracer::RecordParse(qint64 parseUs)
+{
+    const quint64 id = t_pendingParse;
+    t_pendingParse = 0;
+    if (id == 0 || !IsEnabled())
+        return;
+
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+
+    // Calls that already left the ring buffer lose their decoding time
+    RpcTraceEvent* event = findEvent(state, id);
+    if (!event || event->parseUs >= 0)
+        return;
+
+    event->parseUs = parseUs;
+    MethodStats& stats = state.stats[event->method];
+    stats.parseUs += parseUs;
+    ++stats.parsed;
+}
+
+QList<RpcTraceEvent> RpcTracer::GetEvents()
+{
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+    return state.events;
+}
+
+QList<RpcLatencySummary> RpcTracer::GetSummaries()
+{
+    TracerState& state = tracerState();
+    QMutexLocker locker(&state.mutex);
+
+    QList<RpcLatencySummary> summaries;
+    summaries.reserve(state.stats.size());
+    for (auto it = state.stats.constBegin(); it != state.stats.constEnd(); ++it)
+    {
+        const MethodStats& stats = it.value();
+        RpcLatencySummary summary;
+        summary.method = it.key();
+        summary.count = stats.count;
+        summary.failures = stats.failures;
+        summary.p50Us = stats.wire.Percentile(0.50);
+        summary.p90Us = stats.wire.Percentile(0.90);
+        summary.p99Us = stats.wire.Percentile(0.99);
+        summary.maxUs = stats.wire.GetMax();
+        summary.totalUs = stats.wireUs + stats.parseUs;
+        summary.meanQueueUs = stats.queueUs / qMax(1, stats.count);
+        summary.meanSendUs = stats.sendUs / qMax(1, stats.count);
+        summary.meanServerUs = stats.serverUs / qMax(1, stats.count);
+        summary.meanReceiveUs = stats.receiveUs / qMax(1, stats.count);
+        summary.meanParseUs = stats.parseUs / qMax(1, stats.parsed);
+        summary.requestBytes = stats.requestBytes;
+        summary.responseBytes = stats.responseBytes;
+        summaries.append(summary);
+    }
+
+    std::sort(summaries.begin(), summaries.end(), [](const RpcLatencySummary& a, const RpcLatencySummary& b) {
+        return a.totalUs > b.totalUs;
+    });
+    return summaries;
+}
+
+QByteArray RpcTracer::ExportChromeTrace()
+{
+    const QList<RpcTraceEvent> events = GetEvents();
+
+    QJsonArray trace;
+    QJsonObject process = traceEvent("process_name", "__metadata", "M", 0, 0);
+    process.insert("args", QJsonObject{{"name", "XenAdmin API calls"}});
+    trace.append(process);
+
+    // One track per connection, numbered in order of first appearance
+    QHash<QString, int> tracks;
+    for (const RpcTraceEvent& event : events)
+    {
+        int tid = tracks.value(event.endpoint);
+        if (tid == 0)
+        {
+            tid = tracks.size() + 1;
+            tracks.insert(event.endpoint, tid);
+            QJsonObject thread = traceEvent("thread_name", "__metadata", "M", 0, tid);
+            thread.insert("args", QJsonObject{{"name", event.endpoint}});
+            trace.append(thread);
+        }
+
+        const QJsonObject args{
+            {"connection", event.endpoint},
+            {"context", event.context},
+            {"request_bytes", event.requestBytes},
+            {"response_bytes", event.responseBytes},
+            {"queue_us", event.queueUs},
+            {"send_us", event.sendUs},
+            {"server_us", event.serverUs},
+            {"receive_us", event.receiveUs},
+            {"parse_us", event.parseUs},
+            {"failed", event.failed},
+        };
+        appendAsync(trace, event.method, event.id, event.startUs, event.GetTotalUs(), tid, args);
+        if (event.queueUs > 0)
+            appendAsync(trace, "queue", event.id, event.startUs, event.queueUs, tid);
+
+        const qint64 wireStart = event.startUs + event.queueUs;
+        const qint64 wireUs = event.sendUs + event.serverUs + event.receiveUs;
+        if (event.parseUs >= 0)
+            appendAsync(trace, "parse", event.id, wireStart + wireUs, event.parseUs, tid);
+
+        // The worker handles one call at a time, so wire slices never overlap on a track
+        appendComplete(trace, event.method, wireStart, wireUs, tid);
+        appendComplete(trace, "send", wireStart, event.sendUs, tid);
+        appendComplete(trace, "server", wireStart + event.sendUs, event.serverUs, tid);
+        appendComplete(trace, "receive", wireStart + event.sendUs + event.serverUs, event.receiveUs, tid);
+    }
+
+    const QJsonObject document{
+        {"traceEvents", trace},
+        {"displayTimeUnit", "ms"},
+    };
+    return QJsonDocument(document).toJson(QJsonDocument::Compact);
+}
+
+bool RpcTracer::ExportChromeTrace(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if (error)
+            *error = QString("Cannot create %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    const QByteArray data = ExportChromeTrace();
+    if (file.write(data) != data.size())
+    {
+        if (error)
+            *error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QString RpcTracer::MethodFromRequest(const QByteArray& request)
+{
+    // buildJsonRpcCall writes compact JSON, so the key is never followed by spaces
+    static const QByteArray key = "\"method\":\"";
+    const int start = request.indexOf(key);
+    if (start < 0)
+        return QString("(unknown)");
+    const int end = request.indexOf('"', start + key.size());
+    if (end < 0)
+        return QString("(unknown)");
+    return QString::fromUtf8(request.mid(start + key.size(), end - start - key.size()));
+}
+
+RpcTraceScope::RpcTraceScope(const QString& context) : m_previous(t_context)
+{
+    t_context = context;
+}
+
+RpcTraceScope::~RpcTraceScope()
+{
+    t_context = this->m_previous;
+}
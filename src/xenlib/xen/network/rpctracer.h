@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RPCTRACER_H
+#define RPCTRACER_H
+
+#include "../../xenlib_global.h"
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief Timings of one API call as seen by RpcTracer.
+ *
+ * The phases follow the call: waiting in the ConnectionWorker queue, writing
+ * the request, waiting for the first byte of the reply, reading the rest of
+ * it and finally decoding it in JsonRpcClient on the calling thread.
+ */
+struct XENLIB_EXPORT RpcTraceEvent
+{
+    quint64 id = 0;            ///< Sequence number, unique within the process
+    QString method;            ///< "VM.start", "event.from", …
+    QString endpoint;          ///< "host:port" of the connection
+    QString context;           ///< Action or page that issued the call, if known
+    qint64 requestBytes = 0;
+    qint64 responseBytes = 0;
+    qint64 startUs = 0;        ///< When the call was queued, relative to the tracer clock
+    qint64 queueUs = 0;
+    qint64 sendUs = 0;
+    qint64 serverUs = 0;       ///< Request written until the first response byte
+    qint64 receiveUs = 0;
+    qint64 parseUs = -1;       ///< -1 when the reply was not decoded by JsonRpcClient on the waiting thread
+    bool failed = false;       ///< No reply arrived
+
+    /** @brief Queue wait and time on the wire, without decoding. */
+    qint64 GetWireUs() const
+    {
+        return this->queueUs + this->sendUs + this->serverUs + this->receiveUs;
+    }
+
+    qint64 GetTotalUs() const
+    {
+        return this->GetWireUs() + qMax<qint64>(0, this->parseUs);
+    }
+};
+
+/**
+ * @brief Latency statistics of one API method since tracing started.
+ *
+ * Percentiles are taken from a log-linear histogram over the wire time
+ * (queue to last response byte) and are accurate to about 12%.
+ */
+struct XENLIB_EXPORT RpcLatencySummary
+{
+    QString method;
+    int count = 0;
+    int failures = 0;
+    qint64 p50Us = 0;
+    qint64 p90Us = 0;
+    qint64 p99Us = 0;
+    qint64 maxUs = 0;
+    qint64 totalUs = 0;        ///< Sum of wire and parse time over all calls
+    qint64 meanQueueUs = 0;
+    qint64 meanSendUs = 0;
+    qint64 meanServerUs = 0;
+    qint64 meanReceiveUs = 0;
+    qint64 meanParseUs = 0;    ///< Over the calls whose decoding was measured
+    qint64 requestBytes = 0;
+    qint64 responseBytes = 0;
+};
+
+/**
+ * @brief Opt-in, process-wide tracer of API call latency.
+ *
+ * While enabled, ConnectionWorker stamps every queued call and records where
+ * the time went once the reply is in; JsonRpcClient adds the decoding time
+ * when the reply is parsed on the thread that waited for it. Calls are
+ * attributed to the innermost RpcTraceScope active on the issuing thread.
+ *
+ * The most recent calls are kept in a ring buffer for export as Chrome
+ * trace_event JSON (chrome://tracing, Perfetto), and per-method histograms
+ * aggregate everything since the last Clear(). When disabled the hooks cost
+ * one atomic load per call. All methods are thread-safe.
+ */
+class XENLIB_EXPORT RpcTracer
+{
+    public:
+        static const int DEFAULT_CAPACITY = 50000;
+
+        static void SetEnabled(bool enabled);
+
+        static bool IsEnabled()
+        {
+            return enabledFlag().loadRelaxed() != 0;
+        }
+
+        /** @brief Calls kept for export; older ones are dropped first. */
+        static void SetCapacity(int events);
+        static int GetCapacity();
+
+        /** @brief Forget recorded calls and statistics. */
+        static void Clear();
+
+        /** @brief Microseconds on the tracer's monotonic clock. */
+        static qint64 Now();
+
+        /** @brief Context set by the innermost RpcTraceScope on the calling thread. */
+        static QString CurrentContext();
+
+        /**
+         * @brief Add a finished call; assigns and returns its id.
+         *
+         * Does nothing and returns 0 unless enabled.
+         */
+        static quint64 Record(RpcTraceEvent event);
+
+        /**
+         * @brief Mark call @p id as the one the calling thread is about to decode.
+         *
+         * Called by ConnectionWorker::WaitForResponse so that the next
+         * RecordParse() on this thread lands on the right call.
+         */
+        static void SetPendingParse(quint64 id);
+
+        /** @brief Attach decoding time to the call set by SetPendingParse() on this thread. */
+        static void RecordParse(qint64 parseUs);
+
+        static QList<RpcTraceEvent> GetEvents();
+
+        /** @brief Per-method statistics, slowest total first. */
+        static QList<RpcLatencySummary> GetSummaries();
+
+        /**
+         * @brief The recorded calls as Chrome trace_event JSON.
+         *
+         * Each connection gets a track with the time its worker spent on the
+         * wire per call; queue wait and decoding appear as async slices of
+         * the same call, so calls that overlap stay readable.
+         */
+        static QByteArray ExportChromeTrace();
+        static bool ExportChromeTrace(const QString& path, QString* error = nullptr);
+
+        /** @brief Method name of a JSON-RPC request without parsing the whole body. */
+        static QString MethodFromRequest(const QByteArray& request);
+
+    private:
+        RpcTracer() = delete;
+
+        static QAtomicInt& enabledFlag();
+};
+
+/**
+ * @brief Names the action or page behind the API calls made on this thread.
+ *
+ * Scopes nest; the previous context is restored on destruction.
+ */
+class XENLIB_EXPORT RpcTraceScope
+{
+    public:
+        explicit RpcTraceScope(const QString& context);
+        ~RpcTraceScope();
+
+    private:
+        Q_DISABLE_COPY(RpcTraceScope)
+
+        QString m_previous;
+};
+
+#endif // RPCTRACER_H
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "transferbatch.h"
+#include "transferlimits.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QDebug>
+#include <atomic>
+#include <exception>
+
+TransferBatch::TransferBatch(XenConnection* connection, const QString& hostname)
+    : m_connection(connection), m_hostname(hostname)
+{
+}
+
+void TransferBatch::AddJob(const QString& label, qint64 weight, JobFunction job)
+{
+    this->m_jobs.append({ label, qMax<qint64>(1, weight), job });
+}
+
+bool TransferBatch::Run(ProgressFunction progress, CancelFunction cancelled)
+{
+    this->m_error.clear();
+    this->m_cancelled = false;
+
+    const int jobCount = this->m_jobs.size();
+    if (jobCount == 0)
+        return true;
+
+    qint64 totalWeight = 0;
+    for (const Job& job : this->m_jobs)
+        totalWeight += job.weight;
+
+    // Shared between the workers and this thread
+    QMutex mutex;
+    QVector<double> fractions(jobCount, 0.0);
+    QVector<bool> running(jobCount, false);
+    std::atomic<int> nextJob { 0 };
+    std::atomic<bool> abort { false };
+    QString firstError;
+
+    const CancelFunction jobCancelled = [&]() -> bool {
+        return abort.load() || (cancelled && cancelled());
+    };
+
+    auto worker = [&]() {
+        for (;;)
+        {
+            const int index = nextJob.fetch_add(1);
+            if (index >= jobCount || jobCancelled())
+                return;
+
+            const Job& job = this->m_jobs.at(index);
+            if (!TransferLimits::AcquireSlot(this->m_connection, this->m_hostname, jobCancelled))
+                return;
+
+            {
+                QMutexLocker locker(&mutex);
+                running[index] = true;
+            }
+
+            const ReportFunction report = [&, index](qint64 done, qint64 total) {
+                QMutexLocker locker(&mutex);
+                fractions[index] = total > 0 ? qBound(0.0, static_cast<double>(done) / total, 1.0) : 0.0;
+            };
+
+            QString error;
+            try
+            {
+                job.run(report, jobCancelled);
+            }
+            catch (const std::exception& e)
+            {
+                error = QString::fromUtf8(e.what());
+            }
+            catch (...)
+            {
+                // Cancellation exceptions of the caller land here too
+                error = QStringLiteral("Transfer failed");
+            }
+
+            TransferLimits::ReleaseSlot(this->m_connection, this->m_hostname);
+
+            QMutexLocker locker(&mutex);
+            running[index] = false;
+            if (error.isEmpty())
+            {
+                fractions[index] = 1.0;
+            } else if (!abort.exchange(true))
+            {
+                firstError = QString("%1: %2").arg(job.label, error);
+            }
+        }
+    };
+
+    int workerCount = qMin(jobCount, TransferLimits::GetMaxTransfersPerConnection());
+    if (this->m_maxConcurrency > 0)
+        workerCount = qMin(workerCount, this->m_maxConcurrency);
+
+    QList<QThread*> threads;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        QThread* thread = QThread::create(worker);
+        thread->start();
+        threads.append(thread);
+    }
+
+    auto reportProgress = [&]() {
+        if (!progress)
+            return;
+        double done = 0;
+        QStringList active;
+        {
+            QMutexLocker locker(&mutex);
+            for (int i = 0; i < jobCount; ++i)
+            {
+                done += fractions[i] * this->m_jobs.at(i).weight;
+                if (running[i])
+                    active << this->m_jobs.at(i).label;
+            }
+        }
+        progress(static_cast<int>(done * 100.0 / totalWeight), active.join(QStringLiteral(", ")));
+    };
+
+    for (QThread* thread : threads)
+    {
+        while (!thread->wait(PROGRESS_INTERVAL_MS))
+            reportProgress();
+        delete thread;
+    }
+    reportProgress();
+
+    if (cancelled && cancelled())
+    {
+        this->m_cancelled = true;
+        return false;
+    }
+    if (abort.load())
+    {
+        this->m_error = firstError;
+        qWarning() << "TransferBatch: transfer failed:" << firstError;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRANSFERBATCH_H
+#define TRANSFERBATCH_H
+
+#include "../../xenlib_global.h"
+#include <QList>
+#include <QString>
+#include <functional>
+
+class XenConnection;
+
+/**
+ * @brief Runs a set of disk transfers concurrently within the TransferLimits caps.
+ *
+ * Used by the appliance import/export actions so that a VM with several
+ * large disks is not bounded by a single HTTP stream. Each job runs on its
+ * own worker thread once a per-connection and per-host slot is free; the
+ * calling thread stays in Run() and reports aggregate progress, so callers
+ * can update their AsyncOperation from the thread that owns it.
+ *
+ * A job reports failure by throwing; the first failure cancels the other
+ * jobs (their cancel callback starts returning true) and Run() returns false.
+ */
+class XENLIB_EXPORT TransferBatch
+{
+    public:
+        /** @brief Job progress: bytes done out of the job's own total. */
+        using ReportFunction = std::function<void(qint64 done, qint64 total)>;
+        using CancelFunction = std::function<bool()>;
+        using JobFunction = std::function<void(const ReportFunction& report, const CancelFunction& cancelled)>;
+
+        /** @brief Aggregate progress callback, invoked on the thread calling Run(). */
+        using ProgressFunction = std::function<void(int percent, const QString& activeJobs)>;
+
+        static const int PROGRESS_INTERVAL_MS = 250;
+
+        /**
+         * @param connection Connection the transfers run over (slot accounting key)
+         * @param hostname   Host the transfers go to (slot accounting key)
+         */
+        TransferBatch(XenConnection* connection, const QString& hostname);
+
+        /**
+         * @brief Additional cap for this batch only, e.g. 1 when jobs share an output stream.
+         */
+        void SetMaxConcurrency(int max) { this->m_maxConcurrency = max; }
+
+        /**
+         * @brief Queue a job. Jobs start in the order they were added.
+         * @param label  Shown in progress text while the job runs
+         * @param weight Relative share of the aggregate progress (usually the disk size)
+         */
+        void AddJob(const QString& label, qint64 weight, JobFunction job);
+
+        int JobCount() const { return this->m_jobs.size(); }
+
+        /**
+         * @brief Run all jobs and wait for them to finish.
+         * @param progress  Called periodically with aggregate progress (may be null)
+         * @param cancelled Polled by the batch; cancels all jobs when it returns true
+         * @return true if every job completed
+         */
+        bool Run(ProgressFunction progress, CancelFunction cancelled);
+
+        /** @brief First job failure message, or empty on success/cancel. */
+        QString GetError() const { return this->m_error; }
+
+        /** @brief Whether Run() stopped because @p cancelled returned true. */
+        bool WasCancelled() const { return this->m_cancelled; }
+
+    private:
+        struct Job
+        {
+            QString label;
+            qint64 weight = 0;
+            JobFunction run;
+        };
+
+        XenConnection* m_connection;
+        QString m_hostname;
+        int m_maxConcurrency = 0;
+        QList<Job> m_jobs;
+        QString m_error;
+        bool m_cancelled = false;
+};
+
+#endif // TRANSFERBATCH_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "transfercheckpoint.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+TransferCheckpoint::TransferCheckpoint(const QString& dataPath, const QString& identity)
+    : m_dataPath(dataPath),
+      m_checkpointPath(dataPath + ".resume"),
+      m_identity(identity)
+{
+}
+
+QString TransferCheckpoint::Identity(const QString& hostname,
+                                     const QString& remotePath,
+                                     const QMap<QString, QString>& queryParams)
+{
+    QStringList parts;
+    parts << hostname << remotePath;
+    for (auto it = queryParams.constBegin(); it != queryParams.constEnd(); ++it)
+    {
+        if (it.key() == "session_id" || it.key() == "task_id" || it.value().isEmpty())
+            continue;
+        parts << it.key() + "=" + it.value();
+    }
+    return parts.join('&');
+}
+
+qint64 TransferCheckpoint::Load()
+{
+    this->m_totalSize = -1;
+
+    QFile file(this->m_checkpointPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    const qint64 offset = static_cast<qint64>(obj.value("offset").toDouble(-1));
+    const QByteArray expectedTail = obj.value("tail_sha1").toString().toLatin1();
+
+    if (obj.value("identity").toString() != this->m_identity)
+    {
+        qDebug() << "TransferCheckpoint: checkpoint belongs to a different transfer, ignoring";
+        return 0;
+    }
+
+    if (offset <= 0 || QFile(this->m_dataPath).size() < offset)
+    {
+        qWarning() << "TransferCheckpoint: partial file is shorter than checkpoint offset" << offset;
+        return 0;
+    }
+
+    if (this->tailHash(offset) != expectedTail)
+    {
+        qWarning() << "TransferCheckpoint: partial file does not match checkpoint at offset" << offset;
+        return 0;
+    }
+
+    if (!QFile::resize(this->m_dataPath, offset))
+    {
+        qWarning() << "TransferCheckpoint: failed to truncate partial file to" << offset;
+        return 0;
+    }
+
+    this->m_totalSize = static_cast<qint64>(obj.value("total").toDouble(-1));
+    return offset;
+}
+
+bool TransferCheckpoint::Save(qint64 offset, qint64 totalSize)
+{
+    QJsonObject obj;
+    obj.insert("identity", this->m_identity);
+    obj.insert("offset", static_cast<double>(offset));
+    obj.insert("total", static_cast<double>(totalSize));
+    obj.insert("tail_sha1", QString::fromLatin1(this->tailHash(offset)));
+
+    // QSaveFile so a crash mid-write leaves the previous checkpoint intact
+    QSaveFile file(this->m_checkpointPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        return false;
+
+    this->m_totalSize = totalSize;
+    return true;
+}
+
+void TransferCheckpoint::Remove()
+{
+    QFile::remove(this->m_checkpointPath);
+}
+
+QByteArray TransferCheckpoint::tailHash(qint64 offset) const
+{
+    QFile file(this->m_dataPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    const qint64 start = qMax<qint64>(0, offset - TAIL_VERIFY_BYTES);
+    if (!file.seek(start))
+        return QByteArray();
+
+    const QByteArray tail = file.read(offset - start);
+    if (tail.size() != offset - start)
+        return QByteArray();
+
+    return QCryptographicHash::hash(tail, QCryptographicHash::Sha1).toHex();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRANSFERCHECKPOINT_H
+#define TRANSFERCHECKPOINT_H
+
+#include "../../xenlib_global.h"
+#include <QMap>
+#include <QString>
+
+/**
+ * @brief Sidecar record that lets an interrupted download pick up where it stopped.
+ *
+ * Stored as a small JSON file next to the partial download. It records which
+ * remote resource the partial belongs to, how many bytes of it are known to
+ * be on disk and a SHA-1 of the last few of those bytes, so a torn write or a
+ * file that was touched by something else is detected before resuming.
+ */
+class XENLIB_EXPORT TransferCheckpoint
+{
+    public:
+        /// Bytes immediately before the resume offset that are re-hashed on load.
+        static const qint64 TAIL_VERIFY_BYTES = 1024 * 1024;
+
+        /**
+         * @param dataPath  Partial download the checkpoint describes
+         * @param identity  Stable identity of the remote resource, see Identity()
+         */
+        TransferCheckpoint(const QString& dataPath, const QString& identity);
+
+        /**
+         * @brief Identity of a remote resource for resume matching.
+         *
+         * session_id and task_id change on every attempt and are left out;
+         * everything else that selects the content (host, path, uuid, format…)
+         * is kept.
+         */
+        static QString Identity(const QString& hostname,
+                                const QString& remotePath,
+                                const QMap<QString, QString>& queryParams);
+
+        /**
+         * @brief Validate the checkpoint against the partial file.
+         *
+         * On success the partial file is truncated to the checkpointed offset
+         * (dropping anything written after the last checkpoint) and that
+         * offset is returned. Returns 0 if there is no usable checkpoint.
+         */
+        qint64 Load();
+
+        /**
+         * @brief Record that the first @p offset bytes of the partial file are good.
+         *
+         * The data file must have been flushed up to @p offset.
+         * @param totalSize Full size of the resource, or -1 if unknown
+         */
+        bool Save(qint64 offset, qint64 totalSize);
+
+        /** @brief Delete the checkpoint file. */
+        void Remove();
+
+        /** @brief Total size recorded by the last Load() or Save(), or -1. */
+        qint64 TotalSize() const { return this->m_totalSize; }
+
+        QString FilePath() const { return this->m_checkpointPath; }
+
+    private:
+        QByteArray tailHash(qint64 offset) const;
+
+        QString m_dataPath;
+        QString m_checkpointPath;
+        QString m_identity;
+        qint64 m_totalSize = -1;
+};
+
+#endif // TRANSFERCHECKPOINT_H
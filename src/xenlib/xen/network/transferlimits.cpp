@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "transferlimits.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace
+{
+    const int WAIT_SLICE_MS = 100;
+
+    struct SlotState
+    {
+        QMutex mutex;
+        QWaitCondition released;
+        QHash<const void*, int> perConnection;
+        QHash<QString, int> perHost;
+        int maxPerConnection = TransferLimits::DEFAULT_MAX_TRANSFERS_PER_CONNECTION;
+        int maxPerHost = TransferLimits::DEFAULT_MAX_TRANSFERS_PER_HOST;
+    };
+
+    // Token bucket; tokens may go negative so one large write is paid off by
+    // the sleeps that follow it instead of never fitting the bucket.
+    struct BandwidthState
+    {
+        QMutex mutex;
+        std::atomic<qint64> bytesPerSecond { 0 };
+        double tokens = 0;
+        QElapsedTimer clock;
+    };
+
+    SlotState& slotState()
+    {
+        static SlotState state;
+        return state;
+    }
+
+    BandwidthState& bandwidthState()
+    {
+        static BandwidthState state;
+        return state;
+    }
+}
+
+int TransferLimits::GetMaxTransfersPerConnection()
+{
+    QMutexLocker locker(&slotState().mutex);
+    return slotState().maxPerConnection;
+}
+
+void TransferLimits::SetMaxTransfersPerConnection(int max)
+{
+    QMutexLocker locker(&slotState().mutex);
+    slotState().maxPerConnection = qMax(1, max);
+    slotState().released.wakeAll();
+}
+
+int TransferLimits::GetMaxTransfersPerHost()
+{
+    QMutexLocker locker(&slotState().mutex);
+    return slotState().maxPerHost;
+}
+
+void TransferLimits::SetMaxTransfersPerHost(int max)
+{
+    QMutexLocker locker(&slotState().mutex);
+    slotState().maxPerHost = qMax(1, max);
+    slotState().released.wakeAll();
+}
+
+qint64 TransferLimits::GetBandwidthLimit()
+{
+    return bandwidthState().bytesPerSecond.load();
+}
+
+void TransferLimits::SetBandwidthLimit(qint64 bytesPerSecond)
+{
+    QMutexLocker locker(&bandwidthState().mutex);
+    bandwidthState().bytesPerSecond = qMax<qint64>(0, bytesPerSecond);
+    bandwidthState().tokens = 0;
+    bandwidthState().clock.invalidate();
+}
+
+bool TransferLimits::AcquireSlot(const void* connectionKey, const QString& host, CancelCallback cancelled)
+{
+    SlotState& state = slotState();
+    QMutexLocker locker(&state.mutex);
+    while (state.perConnection.value(connectionKey) >= state.maxPerConnection ||
+           state.perHost.value(host) >= state.maxPerHost)
+    {
+        if (cancelled && cancelled())
+            return false;
+        state.released.wait(&state.mutex, WAIT_SLICE_MS);
+    }
+
+    ++state.perConnection[connectionKey];
+    ++state.perHost[host];
+    return true;
+}
+
+void TransferLimits::ReleaseSlot(const void* connectionKey, const QString& host)
+{
+    SlotState& state = slotState();
+    QMutexLocker locker(&state.mutex);
+    if (--state.perConnection[connectionKey] <= 0)
+        state.perConnection.remove(connectionKey);
+    if (--state.perHost[host] <= 0)
+        state.perHost.remove(host);
+    state.released.wakeAll();
+}
+
+bool TransferLimits::Throttle(qint64 bytes, CancelCallback cancelled)
+{
+    BandwidthState& state = bandwidthState();
+    if (state.bytesPerSecond.load(std::memory_order_relaxed) <= 0)
+        return true;
+
+    qint64 waitMs = 0;
+    {
+        QMutexLocker locker(&state.mutex);
+        const double rate = static_cast<double>(state.bytesPerSecond.load());
+        if (rate <= 0)
+            return true;
+
+        // Allow a quarter second of burst so short pauses are not penalised
+        const double burst = qMax(rate / 4.0, 64.0 * 1024.0);
+        if (!state.clock.isValid())
+        {
+            state.clock.start();
+            state.tokens = burst;
+        } else
+        {
+            const qint64 elapsedNs = state.clock.nsecsElapsed();
+            state.clock.restart();
+            state.tokens = qMin(burst, state.tokens + rate * (elapsedNs / 1e9));
+        }
+
+        state.tokens -= static_cast<double>(bytes);
+        if (state.tokens < 0)
+            waitMs = static_cast<qint64>(-state.tokens * 1000.0 / rate);
+    }
+
+    while (waitMs > 0)
+    {
+        if (cancelled && cancelled())
+            return false;
+        const qint64 slice = qMin<qint64>(waitMs, WAIT_SLICE_MS);
+        QThread::msleep(static_cast<unsigned long>(slice));
+        waitMs -= slice;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRANSFERLIMITS_H
+#define TRANSFERLIMITS_H
+
+#include "../../xenlib_global.h"
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Process-wide limits for bulk disk transfers (import/export).
+ *
+ * Holds the concurrency caps used by TransferBatch and the global bandwidth
+ * cap applied by HttpClient to every byte it moves. All methods are
+ * thread-safe; the limits may be changed while transfers are running.
+ */
+class XENLIB_EXPORT TransferLimits
+{
+    public:
+        using CancelCallback = std::function<bool()>;
+
+        static const int DEFAULT_MAX_TRANSFERS_PER_CONNECTION = 4;
+        static const int DEFAULT_MAX_TRANSFERS_PER_HOST = 4;
+
+        /** @brief Max disks moving at once over one XenConnection (all actions combined). */
+        static int GetMaxTransfersPerConnection();
+        static void SetMaxTransfersPerConnection(int max);
+
+        /** @brief Max disks moving at once to/from one host address, across connections. */
+        static int GetMaxTransfersPerHost();
+        static void SetMaxTransfersPerHost(int max);
+
+        /** @brief Aggregate transfer rate cap in bytes per second (0 = unlimited). */
+        static qint64 GetBandwidthLimit();
+        static void SetBandwidthLimit(qint64 bytesPerSecond);
+
+        /**
+         * @brief Block until a transfer slot is free for @p connectionKey and @p host.
+         * @return false if @p cancelled returned true while waiting
+         */
+        static bool AcquireSlot(const void* connectionKey, const QString& host, CancelCallback cancelled);
+
+        /** @brief Return a slot obtained by AcquireSlot(). */
+        static void ReleaseSlot(const void* connectionKey, const QString& host);
+
+        /**
+         * @brief Account @p bytes against the bandwidth cap, sleeping if over budget.
+         *
+         * Returns immediately when no cap is set.
+         * @return false if @p cancelled returned true while waiting
+         */
+        static bool Throttle(qint64 bytes, CancelCallback cancelled);
+
+    private:
+        TransferLimits() = delete;
+};
+
+#endif // TRANSFERLIMITS_H
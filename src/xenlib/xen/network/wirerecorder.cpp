@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "wirerecorder.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QUrl>
+
+namespace
+{
+    struct RecorderState
+    {
+        QMutex mutex;
+        QFile* file = nullptr;
+        QDataStream stream;
+        QElapsedTimer clock;
+        QHash<QString, QString> sessionPlaceholders;   ///< Real session ref → placeholder
+        int count = 0;
+    };
+
+    RecorderState& recorderState()
+    {
+        static RecorderState state;
+        return state;
+    }
+
+    // Parameter positions holding a password, after the session where there is one
+    const QHash<QString, QList<int>>& secretParams()
+    {
+        static const QHash<QString, QList<int>> params = {
+            {"session.login_with_password", {1}},
+            {"session.slave_local_login_with_password", {1}},
+            {"session.change_password", {1, 2}},
+            {"pool.join", {3}},
+            {"pool.join_force", {3}},
+            {"secret.set_value", {2}},
+        };
+        return params;
+    }
+
+    bool isLogin(const QString& method)
+    {
+        return method == "session.login_with_password" || method == "session.slave_local_login_with_password";
+    }
+
+    // Caller holds the mutex
+    QString placeholderFor(RecorderState& state, const QString& sessionRef)
+    {
+        auto it = state.sessionPlaceholders.constFind(sessionRef);
+        if (it != state.sessionPlaceholders.constEnd())
+            return it.value();
+
+        const QString placeholder = QString("OpaqueRef:redacted-session-%1").arg(state.sessionPlaceholders.size() + 1);
+        state.sessionPlaceholders.insert(sessionRef, placeholder);
+        return placeholder;
+    }
+
+    // Caller holds the mutex
+    QString mapSessionRef(const RecorderState& state, const QString& value)
+    {
+        return state.sessionPlaceholders.value(value, value);
+    }
+
+    // Passwords also travel inside maps, e.g. SR/PBD device_config or secret
+    // records, and known session refs wherever they are echoed back. A secret
+    // record keeps its password in a plain "value" field.
+    QJsonValue redactValue(RecorderState& state, const QJsonValue& value, bool secretRecord = false)
+    {
+        if (value.isString())
+            return mapSessionRef(state, value.toString());
+
+        if (value.isArray())
+        {
+            QJsonArray array = value.toArray();
+            for (int i = 0; i < array.size(); ++i)
+                array[i] = redactValue(state, array.at(i), secretRecord);
+            return array;
+        }
+
+        if (!value.isObject())
+            return value;
+
+        // event.from entries: {"class": ..., "ref": ..., "snapshot": {...}}
+        const QJsonObject object = value.toObject();
+        const QString eventClass = object.value("class").toString();
+
+        QJsonObject redacted;
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it)
+        {
+            const QString key = it.key().toLower();
+            QJsonValue field;
+            if (key.contains("password") || key.contains("secret") || (secretRecord && key == "value"))
+                field = WireRecorder::RedactedValue();
+            else if (eventClass == "session" && key == "ref" && it.value().toString().startsWith("OpaqueRef:"))
+                field = placeholderFor(state, it.value().toString());
+            else
+                field = redactValue(state, it.value(), secretRecord || (eventClass == "secret" && key == "snapshot"));
+            redacted.insert(mapSessionRef(state, it.key()), field);
+        }
+        return redacted;
+    }
+
+    QJsonValue redactResult(RecorderState& state, const QString& method, const QJsonValue& result)
+    {
+        if (method == "secret.get_value")
+            return WireRecorder::RedactedValue();
+
+        // Every ref these return is a session, including ones never seen in a request
+        if (method == "session.get_all" && result.isArray())
+        {
+            QJsonArray refs = result.toArray();
+            for (int i = 0; i < refs.size(); ++i)
+                refs[i] = placeholderFor(state, refs.at(i).toString());
+            return refs;
+        }
+        if (method == "session.get_all_records" && result.isObject())
+        {
+            const QJsonObject records = result.toObject();
+            for (auto it = records.constBegin(); it != records.constEnd(); ++it)
+                placeholderFor(state, it.key());
+        }
+
+        return redactValue(state, result, method.startsWith("secret."));
+    }
+
+    void redactJsonRpc(RecorderState& state, QByteArray& request, QByteArray& response)
+    {
+        const QJsonDocument requestDocument = QJsonDocument::fromJson(request);
+        if (!requestDocument.isObject())
+        {
+            request = QString("<%1: %2 bytes>").arg(WireRecorder::RedactedValue()).arg(request.size()).toUtf8();
+            response = QString("<%1: %2 bytes>").arg(WireRecorder::RedactedValue()).arg(response.size()).toUtf8();
+            return;
+        }
+
+        QJsonObject call = requestDocument.object();
+        const QString method = call.value("method").toString();
+        QJsonArray params = call.value("params").toArray();
+        const QList<int> secrets = secretParams().value(method);
+        for (int i = 0; i < params.size(); ++i)
+        {
+            if (secrets.contains(i))
+                params[i] = WireRecorder::RedactedValue();
+            else if (i == 0 && !isLogin(method) && params.at(0).toString().startsWith("OpaqueRef:"))
+                params[0] = placeholderFor(state, params.at(0).toString());
+            else
+                params[i] = redactValue(state, params.at(i));
+        }
+        call.insert("params", params);
+        request = QJsonDocument(call).toJson(QJsonDocument::Compact);
+
+        const QJsonDocument responseDocument = QJsonDocument::fromJson(response);
+        if (!responseDocument.isObject())
+        {
+            if (!response.isEmpty())
+                response = QString("<%1: %2 bytes>").arg(WireRecorder::RedactedValue()).arg(response.size()).toUtf8();
+            return;
+        }
+
+        QJsonObject reply = responseDocument.object();
+        if (!reply.contains("result"))
+            return;
+
+        if (isLogin(method) && reply.value("result").isString())
+            reply.insert("result", placeholderFor(state, reply.value("result").toString()));
+        else
+            reply.insert("result", redactResult(state, method, reply.value("result")));
+        response = QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    }
+
+    void redactHttp(RecorderState& state, QByteArray& request)
+    {
+        static const QRegularExpression sessionParam("([?&]session_id=)([^&\\s]*)");
+        static const QRegularExpression secretHeader("^(authorization|proxy-authorization|cookie):.*$",
+                                                     QRegularExpression::CaseInsensitiveOption |
+                                                         QRegularExpression::MultilineOption);
+
+        QString text = QString::fromLatin1(request);
+        QRegularExpressionMatch match;
+        int from = 0;
+        while ((match = sessionParam.match(text, from)).hasMatch())
+        {
+            const QString ref = QUrl::fromPercentEncoding(match.captured(2).toLatin1());
+            const QString replacement = match.captured(1) + QString::fromLatin1(QUrl::toPercentEncoding(placeholderFor(state, ref)));
+            text.replace(match.capturedStart(), match.capturedLength(), replacement);
+            from = match.capturedStart() + replacement.size();
+        }
+        text.replace(secretHeader, "\\1: " + WireRecorder::RedactedValue());
+        request = text.toLatin1();
+    }
+
+    void writePayload(QDataStream& stream, const QByteArray& payload)
+    {
+        const bool compress = payload.size() >= WireRecorder::COMPRESS_THRESHOLD;
+        stream << quint8(compress ? 1 : 0) << (compress ? qCompress(payload) : payload);
+    }
+}
+
+bool WireRecorder::Start(const QString& path, QString* error)
+{
+    RecorderState& state = recorderState();
+    QMutexLocker locker(&state.mutex);
+
+    QFile* file = new QFile(path);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if (error)
+            *error = QString("Cannot create %1: %2").arg(path, file->errorString());
+        delete file;
+        return false;
+    }
+
+    if (state.file)
+    {
+        state.file->close();
+        delete state.file;
+    }
+
+    state.file = file;
+    state.stream.setDevice(file);
+    state.stream.setVersion(QDataStream::Qt_6_0);
+    state.stream << FILE_MAGIC << FILE_VERSION << QDateTime::currentDateTimeUtc();
+    state.file->flush();
+    state.clock.start();
+    state.sessionPlaceholders.clear();
+    state.count = 0;
+
+    qDebug() << "WireRecorder: recording xapi traffic to" << path;
+    return true;
+}
+
+void WireRecorder::Stop()
+{
+    RecorderState& state = recorderState();
+    QMutexLocker locker(&state.mutex);
+    if (!state.file)
+        return;
+
+    state.stream.setDevice(nullptr);
+    state.file->close();
+    delete state.file;
+    state.file = nullptr;
+    state.sessionPlaceholders.clear();
+}
+
+bool WireRecorder::IsRecording()
+{
+    RecorderState& state = recorderState();
+    QMutexLocker locker(&state.mutex);
+    return state.file != nullptr;
+}
+
+int WireRecorder::GetRecordedCount()
+{
+    RecorderState& state = recorderState();
+    QMutexLocker locker(&state.mutex);
+    return state.count;
+}
+
+void WireRecorder::Record(WireExchange::Channel channel,
+                          const QString& endpoint,
+                          const QByteArray& request,
+                          const QByteArray& response,
+                          qint64 durationUs)
+{
+    RecorderState& state = recorderState();
+    QMutexLocker locker(&state.mutex);
+    if (!state.file)
+        return;
+
+    QByteArray redactedRequest = request;
+    QByteArray redactedResponse = response;
+    if (channel == WireExchange::Channel::JsonRpc)
+        redactJsonRpc(state, redactedRequest, redactedResponse);
+    else
+        redactHttp(state, redactedRequest);
+
+    const qint64 startUs = qMax<qint64>(0, state.clock.nsecsElapsed() / 1000 - durationUs);
+    state.stream << quint8(channel) << startUs << durationUs << endpoint;
+    writePayload(state.stream, redactedRequest);
+    writePayload(state.stream, redactedResponse);
+
+    // Keep the file usable if the client crashes or hangs mid-session
+    state.file->flush();
+    ++state.count;
+}
+
+QString WireRecorder::RedactedValue()
+{
+    return QStringLiteral("redacted");
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WIRERECORDER_H
+#define WIRERECORDER_H
+
+#include "../../xenlib_global.h"
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief One request/response pair captured by WireRecorder.
+ */
+struct XENLIB_EXPORT WireExchange
+{
+    enum class Channel : quint8
+    {
+        JsonRpc = 0,   ///< API call sent by ConnectionWorker
+        Http = 1       ///< HttpClient request; headers only, bulk bodies are not kept
+    };
+
+    Channel channel = Channel::JsonRpc;
+    qint64 startUs = 0;      ///< Request start, relative to the start of the recording
+    qint64 durationUs = 0;   ///< Time until the response was complete
+    QString endpoint;        ///< "host:port" the request went to
+    QByteArray request;
+    QByteArray response;
+};
+
+/**
+ * @brief Opt-in, process-wide recorder of the traffic to xapi.
+ *
+ * While recording, ConnectionWorker logs every JSON-RPC call and HttpClient
+ * the request and status of every transfer, with timings, so a slow pool can
+ * be replayed offline by WireReplay.
+ *
+ * Credentials never reach the file: passwords in login and similar calls are
+ * replaced, as are password and secret fields in both parameters and results
+ * (device_config, secret records); session references are mapped to stable
+ * placeholders wherever they appear and session_id query parameters and
+ * authorization headers are masked. Bodies that are not JSON are reduced to
+ * their size.
+ *
+ * The file is a QDataStream of a header followed by one entry per exchange,
+ * with larger payloads zlib-compressed. All methods are thread-safe.
+ */
+class XENLIB_EXPORT WireRecorder
+{
+    public:
+        static const quint32 FILE_MAGIC = 0x58415752;   // "XAWR"
+        static const quint16 FILE_VERSION = 1;
+        static const int COMPRESS_THRESHOLD = 256;
+
+        /**
+         * @brief Start writing a new recording to @p path, replacing any current one.
+         * @return false with @p error set if the file cannot be created
+         */
+        static bool Start(const QString& path, QString* error = nullptr);
+
+        /** @brief Flush and close the current recording. */
+        static void Stop();
+
+        static bool IsRecording();
+
+        /** @brief Exchanges written since Start(). */
+        static int GetRecordedCount();
+
+        /**
+         * @brief Redact and append one exchange that took @p durationUs and just finished.
+         *
+         * Does nothing unless recording.
+         */
+        static void Record(WireExchange::Channel channel,
+                           const QString& endpoint,
+                           const QByteArray& request,
+                           const QByteArray& response,
+                           qint64 durationUs);
+
+        /** @brief Marker that replaces anything secret in a recording. */
+        static QString RedactedValue();
+
+    private:
+        WireRecorder() = delete;
+};
+
+#endif // WIRERECORDER_H
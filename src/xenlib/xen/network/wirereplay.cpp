@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "wirereplay.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace
+{
+    const int WAIT_SLICE_MS = 50;
+
+    struct InstalledReplay
+    {
+        QMutex mutex;
+        QSharedPointer<WireReplay> replay;
+    };
+
+    InstalledReplay& installedReplay()
+    {
+        static InstalledReplay installed;
+        return installed;
+    }
+
+    bool isLogin(const QString& method)
+    {
+        return method == "session.login_with_password" || method == "session.slave_local_login_with_password";
+    }
+
+    // Session refs differ between runs and passwords are redacted in the file,
+    // so neither takes part in matching
+    QString matchKey(const QString& method, const QJsonArray& params)
+    {
+        if (isLogin(method))
+            return params.at(0).toString();
+        QJsonArray rest = params;
+        if (!rest.isEmpty())
+            rest.removeFirst();
+        return QString::fromUtf8(QJsonDocument(rest).toJson(QJsonDocument::Compact));
+    }
+
+    bool readPayload(QDataStream& stream, QByteArray* payload)
+    {
+        quint8 compressed = 0;
+        QByteArray data;
+        stream >> compressed >> data;
+        *payload = compressed ? qUncompress(data) : data;
+        return stream.status() == QDataStream::Ok && (!compressed || !payload->isEmpty() || data.isEmpty());
+    }
+
+    // Sleeps in slices so a stopping connection is not held up
+    void waitUntil(const QElapsedTimer& clock, qint64 dueUs, const std::function<bool()>& cancelled)
+    {
+        while (!(cancelled && cancelled()))
+        {
+            const qint64 remainingUs = dueUs - clock.nsecsElapsed() / 1000;
+            if (remainingUs <= 0)
+                return;
+            QThread::usleep(qMin<qint64>(remainingUs, WAIT_SLICE_MS * 1000));
+        }
+    }
+}
+
+class WireReplay::Private
+{
+    public:
+        mutable QMutex mutex;
+        QList<WireExchange> exchanges;
+        QList<QString> keys;                      ///< matchKey() per exchange
+        QHash<QString, QList<int>> pending;       ///< Method → unused exchange indices in order
+        int remaining = 0;
+        int misses = 0;
+        double speed = 1.0;
+        QElapsedTimer clock;                      ///< Started by the first Respond()
+};
+
+WireReplay::WireReplay() : d(new Private())
+{
+}
+
+WireReplay::~WireReplay()
+{
+    delete this->d;
+}
+
+bool WireReplay::Load(const QString& path, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(QString("Cannot open %1: %2").arg(path, file.errorString()));
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    QDateTime started;
+    stream >> magic >> version >> started;
+    if (stream.status() != QDataStream::Ok || magic != WireRecorder::FILE_MAGIC)
+        return fail(QString("%1 is not a wire recording").arg(path));
+    if (version > WireRecorder::FILE_VERSION)
+        return fail(QString("%1 was written by a newer version (format %2)").arg(path).arg(version));
+
+    QList<WireExchange> exchanges;
+    while (!stream.atEnd())
+    {
+        WireExchange exchange;
+        quint8 channel = 0;
+        stream >> channel >> exchange.startUs >> exchange.durationUs >> exchange.endpoint;
+        if (!readPayload(stream, &exchange.request) || !readPayload(stream, &exchange.response))
+        {
+            // A recording cut short by a crash still replays up to the damage
+            qWarning() << "WireReplay: truncated recording" << path << "after" << exchanges.size() << "exchanges";
+            break;
+        }
+        exchange.channel = static_cast<WireExchange::Channel>(channel);
+        exchanges.append(exchange);
+    }
+
+    QMutexLocker locker(&this->d->mutex);
+    this->d->exchanges = exchanges;
+    this->d->keys.clear();
+    this->d->pending.clear();
+    this->d->remaining = 0;
+    this->d->misses = 0;
+    this->d->clock.invalidate();
+    for (int i = 0; i < exchanges.size(); ++i)
+    {
+        QString key;
+        if (exchanges.at(i).channel == WireExchange::Channel::JsonRpc)
+        {
+            const QJsonObject call = QJsonDocument::fromJson(exchanges.at(i).request).object();
+            const QString method = call.value("method").toString();
+            key = matchKey(method, call.value("params").toArray());
+            if (!method.isEmpty())
+            {
+                this->d->pending[method].append(i);
+                ++this->d->remaining;
+            }
+        }
+        this->d->keys.append(key);
+    }
+
+    if (error)
+        error->clear();
+    return true;
+}
+
+void WireReplay::SetSpeed(double speed)
+{
+    QMutexLocker locker(&this->d->mutex);
+    this->d->speed = qMax(0.0, speed);
+}
+
+double WireReplay::GetSpeed() const
+{
+    QMutexLocker locker(&this->d->mutex);
+    return this->d->speed;
+}
+
+QByteArray WireReplay::Respond(const QByteArray& request, const std::function<bool()>& cancelled)
+{
+    const QJsonObject call = QJsonDocument::fromJson(request).object();
+    const QString method = call.value("method").toString();
+    const QJsonArray params = call.value("params").toArray();
+    const QString key = matchKey(method, params);
+
+    QMutexLocker locker(&this->d->mutex);
+    if (!this->d->clock.isValid())
+        this->d->clock.start();
+    const double speed = this->d->speed;
+
+    QList<int>& candidates = this->d->pending[method];
+    int chosen = -1;
+    for (int i = 0; i < candidates.size() && chosen < 0; ++i)
+    {
+        if (this->d->keys.at(candidates.at(i)) == key)
+            chosen = i;
+    }
+    if (chosen < 0 && !candidates.isEmpty())
+        chosen = 0;
+
+    QJsonObject reply;
+    if (chosen < 0)
+    {
+        if (method != "event.from")
+        {
+            ++this->d->misses;
+            return QByteArray();
+        }
+        locker.unlock();
+
+        // Recording exhausted: behave like a pool with nothing happening
+        const qint64 timeoutUs = qint64(params.at(3).toDouble() * 1000000);
+        QElapsedTimer waited;
+        waited.start();
+        waitUntil(waited, speed > 0 ? qint64(timeoutUs / speed) : timeoutUs, cancelled);
+        reply.insert("jsonrpc", "2.0");
+        reply.insert("result", QJsonObject{
+            {"events", QJsonArray()},
+            {"valid_ref_counts", QJsonObject()},
+            {"token", params.at(2)},
+        });
+    } else
+    {
+        const WireExchange exchange = this->d->exchanges.at(candidates.takeAt(chosen));
+        --this->d->remaining;
+        const QElapsedTimer clock = this->d->clock;
+        locker.unlock();
+
+        if (speed > 0)
+            waitUntil(clock, qint64((exchange.startUs + exchange.durationUs) / speed), cancelled);
+
+        const QJsonDocument recorded = QJsonDocument::fromJson(exchange.response);
+        if (!recorded.isObject())
+            return exchange.response;
+        reply = recorded.object();
+    }
+
+    reply.insert("id", call.value("id"));
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+QList<WireExchange> WireReplay::GetExchanges() const
+{
+    QMutexLocker locker(&this->d->mutex);
+    return this->d->exchanges;
+}
+
+int WireReplay::GetRemainingCount() const
+{
+    QMutexLocker locker(&this->d->mutex);
+    return this->d->remaining;
+}
+
+int WireReplay::GetMissCount() const
+{
+    QMutexLocker locker(&this->d->mutex);
+    return this->d->misses;
+}
+
+void WireReplay::Install(const QSharedPointer<WireReplay>& replay)
+{
+    InstalledReplay& installed = installedReplay();
+    QMutexLocker locker(&installed.mutex);
+    installed.replay = replay;
+}
+
+QSharedPointer<WireReplay> WireReplay::GetInstalled()
+{
+    InstalledReplay& installed = installedReplay();
+    QMutexLocker locker(&installed.mutex);
+    return installed.replay;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WIREREPLAY_H
+#define WIREREPLAY_H
+
+#include "../../xenlib_global.h"
+#include "wirerecorder.h"
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Answers JSON-RPC calls from a WireRecorder file instead of a host.
+ *
+ * Once installed with Install(), every ConnectionWorker created afterwards
+ * skips the network and hands its requests to Respond(), so XenConnection,
+ * the event poller and XenCache run against the recorded session exactly as
+ * they did in the field. Requests are matched to recorded calls of the same
+ * method and parameters (the session argument is ignored), falling back to
+ * the next unused call of the same method. Each reply is held back until its
+ * recorded completion time divided by the replay speed.
+ *
+ * Once the recorded event.from calls run out, further ones wait for their
+ * timeout and return no events, like a quiet pool.
+ *
+ * HTTP exchanges in the file are available through GetExchanges() for
+ * analysis but are not replayed.
+ *
+ * Respond() is thread-safe.
+ */
+class XENLIB_EXPORT WireReplay
+{
+    public:
+        WireReplay();
+        ~WireReplay();
+
+        /**
+         * @brief Read a recording made by WireRecorder.
+         * @return false with @p error set if the file is missing or malformed
+         */
+        bool Load(const QString& path, QString* error = nullptr);
+
+        /**
+         * @brief Replay speed: 1 keeps recorded timing, 10 is ten times faster
+         *        and 0 answers as soon as possible.
+         */
+        void SetSpeed(double speed);
+        double GetSpeed() const;
+
+        /**
+         * @brief Answer one JSON-RPC request.
+         * @param cancelled Polled while a reply is held back
+         * @return Recorded response with the request's id, or empty if no
+         *         recorded call matches
+         */
+        QByteArray Respond(const QByteArray& request, const std::function<bool()>& cancelled = std::function<bool()>());
+
+        QList<WireExchange> GetExchanges() const;
+
+        /** @brief Recorded JSON-RPC calls not yet used by Respond(). */
+        int GetRemainingCount() const;
+
+        /** @brief Requests Respond() could not match. */
+        int GetMissCount() const;
+
+        /** @brief Route new connections through @p replay; a null pointer restores the network. */
+        static void Install(const QSharedPointer<WireReplay>& replay);
+        static QSharedPointer<WireReplay> GetInstalled();
+
+    private:
+        class Private;
+        Private* d;
+
+        Q_DISABLE_COPY(WireReplay)
+};
+
+#endif // WIREREPLAY_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "xenapi_Message.h"
+#include "../api.h"
+#include "../session.h"
+#include "../failure.h"
+#include <stdexcept>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace XenAPI
+{
+    namespace
+    {
+        // message.destroy returns nothing, so failures have to be read off the raw reply
+        void throwOnFailure(const QByteArray& response)
+        {
+            const QJsonObject root = QJsonDocument::fromJson(response).object();
+            QStringList errors;
+
+            const QJsonObject result = root.value("result").toObject();
+            if (result.value("Status").toString() == "Failure")
+            {
+                for (const QJsonValue& val : result.value("ErrorDescription").toArray())
+                    errors << val.toString();
+            } else if (root.contains("error"))
+            {
+                const QJsonObject error = root.value("error").toObject();
+                errors << error.value("message").toString();
+                for (const QJsonValue& val : error.value("data").toArray())
+                    errors << val.toVariant().toString();
+            }
+
+            if (!errors.isEmpty())
+                throw Failure(errors);
+        }
+    }
+
+    void Message::destroy(Session* session, const QString& message)
+    {
+        if (!session || !session->IsLoggedIn())
+            throw std::runtime_error("Not connected to XenServer");
+
+        QVariantList params;
+        params << session->GetSessionID() << message;
+
+        XenRpcAPI api(session);
+        QByteArray request = api.BuildJsonRpcCall("message.destroy", params);
+        QByteArray response = session->SendApiRequest(request);
+        if (response.isEmpty())
+            throw std::runtime_error("Empty response from server");
+        throwOnFailure(response);
+    }
+
+} // namespace XenAPI
@@ -59,8 +59,13 @@
 #include "xen/vif.h"
 #include "xen/vlan.h"
 #include "xen/vm.h"
+#include "utils/memoryaccountant.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMetaObject>
 #include <QMutexLocker>
+#include <QSet>
+#include <QWaitCondition>
 
 namespace XenLib
 {
@@ -72,6 +77,170 @@ namespace XenLib
 
 XenCache *XenCache::dummyCache = nullptr;
 
+struct XenCache::Waiter
+{
+    QList<XenObjectType> types;
+    QSet<QString> refs;
+    bool signalled = false;
+    QSet<QString> changed;      // Refs seen since the condition last ran
+    bool everything = false;    // A Clear or bulk update came in meanwhile
+    QWaitCondition condition;
+};
+
+struct XenCache::Subscription
+{
+    int id = 0;
+    QPointer<QObject> receiver;
+    XenObjectType type = XenObjectType::Null;
+    QString ref; // empty for whole-type subscriptions
+    QStringList fields;
+    XenCache::ChangeCallback callback;
+
+    // Changes collected since the last flush, coalesced per ref in arrival order
+    QHash<QString, XenCacheChange> pending;
+    QStringList pendingOrder;
+};
+
+namespace
+{
+    // Values interned through m_strings share their buffer with the copy
+    // already cached, so most equal strings are found by pointer alone
+    bool sameString(const QString& a, const QString& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        return a.constData() == b.constData() || a == b;
+    }
+
+    // Cheap checks come first: containers still sharing their data (a record
+    // resent untouched, an interned string) are equal without a walk, and
+    // containers of different size differ. Everything else is compared
+    // element by element; there is no hashing.
+    bool sameValue(const QVariant& a, const QVariant& b)
+    {
+        if (a.metaType() != b.metaType())
+            return a == b;
+
+        switch (a.typeId())
+        {
+            case QMetaType::QString:
+                return sameString(*static_cast<const QString*>(a.constData()),
+                                  *static_cast<const QString*>(b.constData()));
+            case QMetaType::QVariantMap:
+            {
+                const QVariantMap& left = *static_cast<const QVariantMap*>(a.constData());
+                const QVariantMap& right = *static_cast<const QVariantMap*>(b.constData());
+                if (left.isSharedWith(right))
+                    return true;
+                if (left.size() != right.size())
+                    return false;
+                for (auto l = left.constBegin(), r = right.constBegin(); l != left.constEnd(); ++l, ++r)
+                {
+                    if (!sameString(l.key(), r.key()) || !sameValue(l.value(), r.value()))
+                        return false;
+                }
+                return true;
+            }
+            case QMetaType::QVariantList:
+            {
+                const QVariantList& left = *static_cast<const QVariantList*>(a.constData());
+                const QVariantList& right = *static_cast<const QVariantList*>(b.constData());
+                if (left.isSharedWith(right))
+                    return true;
+                if (left.size() != right.size())
+                    return false;
+                for (qsizetype i = 0; i < left.size(); ++i)
+                {
+                    if (!sameValue(left.at(i), right.at(i)))
+                        return false;
+                }
+                return true;
+            }
+            case QMetaType::QStringList:
+            {
+                const QStringList& left = *static_cast<const QStringList*>(a.constData());
+                const QStringList& right = *static_cast<const QStringList*>(b.constData());
+                if (left.isSharedWith(right))
+                    return true;
+                if (left.size() != right.size())
+                    return false;
+                for (qsizetype i = 0; i < left.size(); ++i)
+                {
+                    if (!sameString(left.at(i), right.at(i)))
+                        return false;
+                }
+                return true;
+            }
+            default:
+                return a == b;
+        }
+    }
+
+    // Rough per-node cost of a QMap entry on top of its key and value
+    const qint64 MAP_NODE_OVERHEAD = 32;
+
+    qint64 stringBytes(const QString& string, QSet<const void*>& seen)
+    {
+        // Shared buffers (interned strings) are counted once
+        if (string.isEmpty() || seen.contains(string.constData()))
+            return 0;
+        seen.insert(string.constData());
+        return 16 + (string.capacity() + 1) * qint64(sizeof(QChar));
+    }
+
+    qint64 variantBytes(const QVariant& value, QSet<const void*>& seen);
+
+    qint64 mapBytes(const QVariantMap& map, QSet<const void*>& seen)
+    {
+        qint64 bytes = 0;
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+            bytes += MAP_NODE_OVERHEAD + qint64(sizeof(QString)) + stringBytes(it.key(), seen) + variantBytes(it.value(), seen);
+        return bytes;
+    }
+
+    qint64 variantBytes(const QVariant& value, QSet<const void*>& seen)
+    {
+        qint64 bytes = sizeof(QVariant);
+        switch (value.typeId())
+        {
+            case QMetaType::QString:
+                bytes += stringBytes(*static_cast<const QString*>(value.constData()), seen);
+                break;
+            case QMetaType::QVariantMap:
+                bytes += mapBytes(*static_cast<const QVariantMap*>(value.constData()), seen);
+                break;
+            case QMetaType::QVariantList:
+            {
+                const QVariantList& list = *static_cast<const QVariantList*>(value.constData());
+                for (const QVariant& item : list)
+                    bytes += variantBytes(item, seen);
+                break;
+            }
+            case QMetaType::QStringList:
+            {
+                const QStringList& list = *static_cast<const QStringList*>(value.constData());
+                for (const QString& item : list)
+                    bytes += qint64(sizeof(QString)) + stringBytes(item, seen);
+                break;
+            }
+            default:
+                break;
+        }
+        return bytes;
+    }
+
+    QStringList maskedFields(const QStringList& mask, const QStringList& changed)
+    {
+        QStringList fields;
+        for (const QString& field : mask)
+        {
+            if (changed.contains(field))
+                fields.append(field);
+        }
+        return fields;
+    }
+}
+
 XenCache *XenCache::GetDummy()
 {
     if (!XenCache::dummyCache)
@@ -82,10 +251,35 @@ XenCache *XenCache::GetDummy()
 XenCache::XenCache(XenConnection* connection) : QObject(connection)
 {
     this->m_connection = connection;
+
+    if (connection)
+    {
+        MemoryAccountant* memory = MemoryAccountant::instance();
+        memory->Register(connection, MemoryAccountant::CACHE_RECORDS, this, [this]()
+        {
+            MemoryAccountant::Size size;
+            size.bytes = this->RecordBytes();
+            return size;
+        });
+        memory->Register(connection, MemoryAccountant::OBJECT_SHELLS, this, [this]()
+        {
+            MemoryAccountant::Size size;
+            size.bytes = this->ObjectBytes();
+            return size;
+        });
+    }
 }
 
 XenCache::~XenCache()
 {
+    {
+        QMutexLocker locker(&this->m_subscriptionMutex);
+        qDeleteAll(this->m_subscriptions);
+        this->m_subscriptions.clear();
+        this->m_objectSubscribers.clear();
+        this->m_typeSubscribers.clear();
+        this->m_pendingSubscriptions.clear();
+    }
     this->Clear();
 }
 
@@ -101,12 +295,13 @@ QVariantMap XenCache::ResolveObjectData(const QString& type, const QString& ref)
         return QVariantMap();
     }
 
-    QMutexLocker locker(&this->m_mutex);
-
     XenObjectType normalizedType = XenObject::TypeFromString(type);
     if (normalizedType == XenObjectType::Null)
         return QVariantMap();
 
+    this->demand(normalizedType);
+    QMutexLocker locker(&this->m_mutex);
+
     if (!this->m_cache.contains(normalizedType))
     {
         return QVariantMap();
@@ -126,6 +321,7 @@ QVariantMap XenCache::ResolveObjectData(XenObjectType type, const QString& ref)
     if (ref.isEmpty() || type == XenObjectType::Null)
         return QVariantMap();
 
+    this->demand(type);
     QMutexLocker locker(&this->m_mutex);
 
     if (!this->m_cache.contains(type))
@@ -147,6 +343,7 @@ QSharedPointer<XenObject> XenCache::ResolveObject(const QString& type, const QSt
     if (normalizedType == XenObjectType::Null)
         return QSharedPointer<XenObject>();
 
+    this->demand(normalizedType);
     QMutexLocker locker(&this->m_mutex);
 
     if (this->m_objects.contains(normalizedType))
@@ -178,6 +375,7 @@ QSharedPointer<XenObject> XenCache::ResolveObject(XenObjectType type, const QStr
     if (ref.isEmpty() || type == XenObjectType::Null)
         return QSharedPointer<XenObject>();
 
+    this->demand(type);
     QMutexLocker locker(&this->m_mutex);
 
     if (this->m_objects.contains(type))
@@ -205,14 +403,12 @@ QSharedPointer<XenObject> XenCache::ResolveObject(XenObjectType type, const QStr
 // that was looked up explicitly, while m_cache contains everything
 bool XenCache::Contains(XenObjectType type, const QString &ref) const
 {
-    if (ref.isEmpty())
+    if (ref.isEmpty() || type == XenObjectType::Null)
         return false;
 
+    this->demand(type);
     QMutexLocker locker(&this->m_mutex);
 
-    if (type == XenObjectType::Null)
-        return false;
-
     if (!this->m_cache.contains(type))
         return false;
 
@@ -226,11 +422,12 @@ QList<QVariantMap> XenCache::GetAllData(const QString& type) const
 
 QList<QVariantMap> XenCache::GetAllData(XenObjectType type) const
 {
-    QMutexLocker locker(&this->m_mutex);
-
     if (type == XenObjectType::Null)
         return QList<QVariantMap>();
 
+    this->demand(type);
+    QMutexLocker locker(&this->m_mutex);
+
     if (!this->m_cache.contains(type))
         return QList<QVariantMap>();
 
@@ -260,11 +457,12 @@ QList<QSharedPointer<XenObject> > XenCache::GetAll(XenObjectType type)
 
 QStringList XenCache::GetAllRefs(XenObjectType type) const
 {
-    QMutexLocker locker(&this->m_mutex);
-
     if (type == XenObjectType::Null)
         return QStringList();
 
+    this->demand(type);
+    QMutexLocker locker(&this->m_mutex);
+
     if (!this->m_cache.contains(type))
         return QStringList();
 
@@ -326,6 +524,35 @@ QList<QPair<XenObjectType, QString>> XenCache::GetXenSearchableObjects() const
     return allObjects;
 }
 
+QStringList XenCache::DiffRecords(const QVariantMap& before, const QVariantMap& after)
+{
+    // Both maps are key-ordered, so one merged walk finds added, removed and changed keys
+    QStringList changed;
+    if (before.isSharedWith(after))
+        return changed;
+    auto b = before.constBegin();
+    auto a = after.constBegin();
+    while (b != before.constEnd() || a != after.constEnd())
+    {
+        if (a == after.constEnd() || (b != before.constEnd() && b.key() < a.key()))
+        {
+            changed.append(b.key());
+            ++b;
+        } else if (b == before.constEnd() || a.key() < b.key())
+        {
+            changed.append(a.key());
+            ++a;
+        } else
+        {
+            if (!sameValue(b.value(), a.value()))
+                changed.append(a.key());
+            ++a;
+            ++b;
+        }
+    }
+    return changed;
+}
+
 void XenCache::Update(XenObjectType type, const QString &ref, const QVariantMap &data)
 {
     if (ref.isEmpty())
@@ -338,24 +565,44 @@ void XenCache::Update(XenObjectType type, const QString &ref, const QVariantMap
         return;
 
     bool refresh = false;
+    bool existed = false;
+    QStringList changed;
+    const bool intern = this->m_internStrings.loadRelaxed();
+    const QString key = intern ? this->m_strings.Intern(ref) : ref;
+    QVariantMap dataWithRef = intern ? this->m_strings.Intern(data) : data;
+
+    // Ensure ref is in the data
+    if (!dataWithRef.contains("ref"))
+        dataWithRef["ref"] = key;
+
     {
         QMutexLocker locker(&this->m_mutex);
 
-        if (!this->m_cache.contains(type))
-            this->m_cache[type] = QMap<QString, QVariantMap>();
+        QMap<QString, QVariantMap>& records = this->m_cache[type];
 
-               // Ensure ref is in the data
-        QVariantMap dataWithRef = data;
-        if (!dataWithRef.contains("ref"))
-            dataWithRef["ref"] = ref;
-
-        this->m_cache[type][ref] = dataWithRef;
+        auto it = records.find(key);
+        existed = it != records.end();
+        if (existed)
+        {
+            // Events often resend a record unchanged; nobody needs to hear about those
+            changed = XenCache::DiffRecords(it.value(), dataWithRef);
+            if (changed.isEmpty())
+                return;
+            it.value() = dataWithRef;
+        } else
+        {
+            changed = dataWithRef.keys();
+            records.insert(key, dataWithRef);
+        }
         refresh = this->m_objects.contains(type) && this->m_objects[type].contains(ref);
     }
 
     if (refresh)
         this->refreshObject(type, ref);
 
+    this->wakeWaiters(type, ref);
+    this->queueChange(type, ref, changed, !existed, false);
+
     QSharedPointer<XenObject> object = this->ResolveObject(type, ref);
     emit this->objectChanged(object);
     emit itemChanged(this->m_connection, type, ref);
@@ -367,24 +614,50 @@ void XenCache::UpdateBulk(XenObjectType type, const QVariantMap &allRecords)
         return;
     int updateCount = 0;
     QStringList refreshedRefs;
+    QStringList changedRefs;
+    QList<QStringList> changedFields;
+    QList<bool> added;
+    const bool notify = this->SubscriptionCount() > 0;
+    const bool intern = this->m_internStrings.loadRelaxed();
 
     {
         QMutexLocker locker(&this->m_mutex);
 
-        if (!this->m_cache.contains(type))
-            this->m_cache[type] = QMap<QString, QVariantMap>();
+        QMap<QString, QVariantMap>& records = this->m_cache[type];
 
         // Iterate through all records and add to cache
         for (auto it = allRecords.constBegin(); it != allRecords.constEnd(); ++it)
         {
-            QString ref = it.key();
-            QVariantMap data = it.value().toMap();
+            QString ref = intern ? this->m_strings.Intern(it.key()) : it.key();
+            QVariantMap data = intern ? this->m_strings.Intern(it.value().toMap()) : it.value().toMap();
 
             // Ensure ref is in the data
             if (!data.contains("ref"))
                 data["ref"] = ref;
 
-            this->m_cache[type][ref] = data;
+            auto old = records.find(ref);
+            const bool existed = old != records.end();
+            QStringList changed;
+            if (existed)
+            {
+                changed = XenCache::DiffRecords(old.value(), data);
+                if (changed.isEmpty())
+                    continue;
+                old.value() = data;
+            } else
+            {
+                if (notify)
+                    changed = data.keys();
+                records.insert(ref, data);
+            }
+
+            if (notify)
+            {
+                changedRefs.append(ref);
+                changedFields.append(changed);
+                added.append(!existed);
+            }
+
             if (this->m_objects.contains(type) && this->m_objects[type].contains(ref))
                 refreshedRefs.append(ref);
             updateCount++;
@@ -394,6 +667,11 @@ void XenCache::UpdateBulk(XenObjectType type, const QVariantMap &allRecords)
     for (const QString& ref : refreshedRefs)
         refreshObject(type, ref);
 
+    this->wakeWaiters(type, QString());
+
+    for (int i = 0; i < changedRefs.size(); ++i)
+        this->queueChange(type, changedRefs.at(i), changedFields.at(i), added.at(i), false);
+
     qDebug() << "XenCache: Bulk update completed for" << XenObject::TypeToString(type)
              << "- added/updated" << updateCount << "objects";
 
@@ -409,6 +687,7 @@ void XenCache::Remove(XenObjectType type, const QString &ref)
         return;
 
     QSharedPointer<XenObject> object = this->ResolveObject(type, ref);
+    QVariantMap before;
 
     {
         QMutexLocker locker(&this->m_mutex);
@@ -416,10 +695,12 @@ void XenCache::Remove(XenObjectType type, const QString &ref)
         if (!this->m_cache.contains(type))
             return;
 
-        this->m_cache[type].remove(ref);
+        before = this->m_cache[type].take(ref);
     }
 
     this->evictObject(type, ref);
+    this->wakeWaiters(type, ref);
+    this->queueChange(type, ref, before.keys(), true, true);
     emit this->objectRemoved(object);
     emit itemRemoved(this->m_connection, type, ref);
 }
@@ -443,7 +724,12 @@ void XenCache::ClearType(XenObjectType type)
     }
 
     for (const QString& ref : refs)
+    {
         this->evictObject(type, ref);
+        this->queueChange(type, ref, QStringList(), true, true);
+    }
+
+    this->wakeWaiters(type, QString());
 
     if (count > 0)
     {
@@ -468,7 +754,14 @@ void XenCache::Clear()
     }
 
     for (const auto& entry : refs)
+    {
         this->evictObject(entry.first, entry.second);
+        this->queueChange(entry.first, entry.second, QStringList(), true, true);
+    }
+
+    this->wakeWaiters(XenObjectType::Null, QString());
+
+    this->m_strings.Clear();
 
     qDebug() << "XenCache: Cache cleared";
     emit cacheCleared();
@@ -476,10 +769,12 @@ void XenCache::Clear()
 
 int XenCache::Count(XenObjectType type) const
 {
-    QMutexLocker locker(&this->m_mutex);
     if (type == XenObjectType::Null)
         return 0;
 
+    this->demand(type);
+    QMutexLocker locker(&this->m_mutex);
+
     if (!this->m_cache.contains(type))
         return 0;
 
@@ -531,6 +826,368 @@ QStringList XenCache::GetKnownTypes() const
     };
 }
 
+bool XenCache::WaitFor(const QList<XenObjectType>& types, const QStringList& refs,
+                       const std::function<bool()>& condition, int timeoutMs,
+                       const std::function<bool()>& cancelled)
+{
+    return this->WaitForChanged(types, refs, [&condition](const QStringList&) { return condition(); },
+                                timeoutMs, cancelled);
+}
+
+bool XenCache::WaitForChanged(const QList<XenObjectType>& types, const QStringList& refs,
+                              const std::function<bool(const QStringList& changed)>& condition, int timeoutMs,
+                              const std::function<bool()>& cancelled)
+{
+    Waiter waiter;
+    waiter.types = types;
+    waiter.refs = QSet<QString>(refs.begin(), refs.end());
+
+    // Register before the first check so that a change landing in between
+    // still wakes us
+    {
+        QMutexLocker locker(&this->m_waitMutex);
+        this->m_waiters.append(&waiter);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool satisfied = false;
+    bool check = true;
+    QStringList changed;
+    for (;;)
+    {
+        if (check && condition(changed))
+        {
+            satisfied = true;
+            break;
+        }
+        if (cancelled && cancelled())
+            break;
+
+        const qint64 remaining = timeoutMs < 0 ? WAIT_CANCEL_POLL_MS : timeoutMs - timer.elapsed();
+        if (remaining <= 0)
+            break;
+
+        // Wake on a matching change, or periodically to look at cancellation;
+        // the condition itself is only re-evaluated after a change
+        QMutexLocker locker(&this->m_waitMutex);
+        if (!waiter.signalled)
+            waiter.condition.wait(&this->m_waitMutex, static_cast<unsigned long>(qMin<qint64>(remaining, WAIT_CANCEL_POLL_MS)));
+        check = waiter.signalled;
+        changed = waiter.everything ? QStringList() : QStringList(waiter.changed.cbegin(), waiter.changed.cend());
+        waiter.signalled = false;
+        waiter.everything = false;
+        waiter.changed.clear();
+    }
+
+    QMutexLocker locker(&this->m_waitMutex);
+    this->m_waiters.removeOne(&waiter);
+    return satisfied;
+}
+
+bool XenCache::WaitFor(XenObjectType type, const QString& ref,
+                       const std::function<bool()>& condition, int timeoutMs,
+                       const std::function<bool()>& cancelled)
+{
+    return this->WaitFor(QList<XenObjectType>{ type },
+                         ref.isEmpty() ? QStringList() : QStringList{ ref },
+                         condition, timeoutMs, cancelled);
+}
+
+void XenCache::wakeWaiters(XenObjectType type, const QString& ref)
+{
+    // Null type / empty ref mean "possibly everything" (Clear, UpdateBulk)
+    QMutexLocker locker(&this->m_waitMutex);
+    for (Waiter* waiter : this->m_waiters)
+    {
+        if (type != XenObjectType::Null && !waiter->types.isEmpty() && !waiter->types.contains(type))
+            continue;
+        if (!ref.isEmpty() && !waiter->refs.isEmpty() && !waiter->refs.contains(ref))
+            continue;
+        waiter->signalled = true;
+        if (ref.isEmpty())
+            waiter->everything = true;
+        else
+            waiter->changed.insert(ref);
+        waiter->condition.wakeAll();
+    }
+}
+
+qint64 XenCache::RecordBytes() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    QSet<const void*> seen;
+    qint64 bytes = 0;
+    for (auto typeIt = this->m_cache.constBegin(); typeIt != this->m_cache.constEnd(); ++typeIt)
+    {
+        const QMap<QString, QVariantMap>& records = typeIt.value();
+        for (auto it = records.constBegin(); it != records.constEnd(); ++it)
+        {
+            bytes += MAP_NODE_OVERHEAD + qint64(sizeof(QString) + sizeof(QVariantMap));
+            bytes += stringBytes(it.key(), seen) + mapBytes(it.value(), seen);
+        }
+    }
+    return bytes;
+}
+
+qint64 XenCache::ObjectBytes() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    qint64 count = 0;
+    for (auto it = this->m_objects.constBegin(); it != this->m_objects.constEnd(); ++it)
+        count += it.value().size();
+
+    // Shells only hold the connection and ref; the ref string is shared with the record
+    const qint64 perObject = MAP_NODE_OVERHEAD + qint64(sizeof(QString) + sizeof(QSharedPointer<XenObject>))
+                             + qint64(sizeof(XenObject)) + 24; // shared pointer control block
+    return count * perObject;
+}
+
+void XenCache::SetStringInterning(bool enabled)
+{
+    this->m_internStrings.storeRelaxed(enabled ? 1 : 0);
+}
+
+bool XenCache::IsStringInterning() const
+{
+    return this->m_internStrings.loadRelaxed() != 0;
+}
+
+int XenCache::InternedStringCount() const
+{
+    return this->m_strings.Size();
+}
+
+void XenCache::SetOnDemandTypes(const QList<XenObjectType>& types, const DemandLoader& loader)
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_onDemandTypes = QSet<XenObjectType>(types.begin(), types.end());
+    this->m_demandLoader = loader;
+    this->m_onDemandCount.storeRelease(this->m_onDemandTypes.size());
+}
+
+void XenCache::demand(XenObjectType type) const
+{
+    // Lookups are hot; once everything was asked for this is a single load
+    if (!this->m_onDemandCount.loadAcquire())
+        return;
+
+    DemandLoader loader;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (!this->m_onDemandTypes.remove(type))
+            return;
+        this->m_onDemandCount.storeRelease(this->m_onDemandTypes.size());
+        loader = this->m_demandLoader;
+    }
+
+    if (loader)
+        loader(type);
+}
+
+int XenCache::Subscribe(QObject* receiver, XenObjectType type, const QString& ref,
+                        const ChangeCallback& callback, const QStringList& fields)
+{
+    if (ref.isEmpty())
+        return 0;
+    return this->addSubscription(receiver, type, ref, callback, fields);
+}
+
+int XenCache::Subscribe(QObject* receiver, XenObjectType type,
+                        const ChangeCallback& callback, const QStringList& fields)
+{
+    return this->addSubscription(receiver, type, QString(), callback, fields);
+}
+
+void XenCache::Unsubscribe(int subscriptionId)
+{
+    QMutexLocker locker(&this->m_subscriptionMutex);
+    this->removeSubscriptionLocked(subscriptionId);
+}
+
+void XenCache::Unsubscribe(QObject* receiver)
+{
+    QMutexLocker locker(&this->m_subscriptionMutex);
+    const QList<int> ids = this->m_receiverSubscriptions.take(receiver);
+    for (int id : ids)
+        this->removeSubscriptionLocked(id);
+}
+
+int XenCache::SubscriptionCount() const
+{
+    QMutexLocker locker(&this->m_subscriptionMutex);
+    return this->m_subscriptions.size();
+}
+
+int XenCache::addSubscription(QObject* receiver, XenObjectType type, const QString& ref,
+                              const ChangeCallback& callback, const QStringList& fields)
+{
+    if (!receiver || !callback || type == XenObjectType::Null)
+        return 0;
+
+    QMutexLocker locker(&this->m_subscriptionMutex);
+
+    Subscription* subscription = new Subscription();
+    subscription->id = this->m_nextSubscriptionId++;
+    subscription->receiver = receiver;
+    subscription->type = type;
+    subscription->ref = ref;
+    subscription->fields = fields;
+    subscription->callback = callback;
+    this->m_subscriptions.insert(subscription->id, subscription);
+
+    if (ref.isEmpty())
+        this->m_typeSubscribers[type].append(subscription->id);
+    else
+        this->m_objectSubscribers[type][ref].append(subscription->id);
+
+    // One destroyed() hook per receiver; the entry stays (possibly empty) until then
+    auto receiverIt = this->m_receiverSubscriptions.find(receiver);
+    if (receiverIt == this->m_receiverSubscriptions.end())
+    {
+        this->m_receiverSubscriptions.insert(receiver, QList<int>{ subscription->id });
+        connect(receiver, &QObject::destroyed, this, [this](QObject* object) { this->Unsubscribe(object); }, Qt::DirectConnection);
+    } else
+    {
+        receiverIt.value().append(subscription->id);
+    }
+
+    return subscription->id;
+}
+
+void XenCache::removeSubscriptionLocked(int subscriptionId)
+{
+    Subscription* subscription = this->m_subscriptions.take(subscriptionId);
+    if (!subscription)
+        return;
+
+    if (subscription->ref.isEmpty())
+    {
+        auto it = this->m_typeSubscribers.find(subscription->type);
+        if (it != this->m_typeSubscribers.end())
+        {
+            it.value().removeOne(subscriptionId);
+            if (it.value().isEmpty())
+                this->m_typeSubscribers.erase(it);
+        }
+    } else
+    {
+        auto typeIt = this->m_objectSubscribers.find(subscription->type);
+        if (typeIt != this->m_objectSubscribers.end())
+        {
+            auto refIt = typeIt.value().find(subscription->ref);
+            if (refIt != typeIt.value().end())
+            {
+                refIt.value().removeOne(subscriptionId);
+                if (refIt.value().isEmpty())
+                    typeIt.value().erase(refIt);
+            }
+            if (typeIt.value().isEmpty())
+                this->m_objectSubscribers.erase(typeIt);
+        }
+    }
+
+    auto receiverIt = this->m_receiverSubscriptions.find(subscription->receiver.data());
+    if (receiverIt != this->m_receiverSubscriptions.end())
+        receiverIt.value().removeOne(subscriptionId);
+
+    delete subscription;
+}
+
+void XenCache::queueChange(XenObjectType type, const QString& ref, const QStringList& changed,
+                           bool wholeRecord, bool removed)
+{
+    QMutexLocker locker(&this->m_subscriptionMutex);
+    if (this->m_subscriptions.isEmpty())
+        return;
+
+    QList<int> ids = this->m_typeSubscribers.value(type);
+    auto typeIt = this->m_objectSubscribers.constFind(type);
+    if (typeIt != this->m_objectSubscribers.constEnd())
+        ids += typeIt.value().value(ref);
+    if (ids.isEmpty())
+        return;
+
+    for (int id : ids)
+    {
+        Subscription* subscription = this->m_subscriptions.value(id);
+        if (!subscription)
+            continue;
+
+        // Field masks are matched against the record diff so listeners that only
+        // care about, say, power_state are not woken by metrics churn
+        QStringList fields = changed;
+        if (!subscription->fields.isEmpty())
+        {
+            fields = wholeRecord ? subscription->fields : maskedFields(subscription->fields, changed);
+            if (fields.isEmpty())
+                continue;
+        }
+
+        if (subscription->pending.isEmpty())
+            this->m_pendingSubscriptions.append(id);
+
+        auto pendingIt = subscription->pending.find(ref);
+        if (pendingIt == subscription->pending.end())
+        {
+            XenCacheChange change;
+            change.type = type;
+            change.ref = ref;
+            change.removed = removed;
+            change.fields = fields;
+            subscription->pending.insert(ref, change);
+            subscription->pendingOrder.append(ref);
+        } else
+        {
+            // Last state wins; fields accumulate across the coalesced updates
+            pendingIt.value().removed = removed;
+            for (const QString& field : fields)
+            {
+                if (!pendingIt.value().fields.contains(field))
+                    pendingIt.value().fields.append(field);
+            }
+        }
+    }
+
+    if (!this->m_flushScheduled && !this->m_pendingSubscriptions.isEmpty())
+    {
+        this->m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, [this]() { this->flushSubscriptions(); }, Qt::QueuedConnection);
+    }
+}
+
+void XenCache::flushSubscriptions()
+{
+    QList<int> ids;
+    {
+        QMutexLocker locker(&this->m_subscriptionMutex);
+        ids.swap(this->m_pendingSubscriptions);
+        this->m_flushScheduled = false;
+    }
+
+    // Callbacks run without the lock so they may read the cache or (un)subscribe
+    for (int id : ids)
+    {
+        QList<XenCacheChange> changes;
+        ChangeCallback callback;
+        {
+            QMutexLocker locker(&this->m_subscriptionMutex);
+            Subscription* subscription = this->m_subscriptions.value(id);
+            if (!subscription || !subscription->receiver || subscription->pending.isEmpty())
+                continue;
+
+            changes.reserve(subscription->pendingOrder.size());
+            for (const QString& ref : subscription->pendingOrder)
+                changes.append(subscription->pending.value(ref));
+            subscription->pending.clear();
+            subscription->pendingOrder.clear();
+            callback = subscription->callback;
+        }
+
+        callback(changes);
+    }
+}
+
 QSharedPointer<XenObject> XenCache::createObjectForType(XenObjectType type, const QString& ref)
 {
     if (!this->m_connection)
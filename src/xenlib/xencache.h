@@ -29,17 +29,41 @@
 #define XENCACHE_H
 
 #include <QObject>
+#include <QAtomicInt>
 #include <QMap>
 #include <QVariantMap>
 #include <QMutex>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
 #include <QSharedPointer>
+#include <QStringList>
+#include <functional>
 #include "xen/xenobject.h"
 #include "xen/xenobjecttraits.h"
+#include "utils/stringpool.h"
 
 class Pool;
 class XenConnection;
 
+/**
+ * @brief One coalesced change delivered to a XenCache subscription
+ */
+struct XenCacheChange
+{
+    XenObjectType type = XenObjectType::Null;
+    QString ref;
+    //! Set if the object was gone from the cache by the time the change was delivered
+    bool removed = false;
+    /**
+     * Top-level fields whose value changed, limited to the subscription's field mask
+     * if it has one. Objects that were added or removed list all their fields (or the
+     * whole mask); removals caused by Clear() may list none.
+     */
+    QStringList fields;
+};
+
 /**
  * @brief XenCache - Caches all XenServer objects locally for fast lookups
  *
@@ -54,6 +78,10 @@ class XenConnection;
  * - ResolveObject/ResolveObject<T> creates XenObject instances lazily; the number of
  *   objects in m_objects is NOT expected to match the number of raw records.
  *
+ * String interning:
+ * - Records are run through a per-cache StringPool on Update/UpdateBulk, so refs,
+ *   UUIDs, enum values and field names repeated across records share storage.
+ *
  * Eviction and reconnect:
  * - opaque_ref values are connection-scoped and may change after reconnect.
  * - When records are removed (or cache cleared), existing XenObject instances are
@@ -240,6 +268,10 @@ class XenCache : public QObject
 
         /**
          * @brief Update or add object to cache
+         *
+         * The new record is diffed against the cached one; if no field changed
+         * the call is a no-op and no signal or subscription fires.
+         *
          * @param type Object type
          * @param ref Object reference
          * @param data Object data
@@ -248,11 +280,20 @@ class XenCache : public QObject
 
         /**
          * @brief Update cache from bulk records (all_records response)
+         *
+         * Records identical to the cached ones are skipped like in Update().
          * @param type Object type
          * @param allRecords Map of ref -> object data
          */
         void UpdateBulk(XenObjectType type, const QVariantMap& allRecords);
 
+        /**
+         * @brief Names of top-level fields that differ between two records
+         *
+         * Keys present in only one of the records count as changed.
+         */
+        static QStringList DiffRecords(const QVariantMap& before, const QVariantMap& after);
+
         /**
          * @brief Remove object from cache
          * @param type Object type
@@ -290,6 +331,115 @@ class XenCache : public QObject
          */
         QStringList GetKnownTypes() const;
 
+        /**
+         * @brief Block until @p condition holds, re-checking it only when a matching object changes
+         *
+         * The condition is checked once up front and then after every Update, Remove,
+         * UpdateBulk or Clear touching one of @p types (any type if empty) and, if
+         * @p refs is not empty, one of those refs. It runs on the calling thread without
+         * the cache lock held, so it may use the normal accessors.
+         *
+         * Replaces sleep-and-rescan loops in actions: the caller wakes as soon as the
+         * event lands instead of on the next tick. Must not be called on the thread
+         * that applies events to this cache.
+         *
+         * @param timeoutMs Give up after this many milliseconds; negative waits indefinitely
+         * @param cancelled Polled every WAIT_CANCEL_POLL_MS; returning true ends the wait
+         * @return true if the condition held, false on timeout or cancellation
+         */
+        bool WaitFor(const QList<XenObjectType>& types, const QStringList& refs,
+                     const std::function<bool()>& condition, int timeoutMs,
+                     const std::function<bool()>& cancelled = std::function<bool()>());
+
+        /**
+         * @brief WaitFor() with the refs that changed since the condition last ran
+         *
+         * For conditions that would otherwise rescan every object of a type: they
+         * can look at just the objects in @p changed. An empty list, on the first
+         * check and after a Clear or UpdateBulk, means anything may have changed.
+         */
+        bool WaitForChanged(const QList<XenObjectType>& types, const QStringList& refs,
+                            const std::function<bool(const QStringList& changed)>& condition, int timeoutMs,
+                            const std::function<bool()>& cancelled = std::function<bool()>());
+
+        /**
+         * @brief WaitFor() a single object
+         */
+        bool WaitFor(XenObjectType type, const QString& ref,
+                     const std::function<bool()>& condition, int timeoutMs,
+                     const std::function<bool()>& cancelled = std::function<bool()>());
+
+        /**
+         * @brief Approximate heap held by cached records
+         *
+         * Strings shared between records are counted once. Walks every record,
+         * so this is for diagnostics (MemoryAccountant), not hot paths.
+         */
+        qint64 RecordBytes() const;
+
+        /**
+         * @brief Approximate heap held by lazily created XenObject shells
+         */
+        qint64 ObjectBytes() const;
+
+        /**
+         * @brief Enable or disable string interning of incoming records (enabled by default)
+         *
+         * Only meant for measuring its effect; records already cached are not touched.
+         */
+        void SetStringInterning(bool enabled);
+        bool IsStringInterning() const;
+
+        /**
+         * @brief Number of distinct strings currently held by the intern table
+         */
+        int InternedStringCount() const;
+
+        using DemandLoader = std::function<void(XenObjectType type)>;
+
+        /**
+         * @brief Types that are only loaded once something asks for them
+         *
+         * The first lookup of one of @p types (resolve, GetAll*, Contains, Count)
+         * calls @p loader once, outside the cache lock; the records then arrive as
+         * normal updates. That first lookup sees whatever is cached at the time,
+         * usually nothing, so views should follow changes as they do anyway.
+         */
+        void SetOnDemandTypes(const QList<XenObjectType>& types, const DemandLoader& loader);
+
+        using ChangeCallback = std::function<void(const QList<XenCacheChange>& changes)>;
+
+        /**
+         * @brief Get told about changes to one object instead of filtering every objectChanged()
+         *
+         * Changes are coalesced and delivered once per event loop turn on the cache's
+         * thread, so a burst of events touching the same object results in one call.
+         * Every change lists the fields that changed value. If @p fields is not empty
+         * the subscription only fires when one of those fields changed (or the object
+         * was added or removed), and the delivered change lists only those.
+         *
+         * The subscription is dropped automatically when @p receiver is destroyed.
+         *
+         * @return Subscription id for Unsubscribe()
+         */
+        int Subscribe(QObject* receiver, XenObjectType type, const QString& ref,
+                      const ChangeCallback& callback, const QStringList& fields = QStringList());
+
+        /**
+         * @brief Get told about changes to any object of @p type
+         */
+        int Subscribe(QObject* receiver, XenObjectType type,
+                      const ChangeCallback& callback, const QStringList& fields = QStringList());
+
+        void Unsubscribe(int subscriptionId);
+
+        /**
+         * @brief Drop every subscription owned by @p receiver
+         */
+        void Unsubscribe(QObject* receiver);
+
+        int SubscriptionCount() const;
+
     signals:
         /**
          * @brief Emitted when an object is added or updated
@@ -331,6 +481,10 @@ class XenCache : public QObject
 
     private:
         static XenCache *dummyCache;
+        static const int WAIT_CANCEL_POLL_MS = 200;
+
+        struct Waiter;
+        struct Subscription;
 
         // Type -> (Ref -> ObjectData)
         mutable QMutex m_mutex;
@@ -338,9 +492,41 @@ class XenCache : public QObject
         QMap<XenObjectType, QMap<QString, QSharedPointer<XenObject>>> m_objects;
         QPointer<XenConnection> m_connection;
 
+        // Shared storage for strings repeated across records
+        StringPool m_strings;
+        QAtomicInt m_internStrings = 1;
+
+        // Types loaded on first lookup; guarded by m_mutex, the count allows a lock-free fast path
+        mutable QSet<XenObjectType> m_onDemandTypes;
+        DemandLoader m_demandLoader;
+        mutable QAtomicInt m_onDemandCount = 0;
+
+        // Threads blocked in WaitFor(); guarded by m_waitMutex
+        QMutex m_waitMutex;
+        QList<Waiter*> m_waiters;
+
+        // Targeted change subscriptions; guarded by m_subscriptionMutex
+        mutable QMutex m_subscriptionMutex;
+        QHash<int, Subscription*> m_subscriptions;
+        QHash<XenObjectType, QHash<QString, QList<int>>> m_objectSubscribers;
+        QHash<XenObjectType, QList<int>> m_typeSubscribers;
+        QHash<QObject*, QList<int>> m_receiverSubscriptions;
+        QList<int> m_pendingSubscriptions;
+        int m_nextSubscriptionId = 1;
+        bool m_flushScheduled = false;
+
+        int addSubscription(QObject* receiver, XenObjectType type, const QString& ref,
+                            const ChangeCallback& callback, const QStringList& fields);
+        void removeSubscriptionLocked(int subscriptionId);
+        void queueChange(XenObjectType type, const QString& ref, const QStringList& changed,
+                         bool wholeRecord, bool removed);
+        void flushSubscriptions();
+
         QSharedPointer<XenObject> createObjectForType(XenObjectType type, const QString& ref);
         void refreshObject(XenObjectType type, const QString& ref);
         void evictObject(XenObjectType type, const QString& ref);
+        void wakeWaiters(XenObjectType type, const QString& ref);
+        void demand(XenObjectType type) const;
 };
 
 #endif // XENCACHE_H
@@ -50,6 +50,7 @@ HEADERS += \
     alerts/alert.h \
     alerts/alertmanager.h \
     alerts/messagealert.h \
+    alerts/messagealertloader.h \
     alerts/alarmmessagealert.h \
     alerts/policyalert.h \
     alerts/certificatealert.h \
@@ -57,9 +58,15 @@ HEADERS += \
     operations/multipleaction.h \
     operations/multipleactionlauncher.h \
     operations/parallelaction.h \
+    utils/memoryaccountant.h \
     utils/misc.h \
+    utils/chunkqueue.h \
+    utils/copypipeline.h \
     utils/decompressgzaction.h \
     utils/downloadfileaction.h \
+    utils/httpcompression.h \
+    utils/parallelgzip.h \
+    utils/stringpool.h \
     xen/actions/vm/vmstartaction.h \
     xen/xenapi/xenapi_Blob.h \
     xen/xenapi/xenapi_Bond.h \
@@ -74,6 +81,7 @@ HEADERS += \
     xen/xenapi/xenapi_GPU_group.h \
     xen/xenapi/xenapi_PIF.h \
     xen/xenapi/xenapi_Secret.h \
+    xen/xenapi/xenapi_Message.h \
     xen/xenapi/xenapi_VBD.h \
     xen/xenapi/xenapi_VDI.h \
     xen/xenapi/xenapi_VGPU.h \
@@ -98,6 +106,13 @@ HEADERS += \
     xen/network/connection.h \
     xen/network/connectionworker.h \
     xen/network/httpclient.h \
+    xen/network/httpconnectionpool.h \
+    xen/network/rpctracer.h \
+    xen/network/transferbatch.h \
+    xen/network/transfercheckpoint.h \
+    xen/network/transferlimits.h \
+    xen/network/wirerecorder.h \
+    xen/network/wirereplay.h \
     xen/network/connecttask.h \
     xen/session.h \
     xen/api.h \
@@ -205,6 +220,7 @@ HEADERS += \
     xen/actions/general/perfmondefinitionaction.h \
     xen/actions/general/savechangesaction.h \
     xen/actions/general/savedatasourcestateaction.h \
+    xen/actions/general/dismissmessagesaction.h \
     xen/actions/vm/vmstartabstractaction.h \
     xen/actions/vm/vmstartonaction.h \
     xen/actions/vm/vmresumeaction.h \
@@ -299,6 +315,18 @@ HEADERS += \
     xen/vbdmetrics.h \
     otherconfig/otherconfigandtagswatcher.h \
     folders/foldersmanager.h \
+    diskimage/clusterinflater.h \
+    diskimage/diskimagereader.h \
+    diskimage/qcow2imagereader.h \
+    diskimage/rawimagereader.h \
+    diskimage/sparsevhdstream.h \
+    diskimage/vhdformat.h \
+    diskimage/vhdimagereader.h \
+    diskimage/vmdkimagereader.h \
+    ovf/ovaarchive.h \
+    ovf/ovatar.h \
+    ovf/ovfdisksource.h \
+    ovf/ovfexportstream.h \
     ovf/ovfpackage.h \
     ovf/ovfwriter.h \
     xva/xvaverifier.h
@@ -308,6 +336,7 @@ SOURCES += \
     alerts/alert.cpp \
     alerts/alertmanager.cpp \
     alerts/messagealert.cpp \
+    alerts/messagealertloader.cpp \
     alerts/alarmmessagealert.cpp \
     alerts/policyalert.cpp \
     alerts/certificatealert.cpp \
@@ -315,9 +344,15 @@ SOURCES += \
     operations/multipleaction.cpp \
     operations/multipleactionlauncher.cpp \
     operations/parallelaction.cpp \
+    utils/memoryaccountant.cpp \
     utils/misc.cpp \
+    utils/chunkqueue.cpp \
+    utils/copypipeline.cpp \
     utils/decompressgzaction.cpp \
     utils/downloadfileaction.cpp \
+    utils/httpcompression.cpp \
+    utils/parallelgzip.cpp \
+    utils/stringpool.cpp \
     vmhelpers.cpp \
     xen/actions/vm/vmstartaction.cpp \
     xen/actions/wlb/wlbretrievevmrecommendationsaction.cpp \
@@ -336,6 +371,7 @@ SOURCES += \
     xen/xenapi/xenapi_GPU_group.cpp \
     xen/xenapi/xenapi_PIF.cpp \
     xen/xenapi/xenapi_Secret.cpp \
+    xen/xenapi/xenapi_Message.cpp \
     xen/xenapi/xenapi_VBD.cpp \
     xen/xenapi/xenapi_VDI.cpp \
     xen/xenapi/xenapi_VGPU.cpp \
@@ -356,6 +392,13 @@ SOURCES += \
     xen/network/connection.cpp \
     xen/network/connectionworker.cpp \
     xen/network/httpclient.cpp \
+    xen/network/httpconnectionpool.cpp \
+    xen/network/rpctracer.cpp \
+    xen/network/transferbatch.cpp \
+    xen/network/transfercheckpoint.cpp \
+    xen/network/transferlimits.cpp \
+    xen/network/wirerecorder.cpp \
+    xen/network/wirereplay.cpp \
     xen/session.cpp \
     xen/api.cpp \
     xen/apiversion.cpp \
@@ -455,6 +498,7 @@ SOURCES += \
     xen/actions/general/perfmondefinitionaction.cpp \
     xen/actions/general/savechangesaction.cpp \
     xen/actions/general/savedatasourcestateaction.cpp \
+    xen/actions/general/dismissmessagesaction.cpp \
     xen/actions/vm/vmstartabstractaction.cpp \
     xen/actions/vm/vmstartonaction.cpp \
     xen/actions/vm/vmresumeaction.cpp \
@@ -549,6 +593,18 @@ SOURCES += \
     xen/vmmetrics.cpp \
     otherconfig/otherconfigandtagswatcher.cpp \
     folders/foldersmanager.cpp \
+    diskimage/clusterinflater.cpp \
+    diskimage/diskimagereader.cpp \
+    diskimage/qcow2imagereader.cpp \
+    diskimage/rawimagereader.cpp \
+    diskimage/sparsevhdstream.cpp \
+    diskimage/vhdformat.cpp \
+    diskimage/vhdimagereader.cpp \
+    diskimage/vmdkimagereader.cpp \
+    ovf/ovaarchive.cpp \
+    ovf/ovatar.cpp \
+    ovf/ovfdisksource.cpp \
+    ovf/ovfexportstream.cpp \
     ovf/ovfpackage.cpp \
     ovf/ovfwriter.cpp \
     xva/xvaverifier.cpp
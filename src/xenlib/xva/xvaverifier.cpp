@@ -30,7 +30,12 @@
 #include <QCryptographicHash>
 #include <QDomDocument>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 #include <QtEndian>
+#include <atomic>
 #include <stdexcept>
 #include <cstring>
 
@@ -45,6 +50,8 @@ static const int TAR_SIZE_LEN     = 12;
 static const int TAR_CHKSUM_OFF   = 148;
 static const int TAR_CHKSUM_LEN   = 8;
 
+static const unsigned long PROGRESS_INTERVAL_MS = 100;
+
 // ---------------------------------------------------------------------------
 // Internal helper: parse a null/space-trimmed octal field from a TAR header
 // ---------------------------------------------------------------------------
@@ -258,16 +265,17 @@ quint32 XvaVerifier::paddingLength(quint32 fileSize)
     return nextBlock - fileSize;
 }
 
-QString XvaVerifier::sha1Hex(const QByteArray& data)
+QString XvaVerifier::sha1Hex(const char* data, qint64 size)
 {
-    return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toLower();
+    // Hash the mapped bytes in place, no copy
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(data, static_cast<int>(size));
+    return hash.result().toHex().toLower();
 }
 
-QString XvaVerifier::xxhash64Hex(const QByteArray& data)
+QString XvaVerifier::xxhash64Hex(const char* data, qint64 size)
 {
-    const quint64 hash = xxhash64Compute(
-        reinterpret_cast<const uchar*>(data.constData()),
-        data.size());
+    const quint64 hash = xxhash64Compute(reinterpret_cast<const uchar*>(data), size);
 
     // Format as 16-char uppercase hex (big-endian numeric value),
     // matching the C# hex() function applied to ComputeHash() bytes.
@@ -311,14 +319,113 @@ QHash<QString, QString> XvaVerifier::parseChecksumXml(const QByteArray& xml)
     return table;
 }
 
+bool XvaVerifier::hashJobs(QVector<HashJob>& jobs, const QString& filename, const uchar* mapped,
+                           int threadCount, const std::function<bool()>& cancelCheck,
+                           const std::function<void(qint64)>& progressCallback,
+                           XvaVerifyResult& errorOut)
+{
+    // Detach once up front; the workers only touch their own elements
+    HashJob* jobData = jobs.data();
+    const int jobCount = jobs.size();
+    std::atomic<int> next { 0 };
+    std::atomic<qint64> bytesHashed { 0 };
+    std::atomic<bool> stop { false };
+    QMutex errorMutex;
+    QString readError;
+
+    auto worker = [&]() {
+        QFile file(filename);
+        QByteArray buffer;
+        if (!mapped && !file.open(QIODevice::ReadOnly))
+        {
+            QMutexLocker locker(&errorMutex);
+            readError = QString("Cannot open file: %1").arg(filename);
+            stop = true;
+            return;
+        }
+
+        for (;;)
+        {
+            const int index = next.fetch_add(1);
+            if (index >= jobCount || stop.load())
+                return;
+
+            HashJob& job = jobData[index];
+            const char* data;
+            if (mapped)
+            {
+                data = reinterpret_cast<const char*>(mapped + job.offset);
+            } else
+            {
+                buffer.resize(static_cast<int>(job.size));
+                if (!file.seek(job.offset) || file.read(buffer.data(), job.size) != job.size)
+                {
+                    QMutexLocker locker(&errorMutex);
+                    readError = QString("Unexpected end of file reading entry '%1'").arg(job.filename);
+                    stop = true;
+                    return;
+                }
+                data = buffer.constData();
+            }
+
+            job.computed = job.useXxhash ? xxhash64Hex(data, job.size) : sha1Hex(data, job.size);
+            bytesHashed += job.size;
+        }
+    };
+
+    QVector<QThread*> workers;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        workers.append(QThread::create(worker));
+        workers.last()->start();
+    }
+
+    // Report progress and watch for cancellation while the workers run
+    bool cancelled = false;
+    for (QThread* thread : workers)
+    {
+        while (!thread->wait(PROGRESS_INTERVAL_MS))
+        {
+            if (!cancelled && cancelCheck && cancelCheck())
+            {
+                cancelled = true;
+                stop = true;
+            }
+            if (progressCallback)
+                progressCallback(bytesHashed.load());
+        }
+    }
+    qDeleteAll(workers);
+
+    if (cancelled)
+    {
+        errorOut = { false, XvaVerifyResult::ErrorType::Cancelled, "Verification cancelled by user" };
+        return false;
+    }
+    if (!readError.isEmpty())
+    {
+        errorOut = { false, XvaVerifyResult::ErrorType::IOError, readError };
+        return false;
+    }
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // Main verification entry point — ports Export.verify() from C# export.cs
+//
+// The TAR walk only touches headers and checksum members, so it stays
+// sequential; the data members are collected as jobs and hashed in
+// parallel. Errors are resolved in archive order afterwards, which keeps
+// the result identical to checking each member as it is read.
 // ---------------------------------------------------------------------------
 XvaVerifyResult XvaVerifier::Verify(
     const QString& filename,
     std::function<bool()> cancelCheck,
     std::function<void(qint64)> progressCallback)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly))
     {
@@ -326,19 +433,33 @@ XvaVerifyResult XvaVerifier::Verify(
                  QString("Cannot open file: %1").arg(filename) };
     }
 
-    QHash<QString, QString> recomputedChecksums;
+    const qint64 fileSize = file.size();
+    const uchar* mapped = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+
     QHash<QString, QString> originalChecksums;
-    qint64 bytesProcessed = 0;
+    QVector<HashJob> jobs;
+    qint64 pos = 0;
     int    zeroBlockCount = 0;
 
-    auto readBlock = [&](quint32 size, QByteArray& out) -> bool {
-        out = file.read(static_cast<qint64>(size));
-        if (out.size() != static_cast<int>(size))
+    // Walk result; only reported if no earlier data member fails
+    XvaVerifyResult walkResult { true, XvaVerifyResult::ErrorType::None, QString() };
+    auto walkFail = [&walkResult](XvaVerifyResult::ErrorType type, const QString& message) {
+        walkResult = { false, type, message };
+    };
+
+    // Bytes at [offset, offset + size): a view of the mapping or a read
+    auto fetch = [&](qint64 offset, qint64 size, QByteArray& out) -> bool {
+        if (offset + size > fileSize)
             return false;
-        bytesProcessed += size;
-        if (progressCallback)
-            progressCallback(bytesProcessed);
-        return true;
+        if (mapped)
+        {
+            out = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped + offset), static_cast<int>(size));
+            return true;
+        }
+        if (!file.seek(offset))
+            return false;
+        out = file.read(size);
+        return out.size() == size;
     };
 
     while (true)
@@ -351,11 +472,13 @@ XvaVerifyResult XvaVerifier::Verify(
 
         // Read next 512-byte TAR header
         QByteArray headerBlock;
-        if (!readBlock(TAR_BLOCK_SIZE, headerBlock))
+        if (!fetch(pos, TAR_BLOCK_SIZE, headerBlock))
         {
-            return { false, XvaVerifyResult::ErrorType::IOError,
-                     "Unexpected end of file while reading TAR header" };
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     "Unexpected end of file while reading TAR header");
+            break;
         }
+        pos += TAR_BLOCK_SIZE;
 
         // End-of-archive: two consecutive zero blocks
         if (isAllZeroes(headerBlock))
@@ -375,33 +498,29 @@ XvaVerifyResult XvaVerifier::Verify(
         }
         catch (const std::runtime_error& e)
         {
-            return { false, XvaVerifyResult::ErrorType::HeaderChecksum,
-                     QString::fromStdString(e.what()) };
+            walkFail(XvaVerifyResult::ErrorType::HeaderChecksum, QString::fromStdString(e.what()));
+            break;
         }
 
         if (header.isEndOfArchive)
             break;
 
-        // Read the file data
-        QByteArray fileData;
-        if (header.fileSize > 0 && !readBlock(header.fileSize, fileData))
+        // The file data and its padding must be present
+        const qint64 dataOffset = pos;
+        if (pos + header.fileSize > fileSize)
         {
-            return { false, XvaVerifyResult::ErrorType::IOError,
-                     QString("Unexpected end of file reading entry '%1'")
-                         .arg(header.filename) };
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     QString("Unexpected end of file reading entry '%1'").arg(header.filename));
+            break;
         }
-
-        // Read and discard the padding bytes
-        if (quint32 pad = paddingLength(header.fileSize); pad > 0)
+        pos += header.fileSize;
+        if (pos + paddingLength(header.fileSize) > fileSize)
         {
-            QByteArray padding;
-            if (!readBlock(pad, padding))
-            {
-                return { false, XvaVerifyResult::ErrorType::IOError,
-                         QString("Unexpected end of file reading padding for '%1'")
-                             .arg(header.filename) };
-            }
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     QString("Unexpected end of file reading padding for '%1'").arg(header.filename));
+            break;
         }
+        pos += paddingLength(header.fileSize);
 
         // ---- Dispatch on entry type ----------------------------------------
 
@@ -416,19 +535,22 @@ XvaVerifyResult XvaVerifier::Verify(
         if (header.filename.endsWith("checksum.xml"))
         {
             qDebug() << "XvaVerifier: parsing" << header.filename;
-            originalChecksums = parseChecksumXml(fileData);
+            QByteArray xml;
+            fetch(dataOffset, header.fileSize, xml);
+            originalChecksums = parseChecksumXml(xml);
             continue;
         }
 
         // Data file — must be followed immediately by a companion checksum entry
         // Read companion header
         QByteArray csumHeaderBlock;
-        if (!readBlock(TAR_BLOCK_SIZE, csumHeaderBlock))
+        if (!fetch(pos, TAR_BLOCK_SIZE, csumHeaderBlock))
         {
-            return { false, XvaVerifyResult::ErrorType::IOError,
-                     QString("Unexpected end of file reading checksum header for '%1'")
-                         .arg(header.filename) };
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     QString("Unexpected end of file reading checksum header for '%1'").arg(header.filename));
+            break;
         }
+        pos += TAR_BLOCK_SIZE;
 
         TarHeader csumHeader;
         try
@@ -437,47 +559,67 @@ XvaVerifyResult XvaVerifier::Verify(
         }
         catch (const std::runtime_error& e)
         {
-            return { false, XvaVerifyResult::ErrorType::HeaderChecksum,
-                     QString::fromStdString(e.what()) };
+            walkFail(XvaVerifyResult::ErrorType::HeaderChecksum, QString::fromStdString(e.what()));
+            break;
         }
 
         // Read companion checksum data
         QByteArray csumData;
-        if (csumHeader.fileSize > 0 && !readBlock(csumHeader.fileSize, csumData))
+        if (csumHeader.fileSize > 0 && !fetch(pos, csumHeader.fileSize, csumData))
         {
-            return { false, XvaVerifyResult::ErrorType::IOError,
-                     QString("Unexpected end of file reading checksum data for '%1'")
-                         .arg(header.filename) };
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     QString("Unexpected end of file reading checksum data for '%1'").arg(header.filename));
+            break;
         }
+        pos += csumHeader.fileSize;
 
-        // Read and discard companion padding
-        if (quint32 csumPad = paddingLength(csumHeader.fileSize); csumPad > 0)
+        // Skip companion padding
+        if (pos + paddingLength(csumHeader.fileSize) > fileSize)
         {
-            QByteArray padding;
-            if (!readBlock(csumPad, padding))
-            {
-                return { false, XvaVerifyResult::ErrorType::IOError,
-                         QString("Unexpected end of file reading checksum padding for '%1'")
-                             .arg(header.filename) };
-            }
+            walkFail(XvaVerifyResult::ErrorType::IOError,
+                     QString("Unexpected end of file reading checksum padding for '%1'").arg(header.filename));
+            break;
         }
+        pos += paddingLength(csumHeader.fileSize);
+
+        HashJob job;
+        job.filename  = header.filename;
+        job.offset    = dataOffset;
+        job.size      = header.fileSize;
+        job.useXxhash = csumHeader.filename.endsWith(".xxhash");
+        job.expected  = QString::fromUtf8(csumData).trimmed();
+        jobs.append(job);
+    }
 
-        // Compute and compare hash
-        const QString csumCompare = QString::fromUtf8(csumData).trimmed();
-        const bool useXxhash      = csumHeader.filename.endsWith(".xxhash");
-        const QString computed    = useXxhash ? xxhash64Hex(fileData) : sha1Hex(fileData);
+    // ---- Hash the data members ---------------------------------------------
+    const int threadCount = qBound(1, QThread::idealThreadCount(), qMax(1, jobs.size()));
+    qint64 bytesVerified = 0;
+    for (const HashJob& job : jobs)
+        bytesVerified += job.size;
 
-        if (computed.compare(csumCompare, Qt::CaseInsensitive) != 0)
+    XvaVerifyResult hashResult;
+    if (!hashJobs(jobs, filename, mapped, threadCount, cancelCheck, progressCallback, hashResult))
+        return hashResult;
+
+    // First failing member in archive order wins, as in a sequential pass
+    QHash<QString, QString> recomputedChecksums;
+    for (const HashJob& job : jobs)
+    {
+        if (job.computed.compare(job.expected, Qt::CaseInsensitive) != 0)
         {
             return { false, XvaVerifyResult::ErrorType::BlockChecksum,
                      QString("Block checksum failed for '%1': computed=%2 expected=%3")
-                         .arg(header.filename).arg(computed).arg(csumCompare) };
+                         .arg(job.filename).arg(job.computed).arg(job.expected) };
         }
-
-        recomputedChecksums.insert(header.filename, computed);
-        qDebug() << "XvaVerifier:" << header.filename << "checksum OK";
+        recomputedChecksums.insert(job.filename, job.computed);
     }
 
+    if (!walkResult.success)
+        return walkResult;
+
+    if (progressCallback)
+        progressCallback(fileSize);
+
     // Final cross-check against checksum.xml (if present)
     if (!originalChecksums.isEmpty())
     {
@@ -496,5 +638,16 @@ XvaVerifyResult XvaVerifier::Verify(
         }
     }
 
-    return { true, XvaVerifyResult::ErrorType::None, QString() };
+    XvaVerifyResult result { true, XvaVerifyResult::ErrorType::None, QString() };
+    result.bytesVerified = bytesVerified;
+    result.elapsedMs = timer.elapsed();
+    result.threadCount = threadCount;
+    qDebug().noquote() << QString("XvaVerifier: %1 members, %2 MiB in %3 ms (%4 MiB/s, %5 threads, %6)")
+                              .arg(jobs.size())
+                              .arg(bytesVerified / (1024 * 1024))
+                              .arg(result.elapsedMs)
+                              .arg(result.elapsedMs > 0 ? bytesVerified * 1000.0 / result.elapsedMs / (1024 * 1024) : 0.0, 0, 'f', 1)
+                              .arg(threadCount)
+                              .arg(mapped ? "mapped" : "read");
+    return result;
 }
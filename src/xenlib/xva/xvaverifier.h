@@ -30,6 +30,7 @@
 
 #include <QString>
 #include <QHash>
+#include <QVector>
 #include <functional>
 
 /**
@@ -52,6 +53,10 @@ struct XvaVerifyResult
     } errorType = ErrorType::None;
 
     QString errorMessage;
+
+    qint64 bytesVerified = 0;  ///< Member bytes hashed
+    qint64 elapsedMs = 0;      ///< Wall-clock time of the whole pass
+    int threadCount = 0;       ///< Hashing threads used
 };
 
 /**
@@ -60,11 +65,14 @@ struct XvaVerifyResult
  * Ports the Export.verify() logic from C# CommandLib/export.cs.
  *
  * Algorithm:
- * - Read the XVA (POSIX TAR) sequentially.
+ * - Walk the XVA (POSIX TAR) headers sequentially, memory-mapping the file
+ *   where possible (positioned reads otherwise).
  * - "ova.xml" entries are skipped.
  * - "*.checksum.xml" entries are parsed as global checksum tables.
  * - All other data entries are followed by a companion .checksum (SHA1)
- *   or .xxhash (XXHash64) file; hashes are verified immediately.
+ *   or .xxhash (XXHash64) file; each pair becomes a hashing job.
+ * - Jobs are hashed in parallel on all cores; failures are reported in
+ *   archive order, so the result is the same as a sequential pass.
  * - At end-of-archive, the recomputed table is compared with the global
  *   checksum.xml table (if present).
  */
@@ -75,7 +83,8 @@ class XvaVerifier
          * @brief Verify an XVA file on disk.
          * @param filename         Path to the XVA file.
          * @param cancelCheck      Called to detect cancellation; return true to abort.
-         * @param progressCallback Called periodically with bytes consumed so far.
+         * @param progressCallback Called periodically, on the calling thread, with
+         *                         bytes consumed so far.
          * @return Verification result.
          */
         static XvaVerifyResult Verify(
@@ -102,8 +111,19 @@ class XvaVerifier
         /** @brief Padding bytes after data to reach the next 512-byte boundary. */
         static quint32 paddingLength(quint32 fileSize);
 
+        /** @brief One data member and the checksum recorded for it. */
+        struct HashJob
+        {
+            QString filename;
+            qint64  offset = 0;
+            quint32 size = 0;
+            bool    useXxhash = false;
+            QString expected;
+            QString computed;
+        };
+
         /** @brief Compute SHA1 of data, returning lowercase hex string (40 chars). */
-        static QString sha1Hex(const QByteArray& data);
+        static QString sha1Hex(const char* data, qint64 size);
 
         /**
          * @brief Compute XXHash64 of data, returning uppercase hex string (16 chars).
@@ -111,7 +131,19 @@ class XvaVerifier
          * Matches the output of YYProject.XXHash64.ComputeHash() as used in
          * the C# CommandLib.
          */
-        static QString xxhash64Hex(const QByteArray& data);
+        static QString xxhash64Hex(const char* data, qint64 size);
+
+        /**
+         * @brief Hash every job of @p jobs on a set of worker threads.
+         *
+         * Reads from @p mapped when the archive is mapped, otherwise each
+         * worker opens @p filename itself.
+         * @return false if cancelled or a read failed (@p errorOut set)
+         */
+        static bool hashJobs(QVector<HashJob>& jobs, const QString& filename, const uchar* mapped,
+                             int threadCount, const std::function<bool()>& cancelCheck,
+                             const std::function<void(qint64)>& progressCallback,
+                             XvaVerifyResult& errorOut);
 
         /**
          * @brief Parse a checksum.xml body into a filename → checksum map.
@@ -0,0 +1,741 @@
+/*
+ * Copyright (c) 2025, Petr Bena <petr@bena.rocks>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Hot-path benchmarks over synthetic pools of 1k, 10k and 100k objects.
+//
+// Run with the usual QtTest options, e.g. "-median 5" or "-callgrind";
+// a single size is picked with "cacheUpdate:100k".
+
+#include <QtTest>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QTreeWidget>
+#include "xenlib/xencache.h"
+#include "xenlib/alerts/alertmanager.h"
+#include "xenlib/alerts/messagealert.h"
+#include "xenlib/alerts/messagealertloader.h"
+#include "xenlib/metricupdater.h"
+#include "xenlib/utils/httpcompression.h"
+#include "xenlib/utils/parallelgzip.h"
+#include "xenlib/folders/foldersmanager.h"
+#include "xenlib/xen/network/connection.h"
+#include "xenlib/xen/network/connectionworker.h"
+#include "xenlib/xen/xenobjecttype.h"
+#include "xenlib/xensearch/common.h"
+#include "xenlib/xensearch/grouping.h"
+#include "xenlib/xensearch/iacceptgroups.h"
+#include "xenlib/xensearch/query.h"
+#include "xenlib/xensearch/queryscope.h"
+#include "xenlib/xensearch/search.h"
+#include "mockxapi/mockxapidatabase.h"
+#include "mockxapi/mockxapiinventory.h"
+#include "mockxapi/mockxapiserver.h"
+#include "mainwindowtreebuilder.h"
+#include "tabpages/alertlistmodel.h"
+
+#ifndef XENADMIN_NO_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    const int CONNECT_TIMEOUT_MS = 10000;
+
+    struct CacheEvent
+    {
+        XenObjectType type = XenObjectType::Null;
+        QString ref;
+        QVariantMap snapshot;
+    };
+
+    // What one pool size looks like once generated, kept for the whole run
+    struct Fixture
+    {
+        QList<CacheEvent> events;
+        QByteArray rrdUpdates;
+    };
+
+    // Counts what a search hands out without building any widgets
+    class CountingAcceptor : public IAcceptGroups
+    {
+        public:
+            IAcceptGroups* Add(Grouping* grouping, const QVariant& group, const QString& objectType,
+                               const QVariantMap& objectData, int indent, XenConnection* conn) override
+            {
+                Q_UNUSED(grouping);
+                Q_UNUSED(group);
+                Q_UNUSED(objectType);
+                Q_UNUSED(objectData);
+                Q_UNUSED(indent);
+                Q_UNUSED(conn);
+                ++this->m_count;
+                return this;
+            }
+
+            void FinishedInThisGroup(bool defaultExpand) override
+            {
+                Q_UNUSED(defaultExpand);
+            }
+
+            int GetCount() const
+            {
+                return this->m_count;
+            }
+
+        private:
+            int m_count = 0;
+    };
+
+    Fixture makeFixture(int objects)
+    {
+        MockXapiDatabase database;
+        MockXapiInventory::Populate(database, MockXapiInventory::OptionsForObjectCount(objects));
+
+        // Go through the dump rather than the database so the cache sees exactly what event.from delivers
+        const QJsonObject result = QJsonDocument::fromJson(MockXapiInventory::ExportEventDump(database))
+                                       .object().value("result").toObject();
+        Fixture fixture;
+        const QJsonArray events = result.value("events").toArray();
+        fixture.events.reserve(events.size());
+        for (const QJsonValue& value : events)
+        {
+            const QJsonObject event = value.toObject();
+            CacheEvent entry;
+            entry.type = XenObjectTypeFromString(event.value("class").toString());
+            entry.ref = event.value("ref").toString();
+            entry.snapshot = event.value("snapshot").toObject().toVariantMap();
+            if (entry.type != XenObjectType::Null)
+                fixture.events.append(entry);
+        }
+
+        fixture.rrdUpdates = MockXapiInventory::ExportRrdUpdates(database, true, QDateTime::currentSecsSinceEpoch());
+        return fixture;
+    }
+
+    QByteArray jsonRpcRequest(const QString& method, const QVariantList& params)
+    {
+        const QJsonObject request{
+            { "jsonrpc", "2.0" },
+            { "method", method },
+            { "params", QJsonArray::fromVariantList(params) },
+            { "id", 1 },
+        };
+        return QJsonDocument(request).toJson(QJsonDocument::Compact);
+    }
+
+    // Something like a VHD: runs of zeros between blocks of low-entropy data
+    QByteArray diskImage(qint64 size)
+    {
+        QRandomGenerator rng(7);
+        QByteArray data(static_cast<qsizetype>(size), '\0');
+        for (qint64 offset = 0; offset < size; offset += 64 * 1024)
+        {
+            if (rng.bounded(4) == 0)
+                continue;
+            const qint64 end = qMin(size, offset + 64 * 1024);
+            for (qint64 i = offset; i < end; ++i)
+                data[static_cast<qsizetype>(i)] = static_cast<char>('a' + rng.bounded(16));
+        }
+        return data;
+    }
+
+    // Heap used by string buffers reachable from a value, each distinct buffer
+    // counted once: header plus capacity and terminator in UTF-16
+    qint64 stringBytes(const QString& string, QSet<const void*>& seen)
+    {
+        if (string.isEmpty() || seen.contains(string.constData()))
+            return 0;
+        seen.insert(string.constData());
+        return 16 + (string.capacity() + 1) * qint64(sizeof(QChar));
+    }
+
+    qint64 stringBytes(const QVariant& value, QSet<const void*>& seen)
+    {
+        switch (value.typeId())
+        {
+            case QMetaType::QString:
+                return stringBytes(value.toString(), seen);
+            case QMetaType::QVariantMap:
+            {
+                qint64 bytes = 0;
+                const QVariantMap map = value.toMap();
+                for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+                    bytes += stringBytes(it.key(), seen) + stringBytes(it.value(), seen);
+                return bytes;
+            }
+            case QMetaType::QVariantList:
+            {
+                qint64 bytes = 0;
+                const QVariantList list = value.toList();
+                for (const QVariant& item : list)
+                    bytes += stringBytes(item, seen);
+                return bytes;
+            }
+            default:
+                return 0;
+        }
+    }
+}
+
+class XenAdminBenchmarks : public QObject
+{
+    Q_OBJECT
+
+    private:
+        MockXapiServer m_server;
+        XenConnection* m_connection = nullptr;
+        QMap<int, Fixture> m_fixtures;
+        int m_loaded = -1;
+        Search* m_search = nullptr;
+
+        const Fixture& fixture(int objects)
+        {
+            if (!this->m_fixtures.contains(objects))
+                this->m_fixtures.insert(objects, makeFixture(objects));
+            return this->m_fixtures[objects];
+        }
+
+        void loadCache(const Fixture& fixture)
+        {
+            XenCache* cache = this->m_connection->GetCache();
+            cache->Clear();
+            for (const CacheEvent& event : fixture.events)
+                cache->Update(event.type, event.ref, event.snapshot);
+        }
+
+        // Benchmarks other than cacheUpdate start from a fully populated cache
+        void prepare(int objects)
+        {
+            if (this->m_loaded == objects)
+                return;
+            this->loadCache(this->fixture(objects));
+            this->m_loaded = objects;
+        }
+
+        void addSizes()
+        {
+            QTest::addColumn<int>("objects");
+            QTest::newRow("1k") << 1000;
+            QTest::newRow("10k") << 10000;
+            QTest::newRow("100k") << 100000;
+        }
+
+    private slots:
+        void initTestCase()
+        {
+            // Search and the tree builder only look at connected pools, so the
+            // connection needs a live transport; the mock server provides one
+            QVERIFY2(this->m_server.Start(), qPrintable(this->m_server.GetError()));
+            this->m_connection = new XenConnection(this);
+            this->m_connection->ConnectToHost("127.0.0.1", this->m_server.GetPort(), "root", QString());
+            QTRY_VERIFY_WITH_TIMEOUT(this->m_connection->IsConnected(), CONNECT_TIMEOUT_MS);
+
+            QueryScope* scope = new QueryScope(XenSearch::ObjectTypes::AllExcFolders);
+            this->m_search = new Search(new Query(scope, nullptr), new TypeGrouping(nullptr), "Objects", QString(), false);
+        }
+
+        void cleanupTestCase()
+        {
+            delete this->m_search;
+            this->m_search = nullptr;
+            this->m_connection->DisconnectTransport();
+            this->m_server.Stop();
+        }
+
+        void cacheUpdate_data()
+        {
+            this->addSizes();
+        }
+
+        void cacheUpdate()
+        {
+            QFETCH(int, objects);
+            const Fixture& data = this->fixture(objects);
+
+            QBENCHMARK
+            {
+                this->loadCache(data);
+            }
+            this->m_loaded = objects;
+            QVERIFY(this->m_connection->GetCache()->Count(XenObjectType::VM) > 0);
+        }
+
+        void cacheResend_data()
+        {
+            this->addSizes();
+        }
+
+        void cacheResend()
+        {
+            // event.from after a reconnect resends every record; the unchanged
+            // ones should cost a diff and nothing else
+            QFETCH(int, objects);
+            const Fixture& data = this->fixture(objects);
+            this->prepare(objects);
+
+            XenCache* cache = this->m_connection->GetCache();
+            int notified = 0;
+            QObject receiver;
+            connect(cache, &XenCache::itemChanged, &receiver, [&notified]() { ++notified; });
+
+            QBENCHMARK
+            {
+                for (const CacheEvent& event : data.events)
+                    cache->Update(event.type, event.ref, event.snapshot);
+                QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+            }
+            QCOMPARE(notified, 0);
+        }
+
+        void populateAdapters_data()
+        {
+            this->addSizes();
+        }
+
+        void populateAdapters()
+        {
+            QFETCH(int, objects);
+            this->prepare(objects);
+
+            int count = 0;
+            QBENCHMARK
+            {
+                CountingAcceptor acceptor;
+                this->m_search->PopulateAdapters(this->m_connection, {&acceptor});
+                count = acceptor.GetCount();
+            }
+            QVERIFY(count > 0);
+        }
+
+        void refreshTreeView_data()
+        {
+            this->addSizes();
+        }
+
+        void refreshTreeView()
+        {
+            QFETCH(int, objects);
+            this->prepare(objects);
+
+            QTreeWidget tree;
+            MainWindowTreeBuilder builder(&tree);
+            QBENCHMARK
+            {
+                QTreeWidgetItem* root = builder.CreateNewRootNode(this->m_search, MainWindowTreeBuilder::NavigationMode::Objects,
+                                                                  this->m_connection);
+                builder.RefreshTreeView(root, QString(), MainWindowTreeBuilder::NavigationMode::Objects);
+            }
+            QCOMPARE(tree.topLevelItemCount(), 1);
+            QVERIFY(tree.topLevelItem(0)->childCount() > 0);
+        }
+
+        void foldersRebuild_data()
+        {
+            this->addSizes();
+        }
+
+        void foldersRebuild()
+        {
+            QFETCH(int, objects);
+            this->prepare(objects);
+
+            // Attach the manager to this connection only; going through
+            // ConnectionsManager would also start heartbeats against the mock.
+            // Attaching builds the folder index from scratch.
+            FoldersManager* folders = FoldersManager::instance();
+            QBENCHMARK
+            {
+                QMetaObject::invokeMethod(folders, "onConnectionAdded", Qt::DirectConnection,
+                                          Q_ARG(XenConnection*, this->m_connection));
+                QMetaObject::invokeMethod(folders, "onConnectionRemoved", Qt::DirectConnection,
+                                          Q_ARG(XenConnection*, this->m_connection));
+            }
+            QMetaObject::invokeMethod(folders, "onConnectionAdded", Qt::DirectConnection,
+                                      Q_ARG(XenConnection*, this->m_connection));
+            QVERIFY(folders->HasSubfolders(this->m_connection, FoldersManager::PATH_SEPARATOR));
+            QMetaObject::invokeMethod(folders, "onConnectionRemoved", Qt::DirectConnection,
+                                      Q_ARG(XenConnection*, this->m_connection));
+        }
+
+        void foldersUpdate_data()
+        {
+            this->addSizes();
+        }
+
+        void foldersUpdate()
+        {
+            // One VM moving between folders plus one power state change, the
+            // common steady-state event mix; only the move touches the index
+            QFETCH(int, objects);
+            this->prepare(objects);
+
+            FoldersManager* folders = FoldersManager::instance();
+            QMetaObject::invokeMethod(folders, "onConnectionAdded", Qt::DirectConnection,
+                                      Q_ARG(XenConnection*, this->m_connection));
+            XenCache* cache = this->m_connection->GetCache();
+            const QStringList refs = cache->GetAllRefs(XenObjectType::VM);
+            QVERIFY(refs.size() >= 2);
+            QVariantMap moved = cache->ResolveObjectData(XenObjectType::VM, refs.first());
+            QVariantMap running = cache->ResolveObjectData(XenObjectType::VM, refs.last());
+
+            int round = 0;
+            QBENCHMARK
+            {
+                QVariantMap otherConfig = moved.value("other_config").toMap();
+                otherConfig[FoldersManager::FOLDER_KEY] = QString("/Bench/Folder %1").arg(++round % 2);
+                moved["other_config"] = otherConfig;
+                running["power_state"] = (round % 2) ? "Running" : "Halted";
+                cache->Update(XenObjectType::VM, refs.first(), moved);
+                cache->Update(XenObjectType::VM, refs.last(), running);
+                QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+            }
+            QVERIFY(folders->ContainsResources(this->m_connection, "/Bench"));
+            QMetaObject::invokeMethod(folders, "onConnectionRemoved", Qt::DirectConnection,
+                                      Q_ARG(XenConnection*, this->m_connection));
+            this->m_loaded = -1;
+        }
+
+        void cacheStrings_data()
+        {
+            QTest::addColumn<int>("objects");
+            QTest::addColumn<bool>("interned");
+            for (int objects : { 10000, 100000 })
+            {
+                QTest::newRow(qPrintable(QString("plain-%1k").arg(objects / 1000))) << objects << false;
+                QTest::newRow(qPrintable(QString("interned-%1k").arg(objects / 1000))) << objects << true;
+            }
+        }
+
+        void cacheStrings()
+        {
+            // Reported as bytes of string storage held by the cache after loading
+            // the pool dump, with and without the intern table
+            QFETCH(int, objects);
+            QFETCH(bool, interned);
+            const Fixture& data = this->fixture(objects);
+
+            XenCache cache(nullptr);
+            cache.SetStringInterning(interned);
+            for (const CacheEvent& event : data.events)
+                cache.Update(event.type, event.ref, event.snapshot);
+
+            QSet<XenObjectType> types;
+            for (const CacheEvent& event : data.events)
+                types.insert(event.type);
+
+            QSet<const void*> seen;
+            qint64 bytes = 0;
+            for (XenObjectType objectType : std::as_const(types))
+            {
+                const QStringList refs = cache.GetAllRefs(objectType);
+                for (const QString& ref : refs)
+                {
+                    bytes += stringBytes(ref, seen);
+                    bytes += stringBytes(QVariant(cache.ResolveObjectData(objectType, ref)), seen);
+                }
+            }
+            QTest::setBenchmarkResult(bytes, QTest::BytesAllocated);
+            QVERIFY(bytes > 0);
+            QCOMPARE(cache.InternedStringCount() > 0, interned);
+        }
+
+        void cacheDispatch_data()
+        {
+            QTest::addColumn<int>("listeners");
+            QTest::addColumn<bool>("targeted");
+            for (int listeners : { 100, 1000 })
+            {
+                QTest::newRow(qPrintable(QString("broadcast-%1").arg(listeners))) << listeners << false;
+                QTest::newRow(qPrintable(QString("subscribed-%1").arg(listeners))) << listeners << true;
+            }
+        }
+
+        void cacheDispatch()
+        {
+            // One listener per VM (console tabs, property dialogs) while every
+            // VM changes once: itemChanged() reaches every listener for every
+            // change, a subscription only the one that asked
+            QFETCH(int, listeners);
+            QFETCH(bool, targeted);
+            const int vms = 1000;
+
+            XenCache cache(nullptr);
+            QStringList refs;
+            for (int i = 0; i < vms; ++i)
+            {
+                refs.append(QString("OpaqueRef:dispatch-vm-%1").arg(i));
+                cache.Update(XenObjectType::VM, refs.last(), QVariantMap{ { "power_state", "Halted" } });
+            }
+
+            QObject receiver;
+            int delivered = 0;
+            for (int i = 0; i < listeners; ++i)
+            {
+                const QString ref = refs.at(i % vms);
+                if (targeted)
+                {
+                    cache.Subscribe(&receiver, XenObjectType::VM, ref,
+                                    [&delivered](const QList<XenCacheChange>& changes) { delivered += changes.size(); },
+                                    QStringList{ "power_state" });
+                } else
+                {
+                    connect(&cache, &XenCache::itemChanged, &receiver,
+                            [&delivered, ref](XenConnection*, XenObjectType type, const QString& changed) {
+                                if (type == XenObjectType::VM && changed == ref)
+                                    ++delivered;
+                            });
+                }
+            }
+            QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+
+            int round = 0;
+            QBENCHMARK
+            {
+                const QString state = (++round % 2) ? "Running" : "Halted";
+                for (const QString& ref : refs)
+                    cache.Update(XenObjectType::VM, ref, QVariantMap{ { "power_state", state } });
+                QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+            }
+            QCOMPARE(delivered, round * listeners);
+        }
+
+        void alertsOnConnect_data()
+        {
+            QTest::addColumn<int>("messages");
+            QTest::addColumn<bool>("streamed");
+            for (int messages : { 10000, 50000 })
+            {
+                QTest::newRow(qPrintable(QString("eager-%1k").arg(messages / 1000))) << messages << false;
+                QTest::newRow(qPrintable(QString("streamed-%1k").arg(messages / 1000))) << messages << true;
+            }
+        }
+
+        void alertsOnConnect()
+        {
+            // Reported as milliseconds the GUI thread is busy from the initial
+            // message burst until the newest alerts are in the Alerts model
+            QFETCH(int, messages);
+            QFETCH(bool, streamed);
+            using namespace XenLib;
+
+            QList<QVariantMap> records;
+            records.reserve(messages);
+            const qint64 base = QDateTime::currentSecsSinceEpoch() - messages;
+            for (int i = 0; i < messages; ++i)
+            {
+                records.append(QVariantMap{
+                    { "ref", QString("OpaqueRef:bench-message-%1").arg(i) },
+                    { "name", i % 3 ? "HA_HOST_FAILED" : "ALARM" },
+                    { "priority", i % 5 + 1 },
+                    { "obj_uuid", QString("vm-%1").arg(i % 500) },
+                    { "body", QString("value: %1\nconfig: <variable><name value=\"cpu_usage\"/></variable>").arg(i) },
+                    { "timestamp", base + i },
+                });
+            }
+
+            AlertManager* manager = AlertManager::instance();
+            manager->ClearAllAlerts();
+            AlertListModel model;
+            MessageAlertLoader* loader = MessageAlertLoader::instance();
+            XenConnection connection;
+
+            QElapsedTimer timer;
+            timer.start();
+            if (streamed)
+            {
+                for (const QVariantMap& record : std::as_const(records))
+                    loader->Enqueue(&connection, record);
+                QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+                QThreadPool::globalInstance()->waitForDone();
+                QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+            } else
+            {
+                for (const QVariantMap& record : std::as_const(records))
+                    manager->AddAlert(MessageAlert::ParseMessage(&connection, record));
+            }
+            QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+
+            QVERIFY(model.rowCount() > 0);
+            QCOMPARE(model.rowCount() + loader->PendingCount(), messages);
+
+            // Drop the backlog the streamed run left unparsed
+            while (loader->PendingCount() > 0)
+            {
+                loader->FetchMore();
+                QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+                QThreadPool::globalInstance()->waitForDone();
+                QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+            }
+            manager->ClearAllAlerts();
+        }
+
+        void eventFromTransport_data()
+        {
+            QTest::addColumn<int>("objects");
+            QTest::addColumn<bool>("compressed");
+            for (int objects : { 10000, 100000 })
+            {
+                QTest::newRow(qPrintable(QString("plain-%1k").arg(objects / 1000))) << objects << false;
+                QTest::newRow(qPrintable(QString("gzip-%1k").arg(objects / 1000))) << objects << true;
+            }
+        }
+
+        void eventFromTransport()
+        {
+            // Reported as milliseconds from sending the initial event.from until the
+            // reply body is decoded. Loopback shows the CPU cost of compression; the
+            // byte counts logged alongside are what a WAN link pays for
+            QFETCH(int, objects);
+            QFETCH(bool, compressed);
+            if (compressed && !HttpCompression::IsAvailable())
+                QSKIP("Built without zlib");
+
+            MockXapiServer server;
+            MockXapiInventory::Populate(*server.GetDatabase(), MockXapiInventory::OptionsForObjectCount(objects));
+            server.SetCompressionEnabled(true);
+            QVERIFY2(server.Start(), qPrintable(server.GetError()));
+
+            Xen::ConnectionWorker::SetResponseCompressionEnabled(compressed);
+            Xen::ConnectionWorker worker("127.0.0.1", server.GetPort());
+            worker.start();
+            const QByteArray login = worker.WaitForResponse(
+                worker.QueueRequest(jsonRpcRequest("session.login_with_password", { "root", "" }), false));
+            const QString session = QJsonDocument::fromJson(login).object().value("result").toString();
+            QVERIFY(!session.isEmpty());
+
+            const qint64 sentBefore = server.GetBytesSent();
+            QElapsedTimer timer;
+            timer.start();
+            const QByteArray reply = worker.WaitForResponse(
+                worker.QueueRequest(jsonRpcRequest("event.from", { session, QVariantList{ "*" }, "", 30.0 }), false));
+            QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+            const qint64 wireBytes = server.GetBytesSent() - sentBefore;
+
+            const QJsonArray events = QJsonDocument::fromJson(reply).object().value("result").toObject()
+                                          .value("events").toArray();
+            QCOMPARE(events.size(), server.GetDatabase()->GetTotalCount());
+            qInfo() << "event.from:" << reply.size() << "bytes decoded from" << wireBytes << "on the wire";
+
+            Xen::ConnectionWorker::SetResponseCompressionEnabled(true);
+            worker.RequestStop();
+            worker.wait();
+            server.Stop();
+        }
+
+        void gzipCompress_data()
+        {
+            QTest::addColumn<int>("threads");
+            QTest::newRow("gzwrite") << -1;
+            QTest::newRow("parallel-1") << 1;
+            QTest::newRow(qPrintable(QString("parallel-%1").arg(ParallelGzip::GetThreadCount()))) << 0;
+        }
+
+        void gzipCompress()
+        {
+            // 64 MiB at level 9 into a file: the gzopen/gzwrite loop compressVhds
+            // used to run against ParallelGzip on one thread and on every core
+            QFETCH(int, threads);
+            if (!HttpCompression::IsAvailable())
+                QSKIP("Built without zlib");
+#ifndef XENADMIN_NO_ZLIB
+            static const QByteArray raw = diskImage(64 * 1024 * 1024);
+            QTemporaryDir dir;
+            QVERIFY(dir.isValid());
+            const QString gzPath = dir.filePath("disk.vhd.gz");
+
+            QBENCHMARK
+            {
+                if (threads < 0)
+                {
+                    gzFile gz = gzopen(gzPath.toLocal8Bit().constData(), "wb9");
+                    QVERIFY(gz);
+                    for (qint64 offset = 0; offset < raw.size(); offset += 64 * 1024)
+                    {
+                        const unsigned int n = static_cast<unsigned int>(qMin<qint64>(64 * 1024, raw.size() - offset));
+                        QCOMPARE(gzwrite(gz, raw.constData() + offset, n), static_cast<int>(n));
+                    }
+                    QCOMPARE(gzclose(gz), Z_OK);
+                } else
+                {
+                    QFile out(gzPath);
+                    QVERIFY(out.open(QIODevice::WriteOnly));
+                    ParallelGzip gzip([&out](const char* data, qint64 size, QString&) {
+                        return out.write(data, size) == size;
+                    }, 9, threads);
+                    QVERIFY(gzip.Write(raw.constData(), raw.size()));
+                    QVERIFY(gzip.Finish());
+                }
+            }
+            qInfo() << "gzip level 9:" << raw.size() << "bytes to" << QFileInfo(gzPath).size();
+#endif
+        }
+
+        void parseRrdXml_data()
+        {
+            this->addSizes();
+        }
+
+        void parseRrdXml()
+        {
+            QFETCH(int, objects);
+            const Fixture& data = this->fixture(objects);
+
+            // The parser sits behind the reply slot; calling that skips only the HTTP fetch
+            MetricUpdater updater(this->m_connection);
+            QBENCHMARK
+            {
+                QMetaObject::invokeMethod(&updater, "onRrdDataReceived", Qt::DirectConnection,
+                                          Q_ARG(QByteArray, data.rrdUpdates));
+            }
+            const QList<CacheEvent>& events = data.events;
+            auto running = std::find_if(events.constBegin(), events.constEnd(), [](const CacheEvent& event) {
+                return event.type == XenObjectType::VM && event.snapshot.value("power_state") == "Running"
+                       && !event.snapshot.value("is_control_domain").toBool();
+            });
+            QVERIFY(running != events.constEnd());
+            QVERIFY(updater.hasMetrics("vm", running->snapshot.value("uuid").toString()));
+        }
+};
+
+int main(int argc, char* argv[])
+{
+    // The tree builder needs widgets, but benchmarks have to run on headless machines
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    XenAdminBenchmarks benchmarks;
+    return QTest::qExec(&benchmarks, argc, argv);
+}
+
+#include "bench_main.moc"
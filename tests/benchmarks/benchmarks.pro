@@ -0,0 +1,29 @@
+TEMPLATE = app
+CONFIG += warn_on c++17
+QT += testlib widgets network xml
+
+TARGET = xenadmin-benchmarks
+
+SOURCES += \
+    bench_main.cpp \
+    ../../src/xenadmin-ui/connectionprofile.cpp \
+    ../../src/xenadmin-ui/iconmanager.cpp \
+    ../../src/xenadmin-ui/mainwindowtreebuilder.cpp \
+    ../../src/xenadmin-ui/settingsmanager.cpp \
+    ../../src/xenadmin-ui/tabpages/alertlistmodel.cpp
+
+HEADERS += \
+    ../../src/xenadmin-ui/connectionprofile.h \
+    ../../src/xenadmin-ui/iconmanager.h \
+    ../../src/xenadmin-ui/mainwindowtreebuilder.h \
+    ../../src/xenadmin-ui/settingsmanager.h \
+    ../../src/xenadmin-ui/tabpages/alertlistmodel.h
+
+INCLUDEPATH += \
+    ../../src \
+    ../../src/xenadmin-ui \
+    ../../src/xenlib
+
+# Link with prebuilt xenlib and mockxapi (user-managed build output)
+LIBS += -L../../release/xenlib -lxenlib
+LIBS += -L../../release/mockxapi -lmockxapi
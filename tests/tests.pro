@@ -3,7 +3,9 @@ CONFIG += ordered
 
 SUBDIRS = \
     xenlib \
-    xenadmin-ui
+    xenadmin-ui \
+    benchmarks
 
 xenlib.file = xenlib/xenlib-tests.pro
 xenadmin-ui.file = xenadmin-ui/xenadmin-ui-tests.pro
+benchmarks.file = benchmarks/benchmarks.pro
@@ -3,9 +3,57 @@
 #include "xenlib/xen/vm.h"
 #include "xenlib/xen/xenobjecttype.h"
 #include "xenlib/ovf/ovfpackage.h"
+#include "xenlib/ovf/ovfwriter.h"
+#include "xenlib/ovf/ovatar.h"
+#include "xenlib/ovf/ovaarchive.h"
+#include "xenlib/ovf/ovfdisksource.h"
+#include "xenlib/ovf/ovfexportstream.h"
+#include "xenlib/xen/network/transferbatch.h"
+#include "xenlib/diskimage/diskimagereader.h"
+#include "xenlib/diskimage/sparsevhdstream.h"
+#include "xenlib/xen/network/transferlimits.h"
+#include "xenlib/xen/network/httpclient.h"
+#include "xenlib/xen/network/httpconnectionpool.h"
+#include "xenlib/utils/copypipeline.h"
+#include "xenlib/utils/parallelgzip.h"
+#include "xenlib/utils/httpcompression.h"
+#include "xenlib/utils/stringpool.h"
+#include "xenlib/utils/memoryaccountant.h"
+#include "xenlib/xva/xvaverifier.h"
+#include "xenlib/xen/network/connectionworker.h"
+#include "xenlib/xen/network/wirerecorder.h"
+#include "xenlib/xen/network/wirereplay.h"
+#include "xenlib/xen/network/rpctracer.h"
+#include "xenlib/alerts/alertmanager.h"
+#include "xenlib/alerts/messagealert.h"
+#include "xenlib/alerts/messagealertloader.h"
+#include "xenlib/alerts/alarmmessagealert.h"
+#include "xenlib/folders/foldersmanager.h"
+#include "xenlib/otherconfig/otherconfigandtagswatcher.h"
+#include "xenlib/xen/network/connection.h"
+#include "mockxapi/mockxapidatabase.h"
+#include "mockxapi/mockxapiinventory.h"
+#include "mockxapi/mockxapiserver.h"
 #include "test_helpers.h"
 #include <QTemporaryFile>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
 #include <QTextStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QBuffer>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSslSocket>
+#include <cstring>
+#include <memory>
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Helpers: build minimal cache entries to exercise VM methods in isolation
@@ -30,6 +78,53 @@ static QVariantMap normalVm(const QString& powerState = "Halted",
     return d;
 }
 
+// Deflate "stored" block (no compression), enough to exercise the
+// compressed-cluster paths of the image readers without a compressor
+static QByteArray storedDeflate(const QByteArray& data)
+{
+    QByteArray out;
+    out.append(char(0x01));   // BFINAL=1, BTYPE=00
+    const quint16 len = static_cast<quint16>(data.size());
+    out.append(char(len & 0xff)).append(char(len >> 8));
+    out.append(char(~len & 0xff)).append(char((~len >> 8) & 0xff));
+    return out + data;
+}
+
+static QByteArray storedZlib(const QByteArray& data)
+{
+    quint32 a = 1, b = 0;
+    for (char c : data)
+    {
+        a = (a + static_cast<quint8>(c)) % 65521;
+        b = (b + a) % 65521;
+    }
+    uchar adler[4];
+    qToBigEndian<quint32>((b << 16) | a, adler);
+    return QByteArray("\x78\x01", 2) + storedDeflate(data) + QByteArray(reinterpret_cast<const char*>(adler), 4);
+}
+
+static QByteArray patternBlock(int size, int seed)
+{
+    QByteArray block(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        block[i] = static_cast<char>((i * 7 + seed) % 251 + 1);
+    return block;
+}
+
+// Blocking JSON-RPC call through a worker, the way XenConnection::SendRequest makes it
+static QJsonObject jsonRpc(Xen::ConnectionWorker& worker, const QString& method, const QVariantList& params)
+{
+    static QAtomicInt nextId(1);
+    const QJsonObject request{
+        {"jsonrpc", "2.0"},
+        {"method", method},
+        {"params", QJsonArray::fromVariantList(params)},
+        {"id", nextId.fetchAndAddRelaxed(1)},
+    };
+    const int id = worker.QueueRequest(QJsonDocument(request).toJson(QJsonDocument::Compact), false);
+    return QJsonDocument::fromJson(worker.WaitForResponse(id, 10000)).object();
+}
+
 class XenLibTests : public QObject
 {
     Q_OBJECT
@@ -390,6 +485,1785 @@ private slots:
         QVERIFY(cfg["uefivm"].contains("HVM_boot_policy"));
         QCOMPARE(cfg["uefivm"]["HVM_boot_policy"], QString(""));
     }
+
+    // ── OvaTar / OvaTarWriter ────────────────────────────────────────────────
+
+    void ovaTar_sizeField_roundTripsOctalAndBase256()
+    {
+        const qint64 sizes[] = { 0, 511, 512, OvaTar::MAX_OCTAL_SIZE,
+                                 OvaTar::MAX_OCTAL_SIZE + 1, 2LL * 1024 * 1024 * 1024 * 1024 };
+        for (qint64 size : sizes)
+        {
+            char header[OvaTar::BLOCK_SIZE];
+            OvaTar::FillHeader(header, "disk.vhd", size);
+            QCOMPARE(OvaTar::ParseSize(header + 124), size);
+        }
+    }
+
+    void ovaTarWriter_streamedMembers_passVerifyOva()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString ovaPath = dir.filePath("test.ova");
+
+        const QByteArray ovf  = "<Envelope/>";
+        const QByteArray disk = QByteArray(1000, 'x');
+        auto sha = [](const QByteArray& data) {
+            return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+        };
+        const QByteArray mf = (OvfWriter::manifestLine("test.ovf", sha(ovf)) + "\n"
+                               + OvfWriter::manifestLine("disk.vhd", sha(disk)) + "\n").toUtf8();
+
+        QFile file(ovaPath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        OvaTarWriter tar(&file);
+        QVERIFY(tar.AddMember("test.ovf", ovf));
+        QVERIFY(tar.BeginMember("disk.vhd"));
+        QVERIFY(tar.WriteMemberData(disk.constData(), 300));
+        QVERIFY(tar.WriteMemberData(disk.constData() + 300, disk.size() - 300));
+        QVERIFY(tar.EndMember());
+        QVERIFY(tar.AddMember("test.mf", mf));
+        QVERIFY(tar.Finish());
+        file.close();
+
+        QString error;
+        QVERIFY2(OvfWriter().verifyOva(ovaPath, error), qPrintable(error));
+    }
+
+    void ovfDiskSource_gzipMemberInOva_inflatesAndHashesStoredBytes()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString ovaPath = dir.filePath("test.ova");
+
+        QByteArray disk;
+        for (int i = 0; i < 200000; ++i)
+            disk.append(static_cast<char>(i % 251));
+
+        // Two concatenated gzip members, as written by parallel compressors
+        QByteArray stored;
+        auto gzipInto = [&stored](const QByteArray& data) {
+            OvfDiskStream stream(true, [&stored](const char* p, qint64 n, QString&) {
+                stored.append(p, static_cast<int>(n));
+                return true;
+            });
+            return stream.Start() && stream.write(data) == data.size() && stream.Finish();
+        };
+        QVERIFY(gzipInto(disk.left(70000)));
+        QVERIFY(gzipInto(disk.mid(70000)));
+
+        QFile file(ovaPath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        OvaTarWriter tar(&file);
+        QVERIFY(tar.AddMember("test.ovf", "<Envelope/>"));
+        QVERIFY(tar.AddMember("disk.vhd.gz", stored));
+        QVERIFY(tar.Finish());
+        file.close();
+
+        OvaArchive archive;
+        QString error;
+        QVERIFY2(archive.Open(ovaPath, error), qPrintable(error));
+        QCOMPARE(archive.Members().size(), 2);
+        const OvaMember* member = archive.FindMember("subdir/disk.vhd.gz");
+        QVERIFY(member);
+        QCOMPARE(member->size, static_cast<qint64>(stored.size()));
+
+        OvfDiskSource source(ovaPath, member->dataOffset, member->size, true);
+        source.SetDigestAlgorithm(QCryptographicHash::Sha256);
+        QVERIFY(source.open(QIODevice::ReadOnly));
+        QCOMPARE(source.ContentSize(error), static_cast<qint64>(disk.size()));
+
+        QByteArray inflated;
+        char buf[4096];
+        while (!source.atEnd())
+        {
+            const qint64 n = source.read(buf, sizeof(buf));
+            QVERIFY(n >= 0);
+            inflated.append(buf, static_cast<int>(n));
+        }
+        QCOMPARE(inflated, disk);
+        QCOMPARE(source.GetDigestHex(),
+                 QString::fromLatin1(QCryptographicHash::hash(stored, QCryptographicHash::Sha256).toHex()));
+    }
+
+    void transferBatch_respectsConnectionLimitAndStopsOnFailure()
+    {
+        const int previousLimit = TransferLimits::GetMaxTransfersPerConnection();
+        TransferLimits::SetMaxTransfersPerConnection(2);
+
+        QMutex mutex;
+        int active = 0;
+        int peak = 0;
+        int completed = 0;
+        auto job = [&](const TransferBatch::ReportFunction& report, const TransferBatch::CancelFunction&) {
+            {
+                QMutexLocker locker(&mutex);
+                peak = qMax(peak, ++active);
+            }
+            QThread::msleep(30);
+            report(10, 10);
+            QMutexLocker locker(&mutex);
+            --active;
+            ++completed;
+        };
+
+        TransferBatch batch(nullptr, "host");
+        for (int i = 0; i < 5; ++i)
+            batch.AddJob(QString("disk%1").arg(i), 10, job);
+        int lastPercent = -1;
+        QVERIFY(batch.Run([&](int pct, const QString&) { lastPercent = pct; }, nullptr));
+        QCOMPARE(completed, 5);
+        QCOMPARE(lastPercent, 100);
+        QVERIFY(peak <= 2);
+
+        TransferBatch failing(nullptr, "host");
+        failing.AddJob("bad", 1, [](const TransferBatch::ReportFunction&, const TransferBatch::CancelFunction&) {
+            throw std::runtime_error("boom");
+        });
+        QVERIFY(!failing.Run(nullptr, nullptr));
+        QVERIFY(!failing.WasCancelled());
+        QVERIFY(failing.GetError().contains("boom"));
+
+        TransferLimits::SetMaxTransfersPerConnection(previousLimit);
+    }
+
+    void sparseVhdStream_rawImage_skipsZeroBlocksAndRoundTrips()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // 10 MiB + 1 KiB raw image with data in the first and fourth 2 MiB blocks only
+        const qint64 size = 10 * 1024 * 1024 + 1024;
+        QByteArray raw(static_cast<int>(size), '\0');
+        for (int i = 0; i < 4096; ++i)
+            raw[100 + i] = static_cast<char>(i % 253 + 1);
+        raw[3 * 2 * 1024 * 1024 + 7] = 'x';
+        const QString rawPath = dir.filePath("disk.img");
+        QFile rawFile(rawPath);
+        QVERIFY(rawFile.open(QIODevice::WriteOnly));
+        QCOMPARE(rawFile.write(raw), size);
+        rawFile.close();
+
+        QString error;
+        std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(rawPath, 0, -1, error));
+        QVERIFY2(reader, qPrintable(error));
+        QCOMPARE(reader->FormatName(), QString("raw"));
+
+        SparseVhdStream stream(reader.get());
+        QVERIFY2(stream.Prepare(error), qPrintable(error));
+        QCOMPARE(stream.BlockCount(), 6);
+        QCOMPARE(stream.DataBlockCount(), 2);
+        QVERIFY(stream.open(QIODevice::ReadOnly));
+        QByteArray vhd;
+        char buf[65536];
+        while (!stream.atEnd())
+        {
+            const qint64 n = stream.read(buf, sizeof(buf));
+            QVERIFY(n >= 0);
+            vhd.append(buf, static_cast<int>(n));
+        }
+        QCOMPARE(static_cast<qint64>(vhd.size()), stream.ContentSize());
+
+        // The generated dynamic VHD must read back as the original disk
+        const QString vhdPath = dir.filePath("disk.vhd");
+        QFile vhdFile(vhdPath);
+        QVERIFY(vhdFile.open(QIODevice::WriteOnly));
+        QCOMPARE(vhdFile.write(vhd), static_cast<qint64>(vhd.size()));
+        vhdFile.close();
+
+        std::unique_ptr<DiskImageReader> vhdReader(DiskImageReader::Create(vhdPath, 0, -1, error));
+        QVERIFY2(vhdReader, qPrintable(error));
+        QCOMPARE(vhdReader->FormatName(), QString("vhd"));
+        QCOMPARE(vhdReader->VirtualSize(), size);
+        QCOMPARE(vhdReader->AllocatedExtents().size(), 2);
+        QVERIFY(!reader->HasExactAllocationMap());
+        QVERIFY(vhdReader->HasExactAllocationMap());
+        QByteArray back(static_cast<int>(size), Qt::Uninitialized);
+        QVERIFY2(vhdReader->Read(0, back.data(), size, error), qPrintable(error));
+        QVERIFY(back == raw);
+
+        // Gzipped, the upload length comes from the header and BAT checked
+        // against the gzip trailer. A corrupt byte near the end of the deflate
+        // data shows the rest of the disk was never inflated to count it.
+        auto gzipFile = [&dir](const QString& name, const QByteArray& data) {
+            QByteArray stored;
+            OvfDiskStream gzip(true, [&stored](const char* p, qint64 n, QString&) {
+                stored.append(p, static_cast<int>(n));
+                return true;
+            });
+            gzip.Start();
+            gzip.write(data);
+            gzip.Finish();
+            stored[stored.size() - 40] = static_cast<char>(stored.at(stored.size() - 40) ^ 0x5a);
+            QFile file(dir.filePath(name));
+            file.open(QIODevice::WriteOnly);
+            file.write(stored);
+            return qMakePair(file.fileName(), static_cast<qint64>(stored.size()));
+        };
+        const auto vhdGz = gzipFile("disk.vhd.gz", vhd);
+        QCOMPARE(OvfDiskSource(vhdGz.first, 0, vhdGz.second, true).ContentSize(error), static_cast<qint64>(vhd.size()));
+
+        // A raw disk is sized from the capacity the OVF declares
+        const auto rawGz = gzipFile("disk.img.gz", raw);
+        QCOMPARE(OvfDiskSource(rawGz.first, 0, rawGz.second, true).ContentSize(error, size), size);
+        QCOMPARE(OvfDiskSource(rawGz.first, 0, rawGz.second, true).ContentSize(error, size + 4096), qint64(-1));
+    }
+    void qcow2ImageReader_plainCompressedAndZeroClusters_readBack()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // v3 image, 4 KiB clusters, 64 KiB disk:
+        // cluster 1 plain, cluster 2 compressed, cluster 6 zero-flagged over garbage
+        const int cs = 4096;
+        const QByteArray a = patternBlock(cs, 1);
+        const QByteArray b = patternBlock(cs, 2);
+        const QByteArray deflated = storedDeflate(b);
+        QByteArray img(24576 + 4608, '\0');
+        uchar* p = reinterpret_cast<uchar*>(img.data());
+        qToBigEndian<quint32>(0x514649fb, p);
+        qToBigEndian<quint32>(3, p + 4);
+        qToBigEndian<quint32>(12, p + 20);
+        qToBigEndian<quint64>(16 * cs, p + 24);
+        qToBigEndian<quint32>(1, p + 36);
+        qToBigEndian<quint64>(4096, p + 40);
+        qToBigEndian<quint32>(4, p + 96);
+        qToBigEndian<quint32>(104, p + 100);
+        qToBigEndian<quint64>(8192 | (1ull << 63), p + 4096);
+        qToBigEndian<quint64>(12288 | (1ull << 63), p + 8192 + 1 * 8);
+        qToBigEndian<quint64>((1ull << 62) | (8ull << 58) | 24576, p + 8192 + 2 * 8);
+        qToBigEndian<quint64>(20480 | 1, p + 8192 + 6 * 8);
+        img.replace(12288, cs, a);
+        img.replace(20480, cs, QByteArray(cs, 'g'));
+        img.replace(24576, deflated.size(), deflated);
+
+        const QString path = dir.filePath("disk.qcow2");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(img), static_cast<qint64>(img.size()));
+        file.close();
+
+        QString error;
+        std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(path, 0, -1, error));
+        QVERIFY2(reader, qPrintable(error));
+        QCOMPARE(reader->FormatName(), QString("qcow2"));
+        QCOMPARE(reader->VirtualSize(), static_cast<qint64>(16 * cs));
+        QCOMPARE(reader->AllocatedExtents().size(), 1);
+        QCOMPARE(reader->AllocatedExtents().first().offset, static_cast<qint64>(cs));
+        QCOMPARE(reader->AllocatedExtents().first().length, static_cast<qint64>(2 * cs));
+
+        QByteArray expected(16 * cs, '\0');
+        expected.replace(cs, cs, a);
+        expected.replace(2 * cs, cs, b);
+        QByteArray back(16 * cs, Qt::Uninitialized);
+        QVERIFY2(reader->Read(0, back.data(), back.size(), error), qPrintable(error));
+        QVERIFY(back == expected);
+
+        // Unaligned read straddling the plain and the compressed cluster
+        QByteArray part(5000, Qt::Uninitialized);
+        QVERIFY2(reader->Read(cs + 100, part.data(), part.size(), error), qPrintable(error));
+        QVERIFY(part == expected.mid(cs + 100, 5000));
+
+        SparseVhdStream stream(reader.get());
+        QVERIFY2(stream.Prepare(error), qPrintable(error));
+        QCOMPARE(stream.DataBlockCount(), 1);
+
+        // Header fields that would size allocations are bounded before use
+        auto rejects = [&](int offset, quint64 value, int width) {
+            QByteArray bad = img;
+            if (width == 8)
+                qToBigEndian<quint64>(value, reinterpret_cast<uchar*>(bad.data()) + offset);
+            else
+                qToBigEndian<quint32>(static_cast<quint32>(value), reinterpret_cast<uchar*>(bad.data()) + offset);
+            QFile out(dir.filePath("bad.qcow2"));
+            if (!out.open(QIODevice::WriteOnly) || out.write(bad) != bad.size())
+                return false;
+            out.close();
+            QString badError;
+            std::unique_ptr<DiskImageReader> badReader(DiskImageReader::Create(out.fileName(), 0, -1, badError));
+            return !badReader && badError.contains("Corrupt");
+        };
+        QVERIFY(rejects(36, 0x80000000u, 4));        // L1 far beyond the virtual size
+        QVERIFY(rejects(36, 2, 4));                  // one entry too many
+        QVERIFY(rejects(24, ~0ull, 8));              // negative virtual size
+        QVERIFY(rejects(24, 0, 8));
+    }
+
+    void vmdkImageReader_streamOptimized_readsFooterAndCompressedGrain()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // 64 KiB disk, 4 KiB grains; grain 3 compressed, grain 7 a zero grain.
+        // Sectors: 0 header (GD at end), 1-9 grain, 10-13 GT, 14 GD,
+        // 15 footer marker, 16 footer header, 17 end-of-stream marker
+        const int grain = 4096;
+        const QByteArray data = patternBlock(grain, 3);
+        const QByteArray zlib = storedZlib(data);
+        QByteArray img(18 * 512, '\0');
+        uchar* p = reinterpret_cast<uchar*>(img.data());
+
+        auto writeHeader = [](uchar* h, quint64 gdOffset) {
+            std::memcpy(h, "KDMV", 4);
+            qToLittleEndian<quint32>(3, h + 4);
+            qToLittleEndian<quint32>(1 | (1u << 16) | (1u << 17), h + 8);
+            qToLittleEndian<quint64>(128, h + 12);
+            qToLittleEndian<quint64>(8, h + 20);
+            qToLittleEndian<quint32>(512, h + 44);
+            qToLittleEndian<quint64>(gdOffset, h + 56);
+            qToLittleEndian<quint16>(1, h + 77);
+        };
+        writeHeader(p, ~0ull);
+        writeHeader(p + 16 * 512, 14);
+
+        qToLittleEndian<quint64>(3 * 8, p + 512);
+        qToLittleEndian<quint32>(static_cast<quint32>(zlib.size()), p + 512 + 8);
+        img.replace(512 + 12, zlib.size(), zlib);
+        qToLittleEndian<quint32>(1, p + 10 * 512 + 3 * 4);
+        qToLittleEndian<quint32>(1, p + 10 * 512 + 7 * 4);
+        qToLittleEndian<quint32>(10, p + 14 * 512);
+
+        const QString path = dir.filePath("disk.vmdk");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(img), static_cast<qint64>(img.size()));
+        file.close();
+
+        QString error;
+        std::unique_ptr<DiskImageReader> reader(DiskImageReader::Create(path, 0, -1, error));
+        QVERIFY2(reader, qPrintable(error));
+        QCOMPARE(reader->FormatName(), QString("vmdk"));
+        QCOMPARE(reader->VirtualSize(), static_cast<qint64>(16 * grain));
+        QCOMPARE(reader->AllocatedExtents().size(), 1);
+        QCOMPARE(reader->AllocatedExtents().first().offset, static_cast<qint64>(3 * grain));
+
+        QByteArray expected(16 * grain, '\0');
+        expected.replace(3 * grain, grain, data);
+        QByteArray back(16 * grain, Qt::Uninitialized);
+        QVERIFY2(reader->Read(0, back.data(), back.size(), error), qPrintable(error));
+        QVERIFY(back == expected);
+
+        // A descriptor naming the extent resolves to the same reader
+        const QString descPath = dir.filePath("disk-desc.vmdk");
+        QFile desc(descPath);
+        QVERIFY(desc.open(QIODevice::WriteOnly));
+        desc.write("# Disk DescriptorFile\nversion=1\nparentCID=ffffffff\n"
+                   "createType=\"streamOptimized\"\nRW 128 SPARSE \"disk.vmdk\"\n");
+        desc.close();
+        std::unique_ptr<DiskImageReader> viaDesc(DiskImageReader::Create(descPath, 0, -1, error));
+        QVERIFY2(viaDesc, qPrintable(error));
+        QCOMPARE(viaDesc->FormatName(), QString("vmdk"));
+        QCOMPARE(viaDesc->VirtualSize(), reader->VirtualSize());
+
+        // A grain table size beyond what VMware writes is a corrupt header
+        QByteArray bad = img;
+        qToLittleEndian<quint32>(0x40000000u, reinterpret_cast<uchar*>(bad.data()) + 16 * 512 + 44);
+        QFile badFile(dir.filePath("bad.vmdk"));
+        QVERIFY(badFile.open(QIODevice::WriteOnly));
+        QCOMPARE(badFile.write(bad), static_cast<qint64>(bad.size()));
+        badFile.close();
+        std::unique_ptr<DiskImageReader> badReader(DiskImageReader::Create(badFile.fileName(), 0, -1, error));
+        QVERIFY(!badReader);
+        QVERIFY(error.contains("Corrupt VMDK header"));
+    }
+
+    void xenCacheWaitFor_wakesOnMatchingUpdateAndTimesOut()
+    {
+        XenCache* cache = XenCache::GetDummy();
+        const QString ref = "OpaqueRef:wait-vm";
+        cache->Update(XenObjectType::VM, ref, normalVm("Running"));
+        auto halted = [cache, ref]() {
+            return cache->ResolveObjectData(XenObjectType::VM, ref).value("power_state").toString() == "Halted";
+        };
+
+        // Unrelated changes must not satisfy the wait; the matching one must end it
+        QThread* writer = QThread::create([cache, ref]() {
+            QThread::msleep(50);
+            cache->Update(XenObjectType::VM, "OpaqueRef:other-vm", normalVm("Halted"));
+            cache->Update(XenObjectType::Host, "OpaqueRef:host", QVariantMap());
+            QThread::msleep(50);
+            cache->Update(XenObjectType::VM, ref, normalVm("Halted"));
+        });
+        QElapsedTimer timer;
+        timer.start();
+        writer->start();
+        QVERIFY(cache->WaitFor(XenObjectType::VM, ref, halted, 10000));
+        QVERIFY(timer.elapsed() < 5000);
+        writer->wait();
+        delete writer;
+
+        // Condition never met: times out; cancellation ends the wait early
+        auto never = []() { return false; };
+        QVERIFY(!cache->WaitFor(XenObjectType::VM, ref, never, 100));
+        timer.restart();
+        QVERIFY(!cache->WaitFor(XenObjectType::VM, ref, never, 60000, []() { return true; }));
+        QVERIFY(timer.elapsed() < 5000);
+
+        // WaitForChanged starts with "everything" and then hands over just the changed refs
+        QList<QStringList> seen;
+        auto imported = [&seen](const QStringList& changed) {
+            seen.append(changed);
+            return changed.contains("OpaqueRef:imported-vm");
+        };
+        writer = QThread::create([cache]() {
+            QThread::msleep(50);
+            cache->Update(XenObjectType::Host, "OpaqueRef:host", QVariantMap{ { "name_label", "h" } });
+            cache->Update(XenObjectType::VM, "OpaqueRef:imported-vm", normalVm("Halted"));
+        });
+        writer->start();
+        QVERIFY(cache->WaitForChanged({ XenObjectType::VM }, QStringList(), imported, 10000));
+        writer->wait();
+        delete writer;
+        QVERIFY(seen.size() >= 2);
+        QVERIFY(seen.first().isEmpty());
+        QCOMPARE(seen.last(), QStringList{ "OpaqueRef:imported-vm" });
+
+        cache->Remove(XenObjectType::VM, "OpaqueRef:imported-vm");
+        cache->Remove(XenObjectType::VM, ref);
+        cache->Remove(XenObjectType::VM, "OpaqueRef:other-vm");
+        cache->Remove(XenObjectType::Host, "OpaqueRef:host");
+    }
+    void xenCacheSubscribe_deliversTargetedCoalescedChanges()
+    {
+        XenCache cache(nullptr);
+        const QString vm1 = "OpaqueRef:sub-vm1";
+        const QString vm2 = "OpaqueRef:sub-vm2";
+        cache.Update(XenObjectType::VM, vm1, normalVm("Halted"));
+
+        QObject* receiver = new QObject();
+        QList<XenCacheChange> objectChanges;
+        QList<XenCacheChange> powerChanges;
+        int objectCalls = 0;
+        int hostCalls = 0;
+        cache.Subscribe(receiver, XenObjectType::VM, vm1, [&](const QList<XenCacheChange>& changes) {
+            objectCalls++;
+            objectChanges += changes;
+        });
+        cache.Subscribe(receiver, XenObjectType::VM, [&](const QList<XenCacheChange>& changes) {
+            powerChanges += changes;
+        }, QStringList{ "power_state" });
+        const int hostSubscription = cache.Subscribe(receiver, XenObjectType::Host, "OpaqueRef:sub-host",
+                                                     [&](const QList<XenCacheChange>&) { hostCalls++; });
+        QCOMPARE(cache.SubscriptionCount(), 3);
+
+        // Three updates of vm1 in one turn coalesce into one delivery; the
+        // name-only change does not pass the power_state mask
+        QVariantMap renamed = normalVm("Halted");
+        renamed["name_label"] = "Renamed";
+        cache.Update(XenObjectType::VM, vm1, renamed);
+        cache.Update(XenObjectType::VM, vm1, normalVm("Running"));
+        cache.Update(XenObjectType::VM, vm1, normalVm("Running"));
+        cache.Update(XenObjectType::VM, vm2, normalVm("Halted"));
+        cache.Update(XenObjectType::Host, "OpaqueRef:other-host", QVariantMap());
+        QCOMPARE(objectCalls, 0);
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+
+        QCOMPARE(objectCalls, 1);
+        QCOMPARE(objectChanges.size(), 1);
+        QCOMPARE(objectChanges.first().ref, vm1);
+        QCOMPARE(objectChanges.first().fields, (QStringList{ "name_label", "power_state" }));
+        QCOMPARE(powerChanges.size(), 2);
+        QCOMPARE(powerChanges.at(0).ref, vm1);
+        QCOMPARE(powerChanges.at(0).fields, QStringList{ "power_state" });
+        QCOMPARE(powerChanges.at(1).ref, vm2);
+        QCOMPARE(hostCalls, 0);
+
+        objectChanges.clear();
+        powerChanges.clear();
+        renamed["power_state"] = "Running";
+        cache.Update(XenObjectType::VM, vm1, renamed);
+        cache.Remove(XenObjectType::VM, vm2);
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+        QCOMPARE(objectChanges.size(), 1);
+        QVERIFY(!objectChanges.first().removed);
+        QCOMPARE(powerChanges.size(), 1);
+        QCOMPARE(powerChanges.first().ref, vm2);
+        QVERIFY(powerChanges.first().removed);
+
+        // Unsubscribing by id and by receiver destruction
+        cache.Unsubscribe(hostSubscription);
+        QCOMPARE(cache.SubscriptionCount(), 2);
+        delete receiver;
+        QCOMPARE(cache.SubscriptionCount(), 0);
+        cache.Update(XenObjectType::VM, vm1, normalVm("Halted"));
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+        QCOMPARE(objectCalls, 2);
+    }
+    void xenCacheUpdate_reportsChangedFieldsAndSkipsUnchangedRecords()
+    {
+        QVariantMap before = normalVm("Running");
+        before["other_config"] = QVariantMap{ { "a", "1" }, { "b", QVariantList{ 1, 2 } } };
+        QVariantMap after = before;
+        after["other_config"] = QVariantMap{ { "a", "1" }, { "b", QVariantList{ 1, 3 } } };
+        after["memory_actual"] = "1024";
+        after.remove("name_label");
+        QCOMPARE(XenCache::DiffRecords(before, after), (QStringList{ "memory_actual", "name_label", "other_config" }));
+        QVERIFY(XenCache::DiffRecords(before, QVariantMap(before)).isEmpty());
+
+        // Equal but separately built values still compare equal; same-length strings are compared
+        QVariantMap rebuilt;
+        for (auto it = before.constBegin(); it != before.constEnd(); ++it)
+            rebuilt.insert(QString(it.key().constData(), it.key().size()), it.value());
+        rebuilt["other_config"] = QVariantMap{ { QString("a"), QString("1") }, { "b", QVariantList{ 1, 2 } } };
+        QVERIFY(XenCache::DiffRecords(before, rebuilt).isEmpty());
+        rebuilt["power_state"] = QString("running");
+        QCOMPARE(XenCache::DiffRecords(before, rebuilt), QStringList{ "power_state" });
+
+        XenCache cache(nullptr);
+        const QString ref = "OpaqueRef:diff-vm";
+        QObject* receiver = new QObject();
+        QList<XenCacheChange> changes;
+        int itemSignals = 0;
+        QObject::connect(&cache, &XenCache::itemChanged, receiver, [&]() { itemSignals++; });
+        cache.Subscribe(receiver, XenObjectType::VM, ref, [&](const QList<XenCacheChange>& delivered) {
+            changes += delivered;
+        });
+
+        cache.Update(XenObjectType::VM, ref, before);
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+        QCOMPARE(itemSignals, 1);
+        QCOMPARE(changes.size(), 1);
+        QVERIFY(changes.first().fields.contains("power_state"));
+
+        // A resent identical record is dropped before any signal or subscription
+        changes.clear();
+        cache.Update(XenObjectType::VM, ref, before);
+        cache.UpdateBulk(XenObjectType::VM, QVariantMap{ { ref, before } });
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+        QCOMPARE(itemSignals, 1);
+        QVERIFY(changes.isEmpty());
+
+        QVariantMap metrics = before;
+        metrics["current_operations"] = QVariantMap{ { "task", "clean_shutdown" } };
+        cache.Update(XenObjectType::VM, ref, metrics);
+        QCoreApplication::sendPostedEvents(&cache, QEvent::MetaCall);
+        QCOMPARE(itemSignals, 2);
+        QCOMPARE(changes.size(), 1);
+        QCOMPARE(changes.first().fields, QStringList{ "current_operations" });
+        delete receiver;
+    }
+    void xenCache_loadsOnDemandTypesOnFirstLookup()
+    {
+        XenCache cache(nullptr);
+        QList<XenObjectType> demanded;
+        cache.SetOnDemandTypes({ XenObjectType::PCI, XenObjectType::Certificate },
+                               [&demanded](XenObjectType type) { demanded.append(type); });
+
+        QVERIFY(cache.GetAllRefs(XenObjectType::VM).isEmpty());
+        QVERIFY(demanded.isEmpty());
+
+        QCOMPARE(cache.Count(XenObjectType::PCI), 0);
+        QVERIFY(cache.GetAllRefs(XenObjectType::PCI).isEmpty());
+        QCOMPARE(demanded, QList<XenObjectType>{ XenObjectType::PCI });
+
+        QVERIFY(!cache.Contains(XenObjectType::Certificate, "OpaqueRef:cert"));
+        QVERIFY(cache.ResolveObjectData(XenObjectType::Certificate, "OpaqueRef:cert").isEmpty());
+        QCOMPARE(demanded, (QList<XenObjectType>{ XenObjectType::PCI, XenObjectType::Certificate }));
+
+        XenConnection connection;
+        const QStringList eager = connection.GetEventClasses();
+        QVERIFY(!eager.contains("pool_update"));
+        QVERIFY(eager.contains("message"));
+        connection.GetCache()->GetAllRefs(XenObjectType::PoolUpdate);
+        QVERIFY(connection.GetEventClasses().contains("pool_update"));
+    }
+    void foldersManager_indexFollowsFolderKeyChanges()
+    {
+        XenConnection connection;
+        XenCache* cache = connection.GetCache();
+        auto withFolder = [](const QString& folder) {
+            QVariantMap vm = normalVm("Halted");
+            vm["other_config"] = QVariantMap{ { FoldersManager::FOLDER_KEY, folder } };
+            return vm;
+        };
+        cache->Update(XenObjectType::Pool, "OpaqueRef:pool",
+                      QVariantMap{ { "other_config", QVariantMap{ { FoldersManager::EMPTY_FOLDERS_KEY, "/Empty/Sub" } } } });
+        cache->Update(XenObjectType::VM, "OpaqueRef:f-vm1", withFolder("/A/B"));
+        cache->Update(XenObjectType::VM, "OpaqueRef:f-vm2", withFolder("A"));
+        cache->Update(XenObjectType::VM, "OpaqueRef:f-vm3", normalVm("Halted"));
+
+        FoldersManager* folders = FoldersManager::instance();
+        QMetaObject::invokeMethod(folders, "onConnectionAdded", Qt::DirectConnection, Q_ARG(XenConnection*, &connection));
+        QCOMPARE(folders->Descendants(&connection, "/"), (QStringList{ "/A", "/A/B", "/Empty", "/Empty/Sub" }));
+        QCOMPARE(folders->Descendants(&connection, "/A"), QStringList{ "/A/B" });
+        QVERIFY(folders->HasSubfolders(&connection, "/A"));
+        QVERIFY(!folders->HasSubfolders(&connection, "/A/B"));
+        QVERIFY(folders->ContainsResources(&connection, "/A"));
+        QVERIFY(!folders->ContainsResources(&connection, "/Empty"));
+        QVERIFY(cache->Contains(XenObjectType::Folder, "/A/B"));
+
+        // Changes that leave the folder key alone do not touch the index
+        QSignalSpy spy(folders, &FoldersManager::FoldersChanged);
+        QVariantMap running = withFolder("/A/B");
+        running["power_state"] = "Running";
+        cache->Update(XenObjectType::VM, "OpaqueRef:f-vm1", running);
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QCOMPARE(spy.count(), 0);
+
+        // Moving the only object out of /A/B drops that folder; /A keeps vm2
+        cache->Update(XenObjectType::VM, "OpaqueRef:f-vm1", withFolder("/C"));
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(!cache->Contains(XenObjectType::Folder, "/A/B"));
+        QVERIFY(cache->Contains(XenObjectType::Folder, "/C"));
+        QVERIFY(!folders->HasSubfolders(&connection, "/A"));
+        QVERIFY(folders->ContainsResources(&connection, "/A"));
+
+        cache->Remove(XenObjectType::VM, "OpaqueRef:f-vm2");
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QVERIFY(!cache->Contains(XenObjectType::Folder, "/A"));
+        QCOMPARE(folders->Descendants(&connection, "/"), (QStringList{ "/C", "/Empty", "/Empty/Sub" }));
+
+        QMetaObject::invokeMethod(folders, "onConnectionRemoved", Qt::DirectConnection, Q_ARG(XenConnection*, &connection));
+        QVERIFY(folders->Descendants(&connection, "/").isEmpty());
+    }
+    void otherConfigAndTagsWatcher_countsTagsAndFiresOnSetChanges()
+    {
+        XenConnection connection;
+        XenCache* cache = connection.GetCache();
+        auto vm = [](const QStringList& tags, const QVariantMap& otherConfig) {
+            QVariantMap record = normalVm("Halted");
+            QVariantList tagList;
+            for (const QString& tag : tags)
+                tagList.append(tag);
+            record["tags"] = tagList;
+            record["other_config"] = otherConfig;
+            return record;
+        };
+        cache->Update(XenObjectType::VM, "OpaqueRef:t-vm1", vm({ "prod", "web" }, QVariantMap{ { "owner", "a" } }));
+        cache->Update(XenObjectType::VM, "OpaqueRef:t-vm2", vm({ "prod" }, QVariantMap()));
+
+        OtherConfigAndTagsWatcher* watcher = OtherConfigAndTagsWatcher::instance();
+        QMetaObject::invokeMethod(watcher, "onConnectionAdded", Qt::DirectConnection, Q_ARG(XenConnection*, &connection));
+        QCOMPARE(watcher->GetAllTags(), (QStringList{ "prod", "web" }));
+        QCOMPARE(watcher->TagUseCount("prod"), 2);
+        QCOMPARE(watcher->GetAllOtherConfigKeys(), QStringList{ "owner" });
+
+        QSignalSpy tagsSpy(watcher, &OtherConfigAndTagsWatcher::TagsChanged);
+        QSignalSpy keysSpy(watcher, &OtherConfigAndTagsWatcher::OtherConfigChanged);
+
+        // Power state and other_config values change, but no tag or key comes or goes
+        QVariantMap running = vm({ "prod", "web" }, QVariantMap{ { "owner", "b" } });
+        running["power_state"] = "Running";
+        cache->Update(XenObjectType::VM, "OpaqueRef:t-vm1", running);
+        cache->Update(XenObjectType::VM, "OpaqueRef:t-vm2", vm({ "prod" }, QVariantMap()));
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QCOMPARE(tagsSpy.count(), 0);
+        QCOMPARE(keysSpy.count(), 0);
+
+        // Dropping one of two "prod" users keeps the tag; dropping "web" changes the set
+        cache->Update(XenObjectType::VM, "OpaqueRef:t-vm2", vm({}, QVariantMap()));
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QCOMPARE(tagsSpy.count(), 0);
+        QCOMPARE(watcher->TagUseCount("prod"), 1);
+        cache->Remove(XenObjectType::VM, "OpaqueRef:t-vm1");
+        QCoreApplication::sendPostedEvents(cache, QEvent::MetaCall);
+        QCOMPARE(tagsSpy.count(), 1);
+        QCOMPARE(keysSpy.count(), 1);
+        QVERIFY(watcher->GetAllTags().isEmpty());
+        QVERIFY(watcher->GetAllOtherConfigKeys().isEmpty());
+
+        QMetaObject::invokeMethod(watcher, "onConnectionRemoved", Qt::DirectConnection, Q_ARG(XenConnection*, &connection));
+    }
+    void stringPool_sharesRepeatedStringsAndPrunes()
+    {
+        XenCache cache(nullptr);
+        const QString hostRef = QString("OpaqueRef:") + QString("intern-host");
+        cache.Update(XenObjectType::Host, hostRef, QVariantMap{ { "name_label", "h1" } });
+        for (int i = 0; i < 3; ++i)
+        {
+            QVariantMap vm = normalVm("Running");
+            vm["resident_on"] = QString("OpaqueRef:") + QString("intern-host");
+            cache.Update(XenObjectType::VM, QString("OpaqueRef:intern-vm%1").arg(i), vm);
+        }
+
+        // Equal strings from separately parsed records end up in one buffer
+        const QVariantMap vm0 = cache.ResolveObjectData(XenObjectType::VM, "OpaqueRef:intern-vm0");
+        const QVariantMap vm2 = cache.ResolveObjectData(XenObjectType::VM, "OpaqueRef:intern-vm2");
+        const QString resident0 = vm0.value("resident_on").toString();
+        QCOMPARE(resident0.constData(), vm2.value("resident_on").toString().constData());
+        QCOMPARE(resident0.constData(), cache.GetAllRefs(XenObjectType::Host).first().constData());
+        QCOMPARE(vm0.value("power_state").toString().constData(), vm2.value("power_state").toString().constData());
+        QVERIFY(cache.InternedStringCount() > 0);
+
+        // Entries nobody references any more go on Prune()
+        StringPool pool;
+        QString kept = pool.Intern(QString("kept") + QString("-value"));
+        pool.Intern(QString("dropped") + QString("-value"));
+        QCOMPARE(pool.Size(), 2);
+        pool.Prune();
+        QCOMPARE(pool.Size(), 1);
+        QCOMPARE(pool.Intern(QString("kept-value")).constData(), kept.constData());
+
+        // Long strings are passed through untouched
+        const QString longText(StringPool::MAX_INTERNED_LENGTH + 1, QChar('x'));
+        pool.Intern(longText);
+        QCOMPARE(pool.Size(), 1);
+    }
+    void xvaVerifier_parallelHashes_matchAndReportFirstFailureInOrder()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // XVA-like archive: ova.xml, then 24 blocks with companions. Block 0
+        // has an .xxhash whose value comes from the original sequential
+        // implementation; the rest carry SHA1 .checksum members.
+        QList<QByteArray> blocks;
+        blocks.append(patternBlock(100000, 5));
+        for (int i = 1; i < 24; ++i)
+            blocks.append(patternBlock(65536 + i * 1000, i));
+
+        auto writeXva = [&](const QString& path, const QSet<int>& corrupt) -> bool {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly))
+                return false;
+            OvaTarWriter tar(&file);
+            if (!tar.AddMember("ova.xml", "<value/>"))
+                return false;
+            for (int i = 0; i < blocks.size(); ++i)
+            {
+                const QString name = QString("Ref:1/%1").arg(i, 8, 10, QChar('0'));
+                const QByteArray sum = i == 0 ? QByteArray("C61E895F68951F7B")
+                                              : QCryptographicHash::hash(blocks.at(i), QCryptographicHash::Sha1).toHex();
+                QByteArray data = blocks.at(i);
+                if (corrupt.contains(i))
+                    data[100] = static_cast<char>(data[100] ^ 0x55);
+                if (!tar.AddMember(name, data) || !tar.AddMember(name + (i == 0 ? ".xxhash" : ".checksum"), sum))
+                    return false;
+            }
+            return tar.Finish();
+        };
+
+        const QString good = dir.filePath("good.xva");
+        QVERIFY(writeXva(good, {}));
+        XvaVerifyResult result = XvaVerifier::Verify(good);
+        QVERIFY2(result.success, qPrintable(result.errorMessage));
+        QVERIFY(result.threadCount >= 1);
+        qint64 expectedBytes = 0;
+        for (const QByteArray& block : blocks)
+            expectedBytes += block.size();
+        QCOMPARE(result.bytesVerified, expectedBytes);
+
+        // Two bad blocks: the one earlier in the archive is reported
+        const QString bad = dir.filePath("bad.xva");
+        QVERIFY(writeXva(bad, { 15, 5 }));
+        result = XvaVerifier::Verify(bad);
+        QVERIFY(!result.success);
+        QCOMPARE(result.errorType, XvaVerifyResult::ErrorType::BlockChecksum);
+        QVERIFY2(result.errorMessage.contains("'Ref:1/00000005'"), qPrintable(result.errorMessage));
+
+        const QString badXx = dir.filePath("badxx.xva");
+        QVERIFY(writeXva(badXx, { 0 }));
+        result = XvaVerifier::Verify(badXx);
+        QCOMPARE(result.errorType, XvaVerifyResult::ErrorType::BlockChecksum);
+        QVERIFY2(result.errorMessage.contains("'Ref:1/00000000'"), qPrintable(result.errorMessage));
+    }
+
+    void copyPipeline_overlapsStagesAndAttributesStalls()
+    {
+        const QByteArray payload = patternBlock(8 * 1024 * 1024 + 123, 3);
+
+        auto makeReader = [&payload](qint64& offset) {
+            return [&payload, &offset](char* data, qint64 maxSize, QString&) -> qint64 {
+                const qint64 n = qMin<qint64>(maxSize, payload.size() - offset);
+                std::memcpy(data, payload.constData() + offset, static_cast<size_t>(n));
+                offset += n;
+                return n;
+            };
+        };
+
+        // Slow writer on the calling thread: the reader runs ahead, grows its
+        // buffers and ends up waiting for free ones
+        qint64 offset = 0;
+        QByteArray out;
+        CopyPipeline slowWriter(makeReader(offset), [&out](const char* data, qint64 size, QString&) {
+            QThread::usleep(500);
+            out.append(data, static_cast<int>(size));
+            return true;
+        });
+        QVERIFY(slowWriter.Run(CopyPipeline::Worker::Reader));
+        QVERIFY(out == payload);
+        QCOMPARE(slowWriter.GetWriteStats().bytes, qint64(payload.size()));
+        QCOMPARE(slowWriter.GetPeakBufferSize(), int(CopyPipeline::MAX_BUFFER_SIZE));
+        QVERIFY(slowWriter.GetReadStats().stallNs > slowWriter.GetWriteStats().stallNs);
+
+        // Slow reader with the writer on the worker: now the writer waits
+        offset = 0;
+        out.clear();
+        auto fastRead = makeReader(offset);
+        CopyPipeline slowReader([&fastRead](char* data, qint64 maxSize, QString& error) {
+            QThread::usleep(500);
+            return fastRead(data, maxSize, error);
+        }, [&out](const char* data, qint64 size, QString&) {
+            out.append(data, static_cast<int>(size));
+            return true;
+        });
+        QVERIFY(slowReader.Run(CopyPipeline::Worker::Writer));
+        QVERIFY(out == payload);
+        QVERIFY(slowReader.GetWriteStats().stallNs > slowReader.GetReadStats().stallNs);
+
+        // A failing writer stops the reader and its error is reported
+        offset = 0;
+        int writes = 0;
+        CopyPipeline failing(makeReader(offset), [&writes](const char*, qint64, QString& error) {
+            if (++writes < 3)
+                return true;
+            error = "disk on fire";
+            return false;
+        });
+        QVERIFY(!failing.Run(CopyPipeline::Worker::Reader));
+        QCOMPARE(failing.GetError(), QString("disk on fire"));
+        QCOMPARE(failing.GetWriteStats().calls, qint64(3));
+    }
+
+    void parallelGzip_blocksRoundTripAndStayGunzipCompatible()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // Several blocks plus a partial one, compressible but not trivially so
+        QByteArray raw;
+        for (int i = 0; i < 5; ++i)
+            raw += patternBlock(ParallelGzip::BLOCK_SIZE, i) + QByteArray(40000, char(i));
+        raw += patternBlock(12345, 99);
+
+        const QString rawPath = dir.filePath("disk.vhd");
+        const QString gzPath = rawPath + ".gz";
+        {
+            QFile file(rawPath);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(raw);
+        }
+
+        QString error;
+        QVERIFY2(ParallelGzip::CompressFile(rawPath, gzPath, 6, error), qPrintable(error));
+
+        QFile gz(gzPath);
+        QVERIFY(gz.open(QIODevice::ReadOnly));
+        const QByteArray packed = gz.readAll();
+        gz.close();
+        QVERIFY(packed.size() < raw.size());
+        QVERIFY(packed.startsWith(QByteArray("\x1f\x8b\x08", 3)));
+        QCOMPARE(qFromLittleEndian<quint32>(packed.constData() + packed.size() - 4), quint32(raw.size()));
+
+        const QString outPath = dir.filePath("out.vhd");
+        QVERIFY2(ParallelGzip::DecompressFile(gzPath, outPath, error), qPrintable(error));
+        QFile out(outPath);
+        QVERIFY(out.open(QIODevice::ReadOnly));
+        QVERIFY(out.readAll() == raw);
+
+        // Stock gunzip, where available
+        const QString gzipTool = QStandardPaths::findExecutable("gzip");
+        if (!gzipTool.isEmpty())
+        {
+            QProcess gunzip;
+            gunzip.start(gzipTool, { "-dc", gzPath });
+            QVERIFY(gunzip.waitForFinished(30000));
+            QCOMPARE(gunzip.exitCode(), 0);
+            QVERIFY(gunzip.readAllStandardOutput() == raw);
+        }
+
+        // Truncated input is an error and leaves no output behind
+        const QString cutPath = dir.filePath("cut.gz");
+        {
+            QFile cut(cutPath);
+            QVERIFY(cut.open(QIODevice::WriteOnly));
+            cut.write(packed.left(packed.size() / 2));
+        }
+        QVERIFY(!ParallelGzip::DecompressFile(cutPath, dir.filePath("cut.vhd"), error));
+        QVERIFY(!QFile::exists(dir.filePath("cut.vhd")));
+    }
+
+    void httpClient_keepAliveReusesPooledConnectionAndRecovers()
+    {
+        const QByteArray body = patternBlock(200000, 4);
+        const QByteArray chunkedBody = patternBlock(70000, 8);
+        QAtomicInt stop(0);
+        QAtomicInt connections(0);
+        QSemaphore listening;
+        quint16 port = 0;
+
+        // Serves requests on a connection until the client goes away;
+        // "/close" answers and then drops the connection like an idle timeout
+        QThread* server = QThread::create([&]() {
+            QTcpServer listener;
+            if (listener.listen(QHostAddress::LocalHost, 0))
+                port = listener.serverPort();
+            listening.release();
+            while (port && !stop.loadAcquire())
+            {
+                if (!listener.waitForNewConnection(100))
+                    continue;
+                connections.fetchAndAddOrdered(1);
+                QTcpSocket* socket = listener.nextPendingConnection();
+                QByteArray request;
+                while (!stop.loadAcquire() && socket->state() == QAbstractSocket::ConnectedState)
+                {
+                    if (!request.contains("\r\n\r\n"))
+                    {
+                        socket->waitForReadyRead(100);
+                        request += socket->readAll();
+                        continue;
+                    }
+
+                    const QByteArray line = request.left(request.indexOf("\r\n"));
+                    request = request.mid(request.indexOf("\r\n\r\n") + 4);
+                    if (line.contains("/chunked"))
+                    {
+                        socket->write("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+                        for (int offset = 0; offset < chunkedBody.size(); offset += 30000)
+                        {
+                            const QByteArray piece = chunkedBody.mid(offset, 30000);
+                            socket->write(QByteArray::number(piece.size(), 16) + ";ext=1\r\n" + piece + "\r\n");
+                        }
+                        socket->write("0\r\nX-Trailer: yes\r\n\r\n");
+                    } else
+                    {
+                        socket->write("HTTP/1.1 200 OK\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n");
+                        socket->write(body);
+                    }
+                    while (socket->bytesToWrite() > 0 && socket->waitForBytesWritten(5000))
+                    {
+                    }
+
+                    if (line.contains("/close"))
+                        break;
+                }
+                socket->disconnectFromHost();
+                delete socket;
+            }
+        });
+        server->start();
+        listening.acquire();
+        QVERIFY(port != 0);
+
+        HttpConnectionPool::Clear();
+        const QString key = HttpConnectionPool::Key(QUrl(QString("http://127.0.0.1:%1").arg(port)));
+
+        HttpClient client;
+        client.setEndpoint(port, false);
+        auto fetch = [&client](const QString& path) {
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            if (!client.getStream("127.0.0.1", path, {}, &buffer))
+                return QByteArray("error: ") + client.lastError().toUtf8();
+            return buffer.data();
+        };
+
+        QVERIFY(fetch("/a") == body);
+        QVERIFY(fetch("/chunked") == chunkedBody);
+        QVERIFY(fetch("/b") == body);
+        QCOMPARE(connections.loadAcquire(), 1);
+        QCOMPARE(HttpConnectionPool::GetIdleCount(key), 1);
+
+        // The server closes the pooled connection; the next request reconnects
+        QVERIFY(fetch("/close") == body);
+        QVERIFY(fetch("/c") == body);
+        QCOMPARE(connections.loadAcquire(), 2);
+
+        // Without keep-alive nothing is parked
+        HttpConnectionPool::Clear();
+        client.setKeepAlive(false);
+        QVERIFY(fetch("/d") == body);
+        QCOMPARE(HttpConnectionPool::GetIdleCount(key), 0);
+
+        stop.storeRelease(1);
+        server->wait();
+        delete server;
+    }
+
+    void httpClientGetFile_resumesWithRangeAfterInjectedDisconnects()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const QByteArray payload = patternBlock(3 * 1024 * 1024, 9);
+        bool supportRanges = true;
+        int dropsLeft = 0;
+        QList<qint64> requestStarts;
+        QAtomicInt stop(0);
+        QSemaphore listening;
+        quint16 port = 0;
+
+        // Blocking single-connection-at-a-time server that cuts the body short
+        // at a pseudo-random point while dropsLeft > 0
+        QThread* server = QThread::create([&]() {
+            QTcpServer listener;
+            if (listener.listen(QHostAddress::LocalHost, 0))
+                port = listener.serverPort();
+            listening.release();
+            QRandomGenerator rng(42);
+            while (port && !stop.loadAcquire())
+            {
+                if (!listener.waitForNewConnection(100))
+                    continue;
+                QTcpSocket* socket = listener.nextPendingConnection();
+                QByteArray request;
+                while (!request.contains("\r\n\r\n") && socket->waitForReadyRead(5000))
+                    request += socket->readAll();
+
+                qint64 start = 0;
+                const int range = request.indexOf("Range: bytes=");
+                if (supportRanges && range >= 0)
+                    start = request.mid(range + 13, request.indexOf('-', range + 13) - range - 13).toLongLong();
+                requestStarts.append(start);
+
+                QByteArray head = start > 0
+                    ? QByteArray("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes ")
+                          + QByteArray::number(start) + "-" + QByteArray::number(payload.size() - 1)
+                          + "/" + QByteArray::number(payload.size()) + "\r\n"
+                    : QByteArray("HTTP/1.1 200 OK\r\n");
+                if (supportRanges)
+                    head += "Accept-Ranges: bytes\r\n";
+                head += "Connection: close\r\n";
+                head += "Content-Length: " + QByteArray::number(payload.size() - start) + "\r\n\r\n";
+                socket->write(head);
+
+                qint64 end = payload.size();
+                if (dropsLeft > 0)
+                {
+                    --dropsLeft;
+                    end = start + rng.bounded(static_cast<int>(payload.size() - start));
+                }
+                socket->write(payload.constData() + start, end - start);
+                while (socket->bytesToWrite() > 0 && socket->waitForBytesWritten(5000))
+                {
+                }
+
+                if (end < payload.size())
+                    socket->abort();
+                else
+                {
+                    socket->disconnectFromHost();
+                    if (socket->state() != QAbstractSocket::UnconnectedState)
+                        socket->waitForDisconnected(5000);
+                }
+                delete socket;
+            }
+        });
+        server->start();
+        listening.acquire();
+        QVERIFY(port != 0);
+
+        HttpClient client;
+        client.setEndpoint(port, false);
+        QMap<QString, QString> params;
+        params["uuid"] = "vdi-1";
+        params["session_id"] = "OpaqueRef:session";
+
+        auto readAll = [](const QString& path) {
+            QFile file(path);
+            return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+        };
+
+        // Range-capable server: three drops, each retry continues where the last stopped
+        dropsLeft = 3;
+        const QString ranged = dir.filePath("ranged.raw");
+        QVERIFY2(client.getFile("127.0.0.1", "/export_raw_vdi", params, ranged), qPrintable(client.lastError()));
+        QVERIFY(readAll(ranged) == payload);
+        QCOMPARE(requestStarts.size(), 4);
+        QCOMPARE(requestStarts.first(), qint64(0));
+        for (int i = 1; i < requestStarts.size(); ++i)
+            QVERIFY(requestStarts.at(i) >= requestStarts.at(i - 1));
+        QVERIFY(!QFile::exists(ranged + ".tmp.resume"));
+
+        // Server that ignores Range: the retry starts over and still ends up identical
+        requestStarts.clear();
+        supportRanges = false;
+        dropsLeft = 1;
+        const QString plain = dir.filePath("plain.raw");
+        QVERIFY2(client.getFile("127.0.0.1", "/export_raw_vdi", params, plain), qPrintable(client.lastError()));
+        QVERIFY(readAll(plain) == payload);
+        QCOMPARE(requestStarts, QList<qint64>({ 0, 0 }));
+
+        // Streams resume into the same sink and refuse a restart they cannot undo
+        requestStarts.clear();
+        supportRanges = true;
+        dropsLeft = 2;
+        QBuffer streamed;
+        streamed.open(QIODevice::WriteOnly);
+        QVERIFY2(client.getStream("127.0.0.1", "/export_raw_vdi", params, &streamed), qPrintable(client.lastError()));
+        QVERIFY(streamed.data() == payload);
+        QCOMPARE(requestStarts.size(), 3);
+
+        requestStarts.clear();
+        supportRanges = false;
+        dropsLeft = 1;
+        QBuffer unranged;
+        unranged.open(QIODevice::WriteOnly);
+        QVERIFY(!client.getStream("127.0.0.1", "/export_raw_vdi", params, &unranged));
+        QVERIFY(client.lastError().contains("Range"));
+        QCOMPARE(requestStarts.size(), 2);
+
+        stop.storeRelease(1);
+        server->wait();
+        delete server;
+    }
+    void mockXapiServer_servesConnectionWorkerEndToEnd()
+    {
+        if (!QSslSocket::supportsSsl())
+            QSKIP("TLS is not available");
+
+        MockXapiServer server;
+        MockXapiDatabase* database = server.GetDatabase();
+        MockXapiInventoryOptions options;
+        options.hosts = 2;
+        options.vmsPerHost = 5;
+        MockXapiInventory::Populate(*database, options);
+        server.SetCredentials("root", "secret");
+        server.SetTaskDuration(50);
+        QVERIFY2(server.Start(), qPrintable(server.GetError()));
+
+        Xen::ConnectionWorker worker("127.0.0.1", server.GetPort());
+        worker.start();
+        auto rpc = [&worker](const QString& method, const QVariantList& params) {
+            return jsonRpc(worker, method, params);
+        };
+
+        QCOMPARE(rpc("session.login_with_password", {"root", "wrong"}).value("error").toObject().value("message").toString(),
+                 QString("SESSION_AUTHENTICATION_FAILED"));
+        const QString session = rpc("session.login_with_password", {"root", "secret"}).value("result").toString();
+        QVERIFY(session.startsWith("OpaqueRef:"));
+
+        // Initial event.from returns every object, the next one blocks until a change
+        const QJsonObject initial = rpc("event.from", {session, QVariantList{"*"}, "", 5.0}).value("result").toObject();
+        QCOMPARE(initial.value("events").toArray().size(), database->GetTotalCount());
+
+        const QString vmRef = database->GetRefs("vm").first();
+        server.Schedule(100, [vmRef](MockXapiDatabase& db) { db.Modify("vm", vmRef, {{"name_label", "renamed"}}); });
+        const QJsonObject next = rpc("event.from", {session, QVariantList{"vm"}, initial.value("token").toString(), 5.0})
+                                     .value("result").toObject();
+        const QJsonArray events = next.value("events").toArray();
+        QCOMPARE(events.size(), 1);
+        QCOMPARE(events.first().toObject().value("ref").toString(), vmRef);
+        QCOMPARE(events.first().toObject().value("operation").toString(), QString("mod"));
+        QCOMPARE(events.first().toObject().value("snapshot").toObject().value("name_label").toString(), QString("renamed"));
+
+        // Async calls complete as tasks
+        QString runningVm;
+        const QVariantMap vms = database->GetAll("vm");
+        for (auto it = vms.constBegin(); it != vms.constEnd() && runningVm.isEmpty(); ++it)
+        {
+            const QVariantMap vm = it.value().toMap();
+            if (vm.value("power_state") == "Running" && !vm.value("is_control_domain").toBool())
+                runningVm = it.key();
+        }
+        QVERIFY(!runningVm.isEmpty());
+        const QString task = rpc("Async.VM.clean_shutdown", {session, runningVm}).value("result").toString();
+        QString status;
+        for (int i = 0; i < 100 && status != "success"; ++i)
+        {
+            QThread::msleep(20);
+            status = rpc("task.get_status", {session, task}).value("result").toString();
+        }
+        QCOMPARE(status, QString("success"));
+        QCOMPARE(rpc("VM.get_power_state", {session, runningVm}).value("result").toString(), QString("Halted"));
+
+        // An injected failure hits once, then the call goes through
+        MockXapiFault fault;
+        fault.method = "pool.get_all_records";
+        server.AddFault(fault);
+        QCOMPARE(rpc("pool.get_all_records", {session}).value("error").toObject().value("message").toString(),
+                 QString("INTERNAL_ERROR"));
+        QCOMPARE(rpc("pool.get_all_records", {session}).value("result").toObject().size(), 1);
+
+        QCOMPARE(server.GetCallCount("pool.get_all_records"), 2);
+        QCOMPARE(server.GetCallCount("session.login_with_password"), 2);
+        QCOMPARE(server.GetConnectionCount(), 1);
+
+        worker.RequestStop();
+        worker.wait();
+        server.Stop();
+        QVERIFY(!server.IsRunning());
+    }
+    void httpContentDecoder_inflatesStreamedBodies()
+    {
+        if (!HttpCompression::IsAvailable())
+            QSKIP("Built without zlib");
+
+        QByteArray json;
+        for (int i = 0; i < 5000; ++i)
+            json += QString("{\"ref\":\"OpaqueRef:%1\",\"class\":\"vm\",\"operation\":\"add\"},").arg(i).toUtf8();
+
+        // Fed in small uneven pieces, the way blocks come off a socket
+        auto decode = [](const QByteArray& coding, const QByteArray& encoded, QByteArray& output) {
+            HttpContentDecoder decoder(coding);
+            for (qsizetype offset = 0; offset < encoded.size(); offset += 7)
+            {
+                if (!decoder.Feed(encoded.constData() + offset, qMin<qsizetype>(7, encoded.size() - offset), output))
+                    return false;
+            }
+            return decoder.Finish();
+        };
+
+        const QByteArray gzip = HttpCompression::Gzip(json);
+        QVERIFY(!gzip.isEmpty() && gzip.size() < json.size() / 4);
+        QByteArray output;
+        QVERIFY(decode("gzip", gzip, output));
+        QCOMPARE(output, json);
+
+        // Back-to-back gzip members decode as one body
+        output.clear();
+        QVERIFY(decode("x-gzip", gzip + HttpCompression::Gzip("tail"), output));
+        QCOMPARE(output, json + "tail");
+
+        // deflate is meant to be zlib-wrapped, but raw streams are seen in the wild too
+        const QByteArray zlibStream = qCompress(json).mid(4);
+        const QByteArray rawStream = zlibStream.mid(2, zlibStream.size() - 6);
+        output.clear();
+        QVERIFY(decode("deflate", zlibStream, output));
+        QCOMPARE(output, json);
+        output.clear();
+        QVERIFY(decode("Deflate", rawStream, output));
+        QCOMPARE(output, json);
+
+        output.clear();
+        QVERIFY(decode("identity", json, output));
+        QCOMPARE(output, json);
+
+        output.clear();
+        QVERIFY(!decode("gzip", gzip.chopped(16), output));
+        QVERIFY(!HttpContentDecoder("br").IsSupported());
+        HttpContentDecoder corrupt("gzip");
+        QVERIFY(!corrupt.Feed(json.constData(), json.size(), output));
+        QVERIFY(!corrupt.GetError().isEmpty());
+    }
+    void mockXapiServer_compressesJsonRpcBothWays()
+    {
+        if (!QSslSocket::supportsSsl())
+            QSKIP("TLS is not available");
+        if (!HttpCompression::IsAvailable())
+            QSKIP("Built without zlib");
+
+        MockXapiServer server;
+        MockXapiInventoryOptions options;
+        options.hosts = 2;
+        options.vmsPerHost = 20;
+        MockXapiInventory::Populate(*server.GetDatabase(), options);
+        server.SetCompressionEnabled(true);
+        QVERIFY2(server.Start(), qPrintable(server.GetError()));
+
+        Xen::ConnectionWorker worker("127.0.0.1", server.GetPort());
+        worker.start();
+        const QString session = jsonRpc(worker, "session.login_with_password", {"root", ""}).value("result").toString();
+        QVERIFY(session.startsWith("OpaqueRef:"));
+
+        auto eventFromBytes = [&]() {
+            const qint64 before = server.GetBytesSent();
+            const QJsonObject result = jsonRpc(worker, "event.from", {session, QVariantList{"*"}, "", 5.0})
+                                           .value("result").toObject();
+            const int events = result.value("events").toArray().size();
+            return qMakePair(events, server.GetBytesSent() - before);
+        };
+
+        // Chunked gzip is decoded to the same reply, in a fraction of the bytes
+        const auto compressed = eventFromBytes();
+        Xen::ConnectionWorker::SetResponseCompressionEnabled(false);
+        const auto plain = eventFromBytes();
+        Xen::ConnectionWorker::SetResponseCompressionEnabled(true);
+        QCOMPARE(compressed.first, server.GetDatabase()->GetTotalCount());
+        QCOMPARE(plain.first, compressed.first);
+        QVERIFY2(compressed.second * 4 < plain.second,
+                 qPrintable(QString("%1 vs %2 bytes").arg(compressed.second).arg(plain.second)));
+
+        // Requests are gzipped above the threshold
+        Xen::ConnectionWorker::SetRequestCompressionThreshold(1);
+        QCOMPARE(jsonRpc(worker, "pool.get_all_records", {session}).value("result").toObject().size(), 1);
+        QCOMPARE(server.GetCompressedRequestCount(), 1);
+
+        // A server that refuses them gets the call again uncompressed, and no more compressed ones
+        server.SetCompressionEnabled(false);
+        QCOMPARE(jsonRpc(worker, "pool.get_all_records", {session}).value("result").toObject().size(), 1);
+        QCOMPARE(jsonRpc(worker, "pool.get_all_records", {session}).value("result").toObject().size(), 1);
+        QCOMPARE(server.GetCompressedRequestCount(), 1);
+        QCOMPARE(server.GetCallCount("pool.get_all_records"), 3);
+        Xen::ConnectionWorker::SetRequestCompressionThreshold(0);
+
+        worker.RequestStop();
+        worker.wait();
+        server.Stop();
+    }
+    void mockXapiInventory_sizedDumpLoadsIntoCache()
+    {
+        const MockXapiInventoryOptions options = MockXapiInventory::OptionsForObjectCount(2000, 7);
+        MockXapiDatabase database;
+        MockXapiInventory::Populate(database, options);
+        QVERIFY(qAbs(database.GetTotalCount() - 2000) < 200);
+        QCOMPARE(database.GetCount("message"), options.messages);
+
+        // The dump has the layout of a captured event.from reply
+        QTemporaryFile dump;
+        QVERIFY(dump.open());
+        dump.write(MockXapiInventory::ExportEventDump(database));
+        dump.close();
+        XenCache* cache = LoadCacheFromEventJson(dump.fileName());
+        QVERIFY(cache);
+        QCOMPARE(cache->Count(XenObjectType::VM), database.GetCount("vm"));
+        QCOMPARE(cache->Count(XenObjectType::Message), options.messages);
+
+        QStringList folders;
+        QStringList tags;
+        const QVariantMap vms = database.GetAll("vm");
+        for (const QVariant& vm : vms)
+        {
+            const QVariantMap record = vm.toMap();
+            const QString folder = record.value("other_config").toMap().value("folder").toString();
+            if (!folder.isEmpty() && !folders.contains(folder))
+                folders.append(folder);
+            for (const QVariant& tag : record.value("tags").toList())
+            {
+                if (!tags.contains(tag.toString()))
+                    tags.append(tag.toString());
+            }
+        }
+        QVERIFY(folders.size() > 1);
+        QCOMPARE(tags.size(), options.tags);
+        cache->Clear();
+
+        // Every running VM gets its own columns in the RRD export
+        const QByteArray rrd = MockXapiInventory::ExportRrdUpdates(database, false, 1000000, 3);
+        QVERIFY(rrd.contains("<rows>3</rows>"));
+        QVERIFY(rrd.contains(":vm:"));
+        QVERIFY(!rrd.contains(":host:"));
+    }
+    void wireRecorder_redactsCredentialsAndReplayDrivesWorkerOffline()
+    {
+        if (!QSslSocket::supportsSsl())
+            QSKIP("TLS is not available");
+
+        MockXapiServer server;
+        MockXapiInventoryOptions options;
+        options.vmsPerHost = 3;
+        MockXapiInventory::Populate(*server.GetDatabase(), options);
+        server.SetCredentials("root", "hunter2");
+        QVERIFY2(server.Start(), qPrintable(server.GetError()));
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath("session.xawr");
+        QString error;
+        QVERIFY2(WireRecorder::Start(path, &error), qPrintable(error));
+
+        QString session;
+        QJsonObject pools;
+        QJsonObject initial;
+        {
+            Xen::ConnectionWorker worker("127.0.0.1", server.GetPort());
+            worker.start();
+            session = jsonRpc(worker, "session.login_with_password", {"root", "hunter2"}).value("result").toString();
+            QVERIFY(session.startsWith("OpaqueRef:"));
+            pools = jsonRpc(worker, "pool.get_all_records", {session}).value("result").toObject();
+            initial = jsonRpc(worker, "event.from", {session, QVariantList{"*"}, "", 1.0}).value("result").toObject();
+            QCOMPARE(WireRecorder::GetRecordedCount(), 3);
+            worker.RequestStop();
+            worker.wait();
+        }
+        WireRecorder::Stop();
+        server.Stop();
+
+        // Neither the password nor the live session made it into the file
+        QSharedPointer<WireReplay> replay(new WireReplay());
+        QVERIFY2(replay->Load(path, &error), qPrintable(error));
+        const QList<WireExchange> exchanges = replay->GetExchanges();
+        QCOMPARE(exchanges.size(), 3);
+        for (const WireExchange& exchange : exchanges)
+        {
+            QVERIFY(!exchange.request.contains("hunter2"));
+            QVERIFY(!exchange.request.contains(session.toUtf8()));
+            QVERIFY(!exchange.response.contains(session.toUtf8()));
+            QVERIFY(exchange.durationUs > 0);
+        }
+        QVERIFY(exchanges.at(0).request.contains(WireRecorder::RedactedValue().toUtf8()));
+
+        // With the replay installed a worker needs no server at all
+        replay->SetSpeed(0);
+        WireReplay::Install(replay);
+        Xen::ConnectionWorker offline("127.0.0.1", 1);
+        offline.start();
+        const QString replayed = jsonRpc(offline, "session.login_with_password", {"root", "anything"}).value("result").toString();
+        QVERIFY(replayed.startsWith("OpaqueRef:redacted-session-"));
+        QCOMPARE(jsonRpc(offline, "pool.get_all_records", {replayed}).value("result").toObject(), pools);
+        const QJsonObject events = jsonRpc(offline, "event.from", {replayed, QVariantList{"*"}, "", 1.0}).value("result").toObject();
+        QCOMPARE(events.value("events").toArray().size(), initial.value("events").toArray().size());
+        QCOMPARE(replay->GetRemainingCount(), 0);
+
+        // Past the end of the recording event.from idles and other calls fail
+        const QJsonObject idle = jsonRpc(offline, "event.from", {replayed, QVariantList{"*"}, events.value("token").toString(), 0.2})
+                                     .value("result").toObject();
+        QVERIFY(idle.value("events").toArray().isEmpty());
+        QCOMPARE(idle.value("token").toString(), events.value("token").toString());
+        QVERIFY(jsonRpc(offline, "host.get_all_records", {replayed}).isEmpty());
+        QCOMPARE(replay->GetMissCount(), 1);
+
+        offline.RequestStop();
+        offline.wait();
+        WireReplay::Install(QSharedPointer<WireReplay>());
+    }
+
+    void wireRecorder_redactsSecretsInResponses()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("responses.xawr");
+        QString error;
+        QVERIFY2(WireRecorder::Start(path, &error), qPrintable(error));
+
+        const QByteArray session = "OpaqueRef:live-session";
+        auto call = [](const QString& method, const QJsonArray& params) {
+            return QJsonDocument(QJsonObject{{"jsonrpc", "2.0"}, {"method", method}, {"params", params}, {"id", 1}})
+                .toJson(QJsonDocument::Compact);
+        };
+        auto reply = [](const QJsonValue& result) {
+            return QJsonDocument(QJsonObject{{"jsonrpc", "2.0"}, {"result", result}, {"id", 1}}).toJson(QJsonDocument::Compact);
+        };
+
+        const QJsonObject deviceConfig{{"target", "10.0.0.5"}, {"chapuser", "iscsi"},
+                                       {"chappassword", "chap-hunter2"}, {"password", "cifs-hunter2"}};
+        const QJsonObject pbd{{"uuid", "pbd-1"}, {"device_config", deviceConfig}};
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, "pool:443",
+                             call("session.login_with_password", {"root", "pw"}), reply(QString(session)), 10);
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, "pool:443",
+                             call("PBD.get_all_records", {QString(session)}),
+                             reply(QJsonObject{{"OpaqueRef:pbd-1", pbd}}), 10);
+        const QJsonArray events{
+            QJsonObject{{"class", "pbd"}, {"ref", "OpaqueRef:pbd-1"}, {"snapshot", pbd}},
+            QJsonObject{{"class", "secret"}, {"ref", "OpaqueRef:secret-1"},
+                        {"snapshot", QJsonObject{{"uuid", "secret-1"}, {"value", "secret-hunter2"}}}},
+            QJsonObject{{"class", "session"}, {"ref", "OpaqueRef:other-session"}, {"snapshot", QJsonObject()}},
+        };
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, "pool:443",
+                             call("event.from", {QString(session), QJsonArray{"*"}, "", 30.0}),
+                             reply(QJsonObject{{"events", events}, {"token", "1"}}), 10);
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, "pool:443",
+                             call("secret.get_value", {QString(session), "OpaqueRef:secret-1"}),
+                             reply(QString("secret-hunter2")), 10);
+        WireRecorder::Record(WireExchange::Channel::JsonRpc, "pool:443",
+                             call("session.get_all", {QString(session)}),
+                             reply(QJsonArray{QString(session), "OpaqueRef:other-session"}), 10);
+        WireRecorder::Stop();
+
+        WireReplay replay;
+        QVERIFY2(replay.Load(path, &error), qPrintable(error));
+        const QList<WireExchange> exchanges = replay.GetExchanges();
+        QCOMPARE(exchanges.size(), 5);
+        for (const WireExchange& exchange : exchanges)
+        {
+            QVERIFY(!exchange.response.contains("hunter2"));
+            QVERIFY(!exchange.response.contains(session));
+            QVERIFY(!exchange.response.contains("other-session"));
+        }
+
+        // Everything else in the record survives
+        const QJsonObject recorded = QJsonDocument::fromJson(exchanges.at(1).response).object()
+                                         .value("result").toObject().value("OpaqueRef:pbd-1").toObject()
+                                         .value("device_config").toObject();
+        QCOMPARE(recorded.value("password").toString(), WireRecorder::RedactedValue());
+        QCOMPARE(recorded.value("chappassword").toString(), WireRecorder::RedactedValue());
+        QCOMPARE(recorded.value("chapuser").toString(), QString("iscsi"));
+        QCOMPARE(recorded.value("target").toString(), QString("10.0.0.5"));
+        QCOMPARE(QJsonDocument::fromJson(exchanges.at(3).response).object().value("result").toString(),
+                 WireRecorder::RedactedValue());
+    }
+
+    void rpcTracer_recordsPhasesAndExportsChromeTrace()
+    {
+        if (!QSslSocket::supportsSsl())
+            QSKIP("TLS is not available");
+
+        MockXapiServer server;
+        MockXapiInventoryOptions options;
+        options.vmsPerHost = 2;
+        MockXapiInventory::Populate(*server.GetDatabase(), options);
+        QVERIFY2(server.Start(), qPrintable(server.GetError()));
+
+        RpcTracer::Clear();
+        RpcTracer::SetEnabled(true);
+        {
+            Xen::ConnectionWorker worker("127.0.0.1", server.GetPort());
+            worker.start();
+            RpcTraceScope scope("Test action");
+            const QString session = jsonRpc(worker, "session.login_with_password", {"root", "pw"}).value("result").toString();
+            for (int i = 0; i < 10; ++i)
+            {
+                QVERIFY(!jsonRpc(worker, "vm.get_all_records", {session}).value("result").toObject().isEmpty());
+                RpcTracer::RecordParse(100);
+            }
+            worker.RequestStop();
+            worker.wait();
+        }
+        RpcTracer::SetEnabled(false);
+
+        const QList<RpcTraceEvent> events = RpcTracer::GetEvents();
+        QCOMPARE(events.size(), 11);
+        for (const RpcTraceEvent& event : events)
+        {
+            QCOMPARE(event.context, QString("Test action"));
+            QVERIFY(!event.failed);
+            QVERIFY(event.requestBytes > 0 && event.responseBytes > 0);
+            QVERIFY(event.queueUs >= 0 && event.serverUs >= 0);
+        }
+        QCOMPARE(events.first().method, QString("session.login_with_password"));
+        QCOMPARE(events.first().parseUs, qint64(-1));
+        QCOMPARE(events.last().parseUs, qint64(100));
+
+        bool found = false;
+        for (const RpcLatencySummary& summary : RpcTracer::GetSummaries())
+        {
+            if (summary.method != "vm.get_all_records")
+                continue;
+            found = true;
+            QCOMPARE(summary.count, 10);
+            QVERIFY(summary.p50Us <= summary.p90Us && summary.p90Us <= summary.p99Us && summary.p99Us <= summary.maxUs);
+            QCOMPARE(summary.meanParseUs, qint64(100));
+        }
+        QVERIFY(found);
+
+        QJsonParseError parseError;
+        const QJsonDocument trace = QJsonDocument::fromJson(RpcTracer::ExportChromeTrace(), &parseError);
+        QCOMPARE(parseError.error, QJsonParseError::NoError);
+        QVERIFY(trace.object().value("traceEvents").toArray().size() > events.size());
+
+        RpcTracer::Clear();
+        QVERIFY(RpcTracer::GetEvents().isEmpty());
+    }
+    void alertManager_indexesAndBatchesRemoval()
+    {
+        using namespace XenLib;
+        AlertManager* manager = AlertManager::instance();
+        manager->ClearAllAlerts();
+
+        const qint64 base = 1735689600; // 2025-01-01T00:00:00Z
+        QList<Alert*> alerts;
+        for (int i = 0; i < 1000; ++i)
+        {
+            alerts.append(new MessageAlert(nullptr, {
+                {"ref", QString("OpaqueRef:message-%1").arg(i)},
+                {"name", "HA_HOST_FAILED"},
+                {"priority", i % 5 + 1},
+                {"obj_uuid", QString("vm-%1").arg(i % 10)},
+                {"timestamp", base + i},
+            }));
+        }
+
+        int addedBatches = 0;
+        int removedBatches = 0;
+        QMetaObject::Connection added = connect(manager, &AlertManager::alertsAdded, this, [&]() { ++addedBatches; });
+        QMetaObject::Connection removed = connect(manager, &AlertManager::alertsRemoved, this, [&]() { ++removedBatches; });
+
+        manager->AddAlerts(alerts);
+        QCOMPARE(addedBatches, 1);
+        QCOMPARE(manager->AlertCount(), 1000);
+        QCOMPARE(manager->AlertCount(AlertPriority::Priority1), 200);
+        QCOMPARE(manager->GetAlertsForObject("vm-3").size(), 100);
+        QCOMPARE(manager->GetAlerts(static_cast<XenConnection*>(nullptr)).size(), 1000);
+        QCOMPARE(manager->FindAlertByOpaqueRef("OpaqueRef:message-42"), alerts.at(42));
+        QCOMPARE(manager->FindAlert(alerts.at(7)->GetUUID()), alerts.at(7));
+
+        const QList<Alert*> newest = manager->GetNewestAlerts(3);
+        QCOMPARE(newest.size(), 3);
+        QCOMPARE(newest.first(), alerts.last());
+        QCOMPARE(manager->GetAlerts(QDateTime::fromSecsSinceEpoch(base + 10), QDateTime::fromSecsSinceEpoch(base + 19)).size(), 10);
+
+        alerts.at(0)->SetDismissing(true);
+        QCOMPARE(manager->NonDismissingAlertCount(), 999);
+        alerts.at(0)->SetDismissing(false);
+        QCOMPARE(manager->NonDismissingAlertCount(), 1000);
+
+        // Predicates may query the manager without deadlocking
+        manager->RemoveAlerts([manager](Alert* alert) {
+            return alert->GetPriority() == AlertPriority::Priority5 && manager->FindAlert(alert->GetUUID()) == alert;
+        });
+        QCOMPARE(removedBatches, 1);
+        QCOMPARE(manager->AlertCount(), 800);
+        QCOMPARE(manager->AlertCount(AlertPriority::Priority5), 0);
+        QVERIFY(!manager->FindAlertByOpaqueRef("OpaqueRef:message-4"));
+
+        // Without a connection there is no message to destroy, the alerts just go
+        QVERIFY(!manager->DismissAlerts(manager->GetAlerts(AlertPriority::Priority1)));
+        QCOMPARE(manager->AlertCount(), 600);
+
+        disconnect(added);
+        disconnect(removed);
+        manager->ClearAllAlerts();
+        QCOMPARE(manager->AlertCount(), 0);
+    }
+    void messageAlertLoader_parsesNewestPageFirstOffThread()
+    {
+        using namespace XenLib;
+        AlertManager* manager = AlertManager::instance();
+        MessageAlertLoader* loader = MessageAlertLoader::instance();
+        manager->ClearAllAlerts();
+        XenConnection connection;
+
+        const qint64 base = 1735689600; // 2025-01-01T00:00:00Z
+        auto message = [base](int i) {
+            return QVariantMap{
+                {"ref", QString("OpaqueRef:loader-%1").arg(i)},
+                {"name", i % 2 ? "ALARM" : "HA_HOST_FAILED"},
+                {"priority", 3},
+                {"timestamp", base + i},
+            };
+        };
+        auto settle = [loader]() {
+            QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+            QThreadPool::globalInstance()->waitForDone();
+            QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+        };
+
+        const int total = MessageAlertLoader::PAGE_SIZE + 10;
+        for (int i = 0; i < total; ++i)
+            loader->Enqueue(&connection, message(i));
+        loader->Enqueue(&connection, message(0));
+        QCOMPARE(manager->AlertCount(), 0);
+        settle();
+
+        // Only the newest page is built; the oldest messages wait for FetchMore()
+        QCOMPARE(manager->AlertCount(), int(MessageAlertLoader::PAGE_SIZE));
+        QCOMPARE(loader->PendingCount(), 10);
+        QVERIFY(manager->FindAlertByOpaqueRef(QString("OpaqueRef:loader-%1").arg(total - 1)));
+        QVERIFY(!manager->FindAlertByOpaqueRef("OpaqueRef:loader-0"));
+        Alert* alarm = manager->FindAlertByOpaqueRef(QString("OpaqueRef:loader-%1").arg(total - 1));
+        QVERIFY(dynamic_cast<AlarmMessageAlert*>(alarm));
+        QCOMPARE(alarm->thread(), QThread::currentThread());
+
+        // New messages show up straight away, destroyed ones never do
+        loader->Enqueue(&connection, message(total));
+        loader->Remove("OpaqueRef:loader-0");
+        settle();
+        QCOMPARE(manager->AlertCount(), int(MessageAlertLoader::PAGE_SIZE) + 1);
+        QCOMPARE(loader->PendingCount(), 9);
+
+        loader->FetchMore();
+        settle();
+        QCOMPARE(loader->PendingCount(), 0);
+        QCOMPARE(loader->InFlightCount(), 0);
+        QCOMPARE(manager->AlertCount(), total);
+        QVERIFY(manager->FindAlertByOpaqueRef("OpaqueRef:loader-1"));
+        QVERIFY(!manager->FindAlertByOpaqueRef("OpaqueRef:loader-0"));
+
+        manager->ClearAllAlerts();
+    }
+
+    void alertManager_dismissAllTakesPendingMessages()
+    {
+        using namespace XenLib;
+        AlertManager* manager = AlertManager::instance();
+        MessageAlertLoader* loader = MessageAlertLoader::instance();
+        manager->ClearAllAlerts();
+        XenConnection connection;
+
+        const qint64 base = 1735689600; // 2025-01-01T00:00:00Z
+        auto message = [base](int i) {
+            return QVariantMap{
+                {"ref", QString("OpaqueRef:dismiss-%1").arg(i)},
+                {"name", "HA_HOST_FAILED"},
+                {"priority", 3},
+                {"timestamp", base + i},
+            };
+        };
+        auto settle = [loader]() {
+            QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+            QThreadPool::globalInstance()->waitForDone();
+            QCoreApplication::sendPostedEvents(loader, QEvent::MetaCall);
+        };
+
+        const int total = MessageAlertLoader::PAGE_SIZE + 10;
+        for (int i = 0; i < total; ++i)
+            loader->Enqueue(&connection, message(i));
+        settle();
+        QCOMPARE(manager->AlertCount(), int(MessageAlertLoader::PAGE_SIZE));
+        QCOMPARE(loader->PendingCount(), 10);
+
+        // Dismiss All covers the messages that never became alerts
+        const QHash<XenConnection*, QStringList> pending = loader->TakePending();
+        QCOMPARE(pending.size(), 1);
+        QCOMPARE(pending.value(&connection).size(), 10);
+        QVERIFY(pending.value(&connection).contains("OpaqueRef:dismiss-0"));
+        QCOMPARE(loader->PendingCount(), 0);
+
+        AsyncOperation* op = manager->DismissAlerts(manager->GetNonDismissingAlerts(), pending);
+        QVERIFY(op);
+        QCOMPARE(manager->NonDismissingAlertCount(), 0);
+
+        // Still being destroyed, so a repeated event does not queue it again
+        loader->Enqueue(&connection, message(0));
+        QCOMPARE(loader->PendingCount(), 0);
+
+        // The connection has no session, so nothing is destroyed and everything comes back
+        QTRY_COMPARE(manager->NonDismissingAlertCount(), int(MessageAlertLoader::PAGE_SIZE));
+        QTRY_COMPARE(loader->PendingCount(), 10);
+        settle();
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QCOMPARE(manager->AlertCount(), int(MessageAlertLoader::PAGE_SIZE));
+        QCOMPARE(loader->PendingCount(), 10);
+
+        // A message destroyed while being dismissed is forgotten for good
+        loader->TakePending();
+        loader->Remove("OpaqueRef:dismiss-0");
+        loader->Restore(QStringList() << "OpaqueRef:dismiss-0" << "OpaqueRef:dismiss-1");
+        QCOMPARE(loader->PendingCount(), 1);
+
+        for (int i = 0; i < 10; ++i)
+            loader->Remove(QString("OpaqueRef:dismiss-%1").arg(i));
+        QCOMPARE(loader->PendingCount(), 0);
+        manager->ClearAllAlerts();
+    }
+    void memoryAccountant_evictsOverBudgetAndForgetsOwners()
+    {
+        MemoryAccountant* memory = MemoryAccountant::instance();
+        XenConnection connection;
+
+        auto archiveUsage = [memory, &connection]() {
+            for (const MemoryAccountant::Usage& usage : memory->GetUsage(&connection))
+            {
+                if (usage.subsystem == MemoryAccountant::GRAPH_ARCHIVES)
+                    return usage;
+            }
+            return MemoryAccountant::Usage();
+        };
+
+        // One idle owner that can drop its data, one in use that cannot
+        QObject* idle = new QObject();
+        qint64 idleBytes = 4096;
+        memory->Register(&connection, MemoryAccountant::GRAPH_ARCHIVES, idle,
+            [&idleBytes]() { return MemoryAccountant::Size{ idleBytes, idleBytes }; },
+            [&idleBytes](qint64) { const qint64 freed = idleBytes; idleBytes = 0; return freed; });
+        QObject* busy = new QObject();
+        int busyEvictions = 0;
+        memory->Register(&connection, MemoryAccountant::GRAPH_ARCHIVES, busy,
+            []() { return MemoryAccountant::Size{ 8192, 0 }; },
+            [&busyEvictions](qint64) { ++busyEvictions; return qint64(0); });
+
+        MemoryAccountant::Usage usage = archiveUsage();
+        QCOMPARE(usage.bytes, qint64(12288));
+        QCOMPARE(usage.evictable, qint64(4096));
+        QCOMPARE(usage.providers, 2);
+        QVERIFY(memory->GetConnections().contains(&connection));
+
+        // Nothing is evicted without a budget
+        QCOMPARE(memory->Enforce(), qint64(0));
+        QCOMPARE(idleBytes, qint64(4096));
+
+        QSignalSpy evicted(memory, &MemoryAccountant::evicted);
+        memory->SetBudget(MemoryAccountant::GRAPH_ARCHIVES, 10000);
+        QCOMPARE(archiveUsage().budget, qint64(10000));
+        QCOMPARE(memory->Enforce(), qint64(4096));
+        QCOMPARE(idleBytes, qint64(0));
+        QCOMPARE(busyEvictions, 0);
+        QCOMPARE(evicted.size(), 1);
+        QCOMPARE(evicted.first().at(2).toLongLong(), qint64(4096));
+
+        // Under budget now, so the next check is a no-op
+        QCOMPARE(memory->Enforce(), qint64(0));
+
+        delete busy;
+        usage = archiveUsage();
+        QCOMPARE(usage.providers, 1);
+        QCOMPARE(usage.bytes, qint64(0));
+
+        delete idle;
+        QCOMPARE(archiveUsage().providers, 0);
+        memory->SetBudget(MemoryAccountant::GRAPH_ARCHIVES, 0);
+        QCOMPARE(memory->GetBudget(MemoryAccountant::GRAPH_ARCHIVES), qint64(0));
+    }
 };
 
 QTEST_APPLESS_MAIN(XenLibTests)
@@ -20,3 +20,6 @@ INCLUDEPATH += \
 
 # Link with prebuilt xenlib (user-managed build output)
 LIBS += -L../../release/xenlib -lxenlib
+
+# Mock xapi server used by the end-to-end transport tests
+LIBS += -L../../release/mockxapi -lmockxapi